@@ -0,0 +1,28 @@
+/**
+* Offline mesh converter, run by the MyDX12Demo build for the meshes in assets/.
+*
+* Usage: MyDX12Demo.MeshConverter <input.obj> <output.mesh>
+* Converts the OBJ file with ConvertObjToMeshFile (see MeshConverter.h).
+*/
+#include <MeshConverter.h>
+
+#include <cstdio>
+
+int wmain(int argc, wchar_t* argv[])
+{
+    if (argc != 3)
+    {
+        fwprintf(stderr, L"Usage: %ls <input.obj> <output.mesh>\n", argc > 0 ? argv[0] : L"MyDX12Demo.MeshConverter");
+        return 2;
+    }
+
+    if (!ConvertObjToMeshFile(argv[1], argv[2]))
+    {
+        // MSBuild picks up the "error:" prefix and fails the build step.
+        fwprintf(stderr, L"%ls: error: could not convert to %ls\n", argv[1], argv[2]);
+        return 1;
+    }
+
+    wprintf(L"%ls -> %ls\n", argv[1], argv[2]);
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <BindlessHandleAllocator.h>
+
+#include <TestFramework.h>
+
+#include <set>
+
+TEST_CASE(BindlessHandleRejectedAfterSlotReuse)
+{
+    BindlessHandleAllocator allocator(4);
+
+    uint32_t handle = allocator.Allocate();
+    uint32_t other = allocator.Allocate();
+    CHECK(allocator.IsValid(handle));
+    CHECK(allocator.IsValid(other));
+    CHECK_EQUAL(0u, BindlessHandleAllocator::GetIndex(handle));
+    CHECK_EQUAL(1u, BindlessHandleAllocator::GetIndex(other));
+
+    CHECK(allocator.Free(handle));
+    CHECK(!allocator.IsValid(handle));
+    CHECK(!allocator.Free(handle));
+
+    // The slot is not reused before the submission that may read it has completed.
+    allocator.Allocate();
+    allocator.Allocate();
+    CHECK(allocator.Allocate() == BindlessHandleAllocator::InvalidHandle);
+    allocator.Submitted(1);
+    allocator.ReleaseStale(0);
+    CHECK(allocator.Allocate() == BindlessHandleAllocator::InvalidHandle);
+    allocator.ReleaseStale(1);
+
+    // The reused slot has the same index but a new generation, the stale handle stays rejected.
+    uint32_t reused = allocator.Allocate();
+    CHECK_EQUAL(BindlessHandleAllocator::GetIndex(handle), BindlessHandleAllocator::GetIndex(reused));
+    CHECK(BindlessHandleAllocator::GetGeneration(handle) != BindlessHandleAllocator::GetGeneration(reused));
+    CHECK(allocator.IsValid(reused));
+    CHECK(!allocator.IsValid(handle));
+
+    // Freeing the stale handle must not free the slot of the new one.
+    CHECK(!allocator.Free(handle));
+    CHECK(allocator.IsValid(reused));
+    CHECK_EQUAL(4u, allocator.GetStatistics().NumAllocated);
+
+    CHECK(!allocator.IsValid(BindlessHandleAllocator::InvalidHandle));
+    CHECK(!allocator.IsValid(BindlessHandleAllocator::MakeHandle(3, 5)));
+}
+
+TEST_CASE(BindlessHandleGenerationsAreExhausted)
+{
+    // Every generation of a slot gives a distinct handle, then the slot is retired.
+    BindlessHandleAllocator allocator(1);
+    std::set<uint32_t> handles;
+    uint64_t fenceValue = 0;
+    for (;;)
+    {
+        uint32_t handle = allocator.Allocate();
+        if (handle == BindlessHandleAllocator::InvalidHandle)
+        {
+            break;
+        }
+
+        CHECK(handles.insert(handle).second);
+        CHECK(allocator.Free(handle));
+        allocator.Submitted(++fenceValue);
+        allocator.ReleaseStale(fenceValue);
+    }
+
+    CHECK_EQUAL(size_t(BindlessHandleAllocator::MaxGeneration) + 1, handles.size());
+    CHECK_EQUAL(1u, allocator.GetStatistics().NumRetired);
+    for (uint32_t handle : handles)
+    {
+        CHECK(!allocator.IsValid(handle));
+    }
+}
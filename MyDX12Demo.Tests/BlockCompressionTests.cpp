@@ -0,0 +1,173 @@
+#include <BlockCompression.h>
+
+#include <TestFramework.h>
+#include <ThreadPool.h>
+
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace
+{
+    /**
+     * Synthetic test image: smooth gradients, a little noise, a hard edged
+     * checkerboard region and an alpha channel with both gradients and cutouts.
+     * Every mip is generated at its own size, no filtering is involved.
+     */
+    TextureData MakeTestTexture(uint32_t width, uint32_t height, uint32_t mipLevels, bool opaque)
+    {
+        TextureData texture;
+        texture.Initialize(TextureFormat::RGBA8UNorm, width, height, 1, mipLevels);
+
+        std::mt19937 random(1);
+        for (uint32_t mip = 0; mip < texture.MipLevels; ++mip)
+        {
+            const TextureSubresource& subresource = texture.GetSubresource(mip);
+            uint8_t* pPixels = texture.GetPixels(mip);
+            for (uint32_t y = 0; y < subresource.Height; ++y)
+            {
+                for (uint32_t x = 0; x < subresource.Width; ++x)
+                {
+                    uint8_t* p = pPixels + y * subresource.RowPitch + x * 4;
+                    float fx = x / float(subresource.Width);
+                    float fy = y / float(subresource.Height);
+                    p[0] = static_cast<uint8_t>(127 + 120 * std::sin(fx * 9 + fy * 3));
+                    p[1] = static_cast<uint8_t>(127 + 120 * std::cos(fy * 7));
+                    p[2] = static_cast<uint8_t>(255 * fx * fy * 0.95f + random() % 8);
+                    p[3] = opaque ? 255 : static_cast<uint8_t>(((x / 16 + y / 16) & 1) ? 255 : fx * 255);
+                    if (fx > 0.5f && fy > 0.5f && ((x / 4 + y / 4) & 1))
+                    {
+                        p[0] = 255;
+                        p[1] = 20;
+                        p[2] = 40;
+                    }
+                }
+            }
+        }
+        return texture;
+    }
+
+    // Compress, decompress and compare over the channels the format stores.
+    double RoundTripPSNR(const TextureData& source, TextureFormat format, uint32_t channelMask,
+        BC7Quality quality = BC7Quality::Normal, ThreadPool* pThreadPool = nullptr)
+    {
+        BlockCompressionSettings settings;
+        settings.Quality = quality;
+
+        TextureData compressed, decompressed;
+        CHECK(CompressTexture(source, format, compressed, settings, pThreadPool));
+        CHECK_EQUAL(source.MipLevels, compressed.MipLevels);
+        CHECK(DecompressTexture(compressed, decompressed, pThreadPool));
+        return ComputePSNR(source, decompressed, channelMask);
+    }
+
+    const uint32_t RGB = 0x7;
+    const uint32_t RGBA = 0xF;
+}
+
+// The thresholds are about 2 dB below what the encoders reach on the test image,
+// whose small mips are mostly edges and noise.
+TEST_CASE(BlockCompressionPSNR)
+{
+    ThreadPool threadPool;
+    const TextureData texture = MakeTestTexture(128, 128, 0, false);
+    const TextureData opaqueTexture = MakeTestTexture(128, 128, 0, true);
+
+    CHECK(RoundTripPSNR(opaqueTexture, TextureFormat::BC1UNorm, RGB, BC7Quality::Normal, &threadPool) > 31.0);
+    CHECK(RoundTripPSNR(texture, TextureFormat::BC3UNorm, RGBA, BC7Quality::Normal, &threadPool) > 32.5);
+    CHECK(RoundTripPSNR(texture, TextureFormat::BC4UNorm, 0x1, BC7Quality::Normal, &threadPool) > 42.5);
+    CHECK(RoundTripPSNR(texture, TextureFormat::BC5UNorm, 0x3, BC7Quality::Normal, &threadPool) > 44.5);
+    CHECK(RoundTripPSNR(texture, TextureFormat::BC7UNorm, RGBA, BC7Quality::Fast, &threadPool) > 33.0);
+    CHECK(RoundTripPSNR(opaqueTexture, TextureFormat::BC7UNorm, RGBA, BC7Quality::Fast, &threadPool) > 33.5);
+
+    // The partitioned modes must pay off on opaque blocks.
+    CHECK(RoundTripPSNR(opaqueTexture, TextureFormat::BC7UNorm, RGBA, BC7Quality::Normal, &threadPool) > 39.0);
+    const TextureData smallTexture = MakeTestTexture(32, 32, 1, true);
+    CHECK(RoundTripPSNR(smallTexture, TextureFormat::BC7UNorm, RGBA, BC7Quality::High, &threadPool) >=
+        RoundTripPSNR(smallTexture, TextureFormat::BC7UNorm, RGBA, BC7Quality::Normal, &threadPool) - 0.01);
+}
+
+TEST_CASE(BlockCompressionEdgeCases)
+{
+    uint8_t pixels[64];
+    uint8_t block[16];
+    uint8_t decoded[64];
+
+    // BC1 keeps punch-through alpha.
+    for (int i = 0; i < 16; ++i)
+    {
+        pixels[i * 4 + 0] = 200;
+        pixels[i * 4 + 1] = static_cast<uint8_t>(i * 10);
+        pixels[i * 4 + 2] = 50;
+        pixels[i * 4 + 3] = (i % 3) ? 255 : 0;
+    }
+    EncodeBC1Block(pixels, block);
+    DecodeBC1Block(block, decoded);
+    for (int i = 0; i < 16; ++i)
+    {
+        CHECK_EQUAL(pixels[i * 4 + 3] == 0, decoded[i * 4 + 3] == 0);
+    }
+
+    // A solid color survives BC7 within one step.
+    for (int i = 0; i < 16; ++i)
+    {
+        pixels[i * 4 + 0] = 13;
+        pixels[i * 4 + 1] = 200;
+        pixels[i * 4 + 2] = 77;
+        pixels[i * 4 + 3] = 255;
+    }
+    EncodeBC7Block(pixels, BC7Quality::Fast, block);
+    CHECK(DecodeBC7Block(block, decoded));
+    for (int c = 0; c < 4; ++c)
+    {
+        CHECK_NEAR(pixels[c], decoded[c], 1);
+    }
+
+    // Sizes that are not a multiple of the block size are rejected.
+    TextureData odd, compressed;
+    odd.Initialize(TextureFormat::RGBA8UNorm, 6, 8);
+    CHECK(!CompressTexture(odd, TextureFormat::BC1UNorm, compressed));
+}
+
+// Encoding throughput of a 1024 * 1024 texture with its mips on the thread pool.
+BENCHMARK(BlockCompressionThroughput)
+{
+    struct Case
+    {
+        const char* Name;
+        TextureFormat Format;
+        BC7Quality Quality;
+        uint32_t Size;
+    };
+    // The slower BC7 tiers run on smaller textures to keep the benchmark short.
+    const Case cases[] = {
+        { "BC1", TextureFormat::BC1UNorm, BC7Quality::Fast, 1024 },
+        { "BC3", TextureFormat::BC3UNorm, BC7Quality::Fast, 1024 },
+        { "BC4", TextureFormat::BC4UNorm, BC7Quality::Fast, 1024 },
+        { "BC5", TextureFormat::BC5UNorm, BC7Quality::Fast, 1024 },
+        { "BC7 fast", TextureFormat::BC7UNorm, BC7Quality::Fast, 1024 },
+        { "BC7 normal", TextureFormat::BC7UNorm, BC7Quality::Normal, 256 },
+        { "BC7 high", TextureFormat::BC7UNorm, BC7Quality::High, 64 },
+    };
+
+    ThreadPool threadPool;
+    for (const Case& benchmarkCase : cases)
+    {
+        const TextureData texture = MakeTestTexture(benchmarkCase.Size, benchmarkCase.Size, 0, false);
+        size_t numPixels = 0;
+        for (const TextureSubresource& subresource : texture.Subresources)
+        {
+            numPixels += size_t(subresource.Width) * subresource.Height;
+        }
+
+        BlockCompressionSettings settings;
+        settings.Quality = benchmarkCase.Quality;
+        TextureData compressed;
+        Test::Timer timer;
+        CHECK(CompressTexture(texture, benchmarkCase.Format, compressed, settings, &threadPool));
+        double seconds = timer.GetElapsedSeconds();
+
+        Test::Report(std::string(benchmarkCase.Name) + " (" + std::to_string(benchmarkCase.Size) + ")",
+            numPixels / seconds * 1e-6, "MP/s");
+    }
+}
@@ -0,0 +1,228 @@
+#include <DescriptorAllocator.h>
+
+#include <TestFramework.h>
+
+#include <dxgi1_6.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::WRL;
+
+namespace
+{
+    // The hardware device if there is one, otherwise WARP.
+    ComPtr<ID3D12Device2> CreateDevice()
+    {
+        ComPtr<ID3D12Device2> device;
+        if (SUCCEEDED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+        {
+            return device;
+        }
+
+        ComPtr<IDXGIFactory4> dxgiFactory;
+        ComPtr<IDXGIAdapter1> warpAdapter;
+        if (SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&dxgiFactory))) &&
+            SUCCEEDED(dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter))) &&
+            SUCCEEDED(D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+        {
+            return device;
+        }
+
+        return nullptr;
+    }
+
+    // Frees every stale range, as if the GPU had finished all frames.
+    void ReleaseAll(DescriptorAllocator& allocator, uint64_t& fenceValue)
+    {
+        ++fenceValue;
+        allocator.ReleaseStaleDescriptors(fenceValue, fenceValue);
+    }
+
+    /**
+     * Allocate and free in frames like the renderer does: every frame allocates
+     * a batch and frees the batch of two frames ago. With pFenceValue the stale
+     * ranges are released every frame, otherwise another thread releases them.
+     * Returns the allocations and frees per second.
+     */
+    double RunFrames(DescriptorAllocator& allocator, uint32_t numFrames, uint32_t numPerFrame, uint32_t maxRangeSize, uint32_t seed,
+        uint64_t* pFenceValue)
+    {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<uint32_t> rangeSize(1, maxRangeSize);
+
+        std::vector<DescriptorAllocation> frames[3];
+        for (auto& frame : frames)
+        {
+            frame.reserve(numPerFrame);
+        }
+
+        Test::Timer timer;
+        for (uint32_t frame = 0; frame < numFrames; ++frame)
+        {
+            auto& allocations = frames[frame % 3];
+            allocations.clear();
+            for (uint32_t i = 0; i < numPerFrame; ++i)
+            {
+                allocations.push_back(allocator.Allocate(rangeSize(random)));
+            }
+            Test::DoNotOptimize(allocations.data());
+
+            if (pFenceValue)
+            {
+                ++*pFenceValue;
+                allocator.ReleaseStaleDescriptors(*pFenceValue, *pFenceValue - 1);
+            }
+        }
+        double seconds = timer.GetElapsedSeconds();
+
+        for (auto& frame : frames)
+        {
+            frame.clear();
+        }
+        allocator.FlushThreadCache();
+
+        return 2.0 * numFrames * numPerFrame / seconds;
+    }
+}
+
+TEST_CASE(DescriptorAllocatorReturnsThreadCacheOnExit)
+{
+    ComPtr<ID3D12Device2> device = CreateDevice();
+    CHECK(device);
+
+    uint64_t fenceValue = 0;
+    DescriptorAllocator allocator(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 256);
+
+    // Worker threads that allocated a single descriptor leave nothing reserved after they exit.
+    for (int i = 0; i < 4; ++i)
+    {
+        bool allocated = false;
+        std::thread worker([&]()
+        {
+            DescriptorAllocation allocation = allocator.Allocate();
+            allocated = !allocation.IsNull();
+        });
+        worker.join();
+        CHECK(allocated);
+    }
+    ReleaseAll(allocator, fenceValue);
+
+    DescriptorAllocator::Statistics statistics = allocator.GetStatistics();
+    CHECK_EQUAL(1u, statistics.NumPages);
+    CHECK_EQUAL(statistics.NumDescriptors, statistics.NumFreeDescriptors);
+
+    // Switching to another allocator of the same type returns the rest of the cache.
+    {
+        DescriptorAllocator other(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 256);
+        DescriptorAllocation first = allocator.Allocate();
+        DescriptorAllocation second = other.Allocate();
+        first = DescriptorAllocation();
+        ReleaseAll(allocator, fenceValue);
+        statistics = allocator.GetStatistics();
+        CHECK_EQUAL(statistics.NumDescriptors, statistics.NumFreeDescriptors);
+    }
+
+    // The cache of this thread still refers to the destroyed allocator, the next allocation refills it.
+    DescriptorAllocation allocation = allocator.Allocate();
+    CHECK(!allocation.IsNull());
+    allocation = DescriptorAllocation();
+    allocator.FlushThreadCache();
+    ReleaseAll(allocator, fenceValue);
+    statistics = allocator.GetStatistics();
+    CHECK_EQUAL(statistics.NumDescriptors, statistics.NumFreeDescriptors);
+}
+
+TEST_CASE(DescriptorAllocatorThreadOutlivesAllocator)
+{
+    ComPtr<ID3D12Device2> device = CreateDevice();
+    CHECK(device);
+
+    // The worker exits after the allocator is destroyed, its cache must not touch the freed pages.
+    std::unique_ptr<DescriptorAllocator> allocator = std::make_unique<DescriptorAllocator>(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 64);
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool allocated = false;
+    bool done = false;
+    bool destroyed = false;
+
+    std::thread worker([&]()
+    {
+        DescriptorAllocation allocation = allocator->Allocate();
+        bool isNull = allocation.IsNull();
+        allocation = DescriptorAllocation();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        allocated = !isNull;
+        done = true;
+        condition.notify_all();
+        condition.wait(lock, [&]() { return destroyed; });
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&]() { return done; });
+        allocator.reset();
+        destroyed = true;
+        condition.notify_all();
+    }
+    worker.join();
+    CHECK(allocated);
+}
+
+BENCHMARK(DescriptorAllocatorThroughput)
+{
+    ComPtr<ID3D12Device2> device = CreateDevice();
+    CHECK(device);
+
+    const uint32_t numFrames = 2000;
+    const uint32_t numPerFrame = 1000;
+    uint64_t fenceValue = 0;
+
+    {
+        DescriptorAllocator allocator(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4096);
+        double rate = RunFrames(allocator, numFrames, numPerFrame, 1, 1, &fenceValue);
+        Test::Report("single descriptors", rate / 1e6, "Mops/s");
+        Test::Report("single descriptors, page count", allocator.GetStatistics().NumPages, "pages");
+    }
+    {
+        DescriptorAllocator allocator(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4096);
+        double rate = RunFrames(allocator, numFrames, numPerFrame, 8, 1, &fenceValue);
+        Test::Report("ranges of 1-8 descriptors", rate / 1e6, "Mops/s");
+        Test::Report("ranges of 1-8 descriptors, page count", allocator.GetStatistics().NumPages, "pages");
+    }
+
+    // Worker threads allocating single descriptors from one allocator, this thread releases the stale ranges.
+    unsigned numThreads = std::max(std::thread::hardware_concurrency(), 2u);
+    uint32_t numFramesPerThread = numFrames / numThreads;
+    DescriptorAllocator allocator(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4096);
+    std::atomic<unsigned> numRunning(numThreads);
+    std::vector<std::thread> workers;
+    Test::Timer timer;
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        workers.emplace_back([&, i]()
+        {
+            RunFrames(allocator, numFramesPerThread, numPerFrame, 1, i + 1, nullptr);
+            --numRunning;
+        });
+    }
+    while (numRunning > 0)
+    {
+        ++fenceValue;
+        allocator.ReleaseStaleDescriptors(fenceValue, fenceValue - 1);
+        std::this_thread::yield();
+    }
+    double seconds = timer.GetElapsedSeconds();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    double operations = 2.0 * numFramesPerThread * numPerFrame * numThreads;
+    Test::Report("single descriptors, " + std::to_string(numThreads) + " threads", operations / seconds / 1e6, "Mops/s");
+}
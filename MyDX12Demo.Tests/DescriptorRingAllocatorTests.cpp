@@ -0,0 +1,169 @@
+#include <DescriptorRingAllocator.h>
+
+#include <TestFramework.h>
+
+#include <deque>
+#include <vector>
+
+namespace
+{
+    struct Range
+    {
+        uint32_t Offset;
+        uint32_t NumDescriptors;
+        uint64_t FenceValue;
+    };
+
+    bool RangesOverlap(const Range& a, const Range& b)
+    {
+        return a.Offset < b.Offset + b.NumDescriptors && b.Offset < a.Offset + a.NumDescriptors;
+    }
+
+    uint32_t NextRandom(uint32_t& state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+}
+
+TEST_CASE(DescriptorRingAllocatorWrapsAtEnd)
+{
+    DescriptorRingAllocator ring(16);
+    CHECK_EQUAL(16u, ring.GetNumDescriptors());
+    CHECK_EQUAL(0u, ring.Allocate(6));
+    ring.Submitted(1);
+    CHECK_EQUAL(6u, ring.Allocate(6));
+    ring.Submitted(2);
+    ring.ReleaseCompleted(1);
+    CHECK_EQUAL(6u, ring.GetNumUsedDescriptors());
+
+    // Only 4 descriptors are left before the end: the range starts over at 0 and the end is skipped.
+    CHECK_EQUAL(0u, ring.Allocate(6));
+    CHECK_EQUAL(16u, ring.GetNumUsedDescriptors());
+    ring.Submitted(3);
+    CHECK(ring.Allocate(1) == DescriptorRingAllocator::InvalidOffset);
+
+    ring.ReleaseCompleted(2);
+    CHECK_EQUAL(10u, ring.GetNumUsedDescriptors());
+    CHECK_EQUAL(6u, ring.Allocate(4));
+    CHECK_EQUAL(10u, ring.Allocate(2));
+    CHECK_EQUAL(16u, ring.GetNumUsedDescriptors());
+    ring.Submitted(4);
+
+    // Freeing submission 3 also frees the skipped end, a range that ends exactly at the end does not wrap.
+    ring.ReleaseCompleted(3);
+    CHECK_EQUAL(6u, ring.GetNumUsedDescriptors());
+    CHECK_EQUAL(12u, ring.Allocate(4));
+    CHECK_EQUAL(0u, ring.Allocate(6));
+    CHECK_EQUAL(16u, ring.GetNumUsedDescriptors());
+    ring.Submitted(5);
+    ring.ReleaseCompleted(5);
+    CHECK_EQUAL(0u, ring.GetNumUsedDescriptors());
+
+    // An empty ring starts over at 0, so the whole ring fits in one range wherever the head was.
+    CHECK_EQUAL(0u, ring.Allocate(16));
+    ring.Submitted(6);
+    ring.ReleaseCompleted(6);
+}
+
+TEST_CASE(DescriptorRingAllocatorFailsUntilFenceCompletes)
+{
+    DescriptorRingAllocator ring(16);
+    CHECK_EQUAL(0u, ring.Allocate(10));
+    ring.Submitted(1);
+    CHECK_EQUAL(10u, ring.Allocate(4));
+    ring.Submitted(2);
+
+    // 2 free at the end, the start is still used by submission 1.
+    CHECK(ring.Allocate(3) == DescriptorRingAllocator::InvalidOffset);
+    CHECK(ring.Allocate(17) == DescriptorRingAllocator::InvalidOffset);
+    // A failed allocation does not use anything.
+    CHECK_EQUAL(14u, ring.GetNumUsedDescriptors());
+
+    // Nothing is freed before the fence value of the submission is completed.
+    ring.ReleaseCompleted(0);
+    CHECK_EQUAL(14u, ring.GetNumUsedDescriptors());
+    CHECK(ring.Allocate(3) == DescriptorRingAllocator::InvalidOffset);
+
+    // Submissions are freed in order, up to the completed fence value.
+    ring.ReleaseCompleted(1);
+    CHECK_EQUAL(4u, ring.GetNumUsedDescriptors());
+    CHECK_EQUAL(0u, ring.Allocate(3));
+    CHECK_EQUAL(9u, ring.GetNumUsedDescriptors());
+    ring.Submitted(3);
+    // Submitting without allocating anything adds nothing to free later.
+    ring.Submitted(4);
+    ring.ReleaseCompleted(2);
+    CHECK_EQUAL(5u, ring.GetNumUsedDescriptors());
+    CHECK_EQUAL(3u, ring.Allocate(11));
+    CHECK(ring.Allocate(1) == DescriptorRingAllocator::InvalidOffset);
+    // The descriptors of the command list being recorded stay in use.
+    ring.ReleaseCompleted(4);
+    CHECK_EQUAL(11u, ring.GetNumUsedDescriptors());
+    ring.Submitted(5);
+    ring.ReleaseCompleted(5);
+    CHECK_EQUAL(0u, ring.GetNumUsedDescriptors());
+}
+
+TEST_CASE(DescriptorRingAllocatorReclaimsCompletedFrames)
+{
+    // Three frames in flight like the swap chain: a full ring waits for the oldest frame, as the
+    // dynamic descriptor heap would before it grows. The ranges in use never overlap.
+    const uint32_t numDescriptors = 256;
+    const uint64_t numFramesInFlight = 3;
+
+    DescriptorRingAllocator ring(numDescriptors);
+    std::deque<Range> liveRanges;
+    uint64_t fenceValue = 0;
+    uint64_t completedFenceValue = 0;
+    uint32_t numWaits = 0;
+    uint32_t state = 11;
+
+    for (int frame = 0; frame < 500; ++frame)
+    {
+        ++fenceValue;
+        const uint32_t numAllocations = 1 + NextRandom(state) % 8;
+        for (uint32_t i = 0; i < numAllocations; ++i)
+        {
+            const uint32_t size = 1 + NextRandom(state) % 20;
+            uint32_t offset = ring.Allocate(size);
+            while (offset == DescriptorRingAllocator::InvalidOffset)
+            {
+                // Wait for the oldest submitted frame, the current one can not complete.
+                CHECK(completedFenceValue + 1 < fenceValue);
+                ++completedFenceValue;
+                ++numWaits;
+                ring.ReleaseCompleted(completedFenceValue);
+                while (!liveRanges.empty() && liveRanges.front().FenceValue <= completedFenceValue)
+                {
+                    liveRanges.pop_front();
+                }
+                offset = ring.Allocate(size);
+            }
+
+            Range range = { offset, size, fenceValue };
+            CHECK(offset + size <= numDescriptors);
+            for (const Range& liveRange : liveRanges)
+            {
+                CHECK(!RangesOverlap(range, liveRange));
+            }
+            liveRanges.push_back(range);
+        }
+        ring.Submitted(fenceValue);
+
+        // The GPU keeps up to numFramesInFlight frames.
+        if (fenceValue > numFramesInFlight && completedFenceValue < fenceValue - numFramesInFlight)
+        {
+            completedFenceValue = fenceValue - numFramesInFlight;
+        }
+        ring.ReleaseCompleted(completedFenceValue);
+        while (!liveRanges.empty() && liveRanges.front().FenceValue <= completedFenceValue)
+        {
+            liveRanges.pop_front();
+        }
+    }
+    CHECK(numWaits > 0);
+
+    ring.ReleaseCompleted(fenceValue);
+    CHECK_EQUAL(0u, ring.GetNumUsedDescriptors());
+}
@@ -0,0 +1,251 @@
+#include <DescriptorViewCache.h>
+
+#include <TestFramework.h>
+
+#include <dxgi1_6.h>
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::WRL;
+
+namespace
+{
+    // The hardware device if there is one, otherwise WARP.
+    ComPtr<ID3D12Device2> CreateDevice()
+    {
+        ComPtr<ID3D12Device2> device;
+        if (SUCCEEDED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+        {
+            return device;
+        }
+
+        ComPtr<IDXGIFactory4> dxgiFactory;
+        ComPtr<IDXGIAdapter1> warpAdapter;
+        if (SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&dxgiFactory))) &&
+            SUCCEEDED(dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter))) &&
+            SUCCEEDED(D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+        {
+            return device;
+        }
+
+        return nullptr;
+    }
+
+    // A 4x4 texture with two mips that can be used as SRV, UAV and render target.
+    ComPtr<ID3D12Resource> CreateTexture(ID3D12Device2* pDevice)
+    {
+        D3D12_HEAP_PROPERTIES heapProperties = {};
+        heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+        D3D12_RESOURCE_DESC desc = {};
+        desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        desc.Width = 4;
+        desc.Height = 4;
+        desc.DepthOrArraySize = 1;
+        desc.MipLevels = 2;
+        desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+        desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+        ComPtr<ID3D12Resource> resource;
+        if (FAILED(pDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
+            D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&resource))))
+        {
+            return nullptr;
+        }
+        return resource;
+    }
+
+    /**
+     * The descriptor allocators the application would give the cache. Declared before
+     * the cache, the cached descriptors must not outlive their allocator.
+     */
+    struct Allocators
+    {
+        Allocators(ComPtr<ID3D12Device2> device)
+            : ShaderResourceViews(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 64)
+            , RenderTargetViews(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 64)
+        {
+        }
+
+        DescriptorViewCache::AllocateDescriptorsFunc GetAllocateDescriptors()
+        {
+            return [this](D3D12_DESCRIPTOR_HEAP_TYPE type)
+            {
+                return type == D3D12_DESCRIPTOR_HEAP_TYPE_RTV ? RenderTargetViews.Allocate() : ShaderResourceViews.Allocate();
+            };
+        }
+
+        DescriptorAllocator ShaderResourceViews;
+        DescriptorAllocator RenderTargetViews;
+    };
+
+    // Free descriptors of the allocator once the GPU is done with everything.
+    uint32_t GetNumFreeDescriptors(DescriptorAllocator& allocator, uint64_t& fenceValue)
+    {
+        allocator.FlushThreadCache();
+        ++fenceValue;
+        allocator.ReleaseStaleDescriptors(fenceValue, fenceValue);
+        return allocator.GetStatistics().NumFreeDescriptors;
+    }
+
+    /**
+     * Runs the function on another thread, false if it did not return in time (a deadlock).
+     * The function is destroyed before it counts as finished, so what it captured is released by then.
+     */
+    bool RunWithTimeout(std::function<void()> function)
+    {
+        auto done = std::make_shared< std::promise<void> >();
+        std::future<void> future = done->get_future();
+        std::thread([function, done]() mutable
+        {
+            function();
+            function = nullptr;
+            done->set_value();
+        }).detach();
+        return future.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+    }
+}
+
+TEST_CASE(DescriptorViewCacheReusesViews)
+{
+    ComPtr<ID3D12Device2> device = CreateDevice();
+    CHECK(device);
+    Allocators allocators(device);
+    DescriptorViewCache cache(device, allocators.GetAllocateDescriptors());
+    ComPtr<ID3D12Resource> texture = CreateTexture(device.Get());
+    CHECK(texture);
+
+    // The default view is created once.
+    D3D12_CPU_DESCRIPTOR_HANDLE defaultView = cache.GetShaderResourceView(texture.Get());
+    CHECK(defaultView.ptr != 0);
+    CHECK(cache.GetShaderResourceView(texture.Get()).ptr == defaultView.ptr);
+
+    // Only the fields the view dimension uses are part of the key, not the padding or the rest of the union.
+    D3D12_SHADER_RESOURCE_VIEW_DESC first;
+    std::memset(&first, 0xcd, sizeof(first));
+    first.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    first.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    first.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    first.Texture2D.MostDetailedMip = 1;
+    first.Texture2D.MipLevels = 1;
+    first.Texture2D.PlaneSlice = 0;
+    first.Texture2D.ResourceMinLODClamp = 0.0f;
+    D3D12_SHADER_RESOURCE_VIEW_DESC second;
+    std::memset(&second, 0, sizeof(second));
+    second.Format = first.Format;
+    second.ViewDimension = first.ViewDimension;
+    second.Shader4ComponentMapping = first.Shader4ComponentMapping;
+    second.Texture2D = first.Texture2D;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE mipView = cache.GetShaderResourceView(texture.Get(), &first);
+    CHECK(mipView.ptr != defaultView.ptr);
+    CHECK(cache.GetShaderResourceView(texture.Get(), &second).ptr == mipView.ptr);
+
+    // Another mip, and other view types of the same resource are views of their own.
+    second.Texture2D.MostDetailedMip = 0;
+    CHECK(cache.GetShaderResourceView(texture.Get(), &second).ptr != mipView.ptr);
+    D3D12_CPU_DESCRIPTOR_HANDLE uav = cache.GetUnorderedAccessView(texture.Get());
+    CHECK(uav.ptr != defaultView.ptr && uav.ptr != mipView.ptr);
+    D3D12_CPU_DESCRIPTOR_HANDLE rtv = cache.GetRenderTargetView(texture.Get());
+    CHECK(cache.GetRenderTargetView(texture.Get()).ptr == rtv.ptr);
+
+    DescriptorViewCache::Statistics statistics = cache.GetStatistics();
+    CHECK_EQUAL(5u, statistics.NumViews);
+    CHECK_EQUAL(1u, statistics.NumResources);
+    CHECK_EQUAL(uint64_t(3), statistics.NumHits);
+    CHECK_EQUAL(uint64_t(5), statistics.NumMisses);
+}
+
+TEST_CASE(DescriptorViewCacheInvalidateThenRequestAgain)
+{
+    ComPtr<ID3D12Device2> device = CreateDevice();
+    CHECK(device);
+    // Shared with the worker thread: after a deadlock the test must not destroy the locked cache.
+    auto allocators = std::make_shared<Allocators>(device);
+    auto cache = std::make_shared<DescriptorViewCache>(device, allocators->GetAllocateDescriptors());
+    ComPtr<ID3D12Resource> texture = CreateTexture(device.Get());
+    ComPtr<ID3D12Resource> untracked = CreateTexture(device.Get());
+    CHECK(texture && untracked);
+
+    // 回归测试: invalidating released the release notifier of the resource with the cache locked,
+    // and the notifier locks the cache too. Requesting a view again replaces the notifier.
+    auto views = std::make_shared< std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> >();
+    bool finished = RunWithTimeout([allocators, cache, texture, untracked, views]()
+    {
+        views->push_back(cache->GetShaderResourceView(texture.Get()));
+        cache->Invalidate(texture.Get());
+        views->push_back(cache->GetShaderResourceView(texture.Get()));
+        cache->Invalidate(texture.Get());
+        cache->Invalidate(texture.Get());
+        cache->Invalidate(untracked.Get());
+        views->push_back(cache->GetShaderResourceView(texture.Get()));
+    });
+    CHECK(finished);
+    CHECK_EQUAL(size_t(3), views->size());
+    for (D3D12_CPU_DESCRIPTOR_HANDLE view : *views)
+    {
+        CHECK(view.ptr != 0);
+    }
+
+    DescriptorViewCache::Statistics statistics = cache->GetStatistics();
+    CHECK_EQUAL(1u, statistics.NumViews);
+    CHECK_EQUAL(1u, statistics.NumResources);
+    CHECK_EQUAL(uint64_t(0), statistics.NumHits);
+    CHECK_EQUAL(uint64_t(3), statistics.NumMisses);
+    CHECK_EQUAL(uint64_t(2), statistics.NumInvalidatedViews);
+
+    // The new notifier still drops the views when the resource is released.
+    texture.Reset();
+    statistics = cache->GetStatistics();
+    CHECK_EQUAL(0u, statistics.NumViews);
+    CHECK_EQUAL(0u, statistics.NumResources);
+    CHECK_EQUAL(uint64_t(3), statistics.NumInvalidatedViews);
+}
+
+TEST_CASE(DescriptorViewCacheDropsViewsOfReleasedResources)
+{
+    ComPtr<ID3D12Device2> device = CreateDevice();
+    CHECK(device);
+    Allocators allocators(device);
+    uint64_t fenceValue = 0;
+
+    auto cache = std::make_unique<DescriptorViewCache>(device, allocators.GetAllocateDescriptors());
+    ComPtr<ID3D12Resource> released = CreateTexture(device.Get());
+    ComPtr<ID3D12Resource> kept = CreateTexture(device.Get());
+    CHECK(released && kept);
+
+    cache->GetShaderResourceView(released.Get());
+    cache->GetUnorderedAccessView(released.Get());
+    cache->GetRenderTargetView(released.Get());
+    cache->GetShaderResourceView(kept.Get());
+    CHECK_EQUAL(4u, cache->GetStatistics().NumViews);
+    CHECK_EQUAL(2u, cache->GetStatistics().NumResources);
+
+    // Destroying the resource evicts all of its views and returns their descriptors.
+    released.Reset();
+    DescriptorViewCache::Statistics statistics = cache->GetStatistics();
+    CHECK_EQUAL(1u, statistics.NumViews);
+    CHECK_EQUAL(1u, statistics.NumResources);
+    CHECK_EQUAL(uint64_t(3), statistics.NumInvalidatedViews);
+    const uint32_t numDescriptors = allocators.ShaderResourceViews.GetStatistics().NumDescriptors;
+    CHECK_EQUAL(numDescriptors - 1, GetNumFreeDescriptors(allocators.ShaderResourceViews, fenceValue));
+    const uint32_t numFreeRenderTargetViews = GetNumFreeDescriptors(allocators.RenderTargetViews, fenceValue);
+    CHECK_EQUAL(allocators.RenderTargetViews.GetStatistics().NumDescriptors, numFreeRenderTargetViews);
+
+    // The views of the other resource are still cached.
+    cache->GetShaderResourceView(kept.Get());
+    CHECK_EQUAL(uint64_t(1), cache->GetStatistics().NumHits);
+
+    // A resource that outlives the cache keeps a notifier that does nothing.
+    cache.reset();
+    CHECK_EQUAL(numDescriptors, GetNumFreeDescriptors(allocators.ShaderResourceViews, fenceValue));
+    kept.Reset();
+}
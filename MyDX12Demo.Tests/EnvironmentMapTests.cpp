@@ -0,0 +1,365 @@
+#include <EnvironmentMap.h>
+#include <SphericalHarmonics.h>
+#include <TextureFile.h>
+
+#include <TestFramework.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+    const float Pi = 3.14159265358979f;
+
+    /**
+    * Analytic environment, every channel has a closed form projection and irradiance:
+    * R: constant 1
+    * G: clamped cosine lobe max(0, d.z)
+    * B: linear 0.5 + 0.25 * d.x
+    */
+    void EvaluateEnvironment(const float* d, float* pColor)
+    {
+        pColor[0] = 1.0f;
+        pColor[1] = std::max(d[2], 0.0f);
+        pColor[2] = 0.5f + 0.25f * d[0];
+    }
+
+    // Irradiance / pi of the analytic environment at the normal n, the value stored by ComputeIrradiance.
+    void EvaluateIrradiance(const float* n, float* pColor)
+    {
+        // The clamped cosine lobe convolved with the clamped cosine: (2 / (3 pi)) * ((pi - theta) cos(theta) + sin(theta)).
+        float cosTheta = std::min(std::max(n[2], -1.0f), 1.0f);
+        float theta = std::acos(cosTheta);
+        pColor[0] = 1.0f;
+        pColor[1] = 2.0f / (3.0f * Pi) * ((Pi - theta) * cosTheta + std::sin(theta));
+        // Band 1 is scaled by 2/3.
+        pColor[2] = 0.5f + 0.25f * (2.0f / 3.0f) * n[0];
+    }
+
+    // Closed form SH9 projection of the analytic environment, in the basis order of SphericalHarmonics.h.
+    void GetExpectedSH9(SH9Color& sh)
+    {
+        std::memset(&sh, 0, sizeof(sh));
+        // Constant c: c * Y00 * 4pi = 2 sqrt(pi) c.
+        sh.Coefficients[0][0] = 2.0f * std::sqrt(Pi);
+        // max(0, z): sqrt(pi) / 2, sqrt(pi / 3) on Y10 and sqrt(5 pi) / 8 on Y20.
+        sh.Coefficients[0][1] = std::sqrt(Pi) / 2.0f;
+        sh.Coefficients[2][1] = std::sqrt(Pi / 3.0f);
+        sh.Coefficients[6][1] = std::sqrt(5.0f * Pi) / 8.0f;
+        // a + b x: 2 sqrt(pi) a on Y00 and 2 sqrt(pi / 3) b on Y11.
+        sh.Coefficients[0][2] = 0.5f * 2.0f * std::sqrt(Pi);
+        sh.Coefficients[3][2] = 0.25f * 2.0f * std::sqrt(Pi / 3.0f);
+    }
+
+    TextureData MakePanorama(uint32_t width, uint32_t height)
+    {
+        TextureData panorama;
+        panorama.Initialize(TextureFormat::RGBA32Float, width, height);
+        float* pPixels = reinterpret_cast<float*>(panorama.GetPixels(0));
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float d[3];
+                GetPanoramaDirection((x + 0.5f) / width, (y + 0.5f) / height, d);
+                float* pTexel = pPixels + (size_t(y) * width + x) * 4;
+                EvaluateEnvironment(d, pTexel);
+                pTexel[3] = 1.0f;
+            }
+        }
+        return panorama;
+    }
+
+    void ReadHalfTexel(const TextureData& texture, uint32_t mip, uint32_t face, uint32_t x, uint32_t y, float* pColor)
+    {
+        const TextureSubresource& subresource = texture.GetSubresource(mip, face);
+        const uint16_t* pTexel = reinterpret_cast<const uint16_t*>(texture.GetPixels(mip, face) + size_t(y) * subresource.RowPitch) + x * 4;
+        for (int c = 0; c < 3; ++c)
+        {
+            pColor[c] = HalfToFloat(pTexel[c]);
+        }
+    }
+
+    // Largest error per channel over every texel of a mip of a cubemap.
+    template <typename Expected>
+    void GetCubemapError(const TextureData& cubemap, uint32_t mip, Expected expected, float* pMaxError)
+    {
+        uint32_t size = cubemap.GetSubresource(mip, 0).Width;
+        std::fill(pMaxError, pMaxError + 3, 0.0f);
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            for (uint32_t y = 0; y < size; ++y)
+            {
+                for (uint32_t x = 0; x < size; ++x)
+                {
+                    float d[3];
+                    GetCubemapDirection(face, 2.0f * (x + 0.5f) / size - 1.0f, 2.0f * (y + 0.5f) / size - 1.0f, d);
+                    float actual[3];
+                    float reference[3];
+                    ReadHalfTexel(cubemap, mip, face, x, y, actual);
+                    expected(d, reference);
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        pMaxError[c] = std::max(pMaxError[c], std::abs(actual[c] - reference[c]));
+                    }
+                }
+            }
+        }
+    }
+
+    // Scale (R) and bias (G) of F0 at a texel of the BRDF lookup table.
+    void ReadBRDFLUTTexel(const TextureData& lut, uint32_t x, uint32_t y, float* pScaleBias)
+    {
+        const uint16_t* pTexel = reinterpret_cast<const uint16_t*>(lut.GetPixels(0) + size_t(y) * lut.GetSubresource(0).RowPitch) + x * 2;
+        pScaleBias[0] = HalfToFloat(pTexel[0]);
+        pScaleBias[1] = HalfToFloat(pTexel[1]);
+    }
+
+    void CheckSH9(const SH9Color& actual, const SH9Color& expected, float tolerance)
+    {
+        for (uint32_t i = 0; i < SH9CoefficientCount; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                CHECK_NEAR(expected.Coefficients[i][c], actual.Coefficients[i][c], tolerance);
+            }
+        }
+    }
+
+    // Largest error per channel of the convolved SH against the closed form irradiance.
+    void GetSH9IrradianceError(const SH9Color& sh, float* pMaxError)
+    {
+        std::fill(pMaxError, pMaxError + 3, 0.0f);
+        for (uint32_t i = 0; i < 64; ++i)
+        {
+            for (uint32_t j = 0; j < 32; ++j)
+            {
+                float d[3];
+                GetPanoramaDirection((i + 0.5f) / 64.0f, (j + 0.5f) / 32.0f, d);
+                float actual[3];
+                float reference[3];
+                EvaluateSH9(sh, d, actual);
+                EvaluateIrradiance(d, reference);
+                for (int c = 0; c < 3; ++c)
+                {
+                    pMaxError[c] = std::max(pMaxError[c], std::abs(actual[c] - reference[c]));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(PanoramaToCubemapMatchesAnalyticEnvironment)
+{
+    TextureData panorama = MakePanorama(256, 128);
+    TextureData cubemap;
+    CHECK(PanoramaToCubemap(panorama, 64, cubemap));
+    CHECK(cubemap.IsCubemap);
+    CHECK_EQUAL(6u, cubemap.ArraySize);
+    CHECK_EQUAL(7u, cubemap.MipLevels);
+
+    float maxError[3];
+    GetCubemapError(cubemap, 0, EvaluateEnvironment, maxError);
+    CHECK_NEAR(0.0f, maxError[0], 1e-3f);
+    CHECK_NEAR(0.0f, maxError[1], 2e-3f);
+    CHECK_NEAR(0.0f, maxError[2], 2e-3f);
+
+    // The constant channel survives every mip of the chain.
+    for (uint32_t mip = 1; mip < cubemap.MipLevels; ++mip)
+    {
+        GetCubemapError(cubemap, mip, EvaluateEnvironment, maxError);
+        CHECK_NEAR(0.0f, maxError[0], 1e-3f);
+    }
+
+    // Every mip is the 2x2 average of the mip above, what the filtered importance sampling expects.
+    for (uint32_t mip = 1; mip < cubemap.MipLevels; ++mip)
+    {
+        const uint32_t size = cubemap.GetSubresource(mip, 0).Width;
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            for (uint32_t y = 0; y < size; ++y)
+            {
+                for (uint32_t x = 0; x < size; ++x)
+                {
+                    float average[3] = {};
+                    for (uint32_t i = 0; i < 4; ++i)
+                    {
+                        float color[3];
+                        ReadHalfTexel(cubemap, mip - 1, face, x * 2 + (i & 1), y * 2 + (i >> 1), color);
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            average[c] += 0.25f * color[c];
+                        }
+                    }
+                    float actual[3];
+                    ReadHalfTexel(cubemap, mip, face, x, y, actual);
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        CHECK_NEAR(average[c], actual[c], 2e-3f);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(IrradianceMatchesAnalyticEnvironment)
+{
+    TextureData panorama = MakePanorama(256, 128);
+    TextureData cubemap;
+    CHECK(PanoramaToCubemap(panorama, 64, cubemap));
+
+    TextureData irradiance;
+    CHECK(ComputeIrradiance(cubemap, 16, irradiance));
+    CHECK_EQUAL(16u, irradiance.Width);
+
+    float maxError[3];
+    GetCubemapError(irradiance, 0, EvaluateIrradiance, maxError);
+    CHECK_NEAR(0.0f, maxError[0], 2e-3f);
+    CHECK_NEAR(0.0f, maxError[1], 2e-3f);
+    CHECK_NEAR(0.0f, maxError[2], 2e-3f);
+}
+
+TEST_CASE(PrefilterSpecularKeepsConstantEnvironment)
+{
+    TextureData panorama = MakePanorama(256, 128);
+    TextureData cubemap;
+    CHECK(PanoramaToCubemap(panorama, 64, cubemap));
+
+    TextureData specular;
+    CHECK(PrefilterSpecular(cubemap, 32, 4, 64, specular));
+    CHECK_EQUAL(4u, specular.MipLevels);
+
+    // Mip 0 is the mirror reflection, so it reproduces the environment.
+    float maxError[3];
+    GetCubemapError(specular, 0, EvaluateEnvironment, maxError);
+    CHECK_NEAR(0.0f, maxError[0], 1e-3f);
+    CHECK_NEAR(0.0f, maxError[1], 2e-3f);
+    CHECK_NEAR(0.0f, maxError[2], 2e-3f);
+
+    // A constant environment looks the same at every roughness.
+    for (uint32_t mip = 1; mip < specular.MipLevels; ++mip)
+    {
+        GetCubemapError(specular, mip, EvaluateEnvironment, maxError);
+        CHECK_NEAR(0.0f, maxError[0], 1e-3f);
+    }
+}
+
+TEST_CASE(SH9ProjectionMatchesClosedForm)
+{
+    SH9Color expected;
+    GetExpectedSH9(expected);
+
+    TextureData panorama = MakePanorama(256, 128);
+    SH9Color panoramaSH;
+    CHECK(ProjectPanoramaSH9(panorama, panoramaSH));
+    CheckSH9(panoramaSH, expected, 1e-3f);
+
+    TextureData cubemap;
+    CHECK(PanoramaToCubemap(panorama, 64, cubemap));
+    SH9Color cubemapSH;
+    CHECK(ProjectCubemapSH9(cubemap, cubemapSH));
+    CheckSH9(cubemapSH, expected, 1e-3f);
+
+    // The constant and linear channels are band limited, so the convolved SH is exact for them.
+    // The clamped cosine lobe is not, SH9 leaves a small ringing error.
+    ConvolveSH9Irradiance(cubemapSH);
+    float maxError[3];
+    GetSH9IrradianceError(cubemapSH, maxError);
+    CHECK_NEAR(0.0f, maxError[0], 1e-3f);
+    CHECK_NEAR(0.0f, maxError[1], 0.01f);
+    CHECK_NEAR(0.0f, maxError[2], 1e-3f);
+}
+
+TEST_CASE(BRDFLUTMatchesSplitSumLimits)
+{
+    BRDFLUTSettings settings;
+    settings.Size = 32;
+    settings.SampleCount = 512;
+    TextureData lut;
+    CHECK(GenerateBRDFLUT(settings, lut));
+    CHECK(lut.Format == TextureFormat::RG16Float);
+    CHECK_EQUAL(32u, lut.Width);
+    CHECK_EQUAL(32u, lut.Height);
+
+    // NdotV = 1 on a mirror: all of F0 is reflected, scale 1 and bias 0.
+    float scaleBias[2];
+    ReadBRDFLUTTexel(lut, settings.Size - 1, 0, scaleBias);
+    CHECK_NEAR(1.0f, scaleBias[0], 1e-3f);
+    CHECK_NEAR(0.0f, scaleBias[1], 1e-3f);
+
+    for (uint32_t x = 0; x < settings.Size; ++x)
+    {
+        float previous[2] = { INFINITY, INFINITY };
+        for (uint32_t y = 0; y < settings.Size; ++y)
+        {
+            ReadBRDFLUTTexel(lut, x, y, scaleBias);
+            // Energy: scale + bias is the reflectance for F0 = 1.
+            CHECK(scaleBias[0] >= 0.0f && scaleBias[1] >= 0.0f);
+            CHECK(scaleBias[0] + scaleBias[1] <= 1.0f + 1e-3f);
+
+            // Rougher surfaces reflect less, except at grazing angles, where the k = alpha / 2
+            // remapping of the Schlick-Smith term is known to let the rough end rise again.
+            const float nDotV = (x + 0.5f) / settings.Size;
+            if (nDotV >= 0.25f)
+            {
+                CHECK(scaleBias[0] <= previous[0] + 1e-3f);
+                CHECK(scaleBias[0] + scaleBias[1] <= previous[0] + previous[1] + 1e-3f);
+            }
+            previous[0] = scaleBias[0];
+            previous[1] = scaleBias[1];
+        }
+    }
+
+    // The smooth end reflects nearly everything away from grazing angles, the rough end clearly less.
+    for (uint32_t x = settings.Size / 4; x < settings.Size; ++x)
+    {
+        ReadBRDFLUTTexel(lut, x, 0, scaleBias);
+        CHECK(scaleBias[0] + scaleBias[1] > 0.99f);
+        ReadBRDFLUTTexel(lut, x, settings.Size - 1, scaleBias);
+        CHECK(scaleBias[0] + scaleBias[1] < 0.8f);
+    }
+}
+
+TEST_CASE(BRDFLUTCacheIsReused)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "BRDFLUTCacheIsReused.tex";
+    std::filesystem::remove(path);
+
+    BRDFLUTSettings settings;
+    settings.Size = 16;
+    settings.SampleCount = 64;
+    CHECK(BuildBRDFLUTCache(path.wstring(), settings));
+
+    TextureData expected;
+    CHECK(GenerateBRDFLUT(settings, expected));
+    {
+        TextureFile cache;
+        CHECK(cache.Open(path.wstring()));
+        CHECK_EQUAL(ComputeBRDFLUTCacheKey(settings), cache.GetHeader().Key);
+        CHECK_EQUAL(1u, cache.GetHeader().NumTextures);
+        const TextureFileTexture& texture = cache.GetTexture(0);
+        CHECK_EQUAL(uint32_t(TextureFormat::RG16Float), texture.Format);
+        CHECK_EQUAL(16u, texture.Width);
+        CHECK_EQUAL(1u, texture.NumSubresources);
+        const TextureFileSubresource& subresource = cache.GetSubresources(0)[0];
+        CHECK_EQUAL(uint64_t(expected.Pixels.size()), subresource.SlicePitch);
+        CHECK(memcmp(cache.GetPixels(subresource), expected.Pixels.data(), expected.Pixels.size()) == 0);
+    }
+
+    // A matching key is not written again, other settings rebuild the table.
+    const auto writeTime = std::filesystem::last_write_time(path);
+    CHECK(BuildBRDFLUTCache(path.wstring(), settings));
+    CHECK(std::filesystem::last_write_time(path) == writeTime);
+
+    settings.SampleCount = 128;
+    CHECK(BuildBRDFLUTCache(path.wstring(), settings));
+    {
+        TextureFile cache;
+        CHECK(cache.Open(path.wstring()));
+        CHECK_EQUAL(ComputeBRDFLUTCacheKey(settings), cache.GetHeader().Key);
+    }
+    std::filesystem::remove(path);
+}
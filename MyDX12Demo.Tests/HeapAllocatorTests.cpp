@@ -0,0 +1,275 @@
+#include <HeapAllocator.h>
+
+#include <TestFramework.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    const uint64_t KB = 1024;
+    const uint64_t MB = 1024 * KB;
+
+    struct FakeHeap
+    {
+        uint64_t Size;
+        uint64_t Alignment;
+    };
+
+    // Stands in for ID3D12Device::CreateHeap, keeps track of the live heaps.
+    class FakeDevice
+    {
+    public:
+        HeapAllocator::CreateHeapFunc GetCreateHeap()
+        {
+            return [this](uint64_t size, uint64_t alignment) -> void*
+            {
+                if (m_FailCreate)
+                {
+                    return nullptr;
+                }
+                m_Heaps.push_back(std::make_unique<FakeHeap>(FakeHeap{ size, alignment }));
+                return m_Heaps.back().get();
+            };
+        }
+
+        HeapAllocator::DestroyHeapFunc GetDestroyHeap()
+        {
+            return [this](void* pHeap)
+            {
+                auto iter = std::find_if(m_Heaps.begin(), m_Heaps.end(),
+                    [pHeap](const std::unique_ptr<FakeHeap>& heap) { return heap.get() == pHeap; });
+                CHECK(iter != m_Heaps.end());
+                m_Heaps.erase(iter);
+            };
+        }
+
+        size_t GetNumHeaps() const { return m_Heaps.size(); }
+        void SetFailCreate(bool failCreate) { m_FailCreate = failCreate; }
+
+    private:
+        std::vector<std::unique_ptr<FakeHeap>> m_Heaps;
+        bool m_FailCreate = false;
+    };
+
+    const FakeHeap& GetHeap(const HeapAllocator::Allocation& allocation)
+    {
+        return *static_cast<const FakeHeap*>(allocation.pHeap);
+    }
+
+    void CheckFullyMerged(const BuddyAllocator& allocator)
+    {
+        CHECK(allocator.IsEmpty());
+        CHECK_EQUAL(uint64_t(0), allocator.GetUsedSize());
+        CHECK_EQUAL(uint64_t(0), allocator.GetRequestedSize());
+        CHECK_EQUAL(allocator.GetSize(), allocator.GetLargestFreeBlock());
+        CHECK_EQUAL(0.0f, allocator.GetFragmentation());
+    }
+}
+
+TEST_CASE(BuddyAllocatorSplitsAndMerges)
+{
+    BuddyAllocator allocator(1024, 64);
+    CHECK_EQUAL(uint64_t(1024), allocator.GetLargestFreeBlock());
+
+    // The first block splits the range down to the minimum size, the lowest halves are used first.
+    CHECK_EQUAL(uint64_t(0), allocator.Allocate(64));
+    CHECK_EQUAL(uint64_t(512), allocator.GetLargestFreeBlock());
+    CHECK_EQUAL(uint64_t(64), allocator.Allocate(1));
+    CHECK_EQUAL(uint64_t(128), allocator.Allocate(128));
+    // Rounded up to 128, which splits the free block at 256.
+    CHECK_EQUAL(uint64_t(256), allocator.Allocate(100));
+    CHECK_EQUAL(uint64_t(64 + 64 + 128 + 128), allocator.GetUsedSize());
+    CHECK_EQUAL(uint64_t(64 + 1 + 128 + 100), allocator.GetRequestedSize());
+
+    // The alignment raises the block size, the block at 384 is too small.
+    uint64_t aligned = allocator.Allocate(64, 256);
+    CHECK_EQUAL(uint64_t(512), aligned);
+    CHECK_EQUAL(uint64_t(128 + 256), allocator.GetFreeSize());
+    CHECK_EQUAL(uint64_t(256), allocator.GetLargestFreeBlock());
+    CHECK(allocator.Allocate(512) == BuddyAllocator::InvalidOffset);
+    CHECK(allocator.Allocate(2048) == BuddyAllocator::InvalidOffset);
+
+    // Freeing a block whose buddy is in use does not merge.
+    allocator.Free(0);
+    CHECK_EQUAL(uint64_t(256), allocator.GetLargestFreeBlock());
+    // Freeing the buddy merges 0 and 64 into a 128 block, which is reused first.
+    allocator.Free(64);
+    CHECK_EQUAL(uint64_t(0), allocator.Allocate(128));
+    allocator.Free(0);
+
+    // 256 merges with 384, 0..255 with 256..511 once 128 is free, then everything with 512..1023.
+    allocator.Free(256);
+    allocator.Free(128);
+    CHECK_EQUAL(uint64_t(512), allocator.GetLargestFreeBlock());
+    allocator.Free(aligned);
+    CheckFullyMerged(allocator);
+}
+
+TEST_CASE(BuddyAllocatorFreesInAnyOrder)
+{
+    const uint64_t size = 4096;
+    const uint64_t minBlockSize = 64;
+    const uint32_t numBlocks = static_cast<uint32_t>(size / minBlockSize);
+
+    auto allocateAll = [&](BuddyAllocator& allocator)
+    {
+        std::vector<uint64_t> offsets;
+        for (uint32_t i = 0; i < numBlocks; ++i)
+        {
+            offsets.push_back(allocator.Allocate(minBlockSize));
+            CHECK_EQUAL(uint64_t(i) * minBlockSize, offsets.back());
+        }
+        CHECK(allocator.Allocate(1) == BuddyAllocator::InvalidOffset);
+        CHECK_EQUAL(uint64_t(0), allocator.GetFreeSize());
+        return offsets;
+    };
+
+    // Reverse order.
+    {
+        BuddyAllocator allocator(size, minBlockSize);
+        std::vector<uint64_t> offsets = allocateAll(allocator);
+        for (auto iter = offsets.rbegin(); iter != offsets.rend(); ++iter)
+        {
+            allocator.Free(*iter);
+        }
+        CheckFullyMerged(allocator);
+    }
+
+    // Interleaved: every other block first, nothing can merge until the second half.
+    {
+        BuddyAllocator allocator(size, minBlockSize);
+        std::vector<uint64_t> offsets = allocateAll(allocator);
+        for (uint32_t i = 0; i < numBlocks; i += 2)
+        {
+            allocator.Free(offsets[i]);
+        }
+        CHECK_EQUAL(size / 2, allocator.GetFreeSize());
+        CHECK_EQUAL(minBlockSize, allocator.GetLargestFreeBlock());
+        CHECK(allocator.GetFragmentation() > 0.9f);
+
+        for (uint32_t i = 1; i < numBlocks; i += 2)
+        {
+            allocator.Free(offsets[i]);
+        }
+        CheckFullyMerged(allocator);
+    }
+
+    // Mixed sizes, freed in a scrambled order.
+    {
+        BuddyAllocator allocator(size, minBlockSize);
+        std::vector<uint64_t> offsets;
+        const uint64_t sizes[] = { 64, 200, 64, 1024, 128, 64, 512, 100 };
+        for (uint64_t blockSize : sizes)
+        {
+            offsets.push_back(allocator.Allocate(blockSize));
+            CHECK(offsets.back() != BuddyAllocator::InvalidOffset);
+        }
+        for (uint32_t i : { 3u, 0u, 6u, 2u, 7u, 5u, 1u, 4u })
+        {
+            allocator.Free(offsets[i]);
+        }
+        CheckFullyMerged(allocator);
+    }
+}
+
+TEST_CASE(HeapAllocatorUsesFakeHeaps)
+{
+    FakeDevice device;
+    {
+        HeapAllocator allocator(1 * MB, 64 * KB, device.GetCreateHeap(), device.GetDestroyHeap());
+
+        // Sixteen 64KB blocks fill the first heap, the next allocation creates a second one.
+        std::vector<HeapAllocator::Allocation> allocations;
+        for (uint32_t i = 0; i < 17; ++i)
+        {
+            allocations.push_back(allocator.Allocate(64 * KB));
+            CHECK(allocations.back().IsValid());
+            CHECK_EQUAL(uint64_t(0), allocations.back().Offset % (64 * KB));
+        }
+        CHECK_EQUAL(size_t(2), device.GetNumHeaps());
+        CHECK(allocations[0].pHeap == allocations[15].pHeap);
+        CHECK(allocations[16].pHeap != allocations[0].pHeap);
+        CHECK_EQUAL(1 * MB, GetHeap(allocations[16]).Size);
+        CHECK_EQUAL(64 * KB, GetHeap(allocations[16]).Alignment);
+
+        HeapAllocator::Statistics statistics = allocator.GetStatistics();
+        CHECK_EQUAL(2u, statistics.NumHeaps);
+        CHECK_EQUAL(17u, statistics.NumAllocations);
+        CHECK_EQUAL(2 * MB, statistics.ReservedSize);
+        CHECK_EQUAL(17 * 64 * KB, statistics.UsedSize);
+
+        // A freed block in the first heap is reused before the second heap is touched.
+        HeapAllocator::Allocation freed = allocations[5];
+        allocator.Free(allocations[5]);
+        CHECK(!allocations[5].IsValid());
+        allocations[5] = allocator.Allocate(10 * KB);
+        CHECK(allocations[5].pHeap == freed.pHeap);
+        CHECK_EQUAL(freed.Offset, allocations[5].Offset);
+
+        // Freed in an interleaved order, the heaps are kept and merge back to one free block each.
+        for (size_t i = 0; i < allocations.size(); i += 2)
+        {
+            allocator.Free(allocations[i]);
+        }
+        for (size_t i = allocations.size(); i-- > 0; )
+        {
+            allocator.Free(allocations[i]);
+        }
+        statistics = allocator.GetStatistics();
+        CHECK_EQUAL(2u, statistics.NumHeaps);
+        CHECK_EQUAL(0u, statistics.NumAllocations);
+        CHECK_EQUAL(uint64_t(0), statistics.UsedSize);
+        CHECK_EQUAL(1 * MB, statistics.LargestFreeBlock);
+        // Each heap is one free block, the free space is only split between the two heaps.
+        CHECK_EQUAL(0.5f, statistics.Fragmentation);
+        CHECK_EQUAL(size_t(2), device.GetNumHeaps());
+    }
+    // The allocator destroys its heaps.
+    CHECK_EQUAL(size_t(0), device.GetNumHeaps());
+}
+
+TEST_CASE(HeapAllocatorUsesDedicatedHeapForLargeResources)
+{
+    FakeDevice device;
+    HeapAllocator allocator(1 * MB, 64 * KB, device.GetCreateHeap(), device.GetDestroyHeap());
+
+    HeapAllocator::Allocation small = allocator.Allocate(64 * KB);
+    CHECK_EQUAL(size_t(1), device.GetNumHeaps());
+
+    // Larger than a regular heap: its own heap, only rounded up to the alignment and not to a power of two.
+    HeapAllocator::Allocation large = allocator.Allocate(3 * MB + 1);
+    CHECK(large.IsValid());
+    CHECK_EQUAL(size_t(2), device.GetNumHeaps());
+    CHECK(large.pHeap != small.pHeap);
+    CHECK_EQUAL(uint64_t(0), large.Offset);
+    CHECK_EQUAL(3 * MB + 64 * KB, GetHeap(large).Size);
+
+    // An alignment larger than the heap size also needs a dedicated heap, with that alignment.
+    HeapAllocator::Allocation msaa = allocator.Allocate(64 * KB, 4 * MB);
+    CHECK(msaa.IsValid());
+    CHECK_EQUAL(4 * MB, GetHeap(msaa).Alignment);
+    CHECK_EQUAL(4 * MB, GetHeap(msaa).Size);
+
+    HeapAllocator::Statistics statistics = allocator.GetStatistics();
+    CHECK_EQUAL(3u, statistics.NumHeaps);
+    CHECK_EQUAL(3u, statistics.NumAllocations);
+    CHECK_EQUAL(64 * KB + 3 * MB + 1 + 64 * KB, statistics.RequestedSize);
+
+    // Dedicated heaps are destroyed as soon as their resource is freed, the regular heap stays.
+    allocator.Free(large);
+    CHECK_EQUAL(size_t(2), device.GetNumHeaps());
+    allocator.Free(msaa);
+    CHECK_EQUAL(size_t(1), device.GetNumHeaps());
+    allocator.Free(small);
+    CHECK_EQUAL(size_t(1), device.GetNumHeaps());
+
+    // A heap that can not be created gives an invalid allocation.
+    device.SetFailCreate(true);
+    CHECK(!allocator.Allocate(8 * MB).IsValid());
+    // The existing regular heap still has room.
+    HeapAllocator::Allocation whole = allocator.Allocate(1 * MB);
+    CHECK(whole.IsValid());
+    allocator.Free(whole);
+}
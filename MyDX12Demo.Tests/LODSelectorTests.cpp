@@ -0,0 +1,144 @@
+#include <LODSelector.h>
+
+#include <TestFramework.h>
+#include <ThreadPool.h>
+
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // A field of view of 90 degrees and 1000 pixels: one unit of error at distance d covers 500 / d pixels.
+    const float ViewportHeight = 1000.0f;
+
+    // LOD 1 is within one pixel from a distance of 5, LOD 2 from a distance of 20.
+    const MeshFileLOD LODs[] = {
+        { 0, 300, 0.0f },
+        { 300, 150, 0.01f },
+        { 450, 60, 0.04f },
+    };
+
+    XMMATRIX GetProjection()
+    {
+        return XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 0.1f, 1000.0f);
+    }
+
+    // Moves the instance to the given distance in front of the camera and selects its LOD.
+    uint32_t SelectAt(LODSelector& selector, uint32_t instance, float distance)
+    {
+        selector.SetInstanceBounds(instance, XMFLOAT3(0.0f, 0.0f, distance), 0.0f);
+        selector.Select(XMMatrixIdentity(), GetProjection(), ViewportHeight);
+        return selector.GetLOD(instance);
+    }
+}
+
+TEST_CASE(LODSelectorPicksCoarsestLODWithinThreshold)
+{
+    LODSelector selector;
+    uint32_t chain = selector.AddLODChain(LODs, 3);
+    uint32_t instance = selector.AddInstance(chain);
+    CHECK_EQUAL(0u, selector.GetLOD(instance));
+
+    // Far away the coarsest LOD, moving closer refines right at the threshold.
+    CHECK_EQUAL(2u, SelectAt(selector, instance, 100.0f));
+    CHECK_EQUAL(2u, SelectAt(selector, instance, 21.0f));
+    CHECK_EQUAL(1u, SelectAt(selector, instance, 19.0f));
+    CHECK_EQUAL(1u, SelectAt(selector, instance, 5.5f));
+    CHECK_EQUAL(0u, SelectAt(selector, instance, 4.5f));
+    // Inside the bounding sphere the finest LOD.
+    selector.SetInstanceBounds(instance, XMFLOAT3(0.0f, 0.0f, 1.0f), 2.0f);
+    selector.Select(XMMatrixIdentity(), GetProjection(), ViewportHeight);
+    CHECK_EQUAL(0u, selector.GetLOD(instance));
+
+    // The error is measured to the closest point of the sphere and scaled with the instance.
+    selector.SetInstanceBounds(instance, XMFLOAT3(0.0f, 0.0f, 30.0f), 5.0f);
+    selector.Select(XMMatrixIdentity(), GetProjection(), ViewportHeight);
+    CHECK_EQUAL(1u, selector.GetLOD(instance));
+    selector.SetInstanceBounds(instance, XMFLOAT3(0.0f, 0.0f, 100.0f), 0.0f, 10.0f);
+    selector.Select(XMMatrixIdentity(), GetProjection(), ViewportHeight);
+    CHECK_EQUAL(1u, selector.GetLOD(instance));
+
+    // Zooming in (a narrower field of view) refines at the same distance.
+    CHECK_EQUAL(2u, SelectAt(selector, instance, 100.0f));
+    selector.Select(XMMatrixIdentity(), XMMatrixPerspectiveFovLH(XM_PIDIV2 / 10.0f, 1.0f, 0.1f, 1000.0f), ViewportHeight);
+    CHECK_EQUAL(1u, selector.GetLOD(instance));
+}
+
+TEST_CASE(LODSelectorHysteresisPreventsFlicker)
+{
+    // The distance oscillates around 5, where the error of LOD 1 crosses the one pixel threshold.
+    const float distances[] = { 4.9f, 5.3f };
+    const int numFrames = 20;
+
+    auto countSwitches = [&](float hysteresis)
+    {
+        LODSelectionSettings settings;
+        settings.Hysteresis = hysteresis;
+        LODSelector selector(settings);
+        uint32_t instance = selector.AddInstance(selector.AddLODChain(LODs, 3));
+        CHECK_EQUAL(1u, SelectAt(selector, instance, 10.0f));
+
+        int numSwitches = 0;
+        uint32_t lod = selector.GetLOD(instance);
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            uint32_t newLOD = SelectAt(selector, instance, distances[frame % 2]);
+            numSwitches += newLOD != lod ? 1 : 0;
+            lod = newLOD;
+        }
+        return numSwitches;
+    };
+
+    // Without hysteresis the LOD flips every frame.
+    CHECK_EQUAL(numFrames, countSwitches(0.0f));
+    // With it the first frame refines and the LOD then stays.
+    CHECK_EQUAL(1, countSwitches(0.25f));
+
+    // A coarser LOD is taken again once the error is clearly below the threshold, at 5 / 0.75.
+    LODSelector selector;
+    uint32_t instance = selector.AddInstance(selector.AddLODChain(LODs, 3));
+    CHECK_EQUAL(0u, SelectAt(selector, instance, 4.9f));
+    CHECK_EQUAL(0u, SelectAt(selector, instance, 6.5f));
+    CHECK_EQUAL(1u, SelectAt(selector, instance, 6.8f));
+}
+
+TEST_CASE(LODSelectorSelectsManyInstances)
+{
+    // More than one task of instances and a count that is not a multiple of four.
+    const uint32_t numInstances = 5003;
+    LODSelector serial;
+    LODSelector parallel;
+    const MeshFileLOD singleLOD[] = { { 0, 300, 0.0f } };
+    const uint32_t chains[] = { serial.AddLODChain(LODs, 3), serial.AddLODChain(singleLOD, 1) };
+    parallel.AddLODChain(LODs, 3);
+    parallel.AddLODChain(singleLOD, 1);
+
+    for (uint32_t i = 0; i < numInstances; ++i)
+    {
+        XMFLOAT3 center(float(i % 7), 0.0f, 1.0f + float(i % 40));
+        uint32_t chain = chains[i % 5 == 0 ? 1 : 0];
+        serial.SetInstanceBounds(serial.AddInstance(chain), center, 0.5f);
+        parallel.SetInstanceBounds(parallel.AddInstance(chain), center, 0.5f);
+    }
+    CHECK_EQUAL(size_t(numInstances), serial.GetNumInstances());
+
+    ThreadPool threadPool;
+    serial.Select(XMMatrixIdentity(), GetProjection(), ViewportHeight);
+    parallel.Select(XMMatrixIdentity(), GetProjection(), ViewportHeight, &threadPool);
+
+    uint32_t numCoarsest = 0;
+    for (uint32_t i = 0; i < numInstances; ++i)
+    {
+        CHECK_EQUAL(serial.GetLOD(i), parallel.GetLOD(i));
+        if (i % 5 == 0)
+        {
+            CHECK_EQUAL(0u, serial.GetLOD(i));
+        }
+        numCoarsest += serial.GetLOD(i) == 2 ? 1 : 0;
+    }
+    CHECK(numCoarsest > 0);
+
+    serial.Clear();
+    CHECK_EQUAL(size_t(0), serial.GetNumInstances());
+}
@@ -0,0 +1,213 @@
+#include <MeshFile.h>
+#include <MeshConverter.h>
+
+#include <TestFramework.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::wstring GetTempFileName(const char* name)
+    {
+        return (std::filesystem::temp_directory_path() / name).wstring();
+    }
+
+    // Grid of size * size quads with vertex colors, written as OBJ text.
+    void WriteGridObj(const std::wstring& fileName, uint32_t size)
+    {
+        std::ofstream file(std::filesystem::path(fileName), std::ios::trunc);
+        for (uint32_t y = 0; y <= size; ++y)
+        {
+            for (uint32_t x = 0; x <= size; ++x)
+            {
+                file << "v " << x * 0.01f << ' ' << y * 0.01f << ' ' << ((x * 7 + y * 3) % 11) * 0.001f << ' '
+                    << x / float(size) << ' ' << y / float(size) << " 0.5\n";
+            }
+        }
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                // OBJ indices are 1-based.
+                uint32_t v = y * (size + 1) + x + 1;
+                file << "f " << v << ' ' << v + 1 << ' ' << v + size + 2 << ' ' << v + size + 1 << '\n';
+            }
+        }
+    }
+
+    // Two triangles with R32G32B32_FLOAT positions.
+    MeshData MakeQuad()
+    {
+        const float positions[] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+
+        MeshData mesh;
+        mesh.VertexStride = sizeof(float) * 3;
+        mesh.Attributes.push_back({ MeshAttributeSemantic::Position, MeshFormatR32G32B32Float, 0 });
+        mesh.Vertices.resize(sizeof(positions));
+        memcpy(mesh.Vertices.data(), positions, sizeof(positions));
+        mesh.Indices = { 0, 1, 2, 0, 2, 3 };
+        MeshFileSubmesh submesh = {};
+        submesh.IndexCount = 6;
+        submesh.VertexCount = 4;
+        mesh.Submeshes.push_back(submesh);
+        ComputeSubmeshBounds(mesh);
+        return mesh;
+    }
+
+    // Writes the mesh, lets patch modify the bytes of the file and tries to open it again.
+    template<typename PatchFunc>
+    bool OpenPatchedMeshFile(const char* name, const MeshData& mesh, PatchFunc patch)
+    {
+        const std::wstring fileName = GetTempFileName(name);
+        CHECK(WriteMeshFile(fileName, mesh));
+
+        std::vector<char> bytes(static_cast<size_t>(std::filesystem::file_size(std::filesystem::path(fileName))));
+        std::ifstream(std::filesystem::path(fileName), std::ios::binary).read(bytes.data(), bytes.size());
+        MeshFileHeader header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        patch(header, bytes);
+        memcpy(bytes.data(), &header, sizeof(header));
+        std::ofstream(std::filesystem::path(fileName), std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size());
+
+        bool opened;
+        {
+            MeshFile meshFile;
+            opened = meshFile.Open(fileName);
+        }
+        std::filesystem::remove(std::filesystem::path(fileName));
+        return opened;
+    }
+
+    MeshData MakeQuadWithLOD()
+    {
+        MeshData mesh = MakeQuad();
+        mesh.LODs.push_back({ 0, 6, 0.0f });
+        mesh.LODs.push_back({ 0, 3, 0.5f });
+        mesh.Submeshes[0].LODOffset = 0;
+        mesh.Submeshes[0].LODCount = 2;
+        return mesh;
+    }
+}
+
+TEST_CASE(MeshFileRoundTrip)
+{
+    const std::wstring fileName = GetTempFileName("MeshFileRoundTrip.mesh");
+    MeshData mesh = MakeQuad();
+    CHECK(WriteMeshFile(fileName, mesh));
+
+    MeshFile meshFile;
+    CHECK(meshFile.Open(fileName));
+    const MeshFileHeader& header = meshFile.GetHeader();
+    CHECK_EQUAL(4u, header.VertexCount);
+    CHECK_EQUAL(6u, header.IndexCount);
+    CHECK_EQUAL(MeshFormatR16UInt, header.IndexFormat);
+    CHECK_EQUAL(1u, header.NumSubmeshes);
+    CHECK_EQUAL(0u, reinterpret_cast<uintptr_t>(meshFile.GetVertexData()) % MeshFileAlignment);
+    CHECK(memcmp(meshFile.GetVertexData(), mesh.Vertices.data(), mesh.Vertices.size()) == 0);
+
+    const uint16_t* pIndices = static_cast<const uint16_t*>(meshFile.GetIndexData());
+    for (size_t i = 0; i < mesh.Indices.size(); ++i)
+    {
+        CHECK_EQUAL(mesh.Indices[i], pIndices[i]);
+    }
+    CHECK_EQUAL(1.0f, meshFile.GetSubmeshes()[0].BoundsMax[0]);
+
+    meshFile.Close();
+    std::filesystem::remove(std::filesystem::path(fileName));
+}
+
+TEST_CASE(MeshFileRejectsSubmeshOutsideIndexStream)
+{
+    const std::wstring fileName = GetTempFileName("MeshFileRejectsSubmesh.mesh");
+    MeshData mesh = MakeQuad();
+    mesh.Submeshes[0].IndexStart = 3;
+    CHECK(WriteMeshFile(fileName, mesh));
+
+    MeshFile meshFile;
+    CHECK(!meshFile.Open(fileName));
+    CHECK(!meshFile.IsOpen());
+    std::filesystem::remove(std::filesystem::path(fileName));
+}
+
+TEST_CASE(MeshFileRejectsInvalidRecords)
+{
+    const MeshData mesh = MakeQuadWithLOD();
+    auto noPatch = [](MeshFileHeader&, std::vector<char>&) {};
+    CHECK(OpenPatchedMeshFile("MeshFileValid.mesh", mesh, noPatch));
+
+    MeshData invalidMesh = mesh;
+    invalidMesh.LODs[1].IndexStart = 4;
+    CHECK(!OpenPatchedMeshFile("MeshFileLODIndices.mesh", invalidMesh, noPatch));
+
+    invalidMesh = mesh;
+    invalidMesh.Submeshes[0].LODCount = 3;
+    CHECK(!OpenPatchedMeshFile("MeshFileLODRange.mesh", invalidMesh, noPatch));
+
+    invalidMesh = mesh;
+    invalidMesh.Submeshes[0].BaseVertex = 1;
+    CHECK(!OpenPatchedMeshFile("MeshFileBaseVertex.mesh", invalidMesh, noPatch));
+
+    // Offsets that wrap around when the table size is added must not pass the extent checks.
+    CHECK(!OpenPatchedMeshFile("MeshFileSubmeshOffset.mesh", mesh, [](MeshFileHeader& header, std::vector<char>&)
+    {
+        header.NumSubmeshes = 4;
+        header.SubmeshOffset = 0ull - 4 * sizeof(MeshFileSubmesh);
+    }));
+    CHECK(!OpenPatchedMeshFile("MeshFileLODOffset.mesh", mesh, [](MeshFileHeader& header, std::vector<char>&)
+    {
+        header.LODOffset = 0ull - uint64_t(header.NumLODs) * sizeof(MeshFileLOD);
+    }));
+    CHECK(!OpenPatchedMeshFile("MeshFileVertexCount.mesh", mesh, [](MeshFileHeader& header, std::vector<char>&)
+    {
+        // VertexCount * VertexStride wraps to the real stream size (the stride is a multiple of 4).
+        header.VertexCount += 1ull << 62;
+    }));
+}
+
+// Load time of a 512 * 512 quad grid (525K triangles) from OBJ text against
+// mapping the binary mesh file and copying its streams as the upload would.
+BENCHMARK(MeshFileLoadTime)
+{
+    const std::wstring objFileName = GetTempFileName("MeshFileLoadTime.obj");
+    const std::wstring meshFileName = GetTempFileName("MeshFileLoadTime.mesh");
+    WriteGridObj(objFileName, 512);
+
+    MeshData mesh;
+    CHECK(LoadObjMesh(objFileName, mesh));
+    CHECK(WriteMeshFile(meshFileName, mesh));
+
+    const int numIterations = 3;
+    Test::Timer objTimer;
+    for (int i = 0; i < numIterations; ++i)
+    {
+        MeshData objMesh;
+        CHECK(LoadObjMesh(objFileName, objMesh));
+        Test::DoNotOptimize(objMesh.Vertices.data());
+    }
+    double objSeconds = objTimer.GetElapsedSeconds() / numIterations;
+
+    std::vector<uint8_t> uploadMemory;
+    Test::Timer meshTimer;
+    for (int i = 0; i < numIterations; ++i)
+    {
+        MeshFile meshFile;
+        CHECK(meshFile.Open(meshFileName));
+        const MeshFileHeader& header = meshFile.GetHeader();
+        uploadMemory.resize(static_cast<size_t>(header.VertexDataSize + header.IndexDataSize));
+        memcpy(uploadMemory.data(), meshFile.GetVertexData(), static_cast<size_t>(header.VertexDataSize));
+        memcpy(uploadMemory.data() + header.VertexDataSize, meshFile.GetIndexData(), static_cast<size_t>(header.IndexDataSize));
+        Test::DoNotOptimize(uploadMemory.data());
+    }
+    double meshSeconds = meshTimer.GetElapsedSeconds() / numIterations;
+
+    Test::Report("LoadObjMesh", objSeconds * 1000.0, "ms");
+    Test::Report("MeshFile::Open + stream copy", meshSeconds * 1000.0, "ms");
+    Test::Report("Speedup", objSeconds / meshSeconds, "x");
+
+    std::filesystem::remove(std::filesystem::path(objFileName));
+    std::filesystem::remove(std::filesystem::path(meshFileName));
+}
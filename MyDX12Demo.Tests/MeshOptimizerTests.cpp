@@ -0,0 +1,246 @@
+#include <MeshOptimizer.h>
+
+#include <TestFramework.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Triangle = std::array<uint32_t, 3>;
+
+    // Grid of size * size quads in the z = 0 plane, triangles in row order.
+    MeshData MakeGrid(uint32_t size)
+    {
+        MeshData mesh;
+        mesh.VertexStride = sizeof(float) * 3;
+        mesh.Attributes.push_back({ MeshAttributeSemantic::Position, MeshFormatR32G32B32Float, 0 });
+
+        std::vector<float> positions;
+        for (uint32_t y = 0; y <= size; ++y)
+        {
+            for (uint32_t x = 0; x <= size; ++x)
+            {
+                positions.insert(positions.end(), { float(x), float(y), 0.0f });
+            }
+        }
+        mesh.Vertices.resize(positions.size() * sizeof(float));
+        memcpy(mesh.Vertices.data(), positions.data(), mesh.Vertices.size());
+
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                uint32_t a = y * (size + 1) + x;
+                uint32_t c = a + size + 1;
+                mesh.Indices.insert(mesh.Indices.end(), { a, a + 1, c, a + 1, c + 1, c });
+            }
+        }
+        return mesh;
+    }
+
+    // The same triangles in a random order, the worst case for the vertex cache.
+    void ShuffleTriangles(std::vector<uint32_t>& indices, uint32_t seed)
+    {
+        std::vector<Triangle> triangles(indices.size() / 3);
+        memcpy(triangles.data(), indices.data(), indices.size() * sizeof(uint32_t));
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+        memcpy(indices.data(), triangles.data(), indices.size() * sizeof(uint32_t));
+    }
+
+    // Triangles with the smallest index first, sorted, so reordered index buffers compare equal.
+    std::vector<Triangle> GetSortedTriangles(const std::vector<uint32_t>& indices)
+    {
+        std::vector<Triangle> triangles;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            Triangle triangle = { indices[i], indices[i + 1], indices[i + 2] };
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // Triangles as vertex positions with the winding kept, for comparisons across a vertex remap.
+    std::vector<std::array<float, 9>> GetSortedTrianglePositions(const MeshData& mesh)
+    {
+        std::vector<std::array<float, 9>> triangles;
+        for (const Triangle& triangle : GetSortedTriangles(mesh.Indices))
+        {
+            std::array<float, 9> positions;
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                memcpy(&positions[corner * 3], mesh.Vertices.data() + size_t(triangle[corner]) * mesh.VertexStride, sizeof(float) * 3);
+            }
+            // Rotate to the lexicographically smallest corner, the indices no longer define the start.
+            std::array<float, 9> best = positions;
+            for (int rotation = 1; rotation < 3; ++rotation)
+            {
+                std::array<float, 9> rotated;
+                for (int i = 0; i < 9; ++i)
+                {
+                    rotated[i] = positions[(i + rotation * 3) % 9];
+                }
+                best = std::min(best, rotated);
+            }
+            triangles.push_back(best);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+}
+
+TEST_CASE(VertexCacheAnalyzerCountsMisses)
+{
+    // Two triangles sharing an edge: four transforms, every vertex once.
+    const uint32_t quad[] = { 0, 1, 2, 2, 1, 3 };
+    VertexCacheStatistics statistics = AnalyzeVertexCache(quad, 6, 4);
+    CHECK_EQUAL(4u, statistics.VerticesTransformed);
+    CHECK_EQUAL(2.0f, statistics.ACMR);
+    CHECK_EQUAL(1.0f, statistics.ATVR);
+
+    // A FIFO of 3 entries evicts vertex 0 before the last triangle uses it again.
+    const uint32_t fan[] = { 0, 1, 2, 0, 2, 3, 0, 3, 4 };
+    statistics = AnalyzeVertexCache(fan, 9, 5, 3);
+    CHECK_EQUAL(6u, statistics.VerticesTransformed);
+    CHECK_EQUAL(2.0f, statistics.ACMR);
+    CHECK_EQUAL(6.0f / 5.0f, statistics.ATVR);
+    statistics = AnalyzeVertexCache(fan, 9, 5, 4);
+    CHECK_EQUAL(5u, statistics.VerticesTransformed);
+
+    CHECK_EQUAL(0u, AnalyzeVertexCache(nullptr, 0, 0).VerticesTransformed);
+}
+
+TEST_CASE(VertexCacheOptimizationImprovesGridACMR)
+{
+    const MeshData grid = MakeGrid(64);
+    const size_t vertexCount = grid.GetVertexCount();
+    const std::vector<Triangle> expectedTriangles = GetSortedTriangles(grid.Indices);
+
+    std::vector<uint32_t> shuffled = grid.Indices;
+    ShuffleTriangles(shuffled, 1);
+
+    const std::vector<uint32_t>* inputs[] = { &grid.Indices, &shuffled };
+    for (const std::vector<uint32_t>* pInput : inputs)
+    {
+        const std::vector<uint32_t>& input = *pInput;
+        VertexCacheStatistics before = AnalyzeVertexCache(input.data(), input.size(), vertexCount);
+
+        std::vector<uint32_t> optimized(input.size());
+        OptimizeVertexCache(optimized.data(), input.data(), input.size(), vertexCount);
+        VertexCacheStatistics after = AnalyzeVertexCache(optimized.data(), optimized.size(), vertexCount);
+
+        // Same triangles with the same winding, in an order that is never worse.
+        CHECK(GetSortedTriangles(optimized) == expectedTriangles);
+        CHECK(after.ACMR <= before.ACMR);
+        // A regular grid converges to 0.5, a 16 entry cache gets well below one transform per triangle.
+        CHECK(after.ACMR < 0.8f);
+        CHECK(after.ATVR < 1.6f);
+
+        // The overdraw pass keeps the ACMR within its threshold.
+        std::vector<uint32_t> overdraw(input.size());
+        OptimizeOverdraw(overdraw.data(), optimized.data(), optimized.size(), reinterpret_cast<const float*>(grid.Vertices.data()),
+            grid.VertexStride, vertexCount, 1.05f);
+        CHECK(GetSortedTriangles(overdraw) == expectedTriangles);
+        CHECK(AnalyzeVertexCache(overdraw.data(), overdraw.size(), vertexCount).ACMR <= after.ACMR * 1.05f + 1e-4f);
+    }
+
+    // In place.
+    std::vector<uint32_t> inPlace = shuffled;
+    OptimizeVertexCache(inPlace.data(), inPlace.data(), inPlace.size(), vertexCount);
+    CHECK(GetSortedTriangles(inPlace) == expectedTriangles);
+    CHECK(AnalyzeVertexCache(inPlace.data(), inPlace.size(), vertexCount).ACMR < 0.8f);
+}
+
+TEST_CASE(VertexFetchRemapIsBijection)
+{
+    MeshData grid = MakeGrid(16);
+    const size_t vertexCount = grid.GetVertexCount();
+    // Drop the first row of quads, its lower vertices are no longer referenced.
+    grid.Indices.erase(grid.Indices.begin(), grid.Indices.begin() + 16 * 6);
+    ShuffleTriangles(grid.Indices, 2);
+
+    std::vector<uint32_t> remap(vertexCount);
+    size_t uniqueVertexCount = OptimizeVertexFetchRemap(remap.data(), grid.Indices.data(), grid.Indices.size(), vertexCount);
+    CHECK_EQUAL(vertexCount - 17, uniqueVertexCount);
+
+    // Every referenced vertex gets a distinct new index in [0, uniqueVertexCount), the others none.
+    std::vector<bool> used(uniqueVertexCount, false);
+    for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        if (vertex < 17)
+        {
+            CHECK(remap[vertex] == InvalidVertexIndex);
+            continue;
+        }
+        CHECK(remap[vertex] < uniqueVertexCount);
+        CHECK(!used[remap[vertex]]);
+        used[remap[vertex]] = true;
+    }
+
+    // The new indices appear in increasing order of first use, so the vertex buffer is read linearly.
+    std::vector<uint32_t> indices(grid.Indices.size());
+    RemapIndexBuffer(indices.data(), grid.Indices.data(), grid.Indices.size(), remap.data());
+    uint32_t nextVertex = 0;
+    for (uint32_t index : indices)
+    {
+        CHECK(index <= nextVertex);
+        if (index == nextVertex)
+        {
+            ++nextVertex;
+        }
+    }
+    CHECK_EQUAL(uniqueVertexCount, size_t(nextVertex));
+
+    // Remapped vertices and indices draw the same triangles.
+    MeshData remapped = grid;
+    remapped.Indices = indices;
+    remapped.Vertices.assign(uniqueVertexCount * grid.VertexStride, 0);
+    RemapVertexBuffer(remapped.Vertices.data(), grid.Vertices.data(), vertexCount, grid.VertexStride, remap.data());
+    CHECK(GetSortedTrianglePositions(remapped) == GetSortedTrianglePositions(grid));
+}
+
+TEST_CASE(OptimizeMeshKeepsTriangles)
+{
+    MeshData mesh = MakeGrid(32);
+    ShuffleTriangles(mesh.Indices, 3);
+    const VertexCacheStatistics before = AnalyzeVertexCache(mesh.Indices.data(), mesh.Indices.size(), mesh.GetVertexCount());
+    const MeshData original = mesh;
+
+    OptimizeMesh(mesh);
+    CHECK_EQUAL(original.Vertices.size(), mesh.Vertices.size());
+    CHECK(GetSortedTrianglePositions(mesh) == GetSortedTrianglePositions(original));
+    VertexCacheStatistics after = AnalyzeVertexCache(mesh.Indices.data(), mesh.Indices.size(), mesh.GetVertexCount());
+    CHECK(after.ACMR < before.ACMR);
+    CHECK(after.ACMR < 0.85f);
+}
+
+// OptimizeVertexCache on a shuffled 512 * 512 grid (524K triangles).
+BENCHMARK(VertexCacheOptimizationThroughput)
+{
+    MeshData grid = MakeGrid(512);
+    ShuffleTriangles(grid.Indices, 4);
+    const size_t vertexCount = grid.GetVertexCount();
+    const size_t numTriangles = grid.Indices.size() / 3;
+
+    std::vector<uint32_t> optimized(grid.Indices.size());
+    Test::Timer timer;
+    OptimizeVertexCache(optimized.data(), grid.Indices.data(), grid.Indices.size(), vertexCount);
+    double seconds = timer.GetElapsedSeconds();
+    Test::Report("OptimizeVertexCache", numTriangles / seconds * 1e-6, "Mtriangles/s");
+
+    std::vector<uint32_t> overdraw(grid.Indices.size());
+    timer = Test::Timer();
+    OptimizeOverdraw(overdraw.data(), optimized.data(), optimized.size(), reinterpret_cast<const float*>(grid.Vertices.data()),
+        grid.VertexStride, vertexCount);
+    seconds = timer.GetElapsedSeconds();
+    Test::Report("OptimizeOverdraw", numTriangles / seconds * 1e-6, "Mtriangles/s");
+
+    Test::Report("ACMR before", AnalyzeVertexCache(grid.Indices.data(), grid.Indices.size(), vertexCount).ACMR, "");
+    Test::Report("ACMR after", AnalyzeVertexCache(overdraw.data(), overdraw.size(), vertexCount).ACMR, "");
+}
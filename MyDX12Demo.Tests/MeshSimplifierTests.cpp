@@ -0,0 +1,409 @@
+#include <MeshSimplifier.h>
+#include <MeshFile.h>
+
+#include <TestFramework.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    struct Float3
+    {
+        float x, y, z;
+    };
+
+    Float3 Subtract(const Float3& a, const Float3& b)
+    {
+        return { a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+
+    float Dot(const Float3& a, const Float3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    Float3 Cross(const Float3& a, const Float3& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    MeshData MakeMesh(const std::vector<Float3>& positions, std::vector<uint32_t> indices)
+    {
+        MeshData mesh;
+        mesh.VertexStride = sizeof(Float3);
+        mesh.Attributes.push_back({ MeshAttributeSemantic::Position, MeshFormatR32G32B32Float, 0 });
+        mesh.Vertices.resize(positions.size() * sizeof(Float3));
+        memcpy(mesh.Vertices.data(), positions.data(), mesh.Vertices.size());
+        mesh.Indices = std::move(indices);
+        return mesh;
+    }
+
+    // Grid of size * size quads over [0, size]^2 in the z = 0 plane.
+    MeshData MakeGrid(uint32_t size)
+    {
+        std::vector<Float3> positions;
+        for (uint32_t y = 0; y <= size; ++y)
+        {
+            for (uint32_t x = 0; x <= size; ++x)
+            {
+                positions.push_back({ float(x), float(y), 0.0f });
+            }
+        }
+
+        std::vector<uint32_t> indices;
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                uint32_t a = y * (size + 1) + x;
+                uint32_t c = a + size + 1;
+                indices.insert(indices.end(), { a, a + 1, c, a + 1, c + 1, c });
+            }
+        }
+        return MakeMesh(positions, std::move(indices));
+    }
+
+    // Closed unit sphere without seams: an icosahedron subdivided levels times.
+    MeshData MakeSphere(uint32_t levels)
+    {
+        const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+        std::vector<Float3> positions = {
+            { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+            { 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+            { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 },
+        };
+        std::vector<uint32_t> indices = {
+            0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+            3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+        };
+
+        auto normalize = [](Float3 p)
+        {
+            float length = std::sqrt(Dot(p, p));
+            return Float3{ p.x / length, p.y / length, p.z / length };
+        };
+        for (Float3& p : positions)
+        {
+            p = normalize(p);
+        }
+
+        for (uint32_t level = 0; level < levels; ++level)
+        {
+            std::vector<std::pair<std::pair<uint32_t, uint32_t>, uint32_t>> midpoints;
+            auto getMidpoint = [&](uint32_t a, uint32_t b)
+            {
+                std::pair<uint32_t, uint32_t> key(std::min(a, b), std::max(a, b));
+                for (const auto& midpoint : midpoints)
+                {
+                    if (midpoint.first == key)
+                    {
+                        return midpoint.second;
+                    }
+                }
+                const Float3& pa = positions[a];
+                const Float3& pb = positions[b];
+                positions.push_back(normalize({ pa.x + pb.x, pa.y + pb.y, pa.z + pb.z }));
+                midpoints.push_back({ key, static_cast<uint32_t>(positions.size() - 1) });
+                return midpoints.back().second;
+            };
+
+            std::vector<uint32_t> subdivided;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+                uint32_t ab = getMidpoint(a, b), bc = getMidpoint(b, c), ca = getMidpoint(c, a);
+                subdivided.insert(subdivided.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+            }
+            indices = std::move(subdivided);
+        }
+        return MakeMesh(positions, std::move(indices));
+    }
+
+    const Float3& GetPosition(const MeshData& mesh, uint32_t vertex)
+    {
+        return *reinterpret_cast<const Float3*>(mesh.Vertices.data() + size_t(vertex) * mesh.VertexStride);
+    }
+
+    std::vector<uint32_t> Simplify(const MeshData& mesh, size_t targetIndexCount, float targetError,
+        const SimplifySettings& settings = SimplifySettings(), float* pResultError = nullptr)
+    {
+        std::vector<uint32_t> indices(mesh.Indices.size());
+        size_t indexCount = SimplifyMesh(indices.data(), mesh.Indices.data(), mesh.Indices.size(),
+            reinterpret_cast<const float*>(mesh.Vertices.data()), mesh.VertexStride, mesh.GetVertexCount(),
+            targetIndexCount, targetError, settings, pResultError);
+        indices.resize(indexCount);
+        return indices;
+    }
+
+    // Signed area of the triangles projected onto the z = 0 plane.
+    float GetProjectedArea(const MeshData& mesh, const std::vector<uint32_t>& indices)
+    {
+        float area = 0.0f;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            Float3 normal = Cross(Subtract(GetPosition(mesh, indices[i + 1]), GetPosition(mesh, indices[i])),
+                Subtract(GetPosition(mesh, indices[i + 2]), GetPosition(mesh, indices[i])));
+            area += 0.5f * normal.z;
+        }
+        return area;
+    }
+
+    std::set<uint32_t> GetReferencedVertices(const std::vector<uint32_t>& indices)
+    {
+        return std::set<uint32_t>(indices.begin(), indices.end());
+    }
+
+    bool IsOnGridBorder(const Float3& p, uint32_t size)
+    {
+        return p.x == 0.0f || p.y == 0.0f || p.x == float(size) || p.y == float(size);
+    }
+
+    // Distance from p to the closest point of the triangle abc (Ericson, Real-Time Collision Detection 5.1.5).
+    float GetDistanceToTriangle(const Float3& p, const Float3& a, const Float3& b, const Float3& c)
+    {
+        auto distance = [&p](const Float3& q)
+        {
+            Float3 d = Subtract(p, q);
+            return std::sqrt(Dot(d, d));
+        };
+        auto lerp = [](const Float3& u, const Float3& v, float t)
+        {
+            return Float3{ u.x + (v.x - u.x) * t, u.y + (v.y - u.y) * t, u.z + (v.z - u.z) * t };
+        };
+
+        Float3 ab = Subtract(b, a), ac = Subtract(c, a), ap = Subtract(p, a);
+        float d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return distance(a);
+        Float3 bp = Subtract(p, b);
+        float d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) return distance(b);
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return distance(lerp(a, b, d1 / (d1 - d3)));
+        Float3 cp = Subtract(p, c);
+        float d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) return distance(c);
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return distance(lerp(a, c, d2 / (d2 - d6)));
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) return distance(lerp(b, c, (d4 - d3) / ((d4 - d3) + (d5 - d6))));
+        float denominator = 1.0f / (va + vb + vc);
+        float v = vb * denominator, w = vc * denominator;
+        return distance({ a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w, a.z + ab.z * v + ac.z * w });
+    }
+
+    // Largest distance of an original vertex to the simplified surface.
+    float GetMaxDeviation(const MeshData& mesh, const std::vector<uint32_t>& simplified)
+    {
+        float maxDistance = 0.0f;
+        for (uint32_t vertex : GetReferencedVertices(mesh.Indices))
+        {
+            float distance = INFINITY;
+            for (size_t i = 0; i < simplified.size(); i += 3)
+            {
+                distance = std::min(distance, GetDistanceToTriangle(GetPosition(mesh, vertex),
+                    GetPosition(mesh, simplified[i]), GetPosition(mesh, simplified[i + 1]), GetPosition(mesh, simplified[i + 2])));
+            }
+            maxDistance = std::max(maxDistance, distance);
+        }
+        return maxDistance;
+    }
+}
+
+TEST_CASE(SimplifyMeshReachesTargetIndexCount)
+{
+    // Collapses inside a plane have no error, the interior of a grid reduces to the target.
+    const MeshData grid = MakeGrid(16);
+    const float area = GetProjectedArea(grid, grid.Indices);
+    for (size_t targetIndexCount : { size_t(1200), size_t(600), size_t(300) })
+    {
+        float resultError = -1.0f;
+        std::vector<uint32_t> indices = Simplify(grid, targetIndexCount, 1e-4f, SimplifySettings(), &resultError);
+        CHECK(indices.size() <= targetIndexCount);
+        CHECK(indices.size() >= targetIndexCount * 3 / 4);
+        CHECK_NEAR(0.0f, resultError, 1e-5f);
+        // No triangle flipped or folded over: the simplified grid covers the same area.
+        CHECK_NEAR(area, GetProjectedArea(grid, indices), 1e-3f);
+    }
+
+    // A closed mesh reaches the target as long as the error allows it.
+    const MeshData sphere = MakeSphere(3);
+    std::vector<uint32_t> indices = Simplify(sphere, sphere.Indices.size() / 4, 1.0f);
+    CHECK(indices.size() <= sphere.Indices.size() / 4);
+    CHECK(indices.size() >= sphere.Indices.size() / 5);
+
+    // The target is met from above in place too.
+    std::vector<uint32_t> inPlace = sphere.Indices;
+    size_t indexCount = SimplifyMesh(inPlace.data(), inPlace.data(), inPlace.size(), reinterpret_cast<const float*>(sphere.Vertices.data()),
+        sphere.VertexStride, sphere.GetVertexCount(), sphere.Indices.size() / 4, 1.0f);
+    inPlace.resize(indexCount);
+    CHECK(inPlace == indices);
+}
+
+TEST_CASE(SimplifyMeshRespectsErrorBound)
+{
+    const MeshData sphere = MakeSphere(3);
+
+    float previousError = 0.0f;
+    size_t previousCount = sphere.Indices.size();
+    for (float targetError : { 0.01f, 0.02f, 0.04f, 0.08f })
+    {
+        float resultError = -1.0f;
+        std::vector<uint32_t> indices = Simplify(sphere, 0, targetError, SimplifySettings(), &resultError);
+
+        // The error limit stops the simplification long before the target of 0 indices.
+        CHECK(!indices.empty());
+        CHECK(resultError >= 0.0f);
+        CHECK(resultError <= targetError);
+        // A larger limit allows more collapses.
+        CHECK(resultError >= previousError);
+        CHECK(indices.size() < previousCount);
+
+        // The reported error tracks the real distance to the original surface. It is an estimate from the
+        // quadrics of the collapses and not a strict bound, which is why a factor is allowed.
+        float deviation = GetMaxDeviation(sphere, indices);
+        CHECK(deviation <= 3.0f * resultError);
+
+        previousError = resultError;
+        previousCount = indices.size();
+    }
+
+    // Nothing can be removed from a sphere without any error.
+    CHECK_EQUAL(sphere.Indices.size(), Simplify(sphere, 0, 0.0f).size());
+}
+
+TEST_CASE(SimplifyMeshPreservesBorders)
+{
+    const uint32_t size = 16;
+    const MeshData grid = MakeGrid(size);
+    const float area = GetProjectedArea(grid, grid.Indices);
+
+    std::set<uint32_t> borderVertices;
+    for (uint32_t vertex = 0; vertex < grid.GetVertexCount(); ++vertex)
+    {
+        if (IsOnGridBorder(GetPosition(grid, vertex), size))
+        {
+            borderVertices.insert(vertex);
+        }
+    }
+    CHECK_EQUAL(size_t(4 * size), borderVertices.size());
+
+    // Locked: every border vertex stays.
+    SimplifySettings settings;
+    std::vector<uint32_t> locked = Simplify(grid, 0, 1.0f, settings);
+    std::set<uint32_t> referenced = GetReferencedVertices(locked);
+    for (uint32_t vertex : borderVertices)
+    {
+        CHECK(referenced.count(vertex) == 1);
+    }
+    // Only the border is left, the interior is gone.
+    CHECK(referenced.size() < borderVertices.size() + 4);
+    CHECK_NEAR(area, GetProjectedArea(grid, locked), 1e-3f);
+
+    // Sliding: border vertices collapse along the border, the outline and the corners stay.
+    settings.LockBorder = false;
+    std::vector<uint32_t> sliding = Simplify(grid, 0, 1e-3f, settings);
+    referenced = GetReferencedVertices(sliding);
+    CHECK(referenced.size() < borderVertices.size());
+    for (uint32_t vertex : referenced)
+    {
+        CHECK(IsOnGridBorder(GetPosition(grid, vertex), size));
+    }
+    for (uint32_t corner : { 0u, size, size * (size + 1), (size + 1) * (size + 1) - 1 })
+    {
+        CHECK(referenced.count(corner) == 1);
+    }
+    CHECK_NEAR(area, GetProjectedArea(grid, sliding), 1e-3f);
+}
+
+TEST_CASE(SimplifyMeshPreservesSeams)
+{
+    // Two halves of a grid that meet at x = size / 2 with their own vertices, like a UV seam.
+    const uint32_t size = 16;
+    const uint32_t half = size / 2;
+    const MeshData grid = MakeGrid(size);
+    std::vector<Float3> positions(reinterpret_cast<const Float3*>(grid.Vertices.data()),
+        reinterpret_cast<const Float3*>(grid.Vertices.data()) + grid.GetVertexCount());
+    std::vector<uint32_t> seamVertices;
+    std::vector<uint32_t> seamCopies(positions.size(), ~0u);
+    for (uint32_t y = 0; y <= size; ++y)
+    {
+        uint32_t vertex = y * (size + 1) + half;
+        seamVertices.push_back(vertex);
+        seamCopies[vertex] = static_cast<uint32_t>(positions.size());
+        seamVertices.push_back(seamCopies[vertex]);
+        positions.push_back(positions[vertex]);
+    }
+    std::vector<uint32_t> indices = grid.Indices;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        // Triangles of the right half use the copies.
+        if (positions[indices[i]].x + positions[indices[i + 1]].x + positions[indices[i + 2]].x > 3.0f * half)
+        {
+            for (size_t k = i; k < i + 3; ++k)
+            {
+                indices[k] = seamCopies[indices[k]] != ~0u ? seamCopies[indices[k]] : indices[k];
+            }
+        }
+    }
+    const MeshData mesh = MakeMesh(positions, std::move(indices));
+
+    // With sliding borders only the seam keeps the vertices of the middle column in place.
+    SimplifySettings settings;
+    settings.LockBorder = false;
+    std::vector<uint32_t> simplified = Simplify(mesh, 0, 1e-3f, settings);
+    CHECK(simplified.size() < mesh.Indices.size() / 4);
+    std::set<uint32_t> referenced = GetReferencedVertices(simplified);
+    for (uint32_t vertex : seamVertices)
+    {
+        CHECK(referenced.count(vertex) == 1);
+    }
+    CHECK_NEAR(GetProjectedArea(mesh, mesh.Indices), GetProjectedArea(mesh, simplified), 1e-3f);
+}
+
+TEST_CASE(GenerateLODsBuildsValidChain)
+{
+    MeshData mesh = MakeSphere(4);
+    const size_t baseIndexCount = mesh.Indices.size();
+    LODGenerationSettings settings;
+    settings.MaxLODs = 4;
+    CHECK(GenerateLODs(mesh, settings));
+
+    CHECK_EQUAL(size_t(1), mesh.Submeshes.size());
+    const MeshFileSubmesh& submesh = mesh.Submeshes[0];
+    CHECK_EQUAL(settings.MaxLODs, submesh.LODCount);
+    CHECK_EQUAL(size_t(submesh.LODOffset + submesh.LODCount), mesh.LODs.size());
+
+    const MeshFileLOD* pLODs = &mesh.LODs[submesh.LODOffset];
+    CHECK_EQUAL(0u, pLODs[0].IndexStart);
+    CHECK_EQUAL(uint32_t(baseIndexCount), pLODs[0].IndexCount);
+    CHECK_EQUAL(0.0f, pLODs[0].Error);
+    for (uint32_t lod = 1; lod < submesh.LODCount; ++lod)
+    {
+        // Every level removes at least 10% of the previous one, and the errors add up.
+        CHECK(pLODs[lod].IndexCount <= pLODs[lod - 1].IndexCount * 9 / 10);
+        CHECK(pLODs[lod].Error >= pLODs[lod - 1].Error);
+        CHECK(pLODs[lod].IndexStart + size_t(pLODs[lod].IndexCount) <= mesh.Indices.size());
+        CHECK(pLODs[lod].IndexCount % 3 == 0);
+    }
+    // The radius of the unit sphere is 1 (half the bounding box diagonal is sqrt(3)).
+    CHECK(pLODs[submesh.LODCount - 1].Error <= settings.MaxRelativeError * std::sqrt(3.0f));
+
+    // The chain passes the record validation of the mesh file and loads back unchanged.
+    const std::wstring fileName = (std::filesystem::temp_directory_path() / "GenerateLODsBuildsValidChain.mesh").wstring();
+    ComputeSubmeshBounds(mesh);
+    CHECK(WriteMeshFile(fileName, mesh));
+    {
+        MeshFile meshFile;
+        CHECK(meshFile.Open(fileName));
+        CHECK_EQUAL(uint32_t(mesh.LODs.size()), meshFile.GetHeader().NumLODs);
+        CHECK(memcmp(meshFile.GetLODs(), mesh.LODs.data(), mesh.LODs.size() * sizeof(MeshFileLOD)) == 0);
+    }
+    std::filesystem::remove(std::filesystem::path(fileName));
+}
@@ -0,0 +1,217 @@
+#include <MeshletBuilder.h>
+#include <MeshOptimizer.h>
+
+#include <TestFramework.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Triangle = std::array<uint32_t, 3>;
+
+    // UV sphere with (rings + 1) * (rings + 1) vertices and 2 * rings * rings triangles.
+    MeshData MakeSphere(uint32_t rings)
+    {
+        const float pi = 3.14159265f;
+
+        std::vector<float> positions;
+        for (uint32_t i = 0; i <= rings; ++i)
+        {
+            for (uint32_t j = 0; j <= rings; ++j)
+            {
+                float theta = pi * i / rings;
+                float phi = 2.0f * pi * j / rings;
+                positions.insert(positions.end(), { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+            }
+        }
+
+        MeshData mesh;
+        mesh.VertexStride = sizeof(float) * 3;
+        mesh.Attributes.push_back({ MeshAttributeSemantic::Position, MeshFormatR32G32B32Float, 0 });
+        mesh.Vertices.resize(positions.size() * sizeof(float));
+        memcpy(mesh.Vertices.data(), positions.data(), mesh.Vertices.size());
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < rings; ++j)
+            {
+                uint32_t a = i * (rings + 1) + j;
+                uint32_t c = a + rings + 1;
+                mesh.Indices.insert(mesh.Indices.end(), { a, a + 1, c, a + 1, c + 1, c });
+            }
+        }
+        return mesh;
+    }
+
+    const float* GetPosition(const MeshData& mesh, uint32_t vertex)
+    {
+        return reinterpret_cast<const float*>(mesh.Vertices.data() + size_t(vertex) * mesh.VertexStride);
+    }
+
+    std::vector<Triangle> GetMeshletTriangles(const MeshletMesh& meshlets, const Meshlet& meshlet)
+    {
+        std::vector<Triangle> triangles;
+        for (uint32_t p = 0; p < meshlet.PrimitiveCount; ++p)
+        {
+            uint32_t i0, i1, i2;
+            UnpackMeshletTriangle(meshlets.PrimitiveIndices[meshlet.PrimitiveOffset + p], i0, i1, i2);
+            CHECK(i0 < meshlet.VertexCount && i1 < meshlet.VertexCount && i2 < meshlet.VertexCount);
+            const uint32_t* pVertices = &meshlets.UniqueVertexIndices[meshlet.VertexOffset];
+            triangles.push_back({ pVertices[i0], pVertices[i1], pVertices[i2] });
+        }
+        return triangles;
+    }
+
+    // Every triangle of the mesh is in exactly one meshlet and no meshlet exceeds the limits.
+    void CheckCoverage(const MeshData& mesh, const MeshletMesh& meshlets, const MeshletBuildSettings& settings)
+    {
+        std::vector<Triangle> expected;
+        for (size_t i = 0; i < mesh.Indices.size(); i += 3)
+        {
+            expected.push_back({ mesh.Indices[i], mesh.Indices[i + 1], mesh.Indices[i + 2] });
+        }
+
+        std::vector<Triangle> actual;
+        for (const Meshlet& meshlet : meshlets.Meshlets)
+        {
+            CHECK(meshlet.VertexCount > 0 && meshlet.VertexCount <= settings.MaxVertices);
+            CHECK(meshlet.PrimitiveCount > 0 && meshlet.PrimitiveCount <= settings.MaxPrimitives);
+            std::vector<Triangle> triangles = GetMeshletTriangles(meshlets, meshlet);
+            actual.insert(actual.end(), triangles.begin(), triangles.end());
+        }
+
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        CHECK(expected == actual);
+    }
+
+    // The bounding sphere contains every vertex and the normal cone every triangle normal.
+    void CheckBounds(const MeshData& mesh, const MeshletMesh& meshlets)
+    {
+        const float epsilon = 1e-4f;
+        uint32_t numCones = 0;
+
+        for (size_t m = 0; m < meshlets.Meshlets.size(); ++m)
+        {
+            const Meshlet& meshlet = meshlets.Meshlets[m];
+            const MeshletBounds& bounds = meshlets.Bounds[m];
+
+            for (uint32_t v = 0; v < meshlet.VertexCount; ++v)
+            {
+                const float* p = GetPosition(mesh, meshlets.UniqueVertexIndices[meshlet.VertexOffset + v]);
+                float dx = p[0] - bounds.Center[0], dy = p[1] - bounds.Center[1], dz = p[2] - bounds.Center[2];
+                CHECK(std::sqrt(dx * dx + dy * dy + dz * dz) <= bounds.Radius + epsilon);
+            }
+
+            // A cutoff above 1 disables culling, there is no cone to check.
+            if (bounds.ConeCutoff > 1.0f)
+            {
+                continue;
+            }
+            ++numCones;
+
+            // The normals lie within acos(minDot) of the axis, see BuildMeshlets.
+            float minDot = std::sqrt(1.0f - bounds.ConeCutoff * bounds.ConeCutoff);
+            for (const Triangle& triangle : GetMeshletTriangles(meshlets, meshlet))
+            {
+                const float* p0 = GetPosition(mesh, triangle[0]);
+                const float* p1 = GetPosition(mesh, triangle[1]);
+                const float* p2 = GetPosition(mesh, triangle[2]);
+                float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+                float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+                float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+                float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                // Degenerate triangles (the poles of the sphere) have no normal.
+                if (length < 1e-12f)
+                {
+                    continue;
+                }
+
+                float dot = (n[0] * bounds.ConeAxis[0] + n[1] * bounds.ConeAxis[1] + n[2] * bounds.ConeAxis[2]) / length;
+                CHECK(dot >= minDot - epsilon);
+            }
+        }
+
+        // Meshlets of a fine sphere are nearly flat, they must get cones or the check above tests nothing.
+        CHECK(numCones > 0);
+    }
+}
+
+TEST_CASE(MeshletCoverageAndBounds)
+{
+    MeshData mesh = MakeSphere(64);
+    OptimizeMesh(mesh);
+
+    MeshletBuildSettings settingsList[3];
+    settingsList[1].MaxVertices = 32;
+    settingsList[1].MaxPrimitives = 40;
+    settingsList[2].MaxVertices = MaxMeshletVertices;
+    settingsList[2].MaxPrimitives = MaxMeshletPrimitives;
+
+    for (const MeshletBuildSettings& settings : settingsList)
+    {
+        MeshletMesh meshlets;
+        CHECK(BuildMeshlets(mesh, settings, meshlets));
+        CHECK_EQUAL(meshlets.Meshlets.size(), meshlets.Bounds.size());
+        CHECK_EQUAL(1u, meshlets.Subsets.size());
+        CheckCoverage(mesh, meshlets, settings);
+        CheckBounds(mesh, meshlets);
+    }
+}
+
+TEST_CASE(MeshletSubsetsPerSubmesh)
+{
+    MeshData mesh = MakeSphere(32);
+    // Split the index buffer into two submeshes at a triangle boundary.
+    uint32_t split = static_cast<uint32_t>(mesh.Indices.size() / 6 * 3);
+    MeshFileSubmesh submesh = {};
+    submesh.IndexCount = split;
+    mesh.Submeshes.push_back(submesh);
+    submesh.IndexStart = split;
+    submesh.IndexCount = static_cast<uint32_t>(mesh.Indices.size()) - split;
+    mesh.Submeshes.push_back(submesh);
+
+    MeshletBuildSettings settings;
+    MeshletMesh meshlets;
+    CHECK(BuildMeshlets(mesh, settings, meshlets));
+    CHECK_EQUAL(2u, meshlets.Subsets.size());
+    CHECK_EQUAL(meshlets.Subsets[0].MeshletCount, meshlets.Subsets[1].MeshletOffset);
+    CHECK_EQUAL(meshlets.Meshlets.size(), size_t(meshlets.Subsets[1].MeshletOffset + meshlets.Subsets[1].MeshletCount));
+    CheckCoverage(mesh, meshlets, settings);
+}
+
+// Meshlets of eight spheres with 180K to 250K triangles each, one mesh after
+// the other and one task per mesh on the thread pool.
+BENCHMARK(MeshletBuildLargeMeshes)
+{
+    std::vector<MeshData> meshes;
+    std::vector<const MeshData*> meshPointers;
+    size_t numTriangles = 0;
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        meshes.push_back(MakeSphere(300 + i * 10));
+        OptimizeMesh(meshes.back());
+        numTriangles += meshes.back().Indices.size() / 3;
+    }
+    for (const MeshData& mesh : meshes)
+    {
+        meshPointers.push_back(&mesh);
+    }
+
+    MeshletBuildSettings settings;
+    ThreadPool threadPool;
+    for (int parallel = 0; parallel < 2; ++parallel)
+    {
+        std::vector<MeshletMesh> meshlets(meshes.size());
+        Test::Timer timer;
+        CHECK(BuildMeshlets(meshPointers.data(), meshPointers.size(), settings, meshlets.data(), parallel ? &threadPool : nullptr));
+        double seconds = timer.GetElapsedSeconds();
+
+        Test::Report(std::string("BuildMeshlets") + (parallel ? " (threads)" : ""), numTriangles / seconds * 1e-6, "Mtriangles/s");
+    }
+}
@@ -0,0 +1,278 @@
+#include <MipGenerator.h>
+
+#include <TestFramework.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const MipFilter Filters[] = { MipFilter::Box, MipFilter::Kaiser, MipFilter::Lanczos };
+
+    // Linear RGBA of a texel of an uncompressed texture, sRGB colors decoded.
+    void ReadTexel(const TextureData& texture, uint32_t mip, uint32_t slice, uint32_t x, uint32_t y, float* pColor)
+    {
+        const TextureSubresource& subresource = texture.GetSubresource(mip, slice);
+        const uint8_t* pTexel = texture.GetPixels(mip, slice) + size_t(y) * subresource.RowPitch + size_t(x) * GetBytesPerPixel(texture.Format);
+        for (int c = 0; c < 4; ++c)
+        {
+            switch (texture.Format)
+            {
+            case TextureFormat::RGBA32Float:
+                memcpy(&pColor[c], pTexel + c * 4, sizeof(float));
+                break;
+            case TextureFormat::RGBA16Float:
+            {
+                uint16_t half;
+                memcpy(&half, pTexel + c * 2, sizeof(half));
+                pColor[c] = HalfToFloat(half);
+                break;
+            }
+            default:
+                pColor[c] = IsSRGB(texture.Format) && c < 3 ? SRGBToLinear(pTexel[c] / 255.0f) : pTexel[c] / 255.0f;
+                break;
+            }
+        }
+    }
+
+    void WriteTexel(TextureData& texture, uint32_t slice, uint32_t x, uint32_t y, const float* pColor)
+    {
+        const TextureSubresource& subresource = texture.GetSubresource(0, slice);
+        uint8_t* pTexel = texture.GetPixels(0, slice) + size_t(y) * subresource.RowPitch + size_t(x) * GetBytesPerPixel(texture.Format);
+        for (int c = 0; c < 4; ++c)
+        {
+            switch (texture.Format)
+            {
+            case TextureFormat::RGBA32Float:
+                memcpy(pTexel + c * 4, &pColor[c], sizeof(float));
+                break;
+            case TextureFormat::RGBA16Float:
+            {
+                uint16_t half = FloatToHalf(pColor[c]);
+                memcpy(pTexel + c * 2, &half, sizeof(half));
+                break;
+            }
+            default:
+                pTexel[c] = static_cast<uint8_t>(std::lround(pColor[c] * 255.0f));
+                break;
+            }
+        }
+    }
+
+    // Mip 0 of every slice filled with the same texel bytes.
+    void FillSlice(TextureData& texture, uint32_t slice, const uint8_t* pTexel)
+    {
+        const TextureSubresource& subresource = texture.GetSubresource(0, slice);
+        const uint32_t bytesPerPixel = GetBytesPerPixel(texture.Format);
+        for (size_t offset = 0; offset < subresource.SlicePitch; offset += bytesPerPixel)
+        {
+            memcpy(texture.GetPixels(0, slice) + offset, pTexel, bytesPerPixel);
+        }
+    }
+
+    // Do all texels of every mip of the slice have the color of the first texel? Exact for the 8 bit formats.
+    bool IsSliceConstant(const TextureData& texture, uint32_t slice, float tolerance = 0.0f)
+    {
+        float expected[4];
+        ReadTexel(texture, 0, slice, 0, 0, expected);
+        for (uint32_t mip = 0; mip < texture.MipLevels; ++mip)
+        {
+            const TextureSubresource& subresource = texture.GetSubresource(mip, slice);
+            for (uint32_t y = 0; y < subresource.Height; ++y)
+            {
+                for (uint32_t x = 0; x < subresource.Width; ++x)
+                {
+                    float color[4];
+                    ReadTexel(texture, mip, slice, x, y, color);
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        if (std::abs(color[c] - expected[c]) > tolerance)
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(GenerateMipsKeepsConstantTextures)
+{
+    const float color[4] = { 0.25f, 0.5f, 0.75f, 0.6f };
+    const TextureFormat formats[] = {
+        TextureFormat::RGBA8UNorm, TextureFormat::RGBA8UNormSRGB, TextureFormat::RGBA16Float, TextureFormat::RGBA32Float
+    };
+
+    for (TextureFormat format : formats)
+    {
+        for (MipFilter filter : Filters)
+        {
+            for (bool wrap : { false, true })
+            {
+                TextureData texture;
+                texture.Initialize(format, 64, 32, 1, 0);
+                WriteTexel(texture, 0, 0, 0, color);
+                uint8_t texel[16];
+                memcpy(texel, texture.GetPixels(0), GetBytesPerPixel(format));
+                FillSlice(texture, 0, texel);
+
+                MipGenerationSettings settings;
+                settings.Filter = filter;
+                settings.Wrap = wrap;
+                GenerateMips(texture, settings);
+
+                // The filter weights are normalized, even Lanczos with its negative lobes gives back the same color.
+                // Only the float format can be off by the rounding of the weights.
+                CHECK(IsSliceConstant(texture, 0, format == TextureFormat::RGBA32Float ? 1e-6f : 0.0f));
+            }
+        }
+    }
+}
+
+TEST_CASE(GenerateMipsRoundTripsSRGB)
+{
+    // Every 8 bit sRGB value survives the decode to linear and the encode of the mips.
+    TextureData texture;
+    texture.Initialize(TextureFormat::RGBA8UNormSRGB, 4, 4, 256, 0);
+    for (uint32_t value = 0; value < 256; ++value)
+    {
+        const uint8_t texel[4] = { uint8_t(value), uint8_t(255 - value), uint8_t(value), uint8_t(value) };
+        FillSlice(texture, value, texel);
+    }
+    GenerateMips(texture);
+    for (uint32_t value = 0; value < 256; ++value)
+    {
+        CHECK(IsSliceConstant(texture, value));
+    }
+
+    // Black and white average in linear space: 0.5 linear is 188 in sRGB. Alpha stays linear.
+    for (TextureFormat format : { TextureFormat::RGBA8UNorm, TextureFormat::RGBA8UNormSRGB })
+    {
+        TextureData pair;
+        pair.Initialize(format, 2, 1, 1, 0);
+        const uint8_t pixels[8] = { 0, 0, 0, 0, 255, 255, 255, 255 };
+        memcpy(pair.GetPixels(0), pixels, sizeof(pixels));
+        MipGenerationSettings settings;
+        settings.Filter = MipFilter::Box;
+        GenerateMips(pair, settings);
+        const uint8_t* pMip = pair.GetPixels(1);
+        CHECK_EQUAL(format == TextureFormat::RGBA8UNormSRGB ? 188 : 128, int(pMip[0]));
+        CHECK_EQUAL(128, int(pMip[3]));
+    }
+}
+
+TEST_CASE(GenerateMipsBuildsChainDimensions)
+{
+    struct Size
+    {
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t MipLevels;
+    };
+    const Size sizes[] = { { 1, 1, 1 }, { 256, 256, 9 }, { 256, 1, 9 }, { 13, 7, 4 }, { 5, 300, 9 } };
+
+    for (const Size& size : sizes)
+    {
+        TextureData texture;
+        texture.Initialize(TextureFormat::RGBA8UNorm, size.Width, size.Height, 2, 0);
+        CHECK_EQUAL(size.MipLevels, texture.MipLevels);
+        CHECK_EQUAL(size_t(size.MipLevels * 2), texture.Subresources.size());
+
+        for (uint32_t slice = 0; slice < 2; ++slice)
+        {
+            for (uint32_t mip = 0; mip < texture.MipLevels; ++mip)
+            {
+                const TextureSubresource& subresource = texture.GetSubresource(mip, slice);
+                const uint32_t mipWidth = std::max(size.Width >> mip, 1u);
+                const uint32_t mipHeight = std::max(size.Height >> mip, 1u);
+                CHECK_EQUAL(mipWidth, subresource.Width);
+                CHECK_EQUAL(mipHeight, subresource.Height);
+            }
+            // The chain ends at 1x1.
+            CHECK_EQUAL(1u, texture.GetSubresource(texture.MipLevels - 1, slice).Width);
+            CHECK_EQUAL(1u, texture.GetSubresource(texture.MipLevels - 1, slice).Height);
+        }
+
+        // Every size down to 1x1 can be filtered, the 1x1 texture has nothing to generate.
+        GenerateMips(texture);
+    }
+
+    // A partial chain only fills the mips it has.
+    TextureData partial;
+    partial.Initialize(TextureFormat::RGBA32Float, 64, 64, 1, 3);
+    CHECK_EQUAL(3u, partial.MipLevels);
+    const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    uint8_t texel[16];
+    memcpy(texel, white, sizeof(texel));
+    FillSlice(partial, 0, texel);
+    GenerateMips(partial);
+    CHECK(IsSliceConstant(partial, 0, 1e-6f));
+}
+
+TEST_CASE(GenerateMipsHandlesNonPowerOfTwoArrays)
+{
+    // 37x7 with three slices: every slice a horizontal ramp of its own, in float so nothing is quantized.
+    const uint32_t width = 37;
+    const uint32_t height = 7;
+    const uint32_t arraySize = 3;
+
+    for (MipFilter filter : Filters)
+    {
+        TextureData texture;
+        texture.Initialize(TextureFormat::RGBA32Float, width, height, arraySize, 0);
+        for (uint32_t slice = 0; slice < arraySize; ++slice)
+        {
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    const float color[4] = { x + 0.5f, float(slice), 1.0f, 1.0f };
+                    WriteTexel(texture, slice, x, y, color);
+                }
+            }
+        }
+
+        ThreadPool threadPool;
+        MipGenerationSettings settings;
+        settings.Filter = filter;
+        GenerateMips(texture, settings, &threadPool);
+
+        for (uint32_t slice = 0; slice < arraySize; ++slice)
+        {
+            for (uint32_t mip = 1; mip < texture.MipLevels; ++mip)
+            {
+                const TextureSubresource& subresource = texture.GetSubresource(mip, slice);
+                const float scale = float(width) / float(subresource.Width);
+                const float support = filter == MipFilter::Box ? 0.5f * scale : 3.0f * scale;
+                // The box takes whole texels, which is off by up to half a texel when the reduction is not 2:1.
+                const float tolerance = filter == MipFilter::Box ? 0.5f : 0.01f;
+                for (uint32_t y = 0; y < subresource.Height; ++y)
+                {
+                    for (uint32_t x = 0; x < subresource.Width; ++x)
+                    {
+                        float color[4];
+                        ReadTexel(texture, mip, slice, x, y, color);
+                        // No bleeding between slices, and the constant channels stay constant.
+                        CHECK_NEAR(float(slice), color[1], 1e-5f);
+                        CHECK_NEAR(1.0f, color[2], 1e-5f);
+                        CHECK_NEAR(1.0f, color[3], 1e-5f);
+
+                        // Symmetric normalized filters reproduce a ramp where they do not reach past the edge:
+                        // the texel gets about the source coordinate of its center.
+                        const float center = (x + 0.5f) * scale;
+                        if (center - support >= 0.0f && center + support <= float(width))
+                        {
+                            CHECK_NEAR(center, color[0], tolerance);
+                        }
+                        CHECK(color[0] >= 0.0f && color[0] <= float(width));
+                    }
+                }
+            }
+        }
+    }
+}
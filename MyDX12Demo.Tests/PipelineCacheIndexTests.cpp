@@ -0,0 +1,176 @@
+#include <PipelineCacheIndex.h>
+
+#include <TestFramework.h>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const uint64_t DeviceKey = 0x1234567890abcdefULL;
+
+    // Stands in for the blob of ID3D12PipelineLibrary::Serialize.
+    std::vector<uint8_t> MakeLibrary(size_t size)
+    {
+        std::vector<uint8_t> library(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            library[i] = static_cast<uint8_t>(i * 31 + 7);
+        }
+        return library;
+    }
+
+    std::vector<uint8_t> MakeFile(const std::vector<uint64_t>& keys, const std::vector<uint8_t>& library)
+    {
+        PipelineCacheIndex index(DeviceKey);
+        for (uint64_t key : keys)
+        {
+            index.Insert(key);
+        }
+        return index.Serialize(library.data(), library.size());
+    }
+}
+
+TEST_CASE(PipelineCacheIndexRoundTrips)
+{
+    const std::vector<uint64_t> keys = { 42, 7, 0xffffffffffffffffULL, 1000 };
+    const std::vector<uint8_t> library = MakeLibrary(333);
+
+    PipelineCacheIndex index(DeviceKey);
+    CHECK(!index.IsDirty());
+    for (uint64_t key : keys)
+    {
+        index.Insert(key);
+    }
+    index.Insert(42);
+    CHECK(index.IsDirty());
+    CHECK_EQUAL(4u, index.GetNumKeys());
+    std::vector<uint8_t> file = index.Serialize(library.data(), library.size());
+    CHECK(!index.IsDirty());
+
+    // The keys are sorted, so the same pipelines always give the same file.
+    CHECK(file == MakeFile({ 1000, 0xffffffffffffffffULL, 7, 42 }, library));
+
+    PipelineCacheFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    CHECK_EQUAL(uint64_t(file.size()), header.FileSize);
+    CHECK_EQUAL(uint64_t(0), header.LibraryOffset % PipelineCacheFileAlignment);
+
+    PipelineCacheIndex loaded(DeviceKey);
+    CHECK(loaded.Load(file.data(), file.size()));
+    CHECK(!loaded.IsDirty());
+    CHECK_EQUAL(4u, loaded.GetNumKeys());
+    for (uint64_t key : keys)
+    {
+        CHECK(loaded.Contains(key));
+    }
+    CHECK(!loaded.Contains(8));
+    CHECK_EQUAL(library.size(), loaded.GetLibrarySize());
+    CHECK(std::memcmp(loaded.GetLibraryData(), library.data(), library.size()) == 0);
+    // The library blob is used in place.
+    CHECK(loaded.GetLibraryData() == file.data() + header.LibraryOffset);
+
+    // A new pipeline makes the index dirty, serializing it again keeps the loaded keys.
+    loaded.Insert(8);
+    CHECK(loaded.IsDirty());
+    std::vector<uint8_t> updated = loaded.Serialize(loaded.GetLibraryData(), loaded.GetLibrarySize());
+    PipelineCacheIndex reloaded(DeviceKey);
+    CHECK(reloaded.Load(updated.data(), updated.size()));
+    CHECK_EQUAL(5u, reloaded.GetNumKeys());
+
+    // The file is read into a buffer of any alignment.
+    std::vector<uint8_t> unaligned(file.size() + 1);
+    std::memcpy(unaligned.data() + 1, file.data(), file.size());
+    CHECK(loaded.Load(unaligned.data() + 1, file.size()));
+    CHECK(loaded.Contains(42));
+
+    // An empty index is a valid file too.
+    std::vector<uint8_t> empty = MakeFile({}, library);
+    CHECK(loaded.Load(empty.data(), empty.size()));
+    CHECK_EQUAL(0u, loaded.GetNumKeys());
+
+    CHECK(PipelineCacheIndex::GetPipelineName(0xabcULL) == L"PSO_0000000000000abc");
+}
+
+TEST_CASE(PipelineCacheIndexRejectsOtherDevices)
+{
+    std::vector<uint8_t> file = MakeFile({ 1, 2, 3 }, MakeLibrary(100));
+
+    // Another adapter or driver can not use the library, the cache starts empty.
+    PipelineCacheIndex other(DeviceKey + 1);
+    CHECK(!other.Load(file.data(), file.size()));
+    CHECK_EQUAL(0u, other.GetNumKeys());
+    CHECK(other.GetLibraryData() == nullptr);
+    CHECK_EQUAL(size_t(0), other.GetLibrarySize());
+
+    // A failed load also drops what was loaded before.
+    PipelineCacheIndex index(DeviceKey);
+    CHECK(index.Load(file.data(), file.size()));
+    std::vector<uint8_t> otherFile = file;
+    PipelineCacheFileHeader header;
+    std::memcpy(&header, otherFile.data(), sizeof(header));
+    header.DeviceKey = DeviceKey + 1;
+    std::memcpy(otherFile.data(), &header, sizeof(header));
+    CHECK(!index.Load(otherFile.data(), otherFile.size()));
+    CHECK_EQUAL(0u, index.GetNumKeys());
+    CHECK(!index.Contains(1));
+
+    // Files of another version of the format.
+    std::memcpy(&header, file.data(), sizeof(header));
+    header.Version = PipelineCacheFileVersion + 1;
+    std::memcpy(otherFile.data(), &header, sizeof(header));
+    CHECK(!index.Load(otherFile.data(), otherFile.size()));
+}
+
+TEST_CASE(PipelineCacheIndexRejectsCorruptedFiles)
+{
+    const std::vector<uint8_t> file = MakeFile({ 1, 2, 3 }, MakeLibrary(100));
+    PipelineCacheIndex index(DeviceKey);
+
+    // Every single bit flip is detected: the header fields are checked, the keys and the library hashed.
+    // Only the padding between the keys and the library and the reserved field are not used.
+    PipelineCacheFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    const size_t keysEnd = static_cast<size_t>(header.KeyOffset + header.NumKeys * sizeof(uint64_t));
+    size_t numRejected = 0;
+    for (size_t offset = 0; offset < file.size(); ++offset)
+    {
+        const size_t reservedOffset = offsetof(PipelineCacheFileHeader, Reserved);
+        const bool isUnused = (offset >= reservedOffset && offset < reservedOffset + sizeof(uint32_t)) ||
+            (offset >= keysEnd && offset < header.LibraryOffset);
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            std::vector<uint8_t> corrupted = file;
+            corrupted[offset] ^= uint8_t(1 << bit);
+            const bool loaded = index.Load(corrupted.data(), corrupted.size());
+            CHECK_EQUAL(isUnused, loaded);
+            numRejected += loaded ? 0 : 1;
+        }
+    }
+    CHECK(numRejected > 0);
+
+    // Every truncation, and data appended to the file.
+    for (size_t size = 0; size < file.size(); ++size)
+    {
+        CHECK(!index.Load(file.data(), size));
+    }
+    std::vector<uint8_t> extended = file;
+    extended.push_back(0);
+    CHECK(!index.Load(extended.data(), extended.size()));
+    CHECK(!index.Load(nullptr, file.size()));
+
+    // Offsets that point outside of the file or make the keys overlap the library.
+    std::vector<uint8_t> overlapping = file;
+    header.LibraryOffset = header.KeyOffset;
+    header.LibrarySize = file.size() - header.LibraryOffset;
+    std::memcpy(overlapping.data(), &header, sizeof(header));
+    CHECK(!index.Load(overlapping.data(), overlapping.size()));
+    std::memcpy(&header, file.data(), sizeof(header));
+    header.NumKeys = 0x10000000;
+    std::memcpy(overlapping.data(), &header, sizeof(header));
+    CHECK(!index.Load(overlapping.data(), overlapping.size()));
+
+    // The original still loads.
+    CHECK(index.Load(file.data(), file.size()));
+}
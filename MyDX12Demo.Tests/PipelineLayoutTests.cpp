@@ -0,0 +1,151 @@
+#include <PipelineLayout.h>
+
+#include <TestFramework.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Most of PipelineLayout is checked at compile time, so are its tests: this file only compiles if they pass.
+
+namespace
+{
+    struct TestVertex
+    {
+        float Position[3];
+        uint32_t Color;
+        float TexCoord[2];
+    };
+
+    struct Matrix
+    {
+        float m[16];
+    };
+
+    struct AlmostFullConstants
+    {
+        uint32_t Values[61];
+    };
+
+    static constexpr D3D12_DESCRIPTOR_RANGE1 TextureRanges[] = {
+        { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_NONE, 0 },
+        { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 2, 1, D3D12_DESCRIPTOR_RANGE_FLAG_NONE, 2 },
+    };
+
+    // Formats that do not match their member, attributes that overlap or lie outside of the vertex.
+    static constexpr VertexAttribute WrongFormat[] = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12 },
+    };
+    static constexpr VertexAttribute Overlapping[] = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12 },
+        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 8, 4 },
+    };
+    static constexpr VertexAttribute Adjacent[] = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12 },
+        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 12, 4 },
+    };
+}
+
+template<>
+struct VertexLayout<TestVertex>
+{
+    static constexpr VertexAttribute Attributes[] = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, offsetof(TestVertex, Position), sizeof(TestVertex::Position) },
+        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, offsetof(TestVertex, Color), sizeof(TestVertex::Color) },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, offsetof(TestVertex, TexCoord), sizeof(TestVertex::TexCoord) },
+    };
+};
+
+namespace
+{
+    using TestInputLayout = InputLayout<TestVertex>;
+
+    // 输入布局: one element per member at its offset, the vertex stride is the size of the struct.
+    static_assert(sizeof(TestVertex) == 24, "The vertex buffer stride of TestVertex.");
+    static_assert(TestInputLayout::NumElements == 3, "");
+    static_assert(TestInputLayout::Elements[0].AlignedByteOffset == 0, "");
+    static_assert(TestInputLayout::Elements[1].AlignedByteOffset == 12, "");
+    static_assert(TestInputLayout::Elements[2].AlignedByteOffset == 16, "");
+    static_assert(TestInputLayout::Elements[2].AlignedByteOffset + GetVertexFormatSize(TestInputLayout::Elements[2].Format) ==
+        sizeof(TestVertex), "The last attribute ends at the stride.");
+    static_assert(TestInputLayout::Elements[1].Format == DXGI_FORMAT_R8G8B8A8_UNORM, "");
+    static_assert(TestInputLayout::Elements[2].SemanticName == VertexLayout<TestVertex>::Attributes[2].SemanticName, "");
+    static_assert(TestInputLayout::Elements[1].InputSlot == 0 &&
+        TestInputLayout::Elements[1].InputSlotClass == D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA &&
+        TestInputLayout::Elements[1].InstanceDataStepRate == 0, "");
+    static_assert(TestInputLayout::Desc.pInputElementDescs == TestInputLayout::Elements.data(), "");
+    static_assert(TestInputLayout::Desc.NumElements == 3, "");
+
+    // The checks that InputLayout asserts.
+    static_assert(!HasMatchingFormats(WrongFormat), "");
+    static_assert(HasMatchingFormats(Overlapping), "");
+    static_assert(!HasDisjointAttributes(Overlapping, 16), "");
+    static_assert(HasDisjointAttributes(Adjacent, 16), "");
+    static_assert(!HasDisjointAttributes(Adjacent, 15), "The color lies partly outside of the vertex.");
+    static_assert(GetVertexFormatSize(DXGI_FORMAT_R16G16B16A16_SNORM) == 8, "");
+    static_assert(GetVertexFormatSize(DXGI_FORMAT_R11G11B10_FLOAT) == 4, "");
+    static_assert(GetVertexFormatSize(DXGI_FORMAT_D32_FLOAT) == 0, "Not a vertex format.");
+
+    // 根签名 cost in DWORDs: the constants, 2 per root descriptor and 1 per descriptor table.
+    using TestRootSignature = RootSignatureLayout<D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT,
+        RootConstants<Matrix, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX>,
+        RootCBV<1>,
+        RootSRV<0, 1>,
+        RootUAV<0>,
+        RootDescriptorTable<TextureRanges>>;
+
+    static_assert(RootConstants<Matrix, 0>::Cost == 16, "");
+    static_assert(RootCBV<0>::Cost == 2 && RootSRV<0>::Cost == 2 && RootUAV<0>::Cost == 2, "");
+    static_assert(RootDescriptorTable<TextureRanges>::Cost == 1, "");
+    static_assert(TestRootSignature::NumParameters == 5, "");
+    static_assert(TestRootSignature::Cost == 16 + 3 * 2 + 1, "");
+    static_assert(std::is_same<TestRootSignature::Parameter<0>::Type, Matrix>::value, "");
+    static_assert(std::is_same<TestRootSignature::Parameter<4>, RootDescriptorTable<TextureRanges>>::value, "");
+
+    // Exactly at the limit still compiles, and a root signature without parameters costs nothing.
+    using FullRootSignature = RootSignatureLayout<D3D12_ROOT_SIGNATURE_FLAG_NONE, RootConstants<AlmostFullConstants, 0>, RootCBV<1>, RootDescriptorTable<TextureRanges>>;
+    static_assert(FullRootSignature::Cost == MaxRootSignatureCost, "");
+    static_assert(RootSignatureLayout<D3D12_ROOT_SIGNATURE_FLAG_NONE>::Cost == 0, "");
+
+    // 管线状态流 built in a constant expression.
+    static constexpr GraphicsPipelineStream TestPipelineStream = GraphicsPipelineStream()
+        .WithInputLayout<TestVertex>()
+        .WithRenderTargetFormat(1, DXGI_FORMAT_R8G8B8A8_UNORM)
+        .WithRenderTargetFormat(0, DXGI_FORMAT_R16G16B16A16_FLOAT)
+        .WithDepthStencilFormat(DXGI_FORMAT_D32_FLOAT);
+
+    static_assert(TestPipelineStream.InputLayout.Value.pInputElementDescs == TestInputLayout::Elements.data(), "");
+    static_assert(TestPipelineStream.RTVFormats.Value.NumRenderTargets == 2, "Setting render target 0 keeps render target 1.");
+    static_assert(TestPipelineStream.RTVFormats.Value.RTFormats[0] == DXGI_FORMAT_R16G16B16A16_FLOAT, "");
+    static_assert(TestPipelineStream.DSVFormat.Value == DXGI_FORMAT_D32_FLOAT, "");
+    static_assert(TestPipelineStream.RasterizerState.Value.CullMode == D3D12_CULL_MODE_BACK, "");
+    static_assert(TestPipelineStream.InputLayout.Type == D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT, "");
+    static_assert(offsetof(GraphicsPipelineStream, InputLayout) % alignof(void*) == 0, "Subobjects are pointer aligned.");
+}
+
+TEST_CASE(PipelineLayoutBuildsRootSignatureDesc)
+{
+    // The description of the root parameters is only built at run time.
+    const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc = TestRootSignature::GetDesc();
+    CHECK(&desc == &TestRootSignature::GetDesc());
+    CHECK(desc.Version == D3D_ROOT_SIGNATURE_VERSION_1_1);
+    CHECK(desc.Desc_1_1.Flags == D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+    CHECK_EQUAL(5u, desc.Desc_1_1.NumParameters);
+
+    const D3D12_ROOT_PARAMETER1* pParameters = desc.Desc_1_1.pParameters;
+    CHECK(pParameters[0].ParameterType == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS);
+    CHECK_EQUAL(16u, pParameters[0].Constants.Num32BitValues);
+    CHECK(pParameters[0].ShaderVisibility == D3D12_SHADER_VISIBILITY_VERTEX);
+    CHECK(pParameters[1].ParameterType == D3D12_ROOT_PARAMETER_TYPE_CBV);
+    CHECK_EQUAL(1u, pParameters[1].Descriptor.ShaderRegister);
+    CHECK(pParameters[2].ParameterType == D3D12_ROOT_PARAMETER_TYPE_SRV);
+    CHECK_EQUAL(1u, pParameters[2].Descriptor.RegisterSpace);
+    CHECK(pParameters[3].ParameterType == D3D12_ROOT_PARAMETER_TYPE_UAV);
+    CHECK(pParameters[4].ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE);
+    CHECK_EQUAL(2u, pParameters[4].DescriptorTable.NumDescriptorRanges);
+    CHECK(pParameters[4].DescriptorTable.pDescriptorRanges == TextureRanges);
+
+    const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& empty = RootSignatureLayout<D3D12_ROOT_SIGNATURE_FLAG_NONE>::GetDesc();
+    CHECK_EQUAL(0u, empty.Desc_1_1.NumParameters);
+    CHECK(empty.Desc_1_1.pParameters == nullptr);
+}
@@ -0,0 +1,168 @@
+#include <PipelineStateHasher.h>
+
+#include <TestFramework.h>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // Subobject types as in D3D12_PIPELINE_STATE_SUBOBJECT_TYPE.
+    const uint32_t RootSignatureType = 0;
+    const uint32_t VertexShaderType = 1;
+    const uint32_t PixelShaderType = 2;
+    const uint32_t RasterizerType = 11;
+    const uint32_t InputLayoutType = 13;
+
+    // A DXBC/DXIL container: magic, digest and a body. A zero digest is an unsigned container.
+    std::vector<uint8_t> MakeShader(uint8_t digest, uint8_t body, size_t bodySize = 64)
+    {
+        std::vector<uint8_t> bytecode(4 + 16 + bodySize, body);
+        const uint32_t magic = 0x43425844;
+        std::memcpy(bytecode.data(), &magic, sizeof(magic));
+        std::memset(bytecode.data() + 4, digest, 16);
+        return bytecode;
+    }
+
+    struct Rasterizer
+    {
+        uint32_t FillMode;
+        uint32_t CullMode;
+    };
+
+    void AddRasterizer(PipelineStateHasher& hasher, const Rasterizer& rasterizer)
+    {
+        hasher.BeginSubobject(RasterizerType);
+        hasher.AddValue(rasterizer.FillMode);
+        hasher.AddValue(rasterizer.CullMode);
+    }
+
+    void AddShader(PipelineStateHasher& hasher, uint32_t type, const std::vector<uint8_t>& bytecode)
+    {
+        hasher.BeginSubobject(type);
+        hasher.AddShader(bytecode.data(), bytecode.size());
+    }
+
+    void AddInputLayout(PipelineStateHasher& hasher, const char* pSemanticName)
+    {
+        hasher.BeginSubobject(InputLayoutType);
+        hasher.AddValue(1u);
+        hasher.AddString(pSemanticName);
+    }
+}
+
+TEST_CASE(PipelineStateHasherIgnoresSubobjectOrder)
+{
+    const std::vector<uint8_t> vertexShader = MakeShader(1, 0xaa);
+    const std::vector<uint8_t> pixelShader = MakeShader(2, 0xbb);
+    const uint8_t rootSignature[] = { 1, 2, 3, 4, 5 };
+    const Rasterizer rasterizer = { 3, 1 };
+
+    PipelineStateHasher hasher;
+    hasher.BeginSubobject(RootSignatureType);
+    hasher.AddBytes(rootSignature, sizeof(rootSignature));
+    AddShader(hasher, VertexShaderType, vertexShader);
+    AddShader(hasher, PixelShaderType, pixelShader);
+    AddInputLayout(hasher, "POSITION");
+    AddRasterizer(hasher, rasterizer);
+    const uint64_t key = hasher.GetKey();
+    CHECK(key != 0);
+
+    // The same stream in another order.
+    hasher.Reset();
+    AddRasterizer(hasher, rasterizer);
+    AddInputLayout(hasher, "POSITION");
+    AddShader(hasher, PixelShaderType, pixelShader);
+    hasher.BeginSubobject(RootSignatureType);
+    hasher.AddBytes(rootSignature, sizeof(rootSignature));
+    AddShader(hasher, VertexShaderType, vertexShader);
+    CHECK_EQUAL(key, hasher.GetKey());
+
+    // A subobject given twice replaces the first one, like in D3D12.
+    hasher.Reset();
+    AddRasterizer(hasher, { 2, 2 });
+    AddInputLayout(hasher, "POSITION");
+    AddShader(hasher, PixelShaderType, pixelShader);
+    hasher.BeginSubobject(RootSignatureType);
+    hasher.AddBytes(rootSignature, sizeof(rootSignature));
+    AddShader(hasher, VertexShaderType, vertexShader);
+    AddRasterizer(hasher, rasterizer);
+    CHECK_EQUAL(key, hasher.GetKey());
+
+    // Every part of the description counts.
+    hasher.Reset();
+    hasher.BeginSubobject(RootSignatureType);
+    hasher.AddBytes(rootSignature, sizeof(rootSignature));
+    AddShader(hasher, VertexShaderType, vertexShader);
+    AddShader(hasher, PixelShaderType, pixelShader);
+    AddInputLayout(hasher, "NORMAL");
+    AddRasterizer(hasher, rasterizer);
+    CHECK(hasher.GetKey() != key);
+
+    // A subobject that is left out is not the same as an empty one.
+    hasher.Reset();
+    AddShader(hasher, VertexShaderType, vertexShader);
+    const uint64_t withoutPixelShader = hasher.GetKey();
+    hasher.BeginSubobject(PixelShaderType);
+    CHECK(hasher.GetKey() != withoutPixelShader);
+
+    // The same values in different subobjects.
+    hasher.Reset();
+    AddShader(hasher, VertexShaderType, vertexShader);
+    AddShader(hasher, PixelShaderType, pixelShader);
+    const uint64_t shaders = hasher.GetKey();
+    hasher.Reset();
+    AddShader(hasher, VertexShaderType, pixelShader);
+    AddShader(hasher, PixelShaderType, vertexShader);
+    CHECK(hasher.GetKey() != shaders);
+
+    // Strings are hashed by value, a null string is not the empty string.
+    hasher.Reset();
+    AddInputLayout(hasher, nullptr);
+    const uint64_t nullName = hasher.GetKey();
+    hasher.Reset();
+    AddInputLayout(hasher, "");
+    CHECK(hasher.GetKey() != nullName);
+    const char name[] = { 'P', 'O', 'S', 0 };
+    hasher.Reset();
+    AddInputLayout(hasher, "POS");
+    const uint64_t literalName = hasher.GetKey();
+    hasher.Reset();
+    AddInputLayout(hasher, name);
+    CHECK_EQUAL(literalName, hasher.GetKey());
+}
+
+TEST_CASE(PipelineStateHasherUsesShaderDigest)
+{
+    // Signed containers are keyed by their digest (and size), not by the rest of the bytecode.
+    const std::vector<uint8_t> signedShader = MakeShader(7, 0x11);
+    const std::vector<uint8_t> sameDigest = MakeShader(7, 0x22);
+    const std::vector<uint8_t> otherDigest = MakeShader(8, 0x11);
+    const std::vector<uint8_t> longer = MakeShader(7, 0x11, 80);
+    CHECK_EQUAL(HashShaderBytecode(signedShader.data(), signedShader.size()), HashShaderBytecode(sameDigest.data(), sameDigest.size()));
+    CHECK(HashShaderBytecode(signedShader.data(), signedShader.size()) != HashShaderBytecode(otherDigest.data(), otherDigest.size()));
+    CHECK(HashShaderBytecode(signedShader.data(), signedShader.size()) != HashShaderBytecode(longer.data(), longer.size()));
+
+    // Unsigned containers (all zero digest) and other data are hashed completely.
+    const std::vector<uint8_t> unsignedShader = MakeShader(0, 0x11);
+    const std::vector<uint8_t> unsignedOther = MakeShader(0, 0x22);
+    CHECK(HashShaderBytecode(unsignedShader.data(), unsignedShader.size()) != HashShaderBytecode(unsignedOther.data(), unsignedOther.size()));
+    std::vector<uint8_t> notContainer = MakeShader(7, 0x11);
+    notContainer[0] = 0;
+    std::vector<uint8_t> notContainerOther = MakeShader(7, 0x22);
+    notContainerOther[0] = 0;
+    CHECK(HashShaderBytecode(notContainer.data(), notContainer.size()) != HashShaderBytecode(notContainerOther.data(), notContainerOther.size()));
+
+    // Shorter than a container header, and no shader at all.
+    const uint8_t tiny[] = { 0x44, 0x58, 0x42, 0x43, 1 };
+    CHECK(HashShaderBytecode(tiny, sizeof(tiny)) != HashShaderBytecode(tiny, 4));
+    CHECK_EQUAL(HashShaderBytecode(nullptr, 0), HashShaderBytecode(tiny, 0));
+
+    // The digest is what the pipeline key uses.
+    PipelineStateHasher hasher;
+    AddShader(hasher, VertexShaderType, signedShader);
+    const uint64_t key = hasher.GetKey();
+    hasher.Reset();
+    AddShader(hasher, VertexShaderType, sameDigest);
+    CHECK_EQUAL(key, hasher.GetKey());
+}
@@ -0,0 +1,421 @@
+#include <RenderGraphCompiler.h>
+
+#include <TestFramework.h>
+
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    using Compiler = RenderGraphCompiler;
+    using Queue = RenderGraphCompiler::Queue;
+
+    // The D3D12_RESOURCE_STATES the tests use.
+    const uint32_t Present = 0x0;
+    const uint32_t RenderTarget = 0x4;
+    const uint32_t UnorderedAccess = 0x8;
+    const uint32_t DepthWrite = 0x10;
+    const uint32_t DepthRead = 0x20;
+    const uint32_t NonPixelShaderResource = 0x40;
+    const uint32_t PixelShaderResource = 0x80;
+    const uint32_t CopyDest = 0x400;
+    const uint32_t CopySource = 0x800;
+
+    const char* GetQueueName(Queue queue)
+    {
+        switch (queue)
+        {
+        case Queue::Compute:
+            return "compute";
+        case Queue::Copy:
+            return "copy";
+        default:
+            return "graphics";
+        }
+    }
+
+    void DumpBarriers(const std::vector<Compiler::Barrier>& barriers, std::string& text)
+    {
+        char buffer[64];
+        for (const Compiler::Barrier& barrier : barriers)
+        {
+            if (barrier.Type == Compiler::BarrierType::UnorderedAccess)
+            {
+                snprintf(buffer, sizeof(buffer), " [uav r%u]", barrier.Resource);
+            }
+            else
+            {
+                const char* split = barrier.Split == Compiler::BarrierSplit::Begin ? "begin " :
+                    barrier.Split == Compiler::BarrierSplit::End ? "end " : "";
+                snprintf(buffer, sizeof(buffer), " [%sr%u %x->%x]", split, barrier.Resource, barrier.StateBefore, barrier.StateAfter);
+            }
+            text += buffer;
+        }
+    }
+
+    void DumpWait(const Compiler::QueueWait& wait, std::string& text)
+    {
+        text += std::string(" wait(") + GetQueueName(wait.WaitQueue) + "@" +
+            (wait.Position == Compiler::InvalidIndex ? std::string("end") : std::to_string(wait.Position)) + ")";
+    }
+
+    /**
+     * One line per compiled pass: pass index, queue, signal, waits, the barriers
+     * before the pass and after it. Then the final waits and barriers of every queue.
+     */
+    std::string Dump(const Compiler& compiler)
+    {
+        std::string text;
+        for (const Compiler::CompiledPass& compiledPass : compiler.GetCompiledPasses())
+        {
+            text += "P" + std::to_string(compiledPass.Pass) + " " + GetQueueName(compiledPass.PassQueue);
+            if (compiledPass.Signal)
+            {
+                text += " signal";
+            }
+            for (const Compiler::QueueWait& wait : compiledPass.Waits)
+            {
+                DumpWait(wait, text);
+            }
+            DumpBarriers(compiledPass.Barriers, text);
+            if (!compiledPass.BarriersAfter.empty())
+            {
+                text += " after";
+                DumpBarriers(compiledPass.BarriersAfter, text);
+            }
+            text += "\n";
+        }
+
+        if (!compiler.GetFinalWaits().empty())
+        {
+            text += "final graphics";
+            for (const Compiler::QueueWait& wait : compiler.GetFinalWaits())
+            {
+                DumpWait(wait, text);
+            }
+            text += "\n";
+        }
+        for (uint32_t queue = 0; queue < Compiler::NumQueues; ++queue)
+        {
+            const std::vector<Compiler::Barrier>& barriers = compiler.GetFinalBarriers(static_cast<Queue>(queue));
+            if (!barriers.empty())
+            {
+                text += std::string("final ") + GetQueueName(static_cast<Queue>(queue));
+                DumpBarriers(barriers, text);
+                text += "\n";
+            }
+        }
+        return text;
+    }
+
+    // Every transition has to be possible on the queue that records it.
+    void CheckQueueStates(const Compiler& compiler)
+    {
+        auto checkBarriers = [](Queue queue, const std::vector<Compiler::Barrier>& barriers)
+        {
+            for (const Compiler::Barrier& barrier : barriers)
+            {
+                CHECK(Compiler::IsStateSupported(queue, barrier.StateBefore | barrier.StateAfter));
+            }
+        };
+
+        for (const Compiler::CompiledPass& compiledPass : compiler.GetCompiledPasses())
+        {
+            checkBarriers(compiledPass.PassQueue, compiledPass.Barriers);
+            checkBarriers(compiledPass.PassQueue, compiledPass.BarriersAfter);
+        }
+        for (uint32_t queue = 0; queue < Compiler::NumQueues; ++queue)
+        {
+            checkBarriers(static_cast<Queue>(queue), compiler.GetFinalBarriers(static_cast<Queue>(queue)));
+        }
+    }
+
+    void CheckGolden(const Compiler& compiler, const char* golden)
+    {
+        CHECK_EQUAL(std::string(golden), Dump(compiler));
+        CheckQueueStates(compiler);
+    }
+}
+
+TEST_CASE(RenderGraphCullsUnusedPasses)
+{
+    Compiler compiler;
+    uint32_t backBuffer = compiler.ImportResource(Present, Present);
+    uint32_t target = compiler.AddResource(RenderTarget);
+    uint32_t unused = compiler.AddResource(RenderTarget);
+    uint32_t temp = compiler.AddResource(RenderTarget);
+    uint32_t readback = compiler.AddResource(CopyDest);
+
+    uint32_t draw = compiler.AddPass(Queue::Graphics);
+    compiler.Write(draw, target, RenderTarget);
+    // Nothing reads what it writes.
+    uint32_t dead = compiler.AddPass(Queue::Graphics);
+    compiler.Write(dead, unused, RenderTarget);
+    // Its data is only read by a pass that is culled itself.
+    uint32_t deadProducer = compiler.AddPass(Queue::Graphics);
+    compiler.Write(deadProducer, temp, RenderTarget);
+    uint32_t deadConsumer = compiler.AddPass(Queue::Graphics);
+    compiler.Read(deadConsumer, temp, PixelShaderResource);
+    compiler.Write(deadConsumer, unused, RenderTarget);
+    // Kept for its side effects, and so is the draw it copies from.
+    uint32_t copy = compiler.AddPass(Queue::Graphics, true);
+    compiler.Read(copy, target, CopySource);
+    compiler.Write(copy, readback, CopyDest);
+    uint32_t present = compiler.AddPass(Queue::Graphics);
+    compiler.Read(present, target, PixelShaderResource);
+    compiler.Write(present, backBuffer, RenderTarget);
+    compiler.Compile();
+
+    CHECK(!compiler.IsCulled(draw));
+    CHECK(compiler.IsCulled(dead));
+    CHECK(compiler.IsCulled(deadProducer));
+    CHECK(compiler.IsCulled(deadConsumer));
+    CHECK(!compiler.IsCulled(copy));
+    CHECK(!compiler.IsCulled(present));
+    CheckGolden(compiler,
+        "P0 graphics [begin r0 0->4]\n"
+        "P4 graphics [r1 4->880]\n"
+        "P5 graphics [end r0 0->4]\n"
+        "final graphics [r0 4->0] [r1 880->4]\n");
+
+    Compiler::Statistics statistics = compiler.GetStatistics();
+    CHECK_EQUAL(6u, statistics.NumPasses);
+    CHECK_EQUAL(3u, statistics.NumCulledPasses);
+}
+
+TEST_CASE(RenderGraphMergesReadsAndSplitsTransitions)
+{
+    Compiler compiler;
+    uint32_t backBuffer = compiler.ImportResource(Present, Present);
+    uint32_t gbuffer = compiler.AddResource(RenderTarget);
+    uint32_t unused = compiler.AddResource(RenderTarget);
+    uint32_t shadow = compiler.AddResource(DepthWrite);
+
+    uint32_t geometry = compiler.AddPass(Queue::Graphics);
+    compiler.Write(geometry, gbuffer, RenderTarget);
+    uint32_t dead = compiler.AddPass(Queue::Graphics);
+    compiler.Write(dead, unused, RenderTarget);
+    uint32_t shadows = compiler.AddPass(Queue::Graphics);
+    compiler.Write(shadows, shadow, DepthWrite);
+    uint32_t lighting = compiler.AddPass(Queue::Graphics);
+    compiler.Read(lighting, gbuffer, PixelShaderResource);
+    compiler.Read(lighting, shadow, PixelShaderResource);
+    compiler.Write(lighting, backBuffer, RenderTarget);
+    uint32_t post = compiler.AddPass(Queue::Graphics);
+    compiler.Read(post, gbuffer, NonPixelShaderResource);
+    compiler.Write(post, backBuffer, RenderTarget);
+    compiler.Compile();
+
+    CHECK(compiler.IsCulled(dead));
+    // The two reads of the gbuffer share one transition to PSR | NPSR, which begins after the geometry pass.
+    // The back buffer transition begins after the geometry pass as well, the shadow map one after lighting.
+    CheckGolden(compiler,
+        "P0 graphics [begin r0 0->4]\n"
+        "P2 graphics [begin r1 4->c0]\n"
+        "P3 graphics [end r1 4->c0] [r3 10->80] [end r0 0->4]\n"
+        "P4 graphics [begin r3 80->10]\n"
+        "final graphics [r0 4->0] [r1 c0->4] [end r3 80->10]\n");
+
+    Compiler::Statistics statistics = compiler.GetStatistics();
+    CHECK_EQUAL(9u, statistics.NumBarriers);
+    CHECK_EQUAL(3u, statistics.NumSplitBarriers);
+    CHECK_EQUAL(5u, statistics.NumBarrierBatches);
+
+    // Compiling again gives the same result.
+    const std::string first = Dump(compiler);
+    compiler.Compile();
+    CHECK_EQUAL(first, Dump(compiler));
+}
+
+TEST_CASE(RenderGraphUnorderedAccessBarriers)
+{
+    Compiler compiler;
+    uint32_t backBuffer = compiler.ImportResource(Present, Present);
+    uint32_t buffer = compiler.AddResource(UnorderedAccess);
+    uint32_t depth = compiler.AddResource(DepthWrite);
+
+    uint32_t depthPass = compiler.AddPass(Queue::Graphics);
+    compiler.Write(depthPass, depth, DepthWrite);
+    uint32_t simulate1 = compiler.AddPass(Queue::Compute);
+    compiler.Write(simulate1, buffer, UnorderedAccess);
+    uint32_t simulate2 = compiler.AddPass(Queue::Compute);
+    compiler.Write(simulate2, buffer, UnorderedAccess);
+    uint32_t draw = compiler.AddPass(Queue::Graphics);
+    compiler.Read(draw, buffer, NonPixelShaderResource);
+    compiler.Read(draw, depth, DepthRead);
+    compiler.Write(draw, backBuffer, RenderTarget);
+    compiler.Compile();
+
+    // Without async queues everything runs on the graphics queue. The first UAV write needs no barrier,
+    // the second one a UAV barrier.
+    CheckGolden(compiler,
+        "P0 graphics [begin r0 0->4]\n"
+        "P1 graphics [begin r2 10->20]\n"
+        "P2 graphics [uav r1]\n"
+        "P3 graphics [r1 8->40] [end r2 10->20] [end r0 0->4]\n"
+        "final graphics [r0 4->0] [r1 40->8] [r2 20->10]\n");
+
+    // With async compute the UAV writes run first on the compute queue and the draw waits for the second one.
+    compiler.SetAsyncQueues(true);
+    compiler.Compile();
+    CheckGolden(compiler,
+        "P1 compute\n"
+        "P2 compute signal [uav r1]\n"
+        "P0 graphics [begin r0 0->4]\n"
+        "P3 graphics wait(compute@1) [r1 8->40] [r2 10->20] [end r0 0->4]\n"
+        "final graphics [r0 4->0] [r1 40->8] [r2 20->10]\n");
+}
+
+TEST_CASE(RenderGraphElidesRedundantWaits)
+{
+    Compiler compiler;
+    compiler.SetAsyncQueues(true);
+    uint32_t backBuffer = compiler.ImportResource(Present, Present);
+    uint32_t a = compiler.AddResource(UnorderedAccess);
+    uint32_t b = compiler.AddResource(UnorderedAccess);
+
+    uint32_t computeA = compiler.AddPass(Queue::Compute);
+    compiler.Write(computeA, a, UnorderedAccess);
+    uint32_t computeB = compiler.AddPass(Queue::Compute);
+    compiler.Write(computeB, b, UnorderedAccess);
+    uint32_t useB = compiler.AddPass(Queue::Graphics);
+    compiler.Read(useB, b, NonPixelShaderResource);
+    compiler.Write(useB, backBuffer, RenderTarget);
+    uint32_t useA = compiler.AddPass(Queue::Graphics);
+    compiler.Read(useA, a, NonPixelShaderResource);
+    compiler.Write(useA, backBuffer, RenderTarget);
+    compiler.Compile();
+
+    // Waiting for the second compute pass covers the first one, the last pass does not wait again.
+    CheckGolden(compiler,
+        "P0 compute\n"
+        "P1 compute signal\n"
+        "P2 graphics wait(compute@1) [r2 8->40] [r0 0->4]\n"
+        "P3 graphics [r1 8->40] [begin r2 40->8]\n"
+        "final graphics [r0 4->0] [r1 40->8] [end r2 40->8]\n");
+    CHECK_EQUAL(1u, compiler.GetStatistics().NumQueueWaits);
+}
+
+TEST_CASE(RenderGraphKeepsTransitionsLegalOnAsyncQueues)
+{
+    // The graphics queue renders a target that async compute reads: compute can not transition
+    // from the render target state, the graphics queue does it after the draw, before its signal.
+    {
+        Compiler compiler;
+        compiler.SetAsyncQueues(true);
+        uint32_t backBuffer = compiler.ImportResource(Present, Present);
+        uint32_t target = compiler.AddResource(RenderTarget);
+        uint32_t output = compiler.AddResource(UnorderedAccess);
+
+        uint32_t draw = compiler.AddPass(Queue::Graphics);
+        compiler.Write(draw, target, RenderTarget);
+        uint32_t blur = compiler.AddPass(Queue::Compute);
+        compiler.Read(blur, target, NonPixelShaderResource);
+        compiler.Write(blur, output, UnorderedAccess);
+        uint32_t composite = compiler.AddPass(Queue::Graphics);
+        compiler.Read(composite, output, PixelShaderResource);
+        compiler.Write(composite, backBuffer, RenderTarget);
+        compiler.Compile();
+
+        CheckGolden(compiler,
+            "P0 graphics signal [begin r0 0->4] after [r1 4->40]\n"
+            "P1 compute signal wait(graphics@0)\n"
+            "P2 graphics wait(compute@1) [r2 8->80] [end r0 0->4]\n"
+            "final graphics [r0 4->0] [r1 40->4] [r2 80->8]\n");
+    }
+
+    // A read in the pixel shader followed by a read on compute: the transition from the merged
+    // PSR state to NPSR is made by the graphics queue after the first read.
+    {
+        Compiler compiler;
+        compiler.SetAsyncQueues(true);
+        uint32_t backBuffer = compiler.ImportResource(Present, Present);
+        uint32_t texture = compiler.AddResource(CopyDest);
+        uint32_t counters = compiler.AddResource(UnorderedAccess);
+
+        uint32_t upload = compiler.AddPass(Queue::Graphics);
+        compiler.Write(upload, texture, CopyDest);
+        // Pixel shader that reads the texture and counts into a UAV.
+        uint32_t draw = compiler.AddPass(Queue::Graphics);
+        compiler.Read(draw, texture, PixelShaderResource);
+        compiler.Write(draw, counters, UnorderedAccess);
+        compiler.Write(draw, backBuffer, RenderTarget);
+        uint32_t analyze = compiler.AddPass(Queue::Compute, true);
+        compiler.Read(analyze, texture, NonPixelShaderResource);
+        compiler.Read(analyze, counters, NonPixelShaderResource);
+        compiler.Compile();
+
+        CheckGolden(compiler,
+            "P0 graphics [begin r0 0->4]\n"
+            "P1 graphics signal [r1 400->80] [end r0 0->4] after [r1 80->40]\n"
+            "P2 compute wait(graphics@1) [r2 8->40]\n"
+            "final graphics wait(compute@end)\n"
+            "final graphics [r0 4->0]\n"
+            "final compute [r1 40->400] [r2 40->8]\n");
+    }
+
+    // A compute pass whose first use needs a transition from the render target state, with no
+    // earlier use that could make it: the pass runs on the graphics queue.
+    {
+        Compiler compiler;
+        compiler.SetAsyncQueues(true);
+        uint32_t history = compiler.ImportResource(RenderTarget, RenderTarget);
+        uint32_t output = compiler.ImportResource(UnorderedAccess, UnorderedAccess);
+
+        uint32_t resolve = compiler.AddPass(Queue::Compute);
+        compiler.Read(resolve, history, NonPixelShaderResource);
+        compiler.Write(resolve, output, UnorderedAccess);
+        compiler.Compile();
+
+        CheckGolden(compiler,
+            "P0 graphics [r0 4->40]\n"
+            "final graphics [r0 40->4]\n");
+    }
+}
+
+TEST_CASE(RenderGraphWaitsForFinalBarriers)
+{
+    // The final transition of a compute result is made on the compute queue, the graphics
+    // queue waits for it before the frame is presented.
+    {
+        Compiler compiler;
+        compiler.SetAsyncQueues(true);
+        uint32_t backBuffer = compiler.ImportResource(Present, Present);
+        uint32_t history = compiler.ImportResource(UnorderedAccess, NonPixelShaderResource);
+
+        uint32_t draw = compiler.AddPass(Queue::Graphics);
+        compiler.Write(draw, backBuffer, RenderTarget);
+        uint32_t accumulate = compiler.AddPass(Queue::Compute);
+        compiler.Write(accumulate, history, UnorderedAccess);
+        compiler.Compile();
+
+        CheckGolden(compiler,
+            "P1 compute\n"
+            "P0 graphics [r0 0->4]\n"
+            "final graphics wait(compute@end)\n"
+            "final graphics [r0 4->0]\n"
+            "final compute [r1 8->40]\n");
+    }
+
+    // The final state is not supported on the copy queue: the graphics queue makes the transition
+    // after waiting for the copy.
+    {
+        Compiler compiler;
+        compiler.SetAsyncQueues(true);
+        uint32_t backBuffer = compiler.ImportResource(Present, Present);
+        uint32_t texture = compiler.ImportResource(CopyDest, PixelShaderResource);
+
+        uint32_t draw = compiler.AddPass(Queue::Graphics);
+        compiler.Write(draw, backBuffer, RenderTarget);
+        uint32_t upload = compiler.AddPass(Queue::Copy);
+        compiler.Write(upload, texture, CopyDest);
+        compiler.Compile();
+
+        CheckGolden(compiler,
+            "P1 copy signal\n"
+            "P0 graphics [r0 0->4]\n"
+            "final graphics wait(copy@0)\n"
+            "final graphics [r0 4->0] [r1 400->80]\n");
+        CHECK_EQUAL(1u, compiler.GetStatistics().NumQueueWaits);
+    }
+}
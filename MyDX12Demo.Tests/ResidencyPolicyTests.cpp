@@ -0,0 +1,210 @@
+#include <ResidencyPolicy.h>
+
+#include <TestFramework.h>
+
+#include <vector>
+
+namespace
+{
+    // Stand-ins for the heaps, only their addresses are used.
+    struct FakeHeap
+    {
+        int Id;
+    };
+
+    // Simulates the video memory of the process: the usage is the size of the resident objects.
+    uint64_t GetUsage(const ResidencyPolicy& policy)
+    {
+        return policy.GetStatistics().ResidentSize;
+    }
+
+    ResidencyPolicy::Operations Prepare(ResidencyPolicy& policy, uint64_t budget, uint64_t completedFenceValue)
+    {
+        ResidencyPolicy::Operations operations;
+        policy.PrepareSubmission(budget, GetUsage(policy), completedFenceValue, operations);
+        return operations;
+    }
+
+    // One frame: the objects are used, the paging operations decided and the submission signals fenceValue.
+    ResidencyPolicy::Operations SubmitFrame(ResidencyPolicy& policy, const std::vector<FakeHeap*>& used,
+        uint64_t budget, uint64_t completedFenceValue, uint64_t fenceValue)
+    {
+        for (FakeHeap* pHeap : used)
+        {
+            policy.MarkUsed(pHeap);
+        }
+        ResidencyPolicy::Operations operations = Prepare(policy, budget, completedFenceValue);
+        policy.Submitted(fenceValue);
+        return operations;
+    }
+}
+
+TEST_CASE(ResidencyPolicyEvictsLeastRecentlyUsedFirst)
+{
+    FakeHeap heaps[4] = { { 0 }, { 1 }, { 2 }, { 3 } };
+    ResidencyPolicy policy;
+    for (FakeHeap& heap : heaps)
+    {
+        policy.Add(&heap, 10);
+    }
+    // The first submission initializes all of them and fits in the budget.
+    ResidencyPolicy::Operations operations = Prepare(policy, 100, 0);
+    CHECK(operations.Evict.empty());
+    CHECK(operations.MakeResident.empty());
+    CHECK(!operations.OverBudget);
+    policy.Submitted(1);
+
+    // Used in the order 2, 0, 3, 1: heap 1 is the most recently used one.
+    SubmitFrame(policy, { &heaps[2] }, 100, 1, 2);
+    SubmitFrame(policy, { &heaps[0] }, 100, 2, 3);
+    SubmitFrame(policy, { &heaps[3] }, 100, 3, 4);
+    SubmitFrame(policy, { &heaps[1] }, 100, 4, 5);
+
+    // The budget shrinks to 25 with everything idle: the two least recently used heaps go, in that order.
+    operations = Prepare(policy, 25, 5);
+    CHECK_EQUAL(size_t(2), operations.Evict.size());
+    CHECK(operations.Evict[0] == &heaps[2]);
+    CHECK(operations.Evict[1] == &heaps[0]);
+    CHECK(operations.MakeResident.empty());
+    CHECK(!operations.OverBudget);
+    CHECK(!policy.IsResident(&heaps[2]));
+    CHECK(!policy.IsResident(&heaps[0]));
+    CHECK(policy.IsResident(&heaps[3]));
+    CHECK(policy.IsResident(&heaps[1]));
+    policy.Submitted(6);
+
+    ResidencyPolicy::Statistics statistics = policy.GetStatistics();
+    CHECK_EQUAL(4u, statistics.NumObjects);
+    CHECK_EQUAL(2u, statistics.NumResidentObjects);
+    CHECK_EQUAL(uint64_t(20), statistics.ResidentSize);
+    CHECK_EQUAL(uint64_t(20), statistics.EvictedSize);
+    CHECK_EQUAL(uint64_t(2), statistics.NumEvictions);
+
+    // Within the budget nothing is evicted, however old the objects are.
+    operations = Prepare(policy, 25, 6);
+    CHECK(operations.Evict.empty());
+    policy.Submitted(7);
+}
+
+TEST_CASE(ResidencyPolicyKeepsObjectsInUse)
+{
+    FakeHeap heaps[3] = { { 0 }, { 1 }, { 2 } };
+    ResidencyPolicy policy;
+    for (FakeHeap& heap : heaps)
+    {
+        policy.Add(&heap, 10);
+    }
+    policy.Submitted(1);
+
+    // Heap 0 is in flight (fence 2 not completed) and heap 1 is used by the upcoming submission:
+    // only heap 2 may go.
+    SubmitFrame(policy, { &heaps[0] }, 100, 1, 2);
+    policy.MarkUsed(&heaps[1]);
+    ResidencyPolicy::Operations operations = Prepare(policy, 0, 1);
+    CHECK_EQUAL(size_t(1), operations.Evict.size());
+    CHECK(operations.Evict[0] == &heaps[2]);
+    // 20 bytes can not be evicted, the submission goes over the budget.
+    CHECK(operations.OverBudget);
+    CHECK(policy.IsResident(&heaps[0]));
+    CHECK(policy.IsResident(&heaps[1]));
+    policy.Submitted(3);
+
+    // Once fence 2 completes heap 0 may go, heap 1 is still in flight with fence 3.
+    operations = Prepare(policy, 10, 2);
+    CHECK_EQUAL(size_t(1), operations.Evict.size());
+    CHECK(operations.Evict[0] == &heaps[0]);
+    CHECK(!operations.OverBudget);
+    policy.Submitted(4);
+
+    // Heap 1 stays until fence 3 completes, whatever the budget.
+    operations = Prepare(policy, 0, 2);
+    CHECK(operations.Evict.empty());
+    CHECK(operations.OverBudget);
+    policy.Submitted(5);
+}
+
+TEST_CASE(ResidencyPolicyMakesEvictedObjectsResident)
+{
+    FakeHeap heaps[3] = { { 0 }, { 1 }, { 2 } };
+    ResidencyPolicy policy;
+    for (FakeHeap& heap : heaps)
+    {
+        policy.Add(&heap, 10);
+    }
+    policy.Submitted(1);
+
+    // Evict everything.
+    ResidencyPolicy::Operations operations = Prepare(policy, 0, 1);
+    CHECK_EQUAL(size_t(3), operations.Evict.size());
+    policy.Submitted(2);
+    CHECK_EQUAL(0u, policy.GetStatistics().NumResidentObjects);
+
+    // Using an evicted object reports it and the next submission pages it in before evicting anything.
+    CHECK(policy.MarkUsed(&heaps[1]));
+    CHECK(policy.MarkUsed(&heaps[1]));
+    operations = Prepare(policy, 100, 2);
+    CHECK_EQUAL(size_t(1), operations.MakeResident.size());
+    CHECK(operations.MakeResident[0] == &heaps[1]);
+    CHECK(operations.Evict.empty());
+    CHECK(policy.IsResident(&heaps[1]));
+    CHECK(!policy.MarkUsed(&heaps[1]));
+    policy.Submitted(3);
+
+    // Paging an object in can push the usage over the budget: the other idle objects make room,
+    // never the object that was just made resident.
+    operations = SubmitFrame(policy, { &heaps[0], &heaps[2] }, 20, 3, 4);
+    CHECK_EQUAL(size_t(2), operations.MakeResident.size());
+    CHECK_EQUAL(size_t(1), operations.Evict.size());
+    CHECK(operations.Evict[0] == &heaps[1]);
+    CHECK(!operations.OverBudget);
+
+    // The caller can page an object in itself.
+    policy.MarkResident(&heaps[1]);
+    CHECK(policy.IsResident(&heaps[1]));
+    operations = Prepare(policy, 100, 4);
+    CHECK(operations.MakeResident.empty());
+    policy.Submitted(5);
+
+    ResidencyPolicy::Statistics statistics = policy.GetStatistics();
+    CHECK_EQUAL(3u, statistics.NumResidentObjects);
+    CHECK_EQUAL(uint64_t(4), statistics.NumEvictions);
+    CHECK_EQUAL(uint64_t(4), statistics.NumMakeResidents);
+}
+
+TEST_CASE(ResidencyPolicyReportsOverBudget)
+{
+    FakeHeap heaps[4] = { { 0 }, { 1 }, { 2 }, { 3 } };
+    ResidencyPolicy policy;
+    for (FakeHeap& heap : heaps)
+    {
+        policy.Add(&heap, 10);
+    }
+    policy.Submitted(1);
+
+    // A frame that needs more than the budget: the idle objects go and the frame is still over.
+    ResidencyPolicy::Operations operations = SubmitFrame(policy, { &heaps[0], &heaps[1], &heaps[2] }, 25, 1, 2);
+    CHECK_EQUAL(size_t(1), operations.Evict.size());
+    CHECK(operations.Evict[0] == &heaps[3]);
+    CHECK(operations.OverBudget);
+
+    // The report only depends on the usage against the budget, it clears once the frame fits again.
+    operations = SubmitFrame(policy, { &heaps[0], &heaps[1] }, 25, 2, 3);
+    CHECK(operations.Evict.size() == 1 && operations.Evict[0] == &heaps[2]);
+    CHECK(!operations.OverBudget);
+
+    // The usage reported by the system also counts memory the policy does not track.
+    ResidencyPolicy::Operations external;
+    policy.PrepareSubmission(25, GetUsage(policy) + 100, 2, external);
+    CHECK(external.Evict.empty());
+    CHECK(external.OverBudget);
+    policy.Submitted(4);
+
+    // A removed object is no longer paged, even when it was used by the pending submission.
+    policy.MarkUsed(&heaps[3]);
+    policy.Remove(&heaps[3]);
+    CHECK(!policy.IsTracked(&heaps[3]));
+    operations = Prepare(policy, 100, 4);
+    CHECK(operations.MakeResident.empty());
+    policy.Submitted(5);
+    CHECK_EQUAL(3u, policy.GetStatistics().NumObjects);
+}
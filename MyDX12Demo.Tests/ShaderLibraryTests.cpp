@@ -0,0 +1,130 @@
+#include <ShaderLibrary.h>
+#include <ThreadPool.h>
+
+#include <TestFramework.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::wstring GetTempFileName(const char* name)
+    {
+        return (std::filesystem::temp_directory_path() / name).wstring();
+    }
+
+    void WriteFile(const std::wstring& fileName, const std::string& contents)
+    {
+        std::ofstream file(std::filesystem::path(fileName), std::ios::binary | std::ios::trunc);
+        file << contents;
+    }
+
+    std::string GetContents(const ShaderLibrary::ShaderPtr& shader)
+    {
+        return shader ? std::string(shader->Bytecode.begin(), shader->Bytecode.end()) : std::string();
+    }
+
+    // Calls Update like the frame loop, for numFrames frames or until a shader changed.
+    std::vector<ShaderLibrary::ShaderPtr> UpdateFrames(ShaderLibrary& library, int numFrames, bool stopOnChange)
+    {
+        std::vector<ShaderLibrary::ShaderPtr> changedShaders;
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            for (const ShaderLibrary::ShaderPtr& shader : library.Update())
+            {
+                changedShaders.push_back(shader);
+            }
+            if (stopOnChange && !changedShaders.empty())
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return changedShaders;
+    }
+}
+
+TEST_CASE(ShaderLibraryReloadsChangedShader)
+{
+    const std::wstring fileName = GetTempFileName("ShaderLibraryTests_Reload.cso");
+    WriteFile(fileName, "AAAA");
+
+    ShaderLibrary library(nullptr);
+    ShaderLibrary::ShaderPtr shader = library.Load(fileName);
+    CHECK_EQUAL(std::string("AAAA"), GetContents(shader));
+    CHECK(library.Load(fileName) == shader);
+    CHECK(UpdateFrames(library, 10, false).empty());
+
+    WriteFile(fileName, "AAAAB");
+    std::vector<ShaderLibrary::ShaderPtr> changedShaders = UpdateFrames(library, 400, true);
+    CHECK_EQUAL(size_t(1), changedShaders.size());
+    CHECK_EQUAL(std::string("AAAAB"), GetContents(changedShaders[0]));
+    CHECK(library.Load(fileName) == changedShaders[0]);
+    // The old version stays valid for its users.
+    CHECK_EQUAL(std::string("AAAA"), GetContents(shader));
+
+    // Rewriting the same bytecode changes nothing.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    WriteFile(fileName, "AAAAB");
+    CHECK(UpdateFrames(library, 20, false).empty());
+
+    std::filesystem::remove(std::filesystem::path(fileName));
+}
+
+TEST_CASE(ShaderLibraryRereadsShaderChangedDuringReload)
+{
+    const std::wstring fileName = GetTempFileName("ShaderLibraryTests_ChangedAgain.cso");
+    WriteFile(fileName, "v1");
+
+    ThreadPool threadPool(1);
+    ShaderLibrary library(&threadPool);
+    CHECK_EQUAL(std::string("v1"), GetContents(library.Load(fileName)));
+
+    // The file changes again before the reload ran: only the last version is published.
+    {
+        // Keep the only worker busy, so the reload stays in flight while the file changes again.
+        std::promise<void> gate;
+        std::shared_future<void> gateFuture = gate.get_future().share();
+        std::future<void> blocker = threadPool.Submit([gateFuture]() { gateFuture.wait(); });
+
+        WriteFile(fileName, "v2");
+        CHECK(UpdateFrames(library, 40, false).empty());
+        WriteFile(fileName, "v3, written before v2 is read");
+        CHECK(UpdateFrames(library, 40, false).empty());
+
+        gate.set_value();
+        blocker.wait();
+
+        std::vector<ShaderLibrary::ShaderPtr> changedShaders = UpdateFrames(library, 400, true);
+        CHECK_EQUAL(size_t(1), changedShaders.size());
+        CHECK_EQUAL(std::string("v3, written before v2 is read"), GetContents(changedShaders[0]));
+        CHECK(UpdateFrames(library, 20, false).empty());
+    }
+
+    // The file changes again after the reload read it, before Update collected it: the last write is not lost.
+    {
+        std::promise<void> gate;
+        std::shared_future<void> gateFuture = gate.get_future().share();
+        std::future<void> blocker = threadPool.Submit([gateFuture]() { gateFuture.wait(); });
+
+        WriteFile(fileName, "v4");
+        CHECK(UpdateFrames(library, 40, false).empty());
+
+        // The worker runs the tasks in order, once the next task is done the reload has read v4.
+        gate.set_value();
+        threadPool.Submit([]() {}).wait();
+        WriteFile(fileName, "v5, written after v4 is read");
+
+        std::vector<ShaderLibrary::ShaderPtr> changedShaders = UpdateFrames(library, 40, false);
+        CHECK(!changedShaders.empty());
+        CHECK_EQUAL(std::string("v5, written after v4 is read"), GetContents(changedShaders.back()));
+        CHECK_EQUAL(std::string("v5, written after v4 is read"), GetContents(library.Load(fileName)));
+    }
+
+    std::filesystem::remove(std::filesystem::path(fileName));
+}
@@ -0,0 +1,296 @@
+#include <TaskGraph.h>
+
+#include <TestFramework.h>
+#include <ThreadPool.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    uint32_t NextRandom(uint32_t& state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    // Order in which the tasks started and finished, from one counter.
+    struct Trace
+    {
+        explicit Trace(uint32_t numTasks)
+            : Start(numTasks)
+            , End(numTasks)
+        {
+            for (uint32_t i = 0; i < numTasks; ++i)
+            {
+                Start[i] = 0;
+                End[i] = 0;
+            }
+        }
+
+        std::function<void()> Record(uint32_t task)
+        {
+            return [this, task]()
+            {
+                Start[task] = ++Counter;
+                std::this_thread::yield();
+                End[task] = ++Counter;
+            };
+        }
+
+        std::atomic<uint32_t> Counter{ 0 };
+        std::vector< std::atomic<uint32_t> > Start;
+        std::vector< std::atomic<uint32_t> > End;
+    };
+
+    void Sleep(int milliseconds)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    }
+}
+
+TEST_CASE(TaskGraphRunsDependenciesFirst)
+{
+    ThreadPool threadPool(4);
+    ThreadPool* threadPools[] = { nullptr, &threadPool };
+
+    for (ThreadPool* pThreadPool : threadPools)
+    {
+        // Random dependencies on earlier tasks, some tasks with none.
+        const uint32_t numTasks = 300;
+        Trace trace(numTasks);
+        TaskGraph graph;
+        const uint32_t phase = graph.AddPhase("Tasks");
+        std::vector< std::vector<uint32_t> > dependencies(numTasks);
+        uint32_t state = 3;
+        for (uint32_t task = 0; task < numTasks; ++task)
+        {
+            const uint32_t numDependencies = task > 0 ? NextRandom(state) % 4 : 0;
+            for (uint32_t i = 0; i < numDependencies; ++i)
+            {
+                dependencies[task].push_back(NextRandom(state) % task);
+            }
+            CHECK_EQUAL(task, graph.AddTask(phase, trace.Record(task), dependencies[task]));
+        }
+        CHECK_EQUAL(numTasks, graph.GetNumTasks());
+        graph.Run(pThreadPool);
+
+        for (uint32_t task = 0; task < numTasks; ++task)
+        {
+            CHECK(trace.Start[task] != 0 && trace.End[task] > trace.Start[task]);
+            for (uint32_t dependency : dependencies[task])
+            {
+                CHECK(trace.End[dependency] < trace.Start[task]);
+            }
+        }
+        // Without a thread pool the tasks run on the calling thread, one after the other.
+        if (!pThreadPool)
+        {
+            for (uint32_t task = 0; task < numTasks; ++task)
+            {
+                CHECK_EQUAL(trace.Start[task] + 1, trace.End[task].load());
+            }
+        }
+    }
+
+    // A task can run a graph of its own, the calling thread helps like in ParallelFor.
+    ThreadPool singleThread(1);
+    std::atomic<uint32_t> numInnerTasks(0);
+    TaskGraph outer;
+    const uint32_t outerPhase = outer.AddPhase("Outer");
+    for (int i = 0; i < 4; ++i)
+    {
+        outer.AddTask(outerPhase, [&]()
+        {
+            TaskGraph inner;
+            const uint32_t innerPhase = inner.AddPhase("Inner");
+            uint32_t first = inner.AddTask(innerPhase, [&]() { ++numInnerTasks; });
+            inner.AddTask(innerPhase, [&]() { ++numInnerTasks; }, { first });
+            inner.Run(&singleThread);
+        });
+    }
+    outer.Run(&singleThread);
+    CHECK_EQUAL(8u, numInnerTasks.load());
+}
+
+TEST_CASE(TaskGraphRunsDiamondOnce)
+{
+    ThreadPool threadPool(4);
+    ThreadPool* threadPools[] = { nullptr, &threadPool };
+
+    for (ThreadPool* pThreadPool : threadPools)
+    {
+        // top -> left, right -> bottom, the bottom waits for both sides and runs once.
+        for (int iteration = 0; iteration < 50; ++iteration)
+        {
+            std::atomic<uint32_t> numSides(0);
+            std::atomic<uint32_t> numBottomRuns(0);
+            std::atomic<uint32_t> sidesSeenByBottom(0);
+            std::atomic<bool> topDone(false);
+            std::atomic<bool> sidesSawTop(true);
+
+            TaskGraph graph;
+            const uint32_t phase = graph.AddPhase("Diamond");
+            uint32_t top = graph.AddTask(phase, [&]() { topDone = true; });
+            auto side = [&]()
+            {
+                sidesSawTop = sidesSawTop && topDone;
+                Sleep(iteration % 3);
+                ++numSides;
+            };
+            uint32_t left = graph.AddTask(phase, side, { top });
+            uint32_t right = graph.AddTask(phase, side, { top });
+            // A dependency that is given twice only counts once.
+            graph.AddTask(phase, [&]()
+            {
+                sidesSeenByBottom = numSides.load();
+                ++numBottomRuns;
+            }, { left, right, left });
+            graph.Run(pThreadPool);
+
+            CHECK(sidesSawTop);
+            CHECK_EQUAL(2u, sidesSeenByBottom.load());
+            CHECK_EQUAL(1u, numBottomRuns.load());
+        }
+    }
+}
+
+TEST_CASE(TaskGraphSkipsDependentsOfFailedTasks)
+{
+    ThreadPool threadPool(4);
+    ThreadPool* threadPools[] = { nullptr, &threadPool };
+
+    for (ThreadPool* pThreadPool : threadPools)
+    {
+        bool fail = true;
+        std::atomic<uint32_t> ran[6];
+        TaskGraph graph;
+        const uint32_t phase = graph.AddPhase("Tasks");
+        uint32_t failing = graph.AddTask(phase, [&]()
+        {
+            ++ran[0];
+            if (fail)
+            {
+                throw std::runtime_error("shader not found");
+            }
+        });
+        uint32_t dependent = graph.AddTask(phase, [&]() { ++ran[1]; }, { failing });
+        // Skipped transitively, and when only one of the dependencies failed.
+        graph.AddTask(phase, [&]() { ++ran[2]; }, { dependent });
+        uint32_t independent = graph.AddTask(phase, [&]() { ++ran[3]; });
+        graph.AddTask(phase, [&]() { ++ran[4]; }, { independent, dependent });
+        graph.AddTask(phase, [&]() { ++ran[5]; }, { independent });
+
+        for (std::atomic<uint32_t>& count : ran)
+        {
+            count = 0;
+        }
+        std::string message;
+        try
+        {
+            graph.Run(pThreadPool);
+        }
+        catch (const std::runtime_error& error)
+        {
+            message = error.what();
+        }
+        CHECK(message == "shader not found");
+        const uint32_t expected[6] = { 1, 0, 0, 1, 0, 1 };
+        for (int i = 0; i < 6; ++i)
+        {
+            CHECK_EQUAL(expected[i], ran[i].load());
+        }
+
+        // The failure only affects that run.
+        fail = false;
+        graph.Run(pThreadPool);
+        for (int i = 0; i < 6; ++i)
+        {
+            CHECK_EQUAL(expected[i] + 1, ran[i].load());
+        }
+    }
+
+    // With several failures the first one is rethrown and everything else still runs.
+    TaskGraph graph;
+    const uint32_t phase = graph.AddPhase("Tasks");
+    std::atomic<uint32_t> numRun(0);
+    for (int i = 0; i < 20; ++i)
+    {
+        graph.AddTask(phase, [&, i]()
+        {
+            ++numRun;
+            if (i % 4 == 0)
+            {
+                throw std::runtime_error("failed");
+            }
+        });
+    }
+    bool thrown = false;
+    try
+    {
+        graph.Run(&threadPool);
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK_EQUAL(20u, numRun.load());
+}
+
+TEST_CASE(TaskGraphMeasuresPhases)
+{
+    ThreadPool threadPool(4);
+    ThreadPool* threadPools[] = { nullptr, &threadPool };
+    const int sleepMilliseconds = 20;
+
+    for (ThreadPool* pThreadPool : threadPools)
+    {
+        // Two loads, then a compile that needs both. The empty phase is never started.
+        TaskGraph graph;
+        const uint32_t load = graph.AddPhase("Load");
+        const uint32_t compile = graph.AddPhase("Compile");
+        graph.AddPhase("Empty");
+        uint32_t first = graph.AddTask(load, []() { Sleep(sleepMilliseconds); });
+        uint32_t second = graph.AddTask(load, []() { Sleep(sleepMilliseconds); });
+        graph.AddTask(compile, []() { Sleep(sleepMilliseconds); }, { first, second });
+
+        for (int run = 0; run < 2; ++run)
+        {
+            graph.Run(pThreadPool);
+
+            const std::vector<TaskGraph::PhaseTiming>& phases = graph.GetPhaseTimings();
+            CHECK_EQUAL(size_t(3), phases.size());
+            CHECK(phases[0].Name == "Load");
+            CHECK_EQUAL(2u, phases[0].NumTasks);
+            CHECK_EQUAL(1u, phases[1].NumTasks);
+            CHECK_EQUAL(0u, phases[2].NumTasks);
+
+            // The task time is summed over the threads, the wall clock range covers the tasks.
+            const double minSeconds = sleepMilliseconds / 1000.0;
+            CHECK(phases[0].TaskSeconds >= 2.0 * minSeconds);
+            CHECK(phases[1].TaskSeconds >= minSeconds);
+            CHECK(phases[0].EndSeconds - phases[0].StartSeconds >= minSeconds);
+            CHECK(phases[0].StartSeconds >= 0.0);
+            // Every compile task waits for the loads.
+            CHECK(phases[1].StartSeconds >= phases[0].EndSeconds);
+            CHECK(graph.GetTotalSeconds() >= phases[1].EndSeconds);
+            CHECK(graph.GetTotalSeconds() >= 2.0 * minSeconds);
+            CHECK_EQUAL(0.0, phases[2].TaskSeconds);
+            CHECK_EQUAL(0.0, phases[2].EndSeconds);
+
+            // Timings are of the last run only, not accumulated. Generous bound for a loaded machine.
+            CHECK(phases[0].TaskSeconds < 2.0 * minSeconds + 1.0);
+        }
+
+        graph.Clear();
+        CHECK_EQUAL(0u, graph.GetNumTasks());
+        CHECK(graph.GetPhaseTimings().empty());
+        CHECK_EQUAL(0.0, graph.GetTotalSeconds());
+    }
+}
@@ -0,0 +1,93 @@
+#include <TestFramework.h>
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+namespace
+{
+    struct TestEntry
+    {
+        const char* Name;
+        Test::TestFunc Func;
+        bool IsBenchmark;
+    };
+
+    // Function local, the registrars of the other translation units may run first.
+    std::vector<TestEntry>& GetTests()
+    {
+        static std::vector<TestEntry> tests;
+        return tests;
+    }
+
+    // Written by DoNotOptimize, the compiler has to assume that something reads it.
+    const void* volatile gs_Sink;
+}
+
+namespace Test
+{
+    Registrar::Registrar(const char* name, TestFunc func, bool isBenchmark)
+    {
+        GetTests().push_back({ name, func, isBenchmark });
+    }
+
+    void Fail(const char* file, int line, const std::string& message)
+    {
+        throw Failure(std::string(file) + "(" + std::to_string(line) + "): " + message);
+    }
+
+    void Report(const std::string& name, double value, const char* unit)
+    {
+        printf("    %-48s %12.2f %s\n", name.c_str(), value, unit);
+    }
+
+    void DoNotOptimize(const void* p)
+    {
+        gs_Sink = p;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool benchmarks = false;
+    const char* filter = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--benchmark") == 0)
+        {
+            benchmarks = true;
+        }
+        else
+        {
+            filter = argv[i];
+        }
+    }
+
+    uint32_t numRun = 0;
+    uint32_t numFailed = 0;
+    for (const TestEntry& test : GetTests())
+    {
+        if (test.IsBenchmark != benchmarks || (filter && !strstr(test.Name, filter)))
+        {
+            continue;
+        }
+
+        printf("[ RUN  ] %s\n", test.Name);
+        fflush(stdout);
+        ++numRun;
+        try
+        {
+            test.Func();
+            printf("[  OK  ] %s\n", test.Name);
+        }
+        catch (const std::exception& e)
+        {
+            ++numFailed;
+            printf("[ FAIL ] %s\n    %s\n", test.Name, e.what());
+        }
+    }
+
+    printf("%u run, %u failed\n", numRun, numFailed);
+    return numFailed == 0 ? 0 : 1;
+}
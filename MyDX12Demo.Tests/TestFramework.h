@@ -0,0 +1,95 @@
+/**
+* Minimal test and benchmark runner for the CPU side of the demo.
+*
+* TEST_CASE registers a test, BENCHMARK a benchmark. The runner executes all
+* tests, with --benchmark it executes the benchmarks instead. A failed CHECK
+* throws, the rest of the test is skipped and the runner continues with the
+* next one. Any other argument only runs the tests whose name contains it.
+*/
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace Test
+{
+    using TestFunc = void(*)();
+
+    // Registers a test at static initialization, see TEST_CASE and BENCHMARK.
+    struct Registrar
+    {
+        Registrar(const char* name, TestFunc func, bool isBenchmark);
+    };
+
+    class Failure : public std::runtime_error
+    {
+    public:
+        explicit Failure(const std::string& message)
+            : std::runtime_error(message)
+        {}
+    };
+
+    [[noreturn]] void Fail(const char* file, int line, const std::string& message);
+
+    template<typename Expected, typename Actual>
+    std::string FormatMismatch(const char* expression, const Expected& expected, const Actual& actual)
+    {
+        std::ostringstream stream;
+        stream << expression << ": expected " << expected << ", got " << actual;
+        return stream.str();
+    }
+
+    // Prints one benchmark result.
+    void Report(const std::string& name, double value, const char* unit);
+
+    // Keeps the optimizer from removing a computation whose result is unused.
+    void DoNotOptimize(const void* p);
+
+    class Timer
+    {
+    public:
+        Timer()
+            : m_Start(std::chrono::steady_clock::now())
+        {}
+
+        double GetElapsedSeconds() const
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_Start;
+    };
+}
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static const ::Test::Registrar name##Registrar(#name, &name, false); \
+    static void name()
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static const ::Test::Registrar name##Registrar(#name, &name, true); \
+    static void name()
+
+#define CHECK(condition) \
+    do { if (!(condition)) ::Test::Fail(__FILE__, __LINE__, #condition); } while (false)
+
+#define CHECK_EQUAL(expected, actual) \
+    do { \
+        const auto& checkExpected = (expected); \
+        const auto& checkActual = (actual); \
+        if (!(checkExpected == checkActual)) \
+            ::Test::Fail(__FILE__, __LINE__, ::Test::FormatMismatch(#actual, checkExpected, checkActual)); \
+    } while (false)
+
+#define CHECK_NEAR(expected, actual, tolerance) \
+    do { \
+        const double checkExpected = static_cast<double>(expected); \
+        const double checkActual = static_cast<double>(actual); \
+        if (!(checkActual >= checkExpected - (tolerance) && checkActual <= checkExpected + (tolerance))) \
+            ::Test::Fail(__FILE__, __LINE__, ::Test::FormatMismatch(#actual, checkExpected, checkActual)); \
+    } while (false)
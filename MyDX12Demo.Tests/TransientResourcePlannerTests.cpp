@@ -0,0 +1,197 @@
+#include <TransientResourcePlanner.h>
+
+#include <TestFramework.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    const uint64_t KB = 1024;
+
+    struct Lifetime
+    {
+        uint64_t Size;
+        uint64_t Alignment;
+        uint32_t FirstPass;
+        uint32_t LastPass;
+    };
+
+    bool LifetimesOverlap(const Lifetime& a, const Lifetime& b)
+    {
+        return a.FirstPass <= b.LastPass && b.FirstPass <= a.LastPass;
+    }
+
+    // Small deterministic generator, the placement does not depend on the platform's rand.
+    uint32_t NextRandom(uint32_t& state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+}
+
+TEST_CASE(TransientResourcePlannerSharesMemoryOfDisjointLifetimes)
+{
+    TransientResourcePlanner planner;
+    uint32_t a = planner.AddResource(64 * KB, 64 * KB, 0, 1);
+    uint32_t b = planner.AddResource(64 * KB, 64 * KB, 2, 3);
+    uint32_t c = planner.AddResource(64 * KB, 64 * KB, 4, 5);
+    planner.Plan();
+
+    // One after the other, all three fit in the memory of one.
+    CHECK_EQUAL(uint64_t(0), planner.GetPlacement(a).Offset);
+    CHECK_EQUAL(uint64_t(0), planner.GetPlacement(b).Offset);
+    CHECK_EQUAL(uint64_t(0), planner.GetPlacement(c).Offset);
+    CHECK_EQUAL(64 * KB, planner.GetHeapSize());
+
+    TransientResourcePlanner::Statistics statistics = planner.GetStatistics();
+    CHECK_EQUAL(3u, statistics.NumResources);
+    CHECK_EQUAL(2u, statistics.NumAliasedResources);
+    CHECK_EQUAL(64 * KB, statistics.HeapSize);
+    CHECK_EQUAL(192 * KB, statistics.SummedSize);
+
+    // Sharing a pass is enough to need separate memory: every resource then gets its own.
+    planner.Clear();
+    CHECK_EQUAL(0u, planner.GetNumResources());
+    a = planner.AddResource(64 * KB, 64 * KB, 0, 1);
+    b = planner.AddResource(64 * KB, 64 * KB, 1, 2);
+    c = planner.AddResource(64 * KB, 64 * KB, 2, 3);
+    planner.Plan();
+    CHECK_EQUAL(uint64_t(0), planner.GetPlacement(a).Offset);
+    CHECK_EQUAL(64 * KB, planner.GetPlacement(b).Offset);
+    CHECK_EQUAL(uint64_t(0), planner.GetPlacement(c).Offset);
+    CHECK_EQUAL(128 * KB, planner.GetHeapSize());
+
+    // Nothing to place.
+    planner.Clear();
+    planner.Plan();
+    CHECK_EQUAL(uint64_t(0), planner.GetHeapSize());
+    CHECK_EQUAL(uint64_t(0), planner.GetStatistics().SummedSize);
+}
+
+TEST_CASE(TransientResourcePlannerNeverOverlapsLiveResources)
+{
+    const uint64_t alignments[] = { 256, 4 * KB, 64 * KB };
+    const uint32_t numPasses = 24;
+
+    uint32_t state = 7;
+    for (int frame = 0; frame < 20; ++frame)
+    {
+        TransientResourcePlanner planner;
+        std::vector<Lifetime> lifetimes(40 + frame * 5);
+        for (Lifetime& lifetime : lifetimes)
+        {
+            lifetime.Size = 1 + NextRandom(state) % (512 * KB);
+            lifetime.Alignment = alignments[NextRandom(state) % 3];
+            lifetime.FirstPass = NextRandom(state) % numPasses;
+            lifetime.LastPass = std::min(numPasses - 1, lifetime.FirstPass + NextRandom(state) % 6);
+            planner.AddResource(lifetime.Size, lifetime.Alignment, lifetime.FirstPass, lifetime.LastPass);
+        }
+        planner.Plan();
+
+        uint64_t summedSize = 0;
+        for (uint32_t i = 0; i < lifetimes.size(); ++i)
+        {
+            const TransientResourcePlanner::Placement& placement = planner.GetPlacement(i);
+            CHECK_EQUAL(uint64_t(0), placement.Offset % lifetimes[i].Alignment);
+            CHECK(placement.Offset + lifetimes[i].Size <= planner.GetHeapSize());
+            summedSize += lifetimes[i].Size;
+
+            for (uint32_t j = i + 1; j < lifetimes.size(); ++j)
+            {
+                if (!LifetimesOverlap(lifetimes[i], lifetimes[j]))
+                {
+                    continue;
+                }
+                const TransientResourcePlanner::Placement& other = planner.GetPlacement(j);
+                const bool memoryOverlaps = placement.Offset < other.Offset + lifetimes[j].Size &&
+                    other.Offset < placement.Offset + lifetimes[i].Size;
+                CHECK(!memoryOverlaps);
+            }
+        }
+
+        // The heap is never larger than the sum of the resources and never smaller than the peak of one pass.
+        uint64_t peakSize = 0;
+        for (uint32_t pass = 0; pass < numPasses; ++pass)
+        {
+            uint64_t liveSize = 0;
+            for (const Lifetime& lifetime : lifetimes)
+            {
+                liveSize += lifetime.FirstPass <= pass && pass <= lifetime.LastPass ? lifetime.Size : 0;
+            }
+            peakSize = std::max(peakSize, liveSize);
+        }
+        TransientResourcePlanner::Statistics statistics = planner.GetStatistics();
+        CHECK_EQUAL(summedSize, statistics.SummedSize);
+        CHECK_EQUAL(planner.GetHeapSize(), statistics.HeapSize);
+        CHECK(statistics.HeapSize <= statistics.SummedSize);
+        CHECK(statistics.HeapSize >= peakSize);
+        CHECK(statistics.NumAliasedResources > 0);
+    }
+}
+
+TEST_CASE(TransientResourcePlannerAlignsPlacements)
+{
+    // All alive in the same pass: the larger one goes first, the others after it at their own alignment.
+    TransientResourcePlanner planner;
+    uint32_t small = planner.AddResource(100, 256, 0, 0);
+    uint32_t large = planner.AddResource(1000, 64 * KB, 0, 0);
+    uint32_t tiny = planner.AddResource(10, 4 * KB, 0, 0);
+    planner.Plan();
+    CHECK_EQUAL(uint64_t(0), planner.GetPlacement(large).Offset);
+    CHECK_EQUAL(uint64_t(1024), planner.GetPlacement(small).Offset);
+    CHECK_EQUAL(4 * KB, planner.GetPlacement(tiny).Offset);
+    CHECK_EQUAL(4 * KB + 10, planner.GetHeapSize());
+    CHECK_EQUAL(uint64_t(1110), planner.GetStatistics().SummedSize);
+
+    // A gap between live resources is only used when the aligned resource fits in it.
+    planner.Clear();
+    uint32_t first = planner.AddResource(64 * KB, 64 * KB, 0, 2);
+    uint32_t hole = planner.AddResource(64 * KB, 64 * KB, 0, 0);
+    uint32_t second = planner.AddResource(64 * KB, 64 * KB, 0, 2);
+    uint32_t fits = planner.AddResource(32 * KB, 32 * KB, 1, 2);
+    uint32_t misaligned = planner.AddResource(32 * KB, 128 * KB, 1, 2);
+    planner.Plan();
+    CHECK_EQUAL(uint64_t(0), planner.GetPlacement(first).Offset);
+    CHECK_EQUAL(64 * KB, planner.GetPlacement(hole).Offset);
+    CHECK_EQUAL(128 * KB, planner.GetPlacement(second).Offset);
+    // The hole is free from pass 1.
+    CHECK_EQUAL(64 * KB, planner.GetPlacement(fits).Offset);
+    // 96 KB would still be free, but the next multiple of 128 KB is 256 KB.
+    CHECK_EQUAL(256 * KB, planner.GetPlacement(misaligned).Offset);
+    CHECK_EQUAL(288 * KB, planner.GetHeapSize());
+}
+
+TEST_CASE(TransientResourcePlannerFindsAliasingPredecessor)
+{
+    TransientResourcePlanner planner;
+    uint32_t a = planner.AddResource(1000, 1, 0, 0);
+    uint32_t b = planner.AddResource(1000, 1, 1, 1);
+    uint32_t c = planner.AddResource(500, 1, 2, 2);
+    uint32_t longLived = planner.AddResource(1000, 1, 0, 2);
+    planner.Plan();
+
+    CHECK_EQUAL(uint64_t(0), planner.GetPlacement(a).Offset);
+    CHECK_EQUAL(uint64_t(0), planner.GetPlacement(b).Offset);
+    CHECK_EQUAL(uint64_t(0), planner.GetPlacement(c).Offset);
+    CHECK_EQUAL(uint64_t(1000), planner.GetPlacement(longLived).Offset);
+
+    // The first user of the memory has no predecessor, the pool passes a null "before" resource then.
+    CHECK(planner.GetPlacement(a).AliasedResource == TransientResourcePlanner::InvalidIndex);
+    CHECK(planner.GetPlacement(longLived).AliasedResource == TransientResourcePlanner::InvalidIndex);
+    CHECK_EQUAL(a, planner.GetPlacement(b).AliasedResource);
+    // Both a and b used the memory of c before, the barrier names the one that used it last.
+    CHECK_EQUAL(b, planner.GetPlacement(c).AliasedResource);
+    CHECK_EQUAL(2u, planner.GetStatistics().NumAliasedResources);
+    CHECK_EQUAL(uint64_t(2000), planner.GetHeapSize());
+    CHECK_EQUAL(uint64_t(3500), planner.GetStatistics().SummedSize);
+
+    // Only resources whose memory overlaps count: d follows c, e reaches into the long lived one.
+    uint32_t d = planner.AddResource(600, 1, 3, 3);
+    uint32_t e = planner.AddResource(500, 1, 3, 3);
+    planner.Plan();
+    CHECK_EQUAL(uint64_t(0), planner.GetPlacement(d).Offset);
+    CHECK_EQUAL(uint64_t(600), planner.GetPlacement(e).Offset);
+    CHECK_EQUAL(c, planner.GetPlacement(d).AliasedResource);
+    CHECK_EQUAL(longLived, planner.GetPlacement(e).AliasedResource);
+}
@@ -0,0 +1,135 @@
+#include <VertexQuantization.h>
+
+#include <TestFramework.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Interleaved position and color, like VertexPosColor.
+    struct PosColor
+    {
+        float Position[3];
+        float Color[3];
+    };
+
+    std::vector<PosColor> MakeRandomVertices(size_t numVertices, float minPosition, float maxPosition)
+    {
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> position(minPosition, maxPosition);
+        // Colors slightly outside of [0, 1] test the clamping.
+        std::uniform_real_distribution<float> color(-0.2f, 1.2f);
+
+        std::vector<PosColor> vertices(numVertices);
+        for (PosColor& vertex : vertices)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                vertex.Position[c] = position(random);
+                vertex.Color[c] = color(random);
+            }
+        }
+        return vertices;
+    }
+
+    // Scalar reference of EncodeVertices with the same float operations and
+    // round to nearest even, the SSE2 path has to produce identical bits.
+    VertexPosColorPacked EncodeVertexScalar(const PosColor& vertex, const QuantizationBounds& bounds)
+    {
+        VertexPosColorPacked packed = {};
+        for (int c = 0; c < 3; ++c)
+        {
+            float invScale = 1.0f / bounds.Scale[c];
+            float p = std::min(std::max((vertex.Position[c] - bounds.Bias[c]) * invScale, -1.0f), 1.0f);
+            packed.Position[c] = static_cast<int16_t>(std::lrint(p * 32767.0f));
+            float color = std::min(std::max(vertex.Color[c], 0.0f), 1.0f);
+            packed.Color[c] = static_cast<uint8_t>(std::lrint(color * 255.0f));
+        }
+        packed.Color[3] = 255;
+        return packed;
+    }
+}
+
+TEST_CASE(QuantizationErrorIsBounded)
+{
+    std::vector<PosColor> vertices = MakeRandomVertices(10000, -50.0f, 30.0f);
+    // The corners of the bounds map to exactly -1 and 1.
+    vertices[0] = { { -50.0f, -50.0f, -50.0f }, { 0.0f, 0.0f, 0.0f } };
+    vertices[1] = { { 30.0f, 30.0f, 30.0f }, { 1.0f, 1.0f, 1.0f } };
+
+    QuantizationBounds bounds = ComputeQuantizationBounds(vertices[0].Position, sizeof(PosColor), vertices.size());
+    std::vector<VertexPosColorPacked> packed(vertices.size());
+    EncodeVertices(vertices[0].Position, vertices[0].Color, sizeof(PosColor), vertices.size(), bounds, packed.data());
+
+    float maxError[3];
+    GetMaxQuantizationError(bounds, maxError);
+
+    for (int c = 0; c < 3; ++c)
+    {
+        // Half a quantization step of the bounds, the bound only adds float rounding on top.
+        float halfStep = 0.5f * bounds.Scale[c] / 32767.0f;
+        CHECK(maxError[c] >= halfStep && maxError[c] <= halfStep * 1.01f);
+    }
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        float position[3];
+        DecodePosition(packed[i], bounds, position);
+        for (int c = 0; c < 3; ++c)
+        {
+            CHECK(std::abs(position[c] - vertices[i].Position[c]) <= maxError[c]);
+
+            float color = std::min(std::max(vertices[i].Color[c], 0.0f), 1.0f);
+            CHECK(std::abs(packed[i].Color[c] / 255.0f - color) <= MaxColorQuantizationError + 1e-6f);
+        }
+        CHECK_EQUAL(255, packed[i].Color[3]);
+    }
+}
+
+TEST_CASE(QuantizationOfFlatMesh)
+{
+    // All vertices in the z = 2 plane, the zero extent must not produce infinities.
+    std::vector<PosColor> vertices = MakeRandomVertices(100, -1.0f, 1.0f);
+    for (PosColor& vertex : vertices)
+    {
+        vertex.Position[2] = 2.0f;
+    }
+
+    QuantizationBounds bounds = ComputeQuantizationBounds(vertices[0].Position, sizeof(PosColor), vertices.size());
+    CHECK(bounds.Scale[2] > 0.0f);
+
+    std::vector<VertexPosColorPacked> packed(vertices.size());
+    EncodeVertices(vertices[0].Position, nullptr, sizeof(PosColor), vertices.size(), bounds, packed.data());
+    for (const VertexPosColorPacked& vertex : packed)
+    {
+        float position[3];
+        DecodePosition(vertex, bounds, position);
+        CHECK_NEAR(2.0f, position[2], 1e-5);
+        // Without colors the vertices are white.
+        CHECK(vertex.Color[0] == 255 && vertex.Color[1] == 255 && vertex.Color[2] == 255);
+    }
+}
+
+TEST_CASE(QuantizationSimdMatchesScalar)
+{
+    std::vector<PosColor> vertices = MakeRandomVertices(10000, -3.0f, 7.0f);
+    QuantizationBounds bounds = ComputeQuantizationBounds(vertices[0].Position, sizeof(PosColor), vertices.size());
+
+    // Positions outside of the bounds are clamped the same way.
+    vertices[5].Position[0] = 100.0f;
+    vertices[6].Position[1] = -100.0f;
+
+    std::vector<VertexPosColorPacked> packed(vertices.size());
+    EncodeVertices(vertices[0].Position, vertices[0].Color, sizeof(PosColor), vertices.size(), bounds, packed.data());
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        VertexPosColorPacked expected = EncodeVertexScalar(vertices[i], bounds);
+        CHECK(memcmp(expected.Position, packed[i].Position, sizeof(int16_t) * 3) == 0);
+        CHECK(memcmp(expected.Color, packed[i].Color, sizeof(expected.Color)) == 0);
+    }
+}
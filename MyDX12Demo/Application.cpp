@@ -1,7 +1,12 @@
 #include <Application.h>
 #include <DX12LibPCH.h>
+#include <BindlessDescriptorTable.h>
 #include <Game.h>
 #include <CommandQueue.h>
+#include <DescriptorViewCache.h>
+#include <GPUMemoryAllocator.h>
+#include <PipelineStateCache.h>
+#include <ResidencyManager.h>
 #include <Window.h>
 
 constexpr wchar_t WINDOW_CLASS_NAME[] = L"DX12RenderWindowClass";
@@ -72,6 +77,23 @@ Application::Application(HINSTANCE hInst)
         m_ComputeCommandQueue = std::make_shared<CommandQueue>(m_d3d12Device, D3D12_COMMAND_LIST_TYPE_COMPUTE);
         m_CopyCommandQueue = std::make_shared<CommandQueue>(m_d3d12Device, D3D12_COMMAND_LIST_TYPE_COPY);
 
+        m_ResidencyManager = std::make_shared<ResidencyManager>(m_d3d12Device, m_dxgiAdapter);
+        m_MemoryAllocator = std::make_shared<GPUMemoryAllocator>(m_d3d12Device, 64ull * 1024 * 1024, m_ResidencyManager);
+
+        for (int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+        {
+            m_DescriptorAllocators[i] = std::make_unique<DescriptorAllocator>(m_d3d12Device, static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i));
+        }
+        if (BindlessDescriptorTable::IsSupported(m_d3d12Device.Get()))
+        {
+            m_BindlessDescriptorTable = std::make_shared<BindlessDescriptorTable>(m_d3d12Device);
+        }
+        m_DescriptorViewCache = std::make_shared<DescriptorViewCache>(m_d3d12Device, [this](D3D12_DESCRIPTOR_HEAP_TYPE type)
+        {
+            return AllocateDescriptors(type);
+        });
+        m_PipelineStateCache = std::make_shared<PipelineStateCache>(m_d3d12Device, m_dxgiAdapter, L"PipelineCache.bin");
+
         m_TearingSupported = CheckTearingSupport();
     }
 }
@@ -336,6 +358,16 @@ std::shared_ptr<CommandQueue> Application::GetCommandQueue(D3D12_COMMAND_LIST_TY
     return commandQueue;
 }
 
+std::shared_ptr<GPUMemoryAllocator> Application::GetMemoryAllocator() const
+{
+    return m_MemoryAllocator;
+}
+
+std::shared_ptr<ResidencyManager> Application::GetResidencyManager() const
+{
+    return m_ResidencyManager;
+}
+
 void Application::Flush()
 {
     m_DirectCommandQueue->Flush();
@@ -362,6 +394,38 @@ UINT Application::GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE ty
     return m_d3d12Device->GetDescriptorHandleIncrementSize(type);
 }
 
+DescriptorAllocation Application::AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors)
+{
+    return m_DescriptorAllocators[type]->Allocate(numDescriptors);
+}
+
+void Application::ReleaseStaleDescriptors(uint64_t fenceValue, uint64_t completedFenceValue)
+{
+    for (int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+    {
+        m_DescriptorAllocators[i]->ReleaseStaleDescriptors(fenceValue, completedFenceValue);
+    }
+    if (m_BindlessDescriptorTable)
+    {
+        m_BindlessDescriptorTable->ReleaseStaleDescriptors(fenceValue, completedFenceValue);
+    }
+}
+
+std::shared_ptr<BindlessDescriptorTable> Application::GetBindlessDescriptorTable() const
+{
+    return m_BindlessDescriptorTable;
+}
+
+std::shared_ptr<DescriptorViewCache> Application::GetDescriptorViewCache() const
+{
+    return m_DescriptorViewCache;
+}
+
+std::shared_ptr<PipelineStateCache> Application::GetPipelineStateCache() const
+{
+    return m_PipelineStateCache;
+}
+
 
 // Remove a window from our window lists.
 static void RemoveWindow(HWND hWnd)
@@ -0,0 +1,223 @@
+#include <AssetStreamer.h>
+#include <DX12LibPCH.h>
+
+#include <Application.h>
+#include <CommandQueue.h>
+#include <FastMemcpy.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    // Alignment of the individual requests inside the upload buffer.
+    const size_t UploadAlignment = 16;
+
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+AssetStreamer::AssetStreamer(std::shared_ptr<CommandQueue> copyQueue, std::shared_ptr<CommandQueue> directQueue,
+    uint32_t numIOThreads, size_t maxBatchSize)
+    : m_CopyQueue(copyQueue)
+    , m_DirectQueue(directQueue)
+    , m_MaxBatchSize(maxBatchSize)
+    , m_NumPendingRequests(0)
+    , m_IOThreads(std::max(1u, numIOThreads))
+{
+}
+
+AssetStreamer::~AssetStreamer()
+{
+    // Upload buffers of in-flight batches are released with the batches,
+    // make sure the copy queue is no longer reading them.
+    m_CopyQueue->Flush();
+}
+
+void AssetStreamer::LoadBuffer(const std::wstring& fileName, CompletionCallback callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ++m_NumPendingRequests;
+    }
+
+    m_IOThreads.Submit([this, fileName, callback]()
+    {
+        auto request = std::make_unique<Request>();
+        request->Callback = callback;
+
+        std::ifstream file(std::filesystem::path(fileName), std::ios::binary | std::ios::ate);
+        if (file)
+        {
+            std::streamsize fileSize = file.tellg();
+            file.seekg(0, std::ios::beg);
+
+            request->Data.resize(static_cast<size_t>(fileSize));
+            request->Failed = !file.read(reinterpret_cast<char*>(request->Data.data()), fileSize) || fileSize == 0;
+            request->pData = request->Data.data();
+            request->SizeInBytes = request->Data.size();
+        }
+        else
+        {
+            request->Failed = true;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_ReadyRequests.push_back(std::move(request));
+    });
+}
+
+void AssetStreamer::LoadBuffer(const void* bufferData, size_t sizeInBytes, CompletionCallback callback)
+{
+    auto request = std::make_unique<Request>();
+    request->Callback = callback;
+    request->Data.assign(static_cast<const uint8_t*>(bufferData), static_cast<const uint8_t*>(bufferData) + sizeInBytes);
+    request->pData = request->Data.data();
+    request->SizeInBytes = sizeInBytes;
+    request->Failed = sizeInBytes == 0;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ++m_NumPendingRequests;
+    m_ReadyRequests.push_back(std::move(request));
+}
+
+void AssetStreamer::LoadBuffer(std::shared_ptr<const void> owner, const void* bufferData, size_t sizeInBytes, CompletionCallback callback)
+{
+    auto request = std::make_unique<Request>();
+    request->Callback = callback;
+    request->Owner = owner;
+    request->pData = static_cast<const uint8_t*>(bufferData);
+    request->SizeInBytes = sizeInBytes;
+    request->Failed = sizeInBytes == 0 || !bufferData;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ++m_NumPendingRequests;
+    m_ReadyRequests.push_back(std::move(request));
+}
+
+void AssetStreamer::Update()
+{
+    // 释放已完成的上传批次
+    while (!m_InFlightBatches.empty() && m_CopyQueue->IsFenceComplete(m_InFlightBatches.front().FenceValue))
+    {
+        m_InFlightBatches.pop_front();
+    }
+
+    // Take as many ready requests as fit in the batch budget (at least one).
+    std::vector< std::unique_ptr<Request> > requests;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        size_t batchSize = 0;
+        while (!m_ReadyRequests.empty())
+        {
+            size_t requestSize = AlignUp(m_ReadyRequests.front()->SizeInBytes, UploadAlignment);
+            if (!requests.empty() && batchSize + requestSize > m_MaxBatchSize)
+            {
+                break;
+            }
+
+            batchSize += requestSize;
+            requests.push_back(std::move(m_ReadyRequests.front()));
+            m_ReadyRequests.pop_front();
+        }
+    }
+
+    if (!requests.empty())
+    {
+        SubmitBatch(requests);
+    }
+}
+
+void AssetStreamer::SubmitBatch(std::vector< std::unique_ptr<Request> >& requests)
+{
+    auto device = Application::Get().GetDevice();
+    auto memoryAllocator = Application::Get().GetMemoryAllocator();
+
+    std::vector<size_t> uploadOffsets(requests.size());
+    size_t uploadSize = 0;
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        uploadOffsets[i] = uploadSize;
+        if (!requests[i]->Failed)
+        {
+            uploadSize += AlignUp(requests[i]->SizeInBytes, UploadAlignment);
+        }
+    }
+
+    std::vector<Buffer> buffers(requests.size());
+
+    if (uploadSize > 0)
+    {
+        // One upload buffer for the whole batch.
+        ComPtr<ID3D12Resource> uploadBuffer;
+        CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+        CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadSize);
+        ThrowIfFailed(device->CreateCommittedResource(
+            &heapProperties,
+            D3D12_HEAP_FLAG_NONE,
+            &resourceDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&uploadBuffer)));
+
+        uint8_t* pMappedData = nullptr;
+        CD3DX12_RANGE readRange(0, 0);
+        ThrowIfFailed(uploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pMappedData)));
+
+        auto commandList = m_CopyQueue->GetCommandList();
+
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            const Request& request = *requests[i];
+            if (request.Failed)
+            {
+                continue;
+            }
+
+            // The upload heap is write-combined, bypass the cache.
+            StreamingMemcpy(pMappedData + uploadOffsets[i], request.pData, request.SizeInBytes);
+
+            Buffer& buffer = buffers[i];
+            buffer.SizeInBytes = request.SizeInBytes;
+            buffer.Resource = memoryAllocator->CreateResource(
+                CD3DX12_RESOURCE_DESC::Buffer(buffer.SizeInBytes),
+                D3D12_RESOURCE_STATE_COMMON,
+                nullptr,
+                buffer.Allocation);
+
+            commandList->CopyBufferRegion(buffer.Resource.Get(), 0,
+                uploadBuffer.Get(), uploadOffsets[i], buffer.SizeInBytes);
+        }
+
+        uploadBuffer->Unmap(0, nullptr);
+
+        uint64_t fenceValue = m_CopyQueue->ExecuteCommandList(commandList);
+
+        // Work submitted to the direct queue from now on waits on the GPU for the copies.
+        // Buffers decay to the common state after the copy and are implicitly promoted
+        // to the read state they are first used in on the direct queue.
+        m_DirectQueue->Wait(*m_CopyQueue, fenceValue);
+
+        m_InFlightBatches.push_back(UploadBatch{ fenceValue, uploadBuffer });
+    }
+
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        if (requests[i]->Callback)
+        {
+            requests[i]->Callback(buffers[i]);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_NumPendingRequests -= requests.size();
+}
+
+size_t AssetStreamer::GetNumPendingRequests() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_NumPendingRequests;
+}
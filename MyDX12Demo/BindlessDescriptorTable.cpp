@@ -0,0 +1,138 @@
+#include <BindlessDescriptorTable.h>
+#include <DX12LibPCH.h>
+
+bool BindlessDescriptorTable::IsSupported(ID3D12Device2* device)
+{
+    D3D12_FEATURE_DATA_SHADER_MODEL shaderModel = { D3D_SHADER_MODEL_6_6 };
+    if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &shaderModel, sizeof(shaderModel))) ||
+        shaderModel.HighestShaderModel < D3D_SHADER_MODEL_6_6)
+    {
+        return false;
+    }
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))))
+    {
+        return false;
+    }
+
+    return options.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_2;
+}
+
+BindlessDescriptorTable::BindlessDescriptorTable(Microsoft::WRL::ComPtr<ID3D12Device2> device, uint32_t numDescriptors)
+    : m_d3d12Device(device)
+    , m_Handles(numDescriptors)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.NumDescriptors = numDescriptors;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+    ThrowIfFailed(m_d3d12Device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_d3d12DescriptorHeap)));
+
+    m_BaseDescriptor = m_d3d12DescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    m_DescriptorSize = m_d3d12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+BindlessDescriptorTable::~BindlessDescriptorTable()
+{
+}
+
+uint32_t BindlessDescriptorTable::AllocateSlot(D3D12_CPU_DESCRIPTOR_HANDLE& descriptor)
+{
+    uint32_t handle;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        handle = m_Handles.Allocate();
+    }
+
+    if (handle != InvalidHandle)
+    {
+        descriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_BaseDescriptor, BindlessHandleAllocator::GetIndex(handle), m_DescriptorSize);
+    }
+
+    return handle;
+}
+
+uint32_t BindlessDescriptorTable::CreateShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE descriptor;
+    uint32_t handle = AllocateSlot(descriptor);
+    if (handle != InvalidHandle)
+    {
+        m_d3d12Device->CreateShaderResourceView(pResource, pDesc, descriptor);
+    }
+
+    return handle;
+}
+
+uint32_t BindlessDescriptorTable::CreateUnorderedAccessView(ID3D12Resource* pResource, ID3D12Resource* pCounterResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE descriptor;
+    uint32_t handle = AllocateSlot(descriptor);
+    if (handle != InvalidHandle)
+    {
+        m_d3d12Device->CreateUnorderedAccessView(pResource, pCounterResource, pDesc, descriptor);
+    }
+
+    return handle;
+}
+
+uint32_t BindlessDescriptorTable::CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE descriptor;
+    uint32_t handle = AllocateSlot(descriptor);
+    if (handle != InvalidHandle)
+    {
+        m_d3d12Device->CreateConstantBufferView(&desc, descriptor);
+    }
+
+    return handle;
+}
+
+uint32_t BindlessDescriptorTable::CopyDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE descriptor;
+    uint32_t handle = AllocateSlot(descriptor);
+    if (handle != InvalidHandle)
+    {
+        m_d3d12Device->CopyDescriptorsSimple(1, descriptor, srcDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    }
+
+    return handle;
+}
+
+void BindlessDescriptorTable::Free(uint32_t handle)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    bool freed = m_Handles.Free(handle);
+    assert(freed && "Freeing an invalid or already freed bindless handle.");
+    (void)freed;
+}
+
+void BindlessDescriptorTable::ReleaseStaleDescriptors(uint64_t fenceValue, uint64_t completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Handles.Submitted(fenceValue);
+    m_Handles.ReleaseStale(completedFenceValue);
+}
+
+bool BindlessDescriptorTable::IsValid(uint32_t handle) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Handles.IsValid(handle);
+}
+
+void BindlessDescriptorTable::Bind(ID3D12GraphicsCommandList2* commandList) const
+{
+    ID3D12DescriptorHeap* heaps[] = { m_d3d12DescriptorHeap.Get() };
+    commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+}
+
+BindlessHandleAllocator::Statistics BindlessDescriptorTable::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Handles.GetStatistics();
+}
@@ -0,0 +1,101 @@
+#include <BindlessHandleAllocator.h>
+
+#include <cassert>
+
+BindlessHandleAllocator::BindlessHandleAllocator(uint32_t capacity)
+    : m_Capacity(capacity)
+    , m_NumAllocated(0)
+    , m_NumRetired(0)
+{
+    assert(capacity > 0 && capacity <= MaxCapacity && "Invalid bindless table capacity.");
+    m_Slots.reserve(capacity);
+}
+
+BindlessHandleAllocator::~BindlessHandleAllocator()
+{
+}
+
+uint32_t BindlessHandleAllocator::Allocate()
+{
+    uint32_t index;
+    if (!m_FreeSlots.empty())
+    {
+        index = m_FreeSlots.front();
+        m_FreeSlots.pop_front();
+    }
+    else if (m_Slots.size() < m_Capacity)
+    {
+        index = static_cast<uint32_t>(m_Slots.size());
+        m_Slots.push_back(Slot{ 0, false });
+    }
+    else
+    {
+        return InvalidHandle;
+    }
+
+    Slot& slot = m_Slots[index];
+    slot.Allocated = true;
+    ++m_NumAllocated;
+
+    return MakeHandle(index, slot.Generation);
+}
+
+bool BindlessHandleAllocator::Free(uint32_t handle)
+{
+    if (!IsValid(handle))
+    {
+        return false;
+    }
+
+    const uint32_t index = GetIndex(handle);
+    Slot& slot = m_Slots[index];
+    slot.Allocated = false;
+    --m_NumAllocated;
+
+    // 新的代数: the freed handle no longer matches the slot from now on.
+    if (slot.Generation == MaxGeneration)
+    {
+        ++m_NumRetired;
+        return true;
+    }
+    ++slot.Generation;
+
+    m_PendingSlots.push_back(index);
+    return true;
+}
+
+void BindlessHandleAllocator::Submitted(uint64_t fenceValue)
+{
+    assert((m_StaleSlots.empty() || m_StaleSlots.back().FenceValue <= fenceValue) && "Fence values must increase.");
+
+    for (uint32_t index : m_PendingSlots)
+    {
+        m_StaleSlots.push_back(StaleSlot{ index, fenceValue });
+    }
+    m_PendingSlots.clear();
+}
+
+void BindlessHandleAllocator::ReleaseStale(uint64_t completedFenceValue)
+{
+    while (!m_StaleSlots.empty() && m_StaleSlots.front().FenceValue <= completedFenceValue)
+    {
+        m_FreeSlots.push_back(m_StaleSlots.front().Index);
+        m_StaleSlots.pop_front();
+    }
+}
+
+bool BindlessHandleAllocator::IsValid(uint32_t handle) const
+{
+    const uint32_t index = GetIndex(handle);
+    return index < m_Slots.size() && m_Slots[index].Allocated && m_Slots[index].Generation == GetGeneration(handle);
+}
+
+BindlessHandleAllocator::Statistics BindlessHandleAllocator::GetStatistics() const
+{
+    Statistics statistics;
+    statistics.Capacity = m_Capacity;
+    statistics.NumAllocated = m_NumAllocated;
+    statistics.NumStale = static_cast<uint32_t>(m_PendingSlots.size() + m_StaleSlots.size());
+    statistics.NumRetired = m_NumRetired;
+    return statistics;
+}
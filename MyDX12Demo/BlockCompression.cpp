@@ -0,0 +1,1482 @@
+#include <BlockCompression.h>
+
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <emmintrin.h> // SSE2
+
+namespace
+{
+    // Blocks per side of a tile, one tile is the unit of work of CompressTexture.
+    const uint32_t TileSize = 16;
+
+    // 16 texels in structure of arrays layout: Channels[c][i] is channel c of texel i.
+    struct BlockPixels
+    {
+        alignas(16) float Channels[4][16];
+    };
+
+    void LoadBlock(const uint8_t* pPixels, BlockPixels& block)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        for (int i = 0; i < 16; i += 4)
+        {
+            __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPixels + i * 4));
+            __m128i low = _mm_unpacklo_epi8(texels, zero);
+            __m128i high = _mm_unpackhi_epi8(texels, zero);
+            __m128 t0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+            __m128 t1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+            __m128 t2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+            __m128 t3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+            _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+            _mm_store_ps(&block.Channels[0][i], t0);
+            _mm_store_ps(&block.Channels[1][i], t1);
+            _mm_store_ps(&block.Channels[2][i], t2);
+            _mm_store_ps(&block.Channels[3][i], t3);
+        }
+    }
+
+    float HorizontalSum(__m128 value)
+    {
+        __m128 shuffled = _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2));
+        value = _mm_add_ps(value, shuffled);
+        shuffled = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_cvtss_f32(_mm_add_ps(value, shuffled));
+    }
+
+    /**
+     * Pick the nearest palette entry for every texel, four texels at a time.
+     * pWeights scales the squared error of each channel (0 ignores the channel).
+     * @returns The error summed over the texels with a mask of 1.
+     */
+    float FitIndices(const BlockPixels& block, const float (*pPalette)[4], uint32_t numEntries,
+        const float* pWeights, const float* pMask, uint8_t* pIndices)
+    {
+        __m128 totalError = _mm_setzero_ps();
+        for (int i = 0; i < 16; i += 4)
+        {
+            __m128 texel[4];
+            for (int c = 0; c < 4; ++c)
+            {
+                texel[c] = _mm_load_ps(&block.Channels[c][i]);
+            }
+
+            __m128 bestError = _mm_set1_ps(FLT_MAX);
+            __m128i bestIndex = _mm_setzero_si128();
+            for (uint32_t k = 0; k < numEntries; ++k)
+            {
+                __m128 error = _mm_setzero_ps();
+                for (int c = 0; c < 4; ++c)
+                {
+                    __m128 difference = _mm_sub_ps(texel[c], _mm_set1_ps(pPalette[k][c]));
+                    error = _mm_add_ps(error, _mm_mul_ps(_mm_mul_ps(difference, difference), _mm_set1_ps(pWeights[c])));
+                }
+
+                __m128i better = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+                bestError = _mm_min_ps(error, bestError);
+                bestIndex = _mm_or_si128(_mm_and_si128(better, _mm_set1_epi32(k)), _mm_andnot_si128(better, bestIndex));
+            }
+
+            totalError = _mm_add_ps(totalError, _mm_mul_ps(bestError, _mm_loadu_ps(pMask + i)));
+
+            alignas(16) int32_t indices[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+            for (int j = 0; j < 4; ++j)
+            {
+                pIndices[i + j] = static_cast<uint8_t>(indices[j]);
+            }
+        }
+
+        return HorizontalSum(totalError);
+    }
+
+    /**
+     * Endpoints at the extremes of the principal axis of the texels with a mask of 1,
+     * using the channels with a non-zero weight.
+     * @returns false if no texel is selected.
+     */
+    bool ComputeEndpoints(const BlockPixels& block, const float* pMask, const float* pWeights, float* pEndpoint0, float* pEndpoint1)
+    {
+        const __m128 channelMask = _mm_setr_ps(pWeights[0] > 0.0f ? 1.0f : 0.0f, pWeights[1] > 0.0f ? 1.0f : 0.0f,
+            pWeights[2] > 0.0f ? 1.0f : 0.0f, pWeights[3] > 0.0f ? 1.0f : 0.0f);
+
+        // Mean of the selected texels.
+        float count = 0.0f;
+        float mean[4] = {};
+        for (int c = 0; c < 4; ++c)
+        {
+            __m128 sum = _mm_setzero_ps();
+            for (int i = 0; i < 16; i += 4)
+            {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(&block.Channels[c][i]), _mm_loadu_ps(pMask + i)));
+            }
+            mean[c] = HorizontalSum(sum);
+        }
+        for (int i = 0; i < 16; ++i)
+        {
+            count += pMask[i];
+        }
+        if (count == 0.0f)
+        {
+            return false;
+        }
+
+        __m128 meanVector = _mm_mul_ps(_mm_loadu_ps(mean), _mm_set1_ps(1.0f / count));
+        _mm_storeu_ps(mean, meanVector);
+
+        // Covariance of the selected channels.
+        float covariance[4][4] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            if (pMask[i] == 0.0f)
+            {
+                continue;
+            }
+
+            __m128 texel = _mm_setr_ps(block.Channels[0][i], block.Channels[1][i], block.Channels[2][i], block.Channels[3][i]);
+            alignas(16) float delta[4];
+            _mm_store_ps(delta, _mm_mul_ps(_mm_sub_ps(texel, meanVector), channelMask));
+            for (int c = 0; c < 4; ++c)
+            {
+                __m128 row = _mm_mul_ps(_mm_load_ps(delta), _mm_set1_ps(delta[c]));
+                _mm_storeu_ps(covariance[c], _mm_add_ps(_mm_loadu_ps(covariance[c]), row));
+            }
+        }
+
+        // Power iteration, starting from the channel with the largest variance.
+        int start = 0;
+        for (int c = 1; c < 4; ++c)
+        {
+            if (covariance[c][c] > covariance[start][start])
+            {
+                start = c;
+            }
+        }
+
+        float axis[4] = { covariance[0][start], covariance[1][start], covariance[2][start], covariance[3][start] };
+        float length = 0.0f;
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {};
+            for (int c = 0; c < 4; ++c)
+            {
+                for (int d = 0; d < 4; ++d)
+                {
+                    next[c] += covariance[c][d] * axis[d];
+                }
+            }
+
+            length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+            if (length < 1e-8f)
+            {
+                break;
+            }
+            for (int c = 0; c < 4; ++c)
+            {
+                axis[c] = next[c] / length;
+            }
+        }
+
+        // Solid block, both endpoints at the mean.
+        if (length < 1e-8f)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                pEndpoint0[c] = pEndpoint1[c] = mean[c];
+            }
+            return true;
+        }
+
+        float minT = FLT_MAX;
+        float maxT = -FLT_MAX;
+        for (int i = 0; i < 16; ++i)
+        {
+            if (pMask[i] == 0.0f)
+            {
+                continue;
+            }
+
+            float t = 0.0f;
+            for (int c = 0; c < 4; ++c)
+            {
+                t += (block.Channels[c][i] - mean[c]) * axis[c];
+            }
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+
+        for (int c = 0; c < 4; ++c)
+        {
+            pEndpoint0[c] = std::min(std::max(mean[c] + axis[c] * minT, 0.0f), 255.0f);
+            pEndpoint1[c] = std::min(std::max(mean[c] + axis[c] * maxT, 0.0f), 255.0f);
+        }
+        return true;
+    }
+
+    /**
+     * Least squares endpoints for the given indices, pIndexWeights[k] is the
+     * fraction of endpoint 1 in palette entry k.
+     * @returns false if the system is singular (all texels use the same weight).
+     */
+    bool RefineEndpoints(const BlockPixels& block, const float* pMask, const uint8_t* pIndices, const float* pIndexWeights,
+        float* pEndpoint0, float* pEndpoint1)
+    {
+        float aa = 0.0f;
+        float ab = 0.0f;
+        float bb = 0.0f;
+        __m128 ax = _mm_setzero_ps();
+        __m128 bx = _mm_setzero_ps();
+
+        for (int i = 0; i < 16; ++i)
+        {
+            if (pMask[i] == 0.0f)
+            {
+                continue;
+            }
+
+            float b = pIndexWeights[pIndices[i]];
+            float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+
+            __m128 texel = _mm_setr_ps(block.Channels[0][i], block.Channels[1][i], block.Channels[2][i], block.Channels[3][i]);
+            ax = _mm_add_ps(ax, _mm_mul_ps(texel, _mm_set1_ps(a)));
+            bx = _mm_add_ps(bx, _mm_mul_ps(texel, _mm_set1_ps(b)));
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+
+        __m128 inverse = _mm_set1_ps(1.0f / determinant);
+        __m128 zero = _mm_setzero_ps();
+        __m128 maxValue = _mm_set1_ps(255.0f);
+        __m128 endpoint0 = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ax, _mm_set1_ps(bb)), _mm_mul_ps(bx, _mm_set1_ps(ab))), inverse);
+        __m128 endpoint1 = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(bx, _mm_set1_ps(aa)), _mm_mul_ps(ax, _mm_set1_ps(ab))), inverse);
+        _mm_storeu_ps(pEndpoint0, _mm_min_ps(_mm_max_ps(endpoint0, zero), maxValue));
+        _mm_storeu_ps(pEndpoint1, _mm_min_ps(_mm_max_ps(endpoint1, zero), maxValue));
+        return true;
+    }
+
+    void WriteUInt16(uint8_t* pDest, uint32_t value)
+    {
+        pDest[0] = static_cast<uint8_t>(value);
+        pDest[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    uint32_t ReadUInt16(const uint8_t* pSrc)
+    {
+        return pSrc[0] | (uint32_t(pSrc[1]) << 8);
+    }
+
+    int RoundToInt(float value)
+    {
+        return static_cast<int>(value + 0.5f);
+    }
+
+    //
+    // BC1 (and the color part of BC3)
+    //
+
+    uint16_t QuantizeRGB565(const float* pColor)
+    {
+        uint32_t r = std::min(RoundToInt(pColor[0] * (31.0f / 255.0f)), 31);
+        uint32_t g = std::min(RoundToInt(pColor[1] * (63.0f / 255.0f)), 63);
+        uint32_t b = std::min(RoundToInt(pColor[2] * (31.0f / 255.0f)), 31);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void ExpandRGB565(uint32_t color, uint8_t* pColor)
+    {
+        uint32_t r = (color >> 11) & 31;
+        uint32_t g = (color >> 5) & 63;
+        uint32_t b = color & 31;
+        pColor[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+        pColor[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+        pColor[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+        pColor[3] = 255;
+    }
+
+    // The palette of a color block, shared by the encoder and the decoder so they agree exactly.
+    void GetBC1Palette(uint32_t color0, uint32_t color1, bool fourColors, uint8_t (*pPalette)[4])
+    {
+        ExpandRGB565(color0, pPalette[0]);
+        ExpandRGB565(color1, pPalette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            uint32_t a = pPalette[0][c];
+            uint32_t b = pPalette[1][c];
+            if (fourColors)
+            {
+                pPalette[2][c] = static_cast<uint8_t>((2 * a + b + 1) / 3);
+                pPalette[3][c] = static_cast<uint8_t>((a + 2 * b + 1) / 3);
+            }
+            else
+            {
+                pPalette[2][c] = static_cast<uint8_t>((a + b + 1) / 2);
+                pPalette[3][c] = 0;
+            }
+        }
+        pPalette[2][3] = 255;
+        pPalette[3][3] = fourColors ? 255 : 0;
+    }
+
+    /**
+     * @param allowTransparent Use the three color mode for blocks with alpha < 128.
+     * Without it the block is always encoded in four color mode, as BC3 requires.
+     */
+    void EncodeBC1Color(const BlockPixels& block, bool allowTransparent, uint8_t* pBlock)
+    {
+        static const float FourColorWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        static const float ThreeColorWeights[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+        const float weights[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+
+        float mask[16];
+        bool threeColors = false;
+        for (int i = 0; i < 16; ++i)
+        {
+            bool transparent = allowTransparent && block.Channels[3][i] < 128.0f;
+            mask[i] = transparent ? 0.0f : 1.0f;
+            threeColors |= transparent;
+        }
+
+        float endpoint0[4];
+        float endpoint1[4];
+        if (!ComputeEndpoints(block, mask, weights, endpoint0, endpoint1))
+        {
+            // Fully transparent.
+            WriteUInt16(pBlock, 0);
+            WriteUInt16(pBlock + 2, 0);
+            memset(pBlock + 4, 0xFF, 4);
+            return;
+        }
+
+        const float* pIndexWeights = threeColors ? ThreeColorWeights : FourColorWeights;
+        const uint32_t numEntries = threeColors ? 3 : 4;
+
+        float bestError = FLT_MAX;
+        uint32_t color0 = 0;
+        uint32_t color1 = 0;
+        uint8_t indices[16] = {};
+        for (int iteration = 0; iteration < 3; ++iteration)
+        {
+            uint32_t quantized0 = QuantizeRGB565(endpoint0);
+            uint32_t quantized1 = QuantizeRGB565(endpoint1);
+
+            uint8_t palette[4][4];
+            GetBC1Palette(quantized0, quantized1, !threeColors, palette);
+            float floatPalette[4][4];
+            for (uint32_t k = 0; k < 4; ++k)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    floatPalette[k][c] = palette[k][c];
+                }
+            }
+
+            uint8_t candidate[16];
+            float error = FitIndices(block, floatPalette, numEntries, weights, mask, candidate);
+            if (error < bestError)
+            {
+                bestError = error;
+                color0 = quantized0;
+                color1 = quantized1;
+                memcpy(indices, candidate, sizeof(indices));
+            }
+
+            if (error == 0.0f || !RefineEndpoints(block, mask, candidate, pIndexWeights, endpoint0, endpoint1))
+            {
+                break;
+            }
+        }
+
+        // The order of the endpoints selects the mode: color0 > color1 is four colors.
+        if (threeColors)
+        {
+            if (color0 > color1)
+            {
+                std::swap(color0, color1);
+                for (int i = 0; i < 16; ++i)
+                {
+                    indices[i] = indices[i] < 2 ? indices[i] ^ 1 : indices[i];
+                }
+            }
+            for (int i = 0; i < 16; ++i)
+            {
+                if (mask[i] == 0.0f)
+                {
+                    indices[i] = 3;
+                }
+            }
+        }
+        else if (color0 < color1)
+        {
+            std::swap(color0, color1);
+            for (int i = 0; i < 16; ++i)
+            {
+                indices[i] ^= 1;
+            }
+        }
+        else if (color0 == color1)
+        {
+            memset(indices, 0, sizeof(indices));
+        }
+
+        uint32_t packedIndices = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            packedIndices |= uint32_t(indices[i]) << (i * 2);
+        }
+
+        WriteUInt16(pBlock, color0);
+        WriteUInt16(pBlock + 2, color1);
+        WriteUInt16(pBlock + 4, packedIndices & 0xFFFF);
+        WriteUInt16(pBlock + 6, packedIndices >> 16);
+    }
+
+    void DecodeBC1Color(const uint8_t* pBlock, bool allowTransparent, uint8_t* pPixels)
+    {
+        uint32_t color0 = ReadUInt16(pBlock);
+        uint32_t color1 = ReadUInt16(pBlock + 2);
+        uint32_t indices = ReadUInt16(pBlock + 4) | (ReadUInt16(pBlock + 6) << 16);
+
+        uint8_t palette[4][4];
+        GetBC1Palette(color0, color1, !allowTransparent || color0 > color1, palette);
+        for (int i = 0; i < 16; ++i)
+        {
+            memcpy(pPixels + i * 4, palette[(indices >> (i * 2)) & 3], 4);
+        }
+    }
+
+    //
+    // BC4 (and the alpha part of BC3, the channels of BC5)
+    //
+
+    void GetBC4Palette(uint32_t value0, uint32_t value1, uint8_t* pPalette)
+    {
+        pPalette[0] = static_cast<uint8_t>(value0);
+        pPalette[1] = static_cast<uint8_t>(value1);
+        if (value0 > value1)
+        {
+            for (uint32_t k = 1; k < 7; ++k)
+            {
+                pPalette[k + 1] = static_cast<uint8_t>(((7 - k) * value0 + k * value1 + 3) / 7);
+            }
+        }
+        else
+        {
+            for (uint32_t k = 1; k < 5; ++k)
+            {
+                pPalette[k + 1] = static_cast<uint8_t>(((5 - k) * value0 + k * value1 + 2) / 5);
+            }
+            pPalette[6] = 0;
+            pPalette[7] = 255;
+        }
+    }
+
+    float FitBC4Indices(const BlockPixels& block, uint32_t channel, uint32_t value0, uint32_t value1, uint8_t* pIndices)
+    {
+        static const float Mask[16] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+        float weights[4] = {};
+        weights[channel] = 1.0f;
+
+        uint8_t palette[8];
+        GetBC4Palette(value0, value1, palette);
+        float floatPalette[8][4] = {};
+        for (uint32_t k = 0; k < 8; ++k)
+        {
+            floatPalette[k][channel] = palette[k];
+        }
+        return FitIndices(block, floatPalette, 8, weights, Mask, pIndices);
+    }
+
+    void EncodeBC4Channel(const BlockPixels& block, uint32_t channel, uint8_t* pBlock)
+    {
+        static const float Mask[16] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+        static const float EightValueWeights[8] = { 0.0f, 1.0f, 1.0f / 7, 2.0f / 7, 3.0f / 7, 4.0f / 7, 5.0f / 7, 6.0f / 7 };
+
+        const float* pValues = block.Channels[channel];
+        float minValue = 255.0f;
+        float maxValue = 0.0f;
+        float minInner = 255.0f;
+        float maxInner = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            minValue = std::min(minValue, pValues[i]);
+            maxValue = std::max(maxValue, pValues[i]);
+            if (pValues[i] != 0.0f && pValues[i] != 255.0f)
+            {
+                minInner = std::min(minInner, pValues[i]);
+                maxInner = std::max(maxInner, pValues[i]);
+            }
+        }
+
+        uint32_t value0 = RoundToInt(maxValue);
+        uint32_t value1 = RoundToInt(minValue);
+        uint8_t indices[16] = {};
+        float bestError = 0.0f;
+
+        if (value0 > value1)
+        {
+            // Eight value mode, value0 > value1.
+            float endpoints[2][4] = {};
+            endpoints[0][channel] = maxValue;
+            endpoints[1][channel] = minValue;
+            bestError = FLT_MAX;
+
+            for (int iteration = 0; iteration < 2; ++iteration)
+            {
+                uint32_t candidate0 = RoundToInt(endpoints[0][channel]);
+                uint32_t candidate1 = RoundToInt(endpoints[1][channel]);
+                if (candidate0 <= candidate1)
+                {
+                    break;
+                }
+
+                uint8_t candidate[16];
+                float error = FitBC4Indices(block, channel, candidate0, candidate1, candidate);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    value0 = candidate0;
+                    value1 = candidate1;
+                    memcpy(indices, candidate, sizeof(indices));
+                }
+
+                if (error == 0.0f || !RefineEndpoints(block, Mask, candidate, EightValueWeights, endpoints[0], endpoints[1]))
+                {
+                    break;
+                }
+            }
+
+            // Six value mode, which has exact 0 and 255, for blocks with those values.
+            if (bestError > 0.0f && (minValue == 0.0f || maxValue == 255.0f))
+            {
+                uint32_t candidate0 = minInner <= maxInner ? RoundToInt(minInner) : 0;
+                uint32_t candidate1 = minInner <= maxInner ? RoundToInt(maxInner) : 0;
+
+                uint8_t candidate[16];
+                float error = FitBC4Indices(block, channel, candidate0, candidate1, candidate);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    value0 = candidate0;
+                    value1 = candidate1;
+                    memcpy(indices, candidate, sizeof(indices));
+                }
+            }
+        }
+        // Otherwise a constant block, which the six value mode stores exactly with index 0.
+
+        pBlock[0] = static_cast<uint8_t>(value0);
+        pBlock[1] = static_cast<uint8_t>(value1);
+        uint64_t packedIndices = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            packedIndices |= uint64_t(indices[i]) << (i * 3);
+        }
+        for (int b = 0; b < 6; ++b)
+        {
+            pBlock[2 + b] = static_cast<uint8_t>(packedIndices >> (b * 8));
+        }
+    }
+
+    void DecodeBC4Channel(const uint8_t* pBlock, uint32_t channel, uint8_t* pPixels)
+    {
+        uint8_t palette[8];
+        GetBC4Palette(pBlock[0], pBlock[1], palette);
+
+        uint64_t packedIndices = 0;
+        for (int b = 0; b < 6; ++b)
+        {
+            packedIndices |= uint64_t(pBlock[2 + b]) << (b * 8);
+        }
+        for (int i = 0; i < 16; ++i)
+        {
+            pPixels[i * 4 + channel] = palette[(packedIndices >> (i * 3)) & 7];
+        }
+    }
+
+    //
+    // BC7
+    //
+
+    // Two subset partitions, bit i is the subset of texel i.
+    const uint16_t BC7Partitions2[64] =
+    {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+        0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+        0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+        0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+        0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+    };
+
+    // Anchor texel of subset 1 for the two subset partitions, its index has an implicit 0 MSB.
+    const uint8_t BC7Anchors2[64] =
+    {
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15,  2,  8,  2,  2,  8,  8, 15,
+         2,  8,  2,  2,  8,  8,  2,  2,
+        15, 15,  6,  8,  2,  8, 15, 15,
+         2,  8,  2,  2,  2, 15, 15,  6,
+         6,  2,  6,  8, 15, 15,  2,  2,
+        15, 15, 15, 15, 15,  2,  2, 15,
+    };
+
+    const uint8_t BC7Weights2[4] = { 0, 21, 43, 64 };
+    const uint8_t BC7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    const uint8_t BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    enum class BC7PBits
+    {
+        None,
+        // One P-bit shared by the two endpoints of a subset.
+        PerSubset,
+        PerEndpoint,
+    };
+
+    struct BC7ModeInfo
+    {
+        uint32_t Mode;
+        uint32_t NumSubsets;
+        uint32_t PartitionBits;
+        uint32_t ColorBits;
+        // 0 for opaque modes.
+        uint32_t AlphaBits;
+        BC7PBits PBits;
+        uint32_t IndexBits;
+    };
+
+    const BC7ModeInfo BC7Mode1 = { 1, 2, 6, 6, 0, BC7PBits::PerSubset, 3 };
+    const BC7ModeInfo BC7Mode3 = { 3, 2, 6, 7, 0, BC7PBits::PerEndpoint, 2 };
+    const BC7ModeInfo BC7Mode6 = { 6, 1, 0, 7, 7, BC7PBits::PerEndpoint, 4 };
+
+    const uint8_t* GetBC7Weights(uint32_t indexBits)
+    {
+        return indexBits == 2 ? BC7Weights2 : indexBits == 3 ? BC7Weights3 : BC7Weights4;
+    }
+
+    uint32_t GetBC7Subset(const BC7ModeInfo& mode, uint32_t partition, uint32_t texel)
+    {
+        return mode.NumSubsets == 1 ? 0 : (BC7Partitions2[partition] >> texel) & 1;
+    }
+
+    uint32_t GetBC7Anchor(const BC7ModeInfo& mode, uint32_t partition, uint32_t subset)
+    {
+        return subset == 0 || mode.NumSubsets == 1 ? 0 : BC7Anchors2[partition];
+    }
+
+    bool IsBC7Anchor(const BC7ModeInfo& mode, uint32_t partition, uint32_t texel)
+    {
+        return texel == 0 || (mode.NumSubsets == 2 && texel == BC7Anchors2[partition]);
+    }
+
+    // Expand a quantized endpoint channel with its P-bit to 8 bits by replicating the high bits.
+    uint8_t ExpandBC7Channel(uint32_t value, uint32_t bits, uint32_t pbit, bool hasPBit)
+    {
+        if (hasPBit)
+        {
+            value = (value << 1) | pbit;
+            ++bits;
+        }
+        value <<= 8 - bits;
+        return static_cast<uint8_t>(value | (value >> bits));
+    }
+
+    struct BC7Endpoint
+    {
+        uint8_t Quantized[4];
+        uint8_t PBit;
+        uint8_t Expanded[4];
+    };
+
+    void ExpandBC7Endpoint(const BC7ModeInfo& mode, BC7Endpoint& endpoint)
+    {
+        const bool hasPBit = mode.PBits != BC7PBits::None;
+        for (int c = 0; c < 3; ++c)
+        {
+            endpoint.Expanded[c] = ExpandBC7Channel(endpoint.Quantized[c], mode.ColorBits, endpoint.PBit, hasPBit);
+        }
+        endpoint.Expanded[3] = mode.AlphaBits ? ExpandBC7Channel(endpoint.Quantized[3], mode.AlphaBits, endpoint.PBit, hasPBit) : 255;
+    }
+
+    // Quantize an endpoint with the given P-bit, returns the squared error of the expanded endpoint.
+    float QuantizeBC7Endpoint(const BC7ModeInfo& mode, const float* pValue, uint32_t pbit, BC7Endpoint& endpoint)
+    {
+        const bool hasPBit = mode.PBits != BC7PBits::None;
+        endpoint.PBit = static_cast<uint8_t>(pbit);
+
+        for (int c = 0; c < 4; ++c)
+        {
+            uint32_t bits = c < 3 ? mode.ColorBits : mode.AlphaBits;
+            if (bits == 0)
+            {
+                endpoint.Quantized[c] = 0;
+                continue;
+            }
+
+            int maxValue = (1 << bits) - 1;
+            int quantized;
+            if (hasPBit)
+            {
+                // Nearest value of the bits + 1 lattice whose LSB is the P-bit.
+                float scaled = pValue[c] / 255.0f * float((1 << (bits + 1)) - 1);
+                quantized = static_cast<int>(std::floor((scaled - pbit) * 0.5f + 0.5f));
+            }
+            else
+            {
+                quantized = RoundToInt(pValue[c] / 255.0f * maxValue);
+            }
+            endpoint.Quantized[c] = static_cast<uint8_t>(std::min(std::max(quantized, 0), maxValue));
+        }
+
+        ExpandBC7Endpoint(mode, endpoint);
+
+        float error = 0.0f;
+        for (int c = 0; c < (mode.AlphaBits ? 4 : 3); ++c)
+        {
+            float difference = endpoint.Expanded[c] - pValue[c];
+            error += difference * difference;
+        }
+        return error;
+    }
+
+    // Quantize the endpoints of a subset with the P-bits that give the lowest error.
+    void QuantizeBC7Subset(const BC7ModeInfo& mode, const float* pEndpoint0, const float* pEndpoint1, BC7Endpoint* pEndpoints)
+    {
+        switch (mode.PBits)
+        {
+        case BC7PBits::None:
+            QuantizeBC7Endpoint(mode, pEndpoint0, 0, pEndpoints[0]);
+            QuantizeBC7Endpoint(mode, pEndpoint1, 0, pEndpoints[1]);
+            break;
+        case BC7PBits::PerSubset:
+        {
+            BC7Endpoint candidates[2][2];
+            float error0 = QuantizeBC7Endpoint(mode, pEndpoint0, 0, candidates[0][0]) + QuantizeBC7Endpoint(mode, pEndpoint1, 0, candidates[0][1]);
+            float error1 = QuantizeBC7Endpoint(mode, pEndpoint0, 1, candidates[1][0]) + QuantizeBC7Endpoint(mode, pEndpoint1, 1, candidates[1][1]);
+            int best = error1 < error0 ? 1 : 0;
+            pEndpoints[0] = candidates[best][0];
+            pEndpoints[1] = candidates[best][1];
+            break;
+        }
+        case BC7PBits::PerEndpoint:
+            for (int e = 0; e < 2; ++e)
+            {
+                const float* pValue = e == 0 ? pEndpoint0 : pEndpoint1;
+                BC7Endpoint candidate;
+                float error0 = QuantizeBC7Endpoint(mode, pValue, 0, pEndpoints[e]);
+                float error1 = QuantizeBC7Endpoint(mode, pValue, 1, candidate);
+                if (error1 < error0)
+                {
+                    pEndpoints[e] = candidate;
+                }
+            }
+            break;
+        }
+    }
+
+    void GetBC7Palette(const BC7ModeInfo& mode, const BC7Endpoint* pEndpoints, uint8_t (*pPalette)[4])
+    {
+        const uint8_t* pWeights = GetBC7Weights(mode.IndexBits);
+        for (uint32_t k = 0; k < (1u << mode.IndexBits); ++k)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                uint32_t weight = pWeights[k];
+                pPalette[k][c] = static_cast<uint8_t>(((64 - weight) * pEndpoints[0].Expanded[c] + weight * pEndpoints[1].Expanded[c] + 32) >> 6);
+            }
+        }
+    }
+
+    struct BC7Block
+    {
+        const BC7ModeInfo* pMode;
+        uint32_t Partition;
+        BC7Endpoint Endpoints[2][2];
+        uint8_t Indices[16];
+        float Error;
+    };
+
+    float EncodeBC7Subset(const BlockPixels& block, const BC7ModeInfo& mode, const float* pMask, uint32_t iterations,
+        BC7Endpoint* pEndpoints, uint8_t* pIndices)
+    {
+        const float weights[4] = { 1.0f, 1.0f, 1.0f, mode.AlphaBits ? 1.0f : 0.0f };
+        const uint32_t numEntries = 1u << mode.IndexBits;
+
+        float indexWeights[16];
+        const uint8_t* pWeights = GetBC7Weights(mode.IndexBits);
+        for (uint32_t k = 0; k < numEntries; ++k)
+        {
+            indexWeights[k] = pWeights[k] / 64.0f;
+        }
+
+        float endpoint0[4];
+        float endpoint1[4];
+        if (!ComputeEndpoints(block, pMask, weights, endpoint0, endpoint1))
+        {
+            return 0.0f;
+        }
+
+        float bestError = FLT_MAX;
+        for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+        {
+            BC7Endpoint endpoints[2];
+            QuantizeBC7Subset(mode, endpoint0, endpoint1, endpoints);
+
+            uint8_t palette[16][4];
+            GetBC7Palette(mode, endpoints, palette);
+            float floatPalette[16][4];
+            for (uint32_t k = 0; k < numEntries; ++k)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    floatPalette[k][c] = palette[k][c];
+                }
+            }
+
+            uint8_t indices[16];
+            float error = FitIndices(block, floatPalette, numEntries, weights, pMask, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                pEndpoints[0] = endpoints[0];
+                pEndpoints[1] = endpoints[1];
+                memcpy(pIndices, indices, sizeof(indices));
+            }
+
+            if (error == 0.0f || !RefineEndpoints(block, pMask, indices, indexWeights, endpoint0, endpoint1))
+            {
+                break;
+            }
+        }
+        return bestError;
+    }
+
+    /**
+     * Encode the block with the given mode and partition. Stops early once the
+     * error reaches maxError, the result is only complete if its Error is below it.
+     */
+    void EncodeBC7Candidate(const BlockPixels& block, const BC7ModeInfo& mode, uint32_t partition, uint32_t iterations,
+        float maxError, BC7Block& result)
+    {
+        result.pMode = &mode;
+        result.Partition = partition;
+        result.Error = 0.0f;
+        memset(result.Endpoints, 0, sizeof(result.Endpoints));
+
+        for (uint32_t subset = 0; subset < mode.NumSubsets; ++subset)
+        {
+            float mask[16];
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                mask[i] = GetBC7Subset(mode, partition, i) == subset ? 1.0f : 0.0f;
+            }
+
+            uint8_t indices[16];
+            result.Error += EncodeBC7Subset(block, mode, mask, iterations, result.Endpoints[subset], indices);
+            if (result.Error >= maxError)
+            {
+                return;
+            }
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                if (mask[i] != 0.0f)
+                {
+                    result.Indices[i] = indices[i];
+                }
+            }
+        }
+    }
+
+    /**
+     * Squared distance of a set of RGB texels to their principal axis, from the
+     * sums of the texels (pMoments[0..2]) and of their products (rr, rg, rb, gg, gb, bb).
+     */
+    float EstimateLineFitError(const float* pMoments, float count)
+    {
+        if (count == 0.0f)
+        {
+            return 0.0f;
+        }
+
+        const float mean[3] = { pMoments[0] / count, pMoments[1] / count, pMoments[2] / count };
+        const float scatter[3][3] =
+        {
+            { pMoments[3] - pMoments[0] * mean[0], pMoments[4] - pMoments[0] * mean[1], pMoments[5] - pMoments[0] * mean[2] },
+            { pMoments[4] - pMoments[1] * mean[0], pMoments[6] - pMoments[1] * mean[1], pMoments[7] - pMoments[1] * mean[2] },
+            { pMoments[5] - pMoments[2] * mean[0], pMoments[7] - pMoments[2] * mean[1], pMoments[8] - pMoments[2] * mean[2] },
+        };
+        const float trace = scatter[0][0] + scatter[1][1] + scatter[2][2];
+
+        // Largest eigenvalue by power iteration.
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        float eigenvalue = 0.0f;
+        for (int iteration = 0; iteration < 4; ++iteration)
+        {
+            float next[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                next[c] = scatter[c][0] * axis[0] + scatter[c][1] * axis[1] + scatter[c][2] * axis[2];
+            }
+
+            eigenvalue = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+            if (eigenvalue < 1e-8f)
+            {
+                return std::max(trace, 0.0f);
+            }
+            for (int c = 0; c < 3; ++c)
+            {
+                axis[c] = next[c] / eigenvalue;
+            }
+        }
+        return std::max(trace - eigenvalue, 0.0f);
+    }
+
+    // Order the two subset partitions by how well each subset fits a line in RGB.
+    void RankBC7Partitions(const BlockPixels& block, uint32_t* pPartitions, uint32_t count)
+    {
+        // Per texel r, g, b, rr, rg, rb, gg, gb, bb so the sums of each subset are cheap.
+        float moments[16][9];
+        float total[9] = {};
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            float r = block.Channels[0][i];
+            float g = block.Channels[1][i];
+            float b = block.Channels[2][i];
+            const float texel[9] = { r, g, b, r * r, r * g, r * b, g * g, g * b, b * b };
+            for (int m = 0; m < 9; ++m)
+            {
+                moments[i][m] = texel[m];
+                total[m] += texel[m];
+            }
+        }
+
+        float estimates[64];
+        for (uint32_t partition = 0; partition < 64; ++partition)
+        {
+            float subset1[9] = {};
+            float count1 = 0.0f;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                if ((BC7Partitions2[partition] >> i) & 1)
+                {
+                    for (int m = 0; m < 9; ++m)
+                    {
+                        subset1[m] += moments[i][m];
+                    }
+                    count1 += 1.0f;
+                }
+            }
+
+            float subset0[9];
+            for (int m = 0; m < 9; ++m)
+            {
+                subset0[m] = total[m] - subset1[m];
+            }
+            estimates[partition] = EstimateLineFitError(subset0, 16.0f - count1) + EstimateLineFitError(subset1, count1);
+        }
+
+        uint32_t order[64];
+        for (uint32_t partition = 0; partition < 64; ++partition)
+        {
+            order[partition] = partition;
+        }
+        std::partial_sort(order, order + count, order + 64,
+            [&estimates](uint32_t a, uint32_t b) { return estimates[a] < estimates[b]; });
+        memcpy(pPartitions, order, count * sizeof(uint32_t));
+    }
+
+    // Writes the bits of a block from the least significant bit of byte 0 on.
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(uint8_t* pData)
+            : m_pData(pData)
+            , m_Position(0)
+        {
+            memset(m_pData, 0, 16);
+        }
+
+        void Write(uint32_t value, uint32_t bits)
+        {
+            for (uint32_t b = 0; b < bits; ++b, ++m_Position)
+            {
+                m_pData[m_Position >> 3] |= static_cast<uint8_t>(((value >> b) & 1) << (m_Position & 7));
+            }
+        }
+
+    private:
+        uint8_t* m_pData;
+        uint32_t m_Position;
+    };
+
+    class BitReader
+    {
+    public:
+        explicit BitReader(const uint8_t* pData)
+            : m_pData(pData)
+            , m_Position(0)
+        {}
+
+        uint32_t Read(uint32_t bits)
+        {
+            uint32_t value = 0;
+            for (uint32_t b = 0; b < bits; ++b, ++m_Position)
+            {
+                value |= uint32_t((m_pData[m_Position >> 3] >> (m_Position & 7)) & 1) << b;
+            }
+            return value;
+        }
+
+    private:
+        const uint8_t* m_pData;
+        uint32_t m_Position;
+    };
+
+    void WriteBC7Block(const BC7Block& block, uint8_t* pDest)
+    {
+        const BC7ModeInfo& mode = *block.pMode;
+        const uint32_t maxIndex = (1u << mode.IndexBits) - 1;
+
+        BC7Endpoint endpoints[2][2];
+        uint8_t indices[16];
+        memcpy(endpoints, block.Endpoints, sizeof(endpoints));
+        memcpy(indices, block.Indices, sizeof(indices));
+
+        // The MSB of the anchor indices is implicitly 0, swap the endpoints of subsets where it is not.
+        for (uint32_t subset = 0; subset < mode.NumSubsets; ++subset)
+        {
+            if (indices[GetBC7Anchor(mode, block.Partition, subset)] <= maxIndex / 2)
+            {
+                continue;
+            }
+
+            std::swap(endpoints[subset][0], endpoints[subset][1]);
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                if (GetBC7Subset(mode, block.Partition, i) == subset)
+                {
+                    indices[i] = static_cast<uint8_t>(maxIndex - indices[i]);
+                }
+            }
+        }
+
+        BitWriter writer(pDest);
+        writer.Write(1u << mode.Mode, mode.Mode + 1);
+        writer.Write(block.Partition, mode.PartitionBits);
+
+        for (int c = 0; c < 4; ++c)
+        {
+            uint32_t bits = c < 3 ? mode.ColorBits : mode.AlphaBits;
+            for (uint32_t subset = 0; bits && subset < mode.NumSubsets; ++subset)
+            {
+                writer.Write(endpoints[subset][0].Quantized[c], bits);
+                writer.Write(endpoints[subset][1].Quantized[c], bits);
+            }
+        }
+
+        for (uint32_t subset = 0; subset < mode.NumSubsets; ++subset)
+        {
+            if (mode.PBits == BC7PBits::PerEndpoint)
+            {
+                writer.Write(endpoints[subset][0].PBit, 1);
+                writer.Write(endpoints[subset][1].PBit, 1);
+            }
+            else if (mode.PBits == BC7PBits::PerSubset)
+            {
+                writer.Write(endpoints[subset][0].PBit, 1);
+            }
+        }
+
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            writer.Write(indices[i], mode.IndexBits - (IsBC7Anchor(mode, block.Partition, i) ? 1 : 0));
+        }
+    }
+
+    //
+    // Texture level
+    //
+
+    void EncodeBlock(TextureFormat format, const uint8_t* pPixels, const BlockCompressionSettings& settings, uint8_t* pBlock)
+    {
+        switch (format)
+        {
+        case TextureFormat::BC1UNorm:
+        case TextureFormat::BC1UNormSRGB:
+            EncodeBC1Block(pPixels, pBlock);
+            break;
+        case TextureFormat::BC3UNorm:
+        case TextureFormat::BC3UNormSRGB:
+            EncodeBC3Block(pPixels, pBlock);
+            break;
+        case TextureFormat::BC4UNorm:
+            EncodeBC4Block(pPixels, pBlock);
+            break;
+        case TextureFormat::BC5UNorm:
+            EncodeBC5Block(pPixels, pBlock);
+            break;
+        case TextureFormat::BC7UNorm:
+        case TextureFormat::BC7UNormSRGB:
+            EncodeBC7Block(pPixels, settings.Quality, pBlock);
+            break;
+        default:
+            assert(false && "Not a block compressed format.");
+        }
+    }
+
+    bool DecodeBlock(TextureFormat format, const uint8_t* pBlock, uint8_t* pPixels)
+    {
+        switch (format)
+        {
+        case TextureFormat::BC1UNorm:
+        case TextureFormat::BC1UNormSRGB:
+            DecodeBC1Block(pBlock, pPixels);
+            return true;
+        case TextureFormat::BC3UNorm:
+        case TextureFormat::BC3UNormSRGB:
+            DecodeBC3Block(pBlock, pPixels);
+            return true;
+        case TextureFormat::BC4UNorm:
+            DecodeBC4Block(pBlock, pPixels);
+            return true;
+        case TextureFormat::BC5UNorm:
+            DecodeBC5Block(pBlock, pPixels);
+            return true;
+        case TextureFormat::BC7UNorm:
+        case TextureFormat::BC7UNormSRGB:
+            return DecodeBC7Block(pBlock, pPixels);
+        default:
+            return false;
+        }
+    }
+
+    bool IsRGBA8(TextureFormat format)
+    {
+        return format == TextureFormat::RGBA8UNorm || format == TextureFormat::RGBA8UNormSRGB;
+    }
+}
+
+void EncodeBC1Block(const uint8_t* pPixels, uint8_t* pBlock)
+{
+    BlockPixels block;
+    LoadBlock(pPixels, block);
+    EncodeBC1Color(block, true, pBlock);
+}
+
+void EncodeBC3Block(const uint8_t* pPixels, uint8_t* pBlock)
+{
+    BlockPixels block;
+    LoadBlock(pPixels, block);
+    EncodeBC4Channel(block, 3, pBlock);
+    EncodeBC1Color(block, false, pBlock + 8);
+}
+
+void EncodeBC4Block(const uint8_t* pPixels, uint8_t* pBlock)
+{
+    BlockPixels block;
+    LoadBlock(pPixels, block);
+    EncodeBC4Channel(block, 0, pBlock);
+}
+
+void EncodeBC5Block(const uint8_t* pPixels, uint8_t* pBlock)
+{
+    BlockPixels block;
+    LoadBlock(pPixels, block);
+    EncodeBC4Channel(block, 0, pBlock);
+    EncodeBC4Channel(block, 1, pBlock + 8);
+}
+
+void EncodeBC7Block(const uint8_t* pPixels, BC7Quality quality, uint8_t* pBlock)
+{
+    BlockPixels block;
+    LoadBlock(pPixels, block);
+
+    const uint32_t iterations = quality == BC7Quality::High ? 4 : 2;
+
+    BC7Block best;
+    EncodeBC7Candidate(block, BC7Mode6, 0, iterations, FLT_MAX, best);
+
+    bool opaque = true;
+    for (int i = 0; i < 16; ++i)
+    {
+        opaque &= block.Channels[3][i] == 255.0f;
+    }
+
+    // The two subset modes have no alpha.
+    if (quality != BC7Quality::Fast && opaque && best.Error > 0.0f)
+    {
+        uint32_t partitions[64];
+        uint32_t numPartitions = quality == BC7Quality::Normal ? 8 : 64;
+        RankBC7Partitions(block, partitions, numPartitions);
+
+        for (const BC7ModeInfo* pMode : { &BC7Mode1, &BC7Mode3 })
+        {
+            for (uint32_t p = 0; p < numPartitions; ++p)
+            {
+                BC7Block candidate;
+                EncodeBC7Candidate(block, *pMode, partitions[p], iterations, best.Error, candidate);
+                if (candidate.Error < best.Error)
+                {
+                    best = candidate;
+                }
+            }
+        }
+    }
+
+    WriteBC7Block(best, pBlock);
+}
+
+void DecodeBC1Block(const uint8_t* pBlock, uint8_t* pPixels)
+{
+    DecodeBC1Color(pBlock, true, pPixels);
+}
+
+void DecodeBC3Block(const uint8_t* pBlock, uint8_t* pPixels)
+{
+    DecodeBC1Color(pBlock + 8, false, pPixels);
+    DecodeBC4Channel(pBlock, 3, pPixels);
+}
+
+void DecodeBC4Block(const uint8_t* pBlock, uint8_t* pPixels)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        pPixels[i * 4 + 1] = 0;
+        pPixels[i * 4 + 2] = 0;
+        pPixels[i * 4 + 3] = 255;
+    }
+    DecodeBC4Channel(pBlock, 0, pPixels);
+}
+
+void DecodeBC5Block(const uint8_t* pBlock, uint8_t* pPixels)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        pPixels[i * 4 + 2] = 0;
+        pPixels[i * 4 + 3] = 255;
+    }
+    DecodeBC4Channel(pBlock, 0, pPixels);
+    DecodeBC4Channel(pBlock + 8, 1, pPixels);
+}
+
+bool DecodeBC7Block(const uint8_t* pBlock, uint8_t* pPixels)
+{
+    BitReader reader(pBlock);
+
+    uint32_t modeIndex = 0;
+    while (modeIndex < 8 && reader.Read(1) == 0)
+    {
+        ++modeIndex;
+    }
+
+    const BC7ModeInfo* pMode = modeIndex == 1 ? &BC7Mode1 : modeIndex == 3 ? &BC7Mode3 : modeIndex == 6 ? &BC7Mode6 : nullptr;
+    if (!pMode)
+    {
+        memset(pPixels, 0, 64);
+        return false;
+    }
+    const BC7ModeInfo& mode = *pMode;
+
+    uint32_t partition = reader.Read(mode.PartitionBits);
+
+    BC7Endpoint endpoints[2][2] = {};
+    for (int c = 0; c < 4; ++c)
+    {
+        uint32_t bits = c < 3 ? mode.ColorBits : mode.AlphaBits;
+        for (uint32_t subset = 0; bits && subset < mode.NumSubsets; ++subset)
+        {
+            endpoints[subset][0].Quantized[c] = static_cast<uint8_t>(reader.Read(bits));
+            endpoints[subset][1].Quantized[c] = static_cast<uint8_t>(reader.Read(bits));
+        }
+    }
+
+    for (uint32_t subset = 0; subset < mode.NumSubsets; ++subset)
+    {
+        if (mode.PBits == BC7PBits::PerEndpoint)
+        {
+            endpoints[subset][0].PBit = static_cast<uint8_t>(reader.Read(1));
+            endpoints[subset][1].PBit = static_cast<uint8_t>(reader.Read(1));
+        }
+        else if (mode.PBits == BC7PBits::PerSubset)
+        {
+            endpoints[subset][0].PBit = endpoints[subset][1].PBit = static_cast<uint8_t>(reader.Read(1));
+        }
+    }
+
+    uint8_t palettes[2][16][4];
+    for (uint32_t subset = 0; subset < mode.NumSubsets; ++subset)
+    {
+        ExpandBC7Endpoint(mode, endpoints[subset][0]);
+        ExpandBC7Endpoint(mode, endpoints[subset][1]);
+        GetBC7Palette(mode, endpoints[subset], palettes[subset]);
+    }
+
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        uint32_t index = reader.Read(mode.IndexBits - (IsBC7Anchor(mode, partition, i) ? 1 : 0));
+        memcpy(pPixels + i * 4, palettes[GetBC7Subset(mode, partition, i)][index], 4);
+    }
+    return true;
+}
+
+bool CompressTexture(const TextureData& source, TextureFormat format, TextureData& dest,
+    const BlockCompressionSettings& settings, ThreadPool* pThreadPool)
+{
+    // D3D12 requires the size of mip 0 of a block compressed texture to be a multiple of the block size.
+    if (!IsRGBA8(source.Format) || !IsBlockCompressed(format) || source.Width % 4 != 0 || source.Height % 4 != 0)
+    {
+        return false;
+    }
+
+    dest.Initialize(format, source.Width, source.Height, source.ArraySize, source.MipLevels);
+    const uint32_t bytesPerBlock = GetBytesPerBlock(format);
+
+    struct Tile
+    {
+        uint32_t Subresource;
+        uint32_t BlockX;
+        uint32_t BlockY;
+        uint32_t BlocksWide;
+        uint32_t BlocksHigh;
+    };
+
+    std::vector<Tile> tiles;
+    for (uint32_t subresource = 0; subresource < source.Subresources.size(); ++subresource)
+    {
+        const TextureSubresource& layout = source.Subresources[subresource];
+        const uint32_t blocksWide = (layout.Width + 3) / 4;
+        const uint32_t blocksHigh = (layout.Height + 3) / 4;
+        for (uint32_t y = 0; y < blocksHigh; y += TileSize)
+        {
+            for (uint32_t x = 0; x < blocksWide; x += TileSize)
+            {
+                tiles.push_back({ subresource, x, y, std::min(TileSize, blocksWide - x), std::min(TileSize, blocksHigh - y) });
+            }
+        }
+    }
+
+    // 大的 tile 先做: the threads take tiles one at a time, the small tiles of the low mips fill the gaps at the end.
+    std::stable_sort(tiles.begin(), tiles.end(), [](const Tile& a, const Tile& b)
+    {
+        return a.BlocksWide * a.BlocksHigh > b.BlocksWide * b.BlocksHigh;
+    });
+
+    ParallelFor(pThreadPool, static_cast<uint32_t>(tiles.size()), [&](uint32_t t)
+    {
+        const Tile& tile = tiles[t];
+        const TextureSubresource& sourceLayout = source.Subresources[tile.Subresource];
+        const TextureSubresource& destLayout = dest.Subresources[tile.Subresource];
+        const uint8_t* pSource = source.Pixels.data() + sourceLayout.Offset;
+        uint8_t* pDest = dest.Pixels.data() + destLayout.Offset;
+
+        uint8_t pixels[64];
+        for (uint32_t by = tile.BlockY; by < tile.BlockY + tile.BlocksHigh; ++by)
+        {
+            for (uint32_t bx = tile.BlockX; bx < tile.BlockX + tile.BlocksWide; ++bx)
+            {
+                // Blocks of mips smaller than 4x4 repeat the edge texels.
+                for (uint32_t y = 0; y < 4; ++y)
+                {
+                    uint32_t sy = std::min(by * 4 + y, sourceLayout.Height - 1);
+                    for (uint32_t x = 0; x < 4; ++x)
+                    {
+                        uint32_t sx = std::min(bx * 4 + x, sourceLayout.Width - 1);
+                        memcpy(pixels + (y * 4 + x) * 4, pSource + sy * sourceLayout.RowPitch + sx * 4, 4);
+                    }
+                }
+
+                EncodeBlock(format, pixels, settings, pDest + by * destLayout.RowPitch + bx * bytesPerBlock);
+            }
+        }
+    });
+
+    return true;
+}
+
+bool DecompressTexture(const TextureData& source, TextureData& dest, ThreadPool* pThreadPool)
+{
+    if (!IsBlockCompressed(source.Format))
+    {
+        return false;
+    }
+
+    dest.Initialize(IsSRGB(source.Format) ? TextureFormat::RGBA8UNormSRGB : TextureFormat::RGBA8UNorm,
+        source.Width, source.Height, source.ArraySize, source.MipLevels);
+    const uint32_t bytesPerBlock = GetBytesPerBlock(source.Format);
+
+    std::atomic<bool> result(true);
+    ParallelFor(pThreadPool, static_cast<uint32_t>(source.Subresources.size()), [&](uint32_t subresource)
+    {
+        const TextureSubresource& sourceLayout = source.Subresources[subresource];
+        const TextureSubresource& destLayout = dest.Subresources[subresource];
+        const uint8_t* pSource = source.Pixels.data() + sourceLayout.Offset;
+        uint8_t* pDest = dest.Pixels.data() + destLayout.Offset;
+
+        uint8_t pixels[64];
+        for (uint32_t by = 0; by * 4 < destLayout.Height; ++by)
+        {
+            for (uint32_t bx = 0; bx * 4 < destLayout.Width; ++bx)
+            {
+                if (!DecodeBlock(source.Format, pSource + by * sourceLayout.RowPitch + bx * bytesPerBlock, pixels))
+                {
+                    result = false;
+                }
+
+                for (uint32_t y = 0; y < 4 && by * 4 + y < destLayout.Height; ++y)
+                {
+                    uint32_t width = std::min(4u, destLayout.Width - bx * 4);
+                    memcpy(pDest + (by * 4 + y) * destLayout.RowPitch + bx * 16, pixels + y * 16, width * 4);
+                }
+            }
+        }
+    });
+
+    return result;
+}
+
+double ComputePSNR(const TextureData& reference, const TextureData& image, uint32_t channelMask)
+{
+    if (!IsRGBA8(reference.Format) || !IsRGBA8(image.Format) || reference.Pixels.size() != image.Pixels.size() ||
+        reference.Width != image.Width || reference.Height != image.Height ||
+        reference.ArraySize != image.ArraySize || reference.MipLevels != image.MipLevels)
+    {
+        return -1.0;
+    }
+
+    uint64_t squaredError = 0;
+    uint64_t count = 0;
+    for (size_t i = 0; i < reference.Pixels.size(); ++i)
+    {
+        if (channelMask & (1u << (i & 3)))
+        {
+            int difference = int(reference.Pixels[i]) - int(image.Pixels[i]);
+            squaredError += difference * difference;
+            ++count;
+        }
+    }
+
+    if (squaredError == 0 || count == 0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double meanSquaredError = double(squaredError) / double(count);
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
@@ -106,6 +106,11 @@ bool CommandQueue::IsFenceComplete(uint64_t fenceValue)
     return m_d3d12Fence->GetCompletedValue() >= fenceValue;
 }
 
+uint64_t CommandQueue::GetCompletedFenceValue() const
+{
+    return m_d3d12Fence->GetCompletedValue();
+}
+
 void CommandQueue::WaitForFenceValue(uint64_t fenceValue)
 {
     if (!IsFenceComplete(fenceValue))
@@ -120,6 +125,11 @@ void CommandQueue::Flush()
     WaitForFenceValue(Signal());
 }
 
+void CommandQueue::Wait(const CommandQueue& other, uint64_t fenceValue)
+{
+    ThrowIfFailed(m_d3d12CommandQueue->Wait(other.m_d3d12Fence.Get(), fenceValue));
+}
+
 Microsoft::WRL::ComPtr<ID3D12CommandQueue> CommandQueue::GetD3D12CommandQueue() const
 {
     return m_d3d12CommandQueue;
@@ -2,7 +2,19 @@
  
 #include <Application.h>
 #include <CommandQueue.h>
+#include <DescriptorViewCache.h>
+#include <EnvironmentMap.h>
+#include <FastMemcpy.h>
+#include <GPUMemoryAllocator.h>
 #include <Helpers.h>
+#include <MeshFile.h>
+#include <MeshOptimizer.h>
+#include <MeshSimplifier.h>
+#include <PipelineBuilder.h>
+#include <PipelineLayout.h>
+#include <PipelineStateCache.h>
+#include <ResidencyManager.h>
+#include <TextureFile.h>
 #include <Window.h>
  
 #include <wrl.h>
@@ -53,232 +65,317 @@ static WORD g_Indicies[36] =
 
 
 
+// Can the vertices of the mesh file be drawn with the VertexPosColorPacked input layout?
+static bool IsVertexPosColorPackedLayout(const MeshFileHeader& header)
+{
+    return header.VertexStride == sizeof(VertexPosColorPacked) &&
+        header.NumAttributes == 2 &&
+        header.Attributes[0].Semantic == MeshAttributeSemantic::Position &&
+        header.Attributes[0].Format == MeshFormatR16G16B16A16SNorm &&
+        header.Attributes[0].Offset == offsetof(VertexPosColorPacked, Position) &&
+        header.Attributes[1].Semantic == MeshAttributeSemantic::Color &&
+        header.Attributes[1].Format == MeshFormatR8G8B8A8UNorm &&
+        header.Attributes[1].Offset == offsetof(VertexPosColorPacked, Color);
+}
+
+// Root constants of the vertex shader that map the SNORM positions back to object space.
+struct PositionDequantization
+{
+    XMFLOAT3 Scale;
+    float Padding0;
+    XMFLOAT3 Bias;
+    float Padding1;
+};
+
+// The input assembler expands the packed attributes to floats (SNORM to [-1, 1], UNORM to [0, 1]).
+template<>
+struct VertexLayout<VertexPosColorPacked>
+{
+    static constexpr VertexAttribute Attributes[] = {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_SNORM, offsetof(VertexPosColorPacked, Position), sizeof(VertexPosColorPacked::Position) },
+        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, offsetof(VertexPosColorPacked, Color), sizeof(VertexPosColorPacked::Color) },
+    };
+};
+
+// Allow input layout and deny unnecessary access to certain pipeline stages. 根签名
+// 0: MVP matrix, 1: position dequantization, both 32-bit constants of the vertex shader.
+using Demo1RootSignature = RootSignatureLayout<
+    D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
+    D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
+    D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
+    D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
+    D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS,
+    RootConstants<XMMATRIX, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX>,
+    RootConstants<PositionDequantization, 1, 0, D3D12_SHADER_VISIBILITY_VERTEX>>;
+
+// 管线状态流, a constant: only the root signature and the shaders are filled in at creation.
+static constexpr GraphicsPipelineStream Demo1PipelineStream = GraphicsPipelineStream()
+    .WithInputLayout<VertexPosColorPacked>()
+    .WithPrimitiveTopologyType(D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE)
+    .WithRenderTargetFormat(0, DXGI_FORMAT_R8G8B8A8_UNORM)
+    .WithDepthStencilFormat(DXGI_FORMAT_D32_FLOAT);
+
 Demo1::Demo1(const std::wstring& name, int width, int height, bool vSync)
     : super(name, width, height, vSync)
     , m_Viewport(CD3DX12_VIEWPORT(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)))
     , m_ScissorRect(CD3DX12_RECT(0, 0, LONG_MAX, LONG_MAX))
     , m_FoV(45.0)
+    , m_IndexFormat(DXGI_FORMAT_R16_UINT)
+    , m_QuantizationBounds{ { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f } }
+    , m_BRDFLUTView{}
     , m_ContentLoaded(false)
 {
 }
 
-// 创建一个ID3D12Resource足够大的缓冲区来存储传递给函数的缓冲区数据，并创建一个中间缓冲区，用于将CPU缓冲区数据复制到GPU
-void Demo1::UpdateBufferResource(
-    ComPtr<ID3D12GraphicsCommandList2> commandList,
-    ID3D12Resource** pDestinationResource,
-    ID3D12Resource** pIntermediateResource,
-    size_t numElements, size_t elementSize, const void* bufferData,
-    D3D12_RESOURCE_FLAGS flags)
+bool Demo1::LoadContent()
 {
     auto device = Application::Get().GetDevice();
 
-    size_t bufferSize = numElements * elementSize;
-    
+    // Worker threads for the startup work.
+    m_ThreadPool = std::make_unique<ThreadPool>();
+
+    // 几何体来源: the memory mapped Cube.mesh that the build converts from assets/Cube.obj
+    // (see MyDX12Demo.MeshConverter), the built-in cube if it is missing. Both use the quantized
+    // VertexPosColorPacked layout, the mesh file is not copied before the upload.
+    std::shared_ptr<const void> geometryOwner;
+    const void* pVertexData = nullptr;
+    size_t vertexDataSize = 0;
+    const void* pIndexData = nullptr;
+    size_t indexDataSize = 0;
+
+    auto meshFile = std::make_shared<MeshFile>();
+    if (meshFile->Open(L"Cube.mesh") && IsVertexPosColorPackedLayout(meshFile->GetHeader()))
     {
-        CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
-        CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize, flags);
-
-        // Create a committed resource for the GPU resource in a default heap. 默认堆
-        ThrowIfFailed(device->CreateCommittedResource( //创建资源和足够大以存储该资源的隐式堆。该资源也映射到隐式堆。
-            &heapProperties,
-            D3D12_HEAP_FLAG_NONE,
-            &resourceDesc,
-            D3D12_RESOURCE_STATE_COMMON,
-            nullptr,
-            IID_PPV_ARGS(pDestinationResource)));
+        const MeshFileHeader& header = meshFile->GetHeader();
+        std::copy(header.PositionScale, header.PositionScale + 3, m_QuantizationBounds.Scale);
+        std::copy(header.PositionBias, header.PositionBias + 3, m_QuantizationBounds.Bias);
+        pVertexData = meshFile->GetVertexData();
+        vertexDataSize = static_cast<size_t>(header.VertexDataSize);
+        pIndexData = meshFile->GetIndexData();
+        indexDataSize = static_cast<size_t>(header.IndexDataSize);
+        m_IndexFormat = static_cast<DXGI_FORMAT>(header.IndexFormat);
+        m_Submeshes.assign(meshFile->GetSubmeshes(), meshFile->GetSubmeshes() + header.NumSubmeshes);
+        m_LODs.assign(meshFile->GetLODs(), meshFile->GetLODs() + header.NumLODs);
+        // The mapping stays alive until the streamer has written the data to upload memory.
+        geometryOwner = meshFile;
     }
-    // Create an committed resource for the upload. 上传堆
-    if (bufferData)
-    { // 创建了默认资源，但缓冲区数据尚未上传到该资源。
-        //下一步是创建另一个资源，用于将 CPU 缓冲区数据传输到 GPU 内存。为了执行内存传输，使用上传堆创建中间缓冲区资源。
-		CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
-		CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
-
-        ThrowIfFailed(device->CreateCommittedResource(
-            &heapProperties,
-            D3D12_HEAP_FLAG_NONE,
-            &resourceDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ, //在堆中创建的D3D12_HEAP_TYPE_UPLOAD 必须使用D3D12_RESOURCE_STATE_GENERIC_READ创建且不能更改。
-            nullptr,
-            IID_PPV_ARGS(pIntermediateResource)));
-
-        D3D12_SUBRESOURCE_DATA subresourceData = {};
-        subresourceData.pData = bufferData;
-        subresourceData.RowPitch = bufferSize;
-        subresourceData.SlicePitch = subresourceData.RowPitch;
-        //上传堆中的中间缓冲区将CPU缓冲区数据上传到默认堆中的GPU资源。
-        UpdateSubresources(commandList.Get(),
-            *pDestinationResource, *pIntermediateResource,
-            0, 0, 1, &subresourceData);
+    else
+    {
+        // 优化并量化内置的立方体, the same way MeshConverter prepares mesh files.
+        auto cube = std::make_shared<MeshData>();
+        cube->VertexStride = sizeof(VertexPosColor);
+        cube->Attributes = {
+            { MeshAttributeSemantic::Position, MeshFormatR32G32B32Float, offsetof(VertexPosColor, Position) },
+            { MeshAttributeSemantic::Color, MeshFormatR32G32B32Float, offsetof(VertexPosColor, Color) },
+        };
+        cube->Vertices.assign(reinterpret_cast<const uint8_t*>(g_Vertices), reinterpret_cast<const uint8_t*>(g_Vertices) + sizeof(g_Vertices));
+        cube->Indices.assign(g_Indicies, g_Indicies + _countof(g_Indicies));
+
+        OptimizeMesh(*cube);
+        GenerateLODs(*cube);
+        ComputeSubmeshBounds(*cube);
+        QuantizeMesh(*cube);
+        std::copy(cube->PositionScale, cube->PositionScale + 3, m_QuantizationBounds.Scale);
+        std::copy(cube->PositionBias, cube->PositionBias + 3, m_QuantizationBounds.Bias);
+
+        pVertexData = cube->Vertices.data();
+        vertexDataSize = cube->Vertices.size();
+        pIndexData = cube->Indices.data();
+        indexDataSize = cube->Indices.size() * sizeof(uint32_t);
+        m_IndexFormat = DXGI_FORMAT_R32_UINT;
+        m_Submeshes = cube->Submeshes;
+        m_LODs = cube->LODs;
+        geometryOwner = cube;
     }
-}
 
+    // 每个子网格一个 LOD 实例. Submeshes without LODs only have LOD 0, the submesh itself.
+    m_LODSelector.Clear();
+    for (MeshFileSubmesh& submesh : m_Submeshes)
+    {
+        if (submesh.LODCount == 0)
+        {
+            submesh.LODOffset = static_cast<uint32_t>(m_LODs.size());
+            submesh.LODCount = 1;
+            m_LODs.push_back({ submesh.IndexStart, submesh.IndexCount, 0.0f });
+        }
+        m_LODSelector.AddInstance(m_LODSelector.AddLODChain(&m_LODs[submesh.LODOffset], submesh.LODCount));
+    }
 
-bool Demo1::LoadContent()
-{
-    auto device = Application::Get().GetDevice();
-    auto commandQueue = Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
-    auto commandList = commandQueue->GetCommandList();
+    // 异步上传几何体。The cube is drawn as soon as both buffers have been streamed in,
+    // LoadContent does not wait for the copy queue.
+    m_AssetStreamer = std::make_unique<AssetStreamer>(
+        Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY),
+        Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT));
 
     // 上传 Upload vertex buffer data.
-    ComPtr<ID3D12Resource> intermediateVertexBuffer;
-    UpdateBufferResource(commandList,
-        &m_VertexBuffer, &intermediateVertexBuffer,
-        _countof(g_Vertices), sizeof(VertexPosColor), g_Vertices);
+    m_AssetStreamer->LoadBuffer(geometryOwner, pVertexData, vertexDataSize, [this](const AssetStreamer::Buffer& buffer)
+    {
+        if (!buffer.Resource)
+        {
+            return;
+        }
 
-    // 创建 vertex buffer view
-    m_VertexBufferView.BufferLocation = m_VertexBuffer->GetGPUVirtualAddress();
-    m_VertexBufferView.SizeInBytes = sizeof(g_Vertices);
-    m_VertexBufferView.StrideInBytes = sizeof(VertexPosColor);
+        m_VertexBuffer = buffer.Resource;
+        m_VertexBufferAllocation = buffer.Allocation;
+
+        // 创建 vertex buffer view
+        m_VertexBufferView.BufferLocation = m_VertexBuffer->GetGPUVirtualAddress();
+        m_VertexBufferView.SizeInBytes = static_cast<UINT>(buffer.SizeInBytes);
+        m_VertexBufferView.StrideInBytes = sizeof(VertexPosColorPacked);
+    });
 
     // 上传 Upload index buffer data.
-    ComPtr<ID3D12Resource> intermediateIndexBuffer;
-    UpdateBufferResource(commandList,
-        &m_IndexBuffer, &intermediateIndexBuffer,
-        _countof(g_Indicies), sizeof(WORD), g_Indicies);
-
-    // 创建 index buffer view.
-    m_IndexBufferView.BufferLocation = m_IndexBuffer->GetGPUVirtualAddress();
-    m_IndexBufferView.Format = DXGI_FORMAT_R16_UINT;
-    m_IndexBufferView.SizeInBytes = sizeof(g_Indicies);
-
-    // 创建DSV的描述符堆
-    D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
-    dsvHeapDesc.NumDescriptors = 1;
-    dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-    dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    ThrowIfFailed(device->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&m_DSVHeap)));
-
-    // 加载 vertex shader.
-    ComPtr<ID3DBlob> vertexShaderBlob;
-    ThrowIfFailed(D3DReadFileToBlob(L"VertexShader.cso", &vertexShaderBlob));
-
-    // 加载 pixel shader.
-    ComPtr<ID3DBlob> pixelShaderBlob;
-    ThrowIfFailed(D3DReadFileToBlob(L"PixelShader.cso", &pixelShaderBlob));
-
-    // Create the vertex input layout 顶点着色器输入格式
-    D3D12_INPUT_ELEMENT_DESC inputLayout[] = {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-    };
+    m_AssetStreamer->LoadBuffer(geometryOwner, pIndexData, indexDataSize, [this](const AssetStreamer::Buffer& buffer)
+    {
+        if (!buffer.Resource)
+        {
+            return;
+        }
 
-#pragma region Root Signature
-    D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
-    featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
-    if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
+        m_IndexBuffer = buffer.Resource;
+        m_IndexBufferAllocation = buffer.Allocation;
+
+        // 创建 index buffer view.
+        m_IndexBufferView.BufferLocation = m_IndexBuffer->GetGPUVirtualAddress();
+        m_IndexBufferView.Format = m_IndexFormat;
+        m_IndexBufferView.SizeInBytes = static_cast<UINT>(buffer.SizeInBytes);
+    });
+
+    // The lookup table is generated on the first run only, later runs map the cache file.
+    if (!LoadBRDFLUT())
     {
-        featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+        OutputDebugStringA("Failed to load the BRDF lookup table.\n");
     }
 
-    // Allow input layout and deny unnecessary access to certain pipeline stages. 定义根签名标志
-    D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
-        D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
-        D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
-        D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
-        D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
-        D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS;
-
-    // A single 32-bit constant root parameter that is used by the vertex shader. 根参数
-    CD3DX12_ROOT_PARAMETER1 rootParameters[1];
-    rootParameters[0].InitAsConstants(sizeof(XMMATRIX) / 4, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
-    
-    CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDescription;
-    rootSignatureDescription.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, rootSignatureFlags);
-
-    // 序列化根签名
-    ComPtr<ID3DBlob> rootSignatureBlob;
-    ComPtr<ID3DBlob> errorBlob;
-    ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDescription,
-        featureData.HighestVersion, &rootSignatureBlob, &errorBlob));
-    // 创建根签名
-    ThrowIfFailed(device->CreateRootSignature(0, rootSignatureBlob->GetBufferPointer(),
-        rootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&m_RootSignature)));
+    // Shaders, root signatures and pipeline states are built in parallel on the thread pool.
+    auto pipelineStateCache = Application::Get().GetPipelineStateCache();
+    m_ShaderLibrary = std::make_shared<ShaderLibrary>(m_ThreadPool.get());
+    m_PipelineBuilder = std::make_unique<PipelineBuilder>(device, pipelineStateCache, m_ShaderLibrary);
+
+#pragma region Root Signature
+    // The layout is checked at compile time (64 DWORD limit, see Demo1RootSignature).
+    const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& rootSignatureDescription = Demo1RootSignature::GetDesc();
+
+    // 序列化并创建根签名 (through the pipeline state cache, which keys the PSO by the serialized blob).
+    uint32_t rootSignature = m_PipelineBuilder->AddRootSignature(rootSignatureDescription);
+
+    // The root signature only has constants for now, materials stage their SRV tables here.
+    m_DynamicDescriptorHeap = std::make_unique<DynamicDescriptorHeap>(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    m_DynamicDescriptorHeap->ParseRootSignature(rootSignatureDescription);
 #pragma endregion
 
 #pragma region PSO
-    struct PipelineStateStream
-    {
-        CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE pRootSignature;
-        CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT InputLayout;
-        CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY PrimitiveTopologyType;
-        CD3DX12_PIPELINE_STATE_STREAM_VS VS;
-        CD3DX12_PIPELINE_STATE_STREAM_PS PS;
-        CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT DSVFormat;
-        CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS RTVFormats;
-    } pipelineStateStream;
-    //定义渲染目标的数量和渲染目标格式
-    D3D12_RT_FORMAT_ARRAY rtvFormats = {};
-    rtvFormats.NumRenderTargets = 1;
-    rtvFormats.RTFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
     //描述 PSO
-    pipelineStateStream.pRootSignature = m_RootSignature.Get();
-    pipelineStateStream.InputLayout = { inputLayout, _countof(inputLayout) };
-    pipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-    pipelineStateStream.VS = CD3DX12_SHADER_BYTECODE(vertexShaderBlob.Get());
-    pipelineStateStream.PS = CD3DX12_SHADER_BYTECODE(pixelShaderBlob.Get());
-    pipelineStateStream.DSVFormat = DXGI_FORMAT_D32_FLOAT;
-    pipelineStateStream.RTVFormats = rtvFormats;
-    //创建实际的 PSO
-    D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = {
-        sizeof(PipelineStateStream), &pipelineStateStream
-    };
-    ThrowIfFailed(device->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_PipelineState)));
+    GraphicsPipelineDesc pipelineDesc;
+    pipelineDesc.VertexShader = L"VertexShader.cso";
+    pipelineDesc.PixelShader = L"PixelShader.cso";
+    pipelineDesc.RootSignature = rootSignature;
+    // Input layout, topology and render target formats, see Demo1PipelineStream.
+    pipelineDesc.Stream = Demo1PipelineStream;
+    m_PipelineStateIndex = m_PipelineBuilder->AddGraphicsPipeline(pipelineDesc);
+
+    //创建实际的 PSO, loaded from the pipeline library after the first run.
+    m_PipelineBuilder->Build(m_ThreadPool.get());
+    m_PipelineBuilder->PrintTimings();
+
+    m_RootSignature = m_PipelineBuilder->GetRootSignature(rootSignature);
+    m_PipelineState = m_PipelineBuilder->GetPipelineState(m_PipelineStateIndex);
+    pipelineStateCache->Save();
+
+    PipelineStateCache::Statistics pipelineStatistics = pipelineStateCache->GetStatistics();
+    char buffer[256];
+    sprintf_s(buffer, "Pipeline states: %u compiled, %u from the pipeline library, %u from memory\n",
+        pipelineStatistics.NumCompiled, pipelineStatistics.NumLibraryHits, pipelineStatistics.NumMemoryHits);
+    OutputDebugStringA(buffer);
 #pragma endregion
 
-    //在离开该LoadContent方法之前，必须在命令队列上执行命令列表，以确保索引和顶点缓冲区在渲染之前上传到 GPU 资源。
-    auto fenceValue = commandQueue->ExecuteCommandList(commandList);
-    commandQueue->WaitForFenceValue(fenceValue);
+    // 深度缓冲区 is requested from the transient pool every frame, see PrepareDepthBuffer.
+    m_TransientResourcePool = std::make_unique<TransientResourcePool>(device, Application::Get().GetResidencyManager());
 
     m_ContentLoaded = true;
 
-    // Resize/Create the depth buffer. 创建描述符堆后，现在就可以安全地创建深度缓冲区了。
-    ResizeDepthBuffer(GetClientWidth(), GetClientHeight());
-
     return true;
 }
 
-void Demo1::ResizeDepthBuffer(int width, int height)
+bool Demo1::LoadBRDFLUT()
 {
-    if (m_ContentLoaded)
+    auto device = Application::Get().GetDevice();
+
+    TextureFile lutFile;
+    if (!BuildBRDFLUTCache(L"BRDFLUT.tex", BRDFLUTSettings(), m_ThreadPool.get()) || !lutFile.Open(L"BRDFLUT.tex"))
     {
-        // Flush any GPU commands that might be referencing the depth buffer.
-        Application::Get().Flush();
- 
-        width = std::max(1, width);
-        height = std::max(1, height);
- 
-        auto device = Application::Get().GetDevice();
+        return false;
+    }
 
-        // Resize screen dependent resources.
-        // Create a depth buffer.
-        D3D12_CLEAR_VALUE optimizedClearValue = {};
-        optimizedClearValue.Format = DXGI_FORMAT_D32_FLOAT;
-        optimizedClearValue.DepthStencil = { 1.0f, 0 };
- 
-		CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
-		CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, width, height, //此处是创建纹理 UpdateBufferResource中为缓冲区
-			1, 0, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
-
-        ThrowIfFailed(device->CreateCommittedResource(
-            &heapProperties,
-            D3D12_HEAP_FLAG_NONE,
-            &resourceDesc,
-            D3D12_RESOURCE_STATE_DEPTH_WRITE,
-            &optimizedClearValue,
-            IID_PPV_ARGS(&m_DepthBuffer)
-        ));
-
-        // 更新深度/模板视图
-        D3D12_DEPTH_STENCIL_VIEW_DESC dsv = {};
-        dsv.Format = DXGI_FORMAT_D32_FLOAT;
-        dsv.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-        dsv.Texture2D.MipSlice = 0;
-        dsv.Flags = D3D12_DSV_FLAG_NONE;
- 
-        device->CreateDepthStencilView(m_DepthBuffer.Get(), &dsv,
-            m_DSVHeap->GetCPUDescriptorHandleForHeapStart());
+    const TextureFileTexture& texture = lutFile.GetTexture(0);
+    const TextureFileSubresource* pSubresources = lutFile.GetSubresources(0);
+
+    // 默认堆中的纹理. Placed in the COMMON state, the copy queue promotes it to COPY_DEST and
+    // it decays back to COMMON, from where the direct queue promotes it to a shader resource.
+    CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(texture.Format),
+        texture.Width, texture.Height, static_cast<UINT16>(texture.ArraySize), static_cast<UINT16>(texture.MipLevels));
+    m_BRDFLUT = Application::Get().GetMemoryAllocator()->CreateResource(resourceDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, m_BRDFLUTAllocation);
+
+    // The subresources are uploaded straight from the mapped file.
+    std::vector<D3D12_SUBRESOURCE_DATA> subresourceData(texture.NumSubresources);
+    for (uint32_t i = 0; i < texture.NumSubresources; ++i)
+    {
+        subresourceData[i].pData = lutFile.GetPixels(pSubresources[i]);
+        subresourceData[i].RowPitch = static_cast<LONG_PTR>(pSubresources[i].RowPitch);
+        subresourceData[i].SlicePitch = static_cast<LONG_PTR>(pSubresources[i].SlicePitch);
     }
+
+    ComPtr<ID3D12Resource> uploadBuffer;
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC uploadDesc = CD3DX12_RESOURCE_DESC::Buffer(GetRequiredIntermediateSize(m_BRDFLUT.Get(), 0, texture.NumSubresources));
+    ThrowIfFailed(device->CreateCommittedResource(
+        &heapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &uploadDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&uploadBuffer)));
+
+    auto copyQueue = Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
+    auto commandList = copyQueue->GetCommandList();
+    UpdateSubresourcesFast(commandList.Get(), m_BRDFLUT.Get(), uploadBuffer.Get(), 0, 0, texture.NumSubresources,
+        subresourceData.data(), m_ThreadPool.get());
+
+    // 128x128 texels, waiting for the copy here is cheaper than keeping the upload buffer around.
+    copyQueue->WaitForFenceValue(copyQueue->ExecuteCommandList(commandList));
+
+    m_BRDFLUTView = Application::Get().GetDescriptorViewCache()->GetShaderResourceView(m_BRDFLUT.Get());
+
+    return true;
+}
+
+TransientResourcePool::Handle Demo1::PrepareDepthBuffer(uint64_t completedFenceValue)
+{
+    TransientTextureDesc depthBufferDesc;
+    depthBufferDesc.Format = DXGI_FORMAT_D32_FLOAT;
+    depthBufferDesc.Width = std::max(1, GetClientWidth());
+    depthBufferDesc.Height = std::max(1, GetClientHeight());
+    depthBufferDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+    depthBufferDesc.ClearValue.Format = DXGI_FORMAT_D32_FLOAT;
+    depthBufferDesc.ClearValue.DepthStencil = { 1.0f, 0 };
+
+    // The whole frame is a single pass for now.
+    m_TransientResourcePool->BeginFrame();
+    TransientResourcePool::Handle depthBuffer = m_TransientResourcePool->Request(depthBufferDesc, 0, 0);
+    m_TransientResourcePool->Compile(completedFenceValue);
+
+    // The previous depth buffer is released by the pool once the GPU is done with it, no flush needed.
+    TransientResourcePool::Statistics statistics = m_TransientResourcePool->GetStatistics();
+    if (statistics.NumCreatedResources > 0)
+    {
+        char buffer[256];
+        sprintf_s(buffer, "Transient textures: %u, peak %.1f MB, summed %.1f MB, heap %.1f MB\n",
+            statistics.NumTextures, statistics.PeakSize / (1024.0 * 1024.0),
+            statistics.SummedSize / (1024.0 * 1024.0), statistics.HeapSize / (1024.0 * 1024.0));
+        OutputDebugStringA(buffer);
+    }
+
+    return depthBuffer;
 }
 
 void Demo1::OnResize(ResizeEventArgs& e)
@@ -289,13 +386,33 @@ void Demo1::OnResize(ResizeEventArgs& e)
  
         m_Viewport = CD3DX12_VIEWPORT(0.0f, 0.0f,
             static_cast<float>(e.Width), static_cast<float>(e.Height));
- 
-        ResizeDepthBuffer(e.Width, e.Height);
     }
 }
 
 void Demo1::UnloadContent()
 {
+    auto memoryAllocator = Application::Get().GetMemoryAllocator();
+
+    m_AssetStreamer.reset();
+    // Both wait for their work on the thread pool.
+    m_PipelineBuilder.reset();
+    m_ShaderLibrary.reset();
+    m_ThreadPool.reset();
+
+    m_VertexBuffer.Reset();
+    m_IndexBuffer.Reset();
+    m_BRDFLUT.Reset();
+    m_TransientResourcePool.reset();
+    m_DynamicDescriptorHeap.reset();
+
+    memoryAllocator->Free(m_VertexBufferAllocation);
+    memoryAllocator->Free(m_IndexBufferAllocation);
+    memoryAllocator->Free(m_BRDFLUTAllocation);
+
+    m_Submeshes.clear();
+    m_LODs.clear();
+    m_LODSelector.Clear();
+
     m_ContentLoaded = false;
 }
 
@@ -305,6 +422,24 @@ void Demo1::OnUpdate(UpdateEventArgs& e)
     static double totalTime = 0.0;
  
     super::OnUpdate(e);
+
+    // Submit streamed uploads. Finished buffers become visible to this frame's render commands.
+    m_AssetStreamer->Update();
+
+    // 热重载: rebuild the pipeline states of the recompiled shaders in the background
+    // and switch to them once they are ready. Frames in flight keep the previous ones.
+    std::vector<ShaderLibrary::ShaderPtr> changedShaders = m_ShaderLibrary->Update();
+    if (!changedShaders.empty())
+    {
+        m_PipelineBuilder->Rebuild(changedShaders, m_ThreadPool.get());
+    }
+    for (uint32_t pipelineState : m_PipelineBuilder->ApplyRebuiltPipelines())
+    {
+        if (pipelineState == m_PipelineStateIndex)
+        {
+            m_PipelineState = m_PipelineBuilder->GetPipelineState(pipelineState);
+        }
+    }
  
     totalTime += e.ElapsedTime;
     frameCount++;
@@ -335,6 +470,17 @@ void Demo1::OnUpdate(UpdateEventArgs& e)
     // 更新 projection matrix.
     float aspectRatio = GetClientWidth() / static_cast<float>(GetClientHeight());
     m_ProjectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(m_FoV), aspectRatio, 0.1f, 100.0f);
+
+    // 选择 LOD: project the bounds and LOD errors of every submesh with this frame's camera.
+    // The model matrix only rotates, so the errors are not scaled.
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_Submeshes.size()); ++i)
+    {
+        const MeshFileSubmesh& submesh = m_Submeshes[i];
+        XMFLOAT3 center;
+        XMStoreFloat3(&center, XMVector3Transform(XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(submesh.SphereCenter)), m_ModelMatrix));
+        m_LODSelector.SetInstanceBounds(i, center, submesh.SphereRadius);
+    }
+    m_LODSelector.Select(m_ViewMatrix, m_ProjectionMatrix, static_cast<float>(GetClientHeight()));
 }
 
 void Demo1::OnRender(RenderEventArgs& e)
@@ -348,51 +494,104 @@ void Demo1::OnRender(RenderEventArgs& e)
     UINT currentBackBufferIndex = m_pWindow->GetCurrentBackBufferIndex();
     auto backBuffer = m_pWindow->GetCurrentBackBuffer();
     auto rtv = m_pWindow->GetCurrentRenderTargetView();
-    auto dsv = m_DSVHeap->GetCPUDescriptorHandleForHeapStart();
+    TransientResourcePool::Handle depthBuffer = PrepareDepthBuffer(commandQueue->GetCompletedFenceValue());
+
+    // 深度/模板视图 from the view cache, a new view is only created for a new depth buffer.
+    D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+    dsvDesc.Format = DXGI_FORMAT_D32_FLOAT;
+    dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+    dsvDesc.Texture2D.MipSlice = 0;
+    dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
+    auto dsv = Application::Get().GetDescriptorViewCache()->GetDepthStencilView(
+        m_TransientResourcePool->GetResource(depthBuffer), &dsvDesc);
+    m_DynamicDescriptorHeap->BeginCommandList(commandQueue->GetCompletedFenceValue());
+
+    // 渲染图: the passes declare what they use, the graph records the transitions
+    // (the back buffer goes from PRESENT to RENDER_TARGET and back) in batches.
+    m_RenderGraph.Reset();
+    const uint32_t backBufferResource = m_RenderGraph.ImportResource(backBuffer.Get(),
+        D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_PRESENT);
+    const uint32_t depthBufferResource = m_RenderGraph.AddResource(m_TransientResourcePool->GetResource(depthBuffer),
+        D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
     // 清除渲染目标
+    const uint32_t clearPass = m_RenderGraph.AddPass(D3D12_COMMAND_LIST_TYPE_DIRECT,
+        [this, rtv, dsv, depthBuffer](ID3D12GraphicsCommandList2* pCommandList)
     {
-        TransitionResource(commandList, backBuffer,
-            D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
- 
         FLOAT clearColor[] = { 0.4f, 0.6f, 0.9f, 1.0f };
  
-        ClearRTV(commandList, rtv, clearColor);
-        ClearDepth(commandList, dsv);
-    }
+        ClearRTV(pCommandList, rtv, clearColor);
+        // The transient depth buffer may share memory with other targets, the clear initializes it.
+        m_TransientResourcePool->AliasingBarrier(pCommandList, depthBuffer);
+        ClearDepth(pCommandList, dsv);
+    });
+    m_RenderGraph.Write(clearPass, backBufferResource, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    m_RenderGraph.Write(clearPass, depthBufferResource, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+    const uint32_t cubePass = m_RenderGraph.AddPass(D3D12_COMMAND_LIST_TYPE_DIRECT,
+        [this, rtv, dsv](ID3D12GraphicsCommandList2* pCommandList)
+    {
+        // 准备渲染管线以进行渲染
+        //尽管在 PSO 创建期间已经在 PSO 上设置了根签名（请参阅管道状态对象），
+        //但在绑定任何资源（CBV、UAV、SRV 或采样器描述符）之前，
+        //必须使用 ID3D12GraphicsCommandList::SetGraphicsRootSignature方法
+        //在命令列表上显式设置根签名。未在命令列表上显式设置根签名将导致尝试绑定资源时出现运行时错误。
+        pCommandList->SetPipelineState(m_PipelineState.Get());
+        pCommandList->SetGraphicsRootSignature(m_RootSignature.Get());
+
+        // IA Input Assembler 输入装配器
+        pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST); //该方法将顶点缓冲区绑定到输入装配器
+        pCommandList->IASetVertexBuffers(0, 1, &m_VertexBufferView);
+        pCommandList->IASetIndexBuffer(&m_IndexBufferView);
+        // RS Rasterizer State 光栅化器状态
+        pCommandList->RSSetViewports(1, &m_Viewport);
+        pCommandList->RSSetScissorRects(1, &m_ScissorRect);
+        // OM Output Merger 输出合并
+        pCommandList->OMSetRenderTargets(1, &rtv, FALSE, &dsv);
+
+        // 更新 MVP matrix  （32 位常量传递到顶点着色器中的常量缓冲区）
+        XMMATRIX mvpMatrix = XMMatrixMultiply(m_ModelMatrix, m_ViewMatrix);
+        mvpMatrix = XMMatrixMultiply(mvpMatrix, m_ProjectionMatrix);
+        Demo1RootSignature::SetGraphicsRootConstants<0>(pCommandList, mvpMatrix);
+
+        PositionDequantization dequantization = {};
+        dequantization.Scale = XMFLOAT3(m_QuantizationBounds.Scale);
+        dequantization.Bias = XMFLOAT3(m_QuantizationBounds.Bias);
+        Demo1RootSignature::SetGraphicsRootConstants<1>(pCommandList, dequantization);
+
+        // Draw Call (the geometry may still be streaming in)
+        if (m_VertexBuffer && m_IndexBuffer)
+        {
+            m_DynamicDescriptorHeap->CommitStagedDescriptorsForDraw(pCommandList);
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_Submeshes.size()); ++i)
+            {
+                const MeshFileSubmesh& submesh = m_Submeshes[i];
+                const MeshFileLOD& lod = m_LODs[submesh.LODOffset + m_LODSelector.GetLOD(i)];
+                pCommandList->DrawIndexedInstanced(lod.IndexCount, 1, lod.IndexStart, submesh.BaseVertex, 0);
+            }
+        }
+    });
+    m_RenderGraph.Write(cubePass, backBufferResource, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    m_RenderGraph.Write(cubePass, depthBufferResource, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+    m_RenderGraph.Compile();
+    commandList = m_RenderGraph.Execute(commandList);
 
-    // 准备渲染管线以进行渲染
-    //尽管在 PSO 创建期间已经在 PSO 上设置了根签名（请参阅管道状态对象），
-    //但在绑定任何资源（CBV、UAV、SRV 或采样器描述符）之前，
-    //必须使用 ID3D12GraphicsCommandList::SetGraphicsRootSignature方法
-    //在命令列表上显式设置根签名。未在命令列表上显式设置根签名将导致尝试绑定资源时出现运行时错误。
-    commandList->SetPipelineState(m_PipelineState.Get());
-    commandList->SetGraphicsRootSignature(m_RootSignature.Get());
-
-    // IA Input Assembler 输入装配器
-    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST); //该方法将顶点缓冲区绑定到输入装配器
-    commandList->IASetVertexBuffers(0, 1, &m_VertexBufferView);
-    commandList->IASetIndexBuffer(&m_IndexBufferView);
-    // RS Rasterizer State 光栅化器状态
-    commandList->RSSetViewports(1, &m_Viewport);
-    commandList->RSSetScissorRects(1, &m_ScissorRect);
-    // OM Output Merger 输出合并
-    commandList->OMSetRenderTargets(1, &rtv, FALSE, &dsv);
-
-    // 更新 MVP matrix  （32 位常量传递到顶点着色器中的常量缓冲区）
-    XMMATRIX mvpMatrix = XMMatrixMultiply(m_ModelMatrix, m_ViewMatrix);
-    mvpMatrix = XMMatrixMultiply(mvpMatrix, m_ProjectionMatrix);
-    commandList->SetGraphicsRoot32BitConstants(0, sizeof(XMMATRIX) / 4, &mvpMatrix, 0);
-
-    // Draw Call
-    commandList->DrawIndexedInstanced(_countof(g_Indicies), 1, 0, 0, 0);
-
-    // Present
+    // 驻留: the heaps used by this frame must be resident, the least recently used ones
+    // are evicted if the process is over its video memory budget.
+    auto memoryAllocator = Application::Get().GetMemoryAllocator();
+    auto residencyManager = Application::Get().GetResidencyManager();
+    memoryAllocator->MarkUsed(m_VertexBufferAllocation);
+    memoryAllocator->MarkUsed(m_IndexBufferAllocation);
+
+    // Present, the render graph has transitioned the back buffer back to PRESENT.
     {
-        TransitionResource(commandList, backBuffer,
-            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
- 
+        residencyManager->PrepareSubmission(commandQueue->GetCompletedFenceValue());
         m_FenceValues[currentBackBufferIndex] = commandQueue->ExecuteCommandList(commandList);
+        residencyManager->Submitted(m_FenceValues[currentBackBufferIndex]);
+        m_TransientResourcePool->EndFrame(m_FenceValues[currentBackBufferIndex]);
+        m_DynamicDescriptorHeap->Submitted(m_FenceValues[currentBackBufferIndex]);
+        Application::Get().ReleaseStaleDescriptors(m_FenceValues[currentBackBufferIndex], commandQueue->GetCompletedFenceValue());
  
         currentBackBufferIndex = m_pWindow->Present();
  
@@ -400,17 +599,6 @@ void Demo1::OnRender(RenderEventArgs& e)
     }
 }
 
-// 转换资源
-void Demo1::TransitionResource(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList,
-    Microsoft::WRL::ComPtr<ID3D12Resource> resource, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState)
-{
-    CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-        resource.Get(),
-        beforeState, afterState);
- 
-    commandList->ResourceBarrier(1, &barrier);
-}
-
 // Clear a render target.
 void Demo1::ClearRTV(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList,
     D3D12_CPU_DESCRIPTOR_HANDLE rtv, FLOAT* clearColor)
@@ -0,0 +1,299 @@
+#include <DescriptorAllocator.h>
+#include <DX12LibPCH.h>
+
+#include <atomic>
+
+namespace
+{
+    std::atomic<uint64_t> gs_NextAllocatorId(1);
+
+    // 线程本地缓存: a range of single descriptors reserved by the calling thread, one per heap type.
+    // The cache only holds a weak reference to its page, the rest of the range is returned when the
+    // thread exits or the cache is refilled. A page of a destroyed allocator is not freed to.
+    struct ThreadCache
+    {
+        ~ThreadCache()
+        {
+            Flush();
+        }
+
+        void Flush()
+        {
+            if (NumHandles > 0)
+            {
+                if (std::shared_ptr<DescriptorAllocatorPage> page = Page.lock())
+                {
+                    page->Free(Offset, NumHandles);
+                }
+            }
+
+            AllocatorId = 0;
+            Page.reset();
+            pPage = nullptr;
+            Descriptor.ptr = 0;
+            Offset = 0;
+            NumHandles = 0;
+        }
+
+        // Allocator ids are not reused, so a cache of a destroyed allocator is never handed out again.
+        uint64_t AllocatorId = 0;
+        std::weak_ptr<DescriptorAllocatorPage> Page;
+        DescriptorAllocatorPage* pPage = nullptr;
+        D3D12_CPU_DESCRIPTOR_HANDLE Descriptor = {};
+        uint32_t Offset = 0;
+        uint32_t NumHandles = 0;
+    };
+
+    thread_local ThreadCache gs_ThreadCaches[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+}
+
+DescriptorAllocation::DescriptorAllocation()
+    : m_Descriptor{ 0 }
+    , m_Offset(0)
+    , m_NumHandles(0)
+    , m_DescriptorSize(0)
+    , m_Page(nullptr)
+{
+}
+
+DescriptorAllocation::DescriptorAllocation(D3D12_CPU_DESCRIPTOR_HANDLE descriptor, uint32_t offset, uint32_t numHandles,
+    uint32_t descriptorSize, DescriptorAllocatorPage* pPage)
+    : m_Descriptor(descriptor)
+    , m_Offset(offset)
+    , m_NumHandles(numHandles)
+    , m_DescriptorSize(descriptorSize)
+    , m_Page(pPage)
+{
+}
+
+DescriptorAllocation::~DescriptorAllocation()
+{
+    Free();
+}
+
+DescriptorAllocation::DescriptorAllocation(DescriptorAllocation&& allocation)
+    : m_Descriptor(allocation.m_Descriptor)
+    , m_Offset(allocation.m_Offset)
+    , m_NumHandles(allocation.m_NumHandles)
+    , m_DescriptorSize(allocation.m_DescriptorSize)
+    , m_Page(allocation.m_Page)
+{
+    allocation.m_Descriptor.ptr = 0;
+    allocation.m_NumHandles = 0;
+    allocation.m_Page = nullptr;
+}
+
+DescriptorAllocation& DescriptorAllocation::operator=(DescriptorAllocation&& other)
+{
+    if (this != &other)
+    {
+        Free();
+
+        m_Descriptor = other.m_Descriptor;
+        m_Offset = other.m_Offset;
+        m_NumHandles = other.m_NumHandles;
+        m_DescriptorSize = other.m_DescriptorSize;
+        m_Page = other.m_Page;
+
+        other.m_Descriptor.ptr = 0;
+        other.m_NumHandles = 0;
+        other.m_Page = nullptr;
+    }
+
+    return *this;
+}
+
+void DescriptorAllocation::Free()
+{
+    if (!IsNull() && m_Page)
+    {
+        m_Page->Free(m_Offset, m_NumHandles);
+    }
+
+    m_Descriptor.ptr = 0;
+    m_NumHandles = 0;
+    m_Page = nullptr;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocation::GetDescriptorHandle(uint32_t offset) const
+{
+    assert(offset < m_NumHandles && "Descriptor offset out of range.");
+    return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_Descriptor, offset, m_DescriptorSize);
+}
+
+DescriptorAllocatorPage::DescriptorAllocatorPage(Microsoft::WRL::ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors)
+    : m_Ranges(numDescriptors)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.Type = type;
+    heapDesc.NumDescriptors = numDescriptors;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+    ThrowIfFailed(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_d3d12DescriptorHeap)));
+
+    m_BaseDescriptor = m_d3d12DescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    m_DescriptorSize = device->GetDescriptorHandleIncrementSize(type);
+}
+
+DescriptorAllocatorPage::~DescriptorAllocatorPage()
+{
+}
+
+DescriptorAllocation DescriptorAllocatorPage::Allocate(uint32_t numDescriptors)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    uint32_t offset = m_Ranges.Allocate(numDescriptors);
+    if (offset == DescriptorRangeAllocator::InvalidOffset)
+    {
+        return DescriptorAllocation();
+    }
+
+    return DescriptorAllocation(CD3DX12_CPU_DESCRIPTOR_HANDLE(m_BaseDescriptor, offset, m_DescriptorSize),
+        offset, numDescriptors, m_DescriptorSize, this);
+}
+
+void DescriptorAllocatorPage::Free(uint32_t offset, uint32_t numDescriptors)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Ranges.Free(offset, numDescriptors);
+}
+
+void DescriptorAllocatorPage::Submitted(uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Ranges.Submitted(fenceValue);
+}
+
+void DescriptorAllocatorPage::ReleaseStale(uint64_t completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Ranges.ReleaseStale(completedFenceValue);
+}
+
+bool DescriptorAllocatorPage::HasSpace(uint32_t numDescriptors) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Ranges.HasSpace(numDescriptors);
+}
+
+uint32_t DescriptorAllocatorPage::GetNumDescriptors() const
+{
+    return m_Ranges.GetNumDescriptors();
+}
+
+uint32_t DescriptorAllocatorPage::GetNumFreeDescriptors() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Ranges.GetNumFreeDescriptors();
+}
+
+uint32_t DescriptorAllocatorPage::GetNumStaleDescriptors() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Ranges.GetNumStaleDescriptors();
+}
+
+DescriptorAllocator::DescriptorAllocator(Microsoft::WRL::ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerPage)
+    : m_d3d12Device(device)
+    , m_HeapType(type)
+    , m_NumDescriptorsPerPage(numDescriptorsPerPage)
+    , m_DescriptorSize(device->GetDescriptorHandleIncrementSize(type))
+    , m_Id(gs_NextAllocatorId++)
+{
+    assert(numDescriptorsPerPage >= ThreadCacheSize && "A page must hold a thread cache refill.");
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+}
+
+DescriptorAllocation DescriptorAllocator::Allocate(uint32_t numDescriptors)
+{
+    if (numDescriptors != 1)
+    {
+        return AllocateFromPages(numDescriptors);
+    }
+
+    ThreadCache& cache = gs_ThreadCaches[m_HeapType];
+    if (cache.AllocatorId != m_Id || cache.NumHandles == 0)
+    {
+        // 重新填充: the rest of a cache of another allocator of this type goes back to its page.
+        cache.Flush();
+        DescriptorAllocation range = AllocateFromPages(ThreadCacheSize);
+
+        cache.AllocatorId = m_Id;
+        cache.Page = range.m_Page->shared_from_this();
+        cache.pPage = range.m_Page;
+        cache.Descriptor = range.m_Descriptor;
+        cache.Offset = range.m_Offset;
+        cache.NumHandles = range.m_NumHandles;
+
+        // The cache owns the range now.
+        range.m_Descriptor.ptr = 0;
+        range.m_Page = nullptr;
+    }
+
+    DescriptorAllocation allocation(cache.Descriptor, cache.Offset, 1, m_DescriptorSize, cache.pPage);
+    cache.Descriptor.ptr += m_DescriptorSize;
+    ++cache.Offset;
+    --cache.NumHandles;
+
+    return allocation;
+}
+
+DescriptorAllocation DescriptorAllocator::AllocateFromPages(uint32_t numDescriptors)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (auto& page : m_Pages)
+    {
+        DescriptorAllocation allocation = page->Allocate(numDescriptors);
+        if (!allocation.IsNull())
+        {
+            return allocation;
+        }
+    }
+
+    // 所有页都已满，创建一个新页. Large ranges get a page of their own size.
+    m_Pages.push_back(std::make_shared<DescriptorAllocatorPage>(m_d3d12Device, m_HeapType,
+        std::max(m_NumDescriptorsPerPage, numDescriptors)));
+
+    return m_Pages.back()->Allocate(numDescriptors);
+}
+
+void DescriptorAllocator::ReleaseStaleDescriptors(uint64_t fenceValue, uint64_t completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (auto& page : m_Pages)
+    {
+        page->Submitted(fenceValue);
+        page->ReleaseStale(completedFenceValue);
+    }
+}
+
+void DescriptorAllocator::FlushThreadCache()
+{
+    ThreadCache& cache = gs_ThreadCaches[m_HeapType];
+    if (cache.AllocatorId == m_Id)
+    {
+        cache.Flush();
+    }
+}
+
+DescriptorAllocator::Statistics DescriptorAllocator::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Statistics statistics;
+    statistics.NumPages = static_cast<uint32_t>(m_Pages.size());
+    for (const auto& page : m_Pages)
+    {
+        statistics.NumDescriptors += page->GetNumDescriptors();
+        statistics.NumFreeDescriptors += page->GetNumFreeDescriptors();
+        statistics.NumStaleDescriptors += page->GetNumStaleDescriptors();
+    }
+
+    return statistics;
+}
@@ -0,0 +1,122 @@
+#include <DescriptorRangeAllocator.h>
+
+#include <cassert>
+#include <iterator>
+
+DescriptorRangeAllocator::DescriptorRangeAllocator(uint32_t numDescriptors)
+    : m_NumDescriptors(numDescriptors)
+    , m_NumFreeDescriptors(0)
+    , m_NumStaleDescriptors(0)
+{
+    assert(numDescriptors > 0 && "A page needs at least one descriptor.");
+    AddFreeRange(0, numDescriptors);
+}
+
+DescriptorRangeAllocator::~DescriptorRangeAllocator()
+{
+}
+
+void DescriptorRangeAllocator::AddFreeRange(uint32_t offset, uint32_t numDescriptors)
+{
+    auto offsetIt = m_FreeListByOffset.emplace(offset, FreeRange{ numDescriptors, FreeListBySize::iterator() }).first;
+    offsetIt->second.BySize = m_FreeListBySize.emplace(numDescriptors, offsetIt);
+    m_NumFreeDescriptors += numDescriptors;
+}
+
+uint32_t DescriptorRangeAllocator::Allocate(uint32_t numDescriptors)
+{
+    assert(numDescriptors > 0 && "Allocating an empty range.");
+
+    // 最佳适配: the smallest free range that is large enough.
+    auto sizeIt = m_FreeListBySize.lower_bound(numDescriptors);
+    if (sizeIt == m_FreeListBySize.end())
+    {
+        return InvalidOffset;
+    }
+
+    FreeListByOffset::iterator offsetIt = sizeIt->second;
+    const uint32_t offset = offsetIt->first;
+    const uint32_t size = sizeIt->first;
+
+    m_FreeListBySize.erase(sizeIt);
+    m_FreeListByOffset.erase(offsetIt);
+    m_NumFreeDescriptors -= size;
+
+    // The rest of the range stays free.
+    if (size > numDescriptors)
+    {
+        AddFreeRange(offset + numDescriptors, size - numDescriptors);
+    }
+
+    return offset;
+}
+
+void DescriptorRangeAllocator::Free(uint32_t offset, uint32_t numDescriptors)
+{
+    assert(numDescriptors > 0 && offset + numDescriptors <= m_NumDescriptors && "The range is not part of the page.");
+
+    m_PendingRanges.push_back(StaleRange{ offset, numDescriptors, 0 });
+    m_NumStaleDescriptors += numDescriptors;
+}
+
+void DescriptorRangeAllocator::Submitted(uint64_t fenceValue)
+{
+    assert((m_StaleRanges.empty() || m_StaleRanges.back().FenceValue <= fenceValue) &&
+        "Fence values must increase.");
+
+    for (StaleRange& range : m_PendingRanges)
+    {
+        range.FenceValue = fenceValue;
+        m_StaleRanges.push_back(range);
+    }
+    m_PendingRanges.clear();
+}
+
+void DescriptorRangeAllocator::ReleaseStale(uint64_t completedFenceValue)
+{
+    while (!m_StaleRanges.empty() && m_StaleRanges.front().FenceValue <= completedFenceValue)
+    {
+        const StaleRange& range = m_StaleRanges.front();
+        FreeRangeNow(range.Offset, range.Size);
+        m_NumStaleDescriptors -= range.Size;
+        m_StaleRanges.pop_front();
+    }
+}
+
+void DescriptorRangeAllocator::FreeRangeNow(uint32_t offset, uint32_t numDescriptors)
+{
+    // 与相邻的空闲区间合并
+    auto nextIt = m_FreeListByOffset.upper_bound(offset);
+    assert((nextIt == m_FreeListByOffset.end() || offset + numDescriptors <= nextIt->first) &&
+        "Freeing a range that is already free.");
+
+    if (nextIt != m_FreeListByOffset.begin())
+    {
+        auto prevIt = std::prev(nextIt);
+        assert(prevIt->first + prevIt->second.Size <= offset && "Freeing a range that is already free.");
+
+        if (prevIt->first + prevIt->second.Size == offset)
+        {
+            offset = prevIt->first;
+            numDescriptors += prevIt->second.Size;
+            m_NumFreeDescriptors -= prevIt->second.Size;
+            m_FreeListBySize.erase(prevIt->second.BySize);
+            m_FreeListByOffset.erase(prevIt);
+        }
+    }
+
+    if (nextIt != m_FreeListByOffset.end() && offset + numDescriptors == nextIt->first)
+    {
+        numDescriptors += nextIt->second.Size;
+        m_NumFreeDescriptors -= nextIt->second.Size;
+        m_FreeListBySize.erase(nextIt->second.BySize);
+        m_FreeListByOffset.erase(nextIt);
+    }
+
+    AddFreeRange(offset, numDescriptors);
+}
+
+uint32_t DescriptorRangeAllocator::GetLargestFreeRange() const
+{
+    return m_FreeListBySize.empty() ? 0 : m_FreeListBySize.rbegin()->first;
+}
@@ -0,0 +1,70 @@
+#include <DescriptorRingAllocator.h>
+
+#include <cassert>
+
+DescriptorRingAllocator::DescriptorRingAllocator(uint32_t numDescriptors)
+    : m_NumDescriptors(numDescriptors)
+    , m_Head(0)
+    , m_NumUsedDescriptors(0)
+    , m_NumPendingDescriptors(0)
+{
+    assert(numDescriptors > 0 && "The ring needs at least one descriptor.");
+}
+
+DescriptorRingAllocator::~DescriptorRingAllocator()
+{
+}
+
+uint32_t DescriptorRingAllocator::Allocate(uint32_t numDescriptors)
+{
+    assert(numDescriptors > 0 && "Allocating an empty range.");
+
+    // 环为空: start over at 0, so nothing is skipped at the end.
+    if (m_NumUsedDescriptors == 0)
+    {
+        m_Head = 0;
+    }
+
+    // The free descriptors start at the head and may wrap around the end of the ring.
+    const uint32_t numFree = m_NumDescriptors - m_NumUsedDescriptors;
+    uint32_t offset = m_Head;
+    uint32_t size = numDescriptors;
+
+    if (m_Head + numDescriptors > m_NumDescriptors)
+    {
+        // 跳过环的末尾 and continue at the start.
+        offset = 0;
+        size += m_NumDescriptors - m_Head;
+    }
+
+    if (size > numFree)
+    {
+        return InvalidOffset;
+    }
+
+    m_Head = (offset + numDescriptors) % m_NumDescriptors;
+    m_NumUsedDescriptors += size;
+    m_NumPendingDescriptors += size;
+
+    return offset;
+}
+
+void DescriptorRingAllocator::Submitted(uint64_t fenceValue)
+{
+    assert((m_Submissions.empty() || m_Submissions.back().FenceValue <= fenceValue) && "Fence values must increase.");
+
+    if (m_NumPendingDescriptors > 0)
+    {
+        m_Submissions.push_back(Submission{ fenceValue, m_NumPendingDescriptors });
+        m_NumPendingDescriptors = 0;
+    }
+}
+
+void DescriptorRingAllocator::ReleaseCompleted(uint64_t completedFenceValue)
+{
+    while (!m_Submissions.empty() && m_Submissions.front().FenceValue <= completedFenceValue)
+    {
+        m_NumUsedDescriptors -= m_Submissions.front().NumDescriptors;
+        m_Submissions.pop_front();
+    }
+}
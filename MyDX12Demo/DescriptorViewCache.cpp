@@ -0,0 +1,467 @@
+#include <DescriptorViewCache.h>
+#include <DX12LibPCH.h>
+#include <Hash.h>
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * 资源释放通知: attached to a resource as private data, the resource releases it when it
+ * is destroyed and the last Release drops the cached views of the resource.
+ */
+class ResourceReleaseNotifier : public IUnknown
+{
+public:
+    ResourceReleaseNotifier(std::shared_ptr<DescriptorViewCache::Tracker> tracker, ID3D12Resource* pResource)
+        : m_RefCount(1)
+        , m_Tracker(tracker)
+        , m_pResource(pResource)
+    {
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+    {
+        if (!ppvObject)
+        {
+            return E_POINTER;
+        }
+        if (riid == __uuidof(IUnknown))
+        {
+            *ppvObject = static_cast<IUnknown*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppvObject = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return InterlockedIncrement(&m_RefCount);
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG refCount = InterlockedDecrement(&m_RefCount);
+        if (refCount == 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Tracker->Mutex);
+                if (m_Tracker->pCache)
+                {
+                    m_Tracker->pCache->InvalidateLocked(m_pResource);
+                }
+            }
+            delete this;
+        }
+        return refCount;
+    }
+
+private:
+    volatile ULONG m_RefCount;
+    std::shared_ptr<DescriptorViewCache::Tracker> m_Tracker;
+    // Only used as the key, the resource is being destroyed when the notifier is.
+    ID3D12Resource* m_pResource;
+};
+
+void DescriptorViewCache::ViewKey::AddField(uint64_t value)
+{
+    assert(NumFields < MaxFields);
+    Fields[NumFields++] = value;
+}
+
+void DescriptorViewCache::ViewKey::AddField(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    AddField(static_cast<uint64_t>(bits));
+}
+
+void DescriptorViewCache::ViewKey::Finalize()
+{
+    Hash = HashValue(reinterpret_cast<uintptr_t>(pResource));
+    Hash = HashValue(static_cast<uint32_t>(Type), Hash);
+    Hash = HashValue(HasDesc, Hash);
+    Hash = HashBytes(Fields, NumFields * sizeof(uint64_t), Hash);
+}
+
+bool DescriptorViewCache::ViewKey::operator==(const ViewKey& other) const
+{
+    return Hash == other.Hash && pResource == other.pResource && Type == other.Type && HasDesc == other.HasDesc &&
+        NumFields == other.NumFields && std::equal(Fields, Fields + NumFields, other.Fields);
+}
+
+DescriptorViewCache::ViewKey DescriptorViewCache::MakeKey(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc)
+{
+    ViewKey key;
+    key.pResource = pResource;
+    key.Type = ShaderResourceView;
+    key.HasDesc = pDesc != nullptr;
+    if (pDesc)
+    {
+        key.AddField(static_cast<uint64_t>(pDesc->Format));
+        key.AddField(static_cast<uint64_t>(pDesc->ViewDimension));
+        key.AddField(static_cast<uint64_t>(pDesc->Shader4ComponentMapping));
+
+        switch (pDesc->ViewDimension)
+        {
+        case D3D12_SRV_DIMENSION_BUFFER:
+            key.AddField(pDesc->Buffer.FirstElement);
+            key.AddField(static_cast<uint64_t>(pDesc->Buffer.NumElements));
+            key.AddField(static_cast<uint64_t>(pDesc->Buffer.StructureByteStride));
+            key.AddField(static_cast<uint64_t>(pDesc->Buffer.Flags));
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE1D:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1D.MostDetailedMip));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1D.MipLevels));
+            key.AddField(pDesc->Texture1D.ResourceMinLODClamp);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE1DARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.MostDetailedMip));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.MipLevels));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.FirstArraySlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.ArraySize));
+            key.AddField(pDesc->Texture1DArray.ResourceMinLODClamp);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE2D:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2D.MostDetailedMip));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2D.MipLevels));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2D.PlaneSlice));
+            key.AddField(pDesc->Texture2D.ResourceMinLODClamp);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE2DARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.MostDetailedMip));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.MipLevels));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.FirstArraySlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.ArraySize));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.PlaneSlice));
+            key.AddField(pDesc->Texture2DArray.ResourceMinLODClamp);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE2DMS:
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE2DMSARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DMSArray.FirstArraySlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DMSArray.ArraySize));
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE3D:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture3D.MostDetailedMip));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture3D.MipLevels));
+            key.AddField(pDesc->Texture3D.ResourceMinLODClamp);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURECUBE:
+            key.AddField(static_cast<uint64_t>(pDesc->TextureCube.MostDetailedMip));
+            key.AddField(static_cast<uint64_t>(pDesc->TextureCube.MipLevels));
+            key.AddField(pDesc->TextureCube.ResourceMinLODClamp);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURECUBEARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->TextureCubeArray.MostDetailedMip));
+            key.AddField(static_cast<uint64_t>(pDesc->TextureCubeArray.MipLevels));
+            key.AddField(static_cast<uint64_t>(pDesc->TextureCubeArray.First2DArrayFace));
+            key.AddField(static_cast<uint64_t>(pDesc->TextureCubeArray.NumCubes));
+            key.AddField(pDesc->TextureCubeArray.ResourceMinLODClamp);
+            break;
+        default:
+            assert(false && "Unsupported SRV dimension.");
+            break;
+        }
+    }
+
+    key.Finalize();
+    return key;
+}
+
+DescriptorViewCache::ViewKey DescriptorViewCache::MakeKey(ID3D12Resource* pResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc)
+{
+    ViewKey key;
+    key.pResource = pResource;
+    key.Type = UnorderedAccessView;
+    key.HasDesc = pDesc != nullptr;
+    if (pDesc)
+    {
+        key.AddField(static_cast<uint64_t>(pDesc->Format));
+        key.AddField(static_cast<uint64_t>(pDesc->ViewDimension));
+
+        switch (pDesc->ViewDimension)
+        {
+        case D3D12_UAV_DIMENSION_BUFFER:
+            key.AddField(pDesc->Buffer.FirstElement);
+            key.AddField(static_cast<uint64_t>(pDesc->Buffer.NumElements));
+            key.AddField(static_cast<uint64_t>(pDesc->Buffer.StructureByteStride));
+            key.AddField(pDesc->Buffer.CounterOffsetInBytes);
+            key.AddField(static_cast<uint64_t>(pDesc->Buffer.Flags));
+            break;
+        case D3D12_UAV_DIMENSION_TEXTURE1D:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1D.MipSlice));
+            break;
+        case D3D12_UAV_DIMENSION_TEXTURE1DARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.MipSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.FirstArraySlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.ArraySize));
+            break;
+        case D3D12_UAV_DIMENSION_TEXTURE2D:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2D.MipSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2D.PlaneSlice));
+            break;
+        case D3D12_UAV_DIMENSION_TEXTURE2DARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.MipSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.FirstArraySlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.ArraySize));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.PlaneSlice));
+            break;
+        case D3D12_UAV_DIMENSION_TEXTURE3D:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture3D.MipSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture3D.FirstWSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture3D.WSize));
+            break;
+        default:
+            assert(false && "Unsupported UAV dimension.");
+            break;
+        }
+    }
+
+    key.Finalize();
+    return key;
+}
+
+DescriptorViewCache::ViewKey DescriptorViewCache::MakeKey(ID3D12Resource* pResource, const D3D12_RENDER_TARGET_VIEW_DESC* pDesc)
+{
+    ViewKey key;
+    key.pResource = pResource;
+    key.Type = RenderTargetView;
+    key.HasDesc = pDesc != nullptr;
+    if (pDesc)
+    {
+        key.AddField(static_cast<uint64_t>(pDesc->Format));
+        key.AddField(static_cast<uint64_t>(pDesc->ViewDimension));
+
+        switch (pDesc->ViewDimension)
+        {
+        case D3D12_RTV_DIMENSION_BUFFER:
+            key.AddField(pDesc->Buffer.FirstElement);
+            key.AddField(static_cast<uint64_t>(pDesc->Buffer.NumElements));
+            break;
+        case D3D12_RTV_DIMENSION_TEXTURE1D:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1D.MipSlice));
+            break;
+        case D3D12_RTV_DIMENSION_TEXTURE1DARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.MipSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.FirstArraySlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.ArraySize));
+            break;
+        case D3D12_RTV_DIMENSION_TEXTURE2D:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2D.MipSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2D.PlaneSlice));
+            break;
+        case D3D12_RTV_DIMENSION_TEXTURE2DARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.MipSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.FirstArraySlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.ArraySize));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.PlaneSlice));
+            break;
+        case D3D12_RTV_DIMENSION_TEXTURE2DMS:
+            break;
+        case D3D12_RTV_DIMENSION_TEXTURE2DMSARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DMSArray.FirstArraySlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DMSArray.ArraySize));
+            break;
+        case D3D12_RTV_DIMENSION_TEXTURE3D:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture3D.MipSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture3D.FirstWSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture3D.WSize));
+            break;
+        default:
+            assert(false && "Unsupported RTV dimension.");
+            break;
+        }
+    }
+
+    key.Finalize();
+    return key;
+}
+
+DescriptorViewCache::ViewKey DescriptorViewCache::MakeKey(ID3D12Resource* pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc)
+{
+    ViewKey key;
+    key.pResource = pResource;
+    key.Type = DepthStencilView;
+    key.HasDesc = pDesc != nullptr;
+    if (pDesc)
+    {
+        key.AddField(static_cast<uint64_t>(pDesc->Format));
+        key.AddField(static_cast<uint64_t>(pDesc->ViewDimension));
+        key.AddField(static_cast<uint64_t>(pDesc->Flags));
+
+        switch (pDesc->ViewDimension)
+        {
+        case D3D12_DSV_DIMENSION_TEXTURE1D:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1D.MipSlice));
+            break;
+        case D3D12_DSV_DIMENSION_TEXTURE1DARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.MipSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.FirstArraySlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture1DArray.ArraySize));
+            break;
+        case D3D12_DSV_DIMENSION_TEXTURE2D:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2D.MipSlice));
+            break;
+        case D3D12_DSV_DIMENSION_TEXTURE2DARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.MipSlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.FirstArraySlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DArray.ArraySize));
+            break;
+        case D3D12_DSV_DIMENSION_TEXTURE2DMS:
+            break;
+        case D3D12_DSV_DIMENSION_TEXTURE2DMSARRAY:
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DMSArray.FirstArraySlice));
+            key.AddField(static_cast<uint64_t>(pDesc->Texture2DMSArray.ArraySize));
+            break;
+        default:
+            assert(false && "Unsupported DSV dimension.");
+            break;
+        }
+    }
+
+    key.Finalize();
+    return key;
+}
+
+DescriptorViewCache::DescriptorViewCache(Microsoft::WRL::ComPtr<ID3D12Device2> device, AllocateDescriptorsFunc allocateDescriptors)
+    : m_d3d12Device(device)
+    , m_AllocateDescriptors(allocateDescriptors)
+    , m_Tracker(std::make_shared<Tracker>())
+{
+    ThrowIfFailed(CoCreateGuid(&m_PrivateDataGuid));
+    m_Tracker->pCache = this;
+}
+
+DescriptorViewCache::~DescriptorViewCache()
+{
+    // Resources that are still alive keep their notifiers, which now do nothing.
+    std::lock_guard<std::mutex> lock(m_Tracker->Mutex);
+    m_Tracker->pCache = nullptr;
+    m_Views.clear();
+    m_ResourceViews.clear();
+}
+
+template<typename CreateViewFunc>
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorViewCache::GetView(const ViewKey& key, D3D12_DESCRIPTOR_HEAP_TYPE heapType, CreateViewFunc&& createView)
+{
+    auto it = m_Views.find(key);
+    if (it != m_Views.end())
+    {
+        ++m_Statistics.NumHits;
+        return it->second.GetDescriptorHandle();
+    }
+
+    ++m_Statistics.NumMisses;
+
+    DescriptorAllocation allocation = m_AllocateDescriptors(heapType);
+    D3D12_CPU_DESCRIPTOR_HANDLE descriptor = allocation.GetDescriptorHandle();
+    createView(descriptor);
+
+    if (key.pResource)
+    {
+        TrackResource(key.pResource);
+        m_ResourceViews[key.pResource].push_back(key);
+    }
+    m_Views.emplace(key, std::move(allocation));
+
+    return descriptor;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorViewCache::GetShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc)
+{
+    ViewKey key = MakeKey(pResource, pDesc);
+
+    std::lock_guard<std::mutex> lock(m_Tracker->Mutex);
+    return GetView(key, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, [&](D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
+    {
+        m_d3d12Device->CreateShaderResourceView(pResource, pDesc, descriptor);
+    });
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorViewCache::GetUnorderedAccessView(ID3D12Resource* pResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc)
+{
+    ViewKey key = MakeKey(pResource, pDesc);
+
+    std::lock_guard<std::mutex> lock(m_Tracker->Mutex);
+    return GetView(key, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, [&](D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
+    {
+        m_d3d12Device->CreateUnorderedAccessView(pResource, nullptr, pDesc, descriptor);
+    });
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorViewCache::GetRenderTargetView(ID3D12Resource* pResource, const D3D12_RENDER_TARGET_VIEW_DESC* pDesc)
+{
+    ViewKey key = MakeKey(pResource, pDesc);
+
+    std::lock_guard<std::mutex> lock(m_Tracker->Mutex);
+    return GetView(key, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, [&](D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
+    {
+        m_d3d12Device->CreateRenderTargetView(pResource, pDesc, descriptor);
+    });
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorViewCache::GetDepthStencilView(ID3D12Resource* pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc)
+{
+    ViewKey key = MakeKey(pResource, pDesc);
+
+    std::lock_guard<std::mutex> lock(m_Tracker->Mutex);
+    return GetView(key, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, [&](D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
+    {
+        m_d3d12Device->CreateDepthStencilView(pResource, pDesc, descriptor);
+    });
+}
+
+void DescriptorViewCache::TrackResource(ID3D12Resource* pResource)
+{
+    if (m_ResourceViews.find(pResource) != m_ResourceViews.end())
+    {
+        return;
+    }
+
+    // A tracked resource always has its views in m_ResourceViews, so the resource has no notifier of this
+    // cache yet. Replacing one here would release it with the mutex held, and its Release takes the mutex.
+    // The resource holds the only reference to the notifier from now on.
+    ResourceReleaseNotifier* pNotifier = new ResourceReleaseNotifier(m_Tracker, pResource);
+    HRESULT hr = pResource->SetPrivateDataInterface(m_PrivateDataGuid, pNotifier);
+    pNotifier->Release();
+    ThrowIfFailed(hr);
+}
+
+void DescriptorViewCache::Invalidate(ID3D12Resource* pResource)
+{
+    // 先分离通知对象, without the mutex: releasing the notifier takes the mutex and drops the views, and the
+    // resource is tracked again (with a new notifier) when one of its views is requested next.
+    pResource->SetPrivateDataInterface(m_PrivateDataGuid, nullptr);
+
+    std::lock_guard<std::mutex> lock(m_Tracker->Mutex);
+    InvalidateLocked(pResource);
+}
+
+void DescriptorViewCache::InvalidateLocked(ID3D12Resource* pResource)
+{
+    auto it = m_ResourceViews.find(pResource);
+    if (it == m_ResourceViews.end())
+    {
+        return;
+    }
+
+    // The descriptors go back to the descriptor allocator, which waits for the GPU.
+    for (const ViewKey& key : it->second)
+    {
+        m_Views.erase(key);
+    }
+    m_Statistics.NumInvalidatedViews += it->second.size();
+    m_ResourceViews.erase(it);
+}
+
+DescriptorViewCache::Statistics DescriptorViewCache::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Tracker->Mutex);
+
+    Statistics statistics = m_Statistics;
+    statistics.NumViews = static_cast<uint32_t>(m_Views.size());
+    statistics.NumResources = static_cast<uint32_t>(m_ResourceViews.size());
+    return statistics;
+}
@@ -0,0 +1,300 @@
+#include <DynamicDescriptorHeap.h>
+#include <DX12LibPCH.h>
+
+namespace
+{
+    bool IsSamplerRange(D3D12_DESCRIPTOR_RANGE_TYPE rangeType)
+    {
+        return rangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER;
+    }
+
+    // Number of descriptors of a descriptor table, for version 1.0 and 1.1 root parameters.
+    template<typename RootParameter>
+    uint32_t GetDescriptorTableSize(const RootParameter& rootParameter, D3D12_DESCRIPTOR_HEAP_TYPE heapType)
+    {
+        if (rootParameter.ParameterType != D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE ||
+            rootParameter.DescriptorTable.NumDescriptorRanges == 0)
+        {
+            return 0;
+        }
+
+        // A table holds either samplers or CBVs/SRVs/UAVs.
+        bool isSamplerTable = IsSamplerRange(rootParameter.DescriptorTable.pDescriptorRanges[0].RangeType);
+        if (isSamplerTable != (heapType == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER))
+        {
+            return 0;
+        }
+
+        uint32_t tableSize = 0;
+        uint32_t appendOffset = 0;
+        for (UINT i = 0; i < rootParameter.DescriptorTable.NumDescriptorRanges; ++i)
+        {
+            const auto& range = rootParameter.DescriptorTable.pDescriptorRanges[i];
+            assert(range.NumDescriptors != UINT_MAX && "Unbounded descriptor ranges can not be staged.");
+
+            uint32_t offset = range.OffsetInDescriptorsFromTableStart == D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND ?
+                appendOffset : range.OffsetInDescriptorsFromTableStart;
+            appendOffset = offset + range.NumDescriptors;
+            tableSize = std::max(tableSize, appendOffset);
+        }
+
+        return tableSize;
+    }
+}
+
+DynamicDescriptorHeap::DynamicDescriptorHeap(Microsoft::WRL::ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t numDescriptors)
+    : m_d3d12Device(device)
+    , m_HeapType(heapType)
+    , m_DescriptorSize(device->GetDescriptorHandleIncrementSize(heapType))
+    , m_BaseCPUDescriptor{ 0 }
+    , m_BaseGPUDescriptor{ 0 }
+    , m_Ring(numDescriptors)
+    , m_PairedHeap(nullptr)
+    , m_HeapBound(false)
+    , m_DescriptorTableBitMask(0)
+    , m_StaleDescriptorTableBitMask(0)
+{
+    assert((heapType == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV || heapType == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER) &&
+        "Only CBV/SRV/UAV and sampler heaps can be shader visible.");
+
+    CreateHeap(numDescriptors);
+}
+
+DynamicDescriptorHeap::~DynamicDescriptorHeap()
+{
+}
+
+void DynamicDescriptorHeap::CreateHeap(uint32_t numDescriptors)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.Type = m_HeapType;
+    heapDesc.NumDescriptors = numDescriptors;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+    ThrowIfFailed(m_d3d12Device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_d3d12DescriptorHeap)));
+
+    m_BaseCPUDescriptor = m_d3d12DescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    m_BaseGPUDescriptor = m_d3d12DescriptorHeap->GetGPUDescriptorHandleForHeapStart();
+    m_Ring = DescriptorRingAllocator(numDescriptors);
+    m_Statistics.NumDescriptors = numDescriptors;
+}
+
+void DynamicDescriptorHeap::SetPairedHeap(DynamicDescriptorHeap* pPairedHeap)
+{
+    assert((!pPairedHeap || pPairedHeap->m_HeapType != m_HeapType) && "The paired heap must have the other heap type.");
+    m_PairedHeap = pPairedHeap;
+}
+
+void DynamicDescriptorHeap::ParseRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& rootSignatureDesc)
+{
+    m_DescriptorTableBitMask = 0;
+
+    uint32_t numParameters = rootSignatureDesc.Version == D3D_ROOT_SIGNATURE_VERSION_1_0 ?
+        rootSignatureDesc.Desc_1_0.NumParameters : rootSignatureDesc.Desc_1_1.NumParameters;
+    assert(numParameters <= MaxDescriptorTables && "Too many root parameters.");
+
+    uint32_t numDescriptors = 0;
+    for (uint32_t i = 0; i < numParameters && i < MaxDescriptorTables; ++i)
+    {
+        uint32_t tableSize = rootSignatureDesc.Version == D3D_ROOT_SIGNATURE_VERSION_1_0 ?
+            GetDescriptorTableSize(rootSignatureDesc.Desc_1_0.pParameters[i], m_HeapType) :
+            GetDescriptorTableSize(rootSignatureDesc.Desc_1_1.pParameters[i], m_HeapType);
+
+        m_DescriptorTableCache[i].NumDescriptors = tableSize;
+        m_DescriptorTableCache[i].BaseOffset = numDescriptors;
+        if (tableSize > 0)
+        {
+            m_DescriptorTableBitMask |= 1ull << i;
+            numDescriptors += tableSize;
+        }
+    }
+
+    m_DescriptorHandleCache.assign(numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE{ 0 });
+    m_StaleDescriptorTableBitMask = m_DescriptorTableBitMask;
+}
+
+void DynamicDescriptorHeap::StageDescriptors(uint32_t rootParameterIndex, uint32_t offset, uint32_t numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor)
+{
+    assert(rootParameterIndex < MaxDescriptorTables && (m_DescriptorTableBitMask & (1ull << rootParameterIndex)) != 0 &&
+        "The root parameter is not a descriptor table of this heap type.");
+
+    const DescriptorTableCache& table = m_DescriptorTableCache[rootParameterIndex];
+    assert(offset + numDescriptors <= table.NumDescriptors && "The descriptors do not fit in the descriptor table.");
+
+    for (uint32_t i = 0; i < numDescriptors; ++i)
+    {
+        m_DescriptorHandleCache[table.BaseOffset + offset + i] = CD3DX12_CPU_DESCRIPTOR_HANDLE(srcDescriptor, i, m_DescriptorSize);
+    }
+
+    m_StaleDescriptorTableBitMask |= 1ull << rootParameterIndex;
+}
+
+void DynamicDescriptorHeap::CommitStagedDescriptorsForDraw(ID3D12GraphicsCommandList2* commandList)
+{
+    CommitStagedDescriptors(commandList, [](ID3D12GraphicsCommandList2* commandList, UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+    {
+        commandList->SetGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+    });
+}
+
+void DynamicDescriptorHeap::CommitStagedDescriptorsForDispatch(ID3D12GraphicsCommandList2* commandList)
+{
+    CommitStagedDescriptors(commandList, [](ID3D12GraphicsCommandList2* commandList, UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+    {
+        commandList->SetComputeRootDescriptorTable(rootParameterIndex, baseDescriptor);
+    });
+}
+
+void DynamicDescriptorHeap::CommitStagedDescriptors(ID3D12GraphicsCommandList2* commandList, const SetRootTableFunc& setRootTable)
+{
+    if (m_StaleDescriptorTableBitMask == 0)
+    {
+        return;
+    }
+
+    auto countStaleDescriptors = [this]()
+    {
+        uint32_t numStaleDescriptors = 0;
+        for (uint32_t i = 0; i < MaxDescriptorTables; ++i)
+        {
+            if (m_StaleDescriptorTableBitMask & (1ull << i))
+            {
+                numStaleDescriptors += m_DescriptorTableCache[i].NumDescriptors;
+            }
+        }
+        return numStaleDescriptors;
+    };
+
+    uint32_t numStaleDescriptors = countStaleDescriptors();
+    uint32_t ringOffset = m_Ring.Allocate(numStaleDescriptors);
+    if (ringOffset == DescriptorRingAllocator::InvalidOffset)
+    {
+        // 环已满: switch to a larger heap. The tables set so far point into the old heap, so all
+        // of them are copied again. The old heap may be used by this command list.
+        m_PendingRetiredHeaps.push_back(m_d3d12DescriptorHeap);
+        CreateHeap(std::max(m_Ring.GetNumDescriptors() * 2, numStaleDescriptors * 2));
+        m_HeapBound = false;
+
+        m_StaleDescriptorTableBitMask = m_DescriptorTableBitMask;
+        numStaleDescriptors = countStaleDescriptors();
+        ringOffset = m_Ring.Allocate(numStaleDescriptors);
+        assert(ringOffset != DescriptorRingAllocator::InvalidOffset);
+    }
+
+    BindHeaps(commandList);
+
+    // Gather the contiguous runs of staged descriptors for one batched copy.
+    m_SrcDescriptorRanges.clear();
+    m_DstDescriptorRanges.clear();
+    m_DescriptorRangeSizes.clear();
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE dstDescriptor(m_BaseCPUDescriptor, ringOffset, m_DescriptorSize);
+    CD3DX12_GPU_DESCRIPTOR_HANDLE gpuDescriptor(m_BaseGPUDescriptor, ringOffset, m_DescriptorSize);
+    for (uint32_t i = 0; i < MaxDescriptorTables; ++i)
+    {
+        if ((m_StaleDescriptorTableBitMask & (1ull << i)) == 0)
+        {
+            continue;
+        }
+
+        const DescriptorTableCache& table = m_DescriptorTableCache[i];
+        for (uint32_t j = 0; j < table.NumDescriptors; ++j)
+        {
+            D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor = m_DescriptorHandleCache[table.BaseOffset + j];
+            D3D12_CPU_DESCRIPTOR_HANDLE dst = CD3DX12_CPU_DESCRIPTOR_HANDLE(dstDescriptor, j, m_DescriptorSize);
+
+            // Descriptors that were never staged are left out, the shader must not access them.
+            if (srcDescriptor.ptr == 0)
+            {
+                continue;
+            }
+
+            if (!m_DescriptorRangeSizes.empty() &&
+                m_SrcDescriptorRanges.back().ptr + m_DescriptorRangeSizes.back() * m_DescriptorSize == srcDescriptor.ptr &&
+                m_DstDescriptorRanges.back().ptr + m_DescriptorRangeSizes.back() * m_DescriptorSize == dst.ptr)
+            {
+                ++m_DescriptorRangeSizes.back();
+            }
+            else
+            {
+                m_SrcDescriptorRanges.push_back(srcDescriptor);
+                m_DstDescriptorRanges.push_back(dst);
+                m_DescriptorRangeSizes.push_back(1);
+            }
+        }
+
+        setRootTable(commandList, i, gpuDescriptor);
+
+        dstDescriptor.Offset(table.NumDescriptors, m_DescriptorSize);
+        gpuDescriptor.Offset(table.NumDescriptors, m_DescriptorSize);
+    }
+
+    if (!m_DescriptorRangeSizes.empty())
+    {
+        UINT numRanges = static_cast<UINT>(m_DescriptorRangeSizes.size());
+        m_d3d12Device->CopyDescriptors(numRanges, m_DstDescriptorRanges.data(), m_DescriptorRangeSizes.data(),
+            numRanges, m_SrcDescriptorRanges.data(), m_DescriptorRangeSizes.data(), m_HeapType);
+
+        m_Statistics.NumCopiedRanges += numRanges;
+        for (UINT rangeSize : m_DescriptorRangeSizes)
+        {
+            m_Statistics.NumCopiedDescriptors += rangeSize;
+        }
+    }
+
+    ++m_Statistics.NumCommits;
+    m_StaleDescriptorTableBitMask = 0;
+}
+
+void DynamicDescriptorHeap::BindHeaps(ID3D12GraphicsCommandList2* commandList)
+{
+    if (m_HeapBound)
+    {
+        return;
+    }
+
+    ID3D12DescriptorHeap* heaps[2] = { m_d3d12DescriptorHeap.Get(), nullptr };
+    UINT numHeaps = 1;
+    if (m_PairedHeap)
+    {
+        heaps[numHeaps++] = m_PairedHeap->GetHeap();
+        m_PairedHeap->m_HeapBound = true;
+        // SetDescriptorHeaps invalidates the descriptor tables set so far, the paired heap's tables
+        // must be set again at its next commit even though its heap did not change.
+        m_PairedHeap->m_StaleDescriptorTableBitMask = m_PairedHeap->m_DescriptorTableBitMask;
+    }
+
+    commandList->SetDescriptorHeaps(numHeaps, heaps);
+    m_HeapBound = true;
+}
+
+void DynamicDescriptorHeap::BeginCommandList(uint64_t completedFenceValue)
+{
+    // A new command list has no heaps and no descriptor tables set.
+    m_HeapBound = false;
+    m_StaleDescriptorTableBitMask = m_DescriptorTableBitMask;
+
+    m_Ring.ReleaseCompleted(completedFenceValue);
+    while (!m_RetiredHeaps.empty() && m_RetiredHeaps.front().FenceValue <= completedFenceValue)
+    {
+        m_RetiredHeaps.pop_front();
+    }
+}
+
+void DynamicDescriptorHeap::Submitted(uint64_t fenceValue)
+{
+    m_Ring.Submitted(fenceValue);
+
+    for (auto& heap : m_PendingRetiredHeaps)
+    {
+        m_RetiredHeaps.push_back(RetiredHeap{ fenceValue, heap });
+    }
+    m_PendingRetiredHeaps.clear();
+}
+
+DynamicDescriptorHeap::Statistics DynamicDescriptorHeap::GetStatistics() const
+{
+    Statistics statistics = m_Statistics;
+    statistics.NumUsedDescriptors = m_Ring.GetNumUsedDescriptors();
+    return statistics;
+}
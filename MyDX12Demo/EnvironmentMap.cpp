@@ -0,0 +1,748 @@
+#include <EnvironmentMap.h>
+
+#include <Hash.h>
+#include <MipGenerator.h>
+#include <TextureFile.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <emmintrin.h> // SSE2
+
+namespace
+{
+    const float Pi = 3.14159265358979f;
+
+    // Cubemap with all mips in linear RGBA floats, Faces[mip * 6 + face].
+    struct FloatCubemap
+    {
+        uint32_t Size = 0;
+        uint32_t MipLevels = 0;
+        std::vector< std::vector<float> > Faces;
+
+        void Initialize(uint32_t size, uint32_t mipLevels)
+        {
+            Size = size;
+            MipLevels = mipLevels;
+            Faces.resize(size_t(mipLevels) * 6);
+            for (uint32_t mip = 0; mip < mipLevels; ++mip)
+            {
+                for (uint32_t face = 0; face < 6; ++face)
+                {
+                    Faces[mip * 6 + face].assign(size_t(GetSize(mip)) * GetSize(mip) * 4, 0.0f);
+                }
+            }
+        }
+
+        uint32_t GetSize(uint32_t mip) const
+        {
+            return std::max(Size >> mip, 1u);
+        }
+
+        float* GetFace(uint32_t mip, uint32_t face)
+        {
+            return Faces[mip * 6 + face].data();
+        }
+
+        const float* GetFace(uint32_t mip, uint32_t face) const
+        {
+            return Faces[mip * 6 + face].data();
+        }
+    };
+
+    bool IsFloatFormat(TextureFormat format)
+    {
+        return format == TextureFormat::RGBA32Float || format == TextureFormat::RGBA16Float;
+    }
+
+    void DecodeSubresource(const TextureData& texture, uint32_t mip, uint32_t slice, float* pDest)
+    {
+        const TextureSubresource& subresource = texture.GetSubresource(mip, slice);
+        const size_t count = size_t(subresource.Width) * subresource.Height * 4;
+        if (texture.Format == TextureFormat::RGBA32Float)
+        {
+            memcpy(pDest, texture.GetPixels(mip, slice), count * sizeof(float));
+        }
+        else
+        {
+            const uint16_t* pHalf = reinterpret_cast<const uint16_t*>(texture.GetPixels(mip, slice));
+            for (size_t i = 0; i < count; ++i)
+            {
+                pDest[i] = HalfToFloat(pHalf[i]);
+            }
+        }
+    }
+
+    // Encode a row of RGB to RGBA16F with alpha 1.
+    void EncodeRow(const float* pSrc, uint32_t width, uint8_t* pDest)
+    {
+        uint16_t* pHalf = reinterpret_cast<uint16_t*>(pDest);
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            pHalf[x * 4 + 0] = FloatToHalf(pSrc[x * 4 + 0]);
+            pHalf[x * 4 + 1] = FloatToHalf(pSrc[x * 4 + 1]);
+            pHalf[x * 4 + 2] = FloatToHalf(pSrc[x * 4 + 2]);
+            pHalf[x * 4 + 3] = FloatToHalf(1.0f);
+        }
+    }
+
+    bool LoadCubemap(const TextureData& environment, FloatCubemap& cubemap)
+    {
+        if (!IsFloatFormat(environment.Format) || !environment.IsCubemap || environment.ArraySize != 6 ||
+            environment.Width != environment.Height)
+        {
+            return false;
+        }
+
+        cubemap.Initialize(environment.Width, environment.MipLevels);
+        for (uint32_t mip = 0; mip < cubemap.MipLevels; ++mip)
+        {
+            for (uint32_t face = 0; face < 6; ++face)
+            {
+                DecodeSubresource(environment, mip, face, cubemap.GetFace(mip, face));
+            }
+        }
+        return true;
+    }
+
+    __m128 Lerp(__m128 a, __m128 b, float t)
+    {
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t)));
+    }
+
+    // Bilinear sample of an RGBA float image, u and v in [0, 1]. Wraps horizontally if wrapU, clamps otherwise.
+    __m128 SampleBilinear(const float* pImage, uint32_t width, uint32_t height, float u, float v, bool wrapU)
+    {
+        float x = u * width - 0.5f;
+        float y = v * height - 0.5f;
+        float fx = std::floor(x);
+        float fy = std::floor(y);
+        float tx = x - fx;
+        float ty = y - fy;
+
+        int32_t x0 = static_cast<int32_t>(fx);
+        int32_t y0 = static_cast<int32_t>(fy);
+        int32_t x1 = x0 + 1;
+        int32_t y1 = y0 + 1;
+        if (wrapU)
+        {
+            x0 = ((x0 % int32_t(width)) + int32_t(width)) % int32_t(width);
+            x1 = ((x1 % int32_t(width)) + int32_t(width)) % int32_t(width);
+        }
+        else
+        {
+            x0 = std::min(std::max(x0, 0), int32_t(width) - 1);
+            x1 = std::min(std::max(x1, 0), int32_t(width) - 1);
+        }
+        y0 = std::min(std::max(y0, 0), int32_t(height) - 1);
+        y1 = std::min(std::max(y1, 0), int32_t(height) - 1);
+
+        __m128 c00 = _mm_loadu_ps(pImage + (size_t(y0) * width + x0) * 4);
+        __m128 c10 = _mm_loadu_ps(pImage + (size_t(y0) * width + x1) * 4);
+        __m128 c01 = _mm_loadu_ps(pImage + (size_t(y1) * width + x0) * 4);
+        __m128 c11 = _mm_loadu_ps(pImage + (size_t(y1) * width + x1) * 4);
+        return Lerp(Lerp(c00, c10, tx), Lerp(c01, c11, tx), ty);
+    }
+
+    // Trilinear sample. The bilinear footprint is clamped to the face, which is fine for the wide filters used here.
+    __m128 SampleCubemap(const FloatCubemap& cubemap, const float* pDirection, float lod)
+    {
+        uint32_t face;
+        float u;
+        float v;
+        GetCubemapFaceCoordinates(pDirection, face, u, v);
+
+        lod = std::min(std::max(lod, 0.0f), float(cubemap.MipLevels - 1));
+        uint32_t mip0 = static_cast<uint32_t>(lod);
+        uint32_t mip1 = std::min(mip0 + 1, cubemap.MipLevels - 1);
+        float t = lod - mip0;
+
+        uint32_t size0 = cubemap.GetSize(mip0);
+        __m128 color = SampleBilinear(cubemap.GetFace(mip0, face), size0, size0, u, v, false);
+        if (t > 0.0f && mip1 != mip0)
+        {
+            uint32_t size1 = cubemap.GetSize(mip1);
+            color = Lerp(color, SampleBilinear(cubemap.GetFace(mip1, face), size1, size1, u, v, false), t);
+        }
+        return color;
+    }
+
+    float RadicalInverse(uint32_t bits)
+    {
+        bits = (bits << 16) | (bits >> 16);
+        bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+        bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+        bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+        bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+        return float(bits) * 2.3283064365386963e-10f;
+    }
+
+    // A GGX sample in tangent space (normal = +Z) with its weight and the environment mip to read.
+    struct SpecularSample
+    {
+        float Direction[3];
+        float Weight;
+        float Lod;
+    };
+
+    /**
+     * Importance sample the GGX lobe with N = V = R. The mip of each sample covers the
+     * solid angle of the sample (pdf based), which removes most of the noise.
+     */
+    std::vector<SpecularSample> GenerateSpecularSamples(float roughness, uint32_t sampleCount, uint32_t environmentSize)
+    {
+        const float alpha = roughness * roughness;
+        const float alpha2 = alpha * alpha;
+        const float texelSolidAngle = 4.0f * Pi / (6.0f * environmentSize * environmentSize);
+
+        std::vector<SpecularSample> samples;
+        for (uint32_t i = 0; i < sampleCount; ++i)
+        {
+            float xi0 = (i + 0.5f) / sampleCount;
+            float xi1 = RadicalInverse(i);
+
+            float phi = 2.0f * Pi * xi0;
+            float cosTheta = std::sqrt((1.0f - xi1) / (1.0f + (alpha2 - 1.0f) * xi1));
+            float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+            float h[3] = { sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta };
+
+            // Reflect V = N = +Z around H.
+            SpecularSample sample;
+            sample.Direction[0] = 2.0f * cosTheta * h[0];
+            sample.Direction[1] = 2.0f * cosTheta * h[1];
+            sample.Direction[2] = 2.0f * cosTheta * h[2] - 1.0f;
+            float nDotL = sample.Direction[2];
+            if (nDotL <= 0.0f)
+            {
+                continue;
+            }
+
+            // pdf(L) = D(H) * NdotH / (4 * VdotH) = D(H) / 4 with N = V.
+            float d = cosTheta * cosTheta * (alpha2 - 1.0f) + 1.0f;
+            float distribution = alpha2 / (Pi * d * d);
+            float pdf = distribution * 0.25f;
+            float sampleSolidAngle = 1.0f / (sampleCount * pdf + 1e-6f);
+
+            sample.Weight = nDotL;
+            sample.Lod = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f);
+            samples.push_back(sample);
+        }
+        return samples;
+    }
+
+    // Orthonormal basis around a normal.
+    void GetTangentFrame(const float* pNormal, float* pTangent, float* pBitangent)
+    {
+        float up[3] = { 0.0f, 0.0f, 0.0f };
+        up[std::abs(pNormal[2]) < 0.999f ? 2 : 0] = 1.0f;
+
+        pTangent[0] = up[1] * pNormal[2] - up[2] * pNormal[1];
+        pTangent[1] = up[2] * pNormal[0] - up[0] * pNormal[2];
+        pTangent[2] = up[0] * pNormal[1] - up[1] * pNormal[0];
+        float length = std::sqrt(pTangent[0] * pTangent[0] + pTangent[1] * pTangent[1] + pTangent[2] * pTangent[2]);
+        for (int c = 0; c < 3; ++c)
+        {
+            pTangent[c] /= length;
+        }
+
+        pBitangent[0] = pNormal[1] * pTangent[2] - pNormal[2] * pTangent[1];
+        pBitangent[1] = pNormal[2] * pTangent[0] - pNormal[0] * pTangent[2];
+        pBitangent[2] = pNormal[0] * pTangent[1] - pNormal[1] * pTangent[0];
+    }
+
+    float CubemapAreaElement(float x, float y)
+    {
+        return std::atan2(x * y, std::sqrt(x * x + y * y + 1.0f));
+    }
+}
+
+void GetCubemapDirection(uint32_t face, float u, float v, float* pDirection)
+{
+    float x;
+    float y;
+    float z;
+    switch (face)
+    {
+    case 0: x = 1.0f; y = -v; z = -u; break;
+    case 1: x = -1.0f; y = -v; z = u; break;
+    case 2: x = u; y = 1.0f; z = v; break;
+    case 3: x = u; y = -1.0f; z = -v; break;
+    case 4: x = u; y = -v; z = 1.0f; break;
+    default: x = -u; y = -v; z = -1.0f; break;
+    }
+
+    float invLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+    pDirection[0] = x * invLength;
+    pDirection[1] = y * invLength;
+    pDirection[2] = z * invLength;
+}
+
+void GetCubemapFaceCoordinates(const float* pDirection, uint32_t& face, float& u, float& v)
+{
+    const float x = pDirection[0];
+    const float y = pDirection[1];
+    const float z = pDirection[2];
+    const float ax = std::abs(x);
+    const float ay = std::abs(y);
+    const float az = std::abs(z);
+
+    float sc;
+    float tc;
+    float ma;
+    if (ax >= ay && ax >= az)
+    {
+        face = x >= 0.0f ? 0 : 1;
+        sc = x >= 0.0f ? -z : z;
+        tc = -y;
+        ma = ax;
+    }
+    else if (ay >= az)
+    {
+        face = y >= 0.0f ? 2 : 3;
+        sc = x;
+        tc = y >= 0.0f ? z : -z;
+        ma = ay;
+    }
+    else
+    {
+        face = z >= 0.0f ? 4 : 5;
+        sc = z >= 0.0f ? x : -x;
+        tc = -y;
+        ma = az;
+    }
+
+    u = (sc / ma + 1.0f) * 0.5f;
+    v = (tc / ma + 1.0f) * 0.5f;
+}
+
+float GetCubemapTexelSolidAngle(uint32_t x, uint32_t y, uint32_t size)
+{
+    const float invSize = 1.0f / size;
+    float x0 = 2.0f * x * invSize - 1.0f;
+    float y0 = 2.0f * y * invSize - 1.0f;
+    float x1 = x0 + 2.0f * invSize;
+    float y1 = y0 + 2.0f * invSize;
+    return CubemapAreaElement(x0, y0) - CubemapAreaElement(x0, y1) - CubemapAreaElement(x1, y0) + CubemapAreaElement(x1, y1);
+}
+
+void GetPanoramaDirection(float u, float v, float* pDirection)
+{
+    float phi = (u - 0.5f) * 2.0f * Pi;
+    float theta = v * Pi;
+    pDirection[0] = -std::sin(theta) * std::sin(phi);
+    pDirection[1] = std::cos(theta);
+    pDirection[2] = -std::sin(theta) * std::cos(phi);
+}
+
+void GetPanoramaCoordinates(const float* pDirection, float& u, float& v)
+{
+    float length = std::sqrt(pDirection[0] * pDirection[0] + pDirection[1] * pDirection[1] + pDirection[2] * pDirection[2]);
+    u = std::atan2(-pDirection[0], -pDirection[2]) / (2.0f * Pi) + 0.5f;
+    v = std::acos(std::min(std::max(pDirection[1] / length, -1.0f), 1.0f)) / Pi;
+}
+
+bool PanoramaToCubemap(const TextureData& panorama, uint32_t faceSize, TextureData& cubemap, ThreadPool* pThreadPool)
+{
+    if (!IsFloatFormat(panorama.Format) || faceSize == 0)
+    {
+        return false;
+    }
+
+    std::vector<float> pixels(size_t(panorama.Width) * panorama.Height * 4);
+    DecodeSubresource(panorama, 0, 0, pixels.data());
+
+    // Only mip 0 is resampled from the panorama, GenerateMips builds the others.
+    FloatCubemap result;
+    result.Initialize(faceSize, 1);
+
+    // One task per row of a face.
+    ParallelFor(pThreadPool, 6 * faceSize, [&](uint32_t task)
+    {
+        const uint32_t face = task / faceSize;
+        const uint32_t y = task % faceSize;
+        float* pRow = result.GetFace(0, face) + size_t(y) * faceSize * 4;
+
+        for (uint32_t x = 0; x < faceSize; ++x)
+        {
+            float direction[3];
+            GetCubemapDirection(face, 2.0f * (x + 0.5f) / faceSize - 1.0f, 2.0f * (y + 0.5f) / faceSize - 1.0f, direction);
+
+            float u;
+            float v;
+            GetPanoramaCoordinates(direction, u, v);
+            _mm_storeu_ps(pRow + x * 4, SampleBilinear(pixels.data(), panorama.Width, panorama.Height, u, v, true));
+        }
+    });
+
+    cubemap.Initialize(TextureFormat::RGBA16Float, faceSize, faceSize, 6, 0);
+    cubemap.IsCubemap = true;
+    ParallelFor(pThreadPool, 6, [&](uint32_t face)
+    {
+        const TextureSubresource& subresource = cubemap.GetSubresource(0, face);
+        for (uint32_t y = 0; y < faceSize; ++y)
+        {
+            EncodeRow(result.GetFace(0, face) + size_t(y) * faceSize * 4, faceSize, cubemap.GetPixels(0, face) + y * subresource.RowPitch);
+        }
+    });
+
+    // Box filtered mips, the filtered importance sampling of PrefilterSpecular assumes texels that average the texels below.
+    MipGenerationSettings mipSettings;
+    mipSettings.Filter = MipFilter::Box;
+    GenerateMips(cubemap, mipSettings, pThreadPool);
+
+    return true;
+}
+
+bool PrefilterSpecular(const TextureData& environment, uint32_t faceSize, uint32_t mipLevels, uint32_t sampleCount,
+    TextureData& specular, ThreadPool* pThreadPool)
+{
+    FloatCubemap source;
+    if (faceSize == 0 || sampleCount == 0 || !LoadCubemap(environment, source))
+    {
+        return false;
+    }
+
+    specular.Initialize(TextureFormat::RGBA16Float, faceSize, faceSize, 6, std::max(mipLevels, 1u));
+    specular.IsCubemap = true;
+
+    std::vector< std::vector<SpecularSample> > mipSamples(specular.MipLevels);
+    for (uint32_t mip = 1; mip < specular.MipLevels; ++mip)
+    {
+        float roughness = float(mip) / float(specular.MipLevels - 1);
+        mipSamples[mip] = GenerateSpecularSamples(roughness, sampleCount, source.Size);
+    }
+
+    // One task per row of every face of every mip, the rough mips are much more expensive per texel.
+    struct Row
+    {
+        uint32_t Mip;
+        uint32_t Face;
+        uint32_t Y;
+    };
+    std::vector<Row> rows;
+    for (uint32_t mip = 0; mip < specular.MipLevels; ++mip)
+    {
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            for (uint32_t y = 0; y < specular.GetSubresource(mip, face).Height; ++y)
+            {
+                rows.push_back({ mip, face, y });
+            }
+        }
+    }
+
+    ParallelFor(pThreadPool, static_cast<uint32_t>(rows.size()), [&](uint32_t task)
+    {
+        const Row& row = rows[task];
+        const TextureSubresource& subresource = specular.GetSubresource(row.Mip, row.Face);
+        const uint32_t size = subresource.Width;
+        const std::vector<SpecularSample>& samples = mipSamples[row.Mip];
+
+        std::vector<float> colors(size_t(size) * 4);
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            float normal[3];
+            GetCubemapDirection(row.Face, 2.0f * (x + 0.5f) / size - 1.0f, 2.0f * (row.Y + 0.5f) / size - 1.0f, normal);
+
+            __m128 color;
+            if (samples.empty())
+            {
+                // Roughness 0 is a mirror, read the environment mip with the same texel size.
+                color = SampleCubemap(source, normal, std::log2(float(source.Size) / size));
+            }
+            else
+            {
+                float tangent[3];
+                float bitangent[3];
+                GetTangentFrame(normal, tangent, bitangent);
+
+                __m128 sum = _mm_setzero_ps();
+                float totalWeight = 0.0f;
+                for (const SpecularSample& sample : samples)
+                {
+                    float direction[3];
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        direction[c] = tangent[c] * sample.Direction[0] + bitangent[c] * sample.Direction[1] + normal[c] * sample.Direction[2];
+                    }
+                    sum = _mm_add_ps(sum, _mm_mul_ps(SampleCubemap(source, direction, sample.Lod), _mm_set1_ps(sample.Weight)));
+                    totalWeight += sample.Weight;
+                }
+                color = _mm_div_ps(sum, _mm_set1_ps(totalWeight));
+            }
+            _mm_storeu_ps(&colors[size_t(x) * 4], color);
+        }
+
+        EncodeRow(colors.data(), size, specular.GetPixels(row.Mip, row.Face) + row.Y * subresource.RowPitch);
+    });
+
+    return true;
+}
+
+bool ComputeIrradiance(const TextureData& environment, uint32_t faceSize, TextureData& irradiance, ThreadPool* pThreadPool)
+{
+    FloatCubemap source;
+    if (faceSize == 0 || !LoadCubemap(environment, source))
+    {
+        return false;
+    }
+
+    // The cosine lobe is wide, a 32x32 mip of the environment is plenty.
+    uint32_t sourceMip = 0;
+    while (sourceMip + 1 < source.MipLevels && source.GetSize(sourceMip) > 32)
+    {
+        ++sourceMip;
+    }
+    const uint32_t sourceSize = source.GetSize(sourceMip);
+
+    // Every source texel as direction and radiance * solid angle, structure of arrays padded to 4.
+    const size_t numTexels = size_t(sourceSize) * sourceSize * 6;
+    const size_t paddedTexels = (numTexels + 3) & ~size_t(3);
+    std::vector<float> directionX(paddedTexels, 0.0f);
+    std::vector<float> directionY(paddedTexels, 0.0f);
+    std::vector<float> directionZ(paddedTexels, 0.0f);
+    std::vector<float> radianceR(paddedTexels, 0.0f);
+    std::vector<float> radianceG(paddedTexels, 0.0f);
+    std::vector<float> radianceB(paddedTexels, 0.0f);
+
+    size_t texel = 0;
+    for (uint32_t face = 0; face < 6; ++face)
+    {
+        const float* pFace = source.GetFace(sourceMip, face);
+        for (uint32_t y = 0; y < sourceSize; ++y)
+        {
+            for (uint32_t x = 0; x < sourceSize; ++x, ++texel)
+            {
+                float direction[3];
+                GetCubemapDirection(face, 2.0f * (x + 0.5f) / sourceSize - 1.0f, 2.0f * (y + 0.5f) / sourceSize - 1.0f, direction);
+                float solidAngle = GetCubemapTexelSolidAngle(x, y, sourceSize);
+
+                const float* pColor = pFace + (size_t(y) * sourceSize + x) * 4;
+                directionX[texel] = direction[0];
+                directionY[texel] = direction[1];
+                directionZ[texel] = direction[2];
+                radianceR[texel] = pColor[0] * solidAngle;
+                radianceG[texel] = pColor[1] * solidAngle;
+                radianceB[texel] = pColor[2] * solidAngle;
+            }
+        }
+    }
+
+    irradiance.Initialize(TextureFormat::RGBA16Float, faceSize, faceSize, 6, 1);
+    irradiance.IsCubemap = true;
+
+    ParallelFor(pThreadPool, 6 * faceSize, [&](uint32_t task)
+    {
+        const uint32_t face = task / faceSize;
+        const uint32_t y = task % faceSize;
+        const __m128 zero = _mm_setzero_ps();
+
+        std::vector<float> colors(size_t(faceSize) * 4);
+        for (uint32_t x = 0; x < faceSize; ++x)
+        {
+            float normal[3];
+            GetCubemapDirection(face, 2.0f * (x + 0.5f) / faceSize - 1.0f, 2.0f * (y + 0.5f) / faceSize - 1.0f, normal);
+            const __m128 nx = _mm_set1_ps(normal[0]);
+            const __m128 ny = _mm_set1_ps(normal[1]);
+            const __m128 nz = _mm_set1_ps(normal[2]);
+
+            // Four source texels per iteration.
+            __m128 sumR = zero;
+            __m128 sumG = zero;
+            __m128 sumB = zero;
+            for (size_t i = 0; i < paddedTexels; i += 4)
+            {
+                __m128 cosine = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(nx, _mm_loadu_ps(&directionX[i])),
+                    _mm_mul_ps(ny, _mm_loadu_ps(&directionY[i]))),
+                    _mm_mul_ps(nz, _mm_loadu_ps(&directionZ[i])));
+                cosine = _mm_max_ps(cosine, zero);
+                sumR = _mm_add_ps(sumR, _mm_mul_ps(cosine, _mm_loadu_ps(&radianceR[i])));
+                sumG = _mm_add_ps(sumG, _mm_mul_ps(cosine, _mm_loadu_ps(&radianceG[i])));
+                sumB = _mm_add_ps(sumB, _mm_mul_ps(cosine, _mm_loadu_ps(&radianceB[i])));
+            }
+
+            alignas(16) float r[4];
+            alignas(16) float g[4];
+            alignas(16) float b[4];
+            _mm_store_ps(r, sumR);
+            _mm_store_ps(g, sumG);
+            _mm_store_ps(b, sumB);
+            colors[size_t(x) * 4 + 0] = (r[0] + r[1] + r[2] + r[3]) / Pi;
+            colors[size_t(x) * 4 + 1] = (g[0] + g[1] + g[2] + g[3]) / Pi;
+            colors[size_t(x) * 4 + 2] = (b[0] + b[1] + b[2] + b[3]) / Pi;
+            colors[size_t(x) * 4 + 3] = 1.0f;
+        }
+
+        EncodeRow(colors.data(), faceSize, irradiance.GetPixels(0, face) + y * irradiance.GetSubresource(0, face).RowPitch);
+    });
+
+    return true;
+}
+
+uint64_t ComputeIBLCacheKey(uint64_t sourceKey, const IBLSettings& settings)
+{
+    uint64_t hash = HashValue(IBLCacheVersion);
+    hash = HashValue(sourceKey, hash);
+    hash = HashValue(settings.EnvironmentSize, hash);
+    hash = HashValue(settings.SpecularSize, hash);
+    hash = HashValue(settings.SpecularMipLevels, hash);
+    hash = HashValue(settings.SpecularSampleCount, hash);
+    return HashValue(settings.IrradianceSize, hash);
+}
+
+bool BuildIBLCache(const std::wstring& cacheFileName, uint64_t sourceKey, const std::function<bool(TextureData&)>& loadPanorama,
+    const IBLSettings& settings, ThreadPool* pThreadPool)
+{
+    const uint64_t key = ComputeIBLCacheKey(sourceKey, settings);
+
+    {
+        TextureFile cache;
+        if (cache.Open(cacheFileName) && cache.GetHeader().Key == key && cache.GetHeader().NumTextures == 3)
+        {
+            return true;
+        }
+        // The mapping is closed here, before the file is overwritten.
+    }
+
+    TextureData panorama;
+    if (!loadPanorama(panorama))
+    {
+        return false;
+    }
+
+    TextureData environment;
+    TextureData specular;
+    TextureData irradiance;
+    if (!PanoramaToCubemap(panorama, settings.EnvironmentSize, environment, pThreadPool) ||
+        !PrefilterSpecular(environment, settings.SpecularSize, settings.SpecularMipLevels, settings.SpecularSampleCount, specular, pThreadPool) ||
+        !ComputeIrradiance(environment, settings.IrradianceSize, irradiance, pThreadPool))
+    {
+        return false;
+    }
+
+    return WriteTextureFile(cacheFileName, { &environment, &specular, &irradiance }, key);
+}
+
+bool GenerateBRDFLUT(const BRDFLUTSettings& settings, TextureData& lut, ThreadPool* pThreadPool)
+{
+    if (settings.Size == 0 || settings.SampleCount == 0)
+    {
+        return false;
+    }
+
+    const uint32_t size = settings.Size;
+    const uint32_t sampleCount = settings.SampleCount;
+    const size_t paddedSamples = (size_t(sampleCount) + 3) & ~size_t(3);
+
+    lut.Initialize(TextureFormat::RG16Float, size, size, 1, 1);
+
+    // One task per roughness, the samples only depend on the roughness.
+    ParallelFor(pThreadPool, size, [&](uint32_t y)
+    {
+        const float roughness = (y + 0.5f) / size;
+        const float alpha = roughness * roughness;
+        const float alpha2 = alpha * alpha;
+        // Schlick-Smith geometry term with the IBL remapping k = alpha / 2.
+        const float k = alpha * 0.5f;
+
+        // Half vectors in tangent space (N = +Z). V lies in the XZ plane, so H.y is never needed.
+        // The padding samples have H = 0, which fails the VdotH > 0 test below.
+        std::vector<float> halfX(paddedSamples, 0.0f);
+        std::vector<float> halfZ(paddedSamples, 0.0f);
+        for (uint32_t i = 0; i < sampleCount; ++i)
+        {
+            float xi0 = (i + 0.5f) / sampleCount;
+            float xi1 = RadicalInverse(i);
+
+            float phi = 2.0f * Pi * xi0;
+            float cosTheta = std::sqrt((1.0f - xi1) / (1.0f + (alpha2 - 1.0f) * xi1));
+            float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+            halfX[i] = sinTheta * std::cos(phi);
+            halfZ[i] = cosTheta;
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 kVector = _mm_set1_ps(k);
+        const __m128 oneMinusK = _mm_set1_ps(1.0f - k);
+
+        uint16_t* pRow = reinterpret_cast<uint16_t*>(lut.GetPixels(0, 0) + y * lut.GetSubresource(0, 0).RowPitch);
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            const float nDotV = (x + 0.5f) / size;
+            const __m128 viewX = _mm_set1_ps(std::sqrt(1.0f - nDotV * nDotV));
+            const __m128 viewZ = _mm_set1_ps(nDotV);
+            // G1(V) / NdotV, the NdotV of the visibility term cancels.
+            const __m128 g1VOverNDotV = _mm_set1_ps(1.0f / (nDotV * (1.0f - k) + k));
+
+            __m128 scale = zero;
+            __m128 bias = zero;
+            for (size_t i = 0; i < paddedSamples; i += 4)
+            {
+                const __m128 hx = _mm_loadu_ps(&halfX[i]);
+                const __m128 hz = _mm_loadu_ps(&halfZ[i]);
+
+                // L = 2 (V.H) H - V
+                const __m128 vDotH = _mm_add_ps(_mm_mul_ps(viewX, hx), _mm_mul_ps(viewZ, hz));
+                const __m128 nDotL = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(two, vDotH), hz), viewZ);
+                const __m128 valid = _mm_and_ps(_mm_cmpgt_ps(nDotL, zero), _mm_cmpgt_ps(vDotH, zero));
+
+                // G * VdotH / (NdotH * NdotV), the pdf of the sample is folded in.
+                const __m128 g1L = _mm_div_ps(nDotL, _mm_add_ps(_mm_mul_ps(nDotL, oneMinusK), kVector));
+                const __m128 visibility = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(g1VOverNDotV, g1L), vDotH), hz);
+
+                // Schlick Fresnel (1 - VdotH)^5.
+                const __m128 oneMinusVDotH = _mm_sub_ps(one, vDotH);
+                const __m128 square = _mm_mul_ps(oneMinusVDotH, oneMinusVDotH);
+                const __m128 fresnel = _mm_mul_ps(_mm_mul_ps(square, square), oneMinusVDotH);
+
+                // The masks also clear the NaNs of the padding samples.
+                scale = _mm_add_ps(scale, _mm_and_ps(valid, _mm_mul_ps(_mm_sub_ps(one, fresnel), visibility)));
+                bias = _mm_add_ps(bias, _mm_and_ps(valid, _mm_mul_ps(fresnel, visibility)));
+            }
+
+            alignas(16) float s[4];
+            alignas(16) float b[4];
+            _mm_store_ps(s, scale);
+            _mm_store_ps(b, bias);
+            pRow[x * 2 + 0] = FloatToHalf((s[0] + s[1] + s[2] + s[3]) / sampleCount);
+            pRow[x * 2 + 1] = FloatToHalf((b[0] + b[1] + b[2] + b[3]) / sampleCount);
+        }
+    });
+
+    return true;
+}
+
+uint64_t ComputeBRDFLUTCacheKey(const BRDFLUTSettings& settings)
+{
+    uint64_t hash = HashValue(BRDFLUTCacheVersion);
+    hash = HashValue(settings.Size, hash);
+    return HashValue(settings.SampleCount, hash);
+}
+
+bool BuildBRDFLUTCache(const std::wstring& cacheFileName, const BRDFLUTSettings& settings, ThreadPool* pThreadPool)
+{
+    const uint64_t key = ComputeBRDFLUTCacheKey(settings);
+
+    {
+        TextureFile cache;
+        if (cache.Open(cacheFileName) && cache.GetHeader().Key == key && cache.GetHeader().NumTextures == 1)
+        {
+            return true;
+        }
+    }
+
+    TextureData lut;
+    if (!GenerateBRDFLUT(settings, lut, pThreadPool))
+    {
+        return false;
+    }
+
+    return WriteTextureFile(cacheFileName, { &lut }, key);
+}
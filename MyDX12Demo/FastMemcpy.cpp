@@ -0,0 +1,257 @@
+#include <FastMemcpy.h>
+#include <DX12LibPCH.h>
+
+#include <ThreadPool.h>
+
+#include <cstring>
+#include <vector>
+
+#include <emmintrin.h> // SSE2
+#include <immintrin.h> // AVX
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX_TARGET
+#else
+#include <cpuid.h>
+#define AVX_TARGET __attribute__((target("avx")))
+#endif
+
+namespace
+{
+    // Rows smaller than this are copied with memcpy, the streaming setup is not worth it.
+    const size_t MinStreamingSize = 256;
+    // Copies are split into jobs of roughly this many bytes.
+    const size_t ParallelChunkSize = 256 * 1024;
+
+    bool CheckAVXSupport()
+    {
+#if defined(_MSC_VER)
+        int cpuInfo[4];
+        __cpuid(cpuInfo, 1);
+        bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+        bool avx = (cpuInfo[2] & (1 << 28)) != 0;
+        // The OS must save the YMM registers on context switches.
+        return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+        return __builtin_cpu_supports("avx");
+#endif
+    }
+
+    const bool gs_AVXSupported = CheckAVXSupport();
+
+    // Copies until the destination is aligned to `alignment`, returns the number of bytes copied.
+    size_t CopyHead(uint8_t* pDest, const uint8_t* pSrc, size_t sizeInBytes, size_t alignment)
+    {
+        size_t misalignment = reinterpret_cast<uintptr_t>(pDest) & (alignment - 1);
+        size_t head = misalignment ? std::min(alignment - misalignment, sizeInBytes) : 0;
+        memcpy(pDest, pSrc, head);
+        return head;
+    }
+
+    void StreamSSE2(uint8_t* pDest, const uint8_t* pSrc, size_t sizeInBytes)
+    {
+        size_t offset = CopyHead(pDest, pSrc, sizeInBytes, 16);
+
+        for (; offset + 64 <= sizeInBytes; offset += 64)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + offset));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + offset + 16));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + offset + 32));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + offset + 48));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(pDest + offset), a);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(pDest + offset + 16), b);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(pDest + offset + 32), c);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(pDest + offset + 48), d);
+        }
+        for (; offset + 16 <= sizeInBytes; offset += 16)
+        {
+            _mm_stream_si128(reinterpret_cast<__m128i*>(pDest + offset),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + offset)));
+        }
+
+        memcpy(pDest + offset, pSrc + offset, sizeInBytes - offset);
+    }
+
+    AVX_TARGET void StreamAVX(uint8_t* pDest, const uint8_t* pSrc, size_t sizeInBytes)
+    {
+        size_t offset = CopyHead(pDest, pSrc, sizeInBytes, 32);
+
+        for (; offset + 128 <= sizeInBytes; offset += 128)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + offset));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + offset + 32));
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + offset + 64));
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + offset + 96));
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(pDest + offset), a);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(pDest + offset + 32), b);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(pDest + offset + 64), c);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(pDest + offset + 96), d);
+        }
+        for (; offset + 32 <= sizeInBytes; offset += 32)
+        {
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(pDest + offset),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + offset)));
+        }
+        // Avoid the AVX-SSE transition penalty in the code that follows.
+        _mm256_zeroupper();
+
+        memcpy(pDest + offset, pSrc + offset, sizeInBytes - offset);
+    }
+
+    // Copy without the trailing store fence.
+    void StreamNoFence(void* pDest, const void* pSrc, size_t sizeInBytes)
+    {
+        if (sizeInBytes < MinStreamingSize)
+        {
+            memcpy(pDest, pSrc, sizeInBytes);
+        }
+        else if (gs_AVXSupported)
+        {
+            StreamAVX(static_cast<uint8_t*>(pDest), static_cast<const uint8_t*>(pSrc), sizeInBytes);
+        }
+        else
+        {
+            StreamSSE2(static_cast<uint8_t*>(pDest), static_cast<const uint8_t*>(pSrc), sizeInBytes);
+        }
+    }
+}
+
+void StreamingMemcpy(void* pDest, const void* pSrc, size_t sizeInBytes)
+{
+    StreamNoFence(pDest, pSrc, sizeInBytes);
+    // Non-temporal stores are weakly ordered, make them visible before returning.
+    _mm_sfence();
+}
+
+void CopyRows(void* pDest, size_t destRowPitch, size_t destSlicePitch,
+    const void* pSrc, size_t srcRowPitch, size_t srcSlicePitch,
+    size_t rowSizeInBytes, uint32_t numRows, uint32_t numSlices,
+    ThreadPool* pThreadPool)
+{
+    if (rowSizeInBytes == 0 || numRows == 0 || numSlices == 0)
+    {
+        return;
+    }
+
+    // Tightly packed rows on both sides: every slice is a single contiguous copy.
+    if (destRowPitch == rowSizeInBytes && srcRowPitch == rowSizeInBytes)
+    {
+        rowSizeInBytes *= numRows;
+        destRowPitch = destSlicePitch;
+        srcRowPitch = srcSlicePitch;
+        numRows = numSlices;
+        numSlices = 1;
+        destSlicePitch = destRowPitch * numRows;
+        srcSlicePitch = srcRowPitch * numRows;
+    }
+
+    auto pDestBytes = static_cast<uint8_t*>(pDest);
+    auto pSrcBytes = static_cast<const uint8_t*>(pSrc);
+
+    // 将所有切片的行展平后分块. Short rows are grouped into one job,
+    // long rows (for example whole tightly packed slices) are split into several jobs.
+    uint64_t totalRows = uint64_t(numRows) * numSlices;
+    uint64_t rowsPerJob = std::max<uint64_t>(1, ParallelChunkSize / rowSizeInBytes);
+    uint64_t jobsPerRow = (rowSizeInBytes + ParallelChunkSize - 1) / ParallelChunkSize;
+    size_t bytesPerJob = rowSizeInBytes;
+    uint32_t numJobs;
+    if (jobsPerRow > 1)
+    {
+        rowsPerJob = 1;
+        bytesPerJob = ParallelChunkSize;
+        numJobs = static_cast<uint32_t>(totalRows * jobsPerRow);
+    }
+    else
+    {
+        jobsPerRow = 1;
+        numJobs = static_cast<uint32_t>((totalRows + rowsPerJob - 1) / rowsPerJob);
+    }
+
+    auto copyJob = [&](uint32_t job)
+    {
+        uint64_t firstRow = (job / jobsPerRow) * rowsPerJob;
+        uint64_t lastRow = std::min(totalRows, firstRow + rowsPerJob);
+        size_t firstByte = static_cast<size_t>(job % jobsPerRow) * bytesPerJob;
+        size_t numBytes = std::min(bytesPerJob, rowSizeInBytes - firstByte);
+
+        for (uint64_t row = firstRow; row < lastRow; ++row)
+        {
+            uint64_t z = row / numRows;
+            uint64_t y = row % numRows;
+            StreamNoFence(pDestBytes + destSlicePitch * z + destRowPitch * y + firstByte,
+                pSrcBytes + srcSlicePitch * z + srcRowPitch * y + firstByte,
+                numBytes);
+        }
+        _mm_sfence();
+    };
+
+    ParallelFor(pThreadPool, numJobs, copyJob);
+}
+
+UINT64 UpdateSubresourcesFast(
+    ID3D12GraphicsCommandList* pCmdList,
+    ID3D12Resource* pDestinationResource,
+    ID3D12Resource* pIntermediate,
+    UINT64 IntermediateOffset,
+    UINT FirstSubresource,
+    UINT NumSubresources,
+    const D3D12_SUBRESOURCE_DATA* pSrcData,
+    ThreadPool* pThreadPool)
+{
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(NumSubresources);
+    std::vector<UINT> numRows(NumSubresources);
+    std::vector<UINT64> rowSizesInBytes(NumSubresources);
+    UINT64 requiredSize = 0;
+
+    auto destinationDesc = pDestinationResource->GetDesc();
+    ComPtr<ID3D12Device> device;
+    ThrowIfFailed(pDestinationResource->GetDevice(IID_PPV_ARGS(&device)));
+    device->GetCopyableFootprints(&destinationDesc, FirstSubresource, NumSubresources, IntermediateOffset,
+        layouts.data(), numRows.data(), rowSizesInBytes.data(), &requiredSize);
+
+    // Same validation as UpdateSubresources in d3dx12.h.
+    auto intermediateDesc = pIntermediate->GetDesc();
+    if (intermediateDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER ||
+        intermediateDesc.Width < requiredSize + layouts[0].Offset ||
+        (destinationDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER &&
+            (FirstSubresource != 0 || NumSubresources != 1)))
+    {
+        return 0;
+    }
+
+    BYTE* pData;
+    if (FAILED(pIntermediate->Map(0, nullptr, reinterpret_cast<void**>(&pData))))
+    {
+        return 0;
+    }
+
+    // Subresources (mips, array slices, cube faces) are copied in parallel,
+    // and large subresources are further split by rows.
+    ParallelFor(pThreadPool, NumSubresources, [&](uint32_t i)
+    {
+        D3D12_MEMCPY_DEST destData = { pData + layouts[i].Offset, layouts[i].Footprint.RowPitch,
+            SIZE_T(layouts[i].Footprint.RowPitch) * SIZE_T(numRows[i]) };
+        MemcpySubresourceFast(&destData, &pSrcData[i], static_cast<SIZE_T>(rowSizesInBytes[i]),
+            numRows[i], layouts[i].Footprint.Depth, pThreadPool);
+    });
+
+    pIntermediate->Unmap(0, nullptr);
+
+    if (destinationDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        pCmdList->CopyBufferRegion(
+            pDestinationResource, 0, pIntermediate, layouts[0].Offset, layouts[0].Footprint.Width);
+    }
+    else
+    {
+        for (UINT i = 0; i < NumSubresources; ++i)
+        {
+            CD3DX12_TEXTURE_COPY_LOCATION dst(pDestinationResource, i + FirstSubresource);
+            CD3DX12_TEXTURE_COPY_LOCATION src(pIntermediate, layouts[i]);
+            pCmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+        }
+    }
+
+    return requiredSize;
+}
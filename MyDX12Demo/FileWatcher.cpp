@@ -0,0 +1,229 @@
+#include <FileWatcher.h>
+#include <Hash.h>
+
+#include <cstdint>
+#include <filesystem>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Absolute and normalized, so the same file is found under different names.
+    std::wstring GetCanonicalPath(const std::wstring& fileName)
+    {
+        std::error_code error;
+        std::filesystem::path path = std::filesystem::absolute(std::filesystem::path(fileName), error);
+        if (error)
+        {
+            return fileName;
+        }
+        return path.lexically_normal().wstring();
+    }
+
+#if !defined(_WIN32)
+    // Descriptors are stored off by one so that null means "none", like MappedFile.
+    int ToDescriptor(void* handle)
+    {
+        return static_cast<int>(reinterpret_cast<intptr_t>(handle) - 1);
+    }
+
+    void* FromDescriptor(int descriptor)
+    {
+        return reinterpret_cast<void*>(static_cast<intptr_t>(descriptor) + 1);
+    }
+#endif
+}
+
+FileWatcher::FileWatcher()
+    : m_hInotify(nullptr)
+{
+#if !defined(_WIN32)
+    int inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify >= 0)
+    {
+        m_hInotify = FromDescriptor(inotify);
+    }
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#if defined(_WIN32)
+    for (WatchedDirectory& directory : m_Directories)
+    {
+        if (directory.hNotification)
+        {
+            ::FindCloseChangeNotification(directory.hNotification);
+        }
+    }
+#else
+    // Closing the instance removes all of its watches.
+    if (m_hInotify)
+    {
+        ::close(ToDescriptor(m_hInotify));
+    }
+#endif
+}
+
+uint32_t FileWatcher::FindOrAddDirectory(const std::wstring& path)
+{
+    for (uint32_t i = 0; i < m_Directories.size(); ++i)
+    {
+        if (m_Directories[i].Path == path)
+        {
+            return i;
+        }
+    }
+
+    WatchedDirectory directory;
+    directory.Path = path;
+    directory.hNotification = nullptr;
+    directory.Changed = false;
+
+#if defined(_WIN32)
+    HANDLE hNotification = ::FindFirstChangeNotificationW(path.c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    if (hNotification != INVALID_HANDLE_VALUE)
+    {
+        directory.hNotification = hNotification;
+    }
+#else
+    if (m_hInotify)
+    {
+        // Editors and compilers either rewrite the file or move a new one over it. IN_MODIFY and IN_CREATE
+        // would also fire in the middle of a write, the file is complete when it is closed or moved.
+        int watch = ::inotify_add_watch(ToDescriptor(m_hInotify), std::filesystem::path(path).c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch >= 0)
+        {
+            directory.hNotification = FromDescriptor(watch);
+        }
+    }
+#endif
+
+    m_Directories.push_back(directory);
+    return static_cast<uint32_t>(m_Directories.size() - 1);
+}
+
+void FileWatcher::Watch(const std::wstring& fileName)
+{
+    const std::wstring path = GetCanonicalPath(fileName);
+    if (IsWatching(path))
+    {
+        return;
+    }
+
+    WatchedFile file;
+    file.FileName = path;
+    file.Identity = HashFileIdentity(path);
+    file.PendingIdentity = 0;
+    file.Directory = FindOrAddDirectory(std::filesystem::path(path).parent_path().wstring());
+    m_Files.push_back(file);
+}
+
+bool FileWatcher::IsWatching(const std::wstring& fileName) const
+{
+    const std::wstring path = GetCanonicalPath(fileName);
+    for (const WatchedFile& file : m_Files)
+    {
+        if (file.FileName == path)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FileWatcher::ReadNotifications()
+{
+#if defined(_WIN32)
+    for (WatchedDirectory& directory : m_Directories)
+    {
+        if (directory.hNotification && ::WaitForSingleObject(directory.hNotification, 0) == WAIT_OBJECT_0)
+        {
+            directory.Changed = true;
+            ::FindNextChangeNotification(directory.hNotification);
+        }
+    }
+#else
+    if (!m_hInotify)
+    {
+        return;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (true)
+    {
+        ssize_t size = ::read(ToDescriptor(m_hInotify), buffer, sizeof(buffer));
+        if (size <= 0)
+        {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < size; )
+        {
+            const inotify_event* pEvent = reinterpret_cast<const inotify_event*>(buffer + offset);
+            for (WatchedDirectory& directory : m_Directories)
+            {
+                if (directory.hNotification && ToDescriptor(directory.hNotification) == pEvent->wd)
+                {
+                    directory.Changed = true;
+                }
+            }
+            offset += sizeof(inotify_event) + pEvent->len;
+        }
+    }
+#endif
+}
+
+std::vector<std::wstring> FileWatcher::PollChanges()
+{
+    ReadNotifications();
+
+    std::vector<std::wstring> changedFiles;
+    for (WatchedFile& file : m_Files)
+    {
+        // Files with a pending change are checked again without a new notification.
+        const WatchedDirectory& directory = m_Directories[file.Directory];
+        if (directory.hNotification && !directory.Changed && file.PendingIdentity == 0)
+        {
+            continue;
+        }
+
+        // A file that is being replaced may be missing for a moment, it is reported once it is back.
+        uint64_t identity = HashFileIdentity(file.FileName);
+        if (identity == 0)
+        {
+            continue;
+        }
+
+        if (identity == file.Identity)
+        {
+            file.PendingIdentity = 0;
+        }
+        else if (identity != file.PendingIdentity)
+        {
+            // 仍在写入: wait until the size and write time are the same on the next poll.
+            file.PendingIdentity = identity;
+        }
+        else
+        {
+            changedFiles.push_back(file.FileName);
+            file.Identity = identity;
+            file.PendingIdentity = 0;
+        }
+    }
+
+    for (WatchedDirectory& directory : m_Directories)
+    {
+        directory.Changed = false;
+    }
+
+    return changedFiles;
+}
@@ -0,0 +1,181 @@
+#include <GPUMemoryAllocator.h>
+#include <DX12LibPCH.h>
+
+namespace
+{
+    D3D12_HEAP_FLAGS GetHeapFlags(GPUMemoryAllocator::HeapCategory category)
+    {
+        switch (category)
+        {
+        case GPUMemoryAllocator::HeapCategory::Buffers:
+            return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+        case GPUMemoryAllocator::HeapCategory::NonRTDSTextures:
+            return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+        case GPUMemoryAllocator::HeapCategory::RTDSTextures:
+            return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+        default:
+            assert(false && "Invalid heap category.");
+            return D3D12_HEAP_FLAG_NONE;
+        }
+    }
+
+    GPUMemoryAllocator::HeapCategory GetHeapCategory(const D3D12_RESOURCE_DESC& desc)
+    {
+        if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            return GPUMemoryAllocator::HeapCategory::Buffers;
+        }
+        if ((desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0)
+        {
+            return GPUMemoryAllocator::HeapCategory::RTDSTextures;
+        }
+        return GPUMemoryAllocator::HeapCategory::NonRTDSTextures;
+    }
+}
+
+GPUMemoryAllocator::GPUMemoryAllocator(Microsoft::WRL::ComPtr<ID3D12Device2> device, uint64_t heapSize,
+    std::shared_ptr<ResidencyManager> residencyManager)
+    : m_d3d12Device(device)
+    , m_ResidencyManager(residencyManager)
+{
+    for (int c = 0; c < static_cast<int>(HeapCategory::NumCategories); ++c)
+    {
+        D3D12_HEAP_FLAGS heapFlags = GetHeapFlags(static_cast<HeapCategory>(c));
+
+        for (int a = 0; a < static_cast<int>(AlignmentClass::NumClasses); ++a)
+        {
+            uint64_t alignment = static_cast<AlignmentClass>(a) == AlignmentClass::MSAA ?
+                D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+            auto createHeap = [this, heapFlags](uint64_t size, uint64_t heapAlignment) -> void*
+            {
+                D3D12_HEAP_DESC heapDesc = {};
+                heapDesc.SizeInBytes = size;
+                heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+                heapDesc.Alignment = heapAlignment;
+                heapDesc.Flags = heapFlags;
+
+                ComPtr<ID3D12Heap> heap;
+                if (FAILED(m_d3d12Device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap))))
+                {
+                    return nullptr;
+                }
+                if (m_ResidencyManager)
+                {
+                    m_ResidencyManager->Track(heap.Get(), size);
+                }
+                // The heap allocator owns the reference until the destroy callback is invoked.
+                return heap.Detach();
+            };
+            auto destroyHeap = [this](void* pHeap)
+            {
+                if (m_ResidencyManager)
+                {
+                    m_ResidencyManager->Untrack(static_cast<ID3D12Heap*>(pHeap));
+                }
+                static_cast<ID3D12Heap*>(pHeap)->Release();
+            };
+
+            m_HeapAllocators[c][a] = std::make_unique<HeapAllocator>(heapSize, alignment, createHeap, destroyHeap);
+        }
+    }
+}
+
+GPUMemoryAllocator::~GPUMemoryAllocator()
+{
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> GPUMemoryAllocator::CreateResource(const D3D12_RESOURCE_DESC& resourceDesc,
+    D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* pClearValue, Allocation& allocation)
+{
+    D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = m_d3d12Device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+
+    allocation.Category = GetHeapCategory(resourceDesc);
+    allocation.Alignment = allocationInfo.Alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT ?
+        AlignmentClass::MSAA : AlignmentClass::Default;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        allocation.Block = GetHeapAllocator(allocation.Category, allocation.Alignment).Allocate(
+            allocationInfo.SizeInBytes, allocationInfo.Alignment);
+    }
+    if (!allocation.IsValid())
+    {
+        ThrowIfFailed(E_OUTOFMEMORY);
+    }
+
+    // The new resource is usually initialized right away, possibly on the copy queue.
+    if (m_ResidencyManager)
+    {
+        m_ResidencyManager->MakeResident(static_cast<ID3D12Heap*>(allocation.Block.pHeap));
+    }
+
+    ComPtr<ID3D12Resource> resource;
+    HRESULT hr = m_d3d12Device->CreatePlacedResource(
+        static_cast<ID3D12Heap*>(allocation.Block.pHeap),
+        allocation.Block.Offset,
+        &resourceDesc,
+        initialState,
+        pClearValue,
+        IID_PPV_ARGS(&resource));
+    if (FAILED(hr))
+    {
+        Free(allocation);
+        ThrowIfFailed(hr);
+    }
+
+    return resource;
+}
+
+void GPUMemoryAllocator::Free(Allocation& allocation)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    GetHeapAllocator(allocation.Category, allocation.Alignment).Free(allocation.Block);
+}
+
+void GPUMemoryAllocator::MarkUsed(const Allocation& allocation)
+{
+    if (m_ResidencyManager && allocation.IsValid())
+    {
+        m_ResidencyManager->MarkUsed(static_cast<ID3D12Heap*>(allocation.Block.pHeap));
+    }
+}
+
+HeapAllocator::Statistics GPUMemoryAllocator::GetStatistics(HeapCategory category, AlignmentClass alignment) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return GetHeapAllocator(category, alignment).GetStatistics();
+}
+
+HeapAllocator::Statistics GPUMemoryAllocator::GetStatistics() const
+{
+    HeapAllocator::Statistics total;
+    uint64_t freeSize = 0;
+
+    for (int c = 0; c < static_cast<int>(HeapCategory::NumCategories); ++c)
+    {
+        for (int a = 0; a < static_cast<int>(AlignmentClass::NumClasses); ++a)
+        {
+            HeapAllocator::Statistics stats = GetStatistics(static_cast<HeapCategory>(c), static_cast<AlignmentClass>(a));
+            total.NumHeaps += stats.NumHeaps;
+            total.NumAllocations += stats.NumAllocations;
+            total.ReservedSize += stats.ReservedSize;
+            total.UsedSize += stats.UsedSize;
+            total.RequestedSize += stats.RequestedSize;
+            total.LargestFreeBlock = std::max(total.LargestFreeBlock, stats.LargestFreeBlock);
+            freeSize += stats.ReservedSize - stats.UsedSize;
+        }
+    }
+
+    if (freeSize > 0)
+    {
+        total.Fragmentation = 1.0f - static_cast<float>(total.LargestFreeBlock) / static_cast<float>(freeSize);
+    }
+
+    return total;
+}
+
+HeapAllocator& GPUMemoryAllocator::GetHeapAllocator(HeapCategory category, AlignmentClass alignment) const
+{
+    return *m_HeapAllocators[static_cast<int>(category)][static_cast<int>(alignment)];
+}
@@ -0,0 +1,321 @@
+#include <HeapAllocator.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+    bool IsPowerOfTwo(uint64_t v)
+    {
+        return v != 0 && (v & (v - 1)) == 0;
+    }
+
+    uint64_t NextPowerOfTwo(uint64_t v)
+    {
+        uint64_t p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    uint64_t AlignUp(uint64_t v, uint64_t alignment)
+    {
+        return (v + alignment - 1) & ~(alignment - 1);
+    }
+
+    uint32_t Log2(uint64_t v)
+    {
+        uint32_t r = 0;
+        while (v >>= 1) ++r;
+        return r;
+    }
+}
+
+BuddyAllocator::BuddyAllocator(uint64_t size, uint64_t minBlockSize)
+    : m_Size(size)
+    , m_MinBlockSize(minBlockSize)
+    , m_MaxOrder(0)
+    , m_UsedSize(0)
+    , m_RequestedSize(0)
+{
+    assert(IsPowerOfTwo(minBlockSize) && "The minimum block size must be a power of two.");
+    assert(size >= minBlockSize && IsPowerOfTwo(size / minBlockSize) && size % minBlockSize == 0 &&
+        "The size must be a power of two multiple of the minimum block size.");
+
+    m_MaxOrder = Log2(size / minBlockSize);
+    m_FreeLists.resize(m_MaxOrder + 1);
+    m_FreeLists[m_MaxOrder].insert(0);
+}
+
+uint64_t BuddyAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    uint64_t blockSize = NextPowerOfTwo(std::max({ size, alignment, m_MinBlockSize, uint64_t(1) }));
+    uint32_t order = Log2(blockSize / m_MinBlockSize);
+    if (order > m_MaxOrder)
+    {
+        return InvalidOffset;
+    }
+
+    // 找到能满足请求的最小空闲块
+    uint32_t freeOrder = order;
+    while (freeOrder <= m_MaxOrder && m_FreeLists[freeOrder].empty())
+    {
+        ++freeOrder;
+    }
+    if (freeOrder > m_MaxOrder)
+    {
+        return InvalidOffset;
+    }
+
+    uint64_t offset = *m_FreeLists[freeOrder].begin();
+    m_FreeLists[freeOrder].erase(m_FreeLists[freeOrder].begin());
+
+    // Split the block until it has the requested order. The upper halves go back to the free lists.
+    while (freeOrder > order)
+    {
+        --freeOrder;
+        m_FreeLists[freeOrder].insert(offset + BlockSize(freeOrder));
+    }
+
+    m_Allocations[offset] = AllocationEntry{ order, size };
+    m_UsedSize += BlockSize(order);
+    m_RequestedSize += size;
+
+    return offset;
+}
+
+void BuddyAllocator::Free(uint64_t offset)
+{
+    auto iter = m_Allocations.find(offset);
+    assert(iter != m_Allocations.end() && "Freeing an offset that was not allocated.");
+    if (iter == m_Allocations.end())
+    {
+        return;
+    }
+
+    uint32_t order = iter->second.order;
+    m_UsedSize -= BlockSize(order);
+    m_RequestedSize -= iter->second.requestedSize;
+    m_Allocations.erase(iter);
+
+    // 与空闲的伙伴块合并
+    while (order < m_MaxOrder)
+    {
+        uint64_t buddy = offset ^ BlockSize(order);
+        auto buddyIter = m_FreeLists[order].find(buddy);
+        if (buddyIter == m_FreeLists[order].end())
+        {
+            break;
+        }
+
+        m_FreeLists[order].erase(buddyIter);
+        offset = std::min(offset, buddy);
+        ++order;
+    }
+
+    m_FreeLists[order].insert(offset);
+}
+
+uint64_t BuddyAllocator::GetLargestFreeBlock() const
+{
+    for (uint32_t order = m_MaxOrder + 1; order-- > 0; )
+    {
+        if (!m_FreeLists[order].empty())
+        {
+            return BlockSize(order);
+        }
+    }
+
+    return 0;
+}
+
+float BuddyAllocator::GetFragmentation() const
+{
+    uint64_t freeSize = GetFreeSize();
+    if (freeSize == 0)
+    {
+        return 0.0f;
+    }
+
+    return 1.0f - static_cast<float>(GetLargestFreeBlock()) / static_cast<float>(freeSize);
+}
+
+HeapAllocator::HeapAllocator(uint64_t heapSize, uint64_t alignment, CreateHeapFunc createHeap, DestroyHeapFunc destroyHeap)
+    : m_HeapSize(heapSize)
+    , m_Alignment(alignment)
+    , m_CreateHeap(std::move(createHeap))
+    , m_DestroyHeap(std::move(destroyHeap))
+{
+    assert(IsPowerOfTwo(alignment) && heapSize % alignment == 0 && IsPowerOfTwo(heapSize / alignment) &&
+        "The heap size must be a power of two multiple of the alignment.");
+}
+
+HeapAllocator::~HeapAllocator()
+{
+    for (uint32_t i = 0; i < m_Heaps.size(); ++i)
+    {
+        if (m_Heaps[i].pHeap)
+        {
+            assert(!m_Heaps[i].dedicated && m_Heaps[i].allocator->IsEmpty() && "Destroying a heap with live allocations.");
+            DestroyHeap(i);
+        }
+    }
+}
+
+HeapAllocator::Allocation HeapAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    Allocation allocation;
+
+    uint64_t blockSize = NextPowerOfTwo(std::max({ size, alignment, m_Alignment }));
+    if (blockSize > m_HeapSize)
+    {
+        // Too large for the regular heaps, give the allocation its own heap. It holds a
+        // single resource at offset 0, so it is only rounded up to the alignment.
+        uint64_t heapAlignment = std::max(alignment, m_Alignment);
+        uint32_t heapIndex = CreateHeap(AlignUp(size, heapAlignment), heapAlignment, true);
+        if (heapIndex == ~0u)
+        {
+            return allocation;
+        }
+
+        Heap& heap = m_Heaps[heapIndex];
+        heap.requestedSize = size;
+        allocation.pHeap = heap.pHeap;
+        allocation.Offset = 0;
+        allocation.Size = size;
+        allocation.HeapIndex = heapIndex;
+        return allocation;
+    }
+
+    for (uint32_t i = 0; i < m_Heaps.size(); ++i)
+    {
+        Heap& heap = m_Heaps[i];
+        if (!heap.pHeap || heap.dedicated || heap.allocator->GetLargestFreeBlock() < blockSize)
+        {
+            continue;
+        }
+
+        uint64_t offset = heap.allocator->Allocate(size, alignment);
+        if (offset != BuddyAllocator::InvalidOffset)
+        {
+            allocation.pHeap = heap.pHeap;
+            allocation.Offset = offset;
+            allocation.Size = size;
+            allocation.HeapIndex = i;
+            return allocation;
+        }
+    }
+
+    // 所有堆都已满，创建一个新的堆
+    uint32_t heapIndex = CreateHeap(m_HeapSize, m_Alignment, false);
+    if (heapIndex == ~0u)
+    {
+        return allocation;
+    }
+
+    Heap& heap = m_Heaps[heapIndex];
+    allocation.pHeap = heap.pHeap;
+    allocation.Offset = heap.allocator->Allocate(size, alignment);
+    allocation.Size = size;
+    allocation.HeapIndex = heapIndex;
+
+    return allocation;
+}
+
+void HeapAllocator::Free(Allocation& allocation)
+{
+    if (!allocation.IsValid())
+    {
+        return;
+    }
+
+    assert(allocation.HeapIndex < m_Heaps.size() && m_Heaps[allocation.HeapIndex].pHeap == allocation.pHeap &&
+        "The allocation does not belong to this allocator.");
+
+    Heap& heap = m_Heaps[allocation.HeapIndex];
+
+    // Dedicated heaps are only used by a single resource.
+    if (heap.dedicated)
+    {
+        DestroyHeap(allocation.HeapIndex);
+    }
+    else
+    {
+        heap.allocator->Free(allocation.Offset);
+    }
+
+    allocation = Allocation();
+}
+
+HeapAllocator::Statistics HeapAllocator::GetStatistics() const
+{
+    Statistics stats;
+    uint64_t freeSize = 0;
+
+    for (const Heap& heap : m_Heaps)
+    {
+        if (!heap.pHeap)
+        {
+            continue;
+        }
+
+        stats.NumHeaps++;
+        if (heap.dedicated)
+        {
+            stats.NumAllocations++;
+            stats.ReservedSize += heap.size;
+            stats.UsedSize += heap.size;
+            stats.RequestedSize += heap.requestedSize;
+            continue;
+        }
+
+        stats.NumAllocations += static_cast<uint32_t>(heap.allocator->GetNumAllocations());
+        stats.ReservedSize += heap.allocator->GetSize();
+        stats.UsedSize += heap.allocator->GetUsedSize();
+        stats.RequestedSize += heap.allocator->GetRequestedSize();
+        stats.LargestFreeBlock = std::max(stats.LargestFreeBlock, heap.allocator->GetLargestFreeBlock());
+        freeSize += heap.allocator->GetFreeSize();
+    }
+
+    if (freeSize > 0)
+    {
+        stats.Fragmentation = 1.0f - static_cast<float>(stats.LargestFreeBlock) / static_cast<float>(freeSize);
+    }
+
+    return stats;
+}
+
+uint32_t HeapAllocator::CreateHeap(uint64_t size, uint64_t alignment, bool dedicated)
+{
+    void* pHeap = m_CreateHeap(size, alignment);
+    if (!pHeap)
+    {
+        return ~0u;
+    }
+
+    Heap heap = { pHeap, dedicated, size, 0, nullptr };
+    if (!dedicated)
+    {
+        heap.allocator = std::make_unique<BuddyAllocator>(size, m_Alignment);
+    }
+
+    // Reuse the slot of a destroyed heap if there is one.
+    for (uint32_t i = 0; i < m_Heaps.size(); ++i)
+    {
+        if (!m_Heaps[i].pHeap)
+        {
+            m_Heaps[i] = std::move(heap);
+            return i;
+        }
+    }
+
+    m_Heaps.push_back(std::move(heap));
+    return static_cast<uint32_t>(m_Heaps.size() - 1);
+}
+
+void HeapAllocator::DestroyHeap(uint32_t heapIndex)
+{
+    Heap& heap = m_Heaps[heapIndex];
+    m_DestroyHeap(heap.pHeap);
+    heap.pHeap = nullptr;
+    heap.allocator.reset();
+}
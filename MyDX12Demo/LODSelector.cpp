@@ -0,0 +1,180 @@
+#include <LODSelector.h>
+
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include <emmintrin.h> // SSE2
+
+using namespace DirectX;
+
+namespace
+{
+    // Instances per task when selecting on a thread pool.
+    const size_t InstancesPerTask = 4096;
+
+    // Closest distance used for the projection, the camera may be inside a bounding sphere.
+    const float MinDistance = 1e-3f;
+}
+
+LODSelector::LODSelector(const LODSelectionSettings& settings)
+    : m_Settings(settings)
+    , m_NumInstances(0)
+{
+    assert(settings.Hysteresis >= 0.0f && settings.Hysteresis < 1.0f);
+}
+
+uint32_t LODSelector::AddLODChain(const MeshFileLOD* pLODs, uint32_t lodCount)
+{
+    assert(lodCount > 0 && "A LOD chain needs at least LOD 0.");
+
+    LODChain chain;
+    chain.Offset = static_cast<uint32_t>(m_LODErrors.size());
+    chain.Count = lodCount;
+    for (uint32_t i = 0; i < lodCount; ++i)
+    {
+        assert((i == 0 || pLODs[i].Error >= pLODs[i - 1].Error) && "LOD errors must increase.");
+        m_LODErrors.push_back(pLODs[i].Error);
+    }
+
+    m_LODChains.push_back(chain);
+    return static_cast<uint32_t>(m_LODChains.size() - 1);
+}
+
+uint32_t LODSelector::AddInstance(uint32_t lodChain)
+{
+    assert(lodChain < m_LODChains.size());
+
+    uint32_t instance = static_cast<uint32_t>(m_NumInstances++);
+    size_t paddedCount = (m_NumInstances + 3) & ~size_t(3);
+
+    // Padding instances have no error and are never read back.
+    m_CenterX.resize(paddedCount, 0.0f);
+    m_CenterY.resize(paddedCount, 0.0f);
+    m_CenterZ.resize(paddedCount, 0.0f);
+    m_Radius.resize(paddedCount, 0.0f);
+    m_ErrorScale.resize(paddedCount, 0.0f);
+    m_PixelsPerUnit.resize(paddedCount, 0.0f);
+    m_ErrorScale[instance] = 1.0f;
+
+    m_InstanceChains.push_back(lodChain);
+    m_LODs.push_back(0);
+
+    return instance;
+}
+
+void LODSelector::SetInstanceBounds(uint32_t instance, const XMFLOAT3& center, float radius, float errorScale)
+{
+    assert(instance < m_NumInstances);
+
+    m_CenterX[instance] = center.x;
+    m_CenterY[instance] = center.y;
+    m_CenterZ[instance] = center.z;
+    m_Radius[instance] = radius;
+    m_ErrorScale[instance] = errorScale;
+}
+
+void LODSelector::Clear()
+{
+    m_LODErrors.clear();
+    m_LODChains.clear();
+    m_CenterX.clear();
+    m_CenterY.clear();
+    m_CenterZ.clear();
+    m_Radius.clear();
+    m_ErrorScale.clear();
+    m_PixelsPerUnit.clear();
+    m_InstanceChains.clear();
+    m_LODs.clear();
+    m_NumInstances = 0;
+}
+
+void LODSelector::Select(const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix, float viewportHeight, ThreadPool* pThreadPool)
+{
+    XMFLOAT4X4 view;
+    XMStoreFloat4x4(&view, viewMatrix);
+    XMFLOAT4X4 projection;
+    XMStoreFloat4x4(&projection, projectionMatrix);
+
+    // Pixels covered by one unit at distance 1: the projection scales y by 1 / tan(FoV / 2)
+    // and the viewport maps [-1, 1] to viewportHeight pixels.
+    const float projectionScale = projection._22 * viewportHeight * 0.5f;
+
+    const size_t paddedCount = m_CenterX.size();
+    const uint32_t numTasks = static_cast<uint32_t>((paddedCount + InstancesPerTask - 1) / InstancesPerTask);
+
+    ParallelFor(pThreadPool, numTasks, [&](uint32_t task)
+    {
+        size_t first = task * InstancesPerTask;
+        size_t count = std::min(InstancesPerTask, paddedCount - first);
+        ComputePixelsPerUnit(first, count, view, projectionScale);
+        SelectLODs(first, std::min(count, m_NumInstances - std::min(first, m_NumInstances)));
+    });
+}
+
+void LODSelector::ComputePixelsPerUnit(size_t first, size_t count, const XMFLOAT4X4& view, float projectionScale)
+{
+    assert(first % 4 == 0 && count % 4 == 0);
+
+    // DirectXMath uses row vectors: viewPosition = position * view.
+    const __m128 m00 = _mm_set1_ps(view._11), m01 = _mm_set1_ps(view._12), m02 = _mm_set1_ps(view._13);
+    const __m128 m10 = _mm_set1_ps(view._21), m11 = _mm_set1_ps(view._22), m12 = _mm_set1_ps(view._23);
+    const __m128 m20 = _mm_set1_ps(view._31), m21 = _mm_set1_ps(view._32), m22 = _mm_set1_ps(view._33);
+    const __m128 m30 = _mm_set1_ps(view._41), m31 = _mm_set1_ps(view._42), m32 = _mm_set1_ps(view._43);
+    const __m128 scale = _mm_set1_ps(projectionScale);
+    const __m128 minDistance = _mm_set1_ps(MinDistance);
+
+    for (size_t i = first; i < first + count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&m_CenterX[i]);
+        __m128 y = _mm_loadu_ps(&m_CenterY[i]);
+        __m128 z = _mm_loadu_ps(&m_CenterZ[i]);
+
+        __m128 vx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10)), _mm_add_ps(_mm_mul_ps(z, m20), m30));
+        __m128 vy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11)), _mm_add_ps(_mm_mul_ps(z, m21), m31));
+        __m128 vz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m02), _mm_mul_ps(y, m12)), _mm_add_ps(_mm_mul_ps(z, m22), m32));
+
+        // Distance to the closest point of the sphere, so the error is never underestimated.
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+        distance = _mm_max_ps(_mm_sub_ps(distance, _mm_loadu_ps(&m_Radius[i])), minDistance);
+
+        __m128 pixelsPerUnit = _mm_div_ps(_mm_mul_ps(scale, _mm_loadu_ps(&m_ErrorScale[i])), distance);
+        _mm_storeu_ps(&m_PixelsPerUnit[i], pixelsPerUnit);
+    }
+}
+
+void LODSelector::SelectLODs(size_t first, size_t count)
+{
+    const float threshold = m_Settings.ErrorThreshold;
+    const float coarserThreshold = m_Settings.ErrorThreshold * (1.0f - m_Settings.Hysteresis);
+
+    for (size_t i = first; i < first + count; ++i)
+    {
+        const LODChain& chain = m_LODChains[m_InstanceChains[i]];
+        const float* pErrors = &m_LODErrors[chain.Offset];
+        const float pixelsPerUnit = m_PixelsPerUnit[i];
+
+        // The coarsest LOD whose projected error is within maxPixels.
+        auto coarsestLOD = [&](float maxPixels)
+        {
+            uint32_t lod = 0;
+            while (lod + 1 < chain.Count && pErrors[lod + 1] * pixelsPerUnit <= maxPixels)
+            {
+                ++lod;
+            }
+            return lod;
+        };
+
+        uint32_t current = std::min(m_LODs[i], chain.Count - 1);
+        if (pErrors[current] * pixelsPerUnit > threshold)
+        {
+            // Too coarse, refine right away.
+            m_LODs[i] = coarsestLOD(threshold);
+        }
+        else
+        {
+            m_LODs[i] = std::max(current, coarsestLOD(coarserThreshold));
+        }
+    }
+}
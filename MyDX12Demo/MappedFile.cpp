@@ -0,0 +1,126 @@
+#include <MappedFile.h>
+
+#include <cstdint>
+#include <filesystem>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#if defined(min)
+#undef min
+#endif
+
+#if defined(max)
+#undef max
+#endif
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : m_pData(nullptr)
+    , m_Size(0)
+    , m_hFile(nullptr)
+    , m_hMapping(nullptr)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::wstring& fileName)
+{
+    Close();
+
+#if defined(_WIN32)
+    HANDLE hFile = ::CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    m_hFile = hFile;
+
+    LARGE_INTEGER fileSize;
+    if (!::GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+    m_Size = static_cast<size_t>(fileSize.QuadPart);
+
+    m_hMapping = ::CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_hMapping)
+    {
+        Close();
+        return false;
+    }
+
+    m_pData = ::MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    int fd = ::open(std::filesystem::path(fileName).c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    m_hFile = reinterpret_cast<void*>(static_cast<intptr_t>(fd) + 1);
+
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        Close();
+        return false;
+    }
+    m_Size = static_cast<size_t>(fileStat.st_size);
+
+    void* pData = ::mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    m_pData = pData == MAP_FAILED ? nullptr : pData;
+#endif
+
+    if (!m_pData)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+    if (m_pData)
+    {
+        ::UnmapViewOfFile(m_pData);
+    }
+    if (m_hMapping)
+    {
+        ::CloseHandle(m_hMapping);
+    }
+    if (m_hFile)
+    {
+        ::CloseHandle(m_hFile);
+    }
+#else
+    if (m_pData)
+    {
+        ::munmap(const_cast<void*>(m_pData), m_Size);
+    }
+    if (m_hFile)
+    {
+        // The descriptor is stored off by one so that 0 means "no file".
+        ::close(static_cast<int>(reinterpret_cast<intptr_t>(m_hFile) - 1));
+    }
+#endif
+
+    m_pData = nullptr;
+    m_Size = 0;
+    m_hFile = nullptr;
+    m_hMapping = nullptr;
+}
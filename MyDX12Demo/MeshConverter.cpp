@@ -0,0 +1,145 @@
+#include <MeshConverter.h>
+#include <MeshOptimizer.h>
+#include <MeshSimplifier.h>
+#include <VertexQuantization.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    struct PosColor
+    {
+        float Position[3];
+        float Color[3];
+    };
+
+    // Start a new submesh at the current end of the index buffer.
+    void BeginSubmesh(MeshData& mesh)
+    {
+        if (!mesh.Submeshes.empty() && mesh.Submeshes.back().IndexCount == 0)
+        {
+            return;
+        }
+
+        MeshFileSubmesh submesh = {};
+        submesh.IndexStart = static_cast<uint32_t>(mesh.Indices.size());
+        mesh.Submeshes.push_back(submesh);
+    }
+}
+
+bool LoadObjMesh(const std::wstring& fileName, MeshData& mesh)
+{
+    std::ifstream file(std::filesystem::path(fileName), std::ios::in);
+    if (!file)
+    {
+        return false;
+    }
+
+    std::vector<PosColor> vertices;
+    mesh = MeshData();
+    BeginSubmesh(mesh);
+
+    std::string line;
+    std::vector<uint32_t> polygon;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string keyword;
+        stream >> keyword;
+
+        if (keyword == "v")
+        {
+            PosColor vertex = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+            stream >> vertex.Position[0] >> vertex.Position[1] >> vertex.Position[2];
+            float color[3];
+            if (stream >> color[0] >> color[1] >> color[2])
+            {
+                memcpy(vertex.Color, color, sizeof(color));
+            }
+            vertices.push_back(vertex);
+        }
+        else if (keyword == "f")
+        {
+            polygon.clear();
+            std::string corner;
+            while (stream >> corner)
+            {
+                // Only the position index is used ("v", "v/vt", "v/vt/vn" or "v//vn").
+                long index = std::strtol(corner.c_str(), nullptr, 10);
+                if (index < 0)
+                {
+                    index += static_cast<long>(vertices.size()) + 1;
+                }
+                if (index <= 0 || index > static_cast<long>(vertices.size()))
+                {
+                    return false;
+                }
+                polygon.push_back(static_cast<uint32_t>(index - 1));
+            }
+
+            // 三角形扇
+            for (size_t i = 2; i < polygon.size(); ++i)
+            {
+                mesh.Indices.push_back(polygon[0]);
+                mesh.Indices.push_back(polygon[i - 1]);
+                mesh.Indices.push_back(polygon[i]);
+                mesh.Submeshes.back().IndexCount += 3;
+            }
+        }
+        else if (keyword == "o" || keyword == "g")
+        {
+            BeginSubmesh(mesh);
+        }
+    }
+
+    if (mesh.Submeshes.back().IndexCount == 0)
+    {
+        mesh.Submeshes.pop_back();
+    }
+    if (mesh.Indices.empty())
+    {
+        return false;
+    }
+
+    for (MeshFileSubmesh& submesh : mesh.Submeshes)
+    {
+        // Submeshes index the shared vertex buffer directly.
+        submesh.BaseVertex = 0;
+        submesh.VertexCount = static_cast<uint32_t>(vertices.size());
+    }
+
+    mesh.VertexStride = sizeof(PosColor);
+    mesh.Attributes = {
+        { MeshAttributeSemantic::Position, MeshFormatR32G32B32Float, offsetof(PosColor, Position) },
+        { MeshAttributeSemantic::Color, MeshFormatR32G32B32Float, offsetof(PosColor, Color) },
+    };
+    mesh.Vertices.resize(vertices.size() * sizeof(PosColor));
+    memcpy(mesh.Vertices.data(), vertices.data(), mesh.Vertices.size());
+
+    return true;
+}
+
+bool ConvertObjToMeshFile(const std::wstring& objFileName, const std::wstring& meshFileName)
+{
+    MeshData mesh;
+    if (!LoadObjMesh(objFileName, mesh))
+    {
+        return false;
+    }
+
+    // Reordering, simplification and bounds need the float positions, so they run before quantization.
+    OptimizeMesh(mesh);
+    GenerateLODs(mesh);
+    ComputeSubmeshBounds(mesh);
+    if (!QuantizeMesh(mesh))
+    {
+        return false;
+    }
+
+    return WriteMeshFile(meshFileName, mesh);
+}
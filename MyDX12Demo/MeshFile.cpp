@@ -0,0 +1,264 @@
+#include <MeshFile.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // [offset, offset + count * elementSize) lies in [0, size), without overflowing on crafted values.
+    bool IsRangeInside(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t size)
+    {
+        return offset <= size && count <= (size - offset) / elementSize;
+    }
+
+    // [start, start + count) lies in [0, total).
+    bool IsRangeInside(uint64_t start, uint64_t count, uint64_t total)
+    {
+        return start <= total && count <= total - start;
+    }
+}
+
+const char* GetSemanticName(MeshAttributeSemantic semantic)
+{
+    switch (semantic)
+    {
+    case MeshAttributeSemantic::Position:
+        return "POSITION";
+    case MeshAttributeSemantic::Normal:
+        return "NORMAL";
+    case MeshAttributeSemantic::Color:
+        return "COLOR";
+    case MeshAttributeSemantic::TexCoord:
+        return "TEXCOORD";
+    default:
+        assert(false && "Invalid attribute semantic.");
+        return "";
+    }
+}
+
+const MeshVertexAttribute* MeshData::FindAttribute(MeshAttributeSemantic semantic) const
+{
+    for (const MeshVertexAttribute& attribute : Attributes)
+    {
+        if (attribute.Semantic == semantic)
+        {
+            return &attribute;
+        }
+    }
+
+    return nullptr;
+}
+
+void ComputeSubmeshBounds(MeshData& mesh)
+{
+    const MeshVertexAttribute* pPosition = mesh.FindAttribute(MeshAttributeSemantic::Position);
+    assert(pPosition && pPosition->Format == MeshFormatR32G32B32Float && "Positions must be R32G32B32_FLOAT.");
+
+    auto getPosition = [&](uint32_t vertex, float position[3])
+    {
+        memcpy(position, mesh.Vertices.data() + size_t(vertex) * mesh.VertexStride + pPosition->Offset, sizeof(float) * 3);
+    };
+
+    for (MeshFileSubmesh& submesh : mesh.Submeshes)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            submesh.BoundsMin[c] = submesh.IndexCount ? INFINITY : 0.0f;
+            submesh.BoundsMax[c] = submesh.IndexCount ? -INFINITY : 0.0f;
+        }
+
+        for (uint32_t i = 0; i < submesh.IndexCount; ++i)
+        {
+            float p[3];
+            getPosition(submesh.BaseVertex + mesh.Indices[submesh.IndexStart + i], p);
+            for (int c = 0; c < 3; ++c)
+            {
+                submesh.BoundsMin[c] = std::min(submesh.BoundsMin[c], p[c]);
+                submesh.BoundsMax[c] = std::max(submesh.BoundsMax[c], p[c]);
+            }
+        }
+
+        // Sphere around the center of the box, tight enough for culling and LOD selection.
+        float radiusSq = 0.0f;
+        for (int c = 0; c < 3; ++c)
+        {
+            submesh.SphereCenter[c] = (submesh.BoundsMin[c] + submesh.BoundsMax[c]) * 0.5f;
+        }
+        for (uint32_t i = 0; i < submesh.IndexCount; ++i)
+        {
+            float p[3];
+            getPosition(submesh.BaseVertex + mesh.Indices[submesh.IndexStart + i], p);
+            float dx = p[0] - submesh.SphereCenter[0];
+            float dy = p[1] - submesh.SphereCenter[1];
+            float dz = p[2] - submesh.SphereCenter[2];
+            radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+        }
+        submesh.SphereRadius = std::sqrt(radiusSq);
+    }
+}
+
+bool WriteMeshFile(const std::wstring& fileName, const MeshData& mesh)
+{
+    if (mesh.VertexStride == 0 || mesh.Attributes.size() > MeshFileMaxAttributes)
+    {
+        return false;
+    }
+
+    uint64_t vertexCount = mesh.GetVertexCount();
+    bool use16BitIndices = vertexCount <= 0xFFFF;
+    uint64_t indexSize = use16BitIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    MeshFileHeader header = {};
+    header.Magic = MeshFileMagic;
+    header.Version = MeshFileVersion;
+    header.VertexStride = mesh.VertexStride;
+    header.NumAttributes = static_cast<uint32_t>(mesh.Attributes.size());
+    std::copy(mesh.Attributes.begin(), mesh.Attributes.end(), header.Attributes);
+    header.IndexFormat = use16BitIndices ? MeshFormatR16UInt : MeshFormatR32UInt;
+    header.NumSubmeshes = static_cast<uint32_t>(mesh.Submeshes.size());
+    header.VertexCount = vertexCount;
+    header.IndexCount = mesh.Indices.size();
+    header.SubmeshOffset = sizeof(MeshFileHeader);
+    header.NumLODs = static_cast<uint32_t>(mesh.LODs.size());
+    header.LODOffset = header.SubmeshOffset + sizeof(MeshFileSubmesh) * mesh.Submeshes.size();
+    header.VertexDataOffset = AlignUp(header.LODOffset + sizeof(MeshFileLOD) * mesh.LODs.size(), MeshFileAlignment);
+    header.VertexDataSize = vertexCount * mesh.VertexStride;
+    header.IndexDataOffset = AlignUp(header.VertexDataOffset + header.VertexDataSize, MeshFileAlignment);
+    header.IndexDataSize = mesh.Indices.size() * indexSize;
+    header.FileSize = header.IndexDataOffset + header.IndexDataSize;
+    std::copy(mesh.PositionScale, mesh.PositionScale + 3, header.PositionScale);
+    std::copy(mesh.PositionBias, mesh.PositionBias + 3, header.PositionBias);
+
+    std::vector<uint8_t> fileData(static_cast<size_t>(header.FileSize), 0);
+    memcpy(fileData.data(), &header, sizeof(header));
+    if (!mesh.Submeshes.empty())
+    {
+        memcpy(fileData.data() + header.SubmeshOffset, mesh.Submeshes.data(), sizeof(MeshFileSubmesh) * mesh.Submeshes.size());
+    }
+    if (!mesh.LODs.empty())
+    {
+        memcpy(fileData.data() + header.LODOffset, mesh.LODs.data(), sizeof(MeshFileLOD) * mesh.LODs.size());
+    }
+    if (!mesh.Vertices.empty())
+    {
+        memcpy(fileData.data() + header.VertexDataOffset, mesh.Vertices.data(), static_cast<size_t>(header.VertexDataSize));
+    }
+
+    uint8_t* pIndices = fileData.data() + header.IndexDataOffset;
+    for (size_t i = 0; i < mesh.Indices.size(); ++i)
+    {
+        if (use16BitIndices)
+        {
+            uint16_t index = static_cast<uint16_t>(mesh.Indices[i]);
+            memcpy(pIndices + i * sizeof(uint16_t), &index, sizeof(uint16_t));
+        }
+        else
+        {
+            memcpy(pIndices + i * sizeof(uint32_t), &mesh.Indices[i], sizeof(uint32_t));
+        }
+    }
+
+    std::ofstream file(std::filesystem::path(fileName), std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(fileData.data()), fileData.size());
+    return static_cast<bool>(file);
+}
+
+MeshFile::MeshFile()
+{
+}
+
+MeshFile::~MeshFile()
+{
+    Close();
+}
+
+bool MeshFile::Open(const std::wstring& fileName)
+{
+    Close();
+
+    if (!m_File.Open(fileName) || !Validate())
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MeshFile::Close()
+{
+    m_File.Close();
+}
+
+bool MeshFile::Validate() const
+{
+    const size_t size = m_File.GetSize();
+    if (size < sizeof(MeshFileHeader))
+    {
+        return false;
+    }
+
+    const MeshFileHeader& header = GetHeader();
+    if (header.Magic != MeshFileMagic || header.Version != MeshFileVersion ||
+        header.FileSize != size || header.NumAttributes > MeshFileMaxAttributes || header.VertexStride == 0)
+    {
+        return false;
+    }
+
+    uint64_t indexSize = header.IndexFormat == MeshFormatR16UInt ? sizeof(uint16_t) :
+        header.IndexFormat == MeshFormatR32UInt ? sizeof(uint32_t) : 0;
+
+    // Every stream must lie inside the file, so the views can be used without further checks.
+    if (indexSize == 0 ||
+        !IsRangeInside(header.SubmeshOffset, header.NumSubmeshes, sizeof(MeshFileSubmesh), size) ||
+        !IsRangeInside(header.LODOffset, header.NumLODs, sizeof(MeshFileLOD), size) ||
+        !IsRangeInside(header.VertexDataOffset, header.VertexCount, header.VertexStride, size) ||
+        !IsRangeInside(header.IndexDataOffset, header.IndexCount, indexSize, size) ||
+        header.VertexDataSize != header.VertexCount * header.VertexStride ||
+        header.IndexDataSize != header.IndexCount * indexSize ||
+        header.SubmeshOffset % alignof(MeshFileSubmesh) != 0 ||
+        header.LODOffset % alignof(MeshFileLOD) != 0 ||
+        header.VertexDataOffset % MeshFileAlignment != 0 ||
+        header.IndexDataOffset % MeshFileAlignment != 0)
+    {
+        return false;
+    }
+
+    // The submeshes and LODs are drawn straight from the file, their ranges must lie inside the streams.
+    const MeshFileSubmesh* pSubmeshes = GetSubmeshes();
+    for (uint32_t i = 0; i < header.NumSubmeshes; ++i)
+    {
+        const MeshFileSubmesh& submesh = pSubmeshes[i];
+        if (!IsRangeInside(submesh.IndexStart, submesh.IndexCount, header.IndexCount) ||
+            !IsRangeInside(submesh.BaseVertex, submesh.VertexCount, header.VertexCount) ||
+            (submesh.LODCount != 0 && !IsRangeInside(submesh.LODOffset, submesh.LODCount, header.NumLODs)))
+        {
+            return false;
+        }
+    }
+
+    const MeshFileLOD* pLODs = GetLODs();
+    for (uint32_t i = 0; i < header.NumLODs; ++i)
+    {
+        if (!IsRangeInside(pLODs[i].IndexStart, pLODs[i].IndexCount, header.IndexCount))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
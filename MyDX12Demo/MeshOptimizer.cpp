@@ -0,0 +1,468 @@
+#include <MeshOptimizer.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    /**
+     * FIFO post-transform cache. Every miss pushes the vertex with a new time stamp,
+     * a vertex is still cached if fewer than cacheSize misses happened since.
+     */
+    class FIFOCache
+    {
+    public:
+        FIFOCache(size_t vertexCount, uint32_t cacheSize)
+            : m_CacheTime(vertexCount, 0)
+            , m_CacheSize(cacheSize)
+            , m_TimeStamp(cacheSize + 1)
+        {
+        }
+
+        // Returns true if the vertex had to be transformed.
+        bool Access(uint32_t vertex)
+        {
+            if (m_TimeStamp - m_CacheTime[vertex] > m_CacheSize)
+            {
+                m_CacheTime[vertex] = m_TimeStamp++;
+                return true;
+            }
+
+            return false;
+        }
+
+        void Flush()
+        {
+            m_TimeStamp += m_CacheSize + 1;
+        }
+
+    private:
+        std::vector<uint32_t> m_CacheTime;
+        uint32_t m_CacheSize;
+        uint32_t m_TimeStamp;
+    };
+
+    // Triangles that use each vertex, in CSR form.
+    struct TriangleAdjacency
+    {
+        std::vector<uint32_t> Counts;
+        std::vector<uint32_t> Offsets;
+        std::vector<uint32_t> Triangles;
+
+        TriangleAdjacency(const uint32_t* pIndices, size_t indexCount, size_t vertexCount)
+            : Counts(vertexCount, 0)
+            , Offsets(vertexCount + 1, 0)
+            , Triangles(indexCount)
+        {
+            for (size_t i = 0; i < indexCount; ++i)
+            {
+                assert(pIndices[i] < vertexCount && "Index out of range.");
+                Counts[pIndices[i]]++;
+            }
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                Offsets[v + 1] = Offsets[v] + Counts[v];
+            }
+
+            std::vector<uint32_t> fill(Offsets.begin(), Offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; ++i)
+            {
+                Triangles[fill[pIndices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+    };
+
+    struct Float3
+    {
+        float x, y, z;
+    };
+
+    Float3 GetPosition(const float* pPositions, size_t positionStride, uint32_t vertex)
+    {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(pPositions) + vertex * positionStride);
+        return { p[0], p[1], p[2] };
+    }
+}
+
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    assert(indexCount % 3 == 0);
+
+    VertexCacheStatistics statistics;
+    FIFOCache cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount, false);
+    size_t numReferenced = 0;
+
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t vertex = pIndices[i];
+        assert(vertex < vertexCount && "Index out of range.");
+
+        if (cache.Access(vertex))
+        {
+            statistics.VerticesTransformed++;
+        }
+        if (!referenced[vertex])
+        {
+            referenced[vertex] = true;
+            numReferenced++;
+        }
+    }
+
+    if (indexCount > 0)
+    {
+        statistics.ACMR = float(statistics.VerticesTransformed) / float(indexCount / 3);
+        statistics.ATVR = float(statistics.VerticesTransformed) / float(numReferenced);
+    }
+
+    return statistics;
+}
+
+void OptimizeVertexCache(uint32_t* pDestination, const uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    assert(indexCount % 3 == 0);
+    if (indexCount == 0)
+    {
+        return;
+    }
+
+    const size_t triangleCount = indexCount / 3;
+    TriangleAdjacency adjacency(pIndices, indexCount, vertexCount);
+
+    // Number of triangles that still have to be emitted, per vertex.
+    std::vector<uint32_t> liveTriangles = adjacency.Counts;
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    // Recently referenced vertices, used to restart after a dead end.
+    std::vector<uint32_t> deadEndStack;
+    deadEndStack.reserve(indexCount);
+    std::vector<uint32_t> candidates;
+
+    std::vector<uint32_t> result;
+    result.reserve(indexCount);
+
+    uint32_t timeStamp = cacheSize + 1;
+    uint32_t cursor = 0;
+    uint32_t fanningVertex = pIndices[0];
+
+    auto skipDeadEnd = [&]() -> uint32_t
+    {
+        while (!deadEndStack.empty())
+        {
+            uint32_t vertex = deadEndStack.back();
+            deadEndStack.pop_back();
+            if (liveTriangles[vertex] > 0)
+            {
+                return vertex;
+            }
+        }
+        // 按输入顺序寻找下一个仍有三角形的顶点
+        while (cursor < vertexCount)
+        {
+            uint32_t vertex = cursor++;
+            if (liveTriangles[vertex] > 0)
+            {
+                return vertex;
+            }
+        }
+        return InvalidVertexIndex;
+    };
+
+    while (fanningVertex != InvalidVertexIndex)
+    {
+        candidates.clear();
+
+        // Emit all remaining triangles around the fanning vertex.
+        for (uint32_t a = adjacency.Offsets[fanningVertex]; a < adjacency.Offsets[fanningVertex + 1]; ++a)
+        {
+            uint32_t triangle = adjacency.Triangles[a];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t vertex = pIndices[triangle * 3 + k];
+                result.push_back(vertex);
+                deadEndStack.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                if (timeStamp - cacheTime[vertex] > cacheSize)
+                {
+                    cacheTime[vertex] = timeStamp++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // Prefer the candidate that is oldest in the cache but will still be
+        // in it after its remaining triangles have been emitted.
+        uint32_t nextVertex = InvalidVertexIndex;
+        int64_t bestPriority = -1;
+        for (uint32_t vertex : candidates)
+        {
+            if (liveTriangles[vertex] == 0)
+            {
+                continue;
+            }
+
+            int64_t priority = 0;
+            int64_t age = int64_t(timeStamp) - int64_t(cacheTime[vertex]);
+            if (age + 2 * int64_t(liveTriangles[vertex]) <= int64_t(cacheSize))
+            {
+                priority = age;
+            }
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                nextVertex = vertex;
+            }
+        }
+
+        fanningVertex = nextVertex != InvalidVertexIndex ? nextVertex : skipDeadEnd();
+    }
+
+    assert(result.size() == indexCount);
+    memcpy(pDestination, result.data(), indexCount * sizeof(uint32_t));
+}
+
+void OptimizeOverdraw(uint32_t* pDestination, const uint32_t* pIndices, size_t indexCount,
+    const float* pPositions, size_t positionStride, size_t vertexCount,
+    float threshold, uint32_t cacheSize)
+{
+    assert(indexCount % 3 == 0);
+    assert(pDestination != pIndices && "OptimizeOverdraw can not work in place.");
+    if (indexCount == 0)
+    {
+        return;
+    }
+
+    const size_t triangleCount = indexCount / 3;
+    const float targetACMR = AnalyzeVertexCache(pIndices, indexCount, vertexCount, cacheSize).ACMR * threshold;
+
+    // Hard boundaries: triangles where the cache starts over (all three vertices miss).
+    // Within those, split as soon as the cluster's ACMR is within the target, so the
+    // clusters can be reordered without losing more than the allowed cache efficiency.
+    std::vector<uint32_t> clusterStarts;
+    {
+        FIFOCache hardCache(vertexCount, cacheSize);
+        FIFOCache softCache(vertexCount, cacheSize);
+        uint32_t clusterMisses = 0;
+        uint32_t clusterTriangles = 0;
+
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            uint32_t hardMisses = 0;
+            for (int k = 0; k < 3; ++k)
+            {
+                hardMisses += hardCache.Access(pIndices[t * 3 + k]) ? 1 : 0;
+            }
+
+            if (t == 0 || hardMisses == 3 || clusterTriangles == 0)
+            {
+                if (clusterStarts.empty() || clusterStarts.back() != t)
+                {
+                    clusterStarts.push_back(static_cast<uint32_t>(t));
+                }
+                softCache.Flush();
+                clusterMisses = 0;
+                clusterTriangles = 0;
+            }
+
+            for (int k = 0; k < 3; ++k)
+            {
+                clusterMisses += softCache.Access(pIndices[t * 3 + k]) ? 1 : 0;
+            }
+            clusterTriangles++;
+
+            if (float(clusterMisses) <= targetACMR * float(clusterTriangles) && t + 1 < triangleCount)
+            {
+                clusterStarts.push_back(static_cast<uint32_t>(t + 1));
+                softCache.Flush();
+                clusterMisses = 0;
+                clusterTriangles = 0;
+            }
+        }
+    }
+    const size_t clusterCount = clusterStarts.size();
+    clusterStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+    // Mesh centroid.
+    Float3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        Float3 p = GetPosition(pPositions, positionStride, pIndices[i]);
+        meshCentroid.x += p.x;
+        meshCentroid.y += p.y;
+        meshCentroid.z += p.z;
+    }
+    meshCentroid.x /= float(indexCount);
+    meshCentroid.y /= float(indexCount);
+    meshCentroid.z /= float(indexCount);
+
+    // Clusters that face away from the center are likely in front, draw them first.
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        Float3 centroid = { 0.0f, 0.0f, 0.0f };
+        Float3 normal = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+
+        for (uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+        {
+            Float3 p0 = GetPosition(pPositions, positionStride, pIndices[t * 3 + 0]);
+            Float3 p1 = GetPosition(pPositions, positionStride, pIndices[t * 3 + 1]);
+            Float3 p2 = GetPosition(pPositions, positionStride, pIndices[t * 3 + 2]);
+
+            Float3 e1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+            Float3 e2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+            // Length of the cross product is twice the area, so it weights the sums.
+            Float3 n = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+            float w = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+
+            centroid.x += (p0.x + p1.x + p2.x) * (w / 3.0f);
+            centroid.y += (p0.y + p1.y + p2.y) * (w / 3.0f);
+            centroid.z += (p0.z + p1.z + p2.z) * (w / 3.0f);
+            normal.x += n.x;
+            normal.y += n.y;
+            normal.z += n.z;
+            area += w;
+        }
+
+        float invArea = area > 0.0f ? 1.0f / area : 0.0f;
+        centroid = { centroid.x * invArea, centroid.y * invArea, centroid.z * invArea };
+
+        float normalLength = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        float invNormalLength = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+
+        sortKeys[c] = ((centroid.x - meshCentroid.x) * normal.x +
+            (centroid.y - meshCentroid.y) * normal.y +
+            (centroid.z - meshCentroid.z) * normal.z) * invNormalLength;
+    }
+
+    std::vector<uint32_t> clusterOrder(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        clusterOrder[c] = static_cast<uint32_t>(c);
+    }
+    // Stable so the result does not depend on the sort implementation.
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t a, uint32_t b)
+    {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    size_t offset = 0;
+    for (uint32_t c : clusterOrder)
+    {
+        size_t count = (clusterStarts[c + 1] - clusterStarts[c]) * 3;
+        memcpy(pDestination + offset, pIndices + size_t(clusterStarts[c]) * 3, count * sizeof(uint32_t));
+        offset += count;
+    }
+}
+
+size_t OptimizeVertexFetchRemap(uint32_t* pRemap, const uint32_t* pIndices, size_t indexCount, size_t vertexCount)
+{
+    std::fill(pRemap, pRemap + vertexCount, InvalidVertexIndex);
+
+    uint32_t nextVertex = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t vertex = pIndices[i];
+        assert(vertex < vertexCount && "Index out of range.");
+
+        if (pRemap[vertex] == InvalidVertexIndex)
+        {
+            pRemap[vertex] = nextVertex++;
+        }
+    }
+
+    return nextVertex;
+}
+
+void RemapIndexBuffer(uint32_t* pDestination, const uint32_t* pIndices, size_t indexCount, const uint32_t* pRemap)
+{
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        assert(pRemap[pIndices[i]] != InvalidVertexIndex);
+        pDestination[i] = pRemap[pIndices[i]];
+    }
+}
+
+void RemapVertexBuffer(void* pDestination, const void* pVertices, size_t vertexCount, size_t vertexStride, const uint32_t* pRemap)
+{
+    assert(pDestination != pVertices && "RemapVertexBuffer can not work in place.");
+
+    uint8_t* pDest = static_cast<uint8_t*>(pDestination);
+    const uint8_t* pSrc = static_cast<const uint8_t*>(pVertices);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        if (pRemap[v] != InvalidVertexIndex)
+        {
+            memcpy(pDest + size_t(pRemap[v]) * vertexStride, pSrc + v * vertexStride, vertexStride);
+        }
+    }
+}
+
+void OptimizeMesh(MeshData& mesh, uint32_t cacheSize, float overdrawThreshold)
+{
+    const size_t vertexCount = mesh.GetVertexCount();
+    if (mesh.Indices.empty() || vertexCount == 0)
+    {
+        return;
+    }
+
+    // Work on indices relative to the start of the vertex buffer.
+    for (MeshFileSubmesh& submesh : mesh.Submeshes)
+    {
+        for (uint32_t i = 0; i < submesh.IndexCount; ++i)
+        {
+            mesh.Indices[submesh.IndexStart + i] += submesh.BaseVertex;
+        }
+        submesh.BaseVertex = 0;
+    }
+
+    const MeshVertexAttribute* pPosition = mesh.FindAttribute(MeshAttributeSemantic::Position);
+    const float* pPositions = pPosition && pPosition->Format == MeshFormatR32G32B32Float ?
+        reinterpret_cast<const float*>(mesh.Vertices.data() + pPosition->Offset) : nullptr;
+
+    auto optimizeRange = [&](uint32_t indexStart, uint32_t indexCount)
+    {
+        uint32_t* pIndices = mesh.Indices.data() + indexStart;
+        OptimizeVertexCache(pIndices, pIndices, indexCount, vertexCount, cacheSize);
+
+        if (pPositions)
+        {
+            std::vector<uint32_t> reordered(indexCount);
+            OptimizeOverdraw(reordered.data(), pIndices, indexCount, pPositions, mesh.VertexStride, vertexCount,
+                overdrawThreshold, cacheSize);
+            std::copy(reordered.begin(), reordered.end(), pIndices);
+        }
+    };
+
+    if (mesh.Submeshes.empty())
+    {
+        optimizeRange(0, static_cast<uint32_t>(mesh.Indices.size()));
+    }
+    for (const MeshFileSubmesh& submesh : mesh.Submeshes)
+    {
+        optimizeRange(submesh.IndexStart, submesh.IndexCount);
+    }
+
+    // Vertex fetch order of the whole buffer, shared by all submeshes.
+    std::vector<uint32_t> remap(vertexCount);
+    size_t uniqueVertexCount = OptimizeVertexFetchRemap(remap.data(), mesh.Indices.data(), mesh.Indices.size(), vertexCount);
+    RemapIndexBuffer(mesh.Indices.data(), mesh.Indices.data(), mesh.Indices.size(), remap.data());
+
+    std::vector<uint8_t> vertices(uniqueVertexCount * mesh.VertexStride);
+    RemapVertexBuffer(vertices.data(), mesh.Vertices.data(), vertexCount, mesh.VertexStride, remap.data());
+    mesh.Vertices = std::move(vertices);
+
+    for (MeshFileSubmesh& submesh : mesh.Submeshes)
+    {
+        submesh.VertexCount = static_cast<uint32_t>(uniqueVertexCount);
+    }
+}
@@ -0,0 +1,520 @@
+#include <MeshSimplifier.h>
+
+#include <MeshOptimizer.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    // Weight of the planes that keep open borders in place, relative to the triangle planes.
+    const float BorderWeight = 10.0f;
+
+    // A level must remove at least this fraction of the indices of the previous one.
+    const float MinLODReduction = 0.1f;
+
+    enum class VertexKind : uint8_t
+    {
+        Interior,
+        // On an open border, may only collapse along it.
+        Border,
+        // Never moves: locked borders and seams (several vertices at the same position).
+        Locked,
+    };
+
+    struct Float3
+    {
+        float x, y, z;
+    };
+
+    Float3 Subtract(const Float3& a, const Float3& b)
+    {
+        return { a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+
+    float Dot(const Float3& a, const Float3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    Float3 Cross(const Float3& a, const Float3& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    // Sum of squared distances to a set of weighted planes.
+    struct Quadric
+    {
+        double a00, a11, a22, a01, a02, a12;
+        double b0, b1, b2;
+        double c;
+        // Sum of the plane weights, to turn the sum into an average.
+        double w;
+
+        void AddPlane(const Float3& normal, const Float3& point, double weight)
+        {
+            double nx = normal.x, ny = normal.y, nz = normal.z;
+            double d = -(nx * point.x + ny * point.y + nz * point.z);
+
+            a00 += weight * nx * nx;
+            a11 += weight * ny * ny;
+            a22 += weight * nz * nz;
+            a01 += weight * nx * ny;
+            a02 += weight * nx * nz;
+            a12 += weight * ny * nz;
+            b0 += weight * d * nx;
+            b1 += weight * d * ny;
+            b2 += weight * d * nz;
+            c += weight * d * d;
+            w += weight;
+        }
+
+        void Add(const Quadric& other)
+        {
+            a00 += other.a00; a11 += other.a11; a22 += other.a22;
+            a01 += other.a01; a02 += other.a02; a12 += other.a12;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            w += other.w;
+        }
+
+        double Evaluate(const Float3& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double result = a00 * x * x + a11 * y * y + a22 * z * z +
+                2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return std::max(result, 0.0);
+        }
+    };
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+
+    struct Collapse
+    {
+        uint32_t Source;
+        uint32_t Target;
+        // Geometric error plus attribute error, decides the order of the collapses.
+        float Cost;
+        // Squared geometric error only.
+        float Error;
+    };
+}
+
+size_t SimplifyMesh(uint32_t* pDestination, const uint32_t* pIndices, size_t indexCount,
+    const float* pPositions, size_t positionStride, size_t vertexCount,
+    size_t targetIndexCount, float targetError, const SimplifySettings& settings, float* pResultError)
+{
+    assert(indexCount % 3 == 0);
+    assert(settings.AttributeCount <= MaxSimplifyAttributes);
+
+    std::vector<uint32_t> indices(pIndices, pIndices + indexCount);
+
+    // Work in a unit cube, so the attribute weights do not depend on the size of the mesh.
+    Float3 boundsMin = { INFINITY, INFINITY, INFINITY };
+    Float3 boundsMax = { -INFINITY, -INFINITY, -INFINITY };
+    std::vector<Float3> positions(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(pPositions) + v * positionStride);
+        positions[v] = { p[0], p[1], p[2] };
+    }
+    for (uint32_t index : indices)
+    {
+        assert(index < vertexCount && "Index out of range.");
+        const Float3& p = positions[index];
+        boundsMin = { std::min(boundsMin.x, p.x), std::min(boundsMin.y, p.y), std::min(boundsMin.z, p.z) };
+        boundsMax = { std::max(boundsMax.x, p.x), std::max(boundsMax.y, p.y), std::max(boundsMax.z, p.z) };
+    }
+    float scale = std::max(std::max(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y), boundsMax.z - boundsMin.z);
+    scale = scale > 0.0f ? scale : 1.0f;
+    for (Float3& p : positions)
+    {
+        p = { (p.x - boundsMin.x) / scale, (p.y - boundsMin.y) / scale, (p.z - boundsMin.z) / scale };
+    }
+
+    auto getAttribute = [&](uint32_t vertex, uint32_t attribute)
+    {
+        return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(settings.pAttributes) + vertex * settings.AttributeStride)[attribute];
+    };
+
+    // Vertices that share their position with another vertex are attribute seams,
+    // moving only one of them would tear the mesh apart.
+    std::vector<VertexKind> kinds(vertexCount, VertexKind::Interior);
+    {
+        std::vector<uint32_t> sorted(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            sorted[v] = static_cast<uint32_t>(v);
+        }
+        auto less = [&](uint32_t a, uint32_t b)
+        {
+            const Float3& pa = positions[a];
+            const Float3& pb = positions[b];
+            return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+        };
+        std::sort(sorted.begin(), sorted.end(), less);
+        for (size_t i = 1; i < vertexCount; ++i)
+        {
+            if (!less(sorted[i - 1], sorted[i]))
+            {
+                kinds[sorted[i - 1]] = VertexKind::Locked;
+                kinds[sorted[i]] = VertexKind::Locked;
+            }
+        }
+    }
+
+    // Number of triangles per undirected edge, 1 for open borders.
+    std::unordered_map<uint64_t, uint32_t> edgeCounts;
+    auto countEdges = [&]()
+    {
+        edgeCounts.clear();
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                edgeCounts[EdgeKey(indices[t + k], indices[t + (k + 1) % 3])]++;
+            }
+        }
+    };
+    countEdges();
+
+    // 计算每个顶点的二次误差
+    std::vector<Quadric> quadrics(vertexCount, Quadric());
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+        const uint32_t v[3] = { indices[t], indices[t + 1], indices[t + 2] };
+        Float3 normal = Cross(Subtract(positions[v[1]], positions[v[0]]), Subtract(positions[v[2]], positions[v[0]]));
+        float length = std::sqrt(Dot(normal, normal));
+        if (length == 0.0f)
+        {
+            continue;
+        }
+        normal = { normal.x / length, normal.y / length, normal.z / length };
+
+        for (int k = 0; k < 3; ++k)
+        {
+            // Area weighted.
+            quadrics[v[k]].AddPlane(normal, positions[v[0]], length * 0.5);
+        }
+
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t a = v[k];
+            uint32_t b = v[(k + 1) % 3];
+            if (edgeCounts[EdgeKey(a, b)] != 1)
+            {
+                continue;
+            }
+
+            if (kinds[a] != VertexKind::Locked)
+            {
+                kinds[a] = settings.LockBorder ? VertexKind::Locked : VertexKind::Border;
+            }
+            if (kinds[b] != VertexKind::Locked)
+            {
+                kinds[b] = settings.LockBorder ? VertexKind::Locked : VertexKind::Border;
+            }
+
+            // A plane through the border edge, perpendicular to the triangle.
+            Float3 edge = Subtract(positions[b], positions[a]);
+            Float3 borderNormal = Cross(edge, normal);
+            float borderLength = std::sqrt(Dot(borderNormal, borderNormal));
+            if (borderLength > 0.0f)
+            {
+                borderNormal = { borderNormal.x / borderLength, borderNormal.y / borderLength, borderNormal.z / borderLength };
+                double weight = BorderWeight * Dot(edge, edge);
+                quadrics[a].AddPlane(borderNormal, positions[a], weight);
+                quadrics[b].AddPlane(borderNormal, positions[a], weight);
+            }
+        }
+    }
+
+    auto evaluateCollapse = [&](uint32_t source, uint32_t target)
+    {
+        Quadric q = quadrics[source];
+        q.Add(quadrics[target]);
+        double error = q.w > 0.0 ? q.Evaluate(positions[target]) / q.w : 0.0;
+
+        double cost = error;
+        for (uint32_t a = 0; a < settings.AttributeCount; ++a)
+        {
+            double d = getAttribute(source, a) - getAttribute(target, a);
+            cost += settings.AttributeWeights[a] * d * d;
+        }
+
+        return Collapse{ source, target, static_cast<float>(cost), static_cast<float>(error) };
+    };
+
+    const float maxError = (targetError / scale) * (targetError / scale);
+    float resultError = 0.0f;
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> remap(vertexCount);
+
+    // Each pass collapses a set of independent edges, cheapest first.
+    while (indices.size() > targetIndexCount)
+    {
+        // Triangles around each vertex.
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t index : indices)
+        {
+            adjacencyOffsets[index + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+        adjacency.resize(indices.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); ++i)
+            {
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        collapses.clear();
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t a = indices[t + k];
+                uint32_t b = indices[t + (k + 1) % 3];
+                bool borderEdge = edgeCounts[EdgeKey(a, b)] == 1;
+
+                for (int direction = 0; direction < 2; ++direction)
+                {
+                    uint32_t source = direction ? b : a;
+                    uint32_t target = direction ? a : b;
+                    if (kinds[source] == VertexKind::Locked || (kinds[source] == VertexKind::Border && !borderEdge))
+                    {
+                        continue;
+                    }
+                    collapses.push_back(evaluateCollapse(source, target));
+                }
+            }
+        }
+
+        // Ties are broken by the vertex indices so the result is deterministic.
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+        {
+            return a.Cost != b.Cost ? a.Cost < b.Cost : a.Source != b.Source ? a.Source < b.Source : a.Target < b.Target;
+        });
+
+        std::fill(touched.begin(), touched.end(), 0);
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            remap[v] = static_cast<uint32_t>(v);
+        }
+
+        const size_t trianglesToRemove = (indices.size() - targetIndexCount + 2) / 3;
+        size_t trianglesRemoved = 0;
+        size_t numCollapses = 0;
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (trianglesRemoved >= trianglesToRemove)
+            {
+                break;
+            }
+            if (collapse.Error > maxError || touched[collapse.Source] || touched[collapse.Target])
+            {
+                continue;
+            }
+
+            // Reject collapses that flip a triangle around the source.
+            bool flipped = false;
+            size_t removed = 0;
+            for (uint32_t a = adjacencyOffsets[collapse.Source]; a < adjacencyOffsets[collapse.Source + 1] && !flipped; ++a)
+            {
+                const uint32_t* v = &indices[size_t(adjacency[a]) * 3];
+                if (v[0] == collapse.Target || v[1] == collapse.Target || v[2] == collapse.Target)
+                {
+                    removed++;
+                    continue;
+                }
+
+                Float3 p[3], q[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    p[k] = positions[v[k]];
+                    q[k] = positions[v[k] == collapse.Source ? collapse.Target : v[k]];
+                }
+                Float3 before = Cross(Subtract(p[1], p[0]), Subtract(p[2], p[0]));
+                Float3 after = Cross(Subtract(q[1], q[0]), Subtract(q[2], q[0]));
+                flipped = Dot(before, after) <= 0.0f;
+            }
+            if (flipped)
+            {
+                continue;
+            }
+
+            remap[collapse.Source] = collapse.Target;
+            quadrics[collapse.Target].Add(quadrics[collapse.Source]);
+            resultError = std::max(resultError, collapse.Error);
+            trianglesRemoved += removed;
+            numCollapses++;
+
+            // The neighborhood changed, its remaining collapses are evaluated in the next pass.
+            for (uint32_t a = adjacencyOffsets[collapse.Source]; a < adjacencyOffsets[collapse.Source + 1]; ++a)
+            {
+                const uint32_t* v = &indices[size_t(adjacency[a]) * 3];
+                touched[v[0]] = touched[v[1]] = touched[v[2]] = 1;
+            }
+            touched[collapse.Target] = 1;
+        }
+
+        if (numCollapses == 0)
+        {
+            break;
+        }
+
+        // Apply the collapses and drop the triangles that became degenerate.
+        size_t writeIndex = 0;
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            uint32_t a = remap[indices[t]];
+            uint32_t b = remap[indices[t + 1]];
+            uint32_t c = remap[indices[t + 2]];
+            if (a != b && b != c && a != c)
+            {
+                indices[writeIndex++] = a;
+                indices[writeIndex++] = b;
+                indices[writeIndex++] = c;
+            }
+        }
+        indices.resize(writeIndex);
+        countEdges();
+    }
+
+    if (pResultError)
+    {
+        *pResultError = std::sqrt(resultError) * scale;
+    }
+
+    if (!indices.empty())
+    {
+        memcpy(pDestination, indices.data(), indices.size() * sizeof(uint32_t));
+    }
+    return indices.size();
+}
+
+bool GenerateLODs(MeshData& mesh, const LODGenerationSettings& settings)
+{
+    const MeshVertexAttribute* pPosition = mesh.FindAttribute(MeshAttributeSemantic::Position);
+    if (!pPosition || pPosition->Format != MeshFormatR32G32B32Float)
+    {
+        return false;
+    }
+    const MeshVertexAttribute* pColor = mesh.FindAttribute(MeshAttributeSemantic::Color);
+
+    const size_t vertexCount = mesh.GetVertexCount();
+    const float* pPositions = reinterpret_cast<const float*>(mesh.Vertices.data() + pPosition->Offset);
+
+    SimplifySettings simplifySettings;
+    simplifySettings.LockBorder = settings.LockBorder;
+    if (pColor && pColor->Format == MeshFormatR32G32B32Float)
+    {
+        simplifySettings.pAttributes = reinterpret_cast<const float*>(mesh.Vertices.data() + pColor->Offset);
+        simplifySettings.AttributeStride = mesh.VertexStride;
+        simplifySettings.AttributeCount = 3;
+        std::fill(simplifySettings.AttributeWeights, simplifySettings.AttributeWeights + 3, settings.ColorWeight);
+    }
+
+    // The LOD table belongs to the submeshes.
+    if (mesh.Submeshes.empty() && !mesh.Indices.empty())
+    {
+        MeshFileSubmesh submesh = {};
+        submesh.IndexCount = static_cast<uint32_t>(mesh.Indices.size());
+        submesh.VertexCount = static_cast<uint32_t>(vertexCount);
+        mesh.Submeshes.push_back(submesh);
+    }
+
+    mesh.LODs.clear();
+    for (MeshFileSubmesh& submesh : mesh.Submeshes)
+    {
+        submesh.LODOffset = static_cast<uint32_t>(mesh.LODs.size());
+        mesh.LODs.push_back({ submesh.IndexStart, submesh.IndexCount, 0.0f });
+
+        std::vector<uint32_t> current(mesh.Indices.begin() + submesh.IndexStart, mesh.Indices.begin() + submesh.IndexStart + submesh.IndexCount);
+        for (uint32_t& index : current)
+        {
+            index += submesh.BaseVertex;
+        }
+
+        // The error limit is relative to the size of the submesh.
+        float boundsMin[3] = { INFINITY, INFINITY, INFINITY };
+        float boundsMax[3] = { -INFINITY, -INFINITY, -INFINITY };
+        for (uint32_t index : current)
+        {
+            const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(pPositions) + size_t(index) * mesh.VertexStride);
+            for (int c = 0; c < 3; ++c)
+            {
+                boundsMin[c] = std::min(boundsMin[c], p[c]);
+                boundsMax[c] = std::max(boundsMax[c], p[c]);
+            }
+        }
+        float radius = current.empty() ? 0.0f : 0.5f * std::sqrt(
+            (boundsMax[0] - boundsMin[0]) * (boundsMax[0] - boundsMin[0]) +
+            (boundsMax[1] - boundsMin[1]) * (boundsMax[1] - boundsMin[1]) +
+            (boundsMax[2] - boundsMin[2]) * (boundsMax[2] - boundsMin[2]));
+        const float maxError = settings.MaxRelativeError * radius;
+
+        float error = 0.0f;
+        for (uint32_t lod = 1; lod < settings.MaxLODs && error < maxError; ++lod)
+        {
+            size_t targetIndexCount = static_cast<size_t>(current.size() * settings.ReductionRatio) / 3 * 3;
+
+            std::vector<uint32_t> simplified(current.size());
+            float lodError = 0.0f;
+            size_t indexCount = SimplifyMesh(simplified.data(), current.data(), current.size(),
+                pPositions, mesh.VertexStride, vertexCount, targetIndexCount, maxError - error, simplifySettings, &lodError);
+
+            if (indexCount == 0 || indexCount > current.size() * (1.0f - MinLODReduction))
+            {
+                break;
+            }
+            simplified.resize(indexCount);
+            OptimizeVertexCache(simplified.data(), simplified.data(), simplified.size(), vertexCount);
+
+            // Each level is simplified from the previous one, so the errors add up.
+            error += lodError;
+            mesh.LODs.push_back({ static_cast<uint32_t>(mesh.Indices.size()), static_cast<uint32_t>(indexCount), error });
+            for (uint32_t index : simplified)
+            {
+                mesh.Indices.push_back(index - submesh.BaseVertex);
+            }
+
+            current = std::move(simplified);
+        }
+
+        submesh.LODCount = static_cast<uint32_t>(mesh.LODs.size()) - submesh.LODOffset;
+    }
+
+    return true;
+}
+
+bool GenerateLODs(MeshData* const* ppMeshes, size_t meshCount, const LODGenerationSettings& settings, ThreadPool* pThreadPool)
+{
+    // Not std::vector<bool>, the tasks write their results concurrently.
+    std::vector<uint8_t> succeeded(meshCount, 0);
+
+    ParallelFor(pThreadPool, static_cast<uint32_t>(meshCount), [&](uint32_t i)
+    {
+        succeeded[i] = GenerateLODs(*ppMeshes[i], settings) ? 1 : 0;
+    });
+
+    return std::all_of(succeeded.begin(), succeeded.end(), [](uint8_t result) { return result != 0; });
+}
@@ -0,0 +1,279 @@
+#include <MeshletBuilder.h>
+
+#include <ThreadPool.h>
+#include <VertexQuantization.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const uint32_t InvalidLocalIndex = 0xFFFFFFFF;
+
+    // Normal cones wider than this (the cosine of the half angle) are not worth testing.
+    const float MinConeCosine = 0.1f;
+
+    struct Float3
+    {
+        float x, y, z;
+    };
+
+    Float3 Subtract(const Float3& a, const Float3& b)
+    {
+        return { a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+
+    float Dot(const Float3& a, const Float3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    Float3 Cross(const Float3& a, const Float3& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    Float3 GetPosition(const float* pPositions, size_t positionStride, uint32_t vertex)
+    {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(pPositions) + vertex * positionStride);
+        return { p[0], p[1], p[2] };
+    }
+
+    MeshletBounds ComputeMeshletBounds(const Meshlet& meshlet, const MeshletMesh& mesh, const float* pPositions, size_t positionStride)
+    {
+        MeshletBounds bounds = {};
+
+        // 包围球: center of the bounding box, radius to the farthest vertex.
+        Float3 boundsMin = { INFINITY, INFINITY, INFINITY };
+        Float3 boundsMax = { -INFINITY, -INFINITY, -INFINITY };
+        for (uint32_t i = 0; i < meshlet.VertexCount; ++i)
+        {
+            Float3 p = GetPosition(pPositions, positionStride, mesh.UniqueVertexIndices[meshlet.VertexOffset + i]);
+            boundsMin = { std::min(boundsMin.x, p.x), std::min(boundsMin.y, p.y), std::min(boundsMin.z, p.z) };
+            boundsMax = { std::max(boundsMax.x, p.x), std::max(boundsMax.y, p.y), std::max(boundsMax.z, p.z) };
+        }
+
+        Float3 center = { (boundsMin.x + boundsMax.x) * 0.5f, (boundsMin.y + boundsMax.y) * 0.5f, (boundsMin.z + boundsMax.z) * 0.5f };
+        float radiusSq = 0.0f;
+        for (uint32_t i = 0; i < meshlet.VertexCount; ++i)
+        {
+            Float3 d = Subtract(GetPosition(pPositions, positionStride, mesh.UniqueVertexIndices[meshlet.VertexOffset + i]), center);
+            radiusSq = std::max(radiusSq, Dot(d, d));
+        }
+        bounds.Center[0] = center.x;
+        bounds.Center[1] = center.y;
+        bounds.Center[2] = center.z;
+        bounds.Radius = std::sqrt(radiusSq);
+
+        // 法线锥: average of the unit triangle normals, opened wide enough to contain all of them.
+        std::vector<Float3> normals;
+        std::vector<Float3> corners;
+        normals.reserve(meshlet.PrimitiveCount);
+        corners.reserve(meshlet.PrimitiveCount);
+        Float3 axis = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t p = 0; p < meshlet.PrimitiveCount; ++p)
+        {
+            uint32_t i0, i1, i2;
+            UnpackMeshletTriangle(mesh.PrimitiveIndices[meshlet.PrimitiveOffset + p], i0, i1, i2);
+            Float3 p0 = GetPosition(pPositions, positionStride, mesh.UniqueVertexIndices[meshlet.VertexOffset + i0]);
+            Float3 p1 = GetPosition(pPositions, positionStride, mesh.UniqueVertexIndices[meshlet.VertexOffset + i1]);
+            Float3 p2 = GetPosition(pPositions, positionStride, mesh.UniqueVertexIndices[meshlet.VertexOffset + i2]);
+
+            Float3 n = Cross(Subtract(p1, p0), Subtract(p2, p0));
+            float length = std::sqrt(Dot(n, n));
+            if (length == 0.0f)
+            {
+                // Degenerate triangles are never rasterized and do not constrain the cone.
+                continue;
+            }
+            n = { n.x / length, n.y / length, n.z / length };
+
+            normals.push_back(n);
+            corners.push_back(p0);
+            axis = { axis.x + n.x, axis.y + n.y, axis.z + n.z };
+        }
+
+        float axisLength = std::sqrt(Dot(axis, axis));
+        float minDot = 1.0f;
+        if (axisLength > 0.0f)
+        {
+            axis = { axis.x / axisLength, axis.y / axisLength, axis.z / axisLength };
+            for (const Float3& n : normals)
+            {
+                minDot = std::min(minDot, Dot(axis, n));
+            }
+        }
+
+        bounds.ConeAxis[0] = axis.x;
+        bounds.ConeAxis[1] = axis.y;
+        bounds.ConeAxis[2] = axis.z;
+        if (axisLength == 0.0f || minDot < MinConeCosine)
+        {
+            bounds.ConeApex[0] = center.x;
+            bounds.ConeApex[1] = center.y;
+            bounds.ConeApex[2] = center.z;
+            bounds.ConeCutoff = 2.0f;
+            return bounds;
+        }
+
+        // Move the apex back along the axis until it lies behind every triangle plane,
+        // which makes the test valid for perspective projections.
+        float maxT = 0.0f;
+        for (size_t i = 0; i < normals.size(); ++i)
+        {
+            float t = Dot(Subtract(center, corners[i]), normals[i]) / Dot(axis, normals[i]);
+            maxT = std::max(maxT, t);
+        }
+        bounds.ConeApex[0] = center.x - axis.x * maxT;
+        bounds.ConeApex[1] = center.y - axis.y * maxT;
+        bounds.ConeApex[2] = center.z - axis.z * maxT;
+        // The cone of normals has half angle acos(minDot), the cone of view directions
+        // that see all triangles from behind has the complementary half angle.
+        bounds.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+
+        return bounds;
+    }
+}
+
+void BuildMeshlets(const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t positionStride,
+    size_t vertexCount, const MeshletBuildSettings& settings, MeshletMesh& out)
+{
+    assert(indexCount % 3 == 0);
+    assert(settings.MaxVertices >= 3 && settings.MaxVertices <= MaxMeshletVertices);
+    assert(settings.MaxPrimitives >= 1 && settings.MaxPrimitives <= MaxMeshletPrimitives);
+
+    // Local index of each vertex in the current meshlet.
+    std::vector<uint32_t> localIndices(vertexCount, InvalidLocalIndex);
+
+    Meshlet meshlet = {};
+    meshlet.VertexOffset = static_cast<uint32_t>(out.UniqueVertexIndices.size());
+    meshlet.PrimitiveOffset = static_cast<uint32_t>(out.PrimitiveIndices.size());
+
+    auto finishMeshlet = [&]()
+    {
+        if (meshlet.PrimitiveCount == 0)
+        {
+            return;
+        }
+
+        out.Meshlets.push_back(meshlet);
+        out.Bounds.push_back(ComputeMeshletBounds(meshlet, out, pPositions, positionStride));
+
+        for (uint32_t i = 0; i < meshlet.VertexCount; ++i)
+        {
+            localIndices[out.UniqueVertexIndices[meshlet.VertexOffset + i]] = InvalidLocalIndex;
+        }
+
+        meshlet = {};
+        meshlet.VertexOffset = static_cast<uint32_t>(out.UniqueVertexIndices.size());
+        meshlet.PrimitiveOffset = static_cast<uint32_t>(out.PrimitiveIndices.size());
+    };
+
+    for (size_t t = 0; t < indexCount; t += 3)
+    {
+        const uint32_t v[3] = { pIndices[t], pIndices[t + 1], pIndices[t + 2] };
+        assert(v[0] < vertexCount && v[1] < vertexCount && v[2] < vertexCount && "Index out of range.");
+
+        uint32_t newVertices = (localIndices[v[0]] == InvalidLocalIndex ? 1 : 0) +
+            (localIndices[v[1]] == InvalidLocalIndex && v[1] != v[0] ? 1 : 0) +
+            (localIndices[v[2]] == InvalidLocalIndex && v[2] != v[0] && v[2] != v[1] ? 1 : 0);
+
+        if (meshlet.VertexCount + newVertices > settings.MaxVertices || meshlet.PrimitiveCount + 1 > settings.MaxPrimitives)
+        {
+            finishMeshlet();
+        }
+
+        uint32_t local[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            if (localIndices[v[k]] == InvalidLocalIndex)
+            {
+                localIndices[v[k]] = meshlet.VertexCount++;
+                out.UniqueVertexIndices.push_back(v[k]);
+            }
+            local[k] = localIndices[v[k]];
+        }
+
+        out.PrimitiveIndices.push_back(PackMeshletTriangle(local[0], local[1], local[2]));
+        meshlet.PrimitiveCount++;
+    }
+
+    finishMeshlet();
+}
+
+bool BuildMeshlets(const MeshData& mesh, const MeshletBuildSettings& settings, MeshletMesh& out)
+{
+    out = MeshletMesh();
+
+    const MeshVertexAttribute* pPosition = mesh.FindAttribute(MeshAttributeSemantic::Position);
+    if (!pPosition || (pPosition->Format != MeshFormatR32G32B32Float && pPosition->Format != MeshFormatR16G16B16A16SNorm))
+    {
+        return false;
+    }
+
+    const size_t vertexCount = mesh.GetVertexCount();
+    const float* pPositions = reinterpret_cast<const float*>(mesh.Vertices.data() + pPosition->Offset);
+    size_t positionStride = mesh.VertexStride;
+
+    // Quantized positions are decoded once, the bounds are in object space.
+    std::vector<float> decodedPositions;
+    if (pPosition->Format == MeshFormatR16G16B16A16SNorm)
+    {
+        QuantizationBounds quantization;
+        std::copy(mesh.PositionScale, mesh.PositionScale + 3, quantization.Scale);
+        std::copy(mesh.PositionBias, mesh.PositionBias + 3, quantization.Bias);
+
+        decodedPositions.resize(vertexCount * 3);
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            VertexPosColorPacked vertex = {};
+            memcpy(vertex.Position, mesh.Vertices.data() + v * mesh.VertexStride + pPosition->Offset, sizeof(vertex.Position));
+            DecodePosition(vertex, quantization, &decodedPositions[v * 3]);
+        }
+        pPositions = decodedPositions.data();
+        positionStride = sizeof(float) * 3;
+    }
+
+    auto buildRange = [&](uint32_t indexStart, uint32_t indexCount, uint32_t baseVertex)
+    {
+        MeshletMesh::Subset subset;
+        subset.MeshletOffset = static_cast<uint32_t>(out.Meshlets.size());
+
+        std::vector<uint32_t> indices(mesh.Indices.begin() + indexStart, mesh.Indices.begin() + indexStart + indexCount);
+        for (uint32_t& index : indices)
+        {
+            index += baseVertex;
+        }
+        BuildMeshlets(indices.data(), indices.size(), pPositions, positionStride, vertexCount, settings, out);
+
+        subset.MeshletCount = static_cast<uint32_t>(out.Meshlets.size()) - subset.MeshletOffset;
+        out.Subsets.push_back(subset);
+    };
+
+    if (mesh.Submeshes.empty())
+    {
+        buildRange(0, static_cast<uint32_t>(mesh.Indices.size()), 0);
+    }
+    for (const MeshFileSubmesh& submesh : mesh.Submeshes)
+    {
+        buildRange(submesh.IndexStart, submesh.IndexCount, submesh.BaseVertex);
+    }
+
+    return true;
+}
+
+bool BuildMeshlets(const MeshData* const* ppMeshes, size_t meshCount, const MeshletBuildSettings& settings,
+    MeshletMesh* pOut, ThreadPool* pThreadPool)
+{
+    // Not std::vector<bool>, the tasks write their results concurrently.
+    std::vector<uint8_t> succeeded(meshCount, 0);
+
+    ParallelFor(pThreadPool, static_cast<uint32_t>(meshCount), [&](uint32_t i)
+    {
+        succeeded[i] = BuildMeshlets(*ppMeshes[i], settings, pOut[i]) ? 1 : 0;
+    });
+
+    return std::all_of(succeeded.begin(), succeeded.end(), [](uint8_t result) { return result != 0; });
+}
@@ -0,0 +1,324 @@
+#include <MipGenerator.h>
+
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <emmintrin.h> // SSE2
+
+namespace
+{
+    const float Pi = 3.14159265358979f;
+
+    const float KaiserWidth = 3.0f;
+    const float KaiserAlpha = 4.0f;
+    const float LanczosWidth = 3.0f;
+
+    float Sinc(float x)
+    {
+        if (std::abs(x) < 1e-6f)
+        {
+            return 1.0f;
+        }
+        return std::sin(Pi * x) / (Pi * x);
+    }
+
+    // Modified Bessel function of the first kind, order 0.
+    float BesselI0(float x)
+    {
+        float sum = 1.0f;
+        float term = 1.0f;
+        for (int k = 1; k < 32; ++k)
+        {
+            float t = x / (2.0f * k);
+            term *= t * t;
+            sum += term;
+            if (term < sum * 1e-8f)
+            {
+                break;
+            }
+        }
+        return sum;
+    }
+
+    float GetFilterWidth(MipFilter filter)
+    {
+        switch (filter)
+        {
+        case MipFilter::Box:
+            return 0.5f;
+        case MipFilter::Kaiser:
+            return KaiserWidth;
+        case MipFilter::Lanczos:
+            return LanczosWidth;
+        default:
+            assert(false && "Invalid mip filter.");
+            return 0.0f;
+        }
+    }
+
+    float EvaluateFilter(MipFilter filter, float x)
+    {
+        x = std::abs(x);
+        switch (filter)
+        {
+        case MipFilter::Box:
+            return x < 0.5f ? 1.0f : x == 0.5f ? 0.5f : 0.0f;
+        case MipFilter::Kaiser:
+        {
+            if (x >= KaiserWidth)
+            {
+                return 0.0f;
+            }
+            float t = x / KaiserWidth;
+            return Sinc(x) * BesselI0(KaiserAlpha * std::sqrt(1.0f - t * t)) / BesselI0(KaiserAlpha);
+        }
+        case MipFilter::Lanczos:
+            return x < LanczosWidth ? Sinc(x) * Sinc(x / LanczosWidth) : 0.0f;
+        default:
+            return 0.0f;
+        }
+    }
+
+    /**
+     * Taps of a 1D resampling from srcSize to dstSize texels: output i reads
+     * Taps[Offsets[i] .. Offsets[i + 1]).
+     */
+    struct Resampler
+    {
+        struct Tap
+        {
+            uint32_t Source;
+            float Weight;
+        };
+
+        std::vector<uint32_t> Offsets;
+        std::vector<Tap> Taps;
+
+        Resampler(uint32_t srcSize, uint32_t dstSize, MipFilter filter, bool wrap)
+        {
+            const float scale = float(srcSize) / float(dstSize);
+            const float support = GetFilterWidth(filter) * scale;
+
+            Offsets.push_back(0);
+            for (uint32_t i = 0; i < dstSize; ++i)
+            {
+                // Texel centers are at half integers.
+                float center = (i + 0.5f) * scale;
+                int32_t first = static_cast<int32_t>(std::floor(center - support));
+                int32_t last = static_cast<int32_t>(std::ceil(center + support));
+
+                size_t begin = Taps.size();
+                float sum = 0.0f;
+                for (int32_t j = first; j <= last; ++j)
+                {
+                    float weight = EvaluateFilter(filter, (j + 0.5f - center) / scale);
+                    if (weight == 0.0f)
+                    {
+                        continue;
+                    }
+
+                    int32_t source = wrap ?
+                        ((j % int32_t(srcSize)) + int32_t(srcSize)) % int32_t(srcSize) :
+                        std::min(std::max(j, 0), int32_t(srcSize) - 1);
+                    Taps.push_back({ static_cast<uint32_t>(source), weight });
+                    sum += weight;
+                }
+
+                if (sum != 0.0f)
+                {
+                    for (size_t t = begin; t < Taps.size(); ++t)
+                    {
+                        Taps[t].Weight /= sum;
+                    }
+                }
+                else
+                {
+                    // Only possible for degenerate filters, fall back to the nearest texel.
+                    Taps.resize(begin);
+                    Taps.push_back({ std::min(static_cast<uint32_t>(center), srcSize - 1), 1.0f });
+                }
+                Offsets.push_back(static_cast<uint32_t>(Taps.size()));
+            }
+        }
+    };
+
+    // Convert mip 0 of a slice to linear RGBA floats.
+    void DecodeSlice(const TextureData& texture, uint32_t slice, float* pDest)
+    {
+        const TextureSubresource& subresource = texture.GetSubresource(0, slice);
+        const uint8_t* pSrc = texture.GetPixels(0, slice);
+        const size_t numTexels = size_t(subresource.Width) * subresource.Height;
+
+        switch (texture.Format)
+        {
+        case TextureFormat::RGBA32Float:
+            memcpy(pDest, pSrc, numTexels * 16);
+            break;
+        case TextureFormat::RGBA16Float:
+        {
+            const uint16_t* pHalf = reinterpret_cast<const uint16_t*>(pSrc);
+            for (size_t i = 0; i < numTexels * 4; ++i)
+            {
+                pDest[i] = HalfToFloat(pHalf[i]);
+            }
+            break;
+        }
+        case TextureFormat::RGBA8UNorm:
+        case TextureFormat::RGBA8UNormSRGB:
+        {
+            float table[256];
+            float srgbTable[256];
+            for (int i = 0; i < 256; ++i)
+            {
+                table[i] = i / 255.0f;
+                srgbTable[i] = SRGBToLinear(i / 255.0f);
+            }
+            const float* pColorTable = IsSRGB(texture.Format) ? srgbTable : table;
+
+            for (size_t i = 0; i < numTexels; ++i)
+            {
+                pDest[i * 4 + 0] = pColorTable[pSrc[i * 4 + 0]];
+                pDest[i * 4 + 1] = pColorTable[pSrc[i * 4 + 1]];
+                pDest[i * 4 + 2] = pColorTable[pSrc[i * 4 + 2]];
+                // Alpha is always linear.
+                pDest[i * 4 + 3] = table[pSrc[i * 4 + 3]];
+            }
+            break;
+        }
+        default:
+            assert(false && "Unsupported texture format.");
+        }
+    }
+
+    // Convert a row of linear RGBA floats to the texture format.
+    void EncodeRow(TextureFormat format, const float* pSrc, uint32_t width, uint8_t* pDest)
+    {
+        switch (format)
+        {
+        case TextureFormat::RGBA32Float:
+            memcpy(pDest, pSrc, size_t(width) * 16);
+            break;
+        case TextureFormat::RGBA16Float:
+        {
+            uint16_t* pHalf = reinterpret_cast<uint16_t*>(pDest);
+            for (size_t i = 0; i < size_t(width) * 4; ++i)
+            {
+                pHalf[i] = FloatToHalf(pSrc[i]);
+            }
+            break;
+        }
+        case TextureFormat::RGBA8UNorm:
+        case TextureFormat::RGBA8UNormSRGB:
+        {
+            const bool srgb = IsSRGB(format);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 unormMax = _mm_set1_ps(255.0f);
+
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                __m128 color = _mm_loadu_ps(pSrc + x * 4);
+                if (srgb)
+                {
+                    float c[4];
+                    _mm_storeu_ps(c, _mm_min_ps(_mm_max_ps(color, zero), one));
+                    color = _mm_setr_ps(LinearToSRGB(c[0]), LinearToSRGB(c[1]), LinearToSRGB(c[2]), c[3]);
+                }
+
+                __m128i value = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(color, zero), one), unormMax));
+                value = _mm_packs_epi32(value, value);
+                value = _mm_packus_epi16(value, value);
+                int packed = _mm_cvtsi128_si32(value);
+                memcpy(pDest + x * 4, &packed, sizeof(packed));
+            }
+            break;
+        }
+        default:
+            assert(false && "Unsupported texture format.");
+        }
+    }
+
+    void GenerateMip(TextureData& texture, uint32_t mip, uint32_t slice, const float* pLinear, const MipGenerationSettings& settings)
+    {
+        const uint32_t srcWidth = texture.Width;
+        const uint32_t srcHeight = texture.Height;
+        const TextureSubresource& subresource = texture.GetSubresource(mip, slice);
+        const uint32_t dstWidth = subresource.Width;
+        const uint32_t dstHeight = subresource.Height;
+
+        Resampler horizontal(srcWidth, dstWidth, settings.Filter, settings.Wrap);
+        Resampler vertical(srcHeight, dstHeight, settings.Filter, settings.Wrap);
+
+        // 水平方向: every source row to dstWidth texels.
+        std::vector<float> rows(size_t(dstWidth) * srcHeight * 4);
+        for (uint32_t y = 0; y < srcHeight; ++y)
+        {
+            const float* pSrcRow = pLinear + size_t(y) * srcWidth * 4;
+            float* pDstRow = rows.data() + size_t(y) * dstWidth * 4;
+
+            for (uint32_t x = 0; x < dstWidth; ++x)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (uint32_t t = horizontal.Offsets[x]; t < horizontal.Offsets[x + 1]; ++t)
+                {
+                    const Resampler::Tap& tap = horizontal.Taps[t];
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pSrcRow + size_t(tap.Source) * 4), _mm_set1_ps(tap.Weight)));
+                }
+                _mm_storeu_ps(pDstRow + size_t(x) * 4, sum);
+            }
+        }
+
+        // 垂直方向: weighted sum of whole rows, which keeps the memory access linear.
+        std::vector<float> row(size_t(dstWidth) * 4);
+        uint8_t* pDest = texture.GetPixels(mip, slice);
+        for (uint32_t y = 0; y < dstHeight; ++y)
+        {
+            std::fill(row.begin(), row.end(), 0.0f);
+            for (uint32_t t = vertical.Offsets[y]; t < vertical.Offsets[y + 1]; ++t)
+            {
+                const Resampler::Tap& tap = vertical.Taps[t];
+                const float* pSrcRow = rows.data() + size_t(tap.Source) * dstWidth * 4;
+                const __m128 weight = _mm_set1_ps(tap.Weight);
+
+                for (size_t i = 0; i < size_t(dstWidth) * 4; i += 4)
+                {
+                    __m128 sum = _mm_loadu_ps(&row[i]);
+                    _mm_storeu_ps(&row[i], _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pSrcRow + i), weight)));
+                }
+            }
+
+            EncodeRow(texture.Format, row.data(), dstWidth, pDest + y * subresource.RowPitch);
+        }
+    }
+}
+
+void GenerateMips(TextureData& texture, const MipGenerationSettings& settings, ThreadPool* pThreadPool)
+{
+    if (texture.MipLevels <= 1)
+    {
+        return;
+    }
+
+    // Mip 0 of every slice in linear floats, shared by all mips of the slice.
+    const size_t numTexels = size_t(texture.Width) * texture.Height;
+    std::vector< std::vector<float> > linearSlices(texture.ArraySize);
+    ParallelFor(pThreadPool, texture.ArraySize, [&](uint32_t slice)
+    {
+        linearSlices[slice].resize(numTexels * 4);
+        DecodeSlice(texture, slice, linearSlices[slice].data());
+    });
+
+    // Each mip costs about the same (the filter grows with the reduction), so one task per (mip, slice).
+    const uint32_t mipsPerSlice = texture.MipLevels - 1;
+    ParallelFor(pThreadPool, texture.ArraySize * mipsPerSlice, [&](uint32_t task)
+    {
+        uint32_t slice = task / mipsPerSlice;
+        uint32_t mip = 1 + task % mipsPerSlice;
+        GenerateMip(texture, mip, slice, linearSlices[slice].data(), settings);
+    });
+}
@@ -0,0 +1,268 @@
+#include <PipelineBuilder.h>
+#include <DX12LibPCH.h>
+#include <PipelineStateCache.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+PipelineBuilder::PipelineBuilder(Microsoft::WRL::ComPtr<ID3D12Device2> device, std::shared_ptr<PipelineStateCache> pipelineStateCache,
+    std::shared_ptr<ShaderLibrary> shaderLibrary)
+    : m_d3d12Device(device)
+    , m_PipelineStateCache(pipelineStateCache)
+    , m_ShaderLibrary(shaderLibrary)
+    , m_RootSignatureVersion(D3D_ROOT_SIGNATURE_VERSION_1_1)
+    , m_NumBuiltShaders(0)
+    , m_NumBuiltRootSignatures(0)
+    , m_NumBuiltPipelines(0)
+{
+    D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
+    featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+    if (FAILED(m_d3d12Device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
+    {
+        featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+    }
+    m_RootSignatureVersion = featureData.HighestVersion;
+}
+
+PipelineBuilder::~PipelineBuilder()
+{
+    for (auto& rebuild : m_RebuildTasks)
+    {
+        rebuild.wait();
+    }
+}
+
+uint32_t PipelineBuilder::AddRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc)
+{
+    m_RootSignatures.push_back({ &desc, nullptr });
+    return static_cast<uint32_t>(m_RootSignatures.size() - 1);
+}
+
+uint32_t PipelineBuilder::FindOrAddShader(const std::wstring& fileName)
+{
+    // Same name as the shaders returned by ShaderLibrary::Update.
+    const std::wstring key = ShaderLibrary::GetKey(fileName);
+    for (size_t i = 0; i < m_Shaders.size(); ++i)
+    {
+        if (m_Shaders[i].FileName == key)
+        {
+            return static_cast<uint32_t>(i);
+        }
+    }
+
+    m_Shaders.push_back({ key, nullptr });
+    return static_cast<uint32_t>(m_Shaders.size() - 1);
+}
+
+uint32_t PipelineBuilder::AddGraphicsPipeline(const GraphicsPipelineDesc& desc)
+{
+    assert(desc.RootSignature < m_RootSignatures.size());
+
+    auto pipeline = std::make_unique<PipelineEntry>();
+    pipeline->Desc = desc;
+    pipeline->VertexShader = FindOrAddShader(desc.VertexShader);
+    pipeline->PixelShader = desc.PixelShader.empty() ? InvalidIndex : FindOrAddShader(desc.PixelShader);
+    m_Pipelines.push_back(std::move(pipeline));
+
+    return static_cast<uint32_t>(m_Pipelines.size() - 1);
+}
+
+void PipelineBuilder::Build(ThreadPool* pThreadPool)
+{
+    m_TaskGraph.Clear();
+    const uint32_t shaderPhase = m_TaskGraph.AddPhase("Shader loading");
+    const uint32_t rootSignaturePhase = m_TaskGraph.AddPhase("Root signatures");
+    const uint32_t pipelinePhase = m_TaskGraph.AddPhase("Pipeline states");
+
+    // Task of every entry that is built now, InvalidIndex for the ones that were built before.
+    std::vector<uint32_t> shaderTasks(m_Shaders.size(), InvalidIndex);
+    for (size_t i = m_NumBuiltShaders; i < m_Shaders.size(); ++i)
+    {
+        ShaderEntry& shader = m_Shaders[i];
+        shaderTasks[i] = m_TaskGraph.AddTask(shaderPhase, [this, &shader]()
+        {
+            shader.Shader = m_ShaderLibrary->Load(shader.FileName);
+            if (!shader.Shader)
+            {
+                ThrowIfFailed(HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND));
+            }
+        });
+    }
+
+    std::vector<uint32_t> rootSignatureTasks(m_RootSignatures.size(), InvalidIndex);
+    for (size_t i = m_NumBuiltRootSignatures; i < m_RootSignatures.size(); ++i)
+    {
+        RootSignatureEntry& rootSignature = m_RootSignatures[i];
+        rootSignatureTasks[i] = m_TaskGraph.AddTask(rootSignaturePhase, [this, &rootSignature]()
+        {
+            ComPtr<ID3DBlob> rootSignatureBlob;
+            ComPtr<ID3DBlob> errorBlob;
+            HRESULT hr = D3DX12SerializeVersionedRootSignature(rootSignature.pDesc, m_RootSignatureVersion,
+                &rootSignatureBlob, &errorBlob);
+            if (FAILED(hr) && errorBlob)
+            {
+                OutputDebugStringA(static_cast<const char*>(errorBlob->GetBufferPointer()));
+            }
+            ThrowIfFailed(hr);
+
+            rootSignature.RootSignature = m_PipelineStateCache->CreateRootSignature(rootSignatureBlob->GetBufferPointer(),
+                rootSignatureBlob->GetBufferSize());
+        });
+    }
+
+    // Each pipeline state starts as soon as its own shaders and root signature are ready.
+    for (size_t i = m_NumBuiltPipelines; i < m_Pipelines.size(); ++i)
+    {
+        PipelineEntry& pipeline = *m_Pipelines[i];
+
+        std::vector<uint32_t> dependencies;
+        for (uint32_t task : { shaderTasks[pipeline.VertexShader],
+            pipeline.PixelShader != InvalidIndex ? shaderTasks[pipeline.PixelShader] : InvalidIndex,
+            rootSignatureTasks[pipeline.Desc.RootSignature] })
+        {
+            if (task != InvalidIndex)
+            {
+                dependencies.push_back(task);
+            }
+        }
+
+        m_TaskGraph.AddTask(pipelinePhase, [this, &pipeline]()
+        {
+            pipeline.PipelineState = CreatePipelineState(pipeline, m_RootSignatures[pipeline.Desc.RootSignature].RootSignature.Get(),
+                m_Shaders[pipeline.VertexShader].Shader.get(),
+                pipeline.PixelShader != InvalidIndex ? m_Shaders[pipeline.PixelShader].Shader.get() : nullptr);
+        }, dependencies);
+    }
+
+    m_TaskGraph.Run(pThreadPool);
+
+    m_NumBuiltShaders = m_Shaders.size();
+    m_NumBuiltRootSignatures = m_RootSignatures.size();
+    m_NumBuiltPipelines = m_Pipelines.size();
+}
+
+void PipelineBuilder::Rebuild(const std::vector<ShaderLibrary::ShaderPtr>& changedShaders, ThreadPool* pThreadPool)
+{
+    std::vector<bool> isChanged(m_Shaders.size(), false);
+    for (const ShaderLibrary::ShaderPtr& changedShader : changedShaders)
+    {
+        for (size_t i = 0; i < m_NumBuiltShaders; ++i)
+        {
+            if (m_Shaders[i].FileName == changedShader->FileName)
+            {
+                m_Shaders[i].Shader = changedShader;
+                isChanged[i] = true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < m_NumBuiltPipelines; ++i)
+    {
+        PipelineEntry& pipeline = *m_Pipelines[i];
+        if (!isChanged[pipeline.VertexShader] && (pipeline.PixelShader == InvalidIndex || !isChanged[pipeline.PixelShader]))
+        {
+            continue;
+        }
+
+        // The task keeps the versions it builds with, the shaders may change again in the meantime.
+        const uint32_t index = static_cast<uint32_t>(i);
+        const uint32_t generation = ++pipeline.RebuildGeneration;
+        ComPtr<ID3D12RootSignature> rootSignature = m_RootSignatures[pipeline.Desc.RootSignature].RootSignature;
+        ShaderLibrary::ShaderPtr vertexShader = m_Shaders[pipeline.VertexShader].Shader;
+        ShaderLibrary::ShaderPtr pixelShader = pipeline.PixelShader != InvalidIndex ? m_Shaders[pipeline.PixelShader].Shader : nullptr;
+
+        auto rebuild = [this, &pipeline, index, generation, rootSignature, vertexShader, pixelShader]()
+        {
+            ComPtr<ID3D12PipelineState> pipelineState;
+            try
+            {
+                pipelineState = CreatePipelineState(pipeline, rootSignature.Get(), vertexShader.get(), pixelShader.get());
+            }
+            catch (const std::exception&)
+            {
+                OutputDebugStringW((L"Failed to rebuild the pipeline state with " + pipeline.Desc.VertexShader +
+                    L", keeping the previous one.\n").c_str());
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_RebuildMutex);
+            m_RebuiltPipelines.push_back({ index, generation, pipelineState });
+        };
+
+        if (pThreadPool)
+        {
+            std::lock_guard<std::mutex> lock(m_RebuildMutex);
+            m_RebuildTasks.push_back(pThreadPool->Submit(rebuild));
+        }
+        else
+        {
+            rebuild();
+        }
+    }
+}
+
+std::vector<uint32_t> PipelineBuilder::ApplyRebuiltPipelines()
+{
+    std::vector<RebuiltPipeline> rebuiltPipelines;
+    {
+        std::lock_guard<std::mutex> lock(m_RebuildMutex);
+        rebuiltPipelines.swap(m_RebuiltPipelines);
+
+        m_RebuildTasks.erase(std::remove_if(m_RebuildTasks.begin(), m_RebuildTasks.end(), [](const std::future<void>& rebuild)
+        {
+            return rebuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }), m_RebuildTasks.end());
+    }
+
+    std::vector<uint32_t> changedPipelines;
+    for (RebuiltPipeline& rebuiltPipeline : rebuiltPipelines)
+    {
+        // An older rebuild that finished late is dropped.
+        PipelineEntry& pipeline = *m_Pipelines[rebuiltPipeline.Index];
+        if (rebuiltPipeline.Generation != pipeline.RebuildGeneration)
+        {
+            continue;
+        }
+
+        pipeline.PipelineState = rebuiltPipeline.PipelineState;
+        changedPipelines.push_back(rebuiltPipeline.Index);
+    }
+
+    return changedPipelines;
+}
+
+ComPtr<ID3D12PipelineState> PipelineBuilder::CreatePipelineState(const PipelineEntry& pipeline,
+    ID3D12RootSignature* pRootSignature, const ShaderLibrary::Shader* pVertexShader,
+    const ShaderLibrary::Shader* pPixelShader) const
+{
+    // Everything but the root signature and the shaders is precomputed.
+    GraphicsPipelineStream pipelineStateStream = pipeline.Desc.Stream;
+    pipelineStateStream.RootSignature.Value = pRootSignature;
+    pipelineStateStream.VS.Value = { pVertexShader->Bytecode.data(), pVertexShader->Bytecode.size() };
+    if (pPixelShader)
+    {
+        pipelineStateStream.PS.Value = { pPixelShader->Bytecode.data(), pPixelShader->Bytecode.size() };
+    }
+
+    D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = {
+        sizeof(GraphicsPipelineStream), &pipelineStateStream
+    };
+    return m_PipelineStateCache->CreatePipelineState(pipelineStateStreamDesc);
+}
+
+void PipelineBuilder::PrintTimings() const
+{
+    char buffer[256];
+    sprintf_s(buffer, "Pipeline build: %.2f ms\n", GetTotalSeconds() * 1000.0);
+    OutputDebugStringA(buffer);
+
+    for (const TaskGraph::PhaseTiming& phase : GetPhaseTimings())
+    {
+        sprintf_s(buffer, "  %s: %u tasks, %.2f ms (%.2f ms to %.2f ms), %.2f ms summed\n", phase.Name.c_str(), phase.NumTasks,
+            (phase.EndSeconds - phase.StartSeconds) * 1000.0, phase.StartSeconds * 1000.0, phase.EndSeconds * 1000.0,
+            phase.TaskSeconds * 1000.0);
+        OutputDebugStringA(buffer);
+    }
+}
@@ -0,0 +1,126 @@
+#include <PipelineCacheIndex.h>
+#include <Hash.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+
+namespace
+{
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+PipelineCacheIndex::PipelineCacheIndex(uint64_t deviceKey)
+    : m_DeviceKey(deviceKey)
+    , m_IsDirty(false)
+    , m_pLibraryData(nullptr)
+    , m_LibrarySize(0)
+{
+}
+
+PipelineCacheIndex::~PipelineCacheIndex()
+{
+}
+
+void PipelineCacheIndex::Clear()
+{
+    m_Keys.clear();
+    m_IsDirty = false;
+    m_pLibraryData = nullptr;
+    m_LibrarySize = 0;
+}
+
+bool PipelineCacheIndex::Load(const void* pData, size_t size)
+{
+    Clear();
+
+    if (!pData || size < sizeof(PipelineCacheFileHeader))
+    {
+        return false;
+    }
+
+    // The data may come from a file read into an unaligned buffer.
+    PipelineCacheFileHeader header;
+    std::memcpy(&header, pData, sizeof(header));
+
+    if (header.Magic != PipelineCacheFileMagic || header.Version != PipelineCacheFileVersion ||
+        header.DeviceKey != m_DeviceKey || header.FileSize != size ||
+        header.KeyOffset < sizeof(PipelineCacheFileHeader) || header.KeyOffset > size ||
+        uint64_t(header.NumKeys) * sizeof(uint64_t) > size - header.KeyOffset ||
+        header.LibraryOffset < header.KeyOffset + uint64_t(header.NumKeys) * sizeof(uint64_t) || header.LibraryOffset > size || header.LibrarySize > size - header.LibraryOffset ||
+        header.LibrarySize == 0)
+    {
+        return false;
+    }
+
+    // A corrupted key would make the library look up a pipeline it does not have.
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+    const uint8_t* pLibraryData = pBytes + header.LibraryOffset;
+    uint64_t contentHash = HashBytes(pBytes + header.KeyOffset, size_t(header.NumKeys) * sizeof(uint64_t));
+    if (HashBytes(pLibraryData, static_cast<size_t>(header.LibrarySize), contentHash) != header.ContentHash)
+    {
+        return false;
+    }
+
+    std::vector<uint64_t> keys(header.NumKeys);
+    std::memcpy(keys.data(), pBytes + header.KeyOffset, keys.size() * sizeof(uint64_t));
+    m_Keys.insert(keys.begin(), keys.end());
+
+    m_pLibraryData = pLibraryData;
+    m_LibrarySize = static_cast<size_t>(header.LibrarySize);
+
+    return true;
+}
+
+bool PipelineCacheIndex::Contains(uint64_t key) const
+{
+    return m_Keys.find(key) != m_Keys.end();
+}
+
+void PipelineCacheIndex::Insert(uint64_t key)
+{
+    m_IsDirty |= m_Keys.insert(key).second;
+}
+
+std::vector<uint8_t> PipelineCacheIndex::Serialize(const void* pLibraryData, size_t librarySize)
+{
+    // Sorted, so the same pipelines always give the same file.
+    std::vector<uint64_t> keys(m_Keys.begin(), m_Keys.end());
+    std::sort(keys.begin(), keys.end());
+
+    PipelineCacheFileHeader header = {};
+    header.Magic = PipelineCacheFileMagic;
+    header.Version = PipelineCacheFileVersion;
+    header.NumKeys = static_cast<uint32_t>(keys.size());
+    header.DeviceKey = m_DeviceKey;
+    header.KeyOffset = sizeof(PipelineCacheFileHeader);
+    header.LibraryOffset = AlignUp(header.KeyOffset + keys.size() * sizeof(uint64_t), PipelineCacheFileAlignment);
+    header.LibrarySize = librarySize;
+    header.ContentHash = HashBytes(pLibraryData, librarySize, HashBytes(keys.data(), keys.size() * sizeof(uint64_t)));
+    header.FileSize = header.LibraryOffset + librarySize;
+
+    std::vector<uint8_t> data(static_cast<size_t>(header.FileSize), 0);
+    std::memcpy(data.data(), &header, sizeof(header));
+    if (!keys.empty())
+    {
+        std::memcpy(data.data() + header.KeyOffset, keys.data(), keys.size() * sizeof(uint64_t));
+    }
+    if (librarySize > 0)
+    {
+        std::memcpy(data.data() + header.LibraryOffset, pLibraryData, librarySize);
+    }
+
+    m_IsDirty = false;
+
+    return data;
+}
+
+std::wstring PipelineCacheIndex::GetPipelineName(uint64_t key)
+{
+    wchar_t name[32];
+    std::swprintf(name, sizeof(name) / sizeof(name[0]), L"PSO_%016llx", static_cast<unsigned long long>(key));
+    return name;
+}
@@ -0,0 +1,543 @@
+#include <PipelineStateCache.h>
+#include <DX12LibPCH.h>
+#include <Hash.h>
+#include <PipelineStateHasher.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    // Private data of the root signatures created by the cache: the hash of their blob.
+    const GUID RootSignatureKeyGuid = { 0xd58c14a7, 0xc21e, 0x44d6, { 0xa2, 0x17, 0x7d, 0x33, 0x38, 0x7d, 0xdb, 0x3c } };
+
+    // A pipeline library is only valid for the adapter and driver it was created with.
+    uint64_t GetDeviceKey(IDXGIAdapter4* pAdapter)
+    {
+        uint64_t key = HashValue(static_cast<uint32_t>(D3D12_SDK_VERSION));
+        key = HashValue(static_cast<uint32_t>(sizeof(void*)), key);
+
+        DXGI_ADAPTER_DESC3 desc = {};
+        if (pAdapter && SUCCEEDED(pAdapter->GetDesc3(&desc)))
+        {
+            key = HashValue(desc.VendorId, key);
+            key = HashValue(desc.DeviceId, key);
+            key = HashValue(desc.SubSysId, key);
+            key = HashValue(desc.Revision, key);
+        }
+
+        LARGE_INTEGER driverVersion = {};
+        if (pAdapter && SUCCEEDED(pAdapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion)))
+        {
+            key = HashValue(driverVersion.QuadPart, key);
+        }
+
+        return key;
+    }
+
+    bool ReadFile(const std::wstring& fileName, std::vector<uint8_t>& data)
+    {
+        std::ifstream file(std::filesystem::path(fileName), std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            return false;
+        }
+
+        std::streamoff size = file.tellg();
+        if (size <= 0)
+        {
+            return false;
+        }
+
+        data.resize(static_cast<size_t>(size));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(data.data()), size);
+
+        return static_cast<bool>(file);
+    }
+
+    /**
+     * Feeds the subobjects of a pipeline state stream to a PipelineStateHasher.
+     */
+    class PipelineStreamHasher : public ID3DX12PipelineParserCallbacks
+    {
+    public:
+        PipelineStreamHasher(PipelineStateHasher& hasher)
+            : m_Hasher(hasher)
+            , m_HasError(false)
+        {
+        }
+
+        bool HasError() const
+        {
+            return m_HasError;
+        }
+
+        void FlagsCb(D3D12_PIPELINE_STATE_FLAGS flags) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS);
+            m_Hasher.AddValue(flags);
+        }
+
+        void NodeMaskCb(UINT nodeMask) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK);
+            m_Hasher.AddValue(nodeMask);
+        }
+
+        void RootSignatureCb(ID3D12RootSignature* pRootSignature) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE);
+
+            uint64_t key = 0;
+            UINT size = sizeof(key);
+            if (!pRootSignature || FAILED(pRootSignature->GetPrivateData(RootSignatureKeyGuid, &size, &key)) ||
+                size != sizeof(key))
+            {
+                // Not created by the cache, the pointer is not a stable key.
+                m_HasError = true;
+                return;
+            }
+            m_Hasher.AddValue(key);
+        }
+
+        void InputLayoutCb(const D3D12_INPUT_LAYOUT_DESC& inputLayout) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT);
+            m_Hasher.AddValue(inputLayout.NumElements);
+            for (UINT i = 0; i < inputLayout.NumElements; ++i)
+            {
+                const D3D12_INPUT_ELEMENT_DESC& element = inputLayout.pInputElementDescs[i];
+                m_Hasher.AddString(element.SemanticName);
+                m_Hasher.AddValue(element.SemanticIndex);
+                m_Hasher.AddValue(element.Format);
+                m_Hasher.AddValue(element.InputSlot);
+                m_Hasher.AddValue(element.AlignedByteOffset);
+                m_Hasher.AddValue(element.InputSlotClass);
+                m_Hasher.AddValue(element.InstanceDataStepRate);
+            }
+        }
+
+        void IBStripCutValueCb(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE value) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE);
+            m_Hasher.AddValue(value);
+        }
+
+        void PrimitiveTopologyTypeCb(D3D12_PRIMITIVE_TOPOLOGY_TYPE topologyType) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY);
+            m_Hasher.AddValue(topologyType);
+        }
+
+        void VSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS, shader);
+        }
+
+        void GSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS, shader);
+        }
+
+        void StreamOutputCb(const D3D12_STREAM_OUTPUT_DESC& streamOutput) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT);
+            m_Hasher.AddValue(streamOutput.NumEntries);
+            for (UINT i = 0; i < streamOutput.NumEntries; ++i)
+            {
+                const D3D12_SO_DECLARATION_ENTRY& entry = streamOutput.pSODeclaration[i];
+                m_Hasher.AddValue(entry.Stream);
+                m_Hasher.AddString(entry.SemanticName);
+                m_Hasher.AddValue(entry.SemanticIndex);
+                m_Hasher.AddValue(entry.StartComponent);
+                m_Hasher.AddValue(entry.ComponentCount);
+                m_Hasher.AddValue(entry.OutputSlot);
+            }
+            m_Hasher.AddValue(streamOutput.NumStrides);
+            for (UINT i = 0; i < streamOutput.NumStrides; ++i)
+            {
+                m_Hasher.AddValue(streamOutput.pBufferStrides[i]);
+            }
+            m_Hasher.AddValue(streamOutput.RasterizedStream);
+        }
+
+        void HSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS, shader);
+        }
+
+        void DSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS, shader);
+        }
+
+        void PSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS, shader);
+        }
+
+        void CSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS, shader);
+        }
+
+        void ASCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS, shader);
+        }
+
+        void MSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS, shader);
+        }
+
+        void BlendStateCb(const D3D12_BLEND_DESC& blend) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND);
+            m_Hasher.AddValue(blend.AlphaToCoverageEnable);
+            m_Hasher.AddValue(blend.IndependentBlendEnable);
+            for (const D3D12_RENDER_TARGET_BLEND_DESC& renderTarget : blend.RenderTarget)
+            {
+                m_Hasher.AddValue(renderTarget.BlendEnable);
+                m_Hasher.AddValue(renderTarget.LogicOpEnable);
+                m_Hasher.AddValue(renderTarget.SrcBlend);
+                m_Hasher.AddValue(renderTarget.DestBlend);
+                m_Hasher.AddValue(renderTarget.BlendOp);
+                m_Hasher.AddValue(renderTarget.SrcBlendAlpha);
+                m_Hasher.AddValue(renderTarget.DestBlendAlpha);
+                m_Hasher.AddValue(renderTarget.BlendOpAlpha);
+                m_Hasher.AddValue(renderTarget.LogicOp);
+                m_Hasher.AddValue(renderTarget.RenderTargetWriteMask);
+            }
+        }
+
+        void DepthStencilStateCb(const D3D12_DEPTH_STENCIL_DESC& depthStencil) override
+        {
+            // Same key as the equivalent DEPTH_STENCIL1 subobject.
+            CD3DX12_DEPTH_STENCIL_DESC1 depthStencil1(depthStencil);
+            DepthStencilState1Cb(depthStencil1);
+        }
+
+        void DepthStencilState1Cb(const D3D12_DEPTH_STENCIL_DESC1& depthStencil) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL);
+            m_Hasher.AddValue(depthStencil.DepthEnable);
+            m_Hasher.AddValue(depthStencil.DepthWriteMask);
+            m_Hasher.AddValue(depthStencil.DepthFunc);
+            m_Hasher.AddValue(depthStencil.StencilEnable);
+            m_Hasher.AddValue(depthStencil.StencilReadMask);
+            m_Hasher.AddValue(depthStencil.StencilWriteMask);
+            for (const D3D12_DEPTH_STENCILOP_DESC* pFace : { &depthStencil.FrontFace, &depthStencil.BackFace })
+            {
+                m_Hasher.AddValue(pFace->StencilFailOp);
+                m_Hasher.AddValue(pFace->StencilDepthFailOp);
+                m_Hasher.AddValue(pFace->StencilPassOp);
+                m_Hasher.AddValue(pFace->StencilFunc);
+            }
+            m_Hasher.AddValue(depthStencil.DepthBoundsTestEnable);
+        }
+
+        void DSVFormatCb(DXGI_FORMAT format) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT);
+            m_Hasher.AddValue(format);
+        }
+
+        void RasterizerStateCb(const D3D12_RASTERIZER_DESC& rasterizer) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER);
+            m_Hasher.AddValue(rasterizer.FillMode);
+            m_Hasher.AddValue(rasterizer.CullMode);
+            m_Hasher.AddValue(rasterizer.FrontCounterClockwise);
+            m_Hasher.AddValue(rasterizer.DepthBias);
+            m_Hasher.AddValue(rasterizer.DepthBiasClamp);
+            m_Hasher.AddValue(rasterizer.SlopeScaledDepthBias);
+            m_Hasher.AddValue(rasterizer.DepthClipEnable);
+            m_Hasher.AddValue(rasterizer.MultisampleEnable);
+            m_Hasher.AddValue(rasterizer.AntialiasedLineEnable);
+            m_Hasher.AddValue(rasterizer.ForcedSampleCount);
+            m_Hasher.AddValue(rasterizer.ConservativeRaster);
+        }
+
+        void RTVFormatsCb(const D3D12_RT_FORMAT_ARRAY& formats) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS);
+            m_Hasher.AddValue(formats.NumRenderTargets);
+            for (UINT i = 0; i < formats.NumRenderTargets && i < _countof(formats.RTFormats); ++i)
+            {
+                m_Hasher.AddValue(formats.RTFormats[i]);
+            }
+        }
+
+        void SampleDescCb(const DXGI_SAMPLE_DESC& sampleDesc) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC);
+            m_Hasher.AddValue(sampleDesc.Count);
+            m_Hasher.AddValue(sampleDesc.Quality);
+        }
+
+        void SampleMaskCb(UINT sampleMask) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK);
+            m_Hasher.AddValue(sampleMask);
+        }
+
+        void ViewInstancingCb(const D3D12_VIEW_INSTANCING_DESC& viewInstancing) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING);
+            m_Hasher.AddValue(viewInstancing.ViewInstanceCount);
+            for (UINT i = 0; i < viewInstancing.ViewInstanceCount; ++i)
+            {
+                m_Hasher.AddValue(viewInstancing.pViewInstanceLocations[i].ViewportArrayIndex);
+                m_Hasher.AddValue(viewInstancing.pViewInstanceLocations[i].RenderTargetArrayIndex);
+            }
+            m_Hasher.AddValue(viewInstancing.Flags);
+        }
+
+        void CachedPSOCb(const D3D12_CACHED_PIPELINE_STATE& cachedPSO) override
+        {
+            m_Hasher.BeginSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO);
+            m_Hasher.AddBytes(cachedPSO.pCachedBlob, cachedPSO.CachedBlobSizeInBytes);
+        }
+
+        void ErrorBadInputParameter(UINT) override
+        {
+            m_HasError = true;
+        }
+
+        void ErrorDuplicateSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE) override
+        {
+            m_HasError = true;
+        }
+
+        void ErrorUnknownSubobject(UINT) override
+        {
+            m_HasError = true;
+        }
+
+    private:
+        void Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, const D3D12_SHADER_BYTECODE& shader)
+        {
+            m_Hasher.BeginSubobject(type);
+            m_Hasher.AddShader(shader.pShaderBytecode, shader.BytecodeLength);
+        }
+
+        PipelineStateHasher& m_Hasher;
+        bool m_HasError;
+    };
+}
+
+PipelineStateCache::PipelineStateCache(Microsoft::WRL::ComPtr<ID3D12Device2> device, Microsoft::WRL::ComPtr<IDXGIAdapter4> adapter,
+    const std::wstring& fileName)
+    : m_d3d12Device(device)
+    , m_FileName(fileName)
+    , m_Index(GetDeviceKey(adapter.Get()))
+{
+    D3D12_FEATURE_DATA_SHADER_CACHE shaderCache = {};
+    if (SUCCEEDED(m_d3d12Device->CheckFeatureSupport(D3D12_FEATURE_SHADER_CACHE, &shaderCache, sizeof(shaderCache))) &&
+        (shaderCache.SupportFlags & D3D12_SHADER_CACHE_SUPPORT_LIBRARY))
+    {
+        CreatePipelineLibrary();
+    }
+}
+
+PipelineStateCache::~PipelineStateCache()
+{
+    Save();
+}
+
+void PipelineStateCache::CreatePipelineLibrary()
+{
+    if (ReadFile(m_FileName, m_FileData) && m_Index.Load(m_FileData.data(), m_FileData.size()))
+    {
+        // The runtime checks the blob again: D3D12_ERROR_DRIVER_VERSION_MISMATCH,
+        // D3D12_ERROR_ADAPTER_NOT_FOUND or E_INVALIDARG start with an empty library.
+        HRESULT hr = m_d3d12Device->CreatePipelineLibrary(m_Index.GetLibraryData(), m_Index.GetLibrarySize(),
+            IID_PPV_ARGS(&m_d3d12PipelineLibrary));
+        if (SUCCEEDED(hr))
+        {
+            m_Statistics.LoadedFromFile = true;
+            return;
+        }
+        OutputDebugStringA("PipelineStateCache: the cache file was rejected by the driver, pipelines are compiled again.\n");
+    }
+
+    m_Index.Clear();
+    m_FileData.clear();
+    m_FileData.shrink_to_fit();
+
+    if (FAILED(m_d3d12Device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_d3d12PipelineLibrary))))
+    {
+        m_d3d12PipelineLibrary.Reset();
+    }
+}
+
+Microsoft::WRL::ComPtr<ID3D12RootSignature> PipelineStateCache::CreateRootSignature(const void* pBlob, size_t size)
+{
+    const uint64_t key = HashBytes(pBlob, size);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_RootSignatures.find(key);
+        if (it != m_RootSignatures.end())
+        {
+            return it->second;
+        }
+    }
+
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ThrowIfFailed(m_d3d12Device->CreateRootSignature(0, pBlob, size, IID_PPV_ARGS(&rootSignature)));
+    ThrowIfFailed(rootSignature->SetPrivateData(RootSignatureKeyGuid, sizeof(key), &key));
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    // Another thread may have created the same root signature in the meantime.
+    return m_RootSignatures.emplace(key, rootSignature).first->second;
+}
+
+uint64_t PipelineStateCache::GetPipelineStateKey(const D3D12_PIPELINE_STATE_STREAM_DESC& desc) const
+{
+    PipelineStateHasher hasher;
+    PipelineStreamHasher streamHasher(hasher);
+    if (FAILED(D3DX12ParsePipelineStream(desc, &streamHasher)) || streamHasher.HasError())
+    {
+        return 0;
+    }
+
+    return hasher.GetKey();
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineStateCache::CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+{
+    const uint64_t key = GetPipelineStateKey(desc);
+    if (key == 0)
+    {
+        assert(false && "Pipeline state stream can not be cached, use root signatures of PipelineStateCache::CreateRootSignature.");
+
+        ComPtr<ID3D12PipelineState> pipelineState;
+        ThrowIfFailed(m_d3d12Device->CreatePipelineState(&desc, IID_PPV_ARGS(&pipelineState)));
+        return pipelineState;
+    }
+
+    // The first thread that asks for a key creates the pipeline state, the others wait for it.
+    std::promise< ComPtr<ID3D12PipelineState> > promise;
+    PipelineStateFuture future;
+    bool isCreator = false;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_PipelineStates.find(key);
+        if (it != m_PipelineStates.end())
+        {
+            ++m_Statistics.NumMemoryHits;
+            future = it->second;
+        }
+        else
+        {
+            future = promise.get_future().share();
+            m_PipelineStates.emplace(key, future);
+            isCreator = true;
+        }
+    }
+
+    if (isCreator)
+    {
+        try
+        {
+            promise.set_value(LoadOrCompile(key, desc));
+        }
+        catch (...)
+        {
+            // Let the next request try again, the waiting threads get the exception.
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_PipelineStates.erase(key);
+            }
+            promise.set_exception(std::current_exception());
+        }
+    }
+
+    return future.get();
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineStateCache::LoadOrCompile(uint64_t key, const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+{
+    const std::wstring name = PipelineCacheIndex::GetPipelineName(key);
+
+    bool isInLibrary;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        isInLibrary = m_d3d12PipelineLibrary && m_Index.Contains(key);
+    }
+
+    ComPtr<ID3D12PipelineState> pipelineState;
+    if (isInLibrary)
+    {
+        // Fails with E_INVALIDARG if the stored pipeline does not match the description.
+        if (SUCCEEDED(m_d3d12PipelineLibrary->LoadPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipelineState))))
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ++m_Statistics.NumLibraryHits;
+            return pipelineState;
+        }
+    }
+
+    ThrowIfFailed(m_d3d12Device->CreatePipelineState(&desc, IID_PPV_ARGS(&pipelineState)));
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ++m_Statistics.NumCompiled;
+    // Stored under the lock so Save never serializes the library in the middle of a store.
+    if (m_d3d12PipelineLibrary && !isInLibrary &&
+        SUCCEEDED(m_d3d12PipelineLibrary->StorePipeline(name.c_str(), pipelineState.Get())))
+    {
+        m_Index.Insert(key);
+    }
+
+    return pipelineState;
+}
+
+bool PipelineStateCache::Save()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (!m_d3d12PipelineLibrary || !m_Index.IsDirty())
+    {
+        return true;
+    }
+
+    const size_t librarySize = m_d3d12PipelineLibrary->GetSerializedSize();
+    std::vector<uint8_t> library(librarySize);
+    if (FAILED(m_d3d12PipelineLibrary->Serialize(library.data(), librarySize)))
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> data = m_Index.Serialize(library.data(), librarySize);
+
+    // Write a temporary file and replace the cache file with it.
+    std::filesystem::path path(m_FileName);
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += L".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file)
+        {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+
+    return !error;
+}
+
+PipelineStateCache::Statistics PipelineStateCache::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Statistics statistics = m_Statistics;
+    statistics.NumPipelineStates = static_cast<uint32_t>(m_PipelineStates.size());
+    statistics.NumRootSignatures = static_cast<uint32_t>(m_RootSignatures.size());
+    statistics.NumLibraryPipelineStates = m_Index.GetNumKeys();
+    return statistics;
+}
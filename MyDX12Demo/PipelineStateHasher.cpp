@@ -0,0 +1,124 @@
+#include <PipelineStateHasher.h>
+
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+    // 'DXBC', the container format of both DXBC and DXIL shaders.
+    const uint32_t ShaderContainerMagic = 0x43425844;
+    const size_t ShaderDigestSize = 16;
+
+    const uint32_t NoSubobject = ~0u;
+}
+
+uint64_t HashShaderBytecode(const void* pBytecode, size_t size)
+{
+    uint64_t hash = HashValue(static_cast<uint64_t>(size));
+    if (!pBytecode || size == 0)
+    {
+        return hash;
+    }
+
+    // The container starts with the magic and a digest of the rest of the container.
+    // Unsigned containers (validation skipped) have an all zero digest.
+    if (size >= sizeof(uint32_t) + ShaderDigestSize)
+    {
+        const uint8_t* pBytes = static_cast<const uint8_t*>(pBytecode);
+
+        uint32_t magic;
+        std::memcpy(&magic, pBytes, sizeof(magic));
+
+        const uint8_t* pDigest = pBytes + sizeof(uint32_t);
+        bool isSigned = false;
+        for (size_t i = 0; i < ShaderDigestSize; ++i)
+        {
+            isSigned |= pDigest[i] != 0;
+        }
+
+        if (magic == ShaderContainerMagic && isSigned)
+        {
+            return HashBytes(pDigest, ShaderDigestSize, hash);
+        }
+    }
+
+    return HashBytes(pBytecode, size, hash);
+}
+
+PipelineStateHasher::PipelineStateHasher()
+{
+    Reset();
+}
+
+PipelineStateHasher::~PipelineStateHasher()
+{
+}
+
+void PipelineStateHasher::Reset()
+{
+    std::memset(m_SubobjectHashes, 0, sizeof(m_SubobjectHashes));
+    m_SubobjectMask = 0;
+    m_CurrentType = NoSubobject;
+    m_Hash = HashOffsetBasis;
+}
+
+void PipelineStateHasher::BeginSubobject(uint32_t type)
+{
+    assert(type < MaxSubobjectTypes);
+
+    EndSubobject();
+    m_CurrentType = type;
+    m_Hash = HashValue(type);
+}
+
+void PipelineStateHasher::EndSubobject()
+{
+    if (m_CurrentType != NoSubobject)
+    {
+        m_SubobjectHashes[m_CurrentType] = m_Hash;
+        m_SubobjectMask |= 1u << m_CurrentType;
+        m_CurrentType = NoSubobject;
+    }
+}
+
+void PipelineStateHasher::AddBytes(const void* pData, size_t size)
+{
+    m_Hash = HashValue(static_cast<uint64_t>(size), m_Hash);
+    m_Hash = HashBytes(pData, size, m_Hash);
+}
+
+void PipelineStateHasher::AddString(const char* pString)
+{
+    if (!pString)
+    {
+        m_Hash = HashValue(uint8_t(0), m_Hash);
+        return;
+    }
+
+    m_Hash = HashValue(uint8_t(1), m_Hash);
+    m_Hash = HashBytes(pString, std::strlen(pString) + 1, m_Hash);
+}
+
+void PipelineStateHasher::AddShader(const void* pBytecode, size_t size)
+{
+    m_Hash = HashValue(HashShaderBytecode(pBytecode, size), m_Hash);
+}
+
+uint64_t PipelineStateHasher::GetKey() const
+{
+    uint64_t key = HashValue(m_SubobjectMask | (m_CurrentType != NoSubobject ? 1u << m_CurrentType : 0u));
+    for (uint32_t type = 0; type < MaxSubobjectTypes; ++type)
+    {
+        if (type == m_CurrentType)
+        {
+            key = HashValue(m_Hash, key);
+        }
+        else if (m_SubobjectMask & (1u << type))
+        {
+            key = HashValue(m_SubobjectHashes[type], key);
+        }
+    }
+
+    // 0 marks unused entries in the cache index.
+    return key != 0 ? key : 1;
+}
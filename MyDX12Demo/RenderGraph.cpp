@@ -0,0 +1,229 @@
+#include <RenderGraph.h>
+#include <DX12LibPCH.h>
+#include <Application.h>
+#include <CommandQueue.h>
+
+static_assert(RenderGraphCompiler::CommonState == D3D12_RESOURCE_STATE_COMMON, "The compiler uses the D3D12 states.");
+static_assert(RenderGraphCompiler::UnorderedAccessState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS, "The compiler uses the D3D12 states.");
+static_assert(RenderGraphCompiler::ComputeQueueStates == (D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER |
+    D3D12_RESOURCE_STATE_UNORDERED_ACCESS | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT |
+    D3D12_RESOURCE_STATE_COPY_DEST | D3D12_RESOURCE_STATE_COPY_SOURCE), "The compiler uses the D3D12 states.");
+static_assert(RenderGraphCompiler::CopyQueueStates == (D3D12_RESOURCE_STATE_COPY_DEST | D3D12_RESOURCE_STATE_COPY_SOURCE),
+    "The compiler uses the D3D12 states.");
+
+namespace
+{
+    RenderGraphCompiler::Queue GetQueue(D3D12_COMMAND_LIST_TYPE type)
+    {
+        switch (type)
+        {
+        case D3D12_COMMAND_LIST_TYPE_COMPUTE:
+            return RenderGraphCompiler::Queue::Compute;
+        case D3D12_COMMAND_LIST_TYPE_COPY:
+            return RenderGraphCompiler::Queue::Copy;
+        default:
+            assert(type == D3D12_COMMAND_LIST_TYPE_DIRECT && "Invalid command list type.");
+            return RenderGraphCompiler::Queue::Graphics;
+        }
+    }
+
+    D3D12_COMMAND_LIST_TYPE GetCommandListType(RenderGraphCompiler::Queue queue)
+    {
+        switch (queue)
+        {
+        case RenderGraphCompiler::Queue::Compute:
+            return D3D12_COMMAND_LIST_TYPE_COMPUTE;
+        case RenderGraphCompiler::Queue::Copy:
+            return D3D12_COMMAND_LIST_TYPE_COPY;
+        default:
+            return D3D12_COMMAND_LIST_TYPE_DIRECT;
+        }
+    }
+
+    // Command list of a queue while the graph is executed.
+    struct QueueContext
+    {
+        std::shared_ptr<CommandQueue> Queue;
+        ComPtr<ID3D12GraphicsCommandList2> CommandList;
+        // Positions of the passes in the command list.
+        std::vector<uint32_t> PendingPositions;
+        // Fence value of the last command list executed on the queue, 0 if none.
+        uint64_t FenceValue = 0;
+    };
+}
+
+RenderGraph::RenderGraph()
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+}
+
+void RenderGraph::Reset()
+{
+    m_Compiler.Clear();
+    m_Passes.clear();
+    m_Resources.clear();
+}
+
+uint32_t RenderGraph::ImportResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES initialState, D3D12_RESOURCE_STATES finalState)
+{
+    m_Resources.push_back(pResource);
+    return m_Compiler.ImportResource(initialState, finalState);
+}
+
+uint32_t RenderGraph::AddResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state)
+{
+    m_Resources.push_back(pResource);
+    return m_Compiler.AddResource(state);
+}
+
+uint32_t RenderGraph::AddPass(D3D12_COMMAND_LIST_TYPE type, ExecuteFunc execute, bool hasSideEffects)
+{
+    m_Passes.push_back(std::move(execute));
+    return m_Compiler.AddPass(GetQueue(type), hasSideEffects);
+}
+
+void RenderGraph::Read(uint32_t pass, uint32_t resource, D3D12_RESOURCE_STATES state)
+{
+    m_Compiler.Read(pass, resource, state);
+}
+
+void RenderGraph::Write(uint32_t pass, uint32_t resource, D3D12_RESOURCE_STATES state)
+{
+    m_Compiler.Write(pass, resource, state);
+}
+
+void RenderGraph::Compile()
+{
+    m_Compiler.Compile();
+}
+
+void RenderGraph::ResourceBarriers(ID3D12GraphicsCommandList2* pCommandList, const std::vector<RenderGraphCompiler::Barrier>& barriers)
+{
+    if (barriers.empty())
+    {
+        return;
+    }
+
+    m_Barriers.clear();
+    for (const RenderGraphCompiler::Barrier& barrier : barriers)
+    {
+        ID3D12Resource* pResource = m_Resources[barrier.Resource];
+        if (barrier.Type == RenderGraphCompiler::BarrierType::UnorderedAccess)
+        {
+            m_Barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(pResource));
+            continue;
+        }
+
+        D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        if (barrier.Split == RenderGraphCompiler::BarrierSplit::Begin)
+        {
+            flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+        }
+        else if (barrier.Split == RenderGraphCompiler::BarrierSplit::End)
+        {
+            flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+        }
+        m_Barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(pResource,
+            static_cast<D3D12_RESOURCE_STATES>(barrier.StateBefore), static_cast<D3D12_RESOURCE_STATES>(barrier.StateAfter),
+            D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, flags));
+    }
+
+    pCommandList->ResourceBarrier(static_cast<UINT>(m_Barriers.size()), m_Barriers.data());
+}
+
+ComPtr<ID3D12GraphicsCommandList2> RenderGraph::Execute(ComPtr<ID3D12GraphicsCommandList2> commandList)
+{
+    const std::vector<RenderGraphCompiler::CompiledPass>& compiledPasses = m_Compiler.GetCompiledPasses();
+
+    QueueContext queues[RenderGraphCompiler::NumQueues];
+    for (uint32_t queue = 0; queue < RenderGraphCompiler::NumQueues; ++queue)
+    {
+        queues[queue].Queue = Application::Get().GetCommandQueue(GetCommandListType(static_cast<RenderGraphCompiler::Queue>(queue)));
+    }
+    QueueContext& graphics = queues[static_cast<uint32_t>(RenderGraphCompiler::Queue::Graphics)];
+    graphics.CommandList = commandList;
+
+    // Fence value of every pass once its command list was executed, 0 before.
+    std::vector<uint64_t> fenceValues(compiledPasses.size(), 0);
+    auto executeCommandList = [&fenceValues, &graphics](QueueContext& context)
+    {
+        uint64_t fenceValue = context.Queue->ExecuteCommandList(context.CommandList);
+        context.FenceValue = fenceValue;
+        for (uint32_t position : context.PendingPositions)
+        {
+            fenceValues[position] = fenceValue;
+        }
+        context.PendingPositions.clear();
+        // The caller continues with a new direct command list, the others are opened when they are needed.
+        context.CommandList = &context == &graphics ? context.Queue->GetCommandList() : nullptr;
+    };
+
+    for (uint32_t position = 0; position < compiledPasses.size(); ++position)
+    {
+        const RenderGraphCompiler::CompiledPass& compiledPass = compiledPasses[position];
+        QueueContext& context = queues[static_cast<uint32_t>(compiledPass.PassQueue)];
+
+        for (const RenderGraphCompiler::QueueWait& wait : compiledPass.Waits)
+        {
+            QueueContext& waitContext = queues[static_cast<uint32_t>(wait.WaitQueue)];
+            if (fenceValues[wait.Position] == 0)
+            {
+                executeCommandList(waitContext);
+            }
+            // The earlier passes of an async queue do not have to wait. The direct command
+            // list belongs to the caller, its earlier passes wait as well.
+            if (&context != &graphics && !context.PendingPositions.empty())
+            {
+                executeCommandList(context);
+            }
+            context.Queue->Wait(*waitContext.Queue, fenceValues[wait.Position]);
+        }
+
+        if (!context.CommandList)
+        {
+            context.CommandList = context.Queue->GetCommandList();
+        }
+
+        ResourceBarriers(context.CommandList.Get(), compiledPass.Barriers);
+        m_Passes[compiledPass.Pass](context.CommandList.Get());
+        // Transitions for a later pass on another queue, before the fence that pass waits for.
+        ResourceBarriers(context.CommandList.Get(), compiledPass.BarriersAfter);
+        context.PendingPositions.push_back(position);
+    }
+
+    // The async queues first, the direct queue waits for their final barriers.
+    for (uint32_t queue = RenderGraphCompiler::NumQueues; queue-- > 0; )
+    {
+        QueueContext& context = queues[queue];
+        if (&context == &graphics)
+        {
+            for (const RenderGraphCompiler::QueueWait& wait : m_Compiler.GetFinalWaits())
+            {
+                QueueContext& waitContext = queues[static_cast<uint32_t>(wait.WaitQueue)];
+                const uint64_t fenceValue = wait.Position == RenderGraphCompiler::InvalidIndex ?
+                    waitContext.FenceValue : fenceValues[wait.Position];
+                context.Queue->Wait(*waitContext.Queue, fenceValue);
+            }
+        }
+
+        const std::vector<RenderGraphCompiler::Barrier>& finalBarriers =
+            m_Compiler.GetFinalBarriers(static_cast<RenderGraphCompiler::Queue>(queue));
+        if (!finalBarriers.empty() && !context.CommandList)
+        {
+            context.CommandList = context.Queue->GetCommandList();
+        }
+        if (context.CommandList)
+        {
+            ResourceBarriers(context.CommandList.Get(), finalBarriers);
+        }
+        if (&context != &graphics && context.CommandList)
+        {
+            executeCommandList(context);
+        }
+    }
+
+    return graphics.CommandList;
+}
@@ -0,0 +1,538 @@
+#include <RenderGraphCompiler.h>
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+namespace
+{
+    uint32_t ToIndex(RenderGraphCompiler::Queue queue)
+    {
+        return static_cast<uint32_t>(queue);
+    }
+
+    // Are all states of required set in state? The common state has no bits and only matches itself.
+    bool ContainsState(uint32_t state, uint32_t required)
+    {
+        if (required == RenderGraphCompiler::CommonState)
+        {
+            return state == RenderGraphCompiler::CommonState;
+        }
+        return (state & required) == required;
+    }
+}
+
+const uint32_t RenderGraphCompiler::InvalidIndex;
+
+RenderGraphCompiler::RenderGraphCompiler()
+    : m_AsyncQueues(false)
+{
+    Clear();
+}
+
+RenderGraphCompiler::~RenderGraphCompiler()
+{
+}
+
+void RenderGraphCompiler::Clear()
+{
+    m_Passes.clear();
+    m_Resources.clear();
+    ResetCompiledPasses();
+}
+
+void RenderGraphCompiler::ResetCompiledPasses()
+{
+    m_CompiledPasses.clear();
+    m_FinalWaits.clear();
+    for (uint32_t queue = 0; queue < NumQueues; ++queue)
+    {
+        m_FinalBarriers[queue].clear();
+        m_QueuePositions[queue].clear();
+        for (uint32_t waitQueue = 0; waitQueue < NumQueues; ++waitQueue)
+        {
+            m_LastWaits[queue][waitQueue] = InvalidIndex;
+        }
+    }
+}
+
+bool RenderGraphCompiler::IsStateSupported(Queue queue, uint32_t state)
+{
+    switch (queue)
+    {
+    case Queue::Compute:
+        return (state & ~ComputeQueueStates) == 0;
+    case Queue::Copy:
+        return (state & ~CopyQueueStates) == 0;
+    default:
+        return true;
+    }
+}
+
+uint32_t RenderGraphCompiler::ImportResource(uint32_t initialState, uint32_t finalState)
+{
+    m_Resources.push_back(Resource{ initialState, finalState, true });
+    return static_cast<uint32_t>(m_Resources.size() - 1);
+}
+
+uint32_t RenderGraphCompiler::AddResource(uint32_t state)
+{
+    m_Resources.push_back(Resource{ state, state, false });
+    return static_cast<uint32_t>(m_Resources.size() - 1);
+}
+
+uint32_t RenderGraphCompiler::AddPass(Queue queue, bool hasSideEffects)
+{
+    Pass pass;
+    pass.RequestedQueue = queue;
+    pass.AssignedQueue = queue;
+    pass.HasSideEffects = hasSideEffects;
+    pass.Position = InvalidIndex;
+    m_Passes.push_back(pass);
+    return static_cast<uint32_t>(m_Passes.size() - 1);
+}
+
+void RenderGraphCompiler::AddAccess(uint32_t pass, uint32_t resource, uint32_t state, bool isWrite)
+{
+    assert(pass < m_Passes.size() && resource < m_Resources.size());
+    assert(std::none_of(m_Passes[pass].Accesses.begin(), m_Passes[pass].Accesses.end(),
+        [resource](const Access& access) { return access.Resource == resource; }) &&
+        "A pass accesses a resource once.");
+
+    m_Passes[pass].Accesses.push_back(Access{ resource, state, isWrite });
+}
+
+void RenderGraphCompiler::Read(uint32_t pass, uint32_t resource, uint32_t state)
+{
+    AddAccess(pass, resource, state, false);
+}
+
+void RenderGraphCompiler::Write(uint32_t pass, uint32_t resource, uint32_t state)
+{
+    AddAccess(pass, resource, state, true);
+}
+
+void RenderGraphCompiler::Compile()
+{
+    AssignQueues();
+    BuildDependencies();
+    CullPasses();
+
+    // Every retry moves one more pass to the graphics queue, where every transition is possible.
+    do
+    {
+        ResetCompiledPasses();
+        SortPasses();
+    } while (!ComputeBarriers());
+}
+
+void RenderGraphCompiler::AssignQueues()
+{
+    for (Pass& pass : m_Passes)
+    {
+        pass.AssignedQueue = m_AsyncQueues ? pass.RequestedQueue : Queue::Graphics;
+    }
+}
+
+void RenderGraphCompiler::BuildDependencies()
+{
+    // Walk the passes in declaration order, which defines the order of the accesses of every resource.
+    std::vector<uint32_t> lastWriters(m_Resources.size(), InvalidIndex);
+    std::vector< std::vector<uint32_t> > readersSinceWrite(m_Resources.size());
+
+    for (uint32_t passIndex = 0; passIndex < m_Passes.size(); ++passIndex)
+    {
+        Pass& pass = m_Passes[passIndex];
+        pass.Dependencies.clear();
+        pass.DataDependencies.clear();
+
+        for (const Access& access : pass.Accesses)
+        {
+            const uint32_t lastWriter = lastWriters[access.Resource];
+            if (lastWriter != InvalidIndex)
+            {
+                // A write is treated as read-modify-write (a draw on top of a clear).
+                pass.Dependencies.push_back(lastWriter);
+                pass.DataDependencies.push_back(lastWriter);
+            }
+
+            if (access.IsWrite)
+            {
+                std::vector<uint32_t>& readers = readersSinceWrite[access.Resource];
+                pass.Dependencies.insert(pass.Dependencies.end(), readers.begin(), readers.end());
+                readers.clear();
+                lastWriters[access.Resource] = passIndex;
+            }
+            else
+            {
+                readersSinceWrite[access.Resource].push_back(passIndex);
+            }
+        }
+
+        for (std::vector<uint32_t>* pDependencies : { &pass.Dependencies, &pass.DataDependencies })
+        {
+            std::sort(pDependencies->begin(), pDependencies->end());
+            pDependencies->erase(std::unique(pDependencies->begin(), pDependencies->end()), pDependencies->end());
+        }
+    }
+}
+
+void RenderGraphCompiler::CullPasses()
+{
+    // Dependencies always point to earlier passes, one backward sweep finds everything that is used.
+    std::vector<bool> isUsed(m_Passes.size(), false);
+    for (uint32_t passIndex = static_cast<uint32_t>(m_Passes.size()); passIndex-- > 0; )
+    {
+        const Pass& pass = m_Passes[passIndex];
+        if (pass.HasSideEffects)
+        {
+            isUsed[passIndex] = true;
+        }
+        for (const Access& access : pass.Accesses)
+        {
+            if (access.IsWrite && m_Resources[access.Resource].IsImported)
+            {
+                isUsed[passIndex] = true;
+            }
+        }
+
+        if (isUsed[passIndex])
+        {
+            for (uint32_t dependency : pass.DataDependencies)
+            {
+                isUsed[dependency] = true;
+            }
+        }
+    }
+
+    for (uint32_t passIndex = 0; passIndex < m_Passes.size(); ++passIndex)
+    {
+        m_Passes[passIndex].Position = isUsed[passIndex] ? 0 : InvalidIndex;
+    }
+}
+
+void RenderGraphCompiler::SortPasses()
+{
+    // Kahn's algorithm over the passes that are kept. Culled passes are only ever
+    // write-after-read dependencies of kept passes and can be ignored.
+    std::vector<uint32_t> numPending(m_Passes.size(), 0);
+    std::vector< std::vector<uint32_t> > dependents(m_Passes.size());
+    std::vector<uint32_t> ready;
+
+    for (uint32_t passIndex = 0; passIndex < m_Passes.size(); ++passIndex)
+    {
+        if (IsCulled(passIndex))
+        {
+            continue;
+        }
+        for (uint32_t dependency : m_Passes[passIndex].Dependencies)
+        {
+            if (!IsCulled(dependency))
+            {
+                ++numPending[passIndex];
+                dependents[dependency].push_back(passIndex);
+            }
+        }
+        if (numPending[passIndex] == 0)
+        {
+            ready.push_back(passIndex);
+        }
+    }
+
+    // 优先: async passes first so they start as early as possible, then declaration order.
+    auto isBefore = [this](uint32_t a, uint32_t b)
+    {
+        const bool isAsyncA = m_Passes[a].AssignedQueue != Queue::Graphics;
+        const bool isAsyncB = m_Passes[b].AssignedQueue != Queue::Graphics;
+        if (isAsyncA != isAsyncB)
+        {
+            return isAsyncA;
+        }
+        return a < b;
+    };
+
+    while (!ready.empty())
+    {
+        auto next = std::min_element(ready.begin(), ready.end(), isBefore);
+        const uint32_t passIndex = *next;
+        ready.erase(next);
+
+        Pass& pass = m_Passes[passIndex];
+        pass.Position = static_cast<uint32_t>(m_CompiledPasses.size());
+        m_QueuePositions[ToIndex(pass.AssignedQueue)].push_back(pass.Position);
+
+        CompiledPass compiledPass;
+        compiledPass.Pass = passIndex;
+        compiledPass.PassQueue = pass.AssignedQueue;
+        compiledPass.Signal = false;
+        m_CompiledPasses.push_back(compiledPass);
+
+        for (uint32_t dependent : dependents[passIndex])
+        {
+            if (--numPending[dependent] == 0)
+            {
+                ready.push_back(dependent);
+            }
+        }
+    }
+
+    assert(std::none_of(numPending.begin(), numPending.end(), [](uint32_t n) { return n != 0; }) &&
+        "Dependencies follow the declaration order, there can be no cycle.");
+}
+
+uint32_t RenderGraphCompiler::GetNextPositionOnQueue(Queue queue, uint32_t position) const
+{
+    const std::vector<uint32_t>& positions = m_QueuePositions[ToIndex(queue)];
+    if (position == InvalidIndex)
+    {
+        return positions.empty() ? InvalidIndex : positions.front();
+    }
+
+    auto it = std::upper_bound(positions.begin(), positions.end(), position);
+    return it != positions.end() ? *it : InvalidIndex;
+}
+
+void RenderGraphCompiler::AddWait(uint32_t position, uint32_t waitPosition)
+{
+    CompiledPass& compiledPass = m_CompiledPasses[position];
+    const Queue waitQueue = m_CompiledPasses[waitPosition].PassQueue;
+    if (waitQueue == compiledPass.PassQueue)
+    {
+        return;
+    }
+
+    // Fences are monotonic, waiting for a later pass of the queue covers this one.
+    uint32_t& lastWait = m_LastWaits[ToIndex(compiledPass.PassQueue)][ToIndex(waitQueue)];
+    if (lastWait != InvalidIndex && lastWait >= waitPosition)
+    {
+        return;
+    }
+    lastWait = waitPosition;
+
+    compiledPass.Waits.push_back(QueueWait{ waitQueue, waitPosition });
+    m_CompiledPasses[waitPosition].Signal = true;
+}
+
+void RenderGraphCompiler::AddTransition(uint32_t resource, const ResourceTracker& tracker, uint32_t position, Queue queue,
+    uint32_t stateAfter)
+{
+    // The transition can begin right after the previous use if that was on the same queue
+    // and there is at least one other pass of the queue until this one.
+    uint32_t beginPosition = InvalidIndex;
+    if (tracker.LastPosition == InvalidIndex || tracker.LastQueue == queue)
+    {
+        beginPosition = GetNextPositionOnQueue(queue, tracker.LastPosition);
+    }
+
+    Barrier barrier = { BarrierType::Transition, BarrierSplit::None, resource, tracker.State, stateAfter };
+    std::vector<Barrier>& barriers = position == InvalidIndex ?
+        m_FinalBarriers[ToIndex(queue)] : m_CompiledPasses[position].Barriers;
+
+    if (beginPosition != InvalidIndex && beginPosition != position)
+    {
+        barrier.Split = BarrierSplit::Begin;
+        m_CompiledPasses[beginPosition].Barriers.push_back(barrier);
+        barrier.Split = BarrierSplit::End;
+    }
+    barriers.push_back(barrier);
+}
+
+bool RenderGraphCompiler::ComputeBarriers()
+{
+    std::vector<ResourceTracker> trackers(m_Resources.size());
+    for (uint32_t resource = 0; resource < m_Resources.size(); ++resource)
+    {
+        trackers[resource] = ResourceTracker{ m_Resources[resource].InitialState, false, InvalidIndex, Queue::Graphics, InvalidIndex };
+    }
+
+    for (uint32_t position = 0; position < m_CompiledPasses.size(); ++position)
+    {
+        Pass& pass = m_Passes[m_CompiledPasses[position].Pass];
+        const Queue queue = pass.AssignedQueue;
+
+        // Latest first, the wait for the last pass of a queue covers the earlier ones.
+        std::vector<uint32_t> waitPositions;
+        for (uint32_t dependency : pass.Dependencies)
+        {
+            if (!IsCulled(dependency))
+            {
+                waitPositions.push_back(m_Passes[dependency].Position);
+            }
+        }
+        std::sort(waitPositions.begin(), waitPositions.end(), std::greater<uint32_t>());
+        for (uint32_t waitPosition : waitPositions)
+        {
+            AddWait(position, waitPosition);
+        }
+
+        for (const Access& access : pass.Accesses)
+        {
+            ResourceTracker& tracker = trackers[access.Resource];
+            const bool isFirstUse = tracker.LastPosition == InvalidIndex;
+
+            uint32_t requiredState = access.State;
+            if (!access.IsWrite)
+            {
+                // 合并读取: the following passes of the queue that only read the resource share one transition.
+                for (uint32_t next = position + 1; next < m_CompiledPasses.size(); ++next)
+                {
+                    const Pass& nextPass = m_Passes[m_CompiledPasses[next].Pass];
+                    auto nextAccess = std::find_if(nextPass.Accesses.begin(), nextPass.Accesses.end(),
+                        [&access](const Access& other) { return other.Resource == access.Resource; });
+                    if (nextAccess == nextPass.Accesses.end())
+                    {
+                        continue;
+                    }
+                    if (nextAccess->IsWrite || nextPass.AssignedQueue != queue ||
+                        access.State == CommonState || nextAccess->State == CommonState)
+                    {
+                        break;
+                    }
+                    requiredState |= nextAccess->State;
+                }
+            }
+
+            bool needsTransition = false;
+            bool needsUAVBarrier = false;
+            if (access.IsWrite || tracker.LastAccessIsWrite || isFirstUse)
+            {
+                needsTransition = tracker.State != requiredState;
+                // Unordered accesses are not ordered by a transition to the same state.
+                needsUAVBarrier = !needsTransition && !isFirstUse && requiredState == UnorderedAccessState;
+            }
+            else
+            {
+                // Read after read, the merged transition of an earlier reader may already cover it.
+                needsTransition = !ContainsState(tracker.State, access.State);
+            }
+
+            if ((needsTransition || needsUAVBarrier) && !isFirstUse)
+            {
+                AddWait(position, tracker.LastPosition);
+            }
+            else if (!isFirstUse && tracker.TransitionPosition != InvalidIndex)
+            {
+                // The state was reached by a transition on another queue, it has to be done before this pass.
+                AddWait(position, tracker.TransitionPosition);
+            }
+
+            if (needsTransition && !IsStateSupported(queue, tracker.State | requiredState))
+            {
+                if (isFirstUse || !IsStateSupported(tracker.LastQueue, tracker.State | requiredState))
+                {
+                    // 队列不支持的状态: no queue before the pass can make the transition, run the pass on the graphics queue.
+                    pass.AssignedQueue = Queue::Graphics;
+                    return false;
+                }
+
+                // The queue of the previous use makes the transition after that pass, before it signals this pass.
+                m_CompiledPasses[tracker.LastPosition].BarriersAfter.push_back(
+                    Barrier{ BarrierType::Transition, BarrierSplit::None, access.Resource, tracker.State, requiredState });
+                tracker.State = requiredState;
+                tracker.TransitionPosition = tracker.LastPosition;
+            }
+            else if (needsTransition)
+            {
+                AddTransition(access.Resource, tracker, position, queue, requiredState);
+                tracker.State = requiredState;
+                tracker.TransitionPosition = position;
+            }
+            else if (needsUAVBarrier)
+            {
+                m_CompiledPasses[position].Barriers.push_back(
+                    Barrier{ BarrierType::UnorderedAccess, BarrierSplit::None, access.Resource, requiredState, requiredState });
+            }
+
+            tracker.LastAccessIsWrite = access.IsWrite;
+            tracker.LastPosition = position;
+            tracker.LastQueue = queue;
+        }
+    }
+
+    // 最终状态: transition on the queue of the last use after all of its passes, on the graphics
+    // queue if that queue does not support the states.
+    const uint32_t graphics = ToIndex(Queue::Graphics);
+    uint32_t finalWaitPositions[NumQueues];
+    std::fill(finalWaitPositions, finalWaitPositions + NumQueues, InvalidIndex);
+    for (uint32_t resource = 0; resource < m_Resources.size(); ++resource)
+    {
+        const ResourceTracker& tracker = trackers[resource];
+        const uint32_t finalState = m_Resources[resource].FinalState;
+        if (tracker.State == finalState)
+        {
+            continue;
+        }
+
+        Queue queue = tracker.LastPosition != InvalidIndex ? tracker.LastQueue : Queue::Graphics;
+        if (!IsStateSupported(queue, tracker.State | finalState))
+        {
+            uint32_t& waitPosition = finalWaitPositions[ToIndex(queue)];
+            waitPosition = waitPosition == InvalidIndex ? tracker.LastPosition : std::max(waitPosition, tracker.LastPosition);
+            queue = Queue::Graphics;
+        }
+        AddTransition(resource, tracker, InvalidIndex, queue, finalState);
+    }
+
+    // The graphics queue waits for the final barriers of the other queues, which cover all of their passes,
+    // or for the last use of the resources whose final transition it makes.
+    for (uint32_t queue = 0; queue < NumQueues; ++queue)
+    {
+        if (queue == graphics)
+        {
+            continue;
+        }
+
+        if (!m_FinalBarriers[queue].empty())
+        {
+            m_FinalWaits.push_back(QueueWait{ static_cast<Queue>(queue), InvalidIndex });
+        }
+        else if (finalWaitPositions[queue] != InvalidIndex)
+        {
+            const uint32_t lastWait = m_LastWaits[graphics][queue];
+            if (lastWait == InvalidIndex || lastWait < finalWaitPositions[queue])
+            {
+                m_FinalWaits.push_back(QueueWait{ static_cast<Queue>(queue), finalWaitPositions[queue] });
+                m_CompiledPasses[finalWaitPositions[queue]].Signal = true;
+            }
+        }
+    }
+
+    return true;
+}
+
+RenderGraphCompiler::Statistics RenderGraphCompiler::GetStatistics() const
+{
+    Statistics statistics;
+    statistics.NumPasses = GetNumPasses();
+    statistics.NumCulledPasses = statistics.NumPasses - static_cast<uint32_t>(m_CompiledPasses.size());
+
+    auto countBatch = [&statistics](const std::vector<Barrier>& barriers)
+    {
+        if (!barriers.empty())
+        {
+            ++statistics.NumBarrierBatches;
+        }
+        for (const Barrier& barrier : barriers)
+        {
+            ++statistics.NumBarriers;
+            if (barrier.Split == BarrierSplit::Begin)
+            {
+                ++statistics.NumSplitBarriers;
+            }
+        }
+    };
+
+    for (const CompiledPass& compiledPass : m_CompiledPasses)
+    {
+        countBatch(compiledPass.Barriers);
+        countBatch(compiledPass.BarriersAfter);
+        statistics.NumQueueWaits += static_cast<uint32_t>(compiledPass.Waits.size());
+    }
+    statistics.NumQueueWaits += static_cast<uint32_t>(m_FinalWaits.size());
+    for (const std::vector<Barrier>& barriers : m_FinalBarriers)
+    {
+        countBatch(barriers);
+    }
+
+    return statistics;
+}
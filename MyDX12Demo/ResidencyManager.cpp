@@ -0,0 +1,88 @@
+#include <ResidencyManager.h>
+#include <DX12LibPCH.h>
+
+ResidencyManager::ResidencyManager(Microsoft::WRL::ComPtr<ID3D12Device2> device, Microsoft::WRL::ComPtr<IDXGIAdapter3> adapter)
+    : m_d3d12Device(device)
+    , m_dxgiAdapter(adapter)
+    , m_OverBudget(false)
+{
+}
+
+ResidencyManager::~ResidencyManager()
+{
+}
+
+void ResidencyManager::Track(ID3D12Pageable* pObject, uint64_t size)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Policy.Add(pObject, size);
+}
+
+void ResidencyManager::Untrack(ID3D12Pageable* pObject)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Policy.Remove(pObject);
+}
+
+void ResidencyManager::MarkUsed(ID3D12Pageable* pObject)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Policy.MarkUsed(pObject);
+}
+
+void ResidencyManager::MakeResident(ID3D12Pageable* pObject)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_Policy.IsResident(pObject))
+    {
+        // 同步换入, MakeResident returns once the object can be used.
+        ThrowIfFailed(m_d3d12Device->MakeResident(1, &pObject));
+    }
+    m_Policy.MarkResident(pObject);
+}
+
+void ResidencyManager::PrepareSubmission(uint64_t completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = QueryVideoMemoryInfo();
+    m_Policy.PrepareSubmission(memoryInfo.Budget, memoryInfo.CurrentUsage, completedFenceValue, m_Operations);
+
+    // Evict first, so the objects that are paged in fit into the budget.
+    if (!m_Operations.Evict.empty())
+    {
+        ThrowIfFailed(m_d3d12Device->Evict(static_cast<UINT>(m_Operations.Evict.size()),
+            reinterpret_cast<ID3D12Pageable* const*>(m_Operations.Evict.data())));
+    }
+    if (!m_Operations.MakeResident.empty())
+    {
+        ThrowIfFailed(m_d3d12Device->MakeResident(static_cast<UINT>(m_Operations.MakeResident.size()),
+            reinterpret_cast<ID3D12Pageable* const*>(m_Operations.MakeResident.data())));
+    }
+
+    // Only report when the state changes, not every frame.
+    if (m_Operations.OverBudget && !m_OverBudget)
+    {
+        OutputDebugStringA("ResidencyManager: over the video memory budget, everything the GPU does not use is evicted.\n");
+    }
+    m_OverBudget = m_Operations.OverBudget;
+}
+
+void ResidencyManager::Submitted(uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Policy.Submitted(fenceValue);
+}
+
+DXGI_QUERY_VIDEO_MEMORY_INFO ResidencyManager::QueryVideoMemoryInfo() const
+{
+    DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+    ThrowIfFailed(m_dxgiAdapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo));
+    return memoryInfo;
+}
+
+ResidencyPolicy::Statistics ResidencyManager::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Policy.GetStatistics();
+}
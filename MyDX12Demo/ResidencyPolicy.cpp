@@ -0,0 +1,158 @@
+#include <ResidencyPolicy.h>
+
+#include <algorithm>
+#include <cassert>
+
+ResidencyPolicy::ResidencyPolicy()
+    : m_NumEvictions(0)
+    , m_NumMakeResidents(0)
+{
+}
+
+ResidencyPolicy::~ResidencyPolicy()
+{
+}
+
+void ResidencyPolicy::Add(void* pObject, uint64_t size)
+{
+    assert(pObject && m_Objects.find(pObject) == m_Objects.end() && "The object is already tracked.");
+
+    Object& object = m_Objects[pObject];
+    object.Size = size;
+    object.LastUsedFenceValue = 0;
+    object.Resident = true;
+    object.Pending = false;
+    object.LRUPosition = m_LRUList.insert(m_LRUList.end(), pObject);
+    Touch(pObject, object);
+}
+
+void ResidencyPolicy::Remove(void* pObject)
+{
+    auto it = m_Objects.find(pObject);
+    if (it == m_Objects.end())
+    {
+        return;
+    }
+
+    // A pending entry of a removed object is skipped by Submitted.
+    m_LRUList.erase(it->second.LRUPosition);
+    m_Objects.erase(it);
+}
+
+bool ResidencyPolicy::MarkUsed(void* pObject)
+{
+    auto it = m_Objects.find(pObject);
+    assert(it != m_Objects.end() && "The object is not tracked.");
+
+    Touch(pObject, it->second);
+    return !it->second.Resident;
+}
+
+void ResidencyPolicy::MarkResident(void* pObject)
+{
+    auto it = m_Objects.find(pObject);
+    assert(it != m_Objects.end() && "The object is not tracked.");
+
+    if (!it->second.Resident)
+    {
+        it->second.Resident = true;
+        ++m_NumMakeResidents;
+    }
+    Touch(pObject, it->second);
+}
+
+void ResidencyPolicy::Touch(void* pObject, Object& object)
+{
+    // Most recently used objects go to the back.
+    m_LRUList.splice(m_LRUList.end(), m_LRUList, object.LRUPosition);
+
+    if (!object.Pending)
+    {
+        object.Pending = true;
+        m_PendingObjects.push_back(pObject);
+    }
+}
+
+void ResidencyPolicy::PrepareSubmission(uint64_t budget, uint64_t currentUsage, uint64_t completedFenceValue, Operations& operations)
+{
+    operations.Evict.clear();
+    operations.MakeResident.clear();
+    operations.OverBudget = false;
+
+    // 换入: everything the submission uses must be resident.
+    uint64_t usage = currentUsage;
+    for (void* pObject : m_PendingObjects)
+    {
+        auto it = m_Objects.find(pObject);
+        if (it != m_Objects.end() && !it->second.Resident)
+        {
+            it->second.Resident = true;
+            usage += it->second.Size;
+            operations.MakeResident.push_back(pObject);
+            ++m_NumMakeResidents;
+        }
+    }
+
+    // 换出: least recently used first, skipping what the GPU may still access.
+    for (auto it = m_LRUList.begin(); it != m_LRUList.end() && usage > budget; ++it)
+    {
+        Object& object = m_Objects[*it];
+        if (!object.Resident || object.Pending || object.LastUsedFenceValue > completedFenceValue)
+        {
+            continue;
+        }
+
+        object.Resident = false;
+        usage -= std::min(usage, object.Size);
+        operations.Evict.push_back(*it);
+        ++m_NumEvictions;
+    }
+
+    operations.OverBudget = usage > budget;
+}
+
+void ResidencyPolicy::Submitted(uint64_t fenceValue)
+{
+    for (void* pObject : m_PendingObjects)
+    {
+        auto it = m_Objects.find(pObject);
+        if (it != m_Objects.end())
+        {
+            it->second.LastUsedFenceValue = fenceValue;
+            it->second.Pending = false;
+        }
+    }
+    m_PendingObjects.clear();
+}
+
+bool ResidencyPolicy::IsTracked(void* pObject) const
+{
+    return m_Objects.find(pObject) != m_Objects.end();
+}
+
+bool ResidencyPolicy::IsResident(void* pObject) const
+{
+    auto it = m_Objects.find(pObject);
+    return it != m_Objects.end() && it->second.Resident;
+}
+
+ResidencyPolicy::Statistics ResidencyPolicy::GetStatistics() const
+{
+    Statistics statistics;
+    statistics.NumObjects = static_cast<uint32_t>(m_Objects.size());
+    for (const auto& entry : m_Objects)
+    {
+        if (entry.second.Resident)
+        {
+            ++statistics.NumResidentObjects;
+            statistics.ResidentSize += entry.second.Size;
+        }
+        else
+        {
+            statistics.EvictedSize += entry.second.Size;
+        }
+    }
+    statistics.NumEvictions = m_NumEvictions;
+    statistics.NumMakeResidents = m_NumMakeResidents;
+    return statistics;
+}
@@ -0,0 +1,182 @@
+#include <ShaderLibrary.h>
+#include <MappedFile.h>
+#include <PipelineStateHasher.h>
+#include <ThreadPool.h>
+
+#include <chrono>
+#include <filesystem>
+
+namespace
+{
+    template<typename T>
+    std::shared_future<T> MakeReadyFuture(T value)
+    {
+        std::promise<T> promise;
+        promise.set_value(std::move(value));
+        return promise.get_future().share();
+    }
+
+    template<typename T>
+    bool IsReady(const std::shared_future<T>& future)
+    {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+}
+
+ShaderLibrary::ShaderLibrary(ThreadPool* pThreadPool)
+    : m_pThreadPool(pThreadPool)
+{
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+    // Reloads on the thread pool only use their own data, wait for them anyway
+    // so no reads are left running when the library is gone.
+    for (auto& reload : m_Reloads)
+    {
+        reload.second.Shader.wait();
+    }
+}
+
+std::wstring ShaderLibrary::GetKey(const std::wstring& fileName)
+{
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::absolute(std::filesystem::path(fileName), error);
+    return error ? fileName : path.lexically_normal().wstring();
+}
+
+ShaderLibrary::ShaderPtr ShaderLibrary::ReadShader(const std::wstring& fileName)
+{
+    // The mapping is closed right away, a mapped file can not be overwritten on Windows.
+    MappedFile file;
+    if (!file.Open(fileName))
+    {
+        return nullptr;
+    }
+
+    auto shader = std::make_shared<Shader>();
+    shader->FileName = fileName;
+    const uint8_t* pData = static_cast<const uint8_t*>(file.GetData());
+    shader->Bytecode.assign(pData, pData + file.GetSize());
+    shader->Hash = HashShaderBytecode(shader->Bytecode.data(), shader->Bytecode.size());
+
+    return shader;
+}
+
+ShaderLibrary::ShaderPtr ShaderLibrary::Load(const std::wstring& fileName)
+{
+    const std::wstring key = GetKey(fileName);
+
+    // The first thread that asks for a shader reads it, the others wait for it.
+    std::promise<ShaderPtr> promise;
+    ShaderFuture future;
+    bool isReader = false;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Shaders.find(key);
+        if (it != m_Shaders.end())
+        {
+            future = it->second;
+        }
+        else
+        {
+            future = promise.get_future().share();
+            m_Shaders.emplace(key, future);
+            isReader = true;
+        }
+    }
+
+    if (isReader)
+    {
+        ShaderPtr shader = ReadShader(key);
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (shader)
+            {
+                m_FileWatcher.Watch(key);
+            }
+            else
+            {
+                // Let a later Load try again.
+                m_Shaders.erase(key);
+            }
+        }
+        promise.set_value(shader);
+    }
+
+    return future.get();
+}
+
+std::shared_future<ShaderLibrary::ShaderPtr> ShaderLibrary::LoadAsync(const std::wstring& fileName)
+{
+    if (!m_pThreadPool)
+    {
+        return MakeReadyFuture(Load(fileName));
+    }
+
+    return m_pThreadPool->Submit([this, fileName]() { return Load(fileName); }).share();
+}
+
+void ShaderLibrary::StartReload(const std::wstring& fileName)
+{
+    Reload& reload = m_Reloads[fileName];
+    reload.ChangedAgain = false;
+    if (m_pThreadPool)
+    {
+        reload.Shader = m_pThreadPool->Submit([fileName]() { return ReadShader(fileName); }).share();
+    }
+    else
+    {
+        reload.Shader = MakeReadyFuture(ReadShader(fileName));
+    }
+}
+
+std::vector<ShaderLibrary::ShaderPtr> ShaderLibrary::Update()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // Start the reloads of the changed files.
+    for (const std::wstring& fileName : m_FileWatcher.PollChanges())
+    {
+        auto it = m_Reloads.find(fileName);
+        if (it != m_Reloads.end())
+        {
+            // Still reading an earlier version, read the file again once that is done.
+            it->second.ChangedAgain = true;
+            continue;
+        }
+
+        StartReload(fileName);
+    }
+
+    // Collect the finished reloads, a rewrite with the same bytecode changes nothing.
+    std::vector<ShaderPtr> changedShaders;
+    for (auto it = m_Reloads.begin(); it != m_Reloads.end(); )
+    {
+        if (!IsReady(it->second.Shader))
+        {
+            ++it;
+            continue;
+        }
+
+        if (it->second.ChangedAgain)
+        {
+            // The version that was read is already outdated, it may even be cut off.
+            StartReload(it->first);
+            ++it;
+            continue;
+        }
+
+        ShaderPtr shader = it->second.Shader.get();
+        auto current = m_Shaders.find(it->first);
+        if (shader && current != m_Shaders.end() && IsReady(current->second) &&
+            (!current->second.get() || current->second.get()->Hash != shader->Hash))
+        {
+            current->second = MakeReadyFuture(shader);
+            changedShaders.push_back(shader);
+        }
+        it = m_Reloads.erase(it);
+    }
+
+    return changedShaders;
+}
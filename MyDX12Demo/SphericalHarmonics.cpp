@@ -0,0 +1,343 @@
+#include <SphericalHarmonics.h>
+
+#include <EnvironmentMap.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include <emmintrin.h> // SSE2
+
+namespace
+{
+    const float Pi = 3.14159265358979f;
+
+    // Constants of the real SH basis functions.
+    const float SHBand0 = 0.282094792f;  // 1 / (2 sqrt(pi))
+    const float SHBand1 = 0.488602512f;  // sqrt(3) / (2 sqrt(pi))
+    const float SHBand2 = 1.092548431f;  // sqrt(15) / (2 sqrt(pi))
+    const float SHBand2Z = 0.315391565f; // sqrt(5) / (4 sqrt(pi))
+    const float SHBand2XY = 0.546274215f; // sqrt(15) / (4 sqrt(pi))
+
+    typedef std::array<double, SH9CoefficientCount * 3> SH9Sums;
+
+    // A row of texels as directions, solid angles and radiance, structure of arrays padded to 4.
+    struct TexelRow
+    {
+        std::vector<float> X;
+        std::vector<float> Y;
+        std::vector<float> Z;
+        std::vector<float> SolidAngle;
+        std::vector<float> R;
+        std::vector<float> G;
+        std::vector<float> B;
+
+        // The padding texels keep a solid angle of 0 and do not contribute.
+        explicit TexelRow(uint32_t width)
+        {
+            const size_t padded = (size_t(width) + 3) & ~size_t(3);
+            for (std::vector<float>* pArray : { &X, &Y, &Z, &SolidAngle, &R, &G, &B })
+            {
+                pArray->assign(padded, 0.0f);
+            }
+        }
+
+        // Load the radiance of row y of a RGBA32F or RGBA16F subresource.
+        void LoadRadiance(const TextureData& texture, uint32_t slice, uint32_t y)
+        {
+            const TextureSubresource& subresource = texture.GetSubresource(0, slice);
+            const uint8_t* pRow = texture.GetPixels(0, slice) + y * subresource.RowPitch;
+            if (texture.Format == TextureFormat::RGBA32Float)
+            {
+                const float* pPixels = reinterpret_cast<const float*>(pRow);
+                for (uint32_t x = 0; x < subresource.Width; ++x)
+                {
+                    R[x] = pPixels[x * 4 + 0];
+                    G[x] = pPixels[x * 4 + 1];
+                    B[x] = pPixels[x * 4 + 2];
+                }
+            }
+            else
+            {
+                const uint16_t* pPixels = reinterpret_cast<const uint16_t*>(pRow);
+                for (uint32_t x = 0; x < subresource.Width; ++x)
+                {
+                    R[x] = HalfToFloat(pPixels[x * 4 + 0]);
+                    G[x] = HalfToFloat(pPixels[x * 4 + 1]);
+                    B[x] = HalfToFloat(pPixels[x * 4 + 2]);
+                }
+            }
+        }
+    };
+
+    /**
+     * Projects rows of texels four at a time. The float partial sums only ever hold
+     * one row, they are flushed to doubles so large textures do not lose precision.
+     */
+    class SH9Accumulator
+    {
+    public:
+        SH9Accumulator()
+        {
+            Reset();
+        }
+
+        void AddRow(const TexelRow& row)
+        {
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 three = _mm_set1_ps(3.0f);
+            for (size_t i = 0; i < row.X.size(); i += 4)
+            {
+                const __m128 x = _mm_loadu_ps(&row.X[i]);
+                const __m128 y = _mm_loadu_ps(&row.Y[i]);
+                const __m128 z = _mm_loadu_ps(&row.Z[i]);
+                const __m128 solidAngle = _mm_loadu_ps(&row.SolidAngle[i]);
+
+                __m128 basis[SH9CoefficientCount];
+                basis[0] = _mm_set1_ps(SHBand0);
+                basis[1] = _mm_mul_ps(_mm_set1_ps(SHBand1), y);
+                basis[2] = _mm_mul_ps(_mm_set1_ps(SHBand1), z);
+                basis[3] = _mm_mul_ps(_mm_set1_ps(SHBand1), x);
+                basis[4] = _mm_mul_ps(_mm_set1_ps(SHBand2), _mm_mul_ps(x, y));
+                basis[5] = _mm_mul_ps(_mm_set1_ps(SHBand2), _mm_mul_ps(y, z));
+                basis[6] = _mm_mul_ps(_mm_set1_ps(SHBand2Z), _mm_sub_ps(_mm_mul_ps(three, _mm_mul_ps(z, z)), one));
+                basis[7] = _mm_mul_ps(_mm_set1_ps(SHBand2), _mm_mul_ps(x, z));
+                basis[8] = _mm_mul_ps(_mm_set1_ps(SHBand2XY), _mm_sub_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+
+                const __m128 radiance[3] =
+                {
+                    _mm_mul_ps(_mm_loadu_ps(&row.R[i]), solidAngle),
+                    _mm_mul_ps(_mm_loadu_ps(&row.G[i]), solidAngle),
+                    _mm_mul_ps(_mm_loadu_ps(&row.B[i]), solidAngle),
+                };
+
+                for (uint32_t k = 0; k < SH9CoefficientCount; ++k)
+                {
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        m_Sums[k][c] = _mm_add_ps(m_Sums[k][c], _mm_mul_ps(basis[k], radiance[c]));
+                    }
+                }
+            }
+        }
+
+        // Add the partial sums to the totals and start over.
+        void Flush(SH9Sums& totals)
+        {
+            for (uint32_t k = 0; k < SH9CoefficientCount; ++k)
+            {
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    alignas(16) float lanes[4];
+                    _mm_store_ps(lanes, m_Sums[k][c]);
+                    totals[k * 3 + c] += double(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+                }
+            }
+            Reset();
+        }
+
+    private:
+        void Reset()
+        {
+            for (uint32_t k = 0; k < SH9CoefficientCount; ++k)
+            {
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    m_Sums[k][c] = _mm_setzero_ps();
+                }
+            }
+        }
+
+        __m128 m_Sums[SH9CoefficientCount][3];
+    };
+
+    bool IsFloatFormat(TextureFormat format)
+    {
+        return format == TextureFormat::RGBA32Float || format == TextureFormat::RGBA16Float;
+    }
+
+    // Sum the partial results in a fixed order, so the result does not depend on the scheduling.
+    void Resolve(const std::vector<SH9Sums>& partialSums, SH9Color& sh)
+    {
+        SH9Sums totals = {};
+        for (const SH9Sums& sums : partialSums)
+        {
+            for (size_t i = 0; i < totals.size(); ++i)
+            {
+                totals[i] += sums[i];
+            }
+        }
+
+        for (uint32_t k = 0; k < SH9CoefficientCount; ++k)
+        {
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                sh.Coefficients[k][c] = static_cast<float>(totals[k * 3 + c]);
+            }
+        }
+    }
+}
+
+bool ProjectCubemapSH9(const TextureData& cubemap, SH9Color& sh, ThreadPool* pThreadPool)
+{
+    if (!IsFloatFormat(cubemap.Format) || !cubemap.IsCubemap || cubemap.ArraySize != 6 || cubemap.Width != cubemap.Height)
+    {
+        return false;
+    }
+
+    // The solid angles are the same on every face.
+    const uint32_t size = cubemap.Width;
+    std::vector<float> solidAngles(size_t(size) * size);
+    for (uint32_t y = 0; y < size; ++y)
+    {
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            solidAngles[size_t(y) * size + x] = GetCubemapTexelSolidAngle(x, y, size);
+        }
+    }
+
+    std::vector<SH9Sums> faceSums(6, SH9Sums());
+    ParallelFor(pThreadPool, 6, [&](uint32_t face)
+    {
+        TexelRow row(size);
+        SH9Accumulator accumulator;
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                float direction[3];
+                GetCubemapDirection(face, 2.0f * (x + 0.5f) / size - 1.0f, 2.0f * (y + 0.5f) / size - 1.0f, direction);
+                row.X[x] = direction[0];
+                row.Y[x] = direction[1];
+                row.Z[x] = direction[2];
+                row.SolidAngle[x] = solidAngles[size_t(y) * size + x];
+            }
+            row.LoadRadiance(cubemap, face, y);
+            accumulator.AddRow(row);
+            accumulator.Flush(faceSums[face]);
+        }
+    });
+
+    Resolve(faceSums, sh);
+    return true;
+}
+
+bool ProjectPanoramaSH9(const TextureData& panorama, SH9Color& sh, ThreadPool* pThreadPool)
+{
+    if (!IsFloatFormat(panorama.Format) || panorama.Width == 0 || panorama.Height == 0)
+    {
+        return false;
+    }
+
+    const uint32_t width = panorama.Width;
+    const uint32_t height = panorama.Height;
+
+    // The azimuth only depends on the column, see GetPanoramaDirection.
+    std::vector<float> sinPhi(width);
+    std::vector<float> cosPhi(width);
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        float phi = ((x + 0.5f) / width - 0.5f) * 2.0f * Pi;
+        sinPhi[x] = std::sin(phi);
+        cosPhi[x] = std::cos(phi);
+    }
+
+    // Every row costs the same, so the rows are split into equal bands.
+    const uint32_t numBands = std::min(height, 64u);
+    std::vector<SH9Sums> bandSums(numBands, SH9Sums());
+    ParallelFor(pThreadPool, numBands, [&](uint32_t band)
+    {
+        TexelRow row(width);
+        SH9Accumulator accumulator;
+        const uint32_t firstRow = uint32_t(uint64_t(band) * height / numBands);
+        const uint32_t lastRow = uint32_t(uint64_t(band + 1) * height / numBands);
+        for (uint32_t y = firstRow; y < lastRow; ++y)
+        {
+            // Exact solid angle of a texel of the row: dphi * (cos(theta0) - cos(theta1)).
+            const float theta = (y + 0.5f) / height * Pi;
+            const float solidAngle = 2.0f * Pi / width * (std::cos(Pi * y / height) - std::cos(Pi * (y + 1) / height));
+            const float sinTheta = std::sin(theta);
+            const float cosTheta = std::cos(theta);
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                row.X[x] = -sinTheta * sinPhi[x];
+                row.Y[x] = cosTheta;
+                row.Z[x] = -sinTheta * cosPhi[x];
+                row.SolidAngle[x] = solidAngle;
+            }
+            row.LoadRadiance(panorama, 0, y);
+            accumulator.AddRow(row);
+            accumulator.Flush(bandSums[band]);
+        }
+    });
+
+    Resolve(bandSums, sh);
+    return true;
+}
+
+void ConvolveSH9Irradiance(SH9Color& sh)
+{
+    // Cosine lobe per band (pi, 2pi/3, pi/4), divided by pi.
+    const float bandScale[SH9CoefficientCount] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+    for (uint32_t k = 0; k < SH9CoefficientCount; ++k)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            sh.Coefficients[k][c] *= bandScale[k];
+        }
+    }
+}
+
+void EvaluateSH9(const SH9Color& sh, const float* pDirection, float* pColor)
+{
+    const float x = pDirection[0];
+    const float y = pDirection[1];
+    const float z = pDirection[2];
+    const float basis[SH9CoefficientCount] =
+    {
+        SHBand0,
+        SHBand1 * y,
+        SHBand1 * z,
+        SHBand1 * x,
+        SHBand2 * x * y,
+        SHBand2 * y * z,
+        SHBand2Z * (3.0f * z * z - 1.0f),
+        SHBand2 * x * z,
+        SHBand2XY * (x * x - y * y),
+    };
+
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        float sum = 0.0f;
+        for (uint32_t k = 0; k < SH9CoefficientCount; ++k)
+        {
+            sum += sh.Coefficients[k][c] * basis[k];
+        }
+        pColor[c] = sum;
+    }
+}
+
+void PackSH9Constants(const SH9Color& sh, SH9Constants& constants)
+{
+    // The shader computes c0 + c1 y + c2 z + c3 x + c4 xy + c5 yz + c6 z^2 + c7 xz + c8 (x^2 - y^2),
+    // the constant part of Y20 is folded into c0.
+    const float scale[SH9CoefficientCount] =
+    {
+        SHBand0, SHBand1, SHBand1, SHBand1, SHBand2, SHBand2, 3.0f * SHBand2Z, SHBand2, SHBand2XY,
+    };
+
+    for (uint32_t k = 0; k < SH9CoefficientCount; ++k)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            constants.Values[k * 3 + c] = sh.Coefficients[k][c] * scale[k];
+        }
+    }
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        constants.Values[c] -= SHBand2Z * sh.Coefficients[6][c];
+    }
+    constants.Values[SH9RootConstantCount - 1] = 0.0f;
+}
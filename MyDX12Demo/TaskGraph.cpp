@@ -0,0 +1,256 @@
+#include <TaskGraph.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+struct TaskGraph::RunState
+{
+    // Only used for a task taken from the ready queue, Run is still waiting for it then.
+    TaskGraph* pGraph = nullptr;
+    ThreadPool* pThreadPool = nullptr;
+    std::chrono::steady_clock::time_point Start;
+
+    // Everything below is protected by Mutex.
+    std::vector<uint32_t> NumPendingDependencies;
+    // The task threw, or one of its dependencies failed.
+    std::vector<uint8_t> Failed;
+    std::vector<uint8_t> PhaseStarted;
+    std::deque<uint32_t> Ready;
+    uint32_t NumFinished = 0;
+    std::exception_ptr Exception;
+
+    std::mutex Mutex;
+    std::condition_variable Condition;
+
+    double GetSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    }
+};
+
+TaskGraph::TaskGraph()
+    : m_TotalSeconds(0.0)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+}
+
+void TaskGraph::Clear()
+{
+    m_Tasks.clear();
+    m_Phases.clear();
+    m_TotalSeconds = 0.0;
+}
+
+uint32_t TaskGraph::AddPhase(const std::string& name)
+{
+    PhaseTiming phase;
+    phase.Name = name;
+    m_Phases.push_back(phase);
+
+    return static_cast<uint32_t>(m_Phases.size() - 1);
+}
+
+uint32_t TaskGraph::AddTask(uint32_t phase, std::function<void()> func, const std::vector<uint32_t>& dependencies)
+{
+    assert(phase < m_Phases.size());
+
+    const uint32_t index = static_cast<uint32_t>(m_Tasks.size());
+
+    Task task;
+    task.Phase = phase;
+    task.Func = std::move(func);
+    task.NumDependencies = 0;
+    for (uint32_t dependency : dependencies)
+    {
+        assert(dependency < index && "Dependencies must be added before the tasks that depend on them.");
+
+        // A dependency that is given twice only counts once.
+        std::vector<uint32_t>& dependents = m_Tasks[dependency].Dependents;
+        if (std::find(dependents.begin(), dependents.end(), index) == dependents.end())
+        {
+            dependents.push_back(index);
+            ++task.NumDependencies;
+        }
+    }
+    m_Tasks.push_back(std::move(task));
+
+    ++m_Phases[phase].NumTasks;
+
+    return index;
+}
+
+void TaskGraph::Run(ThreadPool* pThreadPool)
+{
+    for (PhaseTiming& phase : m_Phases)
+    {
+        phase.TaskSeconds = 0.0;
+        phase.StartSeconds = 0.0;
+        phase.EndSeconds = 0.0;
+    }
+    m_TotalSeconds = 0.0;
+
+    if (m_Tasks.empty())
+    {
+        return;
+    }
+
+    // Shared with the pool jobs, a job may only run after Run returned and find nothing to do.
+    auto state = std::make_shared<RunState>();
+    state->pGraph = this;
+    state->pThreadPool = pThreadPool;
+    state->Start = std::chrono::steady_clock::now();
+    state->NumPendingDependencies.resize(m_Tasks.size());
+    state->Failed.resize(m_Tasks.size(), 0);
+    state->PhaseStarted.resize(m_Phases.size(), 0);
+    for (uint32_t i = 0; i < m_Tasks.size(); ++i)
+    {
+        state->NumPendingDependencies[i] = m_Tasks[i].NumDependencies;
+        if (m_Tasks[i].NumDependencies == 0)
+        {
+            state->Ready.push_back(i);
+        }
+    }
+
+    if (!pThreadPool)
+    {
+        // Dependencies come first, so the ready queue runs the tasks in a valid order.
+        while (!state->Ready.empty())
+        {
+            uint32_t task = state->Ready.front();
+            state->Ready.pop_front();
+            Execute(state, task);
+        }
+    }
+    else
+    {
+        // The jobs start taking tasks right away, count them first.
+        const size_t numReady = state->Ready.size();
+        for (size_t i = 0; i < numReady; ++i)
+        {
+            pThreadPool->Submit([state]() { RunReadyTask(state); });
+        }
+
+        // 调用线程也参与工作
+        const uint32_t numTasks = static_cast<uint32_t>(m_Tasks.size());
+        while (true)
+        {
+            uint32_t task;
+            {
+                std::unique_lock<std::mutex> lock(state->Mutex);
+                state->Condition.wait(lock, [&state, numTasks]()
+                {
+                    return !state->Ready.empty() || state->NumFinished == numTasks;
+                });
+                if (state->NumFinished == numTasks)
+                {
+                    break;
+                }
+
+                task = state->Ready.front();
+                state->Ready.pop_front();
+            }
+            Execute(state, task);
+        }
+    }
+
+    m_TotalSeconds = state->GetSeconds();
+
+    if (state->Exception)
+    {
+        std::rethrow_exception(state->Exception);
+    }
+}
+
+void TaskGraph::RunReadyTask(const std::shared_ptr<RunState>& state)
+{
+    uint32_t task;
+    {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        // The calling thread or another job may have taken it already.
+        if (state->Ready.empty())
+        {
+            return;
+        }
+
+        task = state->Ready.front();
+        state->Ready.pop_front();
+    }
+    state->pGraph->Execute(state, task);
+}
+
+void TaskGraph::Execute(const std::shared_ptr<RunState>& pState, uint32_t taskIndex)
+{
+    RunState& state = *pState;
+    const Task& task = m_Tasks[taskIndex];
+
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lock(state.Mutex);
+        failed = state.Failed[taskIndex] != 0;
+    }
+
+    const double start = state.GetSeconds();
+    if (!failed)
+    {
+        try
+        {
+            task.Func();
+        }
+        catch (...)
+        {
+            failed = true;
+
+            std::lock_guard<std::mutex> lock(state.Mutex);
+            if (!state.Exception)
+            {
+                state.Exception = std::current_exception();
+            }
+        }
+    }
+    const double end = state.GetSeconds();
+
+    uint32_t numReady = 0;
+    {
+        std::lock_guard<std::mutex> lock(state.Mutex);
+
+        PhaseTiming& phase = m_Phases[task.Phase];
+        phase.TaskSeconds += end - start;
+        phase.StartSeconds = state.PhaseStarted[task.Phase] ? std::min(phase.StartSeconds, start) : start;
+        phase.EndSeconds = std::max(phase.EndSeconds, end);
+        state.PhaseStarted[task.Phase] = 1;
+
+        for (uint32_t dependent : task.Dependents)
+        {
+            if (failed)
+            {
+                state.Failed[dependent] = 1;
+            }
+            if (--state.NumPendingDependencies[dependent] == 0)
+            {
+                state.Ready.push_back(dependent);
+                ++numReady;
+            }
+        }
+
+        ++state.NumFinished;
+    }
+    state.Condition.notify_all();
+
+    if (state.pThreadPool)
+    {
+        for (uint32_t i = 0; i < numReady; ++i)
+        {
+            state.pThreadPool->Submit([pState]() { RunReadyTask(pState); });
+        }
+    }
+}
@@ -0,0 +1,219 @@
+#include <TextureData.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+uint32_t GetBytesPerPixel(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::RGBA32Float:
+        return 16;
+    case TextureFormat::RGBA16Float:
+        return 8;
+    case TextureFormat::RG16Float:
+    case TextureFormat::RGBA8UNorm:
+    case TextureFormat::RGBA8UNormSRGB:
+        return 4;
+    default:
+        assert(false && "Invalid texture format.");
+        return 0;
+    }
+}
+
+bool IsBlockCompressed(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::BC1UNorm:
+    case TextureFormat::BC1UNormSRGB:
+    case TextureFormat::BC3UNorm:
+    case TextureFormat::BC3UNormSRGB:
+    case TextureFormat::BC4UNorm:
+    case TextureFormat::BC5UNorm:
+    case TextureFormat::BC7UNorm:
+    case TextureFormat::BC7UNormSRGB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32_t GetBytesPerBlock(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::BC1UNorm:
+    case TextureFormat::BC1UNormSRGB:
+    case TextureFormat::BC4UNorm:
+        return 8;
+    case TextureFormat::BC3UNorm:
+    case TextureFormat::BC3UNormSRGB:
+    case TextureFormat::BC5UNorm:
+    case TextureFormat::BC7UNorm:
+    case TextureFormat::BC7UNormSRGB:
+        return 16;
+    default:
+        assert(false && "Not a block compressed format.");
+        return 0;
+    }
+}
+
+bool IsSRGB(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::RGBA8UNormSRGB:
+    case TextureFormat::BC1UNormSRGB:
+    case TextureFormat::BC3UNormSRGB:
+    case TextureFormat::BC7UNormSRGB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32_t GetMipLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+        ++levels;
+    }
+    return levels;
+}
+
+void TextureData::Initialize(TextureFormat format, uint32_t width, uint32_t height, uint32_t arraySize, uint32_t mipLevels)
+{
+    assert(width > 0 && height > 0 && arraySize > 0);
+
+    Format = format;
+    Width = width;
+    Height = height;
+    ArraySize = arraySize;
+    MipLevels = mipLevels ? std::min(mipLevels, GetMipLevelCount(width, height)) : GetMipLevelCount(width, height);
+    IsCubemap = false;
+
+    const bool blockCompressed = IsBlockCompressed(format);
+
+    Subresources.clear();
+    size_t offset = 0;
+    for (uint32_t slice = 0; slice < ArraySize; ++slice)
+    {
+        for (uint32_t mip = 0; mip < MipLevels; ++mip)
+        {
+            TextureSubresource subresource;
+            subresource.Width = std::max(width >> mip, 1u);
+            subresource.Height = std::max(height >> mip, 1u);
+            subresource.Offset = offset;
+            if (blockCompressed)
+            {
+                // Mips smaller than a block still take a whole block.
+                subresource.RowPitch = size_t((subresource.Width + 3) / 4) * GetBytesPerBlock(format);
+                subresource.SlicePitch = subresource.RowPitch * ((subresource.Height + 3) / 4);
+            }
+            else
+            {
+                subresource.RowPitch = size_t(subresource.Width) * GetBytesPerPixel(format);
+                subresource.SlicePitch = subresource.RowPitch * subresource.Height;
+            }
+            Subresources.push_back(subresource);
+
+            offset += subresource.SlicePitch;
+        }
+    }
+
+    Pixels.assign(offset, 0);
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    // Infinity and NaN.
+    if (exponent == 0xFF)
+    {
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+
+    int32_t halfExponent = int32_t(exponent) - 127 + 15;
+    if (halfExponent >= 0x1F)
+    {
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+
+    if (halfExponent <= 0)
+    {
+        // Denormal or zero.
+        if (halfExponent < -10)
+        {
+            return static_cast<uint16_t>(sign);
+        }
+
+        mantissa |= 0x800000;
+        uint32_t shift = uint32_t(14 - halfExponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+        {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    // A carry into the exponent is correct, including the overflow to infinity.
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+    {
+        ++half;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+float HalfToFloat(uint16_t value)
+{
+    uint32_t sign = uint32_t(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+
+    uint32_t bits;
+    if (exponent == 0)
+    {
+        // Denormals are exact in single precision.
+        float result = float(mantissa) * (1.0f / 16777216.0f);
+        return sign ? -result : result;
+    }
+    else if (exponent == 0x1F)
+    {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+float SRGBToLinear(float value)
+{
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float LinearToSRGB(float value)
+{
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
@@ -0,0 +1,153 @@
+#include <TextureFile.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+bool WriteTextureFile(const std::wstring& fileName, const std::vector<const TextureData*>& textures, uint64_t key)
+{
+    TextureFileHeader header = {};
+    header.Magic = TextureFileMagic;
+    header.Version = TextureFileVersion;
+    header.NumTextures = static_cast<uint32_t>(textures.size());
+    header.Key = key;
+    header.TextureOffset = sizeof(TextureFileHeader);
+
+    std::vector<TextureFileTexture> textureTable;
+    std::vector<TextureFileSubresource> subresourceTable;
+    for (const TextureData* pTexture : textures)
+    {
+        TextureFileTexture entry = {};
+        entry.Format = static_cast<uint32_t>(pTexture->Format);
+        entry.Width = pTexture->Width;
+        entry.Height = pTexture->Height;
+        entry.ArraySize = pTexture->ArraySize;
+        entry.MipLevels = pTexture->MipLevels;
+        entry.IsCubemap = pTexture->IsCubemap ? 1 : 0;
+        entry.FirstSubresource = static_cast<uint32_t>(subresourceTable.size());
+        entry.NumSubresources = static_cast<uint32_t>(pTexture->Subresources.size());
+        textureTable.push_back(entry);
+
+        for (const TextureSubresource& subresource : pTexture->Subresources)
+        {
+            // The offset is fixed up once the size of the tables is known.
+            subresourceTable.push_back({ subresource.Width, subresource.Height, subresource.Offset,
+                subresource.RowPitch, subresource.SlicePitch });
+        }
+    }
+
+    header.NumSubresources = static_cast<uint32_t>(subresourceTable.size());
+    header.SubresourceOffset = header.TextureOffset + sizeof(TextureFileTexture) * textureTable.size();
+
+    // Pixel data of each texture, aligned.
+    std::vector<uint64_t> dataOffsets;
+    uint64_t offset = header.SubresourceOffset + sizeof(TextureFileSubresource) * subresourceTable.size();
+    for (size_t t = 0; t < textures.size(); ++t)
+    {
+        offset = AlignUp(offset, TextureFileAlignment);
+        dataOffsets.push_back(offset);
+
+        const TextureFileTexture& entry = textureTable[t];
+        for (uint32_t s = 0; s < entry.NumSubresources; ++s)
+        {
+            subresourceTable[entry.FirstSubresource + s].Offset += offset;
+        }
+        offset += textures[t]->Pixels.size();
+    }
+    header.FileSize = offset;
+
+    std::ofstream file(std::filesystem::path(fileName), std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(textureTable.data()), sizeof(TextureFileTexture) * textureTable.size());
+    file.write(reinterpret_cast<const char*>(subresourceTable.data()), sizeof(TextureFileSubresource) * subresourceTable.size());
+
+    // The pixel data is written straight from the textures instead of being copied into one buffer first.
+    static const char Padding[TextureFileAlignment] = {};
+    uint64_t position = header.SubresourceOffset + sizeof(TextureFileSubresource) * subresourceTable.size();
+    for (size_t t = 0; t < textures.size(); ++t)
+    {
+        file.write(Padding, static_cast<std::streamsize>(dataOffsets[t] - position));
+        file.write(reinterpret_cast<const char*>(textures[t]->Pixels.data()), textures[t]->Pixels.size());
+        position = dataOffsets[t] + textures[t]->Pixels.size();
+    }
+
+    return static_cast<bool>(file);
+}
+
+TextureFile::TextureFile()
+{
+}
+
+TextureFile::~TextureFile()
+{
+    Close();
+}
+
+bool TextureFile::Open(const std::wstring& fileName)
+{
+    Close();
+
+    if (!m_File.Open(fileName) || !Validate())
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void TextureFile::Close()
+{
+    m_File.Close();
+}
+
+bool TextureFile::Validate() const
+{
+    const size_t size = m_File.GetSize();
+    if (size < sizeof(TextureFileHeader))
+    {
+        return false;
+    }
+
+    const TextureFileHeader& header = GetHeader();
+    if (header.Magic != TextureFileMagic || header.Version != TextureFileVersion || header.FileSize != size ||
+        header.TextureOffset + uint64_t(header.NumTextures) * sizeof(TextureFileTexture) > size ||
+        header.SubresourceOffset + uint64_t(header.NumSubresources) * sizeof(TextureFileSubresource) > size)
+    {
+        return false;
+    }
+
+    // Every subresource must lie inside the file, so the views can be used without further checks.
+    for (uint32_t t = 0; t < header.NumTextures; ++t)
+    {
+        const TextureFileTexture& texture = GetTexture(t);
+        if (uint64_t(texture.FirstSubresource) + texture.NumSubresources > header.NumSubresources ||
+            uint64_t(texture.ArraySize) * texture.MipLevels != texture.NumSubresources)
+        {
+            return false;
+        }
+
+        const TextureFileSubresource* pSubresources = GetSubresources(t);
+        for (uint32_t s = 0; s < texture.NumSubresources; ++s)
+        {
+            if (pSubresources[s].Offset > size || pSubresources[s].SlicePitch > size - pSubresources[s].Offset)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
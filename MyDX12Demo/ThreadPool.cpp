@@ -0,0 +1,138 @@
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(uint32_t numThreads)
+    : m_Stop(false)
+{
+    if (numThreads == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        numThreads = std::max(1u, hardwareThreads > 1 ? hardwareThreads - 1 : 1u);
+    }
+
+    m_Threads.reserve(numThreads);
+    for (uint32_t i = 0; i < numThreads; ++i)
+    {
+        m_Threads.emplace_back(&ThreadPool::WorkerThread, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Condition.notify_all();
+
+    for (std::thread& thread : m_Threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Tasks.push(std::move(task));
+    }
+    m_Condition.notify_one();
+}
+
+void ThreadPool::WorkerThread()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_Stop || !m_Tasks.empty(); });
+
+            // Drain the remaining tasks before stopping.
+            if (m_Tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop();
+        }
+
+        task();
+    }
+}
+
+void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // The state is shared with the helper tasks because a helper may only start
+    // running after the calling thread already finished all the work.
+    struct State
+    {
+        std::function<void(uint32_t)> func;
+        uint32_t count;
+        std::atomic<uint32_t> next;
+        std::atomic<uint32_t> completed;
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::exception_ptr exception;
+    };
+
+    auto state = std::make_shared<State>();
+    state->func = func;
+    state->count = count;
+    state->next = 0;
+    state->completed = 0;
+
+    auto work = [state]()
+    {
+        uint32_t index;
+        while ((index = state->next.fetch_add(1)) < state->count)
+        {
+            try
+            {
+                state->func(index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->exception)
+                {
+                    state->exception = std::current_exception();
+                }
+            }
+
+            if (state->completed.fetch_add(1) + 1 == state->count)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->condition.notify_all();
+            }
+        }
+    };
+
+    uint32_t numHelpers = std::min(GetNumThreads(), count - 1);
+    for (uint32_t i = 0; i < numHelpers; ++i)
+    {
+        Enqueue(work);
+    }
+
+    // 调用线程也参与工作
+    work();
+
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->condition.wait(lock, [&state]() { return state->completed.load() == state->count; });
+    }
+
+    if (state->exception)
+    {
+        std::rethrow_exception(state->exception);
+    }
+}
@@ -0,0 +1,136 @@
+#include <TransientResourcePlanner.h>
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace
+{
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+TransientResourcePlanner::TransientResourcePlanner()
+    : m_HeapSize(0)
+{
+}
+
+TransientResourcePlanner::~TransientResourcePlanner()
+{
+}
+
+void TransientResourcePlanner::Clear()
+{
+    m_Resources.clear();
+    m_Placements.clear();
+    m_HeapSize = 0;
+}
+
+uint32_t TransientResourcePlanner::AddResource(uint64_t size, uint64_t alignment, uint32_t firstPass, uint32_t lastPass)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "The alignment must be a power of two.");
+    assert(firstPass <= lastPass && "Invalid lifetime.");
+
+    m_Resources.push_back(Resource{ size, alignment, firstPass, lastPass });
+    return static_cast<uint32_t>(m_Resources.size() - 1);
+}
+
+bool TransientResourcePlanner::LifetimesOverlap(uint32_t a, uint32_t b) const
+{
+    return m_Resources[a].FirstPass <= m_Resources[b].LastPass && m_Resources[b].FirstPass <= m_Resources[a].LastPass;
+}
+
+bool TransientResourcePlanner::MemoryOverlaps(uint32_t a, uint32_t b) const
+{
+    return m_Placements[a].Offset < m_Placements[b].Offset + m_Resources[b].Size &&
+        m_Placements[b].Offset < m_Placements[a].Offset + m_Resources[a].Size;
+}
+
+void TransientResourcePlanner::Plan()
+{
+    const uint32_t numResources = GetNumResources();
+    m_Placements.assign(numResources, Placement());
+    m_HeapSize = 0;
+
+    // 大的先放. Equal sizes keep the pass order, so the result is deterministic.
+    std::vector<uint32_t> order(numResources);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+    {
+        return m_Resources[a].Size > m_Resources[b].Size;
+    });
+
+    std::vector<uint32_t> placed;
+    std::vector<uint32_t> conflicts;
+    for (uint32_t resource : order)
+    {
+        const Resource& desc = m_Resources[resource];
+
+        // The placed resources that are alive at the same time, by offset.
+        conflicts.clear();
+        for (uint32_t other : placed)
+        {
+            if (LifetimesOverlap(resource, other))
+            {
+                conflicts.push_back(other);
+            }
+        }
+        std::sort(conflicts.begin(), conflicts.end(), [this](uint32_t a, uint32_t b)
+        {
+            return m_Placements[a].Offset < m_Placements[b].Offset;
+        });
+
+        // First fit: the lowest gap between the conflicting ranges that is large enough.
+        uint64_t offset = 0;
+        for (uint32_t other : conflicts)
+        {
+            if (AlignUp(offset, desc.Alignment) + desc.Size <= m_Placements[other].Offset)
+            {
+                break;
+            }
+            offset = std::max(offset, m_Placements[other].Offset + m_Resources[other].Size);
+        }
+        offset = AlignUp(offset, desc.Alignment);
+
+        m_Placements[resource].Offset = offset;
+        m_HeapSize = std::max(m_HeapSize, offset + desc.Size);
+        placed.push_back(resource);
+    }
+
+    // The previous occupant of the memory of every resource, for the aliasing barriers.
+    for (uint32_t resource = 0; resource < numResources; ++resource)
+    {
+        uint32_t aliased = InvalidIndex;
+        for (uint32_t other = 0; other < numResources; ++other)
+        {
+            if (other == resource || m_Resources[other].LastPass >= m_Resources[resource].FirstPass ||
+                !MemoryOverlaps(resource, other))
+            {
+                continue;
+            }
+            if (aliased == InvalidIndex || m_Resources[other].LastPass > m_Resources[aliased].LastPass)
+            {
+                aliased = other;
+            }
+        }
+        m_Placements[resource].AliasedResource = aliased;
+    }
+}
+
+TransientResourcePlanner::Statistics TransientResourcePlanner::GetStatistics() const
+{
+    Statistics statistics;
+    statistics.NumResources = GetNumResources();
+    statistics.HeapSize = m_HeapSize;
+    for (uint32_t resource = 0; resource < GetNumResources(); ++resource)
+    {
+        statistics.SummedSize += m_Resources[resource].Size;
+        if (resource < m_Placements.size() && m_Placements[resource].AliasedResource != InvalidIndex)
+        {
+            ++statistics.NumAliasedResources;
+        }
+    }
+    return statistics;
+}
@@ -0,0 +1,224 @@
+#include <TransientResourcePool.h>
+#include <DX12LibPCH.h>
+
+namespace
+{
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    bool IsDepthStencil(const TransientTextureDesc& desc)
+    {
+        return (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) != 0;
+    }
+}
+
+bool TransientTextureDesc::operator==(const TransientTextureDesc& other) const
+{
+    if (Format != other.Format || Width != other.Width || Height != other.Height ||
+        SampleCount != other.SampleCount || Flags != other.Flags || ClearValue.Format != other.ClearValue.Format)
+    {
+        return false;
+    }
+
+    if (IsDepthStencil(*this))
+    {
+        return ClearValue.DepthStencil.Depth == other.ClearValue.DepthStencil.Depth &&
+            ClearValue.DepthStencil.Stencil == other.ClearValue.DepthStencil.Stencil;
+    }
+    return std::equal(ClearValue.Color, ClearValue.Color + 4, other.ClearValue.Color);
+}
+
+TransientResourcePool::TransientResourcePool(Microsoft::WRL::ComPtr<ID3D12Device2> device, std::shared_ptr<ResidencyManager> residencyManager)
+    : m_d3d12Device(device)
+    , m_ResidencyManager(residencyManager)
+    , m_HeapSize(0)
+    , m_HeapAlignment(0)
+    , m_LastFenceValue(0)
+    , m_NumCreatedResources(0)
+{
+}
+
+TransientResourcePool::~TransientResourcePool()
+{
+    // The owner makes sure the GPU is idle, everything can be released right away.
+    m_Requests.clear();
+    m_CachedResources.clear();
+    ReleaseRetiredObjects(~0ull);
+    if (m_Heap && m_ResidencyManager)
+    {
+        m_ResidencyManager->Untrack(m_Heap.Get());
+    }
+}
+
+void TransientResourcePool::BeginFrame()
+{
+    m_Requests.clear();
+}
+
+TransientResourcePool::Handle TransientResourcePool::Request(const TransientTextureDesc& desc, uint32_t firstPass, uint32_t lastPass)
+{
+    assert((desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0 &&
+        "Transient textures are render targets or depth stencil buffers.");
+
+    m_Requests.push_back(Request{ desc, firstPass, lastPass, nullptr });
+    return static_cast<Handle>(m_Requests.size() - 1);
+}
+
+D3D12_RESOURCE_DESC TransientResourcePool::GetResourceDesc(const TransientTextureDesc& desc) const
+{
+    return CD3DX12_RESOURCE_DESC::Tex2D(desc.Format, desc.Width, desc.Height, 1, 1, desc.SampleCount, 0, desc.Flags);
+}
+
+void TransientResourcePool::Compile(uint64_t completedFenceValue)
+{
+    ReleaseRetiredObjects(completedFenceValue);
+
+    // 计算别名布局
+    m_Planner.Clear();
+    uint64_t heapAlignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    for (const Request& request : m_Requests)
+    {
+        D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc(request.Desc);
+        D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = m_d3d12Device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+        m_Planner.AddResource(allocationInfo.SizeInBytes, allocationInfo.Alignment, request.FirstPass, request.LastPass);
+        heapAlignment = std::max<uint64_t>(heapAlignment, allocationInfo.Alignment);
+    }
+    m_Planner.Plan();
+
+    // The heap only grows. A new heap invalidates every cached resource, the old ones are
+    // released once the frames that use them are done.
+    if (!m_Requests.empty() && (m_Planner.GetHeapSize() > m_HeapSize || heapAlignment > m_HeapAlignment))
+    {
+        for (CachedResource& cached : m_CachedResources)
+        {
+            Retire(cached.Resource, false);
+        }
+        m_CachedResources.clear();
+        if (m_Heap)
+        {
+            Retire(m_Heap, true);
+            m_Heap.Reset();
+        }
+
+        D3D12_HEAP_DESC heapDesc = {};
+        heapDesc.SizeInBytes = AlignUp(m_Planner.GetHeapSize(), heapAlignment);
+        heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+        heapDesc.Alignment = heapAlignment;
+        heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+        ThrowIfFailed(m_d3d12Device->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_Heap)));
+        m_HeapSize = heapDesc.SizeInBytes;
+        m_HeapAlignment = heapAlignment;
+
+        if (m_ResidencyManager)
+        {
+            m_ResidencyManager->Track(m_Heap.Get(), m_HeapSize);
+        }
+    }
+
+    // 复用 the cached resources with the same description and offset.
+    for (CachedResource& cached : m_CachedResources)
+    {
+        cached.Claimed = false;
+    }
+
+    m_NumCreatedResources = 0;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_Requests.size()); ++i)
+    {
+        Request& request = m_Requests[i];
+        const uint64_t offset = m_Planner.GetPlacement(i).Offset;
+
+        auto it = std::find_if(m_CachedResources.begin(), m_CachedResources.end(), [&](const CachedResource& cached)
+        {
+            return !cached.Claimed && cached.Offset == offset && cached.Desc == request.Desc;
+        });
+        if (it != m_CachedResources.end())
+        {
+            it->Claimed = true;
+            request.Resource = it->Resource;
+            continue;
+        }
+
+        D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc(request.Desc);
+        D3D12_RESOURCE_STATES initialState = IsDepthStencil(request.Desc) ?
+            D3D12_RESOURCE_STATE_DEPTH_WRITE : D3D12_RESOURCE_STATE_RENDER_TARGET;
+        ThrowIfFailed(m_d3d12Device->CreatePlacedResource(m_Heap.Get(), offset, &resourceDesc, initialState,
+            request.Desc.ClearValue.Format != DXGI_FORMAT_UNKNOWN ? &request.Desc.ClearValue : nullptr,
+            IID_PPV_ARGS(&request.Resource)));
+
+        m_CachedResources.push_back(CachedResource{ request.Desc, offset, request.Resource, true });
+        ++m_NumCreatedResources;
+    }
+
+    // Resources that were not requested this frame.
+    for (auto it = m_CachedResources.begin(); it != m_CachedResources.end();)
+    {
+        if (!it->Claimed)
+        {
+            Retire(it->Resource, false);
+            it = m_CachedResources.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if (m_ResidencyManager && m_Heap)
+    {
+        m_ResidencyManager->MarkUsed(m_Heap.Get());
+    }
+}
+
+ID3D12Resource* TransientResourcePool::GetResource(Handle handle) const
+{
+    return m_Requests[handle].Resource.Get();
+}
+
+void TransientResourcePool::AliasingBarrier(ID3D12GraphicsCommandList2* commandList, Handle handle) const
+{
+    // Without an earlier texture in this frame the memory may still hold a texture of
+    // the previous frame, a null "before" resource covers any of them.
+    uint32_t aliased = m_Planner.GetPlacement(handle).AliasedResource;
+    ID3D12Resource* pResourceBefore = aliased != TransientResourcePlanner::InvalidIndex ? m_Requests[aliased].Resource.Get() : nullptr;
+
+    CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Aliasing(pResourceBefore, GetResource(handle));
+    commandList->ResourceBarrier(1, &barrier);
+}
+
+void TransientResourcePool::EndFrame(uint64_t fenceValue)
+{
+    m_LastFenceValue = fenceValue;
+}
+
+void TransientResourcePool::Retire(Microsoft::WRL::ComPtr<ID3D12Pageable> object, bool isHeap)
+{
+    m_RetiredObjects.push_back(RetiredObject{ m_LastFenceValue, object, isHeap });
+}
+
+void TransientResourcePool::ReleaseRetiredObjects(uint64_t completedFenceValue)
+{
+    while (!m_RetiredObjects.empty() && m_RetiredObjects.front().FenceValue <= completedFenceValue)
+    {
+        if (m_RetiredObjects.front().IsHeap && m_ResidencyManager)
+        {
+            m_ResidencyManager->Untrack(m_RetiredObjects.front().Object.Get());
+        }
+        m_RetiredObjects.pop_front();
+    }
+}
+
+TransientResourcePool::Statistics TransientResourcePool::GetStatistics() const
+{
+    TransientResourcePlanner::Statistics planStatistics = m_Planner.GetStatistics();
+
+    Statistics statistics;
+    statistics.NumTextures = planStatistics.NumResources;
+    statistics.NumAliasedTextures = planStatistics.NumAliasedResources;
+    statistics.PeakSize = planStatistics.HeapSize;
+    statistics.SummedSize = planStatistics.SummedSize;
+    statistics.HeapSize = m_HeapSize;
+    statistics.NumCreatedResources = m_NumCreatedResources;
+    return statistics;
+}
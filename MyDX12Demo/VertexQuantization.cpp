@@ -0,0 +1,144 @@
+#include <VertexQuantization.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <emmintrin.h> // SSE2
+
+namespace
+{
+    const float SNorm16Max = 32767.0f;
+
+    // Bounds with a zero extent (flat meshes) still need a valid scale.
+    const float MinQuantizationScale = 1e-6f;
+
+    __m128 LoadFloat3(const float* p, float w)
+    {
+        return _mm_setr_ps(p[0], p[1], p[2], w);
+    }
+
+    __m128 Clamp(__m128 v, __m128 minValue, __m128 maxValue)
+    {
+        return _mm_min_ps(_mm_max_ps(v, minValue), maxValue);
+    }
+}
+
+QuantizationBounds ComputeQuantizationBounds(const float* pPositions, size_t strideInBytes, size_t numVertices)
+{
+    const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(pPositions);
+
+    __m128 minPosition = _mm_set1_ps(INFINITY);
+    __m128 maxPosition = _mm_set1_ps(-INFINITY);
+    for (size_t i = 0; i < numVertices; ++i)
+    {
+        __m128 p = LoadFloat3(reinterpret_cast<const float*>(pBytes + i * strideInBytes), 0.0f);
+        minPosition = _mm_min_ps(minPosition, p);
+        maxPosition = _mm_max_ps(maxPosition, p);
+    }
+
+    float boundsMin[4], boundsMax[4];
+    _mm_storeu_ps(boundsMin, minPosition);
+    _mm_storeu_ps(boundsMax, maxPosition);
+
+    QuantizationBounds bounds;
+    for (int c = 0; c < 3; ++c)
+    {
+        if (numVertices == 0)
+        {
+            bounds.Scale[c] = 1.0f;
+            bounds.Bias[c] = 0.0f;
+            continue;
+        }
+
+        bounds.Bias[c] = (boundsMin[c] + boundsMax[c]) * 0.5f;
+        bounds.Scale[c] = std::max((boundsMax[c] - boundsMin[c]) * 0.5f, MinQuantizationScale);
+    }
+
+    return bounds;
+}
+
+void EncodeVertices(const float* pPositions, const float* pColors, size_t strideInBytes, size_t numVertices,
+    const QuantizationBounds& bounds, VertexPosColorPacked* pOut)
+{
+    const uint8_t* pPositionBytes = reinterpret_cast<const uint8_t*>(pPositions);
+    const uint8_t* pColorBytes = reinterpret_cast<const uint8_t*>(pColors);
+
+    const __m128 bias = LoadFloat3(bounds.Bias, 0.0f);
+    const __m128 invScale = _mm_div_ps(_mm_set1_ps(1.0f), LoadFloat3(bounds.Scale, 1.0f));
+    const __m128 snormMax = _mm_set1_ps(SNorm16Max);
+    const __m128 unormMax = _mm_set1_ps(255.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+
+    for (size_t i = 0; i < numVertices; ++i)
+    {
+        // Position: [-1, 1] relative to the bounds, rounded to nearest (the default MXCSR mode).
+        __m128 p = LoadFloat3(reinterpret_cast<const float*>(pPositionBytes + i * strideInBytes), 0.0f);
+        p = Clamp(_mm_mul_ps(_mm_sub_ps(p, bias), invScale), minusOne, one);
+        __m128i position = _mm_cvtps_epi32(_mm_mul_ps(p, snormMax));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(pOut[i].Position), _mm_packs_epi32(position, position));
+
+        // Color: alpha is always opaque.
+        __m128 c = pColors ? LoadFloat3(reinterpret_cast<const float*>(pColorBytes + i * strideInBytes), 1.0f) : one;
+        __m128i color = _mm_cvtps_epi32(_mm_mul_ps(Clamp(c, zero, one), unormMax));
+        color = _mm_packs_epi32(color, color);
+        color = _mm_packus_epi16(color, color);
+        int packedColor = _mm_cvtsi128_si32(color);
+        memcpy(pOut[i].Color, &packedColor, sizeof(packedColor));
+    }
+}
+
+void DecodePosition(const VertexPosColorPacked& vertex, const QuantizationBounds& bounds, float position[3])
+{
+    for (int c = 0; c < 3; ++c)
+    {
+        // SNORM to float conversion as defined by D3D: -32768 and -32767 both map to -1.
+        float snorm = std::max(vertex.Position[c] / SNorm16Max, -1.0f);
+        position[c] = snorm * bounds.Scale[c] + bounds.Bias[c];
+    }
+}
+
+void GetMaxQuantizationError(const QuantizationBounds& bounds, float error[3])
+{
+    for (int c = 0; c < 3; ++c)
+    {
+        // Half a quantization step plus the float rounding of the decode.
+        error[c] = 0.5f * bounds.Scale[c] / SNorm16Max + (std::abs(bounds.Bias[c]) + bounds.Scale[c]) * FLT_EPSILON;
+    }
+}
+
+bool QuantizeMesh(MeshData& mesh)
+{
+    const MeshVertexAttribute* pPosition = mesh.FindAttribute(MeshAttributeSemantic::Position);
+    const MeshVertexAttribute* pColor = mesh.FindAttribute(MeshAttributeSemantic::Color);
+    if (!pPosition || pPosition->Format != MeshFormatR32G32B32Float ||
+        (pColor && pColor->Format != MeshFormatR32G32B32Float))
+    {
+        return false;
+    }
+
+    size_t numVertices = mesh.GetVertexCount();
+    const float* pPositions = reinterpret_cast<const float*>(mesh.Vertices.data() + pPosition->Offset);
+    const float* pColors = pColor ? reinterpret_cast<const float*>(mesh.Vertices.data() + pColor->Offset) : nullptr;
+
+    QuantizationBounds bounds = ComputeQuantizationBounds(pPositions, mesh.VertexStride, numVertices);
+
+    std::vector<uint8_t> packedVertices(numVertices * sizeof(VertexPosColorPacked));
+    EncodeVertices(pPositions, pColors, mesh.VertexStride, numVertices, bounds,
+        reinterpret_cast<VertexPosColorPacked*>(packedVertices.data()));
+
+    mesh.VertexStride = sizeof(VertexPosColorPacked);
+    mesh.Attributes = {
+        { MeshAttributeSemantic::Position, MeshFormatR16G16B16A16SNorm, offsetof(VertexPosColorPacked, Position) },
+        { MeshAttributeSemantic::Color, MeshFormatR8G8B8A8UNorm, offsetof(VertexPosColorPacked, Color) },
+    };
+    mesh.Vertices = std::move(packedVertices);
+    std::copy(bounds.Scale, bounds.Scale + 3, mesh.PositionScale);
+    std::copy(bounds.Bias, bounds.Bias + 3, mesh.PositionBias);
+
+    return true;
+}
@@ -2,6 +2,7 @@
 #include <DX12LibPCH.h>
 #include <Application.h>
 #include <CommandQueue.h>
+#include <DescriptorViewCache.h>
 #include <Game.h>
 
 Window::Window(HWND hWnd, const std::wstring& windowName, int clientWidth, int clientHeight, bool vSync )
@@ -18,8 +19,6 @@ Window::Window(HWND hWnd, const std::wstring& windowName, int clientWidth, int c
     m_IsTearingSupported = app.IsTearingSupported();
 
     m_dxgiSwapChain = CreateSwapChain();
-    m_d3d12RTVDescriptorHeap = app.CreateDescriptorHeap(BufferCount, D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    m_RTVDescriptorSize = app.GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
     UpdateRenderTargetViews();
 }
@@ -322,27 +321,23 @@ Microsoft::WRL::ComPtr<IDXGISwapChain4> Window::CreateSwapChain()
 // Update the render target views for the swapchain back buffers.
 void Window::UpdateRenderTargetViews()
 {
-    auto device = Application::Get().GetDevice();
-
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_d3d12RTVDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+    auto descriptorViewCache = Application::Get().GetDescriptorViewCache();
 
     for (int i = 0; i < BufferCount; ++i)
     {
         ComPtr<ID3D12Resource> backBuffer;
         ThrowIfFailed(m_dxgiSwapChain->GetBuffer(i, IID_PPV_ARGS(&backBuffer)));
 
-        device->CreateRenderTargetView(backBuffer.Get(), nullptr, rtvHandle);
+        // The views of the old buffers were dropped when ResizeBuffers destroyed them.
+        descriptorViewCache->GetRenderTargetView(backBuffer.Get());
 
         m_d3d12BackBuffers[i] = backBuffer;
-
-        rtvHandle.Offset(m_RTVDescriptorSize);
     }
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE Window::GetCurrentRenderTargetView() const
 {
-    return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_d3d12RTVDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
-        m_CurrentBackBufferIndex, m_RTVDescriptorSize);
+    return Application::Get().GetDescriptorViewCache()->GetRenderTargetView(m_d3d12BackBuffers[m_CurrentBackBufferIndex].Get());
 }
 
 Microsoft::WRL::ComPtr<ID3D12Resource> Window::GetCurrentBackBuffer() const
@@ -3,6 +3,8 @@
 */
 #pragma once
 
+#include <DescriptorAllocator.h>
+
 #include <d3d12.h>
 #include <dxgi1_6.h>
 #include <wrl.h>
@@ -12,7 +14,12 @@
 
 class Window;
 class Game;
+class BindlessDescriptorTable;
 class CommandQueue;
+class DescriptorViewCache;
+class GPUMemoryAllocator;
+class PipelineStateCache;
+class ResidencyManager;
 
 class Application
 {
@@ -88,12 +95,50 @@ public:
      */
     std::shared_ptr<CommandQueue> GetCommandQueue(D3D12_COMMAND_LIST_TYPE type = D3D12_COMMAND_LIST_TYPE_DIRECT) const;
 
+    /**
+     * 获取GPU内存分配器，用于在默认堆中创建放置资源。
+     */
+    std::shared_ptr<GPUMemoryAllocator> GetMemoryAllocator() const;
+
+    /**
+     * 获取显存驻留管理器. Call PrepareSubmission and Submitted around the direct queue submissions.
+     */
+    std::shared_ptr<ResidencyManager> GetResidencyManager() const;
+
     // Flush all command queues.
     void Flush();
 
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(UINT numDescriptors, D3D12_DESCRIPTOR_HEAP_TYPE type);
     UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const;
 
+    /**
+     * 分配CPU描述符 from the shared descriptor allocator of the heap type.
+     * The allocation must be released before the application is destroyed.
+     */
+    DescriptorAllocation AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors = 1);
+
+    /**
+     * Call after each submission on the direct queue with its fence value: descriptors
+     * freed since the last call are reused once that fence value is completed.
+     */
+    void ReleaseStaleDescriptors(uint64_t fenceValue, uint64_t completedFenceValue);
+
+    /**
+     * 获取无绑定描述符表, the shader visible heap for ResourceDescriptorHeap indexing.
+     * Returns nullptr if the device does not support shader model 6.6.
+     */
+    std::shared_ptr<BindlessDescriptorTable> GetBindlessDescriptorTable() const;
+
+    /**
+     * 获取描述符视图缓存, returns the existing CPU descriptor for a resource and view description.
+     */
+    std::shared_ptr<DescriptorViewCache> GetDescriptorViewCache() const;
+
+    /**
+     * 获取管线状态缓存, persisted in PipelineCache.bin in the working directory like the shaders.
+     */
+    std::shared_ptr<PipelineStateCache> GetPipelineStateCache() const;
+
 protected:
 
     // Create an application instance.
@@ -119,6 +164,15 @@ private:
     std::shared_ptr<CommandQueue> m_ComputeCommandQueue;
     std::shared_ptr<CommandQueue> m_CopyCommandQueue;
 
+    std::shared_ptr<ResidencyManager> m_ResidencyManager;
+    std::shared_ptr<GPUMemoryAllocator> m_MemoryAllocator;
+
+    std::unique_ptr<DescriptorAllocator> m_DescriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+    std::shared_ptr<BindlessDescriptorTable> m_BindlessDescriptorTable;
+    // Declared after the descriptor allocators, its descriptors are freed first.
+    std::shared_ptr<DescriptorViewCache> m_DescriptorViewCache;
+    std::shared_ptr<PipelineStateCache> m_PipelineStateCache;
+
     bool m_TearingSupported;
 
 };
\ No newline at end of file
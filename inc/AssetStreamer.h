@@ -0,0 +1,113 @@
+/**
+* Streams buffer data to the GPU on the copy queue without blocking the render loop.
+*
+* Load requests can be issued from any thread. Files are read on I/O worker
+* threads, and Update (called once per frame on the render thread) packs the
+* finished reads into one upload buffer, records the copies in a single copy
+* command list and makes the direct queue wait for it on the GPU. Completion
+* callbacks are invoked from Update once the resource can be used by command
+* lists submitted to the direct queue.
+*/
+#pragma once
+
+#include <GPUMemoryAllocator.h>
+#include <ThreadPool.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class CommandQueue;
+
+class AssetStreamer
+{
+public:
+    struct Buffer
+    {
+        // nullptr if the request failed (for example the file could not be read).
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+        // The owner of the buffer is responsible for freeing the allocation.
+        GPUMemoryAllocator::Allocation Allocation;
+        size_t SizeInBytes = 0;
+    };
+
+    using CompletionCallback = std::function<void(const Buffer&)>;
+
+    /**
+     * @param numIOThreads The number of threads used to read files.
+     * @param maxBatchSize Upload budget of a single Update call. A larger request is uploaded on its own.
+     */
+    AssetStreamer(std::shared_ptr<CommandQueue> copyQueue, std::shared_ptr<CommandQueue> directQueue,
+        uint32_t numIOThreads = 2, size_t maxBatchSize = 32 * 1024 * 1024);
+    virtual ~AssetStreamer();
+
+    /**
+     * 从文件异步加载缓冲区。 Thread safe.
+     */
+    void LoadBuffer(const std::wstring& fileName, CompletionCallback callback);
+
+    /**
+     * Upload a buffer from memory. The data is copied before the function returns. Thread safe.
+     */
+    void LoadBuffer(const void* bufferData, size_t sizeInBytes, CompletionCallback callback);
+
+    /**
+     * Upload a buffer from memory without copying it first, for example straight from a
+     * memory mapped file. owner keeps the memory alive until the data has been written
+     * to the upload buffer. Thread safe.
+     */
+    void LoadBuffer(std::shared_ptr<const void> owner, const void* bufferData, size_t sizeInBytes, CompletionCallback callback);
+
+    /**
+     * Submit pending uploads, retire finished batches and invoke completion callbacks.
+     * Must be called from the thread that owns the command queues.
+     */
+    void Update();
+
+    // Number of requests that have not invoked their completion callback yet.
+    size_t GetNumPendingRequests() const;
+
+private:
+    AssetStreamer(const AssetStreamer& copy) = delete;
+    AssetStreamer& operator=(const AssetStreamer& other) = delete;
+
+    struct Request
+    {
+        // Points to Data or to memory kept alive by Owner.
+        const uint8_t* pData = nullptr;
+        size_t SizeInBytes = 0;
+        std::vector<uint8_t> Data;
+        std::shared_ptr<const void> Owner;
+        CompletionCallback Callback;
+        bool Failed = false;
+    };
+
+    struct UploadBatch
+    {
+        uint64_t FenceValue;
+        // The upload buffer must stay alive until the copy queue reaches FenceValue.
+        Microsoft::WRL::ComPtr<ID3D12Resource> UploadBuffer;
+    };
+
+    void SubmitBatch(std::vector< std::unique_ptr<Request> >& requests);
+
+    std::shared_ptr<CommandQueue> m_CopyQueue;
+    std::shared_ptr<CommandQueue> m_DirectQueue;
+    size_t m_MaxBatchSize;
+
+    // Requests whose data is available and that are waiting to be uploaded.
+    std::deque< std::unique_ptr<Request> > m_ReadyRequests;
+    std::deque<UploadBatch> m_InFlightBatches;
+    size_t m_NumPendingRequests;
+    mutable std::mutex m_Mutex;
+
+    // Declared last so the I/O threads are joined before the queues above are destroyed.
+    ThreadPool m_IOThreads;
+};
@@ -0,0 +1,81 @@
+/**
+* One large shader visible CBV/SRV/UAV descriptor heap for bindless rendering.
+*
+* Every view gets a stable slot in the heap for its whole lifetime and is
+* referenced by a 32-bit generational handle (BindlessHandleAllocator). Shaders
+* index ResourceDescriptorHeap (shader model 6.6) with the handle, which is
+* passed as a root constant or stored in a buffer, see shaders/Bindless.hlsli.
+* Materials therefore need no descriptor tables of their own and nothing is
+* copied or rebound per draw.
+*
+* The root signature must have RootSignatureFlags and the heap must be bound with
+* Bind. It replaces the CBV/SRV/UAV heap of a DynamicDescriptorHeap, the two can
+* not be used by the same command list. Thread safe.
+*/
+#pragma once
+
+#include <BindlessHandleAllocator.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <mutex>
+
+class BindlessDescriptorTable
+{
+public:
+    static const D3D12_ROOT_SIGNATURE_FLAGS RootSignatureFlags = D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED;
+    static const uint32_t InvalidHandle = BindlessHandleAllocator::InvalidHandle;
+
+    // True if the device supports shader model 6.6 dynamic resources.
+    static bool IsSupported(ID3D12Device2* device);
+
+    BindlessDescriptorTable(Microsoft::WRL::ComPtr<ID3D12Device2> device, uint32_t numDescriptors = 65536);
+    virtual ~BindlessDescriptorTable();
+
+    /**
+     * 创建视图 in a new slot. Returns InvalidHandle if the table is full.
+     */
+    uint32_t CreateShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc);
+    uint32_t CreateUnorderedAccessView(ID3D12Resource* pResource, ID3D12Resource* pCounterResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc);
+    uint32_t CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc);
+    // Copy an existing CPU descriptor (for example from the descriptor allocator) to a new slot.
+    uint32_t CopyDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor);
+
+    /**
+     * 释放句柄. The slot is reused once the submission passed to the next
+     * ReleaseStaleDescriptors has completed. Freeing a handle twice is detected.
+     */
+    void Free(uint32_t handle);
+
+    // See DescriptorAllocator::ReleaseStaleDescriptors.
+    void ReleaseStaleDescriptors(uint64_t fenceValue, uint64_t completedFenceValue);
+
+    bool IsValid(uint32_t handle) const;
+
+    // Set the heap on a command list before drawing with bindless shaders.
+    void Bind(ID3D12GraphicsCommandList2* commandList) const;
+
+    ID3D12DescriptorHeap* GetHeap() const
+    {
+        return m_d3d12DescriptorHeap.Get();
+    }
+
+    BindlessHandleAllocator::Statistics GetStatistics() const;
+
+private:
+    BindlessDescriptorTable(const BindlessDescriptorTable& copy) = delete;
+    BindlessDescriptorTable& operator=(const BindlessDescriptorTable& other) = delete;
+
+    // Allocate a slot and return its CPU descriptor.
+    uint32_t AllocateSlot(D3D12_CPU_DESCRIPTOR_HANDLE& descriptor);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_d3d12DescriptorHeap;
+    D3D12_CPU_DESCRIPTOR_HANDLE m_BaseDescriptor;
+    uint32_t m_DescriptorSize;
+
+    BindlessHandleAllocator m_Handles;
+    mutable std::mutex m_Mutex;
+};
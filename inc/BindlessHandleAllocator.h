@@ -0,0 +1,108 @@
+/**
+* Generational handles for the slots of the bindless descriptor table.
+*
+* Pure C++ like DescriptorRangeAllocator. A handle is a 32-bit value with the
+* slot index in the low IndexBits bits and the generation of the slot in the
+* high bits. Freeing a handle increments the generation of its slot, so a
+* handle that is used after it was freed (or freed twice) no longer matches
+* its slot and is rejected by IsValid and Free, even after the slot is reused.
+*
+* Freed slots are reused only after the submission that may still read the
+* descriptor has completed (Submitted / ReleaseStale, like the descriptor
+* allocator), in FIFO order so a slot is not reused sooner than necessary.
+* A slot whose generation is exhausted is retired for good.
+*/
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class BindlessHandleAllocator
+{
+public:
+    static const uint32_t IndexBits = 20;
+    static const uint32_t GenerationBits = 32 - IndexBits;
+    static const uint32_t IndexMask = (1u << IndexBits) - 1;
+    static const uint32_t MaxGeneration = (1u << GenerationBits) - 1;
+    // Its index is beyond the largest capacity, so it is never valid.
+    static const uint32_t InvalidHandle = ~0u;
+    static const uint32_t MaxCapacity = IndexMask;
+
+    struct Statistics
+    {
+        uint32_t Capacity = 0;
+        uint32_t NumAllocated = 0;
+        // Freed slots waiting for their fence value.
+        uint32_t NumStale = 0;
+        // Slots whose generation is exhausted.
+        uint32_t NumRetired = 0;
+    };
+
+    // @param capacity Number of slots, at most MaxCapacity.
+    explicit BindlessHandleAllocator(uint32_t capacity);
+    virtual ~BindlessHandleAllocator();
+
+    // @returns A new handle or InvalidHandle if all slots are in use.
+    uint32_t Allocate();
+
+    /**
+     * 释放句柄. The slot is reused after the next Submitted and ReleaseStale.
+     * @returns false (and does nothing) if the handle is not valid, for example freed before.
+     */
+    bool Free(uint32_t handle);
+
+    // The slots freed since the last call may be used by the submission that signals fenceValue.
+    void Submitted(uint64_t fenceValue);
+
+    // Make the slots of completed submissions available again.
+    void ReleaseStale(uint64_t completedFenceValue);
+
+    // True if the handle was returned by Allocate and has not been freed.
+    bool IsValid(uint32_t handle) const;
+
+    static uint32_t GetIndex(uint32_t handle)
+    {
+        return handle & IndexMask;
+    }
+
+    static uint32_t GetGeneration(uint32_t handle)
+    {
+        return handle >> IndexBits;
+    }
+
+    static uint32_t MakeHandle(uint32_t index, uint32_t generation)
+    {
+        return (generation << IndexBits) | index;
+    }
+
+    uint32_t GetCapacity() const
+    {
+        return m_Capacity;
+    }
+
+    Statistics GetStatistics() const;
+
+private:
+    struct Slot
+    {
+        uint16_t Generation;
+        bool Allocated;
+    };
+
+    struct StaleSlot
+    {
+        uint32_t Index;
+        uint64_t FenceValue;
+    };
+
+    uint32_t m_Capacity;
+    uint32_t m_NumAllocated;
+    uint32_t m_NumRetired;
+
+    // Slots are created on first use.
+    std::vector<Slot> m_Slots;
+    std::deque<uint32_t> m_FreeSlots;
+    std::vector<uint32_t> m_PendingSlots;
+    std::deque<StaleSlot> m_StaleSlots;
+};
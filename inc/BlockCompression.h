@@ -0,0 +1,80 @@
+/**
+* CPU block compression (BC1, BC3, BC4, BC5 and BC7) for the offline texture tools.
+*
+* The output is a TextureData in the block compressed format with the same
+* mips and slices as the source. Its subresources are in D3D12 order with
+* RowPitch / SlicePitch per row of blocks, so they can be passed to
+* UpdateSubresources as D3D12_SUBRESOURCE_DATA without any conversion.
+*
+* The endpoint fitting (principal axis, least squares refinement) and the
+* index search work on a block in structure of arrays layout with SSE. The
+* texture is split into tiles of blocks that the thread pool hands out one at a
+* time, largest subresources first, so the slow tiles of a BC7 encode do not
+* leave the other threads idle at the end.
+*/
+#pragma once
+
+#include <TextureData.h>
+
+#include <cstdint>
+
+class ThreadPool;
+
+enum class BC7Quality
+{
+    // Mode 6 only.
+    Fast,
+    // Mode 6, and modes 1 and 3 with the 8 most promising partitions for opaque blocks.
+    Normal,
+    // Mode 6, and modes 1 and 3 with all 64 partitions for opaque blocks. More refinement iterations.
+    High,
+};
+
+struct BlockCompressionSettings
+{
+    BC7Quality Quality = BC7Quality::Normal;
+};
+
+/**
+ * Block encoders. pPixels are the 16 RGBA8 texels of the block in row major order.
+ * BC1 encodes texels with alpha < 128 as transparent, BC4 encodes the red channel,
+ * BC5 red and green.
+ */
+void EncodeBC1Block(const uint8_t* pPixels, uint8_t* pBlock);
+void EncodeBC3Block(const uint8_t* pPixels, uint8_t* pBlock);
+void EncodeBC4Block(const uint8_t* pPixels, uint8_t* pBlock);
+void EncodeBC5Block(const uint8_t* pPixels, uint8_t* pBlock);
+void EncodeBC7Block(const uint8_t* pPixels, BC7Quality quality, uint8_t* pBlock);
+
+/**
+ * Block decoders, used to validate the encoders. BC4 and BC5 decode like the
+ * GPU does: the missing channels are 0 and alpha is 255.
+ * DecodeBC7Block only supports the modes written by EncodeBC7Block (1, 3 and 6).
+ * @returns false if the block uses an unsupported mode, pPixels is zeroed in that case.
+ */
+void DecodeBC1Block(const uint8_t* pBlock, uint8_t* pPixels);
+void DecodeBC3Block(const uint8_t* pBlock, uint8_t* pPixels);
+void DecodeBC4Block(const uint8_t* pBlock, uint8_t* pPixels);
+void DecodeBC5Block(const uint8_t* pBlock, uint8_t* pPixels);
+bool DecodeBC7Block(const uint8_t* pBlock, uint8_t* pPixels);
+
+/**
+ * 压缩纹理: compress every subresource of an RGBA8 (UNORM or UNORM_SRGB) texture.
+ * The texel values are compressed as stored, pick an _SRGB format for sRGB sources.
+ * @returns false if the source or the destination format is not supported.
+ */
+bool CompressTexture(const TextureData& source, TextureFormat format, TextureData& dest,
+    const BlockCompressionSettings& settings = BlockCompressionSettings(), ThreadPool* pThreadPool = nullptr);
+
+/**
+ * Decompress a block compressed texture to RGBA8 (UNORM_SRGB for the sRGB formats).
+ * @returns false if the format is not supported or a BC7 block uses an unsupported mode.
+ */
+bool DecompressTexture(const TextureData& source, TextureData& dest, ThreadPool* pThreadPool = nullptr);
+
+/**
+ * Peak signal to noise ratio in dB between two RGBA8 textures of the same size,
+ * over the channels in channelMask (bit 0 red .. bit 3 alpha).
+ * @returns Infinity for identical textures, a negative value if the textures do not match in size.
+ */
+double ComputePSNR(const TextureData& reference, const TextureData& image, uint32_t channelMask = 0xF);
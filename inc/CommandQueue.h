@@ -24,8 +24,14 @@ public:
       
       uint64_t Signal();
       bool IsFenceComplete(uint64_t fenceValue);
+      uint64_t GetCompletedFenceValue() const;
       void WaitForFenceValue(uint64_t fenceValue);
       void Flush();
+
+      // 在GPU上等待另一个命令队列到达指定的栅栏值（不阻塞CPU）。
+      // Commands submitted to this queue after the call will not start before
+      // the other queue has signaled fenceValue.
+      void Wait(const CommandQueue& other, uint64_t fenceValue);
       
       Microsoft::WRL::ComPtr<ID3D12CommandQueue> GetD3D12CommandQueue() const;
 
@@ -1,6 +1,16 @@
 #pragma once
  
+#include <AssetStreamer.h>
+#include <DynamicDescriptorHeap.h>
 #include <Game.h>
+#include <GPUMemoryAllocator.h>
+#include <LODSelector.h>
+#include <PipelineBuilder.h>
+#include <RenderGraph.h>
+#include <ShaderLibrary.h>
+#include <ThreadPool.h>
+#include <TransientResourcePool.h>
+#include <VertexQuantization.h>
 #include <Window.h>
  
 #include <DirectXMath.h>
@@ -48,11 +58,6 @@ protected:
     virtual void OnResize(ResizeEventArgs& e) override;
 private:
      // 辅助函数
-     // 转换资源
-     void TransitionResource(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList,
-         Microsoft::WRL::ComPtr<ID3D12Resource> resource,
-         D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState);
-
      // 清除RTV
     void ClearRTV(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList,
         D3D12_CPU_DESCRIPTOR_HANDLE rtv, FLOAT* clearColor);
@@ -61,35 +66,60 @@ private:
     void ClearDepth(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList,
         D3D12_CPU_DESCRIPTOR_HANDLE dsv, FLOAT depth = 1.0f );
 
-     // 创建GPU缓冲区
-    void UpdateBufferResource(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList,
-        ID3D12Resource** pDestinationResource, ID3D12Resource** pIntermediateResource,
-        size_t numElements, size_t elementSize, const void* bufferData, 
-        D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE );
+    // 请求本帧的深度缓冲区 from the transient pool.
+    TransientResourcePool::Handle PrepareDepthBuffer(uint64_t completedFenceValue);
 
-    // 调整深度缓冲区的大小。
-    void ResizeDepthBuffer(int width, int height);
+    // 加载 BRDF LUT: build or map its cache file and upload it on the copy queue.
+    bool LoadBRDFLUT();
 
     uint64_t m_FenceValues[Window::BufferCount] = {};
 
+    std::unique_ptr<ThreadPool> m_ThreadPool;
+
+    // Streams the cube geometry on the copy queue.
+    std::unique_ptr<AssetStreamer> m_AssetStreamer;
+
     // Vertex buffer for the cube.
     Microsoft::WRL::ComPtr<ID3D12Resource> m_VertexBuffer;
+    GPUMemoryAllocator::Allocation m_VertexBufferAllocation;
     D3D12_VERTEX_BUFFER_VIEW m_VertexBufferView;
     // Index buffer for the cube.
     Microsoft::WRL::ComPtr<ID3D12Resource> m_IndexBuffer;
+    GPUMemoryAllocator::Allocation m_IndexBufferAllocation;
     D3D12_INDEX_BUFFER_VIEW m_IndexBufferView;
+    DXGI_FORMAT m_IndexFormat;
+    // Submeshes of the cube and their levels of detail (see MeshFileLOD).
+    std::vector<MeshFileSubmesh> m_Submeshes;
+    std::vector<MeshFileLOD> m_LODs;
+    // One instance per submesh, selected in OnUpdate.
+    LODSelector m_LODSelector;
+    // Maps the quantized vertex positions back to object space.
+    QuantizationBounds m_QuantizationBounds;
+
+    // Split sum BRDF lookup table of the image based lighting (see GenerateBRDFLUT), RG16F.
+    // The cube shader does not sample it yet, the IBL pass binds m_BRDFLUTView and marks the allocation used.
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_BRDFLUT;
+    GPUMemoryAllocator::Allocation m_BRDFLUTAllocation;
+    D3D12_CPU_DESCRIPTOR_HANDLE m_BRDFLUTView;
     
-    // Depth buffer.
-    Microsoft::WRL::ComPtr<ID3D12Resource> m_DepthBuffer;
-    // Descriptor heap for depth buffer.
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_DSVHeap;
+    // Screen sized targets (the depth buffer), reused across frames and aliased in one heap.
+    std::unique_ptr<TransientResourcePool> m_TransientResourcePool;
+    // 渲染图, built again every frame
+    RenderGraph m_RenderGraph;
 
  
     // 根签名
     Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature;
+    // Copies the descriptor tables of the root signature to the shader visible heap at each draw.
+    std::unique_ptr<DynamicDescriptorHeap> m_DynamicDescriptorHeap;
     
     // PSO
     Microsoft::WRL::ComPtr<ID3D12PipelineState> m_PipelineState;
+    // Shaders of the pipeline states, reloaded when the .cso files change.
+    std::shared_ptr<ShaderLibrary> m_ShaderLibrary;
+    // Builds m_PipelineState and rebuilds it when its shaders are reloaded.
+    std::unique_ptr<PipelineBuilder> m_PipelineBuilder;
+    uint32_t m_PipelineStateIndex = 0;
     
     D3D12_VIEWPORT m_Viewport;
     D3D12_RECT m_ScissorRect;
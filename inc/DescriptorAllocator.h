@@ -0,0 +1,167 @@
+/**
+* Allocator for CPU visible descriptors (RTV, DSV and the staging CBV/SRV/UAV and sampler descriptors).
+*
+* Instead of one descriptor heap per user, descriptors are handed out as
+* ranges of fixed size pages (descriptor heaps). The ranges of a page are
+* managed by DescriptorRangeAllocator, so freed ranges are merged with their
+* neighbours and are only reused after the GPU is done with the frame that
+* freed them. A range larger than the page size gets its own page.
+*
+* Thread safe. Single descriptors, the common case, are taken from a small
+* per-thread cache that is refilled with one range at a time, so most
+* allocations do not take the lock.
+*/
+#pragma once
+
+#include <DescriptorRangeAllocator.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class DescriptorAllocatorPage;
+
+/**
+ * 一段连续的CPU描述符. Move only, the range is freed when the allocation is
+ * destroyed. It must not outlive its DescriptorAllocator.
+ */
+class DescriptorAllocation
+{
+public:
+    // A null allocation.
+    DescriptorAllocation();
+    DescriptorAllocation(D3D12_CPU_DESCRIPTOR_HANDLE descriptor, uint32_t offset, uint32_t numHandles,
+        uint32_t descriptorSize, DescriptorAllocatorPage* pPage);
+    ~DescriptorAllocation();
+
+    DescriptorAllocation(DescriptorAllocation&& allocation);
+    DescriptorAllocation& operator=(DescriptorAllocation&& other);
+
+    bool IsNull() const
+    {
+        return m_Descriptor.ptr == 0;
+    }
+
+    // Get a descriptor at a particular offset in the allocation.
+    D3D12_CPU_DESCRIPTOR_HANDLE GetDescriptorHandle(uint32_t offset = 0) const;
+
+    uint32_t GetNumHandles() const
+    {
+        return m_NumHandles;
+    }
+
+private:
+    DescriptorAllocation(const DescriptorAllocation& copy) = delete;
+    DescriptorAllocation& operator=(const DescriptorAllocation& other) = delete;
+
+    // The allocator hands out parts of the ranges in its thread caches.
+    friend class DescriptorAllocator;
+
+    // Return the range to its page.
+    void Free();
+
+    D3D12_CPU_DESCRIPTOR_HANDLE m_Descriptor;
+    uint32_t m_Offset;
+    uint32_t m_NumHandles;
+    uint32_t m_DescriptorSize;
+    DescriptorAllocatorPage* m_Page;
+};
+
+// A CPU visible descriptor heap and the ranges allocated in it.
+// Shared with the thread caches, which return their rest when the thread exits.
+class DescriptorAllocatorPage : public std::enable_shared_from_this<DescriptorAllocatorPage>
+{
+public:
+    DescriptorAllocatorPage(Microsoft::WRL::ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors);
+    virtual ~DescriptorAllocatorPage();
+
+    // Returns a null allocation if the page has no free range that is large enough.
+    DescriptorAllocation Allocate(uint32_t numDescriptors);
+
+    void Free(uint32_t offset, uint32_t numDescriptors);
+    void Submitted(uint64_t fenceValue);
+    void ReleaseStale(uint64_t completedFenceValue);
+
+    bool HasSpace(uint32_t numDescriptors) const;
+    uint32_t GetNumDescriptors() const;
+    uint32_t GetNumFreeDescriptors() const;
+    uint32_t GetNumStaleDescriptors() const;
+
+private:
+    DescriptorAllocatorPage(const DescriptorAllocatorPage& copy) = delete;
+    DescriptorAllocatorPage& operator=(const DescriptorAllocatorPage& other) = delete;
+
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_d3d12DescriptorHeap;
+    D3D12_CPU_DESCRIPTOR_HANDLE m_BaseDescriptor;
+    uint32_t m_DescriptorSize;
+
+    DescriptorRangeAllocator m_Ranges;
+    mutable std::mutex m_Mutex;
+};
+
+class DescriptorAllocator
+{
+public:
+    struct Statistics
+    {
+        uint32_t NumPages = 0;
+        uint32_t NumDescriptors = 0;
+        uint32_t NumFreeDescriptors = 0;
+        // Freed descriptors waiting for their fence value.
+        uint32_t NumStaleDescriptors = 0;
+    };
+
+    /**
+     * @param numDescriptorsPerPage Size of the descriptor heap pages.
+     */
+    DescriptorAllocator(Microsoft::WRL::ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerPage = 256);
+    virtual ~DescriptorAllocator();
+
+    /**
+     * 分配一段连续的描述符. Thread safe.
+     */
+    DescriptorAllocation Allocate(uint32_t numDescriptors = 1);
+
+    /**
+     * The descriptors freed since the last call may still be referenced by the
+     * submission that signals fenceValue (the direct queue). Ranges of earlier
+     * submissions that are completed are made reusable.
+     */
+    void ReleaseStaleDescriptors(uint64_t fenceValue, uint64_t completedFenceValue);
+
+    /**
+     * Return the cached descriptors of the calling thread, for worker threads
+     * that stop allocating. Otherwise they are returned when the thread exits.
+     */
+    void FlushThreadCache();
+
+    D3D12_DESCRIPTOR_HEAP_TYPE GetType() const
+    {
+        return m_HeapType;
+    }
+
+    Statistics GetStatistics() const;
+
+private:
+    DescriptorAllocator(const DescriptorAllocator& copy) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator& other) = delete;
+
+    // Descriptors taken from the pages per refill of a thread cache.
+    static const uint32_t ThreadCacheSize = 32;
+
+    DescriptorAllocation AllocateFromPages(uint32_t numDescriptors);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
+    D3D12_DESCRIPTOR_HEAP_TYPE m_HeapType;
+    uint32_t m_NumDescriptorsPerPage;
+    uint32_t m_DescriptorSize;
+    // Identifies the allocator in the thread caches, never reused.
+    uint64_t m_Id;
+
+    std::vector< std::shared_ptr<DescriptorAllocatorPage> > m_Pages;
+    mutable std::mutex m_Mutex;
+};
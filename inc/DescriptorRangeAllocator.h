@@ -0,0 +1,104 @@
+/**
+* Free list allocator for ranges of descriptors in one descriptor heap page.
+*
+* Pure C++ like HeapAllocator, so it can be driven without a device. Free
+* ranges are kept in two maps, by offset (to merge a freed range with its
+* neighbours) and by size (best fit allocation). Freed ranges are not reused
+* right away: they wait until the submission that may still reference them
+* has completed.
+*
+* 释放流程: Free puts the range in the pending list, Submitted tags all pending
+* ranges with the fence value of the next submission, and ReleaseStale returns
+* the ranges whose fence value has completed to the free list.
+*/
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+class DescriptorRangeAllocator
+{
+public:
+    static const uint32_t InvalidOffset = ~0u;
+
+    explicit DescriptorRangeAllocator(uint32_t numDescriptors);
+    virtual ~DescriptorRangeAllocator();
+
+    /**
+     * 分配一段连续的描述符.
+     * @returns The offset of the range or InvalidOffset if no free range is large enough.
+     */
+    uint32_t Allocate(uint32_t numDescriptors);
+
+    // Free a range returned by Allocate (or a part of it). It is reused after the next Submitted and ReleaseStale.
+    void Free(uint32_t offset, uint32_t numDescriptors);
+
+    // The ranges freed since the last call may be used by the submission that signals fenceValue.
+    void Submitted(uint64_t fenceValue);
+
+    // Return the ranges whose submission has completed to the free list.
+    void ReleaseStale(uint64_t completedFenceValue);
+
+    uint32_t GetNumDescriptors() const
+    {
+        return m_NumDescriptors;
+    }
+
+    uint32_t GetNumFreeDescriptors() const
+    {
+        return m_NumFreeDescriptors;
+    }
+
+    // Descriptors that were freed but are not reusable yet.
+    uint32_t GetNumStaleDescriptors() const
+    {
+        return m_NumStaleDescriptors;
+    }
+
+    uint32_t GetNumFreeRanges() const
+    {
+        return static_cast<uint32_t>(m_FreeListByOffset.size());
+    }
+
+    uint32_t GetLargestFreeRange() const;
+
+    bool HasSpace(uint32_t numDescriptors) const
+    {
+        return m_FreeListBySize.lower_bound(numDescriptors) != m_FreeListBySize.end();
+    }
+
+private:
+    struct FreeRange;
+    using FreeListByOffset = std::map<uint32_t, FreeRange>;
+    using FreeListBySize = std::multimap<uint32_t, FreeListByOffset::iterator>;
+
+    struct FreeRange
+    {
+        uint32_t Size;
+        FreeListBySize::iterator BySize;
+    };
+
+    struct StaleRange
+    {
+        uint32_t Offset;
+        uint32_t Size;
+        uint64_t FenceValue;
+    };
+
+    void AddFreeRange(uint32_t offset, uint32_t numDescriptors);
+    void FreeRangeNow(uint32_t offset, uint32_t numDescriptors);
+
+    uint32_t m_NumDescriptors;
+    uint32_t m_NumFreeDescriptors;
+    uint32_t m_NumStaleDescriptors;
+
+    FreeListByOffset m_FreeListByOffset;
+    FreeListBySize m_FreeListBySize;
+
+    // Freed since the last Submitted.
+    std::vector<StaleRange> m_PendingRanges;
+    // Ordered by fence value.
+    std::deque<StaleRange> m_StaleRanges;
+};
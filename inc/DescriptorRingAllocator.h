@@ -0,0 +1,60 @@
+/**
+* Ring buffer allocation of the shader visible descriptors of the dynamic descriptor heap.
+*
+* Pure C++ like DescriptorRangeAllocator. Descriptors are allocated in order
+* from the head of the ring and freed in order: Submitted tags everything
+* allocated since the last call with the fence value of the submission that
+* uses it, ReleaseCompleted frees it once that fence value is completed. A
+* range never wraps, the end of the ring is skipped when it is too short.
+*/
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+class DescriptorRingAllocator
+{
+public:
+    static const uint32_t InvalidOffset = ~0u;
+
+    explicit DescriptorRingAllocator(uint32_t numDescriptors);
+    virtual ~DescriptorRingAllocator();
+
+    /**
+     * 从环的头部分配一段连续的描述符.
+     * @returns The offset of the range or InvalidOffset if the ring is full.
+     */
+    uint32_t Allocate(uint32_t numDescriptors);
+
+    // Everything allocated since the last call is used by the submission that signals fenceValue.
+    void Submitted(uint64_t fenceValue);
+
+    // Free the descriptors of the submissions that are completed.
+    void ReleaseCompleted(uint64_t completedFenceValue);
+
+    uint32_t GetNumDescriptors() const
+    {
+        return m_NumDescriptors;
+    }
+
+    // Descriptors in use, including the skipped end of the ring.
+    uint32_t GetNumUsedDescriptors() const
+    {
+        return m_NumUsedDescriptors;
+    }
+
+private:
+    struct Submission
+    {
+        uint64_t FenceValue;
+        uint32_t NumDescriptors;
+    };
+
+    uint32_t m_NumDescriptors;
+    uint32_t m_Head;
+    uint32_t m_NumUsedDescriptors;
+    // Allocated since the last Submitted.
+    uint32_t m_NumPendingDescriptors;
+
+    std::deque<Submission> m_Submissions;
+};
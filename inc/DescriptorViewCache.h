@@ -0,0 +1,146 @@
+/**
+* Cache of CPU descriptors (SRV, UAV, RTV and DSV) keyed by resource and view description.
+*
+* Asking for a view that was created before returns the existing descriptor
+* instead of allocating and creating a new one, so code can request its views
+* every frame (after a resize, while streaming) without creating descriptors.
+* The key hashes the fields of the view description that its ViewDimension
+* uses, like Hash.h recommends, so padding and unused union members do not
+* cause misses. A null description (the default view) is a key of its own.
+*
+* The views of a resource are dropped automatically when the resource is
+* destroyed: the cache attaches a small private data object to the resource
+* (SetPrivateDataInterface) that is released together with the resource.
+* The descriptors are returned to the descriptor allocator, which reuses them
+* once the GPU is done with the frame. Thread safe.
+*
+* The descriptors come from AllocateDescriptorsFunc (the application's
+* descriptor allocators), so the cache can be tested without the application.
+*/
+#pragma once
+
+#include <DescriptorAllocator.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class DescriptorViewCache
+{
+public:
+    struct Statistics
+    {
+        uint32_t NumViews = 0;
+        uint32_t NumResources = 0;
+        // Totals over the lifetime of the cache.
+        uint64_t NumHits = 0;
+        uint64_t NumMisses = 0;
+        uint64_t NumInvalidatedViews = 0;
+    };
+
+    // Allocates one CPU descriptor of the heap type. Called with the cache locked.
+    using AllocateDescriptorsFunc = std::function<DescriptorAllocation(D3D12_DESCRIPTOR_HEAP_TYPE)>;
+
+    DescriptorViewCache(Microsoft::WRL::ComPtr<ID3D12Device2> device, AllocateDescriptorsFunc allocateDescriptors);
+    virtual ~DescriptorViewCache();
+
+    /**
+     * 获取视图, creating it on first use. pDesc may be nullptr for the default view.
+     * The descriptor stays valid until the resource is destroyed or Invalidate is called.
+     */
+    D3D12_CPU_DESCRIPTOR_HANDLE GetShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc = nullptr);
+    // UAVs without a counter resource.
+    D3D12_CPU_DESCRIPTOR_HANDLE GetUnorderedAccessView(ID3D12Resource* pResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc = nullptr);
+    D3D12_CPU_DESCRIPTOR_HANDLE GetRenderTargetView(ID3D12Resource* pResource, const D3D12_RENDER_TARGET_VIEW_DESC* pDesc = nullptr);
+    D3D12_CPU_DESCRIPTOR_HANDLE GetDepthStencilView(ID3D12Resource* pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc = nullptr);
+
+    // Drop the views of a resource, for example before its contents are replaced in place.
+    void Invalidate(ID3D12Resource* pResource);
+
+    Statistics GetStatistics() const;
+
+private:
+    DescriptorViewCache(const DescriptorViewCache& copy) = delete;
+    DescriptorViewCache& operator=(const DescriptorViewCache& other) = delete;
+
+    enum ViewType : uint32_t
+    {
+        ShaderResourceView,
+        UnorderedAccessView,
+        RenderTargetView,
+        DepthStencilView,
+    };
+
+    // The resource and the used fields of the view description.
+    struct ViewKey
+    {
+        static const uint32_t MaxFields = 12;
+
+        ID3D12Resource* pResource = nullptr;
+        ViewType Type = ShaderResourceView;
+        bool HasDesc = false;
+        uint32_t NumFields = 0;
+        uint64_t Fields[MaxFields] = {};
+        uint64_t Hash = 0;
+
+        void AddField(uint64_t value);
+        void AddField(float value);
+        void Finalize();
+
+        bool operator==(const ViewKey& other) const;
+    };
+
+    struct ViewKeyHash
+    {
+        size_t operator()(const ViewKey& key) const
+        {
+            return static_cast<size_t>(key.Hash);
+        }
+    };
+
+    /**
+     * Shared with the release notifiers of the resources, which may outlive the cache.
+     * Mutex protects the whole cache.
+     */
+    struct Tracker
+    {
+        std::mutex Mutex;
+        DescriptorViewCache* pCache = nullptr;
+    };
+
+    friend class ResourceReleaseNotifier;
+
+    static ViewKey MakeKey(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc);
+    static ViewKey MakeKey(ID3D12Resource* pResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc);
+    static ViewKey MakeKey(ID3D12Resource* pResource, const D3D12_RENDER_TARGET_VIEW_DESC* pDesc);
+    static ViewKey MakeKey(ID3D12Resource* pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc);
+
+    /**
+     * Look up the key. On a miss allocate a descriptor of heapType and call
+     * createView with it. Called with the tracker mutex held.
+     */
+    template<typename CreateViewFunc>
+    D3D12_CPU_DESCRIPTOR_HANDLE GetView(const ViewKey& key, D3D12_DESCRIPTOR_HEAP_TYPE heapType, CreateViewFunc&& createView);
+
+    // Attach the release notifier the first time a resource is seen.
+    void TrackResource(ID3D12Resource* pResource);
+    void InvalidateLocked(ID3D12Resource* pResource);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
+    AllocateDescriptorsFunc m_AllocateDescriptors;
+    // Identifies the private data of this cache on the resources.
+    GUID m_PrivateDataGuid;
+    std::shared_ptr<Tracker> m_Tracker;
+
+    std::unordered_map<ViewKey, DescriptorAllocation, ViewKeyHash> m_Views;
+    // The cached views of every resource, for invalidation.
+    std::unordered_map< ID3D12Resource*, std::vector<ViewKey> > m_ResourceViews;
+
+    Statistics m_Statistics;
+};
@@ -0,0 +1,141 @@
+/**
+* Stages CPU descriptors for the descriptor tables of a root signature and
+* copies them to a shader visible descriptor heap right before a draw or dispatch.
+*
+* One instance per command list (and heap type). StageDescriptors only records
+* the CPU descriptor handles in a cache and marks the root parameter dirty.
+* CommitStagedDescriptorsForDraw / ForDispatch copies the descriptors of the
+* dirty tables, and only those, to the shader visible ring with one batched
+* CopyDescriptors call and sets the root descriptor tables. Descriptor tables
+* that did not change keep the shader visible copy of the previous draw.
+*
+* The shader visible descriptors are allocated from a ring (DescriptorRingAllocator)
+* that is recycled by fence value: call Submitted after executing the command list
+* and BeginCommandList before recording the next one. When the ring is full a
+* larger one is created, the old heap is released when the GPU is done with it.
+*/
+#pragma once
+
+#include <DescriptorRingAllocator.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+class DynamicDescriptorHeap
+{
+public:
+    struct Statistics
+    {
+        // Totals over the lifetime of the heap.
+        uint64_t NumCommits = 0;
+        uint64_t NumCopiedDescriptors = 0;
+        // CopyDescriptors source ranges, contiguous staged descriptors are copied as one range.
+        uint64_t NumCopiedRanges = 0;
+        uint32_t NumDescriptors = 0;
+        uint32_t NumUsedDescriptors = 0;
+    };
+
+    /**
+     * @param heapType D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV or D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER.
+     * @param numDescriptors Initial size of the shader visible ring.
+     */
+    DynamicDescriptorHeap(Microsoft::WRL::ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t numDescriptors = 1024);
+    virtual ~DynamicDescriptorHeap();
+
+    /**
+     * 配对的堆: the heap of the other shader visible type used by the same command list.
+     * SetDescriptorHeaps replaces both heaps, so both are bound together.
+     */
+    void SetPairedHeap(DynamicDescriptorHeap* pPairedHeap);
+
+    /**
+     * Read the descriptor table layout of the root signature that is (about to be)
+     * set on the command list. Clears the staged descriptors.
+     */
+    void ParseRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& rootSignatureDesc);
+
+    /**
+     * 暂存描述符: copy numDescriptors contiguous CPU descriptors starting at srcDescriptor
+     * to the table of rootParameterIndex at offset. The source descriptors are read at commit.
+     */
+    void StageDescriptors(uint32_t rootParameterIndex, uint32_t offset, uint32_t numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor);
+
+    // Copy the dirty tables to the shader visible heap and set them on the command list.
+    void CommitStagedDescriptorsForDraw(ID3D12GraphicsCommandList2* commandList);
+    void CommitStagedDescriptorsForDispatch(ID3D12GraphicsCommandList2* commandList);
+
+    /**
+     * Call before recording a command list: the heap is bound again at the next commit and
+     * the shader visible descriptors of completed submissions are reused.
+     */
+    void BeginCommandList(uint64_t completedFenceValue);
+
+    // The command list was executed and signals fenceValue.
+    void Submitted(uint64_t fenceValue);
+
+    ID3D12DescriptorHeap* GetHeap() const
+    {
+        return m_d3d12DescriptorHeap.Get();
+    }
+
+    Statistics GetStatistics() const;
+
+private:
+    DynamicDescriptorHeap(const DynamicDescriptorHeap& copy) = delete;
+    DynamicDescriptorHeap& operator=(const DynamicDescriptorHeap& other) = delete;
+
+    // 根签名最多 64 DWORDs, so at most 64 descriptor tables.
+    static const uint32_t MaxDescriptorTables = 64;
+
+    struct DescriptorTableCache
+    {
+        uint32_t NumDescriptors = 0;
+        // Offset in m_DescriptorHandleCache.
+        uint32_t BaseOffset = 0;
+    };
+
+    using SetRootTableFunc = std::function<void(ID3D12GraphicsCommandList2*, UINT, D3D12_GPU_DESCRIPTOR_HANDLE)>;
+
+    void CommitStagedDescriptors(ID3D12GraphicsCommandList2* commandList, const SetRootTableFunc& setRootTable);
+    void CreateHeap(uint32_t numDescriptors);
+    void BindHeaps(ID3D12GraphicsCommandList2* commandList);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
+    D3D12_DESCRIPTOR_HEAP_TYPE m_HeapType;
+    uint32_t m_DescriptorSize;
+
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_d3d12DescriptorHeap;
+    D3D12_CPU_DESCRIPTOR_HANDLE m_BaseCPUDescriptor;
+    D3D12_GPU_DESCRIPTOR_HANDLE m_BaseGPUDescriptor;
+    DescriptorRingAllocator m_Ring;
+    DynamicDescriptorHeap* m_PairedHeap;
+    bool m_HeapBound;
+
+    // Heaps replaced by a larger ring, released once FenceValue is completed.
+    struct RetiredHeap
+    {
+        uint64_t FenceValue;
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> Heap;
+    };
+    // Replaced while recording the current command list, its fence value is not known yet.
+    std::vector< Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> > m_PendingRetiredHeaps;
+    std::deque<RetiredHeap> m_RetiredHeaps;
+
+    DescriptorTableCache m_DescriptorTableCache[MaxDescriptorTables];
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_DescriptorHandleCache;
+    // Root parameters that are descriptor tables of this heap type, and the ones that changed.
+    uint64_t m_DescriptorTableBitMask;
+    uint64_t m_StaleDescriptorTableBitMask;
+
+    // Scratch arrays of the batched copy.
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_SrcDescriptorRanges;
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_DstDescriptorRanges;
+    std::vector<UINT> m_DescriptorRangeSizes;
+
+    Statistics m_Statistics;
+};
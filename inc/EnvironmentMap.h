@@ -0,0 +1,128 @@
+/**
+* CPU precomputation of the image based lighting maps.
+*
+* An HDR panorama (equirectangular) is converted to an environment cubemap,
+* which is then prefiltered with the GGX distribution for the specular term
+* (one roughness per mip) and convolved with the cosine lobe for the diffuse
+* irradiance. BuildIBLCache stores the three cubemaps in a TextureFile keyed
+* by the source and the settings, so only the first run pays for the
+* precomputation; later runs map the cache and upload the faces directly.
+*
+* The environment independent half of the split sum, the BRDF integration
+* lookup table, has its own cache (BuildBRDFLUTCache) shared by all environments.
+*
+* Cubemap faces follow D3D12: +X, -X, +Y, -Y, +Z, -Z with v pointing down.
+* All outputs are RGBA16F cubemaps with alpha 1.
+*/
+#pragma once
+
+#include <TextureData.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+class ThreadPool;
+
+// Bump when the precomputation changes, so old caches are rebuilt.
+const uint32_t IBLCacheVersion = 2;
+
+// Textures of an IBL cache file.
+const uint32_t IBLEnvironmentTexture = 0;
+const uint32_t IBLSpecularTexture = 1;
+const uint32_t IBLIrradianceTexture = 2;
+
+// Bump when the BRDF integration changes, so old lookup tables are rebuilt.
+const uint32_t BRDFLUTCacheVersion = 1;
+
+struct IBLSettings
+{
+    // Face size of the environment cubemap, which has a full mip chain.
+    uint32_t EnvironmentSize = 512;
+    // Face size of mip 0 of the prefiltered specular cubemap.
+    uint32_t SpecularSize = 128;
+    // Mip m of the specular cubemap has the roughness m / (SpecularMipLevels - 1).
+    uint32_t SpecularMipLevels = 6;
+    // GGX importance samples per texel.
+    uint32_t SpecularSampleCount = 256;
+    uint32_t IrradianceSize = 32;
+};
+
+struct BRDFLUTSettings
+{
+    // The lookup table is Size x Size texels.
+    uint32_t Size = 128;
+    // GGX importance samples per texel.
+    uint32_t SampleCount = 1024;
+};
+
+/**
+ * Normalized direction through a point of a cube face.
+ * @param u, v Face coordinates in [-1, 1], v points down.
+ */
+void GetCubemapDirection(uint32_t face, float u, float v, float* pDirection);
+
+/**
+ * Face and texture coordinates in [0, 1] of a (not necessarily normalized) direction.
+ */
+void GetCubemapFaceCoordinates(const float* pDirection, uint32_t& face, float& u, float& v);
+
+// Solid angle covered by texel (x, y) of a face with size x size texels.
+float GetCubemapTexelSolidAngle(uint32_t x, uint32_t y, uint32_t size);
+
+/**
+ * Normalized direction of a panorama texture coordinate in [0, 1].
+ * v = 0 is straight up (+Y), u = 0.5 looks down -Z.
+ */
+void GetPanoramaDirection(float u, float v, float* pDirection);
+void GetPanoramaCoordinates(const float* pDirection, float& u, float& v);
+
+/**
+ * 全景图转立方体贴图. The panorama must be RGBA32F or RGBA16F.
+ * The cubemap gets a full mip chain, the mips are 2x2 box filtered.
+ */
+bool PanoramaToCubemap(const TextureData& panorama, uint32_t faceSize, TextureData& cubemap, ThreadPool* pThreadPool = nullptr);
+
+/**
+ * GGX prefiltering of an environment cubemap (RGBA32F or RGBA16F with mips) for
+ * the split sum approximation. Uses filtered importance sampling: every sample reads
+ * the environment mip that matches its solid angle, so few samples are noise free.
+ */
+bool PrefilterSpecular(const TextureData& environment, uint32_t faceSize, uint32_t mipLevels, uint32_t sampleCount,
+    TextureData& specular, ThreadPool* pThreadPool = nullptr);
+
+/**
+ * Diffuse irradiance of an environment cubemap: the cosine weighted integral of the
+ * radiance over the hemisphere divided by pi, so a constant environment gives back
+ * its radiance and the shader only multiplies by the albedo.
+ */
+bool ComputeIrradiance(const TextureData& environment, uint32_t faceSize, TextureData& irradiance, ThreadPool* pThreadPool = nullptr);
+
+// Key of an IBL cache built from the given source (for example HashFileIdentity of the panorama).
+uint64_t ComputeIBLCacheKey(uint64_t sourceKey, const IBLSettings& settings);
+
+/**
+ * Make sure the cache file holds the IBL maps of the source. If the cache is
+ * missing or was built from another source or with other settings, the panorama
+ * is loaded with loadPanorama and the maps are computed and written.
+ * Open the cache with a TextureFile afterwards, see IBLEnvironmentTexture.
+ */
+bool BuildIBLCache(const std::wstring& cacheFileName, uint64_t sourceKey, const std::function<bool(TextureData&)>& loadPanorama,
+    const IBLSettings& settings = IBLSettings(), ThreadPool* pThreadPool = nullptr);
+
+/**
+ * 预计算 split sum BRDF lookup table for the GGX specular term, RG16F.
+ * u = NdotV and v = roughness (top row smooth), both sampled at the texel centers.
+ * R is the scale and G the bias of F0: specular = prefiltered * (F0 * R + G).
+ */
+bool GenerateBRDFLUT(const BRDFLUTSettings& settings, TextureData& lut, ThreadPool* pThreadPool = nullptr);
+
+uint64_t ComputeBRDFLUTCacheKey(const BRDFLUTSettings& settings);
+
+/**
+ * Make sure the cache file holds the BRDF lookup table for the settings, generating and
+ * writing it if the file is missing or outdated. Map it with a TextureFile afterwards,
+ * the table is texture 0 and can be uploaded straight from the mapped view.
+ */
+bool BuildBRDFLUTCache(const std::wstring& cacheFileName, const BRDFLUTSettings& settings = BRDFLUTSettings(),
+    ThreadPool* pThreadPool = nullptr);
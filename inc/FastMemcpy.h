@@ -0,0 +1,64 @@
+/**
+* Copy routines for writing into upload heaps.
+*
+* Upload heaps are write-combined memory: the CPU should write them
+* sequentially and never read them back. The routines here use non-temporal
+* (streaming) stores, which bypass the cache and avoid polluting it with data
+* that is only ever read by the GPU. Large subresources are split across a
+* thread pool.
+*/
+#pragma once
+
+#include <d3d12.h>
+
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+/**
+ * memcpy using non-temporal stores (AVX when the CPU supports it, SSE2 otherwise).
+ * The destination does not need to be aligned.
+ */
+void StreamingMemcpy(void* pDest, const void* pSrc, size_t sizeInBytes);
+
+/**
+ * Copy numSlices * numRows rows of rowSizeInBytes bytes between two pitched layouts.
+ * Copies larger than a few hundred kilobytes are split over the thread pool
+ * (if one is given).
+ */
+void CopyRows(void* pDest, size_t destRowPitch, size_t destSlicePitch,
+    const void* pSrc, size_t srcRowPitch, size_t srcSlicePitch,
+    size_t rowSizeInBytes, uint32_t numRows, uint32_t numSlices,
+    ThreadPool* pThreadPool = nullptr);
+
+/**
+ * Drop-in replacement for MemcpySubresource (d3dx12.h) using CopyRows.
+ */
+inline void MemcpySubresourceFast(
+    const D3D12_MEMCPY_DEST* pDest,
+    const D3D12_SUBRESOURCE_DATA* pSrc,
+    SIZE_T RowSizeInBytes,
+    UINT NumRows,
+    UINT NumSlices,
+    ThreadPool* pThreadPool = nullptr)
+{
+    CopyRows(pDest->pData, pDest->RowPitch, pDest->SlicePitch,
+        pSrc->pData, static_cast<size_t>(pSrc->RowPitch), static_cast<size_t>(pSrc->SlicePitch),
+        RowSizeInBytes, NumRows, NumSlices, pThreadPool);
+}
+
+/**
+ * Same as the heap-allocating UpdateSubresources in d3dx12.h but copies the
+ * subresources with MemcpySubresourceFast, in parallel if a thread pool is given.
+ * @returns The required intermediate size or 0 on failure.
+ */
+UINT64 UpdateSubresourcesFast(
+    ID3D12GraphicsCommandList* pCmdList,
+    ID3D12Resource* pDestinationResource,
+    ID3D12Resource* pIntermediate,
+    UINT64 IntermediateOffset,
+    UINT FirstSubresource,
+    UINT NumSubresources,
+    const D3D12_SUBRESOURCE_DATA* pSrcData,
+    ThreadPool* pThreadPool = nullptr);
@@ -0,0 +1,74 @@
+/**
+* Watches files for changes, used for hot reloading.
+*
+* The directories of the watched files are observed with the change
+* notifications of the OS (FindFirstChangeNotification on Windows, inotify
+* otherwise). A notification only marks its directory, PollChanges then
+* compares the size and last write time (HashFileIdentity) of the files in it,
+* so unrelated files and repeated notifications for the same save are ignored.
+* Directories for which no notification could be set up are checked on every
+* poll instead. Not thread safe, poll from one thread.
+*
+* A file that is still being written must not be reported, the reader would see
+* a truncated file and the end of the write would be lost. inotify only reports
+* closed and moved files, and on every platform a change is only reported once
+* the size and last write time stayed the same for one poll.
+*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class FileWatcher
+{
+public:
+    FileWatcher();
+    virtual ~FileWatcher();
+
+    // 监视文件. Watching a file twice has no effect.
+    void Watch(const std::wstring& fileName);
+
+    bool IsWatching(const std::wstring& fileName) const;
+
+    /**
+     * 检查更改 without blocking.
+     * @returns The files that were written, created or replaced since they were
+     * watched or since they were last reported, in the order they were watched.
+     * A change is reported by the second poll that sees it.
+     */
+    std::vector<std::wstring> PollChanges();
+
+private:
+    FileWatcher(const FileWatcher& copy) = delete;
+    FileWatcher& operator=(const FileWatcher& other) = delete;
+
+    struct WatchedFile
+    {
+        std::wstring FileName;
+        // Identity of the last reported version.
+        uint64_t Identity;
+        // Identity of a new version seen by the last poll, 0 if none. Reported when the next poll sees it again.
+        uint64_t PendingIdentity;
+        uint32_t Directory;
+    };
+
+    struct WatchedDirectory
+    {
+        std::wstring Path;
+        // Change notification handle on Windows, inotify watch descriptor + 1 otherwise. Null if polled.
+        void* hNotification;
+        bool Changed;
+    };
+
+    // Index of the directory in m_Directories, starts observing it the first time.
+    uint32_t FindOrAddDirectory(const std::wstring& path);
+    // Mark the directories that received a notification.
+    void ReadNotifications();
+
+    std::vector<WatchedFile> m_Files;
+    std::vector<WatchedDirectory> m_Directories;
+
+    // inotify instance (descriptor + 1), unused on Windows.
+    void* m_hInotify;
+};
@@ -0,0 +1,90 @@
+/**
+* Allocates GPU resources as placed resources in large ID3D12Heaps instead of
+* giving every resource its own implicit heap (CreateCommittedResource).
+*
+* With a residency manager the heaps are tracked as its pageable objects: the
+* users mark the allocations they access with MarkUsed before each submission.
+*/
+#pragma once
+
+#include <HeapAllocator.h>
+#include <ResidencyManager.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <memory>
+#include <mutex>
+
+class GPUMemoryAllocator
+{
+public:
+    // Resource heap tier 1 hardware requires buffers, render target/depth stencil
+    // textures and all other textures to be placed in separate heaps.
+    enum class HeapCategory
+    {
+        Buffers,
+        NonRTDSTextures,
+        RTDSTextures,
+        NumCategories
+    };
+
+    // Heap alignment classes. MSAA textures require 4MB alignment.
+    enum class AlignmentClass
+    {
+        Default, // D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT (64KB)
+        MSAA,    // D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT (4MB)
+        NumClasses
+    };
+
+    struct Allocation
+    {
+        HeapCategory Category = HeapCategory::Buffers;
+        AlignmentClass Alignment = AlignmentClass::Default;
+        HeapAllocator::Allocation Block;
+
+        bool IsValid() const { return Block.IsValid(); }
+    };
+
+    /**
+     * @param heapSize The size of the heaps that are created for every category.
+     * @param residencyManager Optional, tracks the residency of the heaps.
+     */
+    GPUMemoryAllocator(Microsoft::WRL::ComPtr<ID3D12Device2> device, uint64_t heapSize = 64ull * 1024 * 1024,
+        std::shared_ptr<ResidencyManager> residencyManager = nullptr);
+    virtual ~GPUMemoryAllocator();
+
+    /**
+     * 在默认堆中创建一个放置资源。
+     * @param allocation Receives the heap block the resource was placed in. Pass it to Free
+     * once the GPU has finished using the resource.
+     */
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateResource(const D3D12_RESOURCE_DESC& resourceDesc,
+        D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* pClearValue, Allocation& allocation);
+
+    /**
+     * Return the heap block of a resource. The resource must no longer be referenced by the GPU.
+     */
+    void Free(Allocation& allocation);
+
+    /**
+     * The resource of the allocation is used by the next submission on the direct queue,
+     * see ResidencyManager::MarkUsed. Does nothing without a residency manager.
+     */
+    void MarkUsed(const Allocation& allocation);
+
+    HeapAllocator::Statistics GetStatistics(HeapCategory category, AlignmentClass alignment) const;
+
+    // Statistics summed over all categories and alignment classes.
+    HeapAllocator::Statistics GetStatistics() const;
+
+private:
+    HeapAllocator& GetHeapAllocator(HeapCategory category, AlignmentClass alignment) const;
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
+    std::shared_ptr<ResidencyManager> m_ResidencyManager;
+
+    std::unique_ptr<HeapAllocator> m_HeapAllocators[static_cast<int>(HeapCategory::NumCategories)][static_cast<int>(AlignmentClass::NumClasses)];
+
+    mutable std::mutex m_Mutex;
+};
@@ -0,0 +1,59 @@
+/**
+* 64-bit FNV-1a hashing, used for the keys of the offline caches.
+*
+* Hash the fields of a struct one by one, hashing the whole struct would
+* include the padding bytes.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+const uint64_t HashOffsetBasis = 14695981039346656037ULL;
+const uint64_t HashPrime = 1099511628211ULL;
+
+inline uint64_t HashBytes(const void* pData, size_t size, uint64_t hash = HashOffsetBasis)
+{
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= pBytes[i];
+        hash *= HashPrime;
+    }
+    return hash;
+}
+
+template<typename T>
+inline uint64_t HashValue(const T& value, uint64_t hash = HashOffsetBasis)
+{
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Hash the fields of structs one by one.");
+    return HashBytes(&value, sizeof(T), hash);
+}
+
+/**
+ * Key of a source file for cache invalidation: its path, size and last write time.
+ * Cheap compared to hashing the contents, returns 0 if the file does not exist.
+ */
+inline uint64_t HashFileIdentity(const std::wstring& fileName)
+{
+    std::error_code error;
+    std::filesystem::path path(fileName);
+    uint64_t size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        return 0;
+    }
+    int64_t writeTime = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    if (error)
+    {
+        return 0;
+    }
+
+    uint64_t hash = HashBytes(fileName.data(), fileName.size() * sizeof(wchar_t));
+    hash = HashValue(size, hash);
+    return HashValue(writeTime, hash);
+}
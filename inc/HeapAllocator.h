@@ -0,0 +1,168 @@
+/**
+* Heap suballocation core used by the GPU memory allocator.
+*
+* This file is pure C++ (no D3D12 types) so the placement policy can be
+* exercised with fake heaps. The heap handles are opaque pointers that are
+* produced and destroyed by user supplied callbacks.
+*/
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Binary buddy allocator over a single contiguous range [0, size).
+ * Every block is a power of two multiple of the minimum block size and is
+ * naturally aligned to its own size, so any alignment up to the block size
+ * is satisfied without padding.
+ */
+class BuddyAllocator
+{
+public:
+    static const uint64_t InvalidOffset = ~0ull;
+
+    /**
+     * @param size Total size of the range. Must be a power of two multiple of minBlockSize.
+     * @param minBlockSize The smallest block that will be handed out (power of two).
+     */
+    BuddyAllocator(uint64_t size, uint64_t minBlockSize);
+
+    /**
+     * 分配一个满足大小和对齐要求的块。
+     * @returns The offset of the block or InvalidOffset if the range is exhausted.
+     */
+    uint64_t Allocate(uint64_t size, uint64_t alignment = 0);
+
+    /**
+     * Release a block previously returned by Allocate and merge it with its free buddies.
+     */
+    void Free(uint64_t offset);
+
+    uint64_t GetSize() const { return m_Size; }
+    // Bytes covered by allocated blocks (including the power of two rounding).
+    uint64_t GetUsedSize() const { return m_UsedSize; }
+    // Bytes actually requested by the callers.
+    uint64_t GetRequestedSize() const { return m_RequestedSize; }
+    uint64_t GetFreeSize() const { return m_Size - m_UsedSize; }
+    uint64_t GetLargestFreeBlock() const;
+    size_t GetNumAllocations() const { return m_Allocations.size(); }
+    bool IsEmpty() const { return m_Allocations.empty(); }
+
+    /**
+     * External fragmentation of the free space in the range [0, 1].
+     * 0 means all free memory is a single block, values close to 1 mean
+     * the free memory is split into many small blocks.
+     */
+    float GetFragmentation() const;
+
+private:
+    struct AllocationEntry
+    {
+        uint32_t order;
+        uint64_t requestedSize;
+    };
+
+    uint64_t BlockSize(uint32_t order) const { return m_MinBlockSize << order; }
+
+    uint64_t m_Size;
+    uint64_t m_MinBlockSize;
+    uint32_t m_MaxOrder;
+
+    uint64_t m_UsedSize;
+    uint64_t m_RequestedSize;
+
+    // Free block offsets for every order, ordered so the lowest address is reused first.
+    std::vector< std::set<uint64_t> > m_FreeLists;
+    std::unordered_map<uint64_t, AllocationEntry> m_Allocations;
+};
+
+/**
+ * Manages a growing set of fixed size heaps and places allocations in them
+ * using a buddy allocator per heap. Allocations larger than the heap size get
+ * a dedicated heap, only rounded up to the alignment, that is destroyed again
+ * as soon as it becomes empty.
+ */
+class HeapAllocator
+{
+public:
+    // Creates a heap of the given size and alignment. Returns an opaque handle.
+    using CreateHeapFunc = std::function<void*(uint64_t size, uint64_t alignment)>;
+    // Destroys a heap handle returned by CreateHeapFunc.
+    using DestroyHeapFunc = std::function<void(void*)>;
+
+    struct Allocation
+    {
+        void* pHeap = nullptr;
+        uint64_t Offset = 0;
+        uint64_t Size = 0;
+        uint32_t HeapIndex = ~0u;
+
+        bool IsValid() const { return pHeap != nullptr; }
+    };
+
+    struct Statistics
+    {
+        uint32_t NumHeaps = 0;
+        uint32_t NumAllocations = 0;
+        // Sum of the size of all heaps.
+        uint64_t ReservedSize = 0;
+        // Bytes covered by allocated blocks.
+        uint64_t UsedSize = 0;
+        // Bytes requested by the callers.
+        uint64_t RequestedSize = 0;
+        uint64_t LargestFreeBlock = 0;
+        // External fragmentation of the free space, see BuddyAllocator::GetFragmentation.
+        float Fragmentation = 0.0f;
+    };
+
+    /**
+     * @param heapSize Size of the regular heaps. Must be a power of two multiple of alignment.
+     * @param alignment Heap alignment and minimum block size (for example 64KB or 4MB for MSAA).
+     */
+    HeapAllocator(uint64_t heapSize, uint64_t alignment, CreateHeapFunc createHeap, DestroyHeapFunc destroyHeap);
+    virtual ~HeapAllocator();
+
+    /**
+     * Place an allocation in one of the heaps, creating a new heap if necessary.
+     * Returns an invalid allocation if the heap could not be created.
+     */
+    Allocation Allocate(uint64_t size, uint64_t alignment = 0);
+
+    void Free(Allocation& allocation);
+
+    uint64_t GetHeapSize() const { return m_HeapSize; }
+    uint64_t GetAlignment() const { return m_Alignment; }
+
+    Statistics GetStatistics() const;
+
+private:
+    HeapAllocator(const HeapAllocator& copy) = delete;
+    HeapAllocator& operator=(const HeapAllocator& other) = delete;
+
+    struct Heap
+    {
+        void* pHeap;
+        bool dedicated;
+        uint64_t size;
+        // Size of the resource in a dedicated heap.
+        uint64_t requestedSize;
+        // Null for dedicated heaps, their resource is placed at offset 0.
+        std::unique_ptr<BuddyAllocator> allocator;
+    };
+
+    uint32_t CreateHeap(uint64_t size, uint64_t alignment, bool dedicated);
+    void DestroyHeap(uint32_t heapIndex);
+
+    uint64_t m_HeapSize;
+    uint64_t m_Alignment;
+
+    CreateHeapFunc m_CreateHeap;
+    DestroyHeapFunc m_DestroyHeap;
+
+    // Destroyed heaps leave an empty slot so the indices of live allocations stay valid.
+    std::vector<Heap> m_Heaps;
+};
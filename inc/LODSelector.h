@@ -0,0 +1,102 @@
+/**
+* Runtime LOD selection by screen space error.
+*
+* Every instance references a LOD chain (the object space errors stored in the
+* mesh file, see MeshFileLOD) and has a world space bounding sphere. Select
+* projects the errors to pixels with the camera of the frame and picks the
+* coarsest LOD whose error stays below the threshold. A coarser LOD is only
+* taken once its error is clearly below the threshold (hysteresis), so objects
+* near a switching distance do not flicker between two LODs.
+*
+* The instances are stored as structure of arrays and projected four at a time with SSE.
+*/
+#pragma once
+
+#include <MeshFile.h>
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+struct LODSelectionSettings
+{
+    // Largest acceptable error in pixels.
+    float ErrorThreshold = 1.0f;
+    // Switching to a coarser LOD requires an error below ErrorThreshold * (1 - Hysteresis).
+    float Hysteresis = 0.25f;
+};
+
+class LODSelector
+{
+public:
+    LODSelector(const LODSelectionSettings& settings = LODSelectionSettings());
+
+    /**
+     * Register a LOD chain. The errors must increase with the LOD, LOD 0 has no error.
+     * @returns The index of the chain.
+     */
+    uint32_t AddLODChain(const MeshFileLOD* pLODs, uint32_t lodCount);
+
+    /**
+     * Add an instance that starts at LOD 0.
+     * @returns The index of the instance.
+     */
+    uint32_t AddInstance(uint32_t lodChain);
+
+    /**
+     * Set the world space bounding sphere of an instance.
+     * @param errorScale Scale from object space to world space, applied to the LOD errors.
+     */
+    void SetInstanceBounds(uint32_t instance, const DirectX::XMFLOAT3& center, float radius, float errorScale = 1.0f);
+
+    /**
+     * Select the LOD of every instance. viewportHeight is in pixels; the field of view is
+     * taken from the projection matrix, so zooming in selects finer LODs.
+     */
+    void Select(const DirectX::XMMATRIX& viewMatrix, const DirectX::XMMATRIX& projectionMatrix, float viewportHeight,
+        ThreadPool* pThreadPool = nullptr);
+
+    uint32_t GetLOD(uint32_t instance) const
+    {
+        return m_LODs[instance];
+    }
+
+    size_t GetNumInstances() const
+    {
+        return m_NumInstances;
+    }
+
+    // Remove all chains and instances.
+    void Clear();
+
+private:
+    struct LODChain
+    {
+        uint32_t Offset;
+        uint32_t Count;
+    };
+
+    // Pixels per unit of object space error for instances [first, first + count), count a multiple of 4.
+    void ComputePixelsPerUnit(size_t first, size_t count, const DirectX::XMFLOAT4X4& view, float projectionScale);
+    void SelectLODs(size_t first, size_t count);
+
+    LODSelectionSettings m_Settings;
+
+    std::vector<float> m_LODErrors;
+    std::vector<LODChain> m_LODChains;
+
+    // Per instance, padded to a multiple of 4.
+    std::vector<float> m_CenterX;
+    std::vector<float> m_CenterY;
+    std::vector<float> m_CenterZ;
+    std::vector<float> m_Radius;
+    std::vector<float> m_ErrorScale;
+    std::vector<float> m_PixelsPerUnit;
+    std::vector<uint32_t> m_InstanceChains;
+    std::vector<uint32_t> m_LODs;
+    size_t m_NumInstances;
+};
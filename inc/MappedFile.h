@@ -0,0 +1,50 @@
+/**
+* Read only memory mapping of a whole file.
+*
+* Used by the binary asset containers (MeshFile, TextureFile), which are laid
+* out so that they can be used straight from the mapped view.
+*/
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class MappedFile
+{
+public:
+    MappedFile();
+    virtual ~MappedFile();
+
+    /**
+     * Map the file.
+     * @returns false if the file does not exist, is empty or could not be mapped.
+     */
+    bool Open(const std::wstring& fileName);
+    void Close();
+
+    bool IsOpen() const
+    {
+        return m_pData != nullptr;
+    }
+
+    const void* GetData() const
+    {
+        return m_pData;
+    }
+
+    size_t GetSize() const
+    {
+        return m_Size;
+    }
+
+private:
+    MappedFile(const MappedFile& copy) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    const void* m_pData;
+    size_t m_Size;
+
+    // Platform handles (file and file mapping on Windows, file descriptor otherwise).
+    void* m_hFile;
+    void* m_hMapping;
+};
@@ -0,0 +1,25 @@
+/**
+* Offline conversion of text meshes into the binary mesh format (see MeshFile.h).
+*/
+#pragma once
+
+#include <MeshFile.h>
+
+#include <string>
+
+/**
+ * Parse a Wavefront OBJ file into a position/color mesh that matches VertexPosColor
+ * (POSITION and COLOR as R32G32B32_FLOAT). Vertex colors written as "v x y z r g b"
+ * are kept, other vertices are white. Polygons are triangulated as fans and every
+ * "o"/"g" statement starts a new submesh.
+ * @returns false if the file could not be read or contains no triangles.
+ */
+bool LoadObjMesh(const std::wstring& fileName, MeshData& mesh);
+
+/**
+ * Convert an OBJ file to a mesh file: optimizes the index and vertex order (see
+ * MeshOptimizer.h), generates the LOD chain (see MeshSimplifier.h) and computes
+ * the submesh bounds. The vertices
+ * are stored in the quantized VertexPosColorPacked layout (see VertexQuantization.h).
+ */
+bool ConvertObjToMeshFile(const std::wstring& objFileName, const std::wstring& meshFileName);
@@ -0,0 +1,208 @@
+/**
+* Binary mesh container.
+*
+* A mesh file is laid out so that it can be memory mapped and uploaded
+* without any parsing:
+*
+*   MeshFileHeader
+*   MeshFileSubmesh[NumSubmeshes]
+*   MeshFileLOD[NumLODs]
+*   vertex stream (aligned to MeshFileAlignment)
+*   index stream  (aligned to MeshFileAlignment)
+*
+* The header describes the vertex layout so the matching input layout can
+* be built at load time. Use MeshConverter to produce mesh files offline.
+*/
+#pragma once
+
+#include <MappedFile.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 'MESH'
+const uint32_t MeshFileMagic = 0x4853454D;
+const uint32_t MeshFileVersion = 3;
+// Alignment of the vertex and index streams inside the file.
+const uint32_t MeshFileAlignment = 64;
+const uint32_t MeshFileMaxAttributes = 8;
+
+// DXGI_FORMAT values used by the mesh tools, so the offline tools do not depend on the Windows SDK.
+const uint32_t MeshFormatR32G32B32Float = 6;   // DXGI_FORMAT_R32G32B32_FLOAT
+const uint32_t MeshFormatR16G16B16A16SNorm = 13; // DXGI_FORMAT_R16G16B16A16_SNORM
+const uint32_t MeshFormatR8G8B8A8UNorm = 28;   // DXGI_FORMAT_R8G8B8A8_UNORM
+const uint32_t MeshFormatR32UInt = 42;         // DXGI_FORMAT_R32_UINT
+const uint32_t MeshFormatR16UInt = 57;         // DXGI_FORMAT_R16_UINT
+
+enum class MeshAttributeSemantic : uint32_t
+{
+    Position,
+    Normal,
+    Color,
+    TexCoord,
+};
+
+// Returns the HLSL semantic name ("POSITION", "COLOR", ...).
+const char* GetSemanticName(MeshAttributeSemantic semantic);
+
+struct MeshVertexAttribute
+{
+    MeshAttributeSemantic Semantic;
+    // DXGI_FORMAT of the attribute.
+    uint32_t Format;
+    // Byte offset inside the vertex.
+    uint32_t Offset;
+};
+
+struct MeshFileSubmesh
+{
+    uint32_t IndexStart;
+    uint32_t IndexCount;
+    uint32_t BaseVertex;
+    uint32_t VertexCount;
+    // Object space bounds.
+    float BoundsMin[3];
+    float BoundsMax[3];
+    float SphereCenter[3];
+    float SphereRadius;
+    // Range in the LOD table, LODCount is 0 if no LODs were generated.
+    uint32_t LODOffset;
+    uint32_t LODCount;
+};
+
+/**
+ * A level of detail of a submesh. All levels share the vertex buffer and use
+ * the BaseVertex of their submesh, LOD 0 is the submesh itself.
+ */
+struct MeshFileLOD
+{
+    uint32_t IndexStart;
+    uint32_t IndexCount;
+    // Object space geometric error compared to LOD 0.
+    float Error;
+};
+
+struct MeshFileHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t VertexStride;
+    uint32_t NumAttributes;
+    MeshVertexAttribute Attributes[MeshFileMaxAttributes];
+    // DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT.
+    uint32_t IndexFormat;
+    uint32_t NumSubmeshes;
+    uint64_t VertexCount;
+    uint64_t IndexCount;
+    uint64_t SubmeshOffset;
+    uint64_t VertexDataOffset;
+    uint64_t VertexDataSize;
+    uint64_t IndexDataOffset;
+    uint64_t IndexDataSize;
+    uint64_t FileSize;
+    // Object space position = stored position * PositionScale + PositionBias.
+    // Identity unless the positions are quantized (see VertexQuantization.h).
+    float PositionScale[3];
+    float PositionBias[3];
+    uint32_t NumLODs;
+    uint64_t LODOffset;
+};
+
+/**
+ * In-memory mesh used by the offline tools.
+ * Vertices are stored as raw bytes described by Attributes and VertexStride.
+ */
+struct MeshData
+{
+    uint32_t VertexStride = 0;
+    std::vector<MeshVertexAttribute> Attributes;
+    std::vector<uint8_t> Vertices;
+    std::vector<uint32_t> Indices;
+    std::vector<MeshFileSubmesh> Submeshes;
+    // Referenced by MeshFileSubmesh::LODOffset and LODCount.
+    std::vector<MeshFileLOD> LODs;
+    // Dequantization of the positions, see MeshFileHeader.
+    float PositionScale[3] = { 1.0f, 1.0f, 1.0f };
+    float PositionBias[3] = { 0.0f, 0.0f, 0.0f };
+
+    size_t GetVertexCount() const
+    {
+        return VertexStride ? Vertices.size() / VertexStride : 0;
+    }
+
+    // Returns the attribute with the given semantic or nullptr.
+    const MeshVertexAttribute* FindAttribute(MeshAttributeSemantic semantic) const;
+};
+
+/**
+ * 计算子网格的包围盒和包围球。The position attribute must be R32G32B32_FLOAT.
+ */
+void ComputeSubmeshBounds(MeshData& mesh);
+
+/**
+ * Write a mesh file. 16-bit indices are used if all vertices can be addressed with them.
+ */
+bool WriteMeshFile(const std::wstring& fileName, const MeshData& mesh);
+
+/**
+ * A memory mapped mesh file. The streams point directly into the mapped view,
+ * nothing is parsed or copied when the file is opened.
+ */
+class MeshFile
+{
+public:
+    MeshFile();
+    virtual ~MeshFile();
+
+    /**
+     * Map the file and validate the header.
+     * @returns false if the file could not be mapped or is not a valid mesh file.
+     */
+    bool Open(const std::wstring& fileName);
+    void Close();
+
+    bool IsOpen() const
+    {
+        return m_File.IsOpen();
+    }
+
+    const MeshFileHeader& GetHeader() const
+    {
+        return *static_cast<const MeshFileHeader*>(m_File.GetData());
+    }
+
+    const MeshFileSubmesh* GetSubmeshes() const
+    {
+        return reinterpret_cast<const MeshFileSubmesh*>(GetBytes() + GetHeader().SubmeshOffset);
+    }
+
+    const MeshFileLOD* GetLODs() const
+    {
+        return reinterpret_cast<const MeshFileLOD*>(GetBytes() + GetHeader().LODOffset);
+    }
+
+    const void* GetVertexData() const
+    {
+        return GetBytes() + GetHeader().VertexDataOffset;
+    }
+
+    const void* GetIndexData() const
+    {
+        return GetBytes() + GetHeader().IndexDataOffset;
+    }
+
+private:
+    MeshFile(const MeshFile& copy) = delete;
+    MeshFile& operator=(const MeshFile& other) = delete;
+
+    const uint8_t* GetBytes() const
+    {
+        return static_cast<const uint8_t*>(m_File.GetData());
+    }
+
+    bool Validate() const;
+
+    MappedFile m_File;
+};
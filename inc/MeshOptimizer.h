@@ -0,0 +1,86 @@
+/**
+* Index and vertex reordering for faster rendering.
+*
+* The usual order is: OptimizeVertexCache (Tipsify), then OptimizeOverdraw,
+* which reorders the clusters of the cache optimized index buffer front to
+* back, then OptimizeVertexFetch so the vertex buffer is read linearly.
+* OptimizeMesh runs all three on a MeshData. AnalyzeVertexCache simulates a
+* FIFO post-transform cache to measure the result without a GPU.
+*
+* Indices are 32-bit, vertices are addressed relative to the start of the
+* vertex buffer.
+*/
+#pragma once
+
+#include <MeshFile.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Typical size of the post-transform cache of current GPUs, in vertices.
+const uint32_t DefaultVertexCacheSize = 16;
+
+struct VertexCacheStatistics
+{
+    // Number of vertex shader invocations.
+    uint32_t VerticesTransformed = 0;
+    // Average cache miss ratio: transformed vertices per triangle (0.5 is optimal for large meshes, 3 is the worst).
+    float ACMR = 0.0f;
+    // Average transformed to vertex ratio: transformed vertices per referenced vertex (1 is optimal).
+    float ATVR = 0.0f;
+};
+
+/**
+ * Simulate a FIFO post-transform vertex cache of cacheSize entries.
+ */
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* pIndices, size_t indexCount, size_t vertexCount,
+    uint32_t cacheSize = DefaultVertexCacheSize);
+
+/**
+ * Reorder the triangles for the post-transform vertex cache with Tipsify
+ * (Sander et al. 2007), linear in the number of triangles.
+ * pDestination may be equal to pIndices.
+ */
+void OptimizeVertexCache(uint32_t* pDestination, const uint32_t* pIndices, size_t indexCount, size_t vertexCount,
+    uint32_t cacheSize = DefaultVertexCacheSize);
+
+/**
+ * Reorder clusters of a cache optimized index buffer so that triangles facing
+ * outwards are drawn first, which reduces overdraw for mostly convex meshes.
+ * Clusters are split further as long as the ACMR stays below threshold times the
+ * ACMR of the input (1.05 allows a 5% worse vertex cache hit rate).
+ * @param pPositions Pointer to the first position (3 floats), positionStride bytes apart.
+ * pDestination may not be equal to pIndices.
+ */
+void OptimizeOverdraw(uint32_t* pDestination, const uint32_t* pIndices, size_t indexCount,
+    const float* pPositions, size_t positionStride, size_t vertexCount,
+    float threshold = 1.05f, uint32_t cacheSize = DefaultVertexCacheSize);
+
+/**
+ * Compute a remap table that orders the vertices by their first use in the index buffer.
+ * Unreferenced vertices are mapped to InvalidVertexIndex.
+ * @returns The number of referenced vertices.
+ */
+size_t OptimizeVertexFetchRemap(uint32_t* pRemap, const uint32_t* pIndices, size_t indexCount, size_t vertexCount);
+
+const uint32_t InvalidVertexIndex = 0xFFFFFFFF;
+
+/**
+ * Apply a remap table to an index buffer. pDestination may be equal to pIndices.
+ */
+void RemapIndexBuffer(uint32_t* pDestination, const uint32_t* pIndices, size_t indexCount, const uint32_t* pRemap);
+
+/**
+ * Apply a remap table to a vertex buffer. Unreferenced vertices are dropped.
+ * pDestination may not be equal to pVertices.
+ */
+void RemapVertexBuffer(void* pDestination, const void* pVertices, size_t vertexCount, size_t vertexStride, const uint32_t* pRemap);
+
+/**
+ * 优化网格: vertex cache and overdraw ordering per submesh followed by vertex fetch
+ * ordering of the whole mesh. The overdraw pass needs R32G32B32_FLOAT positions and
+ * is skipped otherwise, so optimize before QuantizeMesh. Submeshes keep their index
+ * ranges, vertices are addressed from the start of the vertex buffer afterwards
+ * (BaseVertex is 0).
+ */
+void OptimizeMesh(MeshData& mesh, uint32_t cacheSize = DefaultVertexCacheSize, float overdrawThreshold = 1.05f);
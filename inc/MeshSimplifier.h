@@ -0,0 +1,77 @@
+/**
+* Mesh simplification and LOD chain generation.
+*
+* SimplifyMesh collapses edges in order of their quadric error (Garland and
+* Heckbert 1997). Vertices only move onto existing vertices, so every level of
+* detail is just another index buffer over the original vertex buffer and the
+* LOD table (MeshFileLOD) stays compact.
+*/
+#pragma once
+
+#include <MeshFile.h>
+
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+const uint32_t MaxSimplifyAttributes = 4;
+
+struct SimplifySettings
+{
+    /**
+     * Vertex attributes (floats, attributeStride bytes apart) that should be
+     * preserved, for example the color. The squared attribute difference times
+     * the weight is added to the geometric error to order the collapses; the
+     * error limit and the reported error are geometric only.
+     */
+    const float* pAttributes = nullptr;
+    size_t AttributeStride = 0;
+    uint32_t AttributeCount = 0;
+    float AttributeWeights[MaxSimplifyAttributes] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    // Keep the vertices on open borders in place. Otherwise they may only slide along the border.
+    bool LockBorder = true;
+};
+
+/**
+ * Simplify a triangle list to at most targetIndexCount indices, unless that would
+ * exceed targetError (object space distance).
+ * @param pDestination Receives the indices, must hold indexCount indices. May be equal to pIndices.
+ * @param pResultError Optional, receives the geometric error of the result.
+ * @returns The number of indices written to pDestination.
+ */
+size_t SimplifyMesh(uint32_t* pDestination, const uint32_t* pIndices, size_t indexCount,
+    const float* pPositions, size_t positionStride, size_t vertexCount,
+    size_t targetIndexCount, float targetError, const SimplifySettings& settings = SimplifySettings(),
+    float* pResultError = nullptr);
+
+struct LODGenerationSettings
+{
+    // Including LOD 0.
+    uint32_t MaxLODs = 4;
+    // Target index count of each level relative to the previous one.
+    float ReductionRatio = 0.5f;
+    // Largest error of any level relative to the radius of the submesh.
+    float MaxRelativeError = 0.05f;
+    // Weight of the color attribute, if the mesh has one (R32G32B32_FLOAT).
+    float ColorWeight = 1.0f;
+    bool LockBorder = true;
+};
+
+/**
+ * 生成 LOD 链: append the index buffers of the levels to mesh.Indices and fill
+ * mesh.LODs and the LOD ranges of the submeshes. Each level is simplified from
+ * the previous one and optimized for the vertex cache. A chain ends early if a
+ * level can not be reduced by at least 10% within the error limit.
+ * Call after OptimizeMesh and before QuantizeMesh, positions must be R32G32B32_FLOAT.
+ * @returns false if the mesh has no R32G32B32_FLOAT positions.
+ */
+bool GenerateLODs(MeshData& mesh, const LODGenerationSettings& settings = LODGenerationSettings());
+
+/**
+ * 并行地为多个网格生成 LOD, one task per mesh.
+ * @returns false if GenerateLODs failed for any mesh.
+ */
+bool GenerateLODs(MeshData* const* ppMeshes, size_t meshCount, const LODGenerationSettings& settings = LODGenerationSettings(),
+    ThreadPool* pThreadPool = nullptr);
@@ -0,0 +1,108 @@
+/**
+* Meshlet generation for mesh shader pipelines.
+*
+* Splits the triangles of a mesh into meshlets of at most MaxVertices unique
+* vertices and MaxPrimitives triangles, in index buffer order, so run
+* OptimizeVertexCache (MeshOptimizer.h) first for compact meshlets. Every
+* meshlet gets a bounding sphere and a normal cone for culling in the
+* amplification shader.
+*/
+#pragma once
+
+#include <MeshFile.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// D3D12 limits of a single mesh shader thread group.
+const uint32_t MaxMeshletVertices = 256;
+const uint32_t MaxMeshletPrimitives = 256;
+
+struct MeshletBuildSettings
+{
+    // Defaults recommended for current hardware.
+    uint32_t MaxVertices = 64;
+    uint32_t MaxPrimitives = 126;
+};
+
+struct Meshlet
+{
+    // Range in MeshletMesh::UniqueVertexIndices.
+    uint32_t VertexOffset;
+    uint32_t VertexCount;
+    // Range in MeshletMesh::PrimitiveIndices.
+    uint32_t PrimitiveOffset;
+    uint32_t PrimitiveCount;
+};
+
+struct MeshletBounds
+{
+    // Bounding sphere of the meshlet's vertices.
+    float Center[3];
+    float Radius;
+    /**
+     * Normal cone: all triangles face away from a camera at position c if
+     * dot(normalize(ConeApex - c), ConeAxis) >= ConeCutoff.
+     * ConeCutoff is larger than 1 if the triangles can not be culled together.
+     */
+    float ConeApex[3];
+    float ConeAxis[3];
+    float ConeCutoff;
+};
+
+// A meshlet primitive: three local vertex indices packed as 10:10:10.
+inline uint32_t PackMeshletTriangle(uint32_t i0, uint32_t i1, uint32_t i2)
+{
+    return (i0 & 0x3FF) | ((i1 & 0x3FF) << 10) | ((i2 & 0x3FF) << 20);
+}
+
+inline void UnpackMeshletTriangle(uint32_t primitive, uint32_t& i0, uint32_t& i1, uint32_t& i2)
+{
+    i0 = primitive & 0x3FF;
+    i1 = (primitive >> 10) & 0x3FF;
+    i2 = (primitive >> 20) & 0x3FF;
+}
+
+struct MeshletMesh
+{
+    // Meshlets of a submesh.
+    struct Subset
+    {
+        uint32_t MeshletOffset;
+        uint32_t MeshletCount;
+    };
+
+    std::vector<Meshlet> Meshlets;
+    std::vector<MeshletBounds> Bounds;
+    // Vertex buffer indices (relative to the start of the vertex buffer) referenced by the meshlets.
+    std::vector<uint32_t> UniqueVertexIndices;
+    // Packed triangles, see PackMeshletTriangle.
+    std::vector<uint32_t> PrimitiveIndices;
+    // One per submesh, or a single one if the mesh has no submeshes.
+    std::vector<Subset> Subsets;
+};
+
+/**
+ * Build the meshlets of a triangle list.
+ * @param pPositions Pointer to the first position (3 floats), positionStride bytes apart.
+ * The meshlets are appended to out, which allows building several index ranges into one MeshletMesh.
+ */
+void BuildMeshlets(const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t positionStride,
+    size_t vertexCount, const MeshletBuildSettings& settings, MeshletMesh& out);
+
+/**
+ * Build the meshlets of every submesh of the mesh. Positions can be R32G32B32_FLOAT
+ * or quantized (see VertexQuantization.h).
+ * @returns false if the mesh has no supported position attribute.
+ */
+bool BuildMeshlets(const MeshData& mesh, const MeshletBuildSettings& settings, MeshletMesh& out);
+
+/**
+ * 并行地为多个网格生成 meshlets, one task per mesh.
+ * @returns false if any mesh has no supported position attribute.
+ */
+bool BuildMeshlets(const MeshData* const* ppMeshes, size_t meshCount, const MeshletBuildSettings& settings,
+    MeshletMesh* pOut, ThreadPool* pThreadPool = nullptr);
@@ -0,0 +1,39 @@
+/**
+* CPU mip chain generation, so mips can be baked offline and streamed in
+* instead of being generated on the GPU at startup.
+*
+* Every mip is resampled directly from mip 0 with a separable filter scaled to
+* the size of the mip. That avoids the blur that builds up when each level is
+* filtered from the previous one and makes all (mip, slice) pairs independent
+* tasks. Filtering happens in linear space with SSE, sRGB textures are
+* converted on load and store.
+*/
+#pragma once
+
+#include <TextureData.h>
+
+class ThreadPool;
+
+enum class MipFilter
+{
+    // Average of the covered texels. Cheapest, slightly blurry.
+    Box,
+    // Kaiser windowed sinc (width 3, alpha 4). Sharp with little ringing.
+    Kaiser,
+    // Lanczos 3. Sharpest, may ring around hard edges.
+    Lanczos,
+};
+
+struct MipGenerationSettings
+{
+    MipFilter Filter = MipFilter::Kaiser;
+    // Sample across the opposite edge for tiling textures, clamp to the edge otherwise.
+    bool Wrap = false;
+};
+
+/**
+ * 生成 mip 链: fill mips 1 to MipLevels - 1 of every array slice from mip 0.
+ * Supports RGBA8 (UNORM and UNORM_SRGB), RGBA16F and RGBA32F.
+ */
+void GenerateMips(TextureData& texture, const MipGenerationSettings& settings = MipGenerationSettings(),
+    ThreadPool* pThreadPool = nullptr);
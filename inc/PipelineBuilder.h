@@ -0,0 +1,181 @@
+/**
+* Startup stage that builds the root signatures and pipeline states of the
+* application in parallel.
+*
+* The pipelines are described up front, Build turns them into a TaskGraph:
+* every shader file is read once, every root signature is serialized and
+* created once, and each pipeline state is created as soon as its shaders and
+* its root signature are ready, all on the thread pool. Root signatures and
+* pipeline states go through the PipelineStateCache, so pipelines that were
+* built before are loaded from the pipeline library instead of compiled.
+*
+* The phase timings of the last Build are available for startup profiling.
+*
+* Shaders come from the ShaderLibrary. When it reports changed shaders,
+* Rebuild creates the pipeline states that use them again on the thread pool,
+* the other pipeline states are left alone. ApplyRebuiltPipelines swaps the
+* new pipeline states in between frames. The replaced pipeline states stay
+* alive in the PipelineStateCache, so frames in flight can still use them.
+*/
+#pragma once
+
+#include <PipelineLayout.h>
+#include <ShaderLibrary.h>
+#include <TaskGraph.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class PipelineStateCache;
+class ThreadPool;
+
+struct GraphicsPipelineDesc
+{
+    // Compiled shader files (.cso). The pixel shader may be empty.
+    std::wstring VertexShader;
+    std::wstring PixelShader;
+    // Index returned by PipelineBuilder::AddRootSignature.
+    uint32_t RootSignature = 0;
+
+    // Fixed function state, usually a constexpr stream (see PipelineLayout.h). Its root
+    // signature and shaders are filled in by the builder. The input layout it points to
+    // must stay valid as long as the builder, which the constexpr input layouts do.
+    GraphicsPipelineStream Stream;
+};
+
+class PipelineBuilder
+{
+public:
+    PipelineBuilder(Microsoft::WRL::ComPtr<ID3D12Device2> device, std::shared_ptr<PipelineStateCache> pipelineStateCache,
+        std::shared_ptr<ShaderLibrary> shaderLibrary);
+    // Waits for the rebuilds that are still running.
+    virtual ~PipelineBuilder();
+
+    /**
+     * 添加根签名. The description (and the arrays it points to) must stay
+     * valid until Build returns. It is serialized with the highest root
+     * signature version the device supports.
+     * @returns The index of the root signature.
+     */
+    uint32_t AddRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc);
+
+    // 添加图形管线. @returns The index of the pipeline state.
+    uint32_t AddGraphicsPipeline(const GraphicsPipelineDesc& desc);
+
+    /**
+     * 构建 everything that was added since the last Build, on the thread pool or
+     * on the calling thread if pThreadPool is nullptr. Throws the first error.
+     */
+    void Build(ThreadPool* pThreadPool);
+
+    /**
+     * 重建管线 that use one of the shaders (ShaderLibrary::Update) in the background,
+     * on the thread pool or on the calling thread if pThreadPool is nullptr. A pipeline
+     * state that fails to build, for example from a broken shader, keeps its previous version.
+     */
+    void Rebuild(const std::vector<ShaderLibrary::ShaderPtr>& changedShaders, ThreadPool* pThreadPool);
+
+    /**
+     * Make the rebuilt pipeline states current, call between frames.
+     * @returns The indices of the pipeline states that changed.
+     */
+    std::vector<uint32_t> ApplyRebuiltPipelines();
+
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> GetRootSignature(uint32_t index) const
+    {
+        return m_RootSignatures[index].RootSignature;
+    }
+
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> GetPipelineState(uint32_t index) const
+    {
+        return m_Pipelines[index]->PipelineState;
+    }
+
+    // Timings of the shader loading, root signature and pipeline state phases of the last Build.
+    const std::vector<TaskGraph::PhaseTiming>& GetPhaseTimings() const
+    {
+        return m_TaskGraph.GetPhaseTimings();
+    }
+
+    double GetTotalSeconds() const
+    {
+        return m_TaskGraph.GetTotalSeconds();
+    }
+
+    // Write the timings of the last Build to the debugger output.
+    void PrintTimings() const;
+
+private:
+    PipelineBuilder(const PipelineBuilder& copy) = delete;
+    PipelineBuilder& operator=(const PipelineBuilder& other) = delete;
+
+    struct ShaderEntry
+    {
+        // ShaderLibrary::GetKey of the file.
+        std::wstring FileName;
+        ShaderLibrary::ShaderPtr Shader;
+    };
+
+    struct RootSignatureEntry
+    {
+        const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pDesc;
+        Microsoft::WRL::ComPtr<ID3D12RootSignature> RootSignature;
+    };
+
+    // No pixel shader, or no task to wait for.
+    static const uint32_t InvalidIndex = ~0u;
+
+    // Not moved once added, the rebuilds on the thread pool point to it.
+    struct PipelineEntry
+    {
+        GraphicsPipelineDesc Desc;
+        // Indices in m_Shaders.
+        uint32_t VertexShader;
+        uint32_t PixelShader;
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineState;
+        // Only the result of the latest rebuild is applied.
+        uint32_t RebuildGeneration = 0;
+    };
+
+    struct RebuiltPipeline
+    {
+        uint32_t Index;
+        uint32_t Generation;
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineState;
+    };
+
+    // Index of the shader file in m_Shaders, the file is only loaded once.
+    uint32_t FindOrAddShader(const std::wstring& fileName);
+
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> CreatePipelineState(const PipelineEntry& pipeline,
+        ID3D12RootSignature* pRootSignature, const ShaderLibrary::Shader* pVertexShader,
+        const ShaderLibrary::Shader* pPixelShader) const;
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
+    std::shared_ptr<PipelineStateCache> m_PipelineStateCache;
+    std::shared_ptr<ShaderLibrary> m_ShaderLibrary;
+    D3D_ROOT_SIGNATURE_VERSION m_RootSignatureVersion;
+
+    std::vector<ShaderEntry> m_Shaders;
+    std::vector<RootSignatureEntry> m_RootSignatures;
+    std::vector< std::unique_ptr<PipelineEntry> > m_Pipelines;
+
+    // Entries before these were built by an earlier Build.
+    size_t m_NumBuiltShaders;
+    size_t m_NumBuiltRootSignatures;
+    size_t m_NumBuiltPipelines;
+
+    // Rebuilds that are running and their results, protected by m_RebuildMutex.
+    std::vector< std::future<void> > m_RebuildTasks;
+    std::vector<RebuiltPipeline> m_RebuiltPipelines;
+    std::mutex m_RebuildMutex;
+
+    TaskGraph m_TaskGraph;
+};
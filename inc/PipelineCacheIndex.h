@@ -0,0 +1,104 @@
+/**
+* Index and file format of the persistent pipeline state cache.
+*
+* Pure C++ so the file handling can be checked without a GPU. The cache file
+* holds the serialized ID3D12PipelineLibrary together with the keys of the
+* pipeline states stored in it:
+*
+*   PipelineCacheFileHeader
+*   uint64_t Keys[NumKeys] (sorted)
+*   library blob (aligned to PipelineCacheFileAlignment)
+*
+* The header carries a device key (adapter and driver), a hash of the keys and
+* the library blob and the size of the file. A file written by another version of the
+* format, for another device or driver, or that was truncated or corrupted is
+* rejected by Load and the cache starts empty, the pipelines are compiled again.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// 'PSOC'
+const uint32_t PipelineCacheFileMagic = 0x434F5350;
+const uint32_t PipelineCacheFileVersion = 2;
+const uint32_t PipelineCacheFileAlignment = 16;
+
+struct PipelineCacheFileHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t NumKeys;
+    uint32_t Reserved;
+    // Adapter, driver and runtime the library was created with.
+    uint64_t DeviceKey;
+    uint64_t KeyOffset;
+    uint64_t LibraryOffset;
+    uint64_t LibrarySize;
+    // HashBytes of the keys followed by the library blob.
+    uint64_t ContentHash;
+    uint64_t FileSize;
+};
+
+class PipelineCacheIndex
+{
+public:
+    explicit PipelineCacheIndex(uint64_t deviceKey);
+    virtual ~PipelineCacheIndex();
+
+    void Clear();
+
+    /**
+     * 加载缓存文件 from memory. The library blob points into pData, which must stay
+     * alive as long as the pipeline library created from it.
+     * @returns false (and leaves the index empty) if the file is not valid for the device.
+     */
+    bool Load(const void* pData, size_t size);
+
+    // The library blob of the loaded file, nullptr if nothing was loaded.
+    const void* GetLibraryData() const
+    {
+        return m_pLibraryData;
+    }
+
+    size_t GetLibrarySize() const
+    {
+        return m_LibrarySize;
+    }
+
+    bool Contains(uint64_t key) const;
+
+    // Record a pipeline state that was stored in the library.
+    void Insert(uint64_t key);
+
+    uint32_t GetNumKeys() const
+    {
+        return static_cast<uint32_t>(m_Keys.size());
+    }
+
+    // True if keys were inserted since the last Load or Serialize.
+    bool IsDirty() const
+    {
+        return m_IsDirty;
+    }
+
+    /**
+     * 序列化 the index and the serialized library to the file format.
+     */
+    std::vector<uint8_t> Serialize(const void* pLibraryData, size_t librarySize);
+
+    // Name of the pipeline state in the ID3D12PipelineLibrary.
+    static std::wstring GetPipelineName(uint64_t key);
+
+private:
+    uint64_t m_DeviceKey;
+
+    std::unordered_set<uint64_t> m_Keys;
+    bool m_IsDirty;
+
+    const void* m_pLibraryData;
+    size_t m_LibrarySize;
+};
@@ -0,0 +1,435 @@
+/**
+* Pipeline layouts that are checked and assembled at compile time.
+*
+* Vertex structs are reflected with a VertexLayout specialization. InputLayout
+* turns it into a constexpr input element array and checks that the format of
+* every attribute has the size of its member and that the attributes do not
+* overlap, so the input layout can not drift from the vertex struct.
+*
+* RootSignatureLayout describes the root parameters as types. The root
+* signature cost (DWORDs) is summed at compile time and checked against the
+* 64 DWORD limit, and SetGraphicsRootConstants only accepts the type that the
+* root constants were declared with.
+*
+* GraphicsPipelineStream is a pipeline state stream whose fixed function state
+* is built with constexpr With* calls. The result is a constant, creating a
+* pipeline state only fills in the root signature and the shaders
+* (see PipelineBuilder).
+*/
+#pragma once
+
+#include <d3d12.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Root signatures are limited to 64 DWORDs.
+static const uint32_t MaxRootSignatureCost = 64;
+
+/**
+ * 格式大小 in bytes of the vertex formats, 0 for the formats that are not
+ * used as vertex attributes here.
+ */
+constexpr size_t GetVertexFormatSize(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R32G32B32A32_UINT:
+    case DXGI_FORMAT_R32G32B32A32_SINT:
+        return 16;
+    case DXGI_FORMAT_R32G32B32_FLOAT:
+    case DXGI_FORMAT_R32G32B32_UINT:
+    case DXGI_FORMAT_R32G32B32_SINT:
+        return 12;
+    case DXGI_FORMAT_R32G32_FLOAT:
+    case DXGI_FORMAT_R32G32_UINT:
+    case DXGI_FORMAT_R32G32_SINT:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_SNORM:
+    case DXGI_FORMAT_R16G16B16A16_UINT:
+    case DXGI_FORMAT_R16G16B16A16_SINT:
+        return 8;
+    case DXGI_FORMAT_R32_FLOAT:
+    case DXGI_FORMAT_R32_UINT:
+    case DXGI_FORMAT_R32_SINT:
+    case DXGI_FORMAT_R16G16_FLOAT:
+    case DXGI_FORMAT_R16G16_UNORM:
+    case DXGI_FORMAT_R16G16_SNORM:
+    case DXGI_FORMAT_R16G16_UINT:
+    case DXGI_FORMAT_R16G16_SINT:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_SNORM:
+    case DXGI_FORMAT_R8G8B8A8_UINT:
+    case DXGI_FORMAT_R8G8B8A8_SINT:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+        return 4;
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_R16_UNORM:
+    case DXGI_FORMAT_R16_SNORM:
+    case DXGI_FORMAT_R16_UINT:
+    case DXGI_FORMAT_R16_SINT:
+    case DXGI_FORMAT_R8G8_UNORM:
+    case DXGI_FORMAT_R8G8_SNORM:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+struct VertexAttribute
+{
+    const char* SemanticName;
+    UINT SemanticIndex;
+    DXGI_FORMAT Format;
+    // offsetof and sizeof of the member.
+    size_t Offset;
+    size_t Size;
+};
+
+/**
+ * 顶点反射: specialize for a vertex struct with
+ *     static constexpr VertexAttribute Attributes[] = { ... };
+ * listing one attribute per member.
+ */
+template<typename Vertex>
+struct VertexLayout;
+
+// Every attribute format has the size of its member.
+template<size_t N>
+constexpr bool HasMatchingFormats(const VertexAttribute (&attributes)[N])
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (GetVertexFormatSize(attributes[i].Format) != attributes[i].Size)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// No two attributes share bytes and all of them lie within the vertex.
+template<size_t N>
+constexpr bool HasDisjointAttributes(const VertexAttribute (&attributes)[N], size_t vertexSize)
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (attributes[i].Offset + attributes[i].Size > vertexSize)
+        {
+            return false;
+        }
+        for (size_t j = i + 1; j < N; ++j)
+        {
+            if (attributes[i].Offset < attributes[j].Offset + attributes[j].Size &&
+                attributes[j].Offset < attributes[i].Offset + attributes[i].Size)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+constexpr D3D12_INPUT_ELEMENT_DESC MakeInputElement(const VertexAttribute& attribute)
+{
+    return { attribute.SemanticName, attribute.SemanticIndex, attribute.Format, 0,
+        static_cast<UINT>(attribute.Offset), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+}
+
+template<typename Vertex, size_t... Indices>
+constexpr std::array<D3D12_INPUT_ELEMENT_DESC, sizeof...(Indices)> MakeInputElements(std::index_sequence<Indices...>)
+{
+    return { { MakeInputElement(VertexLayout<Vertex>::Attributes[Indices])... } };
+}
+
+/**
+ * 输入布局 of a reflected vertex struct, a constant in the binary.
+ * All attributes are read from input slot 0 at the offsets of their members.
+ */
+template<typename Vertex>
+struct InputLayout
+{
+    static constexpr size_t NumElements = std::size(VertexLayout<Vertex>::Attributes);
+
+    static_assert(HasMatchingFormats(VertexLayout<Vertex>::Attributes),
+        "The format of a vertex attribute does not match the size of its member.");
+    static_assert(HasDisjointAttributes(VertexLayout<Vertex>::Attributes, sizeof(Vertex)),
+        "Vertex attributes overlap or lie outside of the vertex.");
+
+    static constexpr std::array<D3D12_INPUT_ELEMENT_DESC, NumElements> Elements =
+        MakeInputElements<Vertex>(std::make_index_sequence<NumElements>());
+
+    static constexpr D3D12_INPUT_LAYOUT_DESC Desc = { Elements.data(), static_cast<UINT>(NumElements) };
+};
+
+/**
+ * 根参数 types for RootSignatureLayout. Cost is the size of the parameter in the
+ * root signature in DWORDs: the constants themselves, 2 for a root descriptor
+ * and 1 for a descriptor table.
+ */
+template<typename T, UINT ShaderRegister, UINT RegisterSpace = 0, D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+struct RootConstants
+{
+    static_assert(sizeof(T) % 4 == 0, "Root constants are set in DWORDs.");
+
+    using Type = T;
+    static constexpr uint32_t Cost = sizeof(T) / 4;
+
+    static D3D12_ROOT_PARAMETER1 GetDesc()
+    {
+        D3D12_ROOT_PARAMETER1 parameter = {};
+        parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+        parameter.Constants.ShaderRegister = ShaderRegister;
+        parameter.Constants.RegisterSpace = RegisterSpace;
+        parameter.Constants.Num32BitValues = Cost;
+        parameter.ShaderVisibility = Visibility;
+        return parameter;
+    }
+};
+
+template<D3D12_ROOT_PARAMETER_TYPE ParameterType, UINT ShaderRegister, UINT RegisterSpace, D3D12_ROOT_DESCRIPTOR_FLAGS Flags,
+    D3D12_SHADER_VISIBILITY Visibility>
+struct RootDescriptor
+{
+    static constexpr uint32_t Cost = 2;
+
+    static D3D12_ROOT_PARAMETER1 GetDesc()
+    {
+        D3D12_ROOT_PARAMETER1 parameter = {};
+        parameter.ParameterType = ParameterType;
+        parameter.Descriptor.ShaderRegister = ShaderRegister;
+        parameter.Descriptor.RegisterSpace = RegisterSpace;
+        parameter.Descriptor.Flags = Flags;
+        parameter.ShaderVisibility = Visibility;
+        return parameter;
+    }
+};
+
+template<UINT ShaderRegister, UINT RegisterSpace = 0, D3D12_ROOT_DESCRIPTOR_FLAGS Flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE,
+    D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+using RootCBV = RootDescriptor<D3D12_ROOT_PARAMETER_TYPE_CBV, ShaderRegister, RegisterSpace, Flags, Visibility>;
+
+template<UINT ShaderRegister, UINT RegisterSpace = 0, D3D12_ROOT_DESCRIPTOR_FLAGS Flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE,
+    D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+using RootSRV = RootDescriptor<D3D12_ROOT_PARAMETER_TYPE_SRV, ShaderRegister, RegisterSpace, Flags, Visibility>;
+
+template<UINT ShaderRegister, UINT RegisterSpace = 0, D3D12_ROOT_DESCRIPTOR_FLAGS Flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE,
+    D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+using RootUAV = RootDescriptor<D3D12_ROOT_PARAMETER_TYPE_UAV, ShaderRegister, RegisterSpace, Flags, Visibility>;
+
+// Ranges is a static constexpr D3D12_DESCRIPTOR_RANGE1 array.
+template<const auto& Ranges, D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+struct RootDescriptorTable
+{
+    static constexpr uint32_t Cost = 1;
+
+    static D3D12_ROOT_PARAMETER1 GetDesc()
+    {
+        D3D12_ROOT_PARAMETER1 parameter = {};
+        parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        parameter.DescriptorTable.NumDescriptorRanges = static_cast<UINT>(std::size(Ranges));
+        parameter.DescriptorTable.pDescriptorRanges = Ranges;
+        parameter.ShaderVisibility = Visibility;
+        return parameter;
+    }
+};
+
+/**
+ * 根签名布局 (version 1.1) made of the root parameter types above, in order.
+ * The description is built once and stays valid for the lifetime of the
+ * program, it can be passed to PipelineBuilder::AddRootSignature directly.
+ */
+template<D3D12_ROOT_SIGNATURE_FLAGS Flags, typename... Parameters>
+class RootSignatureLayout
+{
+public:
+    static constexpr uint32_t NumParameters = sizeof...(Parameters);
+    static constexpr uint32_t Cost = (0 + ... + Parameters::Cost);
+
+    static_assert(Cost <= MaxRootSignatureCost, "The root signature is larger than 64 DWORDs.");
+
+    template<uint32_t Index>
+    using Parameter = std::tuple_element_t<Index, std::tuple<Parameters...>>;
+
+    static const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& GetDesc()
+    {
+        static const std::array<D3D12_ROOT_PARAMETER1, NumParameters> parameters = { { Parameters::GetDesc()... } };
+        static const D3D12_VERSIONED_ROOT_SIGNATURE_DESC desc = MakeDesc(parameters.data());
+        return desc;
+    }
+
+    // 设置根常量 of the RootConstants parameter at Index, the value must have its type.
+    template<uint32_t Index, typename T>
+    static void SetGraphicsRootConstants(ID3D12GraphicsCommandList* pCommandList, const T& value)
+    {
+        static_assert(std::is_same<T, typename Parameter<Index>::Type>::value,
+            "The value does not have the type of the root constants.");
+        pCommandList->SetGraphicsRoot32BitConstants(Index, Parameter<Index>::Cost, &value, 0);
+    }
+
+private:
+    static D3D12_VERSIONED_ROOT_SIGNATURE_DESC MakeDesc(const D3D12_ROOT_PARAMETER1* pParameters)
+    {
+        D3D12_VERSIONED_ROOT_SIGNATURE_DESC desc = {};
+        desc.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
+        desc.Desc_1_1.NumParameters = NumParameters;
+        desc.Desc_1_1.pParameters = NumParameters > 0 ? pParameters : nullptr;
+        desc.Desc_1_1.Flags = Flags;
+        return desc;
+    }
+};
+
+/**
+ * Subobject of a pipeline state stream: the subobject type followed by its
+ * description, pointer aligned like CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT,
+ * but usable in constant expressions.
+ */
+template<typename Inner, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE SubobjectType>
+struct alignas(void*) PipelineStateStreamSubobject
+{
+    D3D12_PIPELINE_STATE_SUBOBJECT_TYPE Type = SubobjectType;
+    Inner Value = {};
+};
+
+// The defaults of CD3DX12_RASTERIZER_DESC, CD3DX12_BLEND_DESC and CD3DX12_DEPTH_STENCIL_DESC.
+constexpr D3D12_RASTERIZER_DESC GetDefaultRasterizerDesc()
+{
+    D3D12_RASTERIZER_DESC desc = {};
+    desc.FillMode = D3D12_FILL_MODE_SOLID;
+    desc.CullMode = D3D12_CULL_MODE_BACK;
+    desc.FrontCounterClockwise = FALSE;
+    desc.DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
+    desc.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
+    desc.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
+    desc.DepthClipEnable = TRUE;
+    desc.MultisampleEnable = FALSE;
+    desc.AntialiasedLineEnable = FALSE;
+    desc.ForcedSampleCount = 0;
+    desc.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+    return desc;
+}
+
+constexpr D3D12_BLEND_DESC GetDefaultBlendDesc()
+{
+    D3D12_BLEND_DESC desc = {};
+    desc.AlphaToCoverageEnable = FALSE;
+    desc.IndependentBlendEnable = FALSE;
+    for (D3D12_RENDER_TARGET_BLEND_DESC& renderTarget : desc.RenderTarget)
+    {
+        renderTarget.BlendEnable = FALSE;
+        renderTarget.LogicOpEnable = FALSE;
+        renderTarget.SrcBlend = D3D12_BLEND_ONE;
+        renderTarget.DestBlend = D3D12_BLEND_ZERO;
+        renderTarget.BlendOp = D3D12_BLEND_OP_ADD;
+        renderTarget.SrcBlendAlpha = D3D12_BLEND_ONE;
+        renderTarget.DestBlendAlpha = D3D12_BLEND_ZERO;
+        renderTarget.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+        renderTarget.LogicOp = D3D12_LOGIC_OP_NOOP;
+        renderTarget.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+    }
+    return desc;
+}
+
+constexpr D3D12_DEPTH_STENCIL_DESC GetDefaultDepthStencilDesc()
+{
+    D3D12_DEPTH_STENCIL_DESC desc = {};
+    desc.DepthEnable = TRUE;
+    desc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+    desc.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+    desc.StencilEnable = FALSE;
+    desc.StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
+    desc.StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
+    desc.FrontFace = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+    desc.BackFace = desc.FrontFace;
+    return desc;
+}
+
+/**
+ * 图形管线状态流. The root signature and the shaders are left empty and filled
+ * in when the pipeline state is created, everything else is meant to be a
+ * constant:
+ *
+ *     constexpr GraphicsPipelineStream stream = GraphicsPipelineStream()
+ *         .WithInputLayout<Vertex>()
+ *         .WithRenderTargetFormat(0, DXGI_FORMAT_R8G8B8A8_UNORM)
+ *         .WithDepthStencilFormat(DXGI_FORMAT_D32_FLOAT);
+ */
+struct GraphicsPipelineStream
+{
+    PipelineStateStreamSubobject<ID3D12RootSignature*, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE> RootSignature;
+    PipelineStateStreamSubobject<D3D12_INPUT_LAYOUT_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT> InputLayout;
+    PipelineStateStreamSubobject<D3D12_PRIMITIVE_TOPOLOGY_TYPE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY> PrimitiveTopologyType =
+        { D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY, D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE };
+    PipelineStateStreamSubobject<D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS> VS;
+    PipelineStateStreamSubobject<D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS> PS;
+    PipelineStateStreamSubobject<D3D12_RASTERIZER_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER> RasterizerState =
+        { D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER, GetDefaultRasterizerDesc() };
+    PipelineStateStreamSubobject<D3D12_BLEND_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND> BlendState =
+        { D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND, GetDefaultBlendDesc() };
+    PipelineStateStreamSubobject<D3D12_DEPTH_STENCIL_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL> DepthStencilState =
+        { D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL, GetDefaultDepthStencilDesc() };
+    PipelineStateStreamSubobject<DXGI_FORMAT, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT> DSVFormat;
+    PipelineStateStreamSubobject<D3D12_RT_FORMAT_ARRAY, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS> RTVFormats;
+
+    template<typename Vertex>
+    constexpr GraphicsPipelineStream WithInputLayout() const
+    {
+        GraphicsPipelineStream stream = *this;
+        stream.InputLayout.Value = ::InputLayout<Vertex>::Desc;
+        return stream;
+    }
+
+    constexpr GraphicsPipelineStream WithPrimitiveTopologyType(D3D12_PRIMITIVE_TOPOLOGY_TYPE primitiveTopologyType) const
+    {
+        GraphicsPipelineStream stream = *this;
+        stream.PrimitiveTopologyType.Value = primitiveTopologyType;
+        return stream;
+    }
+
+    constexpr GraphicsPipelineStream WithRasterizerState(const D3D12_RASTERIZER_DESC& rasterizerState) const
+    {
+        GraphicsPipelineStream stream = *this;
+        stream.RasterizerState.Value = rasterizerState;
+        return stream;
+    }
+
+    constexpr GraphicsPipelineStream WithBlendState(const D3D12_BLEND_DESC& blendState) const
+    {
+        GraphicsPipelineStream stream = *this;
+        stream.BlendState.Value = blendState;
+        return stream;
+    }
+
+    constexpr GraphicsPipelineStream WithDepthStencilState(const D3D12_DEPTH_STENCIL_DESC& depthStencilState) const
+    {
+        GraphicsPipelineStream stream = *this;
+        stream.DepthStencilState.Value = depthStencilState;
+        return stream;
+    }
+
+    // Render targets 0 to index - 1 have to be set as well.
+    constexpr GraphicsPipelineStream WithRenderTargetFormat(UINT index, DXGI_FORMAT format) const
+    {
+        GraphicsPipelineStream stream = *this;
+        stream.RTVFormats.Value.RTFormats[index] = format;
+        stream.RTVFormats.Value.NumRenderTargets = index + 1 > stream.RTVFormats.Value.NumRenderTargets ?
+            index + 1 : stream.RTVFormats.Value.NumRenderTargets;
+        return stream;
+    }
+
+    constexpr GraphicsPipelineStream WithDepthStencilFormat(DXGI_FORMAT format) const
+    {
+        GraphicsPipelineStream stream = *this;
+        stream.DSVFormat.Value = format;
+        return stream;
+    }
+};
@@ -0,0 +1,104 @@
+/**
+* Cache of pipeline states and root signatures.
+*
+* Pipeline states are keyed by the whole pipeline state stream (PipelineStateHasher):
+* the shader bytecode, the root signature, the input layout, the formats and
+* all other state. A pipeline state that was created before is returned from
+* memory. New pipeline states are stored in an ID3D12PipelineLibrary, which is
+* written to a cache file by Save and loaded again on the next run, so the
+* driver compiles every pipeline only once instead of on every launch.
+*
+* The cache file is checked when it is loaded (PipelineCacheIndex): a file of
+* another format version, adapter or driver, or a damaged file, is ignored and
+* the pipelines are compiled again. Without pipeline library support the cache
+* only works in memory.
+*
+* Root signatures must be created with CreateRootSignature, the cache tags them
+* with the hash of their serialized blob so they can be part of the key.
+* Thread safe, a pipeline state that is requested by several threads at once is
+* only created once.
+*/
+#pragma once
+
+#include <PipelineCacheIndex.h>
+
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class PipelineStateCache
+{
+public:
+    struct Statistics
+    {
+        uint32_t NumPipelineStates = 0;
+        uint32_t NumRootSignatures = 0;
+        // Pipeline states in the pipeline library (loaded and stored).
+        uint32_t NumLibraryPipelineStates = 0;
+        // Totals over the lifetime of the cache.
+        uint32_t NumMemoryHits = 0;
+        uint32_t NumLibraryHits = 0;
+        uint32_t NumCompiled = 0;
+        // True if the pipeline library was loaded from the cache file.
+        bool LoadedFromFile = false;
+    };
+
+    PipelineStateCache(Microsoft::WRL::ComPtr<ID3D12Device2> device, Microsoft::WRL::ComPtr<IDXGIAdapter4> adapter,
+        const std::wstring& fileName);
+    // Saves the cache file.
+    virtual ~PipelineStateCache();
+
+    /**
+     * 创建根签名 from a serialized root signature, or return the existing one.
+     */
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> CreateRootSignature(const void* pBlob, size_t size);
+
+    /**
+     * 创建管线状态, or return the existing one. The stream must use a root
+     * signature of CreateRootSignature.
+     */
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC& desc);
+
+    // The key of a pipeline state stream, 0 if it can not be cached.
+    uint64_t GetPipelineStateKey(const D3D12_PIPELINE_STATE_STREAM_DESC& desc) const;
+
+    /**
+     * 保存缓存文件 if new pipeline states were stored. The file is replaced
+     * atomically, a crash while saving keeps the previous file.
+     */
+    bool Save();
+
+    Statistics GetStatistics() const;
+
+private:
+    PipelineStateCache(const PipelineStateCache& copy) = delete;
+    PipelineStateCache& operator=(const PipelineStateCache& other) = delete;
+
+    // Create the pipeline library from the cache file, or an empty one.
+    void CreatePipelineLibrary();
+    // Load the pipeline state from the library or compile (and store) it.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> LoadOrCompile(uint64_t key, const D3D12_PIPELINE_STATE_STREAM_DESC& desc);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
+    std::wstring m_FileName;
+
+    // Null if pipeline libraries are not supported.
+    Microsoft::WRL::ComPtr<ID3D12PipelineLibrary1> m_d3d12PipelineLibrary;
+    // Contents of the cache file, the library uses the blob in place.
+    std::vector<uint8_t> m_FileData;
+    PipelineCacheIndex m_Index;
+
+    using PipelineStateFuture = std::shared_future< Microsoft::WRL::ComPtr<ID3D12PipelineState> >;
+    std::unordered_map<uint64_t, PipelineStateFuture> m_PipelineStates;
+    std::unordered_map< uint64_t, Microsoft::WRL::ComPtr<ID3D12RootSignature> > m_RootSignatures;
+
+    Statistics m_Statistics;
+    mutable std::mutex m_Mutex;
+};
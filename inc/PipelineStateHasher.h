@@ -0,0 +1,65 @@
+/**
+* Key of a pipeline state for the pipeline state cache.
+*
+* Pure C++ (the subobjects are fed in by PipelineStateCache), so keys can be
+* checked without a GPU. Every subobject of a pipeline state stream is hashed
+* on its own and the subobject hashes are combined in subobject type order, so
+* two streams that describe the same pipeline with their subobjects in a
+* different order get the same key. Pointers are never hashed: shaders are
+* keyed by their bytecode, root signatures by their serialized blob and input
+* layouts by their semantic names, so keys are stable across runs.
+*/
+#pragma once
+
+#include <Hash.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Hash of compiled shader bytecode. Uses the digest in the header of signed
+ * DXBC/DXIL containers and hashes the whole bytecode otherwise.
+ */
+uint64_t HashShaderBytecode(const void* pBytecode, size_t size);
+
+class PipelineStateHasher
+{
+public:
+    // Larger than the number of D3D12_PIPELINE_STATE_SUBOBJECT_TYPEs.
+    static const uint32_t MaxSubobjectTypes = 32;
+
+    PipelineStateHasher();
+    virtual ~PipelineStateHasher();
+
+    void Reset();
+
+    /**
+     * 开始一个子对象. The values added until the next BeginSubobject belong to it.
+     * A subobject type that is given twice replaces the earlier one, like in D3D12.
+     */
+    void BeginSubobject(uint32_t type);
+
+    template<typename T>
+    void AddValue(const T& value)
+    {
+        m_Hash = HashValue(value, m_Hash);
+    }
+
+    void AddBytes(const void* pData, size_t size);
+    // nullptr and "" hash differently.
+    void AddString(const char* pString);
+    // Shader bytecode, see HashShaderBytecode.
+    void AddShader(const void* pBytecode, size_t size);
+
+    // The key of the pipeline state, never 0.
+    uint64_t GetKey() const;
+
+private:
+    void EndSubobject();
+
+    uint64_t m_SubobjectHashes[MaxSubobjectTypes];
+    uint32_t m_SubobjectMask;
+
+    uint32_t m_CurrentType;
+    uint64_t m_Hash;
+};
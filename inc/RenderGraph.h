@@ -0,0 +1,92 @@
+/**
+* Render graph (frame graph): the passes of a frame declare the resources they
+* read and write, the graph records the barriers between them.
+*
+* Built again every frame: Reset, import the resources, add the passes with
+* their accesses, Compile and Execute. The decisions (culling, order, barrier
+* batches, split barriers, queues and fence waits) are made by the
+* RenderGraphCompiler, Execute only records them. Every barrier batch is one
+* ResourceBarrier call.
+*/
+#pragma once
+
+#include <RenderGraphCompiler.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class RenderGraph
+{
+public:
+    // Records the commands of a pass, the barriers of its resources are already recorded.
+    using ExecuteFunc = std::function<void(ID3D12GraphicsCommandList2* pCommandList)>;
+
+    RenderGraph();
+    virtual ~RenderGraph();
+
+    // Start a new frame, the passes and resources of the last one are removed.
+    void Reset();
+
+    // Compute and copy passes run on their own queues, on the direct queue otherwise.
+    void SetAsyncQueues(bool enabled)
+    {
+        m_Compiler.SetAsyncQueues(enabled);
+    }
+
+    /**
+     * 导入资源 that is used after the frame (the back buffer), it ends the frame in finalState.
+     * @returns The index of the resource.
+     */
+    uint32_t ImportResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES initialState, D3D12_RESOURCE_STATES finalState);
+
+    // 添加资源 that is only used in the frame (transient targets), it starts and ends the frame in state.
+    uint32_t AddResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state);
+
+    /**
+     * 添加渲染通道, in submission order.
+     * @param type The queue the pass prefers, D3D12_COMMAND_LIST_TYPE_DIRECT, _COMPUTE or _COPY.
+     * @param hasSideEffects Never cull the pass, even if nothing uses what it writes.
+     * @returns The index of the pass.
+     */
+    uint32_t AddPass(D3D12_COMMAND_LIST_TYPE type, ExecuteFunc execute, bool hasSideEffects = false);
+
+    void Read(uint32_t pass, uint32_t resource, D3D12_RESOURCE_STATES state);
+    void Write(uint32_t pass, uint32_t resource, D3D12_RESOURCE_STATES state);
+
+    void Compile();
+
+    /**
+     * 执行: record the passes that were not culled. Direct passes are recorded into
+     * commandList, which the caller executes. Compute and copy passes are recorded on
+     * their own queues and executed here, with the fence waits the compiler planned.
+     * If another queue has to wait for a direct pass, commandList is executed early.
+     * The direct queue waits for the final barriers of the other queues, so the
+     * resources are in their final states (the back buffer can be presented) once
+     * the returned command list is done.
+     * @returns The direct command list to continue with.
+     */
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> Execute(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList);
+
+    const RenderGraphCompiler& GetCompiler() const
+    {
+        return m_Compiler;
+    }
+
+private:
+    RenderGraph(const RenderGraph& copy) = delete;
+    RenderGraph& operator=(const RenderGraph& other) = delete;
+
+    void ResourceBarriers(ID3D12GraphicsCommandList2* pCommandList, const std::vector<RenderGraphCompiler::Barrier>& barriers);
+
+    RenderGraphCompiler m_Compiler;
+
+    std::vector<ExecuteFunc> m_Passes;
+    std::vector<ID3D12Resource*> m_Resources;
+
+    // Reused by ResourceBarriers.
+    std::vector<D3D12_RESOURCE_BARRIER> m_Barriers;
+};
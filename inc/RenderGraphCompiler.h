@@ -0,0 +1,255 @@
+/**
+* Compiler of the render graph (frame graph), see RenderGraph.
+*
+* Pure C++ like TransientResourcePlanner, so the compiled frame can be checked
+* without a GPU. Passes declare which resources they read and write and in
+* which state, the states are D3D12_RESOURCE_STATES values. Compile
+*  - assigns the passes to queues (compute and copy passes run on the graphics
+*    queue unless async queues are enabled),
+*  - culls the passes whose results are not used: a pass is kept if it has
+*    side effects, writes an imported resource or produces data for a kept pass,
+*  - sorts the passes topologically, async passes first among the ready ones
+*    so they overlap the graphics work, otherwise in declaration order,
+*  - computes the barriers: one batch before every pass, consecutive reads on
+*    a queue are merged into one transition to the combined read state,
+*    transitions that have passes in between on the same queue are split
+*    (begin right after the previous use, end before the next one), and
+*    writes in the unordered access state get UAV barriers,
+*  - keeps the transitions legal on their queue: a transition from or to a
+*    state that the compute or copy queue does not support (render target,
+*    depth, pixel shader resource, ...) is made by the queue of the previous
+*    use, right after that pass and before its signal. A pass for which that
+*    is not possible either runs on the graphics queue,
+*  - computes the fence waits between queues, a queue waits for another one
+*    only if it did not already wait for that point or a later one. At the
+*    end of the frame the graphics queue waits for the final transitions of
+*    the other queues, so everything is done before Present.
+* The result only depends on the declarations, never on pointers or timing.
+*/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class RenderGraphCompiler
+{
+public:
+    static const uint32_t InvalidIndex = ~0u;
+
+    // D3D12_RESOURCE_STATE_COMMON and D3D12_RESOURCE_STATE_UNORDERED_ACCESS.
+    static const uint32_t CommonState = 0x0;
+    static const uint32_t UnorderedAccessState = 0x8;
+    // States a compute queue can transition from and to, besides the common state: vertex and constant buffer,
+    // unordered access, non pixel shader resource, indirect argument, copy destination and copy source.
+    static const uint32_t ComputeQueueStates = 0x1 | 0x8 | 0x40 | 0x200 | 0x400 | 0x800;
+    // Copy destination and copy source.
+    static const uint32_t CopyQueueStates = 0x400 | 0x800;
+
+    enum class Queue : uint32_t
+    {
+        Graphics,
+        Compute,
+        Copy,
+    };
+
+    static const uint32_t NumQueues = 3;
+
+    enum class BarrierType : uint32_t
+    {
+        Transition,
+        UnorderedAccess,
+    };
+
+    enum class BarrierSplit : uint32_t
+    {
+        None,
+        Begin,
+        End,
+    };
+
+    struct Barrier
+    {
+        BarrierType Type;
+        BarrierSplit Split;
+        uint32_t Resource;
+        // Unused for UAV barriers.
+        uint32_t StateBefore;
+        uint32_t StateAfter;
+    };
+
+    struct QueueWait
+    {
+        Queue WaitQueue;
+        // Position in the compiled order of the pass that has to be finished,
+        // InvalidIndex for the end of the queue (its final barriers).
+        uint32_t Position;
+    };
+
+    struct CompiledPass
+    {
+        // Index returned by AddPass.
+        uint32_t Pass;
+        Queue PassQueue;
+        // Fence waits on the other queues before the pass.
+        std::vector<QueueWait> Waits;
+        // One ResourceBarrier batch before the pass.
+        std::vector<Barrier> Barriers;
+        // One batch after the pass, before the signal: transitions the queue of the next use can not make.
+        std::vector<Barrier> BarriersAfter;
+        // Another queue waits for this pass, signal a fence after it.
+        bool Signal;
+    };
+
+    struct Statistics
+    {
+        uint32_t NumPasses = 0;
+        uint32_t NumCulledPasses = 0;
+        uint32_t NumBarriers = 0;
+        uint32_t NumSplitBarriers = 0;
+        // Non-empty batches, each is one ResourceBarrier call.
+        uint32_t NumBarrierBatches = 0;
+        uint32_t NumQueueWaits = 0;
+    };
+
+    RenderGraphCompiler();
+    virtual ~RenderGraphCompiler();
+
+    void Clear();
+
+    // Compute and copy passes run on their own queues, on the graphics queue otherwise.
+    void SetAsyncQueues(bool enabled)
+    {
+        m_AsyncQueues = enabled;
+    }
+
+    /**
+     * 导入资源: used outside of the graph (the back buffer), the passes that write
+     * it are never culled. It is transitioned to finalState at the end of the frame.
+     * @returns The index of the resource.
+     */
+    uint32_t ImportResource(uint32_t initialState, uint32_t finalState);
+
+    // 添加资源 that only lives in the graph, it starts and ends the frame in state.
+    uint32_t AddResource(uint32_t state);
+
+    // 添加渲染通道. @returns The index of the pass, passes are declared in submission order.
+    uint32_t AddPass(Queue queue, bool hasSideEffects = false);
+
+    // Declare an access of the pass, once per resource and pass.
+    void Read(uint32_t pass, uint32_t resource, uint32_t state);
+    void Write(uint32_t pass, uint32_t resource, uint32_t state);
+
+    void Compile();
+
+    // The passes that are executed, in execution order.
+    const std::vector<CompiledPass>& GetCompiledPasses() const
+    {
+        return m_CompiledPasses;
+    }
+
+    // Barriers at the end of the queue, the transitions to the final states.
+    const std::vector<Barrier>& GetFinalBarriers(Queue queue) const
+    {
+        return m_FinalBarriers[static_cast<uint32_t>(queue)];
+    }
+
+    // Fence waits of the graphics queue before its final barriers, the frame is complete after them.
+    const std::vector<QueueWait>& GetFinalWaits() const
+    {
+        return m_FinalWaits;
+    }
+
+    // Can a command list of the queue transition from and to the state?
+    static bool IsStateSupported(Queue queue, uint32_t state);
+
+    bool IsCulled(uint32_t pass) const
+    {
+        return m_Passes[pass].Position == InvalidIndex;
+    }
+
+    uint32_t GetNumPasses() const
+    {
+        return static_cast<uint32_t>(m_Passes.size());
+    }
+
+    uint32_t GetNumResources() const
+    {
+        return static_cast<uint32_t>(m_Resources.size());
+    }
+
+    Statistics GetStatistics() const;
+
+private:
+    struct Access
+    {
+        uint32_t Resource;
+        uint32_t State;
+        bool IsWrite;
+    };
+
+    struct Pass
+    {
+        Queue RequestedQueue;
+        Queue AssignedQueue;
+        bool HasSideEffects;
+        std::vector<Access> Accesses;
+        // Passes this one has to run after (read after write, write after read and write after write).
+        std::vector<uint32_t> Dependencies;
+        // The subset whose results this pass uses (read after write and write after write).
+        std::vector<uint32_t> DataDependencies;
+        // Position in m_CompiledPasses, InvalidIndex if culled.
+        uint32_t Position;
+    };
+
+    struct Resource
+    {
+        uint32_t InitialState;
+        uint32_t FinalState;
+        bool IsImported;
+    };
+
+    // State of a resource while the barriers are computed.
+    struct ResourceTracker
+    {
+        uint32_t State;
+        bool LastAccessIsWrite;
+        // Position of the last pass that used the resource, InvalidIndex before the first use.
+        uint32_t LastPosition;
+        Queue LastQueue;
+        // Position of the pass whose barriers made the last transition, InvalidIndex if none.
+        uint32_t TransitionPosition;
+    };
+
+    void AddAccess(uint32_t pass, uint32_t resource, uint32_t state, bool isWrite);
+
+    void AssignQueues();
+    void BuildDependencies();
+    void CullPasses();
+    void SortPasses();
+    /**
+     * Barriers and waits of the compiled passes and the transitions to the final states.
+     * @returns false if a pass was moved to the graphics queue, then the passes are sorted again.
+     */
+    bool ComputeBarriers();
+    void ResetCompiledPasses();
+
+    // Adds a transition at position, split if the previous use on the same queue leaves room.
+    void AddTransition(uint32_t resource, const ResourceTracker& tracker, uint32_t position, Queue queue,
+        uint32_t stateAfter);
+    // Make the pass at position wait for the pass at waitPosition if they run on different queues.
+    void AddWait(uint32_t position, uint32_t waitPosition);
+    // Position of the next pass on the queue after position (InvalidIndex for the first one), or InvalidIndex.
+    uint32_t GetNextPositionOnQueue(Queue queue, uint32_t position) const;
+
+    std::vector<Pass> m_Passes;
+    std::vector<Resource> m_Resources;
+    bool m_AsyncQueues;
+
+    std::vector<CompiledPass> m_CompiledPasses;
+    std::vector<Barrier> m_FinalBarriers[NumQueues];
+    std::vector<QueueWait> m_FinalWaits;
+    // Positions of the compiled passes of each queue, in order.
+    std::vector<uint32_t> m_QueuePositions[NumQueues];
+    // Latest position of the other queues that each queue waited for.
+    uint32_t m_LastWaits[NumQueues][NumQueues];
+};
@@ -0,0 +1,75 @@
+/**
+* Keeps the video memory use of the process within the budget the OS gives it.
+*
+* Tracks pageable objects (the heaps of the GPU memory allocator) with their
+* size and the fence value of the last submission that used them. Before a
+* submission the local memory budget is queried and, when the process is over
+* budget, the least recently used objects the GPU has finished with are evicted
+* (ID3D12Device::Evict). Evicted objects are made resident again as soon as a
+* submission uses them. The decisions are made by ResidencyPolicy.
+*
+* Fence values are those of the direct queue. Work on other queues must make
+* its objects resident immediately (MakeResident) and be waited on by the
+* direct queue, which the asset streamer does.
+*/
+#pragma once
+
+#include <ResidencyPolicy.h>
+
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <wrl.h>
+
+#include <mutex>
+
+class ResidencyManager
+{
+public:
+    ResidencyManager(Microsoft::WRL::ComPtr<ID3D12Device2> device, Microsoft::WRL::ComPtr<IDXGIAdapter3> adapter);
+    virtual ~ResidencyManager();
+
+    // Track a new (resident) pageable object. Thread safe.
+    void Track(ID3D12Pageable* pObject, uint64_t size);
+
+    // Stop tracking an object before it is released. Thread safe.
+    void Untrack(ID3D12Pageable* pObject);
+
+    /**
+     * 标记对象被下一次提交使用. It is made resident by PrepareSubmission if it was evicted. Thread safe.
+     */
+    void MarkUsed(ID3D12Pageable* pObject);
+
+    /**
+     * Make the object resident right away, for work that is not submitted through
+     * PrepareSubmission (for example copies on the copy queue). Thread safe.
+     */
+    void MakeResident(ID3D12Pageable* pObject);
+
+    /**
+     * Call right before executing a command list on the direct queue: pages in the
+     * objects marked used and evicts least recently used objects while over budget.
+     * @param completedFenceValue The completed fence value of the direct queue.
+     */
+    void PrepareSubmission(uint64_t completedFenceValue);
+
+    // Call with the fence value returned by CommandQueue::ExecuteCommandList.
+    void Submitted(uint64_t fenceValue);
+
+    // Budget and usage of the local (video memory) segment group.
+    DXGI_QUERY_VIDEO_MEMORY_INFO QueryVideoMemoryInfo() const;
+
+    ResidencyPolicy::Statistics GetStatistics() const;
+
+private:
+    ResidencyManager(const ResidencyManager& copy) = delete;
+    ResidencyManager& operator=(const ResidencyManager& other) = delete;
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
+    Microsoft::WRL::ComPtr<IDXGIAdapter3> m_dxgiAdapter;
+
+    ResidencyPolicy m_Policy;
+    ResidencyPolicy::Operations m_Operations;
+    bool m_OverBudget;
+
+    mutable std::mutex m_Mutex;
+};
@@ -0,0 +1,109 @@
+/**
+* Residency policy core used by the residency manager.
+*
+* Pure C++ like HeapAllocator: the pageable objects are opaque pointers and the
+* video memory budget is passed in, so the eviction decisions can be driven
+* with a simulated budget. The policy only decides, the caller performs the
+* MakeResident / Evict calls it returns.
+*
+* Objects are ordered least recently used first. Before a submission every
+* object used by it is made resident, and while the usage is over the budget
+* the least recently used objects that the GPU has finished with are evicted.
+* An object is never evicted while it is used by the upcoming submission or by
+* work that has not completed yet (its last used fence value is not reached).
+*/
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+class ResidencyPolicy
+{
+public:
+    struct Statistics
+    {
+        uint32_t NumObjects = 0;
+        uint32_t NumResidentObjects = 0;
+        uint64_t ResidentSize = 0;
+        uint64_t EvictedSize = 0;
+        // Totals over the lifetime of the policy.
+        uint64_t NumEvictions = 0;
+        uint64_t NumMakeResidents = 0;
+    };
+
+    // Paging operations to perform before a submission, evictions first.
+    struct Operations
+    {
+        std::vector<void*> Evict;
+        std::vector<void*> MakeResident;
+        // Still over budget after evicting everything the GPU is not using.
+        bool OverBudget = false;
+    };
+
+    ResidencyPolicy();
+    virtual ~ResidencyPolicy();
+
+    /**
+     * 跟踪一个新对象. Objects are resident when they are created and count as
+     * used by the next submission, which usually initializes them.
+     */
+    void Add(void* pObject, uint64_t size);
+
+    // Stop tracking an object, for example right before it is destroyed.
+    void Remove(void* pObject);
+
+    /**
+     * The object is used by the next submission.
+     * @returns true if the object is evicted and will be made resident by PrepareSubmission.
+     */
+    bool MarkUsed(void* pObject);
+
+    // The caller made an evicted object resident itself; it also counts as used.
+    void MarkResident(void* pObject);
+
+    /**
+     * Decide the paging operations for the next submission.
+     * @param budget, currentUsage The local memory budget and usage of the process (QueryVideoMemoryInfo).
+     * @param completedFenceValue Objects last used at or before this fence value may be evicted.
+     */
+    void PrepareSubmission(uint64_t budget, uint64_t currentUsage, uint64_t completedFenceValue, Operations& operations);
+
+    /**
+     * The submission was executed and signals fenceValue, which becomes the last used
+     * fence value of every object marked used since the previous submission.
+     */
+    void Submitted(uint64_t fenceValue);
+
+    bool IsTracked(void* pObject) const;
+    bool IsResident(void* pObject) const;
+
+    Statistics GetStatistics() const;
+
+private:
+    ResidencyPolicy(const ResidencyPolicy& copy) = delete;
+    ResidencyPolicy& operator=(const ResidencyPolicy& other) = delete;
+
+    struct Object
+    {
+        uint64_t Size;
+        uint64_t LastUsedFenceValue;
+        bool Resident;
+        // Used by the next submission.
+        bool Pending;
+        // Position in m_LRUList.
+        std::list<void*>::iterator LRUPosition;
+    };
+
+    void Touch(void* pObject, Object& object);
+
+    std::unordered_map<void*, Object> m_Objects;
+    // All tracked objects, least recently used first.
+    std::list<void*> m_LRUList;
+    // Objects marked used since the last submission.
+    std::vector<void*> m_PendingObjects;
+
+    uint64_t m_NumEvictions;
+    uint64_t m_NumMakeResidents;
+};
@@ -0,0 +1,92 @@
+/**
+* Compiled shaders (.cso) loaded from disk, with hot reloading.
+*
+* Every shader file is read once (memory mapped and copied, so the file is not
+* kept open and can be overwritten by the shader compiler) and hashed with
+* HashShaderBytecode, the same hash the pipeline state cache keys shaders with.
+* Loads can run on the thread pool (LoadAsync).
+*
+* The loaded files are watched (FileWatcher). Update rereads the files that
+* were changed in the background and returns the shaders whose bytecode
+* really changed, so only the pipeline states that use them have to be
+* rebuilt (PipelineBuilder::Rebuild). Thread safe.
+*/
+#pragma once
+
+#include <FileWatcher.h>
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+class ShaderLibrary
+{
+public:
+    struct Shader
+    {
+        std::wstring FileName;
+        std::vector<uint8_t> Bytecode;
+        // HashShaderBytecode of the bytecode.
+        uint64_t Hash = 0;
+    };
+
+    // A loaded version of a shader, stays valid after the shader was reloaded.
+    using ShaderPtr = std::shared_ptr<const Shader>;
+
+    /**
+     * @param pThreadPool Runs LoadAsync and the reloads, nullptr to do them on the calling thread.
+     */
+    explicit ShaderLibrary(ThreadPool* pThreadPool);
+    virtual ~ShaderLibrary();
+
+    /**
+     * 加载着色器, or return the loaded version.
+     * @returns nullptr if the file could not be read.
+     */
+    ShaderPtr Load(const std::wstring& fileName);
+
+    std::shared_future<ShaderPtr> LoadAsync(const std::wstring& fileName);
+
+    /**
+     * 热重载: start rereading the shader files that changed on disk and collect
+     * the reloads that finished. Call once per frame.
+     * @returns The shaders whose bytecode changed since the last call.
+     */
+    std::vector<ShaderPtr> Update();
+
+    // Normalized file name used as the key, ShaderLibrary::Shader::FileName.
+    static std::wstring GetKey(const std::wstring& fileName);
+
+private:
+    ShaderLibrary(const ShaderLibrary& copy) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary& other) = delete;
+
+    using ShaderFuture = std::shared_future<ShaderPtr>;
+
+    // A reload started by Update.
+    struct Reload
+    {
+        ShaderFuture Shader;
+        // The file changed again while it was read, the result is dropped and the file is read once more.
+        bool ChangedAgain = false;
+    };
+
+    static ShaderPtr ReadShader(const std::wstring& fileName);
+    // Called with the mutex held.
+    void StartReload(const std::wstring& fileName);
+
+    ThreadPool* m_pThreadPool;
+
+    // Current version of every shader, loads in progress are futures that are not ready yet.
+    std::unordered_map<std::wstring, ShaderFuture> m_Shaders;
+    std::unordered_map<std::wstring, Reload> m_Reloads;
+
+    FileWatcher m_FileWatcher;
+    std::mutex m_Mutex;
+};
@@ -0,0 +1,63 @@
+/**
+* Order 3 (9 coefficient) spherical harmonics for diffuse lighting.
+*
+* The radiance of a cubemap or an HDR panorama is projected onto the nine real
+* SH basis functions, every texel weighted with its solid angle. Convolving the
+* result with the cosine lobe gives the irradiance of any normal from just 27
+* floats, which the pixel shader reads as root constants (see
+* shaders/SphericalHarmonics.hlsli) instead of sampling an irradiance cubemap.
+*
+* Basis order: Y00, Y1-1 (y), Y10 (z), Y11 (x), Y2-2 (xy), Y2-1 (yz), Y20, Y21 (xz), Y22.
+*/
+#pragma once
+
+#include <TextureData.h>
+
+#include <cstdint>
+
+class ThreadPool;
+
+const uint32_t SH9CoefficientCount = 9;
+
+// Root constants of SH9Constants: 27 floats padded to whole float4 registers.
+const uint32_t SH9RootConstantCount = 28;
+
+// RGB coefficients of the nine basis functions.
+struct SH9Color
+{
+    float Coefficients[SH9CoefficientCount][3];
+};
+
+/**
+ * SH9Color in the layout of the HLSL SH9Constants struct: the coefficients are
+ * premultiplied with the basis constants and tightly packed into 7 float4, so the
+ * shader evaluates the irradiance with a handful of multiply-adds.
+ */
+struct SH9Constants
+{
+    float Values[SH9RootConstantCount];
+};
+
+/**
+ * Project a cubemap (RGBA32F or RGBA16F, mip 0) onto the SH basis.
+ * Each face is projected by its own task.
+ */
+bool ProjectCubemapSH9(const TextureData& cubemap, SH9Color& sh, ThreadPool* pThreadPool = nullptr);
+
+/**
+ * Project an equirectangular panorama (RGBA32F or RGBA16F, mip 0) onto the SH basis,
+ * see GetPanoramaDirection for the mapping.
+ */
+bool ProjectPanoramaSH9(const TextureData& panorama, SH9Color& sh, ThreadPool* pThreadPool = nullptr);
+
+/**
+ * Convolve projected radiance with the cosine lobe. The result is the irradiance divided
+ * by pi, the same convention as ComputeIrradiance, so the shader only multiplies by the albedo.
+ */
+void ConvolveSH9Irradiance(SH9Color& sh);
+
+// Evaluate the SH at a normalized direction.
+void EvaluateSH9(const SH9Color& sh, const float* pDirection, float* pColor);
+
+// Fill the root constants read by EvaluateSH9 in shaders/SphericalHarmonics.hlsli.
+void PackSH9Constants(const SH9Color& sh, SH9Constants& constants);
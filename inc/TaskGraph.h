@@ -0,0 +1,97 @@
+/**
+* A graph of tasks with dependencies, run on the thread pool.
+*
+* Used for startup work that forms chains (load shader -> create pipeline
+* state): a task is started as soon as all of its dependencies have finished,
+* instead of waiting for a whole stage to complete. Every task belongs to a
+* phase, Run measures how long each phase took.
+*
+* Dependencies must be added before the tasks that depend on them, so the
+* graph can not contain cycles. Like ThreadPool::ParallelFor the calling
+* thread helps running the tasks, so Run can be called from inside a task.
+*/
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+class TaskGraph
+{
+public:
+    struct PhaseTiming
+    {
+        std::string Name;
+        uint32_t NumTasks = 0;
+        // Time spent in the tasks of the phase, summed over all threads.
+        double TaskSeconds = 0.0;
+        // Wall clock range of the phase, relative to the start of Run.
+        double StartSeconds = 0.0;
+        double EndSeconds = 0.0;
+    };
+
+    TaskGraph();
+    virtual ~TaskGraph();
+
+    void Clear();
+
+    // 添加一个阶段. @returns The index of the phase.
+    uint32_t AddPhase(const std::string& name);
+
+    /**
+     * 添加一个任务.
+     * @param dependencies Tasks that must finish before this one starts.
+     * @returns The index of the task.
+     */
+    uint32_t AddTask(uint32_t phase, std::function<void()> func, const std::vector<uint32_t>& dependencies = {});
+
+    uint32_t GetNumTasks() const
+    {
+        return static_cast<uint32_t>(m_Tasks.size());
+    }
+
+    /**
+     * 运行所有任务 on the thread pool, or serially in order if pThreadPool is nullptr.
+     * If a task throws, the tasks that depend on it are skipped and the first
+     * exception is rethrown once all other tasks have finished.
+     */
+    void Run(ThreadPool* pThreadPool);
+
+    const std::vector<PhaseTiming>& GetPhaseTimings() const
+    {
+        return m_Phases;
+    }
+
+    // Wall clock time of the last Run.
+    double GetTotalSeconds() const
+    {
+        return m_TotalSeconds;
+    }
+
+private:
+    TaskGraph(const TaskGraph& copy) = delete;
+    TaskGraph& operator=(const TaskGraph& other) = delete;
+
+    struct Task
+    {
+        uint32_t Phase;
+        std::function<void()> Func;
+        uint32_t NumDependencies;
+        std::vector<uint32_t> Dependents;
+    };
+
+    struct RunState;
+
+    // Pool job: run one task of the ready queue, if there is one left. The graph may be gone by then.
+    static void RunReadyTask(const std::shared_ptr<RunState>& state);
+    // Run one task and queue the dependents it made ready.
+    void Execute(const std::shared_ptr<RunState>& state, uint32_t task);
+
+    std::vector<Task> m_Tasks;
+    std::vector<PhaseTiming> m_Phases;
+    double m_TotalSeconds;
+};
@@ -0,0 +1,99 @@
+/**
+* CPU side texture storage used by the offline texture tools.
+*
+* All subresources live in one allocation, ordered like D3D12 subresource
+* indices (mip + slice * MipLevels) with tightly packed rows, so each one can
+* be passed to UpdateSubresources as a D3D12_SUBRESOURCE_DATA directly.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The values are the matching DXGI_FORMATs, so the offline tools do not depend on the Windows SDK.
+enum class TextureFormat : uint32_t
+{
+    RGBA32Float = 2,    // DXGI_FORMAT_R32G32B32A32_FLOAT
+    RGBA16Float = 10,   // DXGI_FORMAT_R16G16B16A16_FLOAT
+    RG16Float = 34,     // DXGI_FORMAT_R16G16_FLOAT
+    RGBA8UNorm = 28,    // DXGI_FORMAT_R8G8B8A8_UNORM
+    RGBA8UNormSRGB = 29, // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+    BC1UNorm = 71,      // DXGI_FORMAT_BC1_UNORM
+    BC1UNormSRGB = 72,  // DXGI_FORMAT_BC1_UNORM_SRGB
+    BC3UNorm = 77,      // DXGI_FORMAT_BC3_UNORM
+    BC3UNormSRGB = 78,  // DXGI_FORMAT_BC3_UNORM_SRGB
+    BC4UNorm = 80,      // DXGI_FORMAT_BC4_UNORM
+    BC5UNorm = 83,      // DXGI_FORMAT_BC5_UNORM
+    BC7UNorm = 98,      // DXGI_FORMAT_BC7_UNORM
+    BC7UNormSRGB = 99,  // DXGI_FORMAT_BC7_UNORM_SRGB
+};
+
+// Only valid for the uncompressed formats.
+uint32_t GetBytesPerPixel(TextureFormat format);
+
+// Is the format stored in 4x4 texel blocks?
+bool IsBlockCompressed(TextureFormat format);
+
+// Size of one 4x4 block, only valid for the block compressed formats.
+uint32_t GetBytesPerBlock(TextureFormat format);
+
+// Is the color stored with the sRGB transfer function?
+bool IsSRGB(TextureFormat format);
+
+// Number of mips down to 1x1.
+uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+
+struct TextureSubresource
+{
+    uint32_t Width;
+    uint32_t Height;
+    // Offset in TextureData::Pixels.
+    size_t Offset;
+    // Bytes per row of texels, or per row of blocks for the block compressed formats.
+    size_t RowPitch;
+    size_t SlicePitch;
+};
+
+struct TextureData
+{
+    TextureFormat Format = TextureFormat::RGBA8UNorm;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    uint32_t ArraySize = 1;
+    uint32_t MipLevels = 1;
+    // The slices are cube faces (+X, -X, +Y, -Y, +Z, -Z), ArraySize is a multiple of 6.
+    // Initialize resets it, the code that fills the faces sets it.
+    bool IsCubemap = false;
+    std::vector<TextureSubresource> Subresources;
+    std::vector<uint8_t> Pixels;
+
+    /**
+     * Allocate zeroed storage and compute the subresource layout.
+     * @param mipLevels 0 for the full mip chain.
+     */
+    void Initialize(TextureFormat format, uint32_t width, uint32_t height, uint32_t arraySize = 1, uint32_t mipLevels = 1);
+
+    const TextureSubresource& GetSubresource(uint32_t mip, uint32_t slice = 0) const
+    {
+        return Subresources[mip + slice * MipLevels];
+    }
+
+    uint8_t* GetPixels(uint32_t mip, uint32_t slice = 0)
+    {
+        return Pixels.data() + GetSubresource(mip, slice).Offset;
+    }
+
+    const uint8_t* GetPixels(uint32_t mip, uint32_t slice = 0) const
+    {
+        return Pixels.data() + GetSubresource(mip, slice).Offset;
+    }
+};
+
+// IEEE half precision conversion, rounds to nearest even.
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+
+// sRGB transfer function.
+float SRGBToLinear(float value);
+float LinearToSRGB(float value);
@@ -0,0 +1,133 @@
+/**
+* Binary texture container.
+*
+* A texture file holds one or more textures and is laid out so that it can be
+* memory mapped and uploaded without any parsing:
+*
+*   TextureFileHeader
+*   TextureFileTexture[NumTextures]
+*   TextureFileSubresource[NumSubresources]
+*   pixel data (every texture aligned to TextureFileAlignment)
+*
+* The subresources of a texture are in D3D12 order, each one can be passed to
+* UpdateSubresources as a D3D12_SUBRESOURCE_DATA pointing into the mapped view.
+* The header carries a key so the file can be used as a cache of generated
+* textures (IBL maps, lookup tables): a cache is valid if its key matches the
+* key of the inputs it was generated from.
+*/
+#pragma once
+
+#include <MappedFile.h>
+#include <TextureData.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 'TEXF'
+const uint32_t TextureFileMagic = 0x46584554;
+const uint32_t TextureFileVersion = 1;
+// Alignment of the pixel data of each texture inside the file.
+const uint32_t TextureFileAlignment = 64;
+
+struct TextureFileTexture
+{
+    // TextureFormat (DXGI_FORMAT) of the texture.
+    uint32_t Format;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t ArraySize;
+    uint32_t MipLevels;
+    // 1 if the slices are cube faces.
+    uint32_t IsCubemap;
+    // Range in the subresource table.
+    uint32_t FirstSubresource;
+    uint32_t NumSubresources;
+};
+
+struct TextureFileSubresource
+{
+    uint32_t Width;
+    uint32_t Height;
+    // Offset from the start of the file.
+    uint64_t Offset;
+    uint64_t RowPitch;
+    uint64_t SlicePitch;
+};
+
+struct TextureFileHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t NumTextures;
+    uint32_t NumSubresources;
+    // Cache key given to WriteTextureFile, 0 for plain assets.
+    uint64_t Key;
+    uint64_t TextureOffset;
+    uint64_t SubresourceOffset;
+    uint64_t FileSize;
+};
+
+/**
+ * Write the textures to a texture file.
+ */
+bool WriteTextureFile(const std::wstring& fileName, const std::vector<const TextureData*>& textures, uint64_t key = 0);
+
+/**
+ * A memory mapped texture file. The pixel data points directly into the
+ * mapped view, nothing is parsed or copied when the file is opened.
+ */
+class TextureFile
+{
+public:
+    TextureFile();
+    virtual ~TextureFile();
+
+    /**
+     * Map the file and validate the header and the tables.
+     * @returns false if the file could not be mapped or is not a valid texture file.
+     */
+    bool Open(const std::wstring& fileName);
+    void Close();
+
+    bool IsOpen() const
+    {
+        return m_File.IsOpen();
+    }
+
+    const TextureFileHeader& GetHeader() const
+    {
+        return *static_cast<const TextureFileHeader*>(m_File.GetData());
+    }
+
+    const TextureFileTexture& GetTexture(uint32_t texture) const
+    {
+        return reinterpret_cast<const TextureFileTexture*>(GetBytes() + GetHeader().TextureOffset)[texture];
+    }
+
+    // The subresources of a texture, GetTexture(texture).NumSubresources entries.
+    const TextureFileSubresource* GetSubresources(uint32_t texture) const
+    {
+        return reinterpret_cast<const TextureFileSubresource*>(GetBytes() + GetHeader().SubresourceOffset) +
+            GetTexture(texture).FirstSubresource;
+    }
+
+    const void* GetPixels(const TextureFileSubresource& subresource) const
+    {
+        return GetBytes() + subresource.Offset;
+    }
+
+private:
+    TextureFile(const TextureFile& copy) = delete;
+    TextureFile& operator=(const TextureFile& other) = delete;
+
+    const uint8_t* GetBytes() const
+    {
+        return static_cast<const uint8_t*>(m_File.GetData());
+    }
+
+    bool Validate() const;
+
+    MappedFile m_File;
+};
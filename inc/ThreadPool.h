@@ -0,0 +1,92 @@
+/**
+* A simple fixed size thread pool.
+*
+* Tasks are executed in FIFO order by a set of worker threads. ParallelFor
+* splits an index range over the workers and lets the calling thread help,
+* so it can safely be called from inside another task.
+*/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    /**
+     * @param numThreads The number of worker threads. 0 uses one thread less
+     * than the number of hardware threads (at least one).
+     */
+    explicit ThreadPool(uint32_t numThreads = 0);
+    virtual ~ThreadPool();
+
+    uint32_t GetNumThreads() const
+    {
+        return static_cast<uint32_t>(m_Threads.size());
+    }
+
+    /**
+     * 提交一个任务到线程池。
+     * @returns A future that receives the result (or the exception) of the task.
+     */
+    template<typename Func>
+    auto Submit(Func&& func) -> std::future<decltype(func())>
+    {
+        using ResultType = decltype(func());
+
+        auto task = std::make_shared< std::packaged_task<ResultType()> >(std::forward<Func>(func));
+        std::future<ResultType> result = task->get_future();
+
+        Enqueue([task]() { (*task)(); });
+
+        return result;
+    }
+
+    /**
+     * Invoke func(i) for every i in [0, count) using the worker threads and
+     * the calling thread. Returns when all invocations have finished.
+     * The first exception thrown by func is rethrown on the calling thread.
+     */
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+
+private:
+    ThreadPool(const ThreadPool& copy) = delete;
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    void Enqueue(std::function<void()> task);
+    void WorkerThread();
+
+    std::vector<std::thread> m_Threads;
+    std::queue< std::function<void()> > m_Tasks;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_Stop;
+};
+
+/**
+ * Run func(i) for i in [0, count) on the thread pool, or serially on the
+ * calling thread if no thread pool is given.
+ */
+inline void ParallelFor(ThreadPool* pThreadPool, uint32_t count, const std::function<void(uint32_t)>& func)
+{
+    if (pThreadPool && count > 1)
+    {
+        pThreadPool->ParallelFor(count, func);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            func(i);
+        }
+    }
+}
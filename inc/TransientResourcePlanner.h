@@ -0,0 +1,90 @@
+/**
+* Lifetime based memory aliasing used by the transient resource pool.
+*
+* Pure C++ like HeapAllocator, so the placement can be checked without a GPU.
+* Every resource is used by a range of passes [FirstPass, LastPass] of a frame.
+* Resources whose pass ranges do not overlap can share memory, Plan places
+* them at offsets in one heap so the heap only has to be as large as the peak
+* of the memory that is alive at the same time instead of the sum of all
+* resources.
+*/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class TransientResourcePlanner
+{
+public:
+    static const uint32_t InvalidIndex = ~0u;
+
+    struct Placement
+    {
+        uint64_t Offset = 0;
+        // The resource that used overlapping memory last before this one in the frame,
+        // InvalidIndex if there is none. It is the "before" resource of the aliasing barrier.
+        uint32_t AliasedResource = InvalidIndex;
+    };
+
+    struct Statistics
+    {
+        uint32_t NumResources = 0;
+        // Resources that share memory with an earlier resource of the frame.
+        uint32_t NumAliasedResources = 0;
+        // Size of the heap the resources were placed in.
+        uint64_t HeapSize = 0;
+        // Memory needed without aliasing.
+        uint64_t SummedSize = 0;
+    };
+
+    TransientResourcePlanner();
+    virtual ~TransientResourcePlanner();
+
+    void Clear();
+
+    /**
+     * 添加一个资源.
+     * @param alignment Placement alignment, a power of two.
+     * @returns The index of the resource.
+     */
+    uint32_t AddResource(uint64_t size, uint64_t alignment, uint32_t firstPass, uint32_t lastPass);
+
+    /**
+     * Assign heap offsets. Larger resources are placed first, each at the lowest
+     * offset that does not overlap a resource with an overlapping lifetime.
+     */
+    void Plan();
+
+    uint32_t GetNumResources() const
+    {
+        return static_cast<uint32_t>(m_Resources.size());
+    }
+
+    const Placement& GetPlacement(uint32_t resource) const
+    {
+        return m_Placements[resource];
+    }
+
+    uint64_t GetHeapSize() const
+    {
+        return m_HeapSize;
+    }
+
+    Statistics GetStatistics() const;
+
+private:
+    struct Resource
+    {
+        uint64_t Size;
+        uint64_t Alignment;
+        uint32_t FirstPass;
+        uint32_t LastPass;
+    };
+
+    bool LifetimesOverlap(uint32_t a, uint32_t b) const;
+    bool MemoryOverlaps(uint32_t a, uint32_t b) const;
+
+    std::vector<Resource> m_Resources;
+    std::vector<Placement> m_Placements;
+    uint64_t m_HeapSize;
+};
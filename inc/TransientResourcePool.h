@@ -0,0 +1,145 @@
+/**
+* Pool of transient render targets and depth buffers that only live for a frame.
+*
+* Every frame the renderer requests the textures it needs together with the
+* range of passes that use them. Compile places the textures in one shared
+* placed heap with TransientResourcePlanner, so textures with disjoint lifetimes
+* alias the same memory, and hands out the resources. Resources are cached by
+* description and heap offset: as long as the requests do not change (the
+* usual case) the same ID3D12Resources are returned every frame and nothing is
+* created. When the requests change, for example after a resize, resources and
+* heaps that are no longer needed are released once the GPU has finished the
+* last frame that used them, so no flush is needed.
+*
+* The contents of a transient texture are undefined at its first use in a
+* frame: issue AliasingBarrier and clear (or discard) it before rendering to it.
+* A texture must be back in its initial state (RENDER_TARGET or DEPTH_WRITE)
+* when its last pass ends.
+*/
+#pragma once
+
+#include <ResidencyManager.h>
+#include <TransientResourcePlanner.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+struct TransientTextureDesc
+{
+    DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    uint32_t SampleCount = 1;
+    // D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET or D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL, plus optional flags.
+    D3D12_RESOURCE_FLAGS Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+    // Optimized clear value, its format must be Format.
+    D3D12_CLEAR_VALUE ClearValue = {};
+
+    bool operator==(const TransientTextureDesc& other) const;
+    bool operator!=(const TransientTextureDesc& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+class TransientResourcePool
+{
+public:
+    using Handle = uint32_t;
+
+    struct Statistics
+    {
+        uint32_t NumTextures = 0;
+        uint32_t NumAliasedTextures = 0;
+        // Memory needed by this frame's textures with aliasing (the peak) and without.
+        uint64_t PeakSize = 0;
+        uint64_t SummedSize = 0;
+        // Size of the current heap, at least PeakSize.
+        uint64_t HeapSize = 0;
+        // Resources created by the last Compile, 0 when everything was reused.
+        uint32_t NumCreatedResources = 0;
+    };
+
+    TransientResourcePool(Microsoft::WRL::ComPtr<ID3D12Device2> device, std::shared_ptr<ResidencyManager> residencyManager = nullptr);
+    virtual ~TransientResourcePool();
+
+    // 开始一帧: forget the requests of the previous frame.
+    void BeginFrame();
+
+    /**
+     * Request a texture that is used by the passes [firstPass, lastPass] of this frame.
+     * The handle is valid until the next BeginFrame.
+     */
+    Handle Request(const TransientTextureDesc& desc, uint32_t firstPass, uint32_t lastPass);
+
+    /**
+     * Place the requested textures and create the resources that are not cached yet.
+     * @param completedFenceValue The completed fence value of the direct queue, retired
+     * resources and heaps older than this are released.
+     */
+    void Compile(uint64_t completedFenceValue);
+
+    ID3D12Resource* GetResource(Handle handle) const;
+
+    // Record the aliasing barrier for the first use of a texture in the frame.
+    void AliasingBarrier(ID3D12GraphicsCommandList2* commandList, Handle handle) const;
+
+    // The frame was submitted to the direct queue and signals fenceValue.
+    void EndFrame(uint64_t fenceValue);
+
+    Statistics GetStatistics() const;
+
+private:
+    TransientResourcePool(const TransientResourcePool& copy) = delete;
+    TransientResourcePool& operator=(const TransientResourcePool& other) = delete;
+
+    struct Request
+    {
+        TransientTextureDesc Desc;
+        uint32_t FirstPass;
+        uint32_t LastPass;
+        // Filled by Compile.
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+    };
+
+    struct CachedResource
+    {
+        TransientTextureDesc Desc;
+        uint64_t Offset;
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+        bool Claimed;
+    };
+
+    // Objects kept alive until the GPU reaches FenceValue.
+    struct RetiredObject
+    {
+        uint64_t FenceValue;
+        Microsoft::WRL::ComPtr<ID3D12Pageable> Object;
+        bool IsHeap;
+    };
+
+    D3D12_RESOURCE_DESC GetResourceDesc(const TransientTextureDesc& desc) const;
+    void Retire(Microsoft::WRL::ComPtr<ID3D12Pageable> object, bool isHeap);
+    void ReleaseRetiredObjects(uint64_t completedFenceValue);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
+    std::shared_ptr<ResidencyManager> m_ResidencyManager;
+
+    std::vector<Request> m_Requests;
+    TransientResourcePlanner m_Planner;
+
+    Microsoft::WRL::ComPtr<ID3D12Heap> m_Heap;
+    uint64_t m_HeapSize;
+    uint64_t m_HeapAlignment;
+    std::vector<CachedResource> m_CachedResources;
+    std::deque<RetiredObject> m_RetiredObjects;
+
+    // Fence value of the last submitted frame.
+    uint64_t m_LastFenceValue;
+    uint32_t m_NumCreatedResources;
+};
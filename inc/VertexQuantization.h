@@ -0,0 +1,68 @@
+/**
+* Quantized vertex formats.
+*
+* VertexPosColorPacked stores the position as 16-bit SNORM values relative to
+* the bounds of the mesh and the color as RGBA8 UNORM, 12 bytes per vertex
+* instead of the 24 bytes of VertexPosColor. The input assembler converts
+* both to floats, the vertex shader only has to apply the per-mesh scale and
+* bias (see VertexShader.hlsl).
+*/
+#pragma once
+
+#include <MeshFile.h>
+
+#include <cstddef>
+#include <cstdint>
+
+struct VertexPosColorPacked
+{
+    // x, y, z in [-32767, 32767], w is padding.
+    int16_t Position[4];
+    uint8_t Color[4];
+};
+
+static_assert(sizeof(VertexPosColorPacked) == 12, "VertexPosColorPacked must be tightly packed.");
+
+/**
+ * Maps SNORM positions back to object space: position = snorm * Scale + Bias.
+ */
+struct QuantizationBounds
+{
+    float Scale[3];
+    float Bias[3];
+};
+
+/**
+ * 计算包围所有顶点位置的量化范围。
+ * @param pPositions Pointer to the first position (3 floats), strideInBytes apart.
+ */
+QuantizationBounds ComputeQuantizationBounds(const float* pPositions, size_t strideInBytes, size_t numVertices);
+
+/**
+ * Encode float positions and colors (3 floats each) into packed vertices using SSE2.
+ * Positions outside of the bounds are clamped, colors are clamped to [0, 1].
+ */
+void EncodeVertices(const float* pPositions, const float* pColors, size_t strideInBytes, size_t numVertices,
+    const QuantizationBounds& bounds, VertexPosColorPacked* pOut);
+
+/**
+ * Decode a packed position the same way the input assembler and the vertex shader do.
+ */
+void DecodePosition(const VertexPosColorPacked& vertex, const QuantizationBounds& bounds, float position[3]);
+
+/**
+ * Upper bound of the per-axis position error introduced by EncodeVertices
+ * for positions inside the bounds (half a quantization step plus float rounding).
+ */
+void GetMaxQuantizationError(const QuantizationBounds& bounds, float error[3]);
+
+// Upper bound of the color error (half a step of an 8-bit UNORM value).
+const float MaxColorQuantizationError = 0.5f / 255.0f;
+
+/**
+ * Convert a mesh with R32G32B32_FLOAT POSITION and COLOR attributes to the
+ * VertexPosColorPacked layout. The quantization bounds are stored in
+ * mesh.PositionScale and mesh.PositionBias. Compute the submesh bounds first.
+ * @returns false if the mesh does not have the expected attributes.
+ */
+bool QuantizeMesh(MeshData& mesh);
@@ -153,10 +153,8 @@ private:
     std::weak_ptr<Game> m_pGame;
 
     Microsoft::WRL::ComPtr<IDXGISwapChain4> m_dxgiSwapChain;
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_d3d12RTVDescriptorHeap;
     Microsoft::WRL::ComPtr<ID3D12Resource> m_d3d12BackBuffers[BufferCount];
 
-    UINT m_RTVDescriptorSize;
     UINT m_CurrentBackBufferIndex;
 
     RECT m_WindowRect;
@@ -0,0 +1,46 @@
+// Bindless resource access (shader model 6.6), see BindlessDescriptorTable.h.
+//
+// A handle is the index of the view in ResourceDescriptorHeap in the low 20 bits
+// and the generation of its slot in the high 12 bits. Pass handles as root
+// constants or in a buffer, for example
+//     struct MaterialConstants { uint AlbedoTexture; uint NormalTexture; };
+//     ConstantBuffer<MaterialConstants> MaterialCB : register(b1);
+//     Texture2D<float4> albedo = GetBindlessTexture2D(MaterialCB.AlbedoTexture);
+
+#define BINDLESS_INDEX_BITS 20
+#define BINDLESS_INVALID_HANDLE 0xffffffff
+
+uint BindlessIndex(uint handle)
+{
+    return handle & ((1u << BINDLESS_INDEX_BITS) - 1);
+}
+
+bool IsValidBindlessHandle(uint handle)
+{
+    return handle != BINDLESS_INVALID_HANDLE;
+}
+
+Texture2D<float4> GetBindlessTexture2D(uint handle)
+{
+    return ResourceDescriptorHeap[BindlessIndex(handle)];
+}
+
+TextureCube<float4> GetBindlessTextureCube(uint handle)
+{
+    return ResourceDescriptorHeap[BindlessIndex(handle)];
+}
+
+ByteAddressBuffer GetBindlessBuffer(uint handle)
+{
+    return ResourceDescriptorHeap[BindlessIndex(handle)];
+}
+
+RWTexture2D<float4> GetBindlessRWTexture2D(uint handle)
+{
+    return ResourceDescriptorHeap[BindlessIndex(handle)];
+}
+
+RWByteAddressBuffer GetBindlessRWBuffer(uint handle)
+{
+    return ResourceDescriptorHeap[BindlessIndex(handle)];
+}
@@ -0,0 +1,28 @@
+// Irradiance from order 3 spherical harmonics, see SphericalHarmonics.h.
+//
+// Bind SH9Constants as 28 root constants (PackSH9Constants on the CPU), for example
+//     ConstantBuffer<SH9Constants> IrradianceSHCB : register(b2);
+
+// The 9 RGB coefficients premultiplied with the basis constants, tightly packed.
+struct SH9Constants
+{
+    float4 Packed[7];
+};
+
+// Irradiance / pi for a normalized world space normal, multiply by the albedo.
+float3 EvaluateSH9(SH9Constants sh, float3 n)
+{
+    float3 c0 = sh.Packed[0].xyz;
+    float3 c1 = float3(sh.Packed[0].w, sh.Packed[1].xy);
+    float3 c2 = float3(sh.Packed[1].zw, sh.Packed[2].x);
+    float3 c3 = sh.Packed[2].yzw;
+    float3 c4 = sh.Packed[3].xyz;
+    float3 c5 = float3(sh.Packed[3].w, sh.Packed[4].xy);
+    float3 c6 = float3(sh.Packed[4].zw, sh.Packed[5].x);
+    float3 c7 = sh.Packed[5].yzw;
+    float3 c8 = sh.Packed[6].xyz;
+
+    float3 result = c0 + c1 * n.y + c2 * n.z + c3 * n.x;
+    result += c4 * (n.x * n.y) + c5 * (n.y * n.z) + c6 * (n.z * n.z) + c7 * (n.x * n.z) + c8 * (n.x * n.x - n.y * n.y);
+    return max(result, 0.0f);
+}
@@ -3,12 +3,22 @@ struct ModelViewProjection
     matrix MVP;
 };
 
+// Maps the quantized positions back to object space (see VertexQuantization.h).
+struct PositionDequantization
+{
+    float3 Scale;
+    float3 Bias;
+};
+
 ConstantBuffer<ModelViewProjection> ModelViewProjectionCB : register(b0);
+ConstantBuffer<PositionDequantization> PositionDequantizationCB : register(b1);
 
+// VertexPosColorPacked: R16G16B16A16_SNORM position and R8G8B8A8_UNORM color,
+// already converted to floats by the input assembler.
 struct VertexPosColor
 {
-    float3 Position : POSITION;
-    float3 Color    : COLOR;
+    float4 Position : POSITION;
+    float4 Color    : COLOR;
 };
 
 struct VertexShaderOutput
@@ -21,8 +31,10 @@ VertexShaderOutput main(VertexPosColor IN)
 {
     VertexShaderOutput OUT;
 
-    OUT.Position = mul(ModelViewProjectionCB.MVP, float4(IN.Position, 1.0f));
-    OUT.Color = float4(IN.Color, 1.0f);
+    float3 position = IN.Position.xyz * PositionDequantizationCB.Scale + PositionDequantizationCB.Bias;
+
+    OUT.Position = mul(ModelViewProjectionCB.MVP, float4(position, 1.0f));
+    OUT.Color = float4(IN.Color.rgb, 1.0f);
 
     return OUT;
-}
\ No newline at end of file
+}